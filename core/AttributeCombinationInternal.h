@@ -99,4 +99,48 @@ public:
 static AttributeCombinationCheck DEBUG_AttributeCombinationCheck; // yes, this gets duplicated for each include, but it's just for debug..
 #endif // NDEBUG
 
+// the number of states in each dimension of an attribute combination's tensor, and how many buckets apart neighbouring states of each dimension are.
+// Our tensor totals and interaction binning fill this in once and then index the tensor from it instead of going back through the attribute pointers for
+// every case or cut.  With a compile time number of dimensions the arrays are exactly sized and the loops over them unroll into straight index arithmetic
+template<size_t countCompilerDimensions>
+class TensorStrides final {
+   size_t m_cDimensions;
+   size_t m_acStates[countCompilerDimensions <= 0 ? k_cDimensionsMax : countCompilerDimensions];
+   size_t m_acStrides[countCompilerDimensions <= 0 ? k_cDimensionsMax : countCompilerDimensions];
+
+public:
+
+   // our caller needs to have checked that the tensor's total number of buckets doesn't overflow
+   TML_INLINE void Initialize(const AttributeCombinationCore * const pAttributeCombination) {
+      const size_t cDimensions = GET_ATTRIBUTE_COMBINATION_DIMENSIONS(countCompilerDimensions, pAttributeCombination->m_cAttributes);
+      EBM_ASSERT(cDimensions == pAttributeCombination->m_cAttributes);
+      EBM_ASSERT(1 <= cDimensions);
+      EBM_ASSERT(cDimensions <= k_cDimensionsMax);
+      m_cDimensions = cDimensions;
+      size_t cStride = 1;
+      for(size_t iDimension = 0; iDimension < cDimensions; ++iDimension) {
+         const size_t cStates = pAttributeCombination->m_AttributeCombinationEntry[iDimension].m_pAttribute->m_cStates;
+         EBM_ASSERT(1 <= cStates);
+         EBM_ASSERT(!IsMultiplyError(cStride, cStates));
+         m_acStates[iDimension] = cStates;
+         m_acStrides[iDimension] = cStride;
+         cStride *= cStates;
+      }
+   }
+
+   TML_INLINE size_t GetCountDimensions() const {
+      return GET_ATTRIBUTE_COMBINATION_DIMENSIONS(countCompilerDimensions, m_cDimensions);
+   }
+
+   TML_INLINE size_t GetCountStates(const size_t iDimension) const {
+      EBM_ASSERT(iDimension < GetCountDimensions());
+      return m_acStates[iDimension];
+   }
+
+   TML_INLINE size_t GetStride(const size_t iDimension) const {
+      EBM_ASSERT(iDimension < GetCountDimensions());
+      return m_acStrides[iDimension];
+   }
+};
+
 #endif // ATTRIBUTE_COMBINATION_H
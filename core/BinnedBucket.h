@@ -5,7 +5,7 @@
 #ifndef BINNED_BUCKET_H
 #define BINNED_BUCKET_H
 
-#include <type_traits> // std::is_pod
+#include <type_traits> // std::is_pod, std::is_same
 #include <assert.h>
 #include <string.h> // memset
 #include <stddef.h> // size_t, ptrdiff_t
@@ -21,6 +21,8 @@
 #include "DataSetByAttributeCombination.h"
 #include "DataSetByAttribute.h"
 #include "SamplingWithReplacement.h"
+#include "ThreadPool.h"
+#include "SimdKernels.h" // RunSimdVariant
 
 // we don't need to handle multi-dimensional inputs with more than 64 bits total
 // the rational is that we need to bin this data, and our binning memory will be N1*N1*...*N(D-1)*N(D)
@@ -127,7 +129,84 @@ public:
 static_assert(std::is_pod<BinnedBucket<false>>::value, "BinnedBucket will be more efficient as a POD as we make potentially large arrays of them!");
 static_assert(std::is_pod<BinnedBucket<true>>::value, "BinnedBucket will be more efficient as a POD as we make potentially large arrays of them!");
 
-template<ptrdiff_t countCompilerClassificationTargetStates>
+// our binning loops are templated on one of these classes so that they can read the occurrence counts of any SamplingMethod without a virtual call or a branch per case.
+// Next() returns the occurrences of consecutive cases starting from iCaseStart, and GetCountOccurrences(..) looks up any single case.  If k_bFlat is true every case
+// occurs once, so the loops skip counting cases since SamplingFlat already has the counts for each bin
+class CountOccurrencesWithReplacement final {
+   const size_t * m_pCountOccurrences;
+
+public:
+   static constexpr bool k_bFlat = false;
+
+   TML_INLINE CountOccurrencesWithReplacement(const SamplingMethod * const pSamplingSet, const size_t iCaseStart)
+      : m_pCountOccurrences(static_cast<const SamplingWithReplacement *>(pSamplingSet)->m_aCountOccurrences + iCaseStart) {
+      EBM_ASSERT(SamplingTypeCore::WithReplacementCore == pSamplingSet->m_samplingType);
+   }
+
+   TML_INLINE size_t Next() {
+      const size_t cOccurrences = *m_pCountOccurrences;
+      ++m_pCountOccurrences;
+      return cOccurrences;
+   }
+
+   TML_INLINE static size_t GetCountOccurrences(const SamplingMethod * const pSamplingSet, const size_t iCase) {
+      EBM_ASSERT(SamplingTypeCore::WithReplacementCore == pSamplingSet->m_samplingType);
+      return static_cast<const SamplingWithReplacement *>(pSamplingSet)->m_aCountOccurrences[iCase];
+   }
+};
+
+class CountOccurrencesWithoutReplacement final {
+   const SamplingWithoutReplacement * const m_pSamplingSet;
+   size_t m_iCase;
+
+public:
+   static constexpr bool k_bFlat = false;
+
+   TML_INLINE CountOccurrencesWithoutReplacement(const SamplingMethod * const pSamplingSet, const size_t iCaseStart)
+      : m_pSamplingSet(static_cast<const SamplingWithoutReplacement *>(pSamplingSet))
+      , m_iCase(iCaseStart) {
+      EBM_ASSERT(SamplingTypeCore::WithoutReplacementCore == pSamplingSet->m_samplingType);
+   }
+
+   TML_INLINE size_t Next() {
+      // the 0 or 1 that we return here gets multiplied into our sums, so cases outside of our bag add zeros instead of being skipped by a hard to predict branch
+      const size_t cOccurrences = m_pSamplingSet->GetCountOccurrences(m_iCase);
+      ++m_iCase;
+      return cOccurrences;
+   }
+
+   TML_INLINE static size_t GetCountOccurrences(const SamplingMethod * const pSamplingSet, const size_t iCase) {
+      EBM_ASSERT(SamplingTypeCore::WithoutReplacementCore == pSamplingSet->m_samplingType);
+      return static_cast<const SamplingWithoutReplacement *>(pSamplingSet)->GetCountOccurrences(iCase);
+   }
+};
+
+class CountOccurrencesFlat final {
+public:
+   static constexpr bool k_bFlat = true;
+
+   TML_INLINE CountOccurrencesFlat(const SamplingMethod * const pSamplingSet, const size_t iCaseStart) {
+      UNUSED(pSamplingSet);
+      UNUSED(iCaseStart);
+      EBM_ASSERT(SamplingTypeCore::FlatCore == pSamplingSet->m_samplingType);
+   }
+
+   // this is a compile time constant, so multiplying by it gets optimized away and we don't touch any occurrence memory
+   TML_INLINE size_t Next() {
+      return 1;
+   }
+
+   TML_INLINE static size_t GetCountOccurrences(const SamplingMethod * const pSamplingSet, const size_t iCase) {
+      UNUSED(pSamplingSet);
+      UNUSED(iCase);
+      EBM_ASSERT(SamplingTypeCore::FlatCore == pSamplingSet->m_samplingType);
+      return 1;
+   }
+};
+
+// TFloat is the type that the residuals are stored as in our data set (see DataSetAttributeCombination::IsSinglePrecision).  Our sums are always FractionalDataType
+// TCountOccurrences is CountOccurrencesWithReplacement, CountOccurrencesWithoutReplacement or CountOccurrencesFlat depending on the type of pTrainingSet
+template<ptrdiff_t countCompilerClassificationTargetStates, typename TFloat, typename TCountOccurrences>
 void BinDataSetTrainingZeroDimensions(BinnedBucket<IsRegression(countCompilerClassificationTargetStates)> * const pBinnedBucketEntry, const SamplingMethod * const pTrainingSet, const size_t cTargetStates) {
    LOG(TraceLevelVerbose, "Entered BinDataSetTrainingZeroDimensions");
 
@@ -137,11 +216,10 @@ void BinDataSetTrainingZeroDimensions(BinnedBucket<IsRegression(countCompilerCla
    const size_t cCases = pTrainingSet->m_pOriginDataSet->GetCountCases();
    EBM_ASSERT(0 < cCases);
 
-   const SamplingWithReplacement * const pSamplingWithReplacement = static_cast<const SamplingWithReplacement *>(pTrainingSet);
-   const size_t * pCountOccurrences = pSamplingWithReplacement->m_aCountOccurrences;
-   const FractionalDataType * pResidualError = pSamplingWithReplacement->m_pOriginDataSet->GetResidualPointer();
+   TCountOccurrences countOccurrences(pTrainingSet, 0);
+   const TFloat * pResidualError = pTrainingSet->m_pOriginDataSet->GetResidualPointer<TFloat>();
    // this shouldn't overflow since we're accessing existing memory
-   const FractionalDataType * const pResidualErrorEnd = pResidualError + cVectorLength * cCases;
+   const TFloat * const pResidualErrorEnd = pResidualError + cVectorLength * cCases;
 
    PredictionStatistics<IsRegression(countCompilerClassificationTargetStates)> * const pPredictionStatistics = &pBinnedBucketEntry->aPredictionStatistics[0];
    while(pResidualErrorEnd != pResidualError) {
@@ -150,11 +228,12 @@ void BinDataSetTrainingZeroDimensions(BinnedBucket<IsRegression(countCompilerCla
       // this loop gets about 10 times slower if you use a proper pseudo random number generator like std::default_random_engine
       // taking all the above together, it seems unlikley we'll use a method of separating sets via single pass randomized set splitting.  Even if count is stored in memory if shouldn't increase the time spent fetching it by 2 times, unless our bottleneck when threading is overwhelmingly memory pressure related, and even then we could store the count for a single bit aleviating the memory pressure greatly, if we use the right sampling method 
 
-      // TODO : try using a sampling method with non-repeating cases, and put the count into a bit.  Then unwind that loop either at the byte level (8 times) or the uint64_t level.  This can be done without branching and doesn't require random number generators
+      // with TrainingOptionsSamplingWithoutReplacement each count is a single bit, which CountOccurrencesWithoutReplacement reads without branching
 
-      const size_t cOccurences = *pCountOccurrences;
-      ++pCountOccurrences;
-      pBinnedBucketEntry->cCasesInBucket += cOccurences;
+      const size_t cOccurences = countOccurrences.Next();
+      if(!TCountOccurrences::k_bFlat) {
+         pBinnedBucketEntry->cCasesInBucket += cOccurences;
+      }
       const FractionalDataType cFloatOccurences = static_cast<FractionalDataType>(cOccurences);
 
 #ifndef NDEBUG
@@ -167,7 +246,7 @@ void BinDataSetTrainingZeroDimensions(BinnedBucket<IsRegression(countCompilerCla
 #endif // NDEBUG
       size_t iVector = 0;
       do {
-         const FractionalDataType residualError = *pResidualError;
+         const FractionalDataType residualError = static_cast<FractionalDataType>(*pResidualError);
          EBM_ASSERT(!IsClassification(countCompilerClassificationTargetStates) || 2 == cTargetStates && !bExpandBinaryLogits || static_cast<ptrdiff_t>(iVector) != k_iZeroResidual || 0 == residualError);
 #ifndef NDEBUG
          residualTotalDebug += residualError;
@@ -185,22 +264,48 @@ void BinDataSetTrainingZeroDimensions(BinnedBucket<IsRegression(countCompilerCla
          // the compiler seems to not mind if we make this a for loop or do loop in terms of collapsing away the loop
       } while(iVector < cVectorLength);
 
-      EBM_ASSERT(!IsClassification(countCompilerClassificationTargetStates) || 2 == cTargetStates && !bExpandBinaryLogits || 0 <= k_iZeroResidual || -0.00000000001 < residualTotalDebug && residualTotalDebug < 0.00000000001);
+      // single precision residuals are each rounded separately, so they only cancel to within float precision
+      EBM_ASSERT(!IsClassification(countCompilerClassificationTargetStates) || 2 == cTargetStates && !bExpandBinaryLogits || 0 <= k_iZeroResidual || (std::is_same<TFloat, float>::value) && -0.0001 < residualTotalDebug && residualTotalDebug < 0.0001 || -0.00000000001 < residualTotalDebug && residualTotalDebug < 0.00000000001);
+   }
+   if(TCountOccurrences::k_bFlat) {
+      pBinnedBucketEntry->cCasesInBucket += cCases;
    }
    LOG(TraceLevelVerbose, "Exited BinDataSetTrainingZeroDimensions");
 }
 
-// TODO : remove cCompilerDimensions since we don't need it anymore, and replace it with a more useful number like the number of cItemsPerBitPackDataUnit
-template<ptrdiff_t countCompilerClassificationTargetStates, size_t cCompilerDimensions>
-void BinDataSetTraining(BinnedBucket<IsRegression(countCompilerClassificationTargetStates)> * const aBinnedBuckets, const AttributeCombinationCore * const pAttributeCombination, const SamplingMethod * const pTrainingSet, const size_t cTargetStates
+template<ptrdiff_t countCompilerClassificationTargetStates, typename TFloat>
+TML_INLINE void BinDataSetTrainingZeroDimensionsOccurrencesDispatch(BinnedBucket<IsRegression(countCompilerClassificationTargetStates)> * const pBinnedBucketEntry, const SamplingMethod * const pTrainingSet, const size_t cTargetStates) {
+   if(SamplingTypeCore::FlatCore == pTrainingSet->m_samplingType) {
+      BinDataSetTrainingZeroDimensions<countCompilerClassificationTargetStates, TFloat, CountOccurrencesFlat>(pBinnedBucketEntry, pTrainingSet, cTargetStates);
+   } else if(SamplingTypeCore::WithoutReplacementCore == pTrainingSet->m_samplingType) {
+      BinDataSetTrainingZeroDimensions<countCompilerClassificationTargetStates, TFloat, CountOccurrencesWithoutReplacement>(pBinnedBucketEntry, pTrainingSet, cTargetStates);
+   } else {
+      BinDataSetTrainingZeroDimensions<countCompilerClassificationTargetStates, TFloat, CountOccurrencesWithReplacement>(pBinnedBucketEntry, pTrainingSet, cTargetStates);
+   }
+}
+
+// picks the BinDataSetTrainingZeroDimensions instantiation that matches how pTrainingSet stores its occurrences and how its data set stores its residuals
+template<ptrdiff_t countCompilerClassificationTargetStates>
+TML_INLINE void BinDataSetTrainingZeroDimensionsDispatch(BinnedBucket<IsRegression(countCompilerClassificationTargetStates)> * const pBinnedBucketEntry, const SamplingMethod * const pTrainingSet, const size_t cTargetStates) {
+   if(pTrainingSet->m_pOriginDataSet->IsSinglePrecision()) {
+      BinDataSetTrainingZeroDimensionsOccurrencesDispatch<countCompilerClassificationTargetStates, float>(pBinnedBucketEntry, pTrainingSet, cTargetStates);
+   } else {
+      BinDataSetTrainingZeroDimensionsOccurrencesDispatch<countCompilerClassificationTargetStates, FractionalDataType>(pBinnedBucketEntry, pTrainingSet, cTargetStates);
+   }
+}
+
+// bins the cases in the range [iCaseStart, iCaseStart + cCases) into aBinnedBuckets.  iCaseStart needs to be on a bit pack boundary.  We're forced inline
+// so that BinDataSetTrainingSimd can compile us for each instruction set.  The number of dimensions doesn't change this loop since our packed data already
+// holds the combined bin index, so we don't compile a copy for each of them
+template<ptrdiff_t countCompilerClassificationTargetStates, typename TFloat, typename TCountOccurrences>
+TML_INLINE void BinDataSetTraining(BinnedBucket<IsRegression(countCompilerClassificationTargetStates)> * const aBinnedBuckets, const AttributeCombinationCore * const pAttributeCombination, const SamplingMethod * const pTrainingSet, const size_t cTargetStates, const size_t iCaseStart, const size_t cCases
 #ifndef NDEBUG
    , const unsigned char * const aBinnedBucketsEndDebug
 #endif // NDEBUG
 ) {
    LOG(TraceLevelVerbose, "Entered BinDataSetTraining");
 
-   EBM_ASSERT(cCompilerDimensions == pAttributeCombination->m_cAttributes);
-   static_assert(1 <= cCompilerDimensions, "cCompilerDimensions must be 1 or greater");
+   EBM_ASSERT(1 <= pAttributeCombination->m_cAttributes);
 
    const size_t cVectorLength = GET_VECTOR_LENGTH(countCompilerClassificationTargetStates, cTargetStates);
    const size_t cItemsPerBitPackDataUnit = pAttributeCombination->m_cItemsPerBitPackDataUnit;
@@ -209,15 +314,15 @@ void BinDataSetTraining(BinnedBucket<IsRegression(countCompilerClassificationTar
    EBM_ASSERT(!GetBinnedBucketSizeOverflow<IsRegression(countCompilerClassificationTargetStates)>(cVectorLength)); // we're accessing allocated memory
    const size_t cBytesPerBinnedBucket = GetBinnedBucketSize<IsRegression(countCompilerClassificationTargetStates)>(cVectorLength);
 
-   const size_t cCases = pTrainingSet->m_pOriginDataSet->GetCountCases();
    EBM_ASSERT(0 < cCases);
+   EBM_ASSERT(iCaseStart + cCases <= pTrainingSet->m_pOriginDataSet->GetCountCases());
+   EBM_ASSERT(0 == iCaseStart % cItemsPerBitPackDataUnit);
 
-   const SamplingWithReplacement * const pSamplingWithReplacement = static_cast<const SamplingWithReplacement *>(pTrainingSet);
-   const size_t * pCountOccurrences = pSamplingWithReplacement->m_aCountOccurrences;
-   const StorageDataTypeCore * pInputData = pSamplingWithReplacement->m_pOriginDataSet->GetDataPointer(pAttributeCombination);
-   const FractionalDataType * pResidualError = pSamplingWithReplacement->m_pOriginDataSet->GetResidualPointer();
+   TCountOccurrences countOccurrences(pTrainingSet, iCaseStart);
+   const StorageDataTypeCore * pInputData = pTrainingSet->m_pOriginDataSet->GetDataPointer(pAttributeCombination) + iCaseStart / cItemsPerBitPackDataUnit;
+   const TFloat * pResidualError = pTrainingSet->m_pOriginDataSet->GetResidualPointer<TFloat>() + cVectorLength * iCaseStart;
    // this shouldn't overflow since we're accessing existing memory
-   const FractionalDataType * const pResidualErrorLastItemWhereNextLoopCouldDoFullLoopOrLessAndComplete = pResidualError + cVectorLength * (static_cast<ptrdiff_t>(cCases) - cItemsPerBitPackDataUnit);
+   const TFloat * const pResidualErrorLastItemWhereNextLoopCouldDoFullLoopOrLessAndComplete = pResidualError + cVectorLength * (static_cast<ptrdiff_t>(cCases) - cItemsPerBitPackDataUnit);
 
    size_t cItemsRemaining;
 
@@ -227,7 +332,7 @@ void BinDataSetTraining(BinnedBucket<IsRegression(countCompilerClassificationTar
       // this loop gets about 10 times slower if you use a proper pseudo random number generator like std::default_random_engine
       // taking all the above together, it seems unlikley we'll use a method of separating sets via single pass randomized set splitting.  Even if count is stored in memory if shouldn't increase the time spent fetching it by 2 times, unless our bottleneck when threading is overwhelmingly memory pressure related, and even then we could store the count for a single bit aleviating the memory pressure greatly, if we use the right sampling method 
 
-      // TODO : try using a sampling method with non-repeating cases, and put the count into a bit.  Then unwind that loop either at the byte level (8 times) or the uint64_t level.  This can be done without branching and doesn't require random number generators
+      // with TrainingOptionsSamplingWithoutReplacement each count is a single bit, which CountOccurrencesWithoutReplacement reads without branching
 
       cItemsRemaining = cItemsPerBitPackDataUnit;
       // TODO : jumping back into this loop and changing cItemsRemaining to a dynamic value that isn't compile time determinable
@@ -242,9 +347,11 @@ void BinDataSetTraining(BinnedBucket<IsRegression(countCompilerClassificationTar
          BinnedBucket<IsRegression(countCompilerClassificationTargetStates)> * const pBinnedBucketEntry = GetBinnedBucketByIndex(cBytesPerBinnedBucket, aBinnedBuckets, iBin);
 
          ASSERT_BINNED_BUCKET_OK(cBytesPerBinnedBucket, pBinnedBucketEntry, aBinnedBucketsEndDebug);
-         const size_t cOccurences = *pCountOccurrences;
-         ++pCountOccurrences;
-         pBinnedBucketEntry->cCasesInBucket += cOccurences;
+         const size_t cOccurences = countOccurrences.Next();
+         if(!TCountOccurrences::k_bFlat) {
+            // SamplingFlat has already put the case counts into our histogram (see BinDataSetTrainingParallel)
+            pBinnedBucketEntry->cCasesInBucket += cOccurences;
+         }
          const FractionalDataType cFloatOccurences = static_cast<FractionalDataType>(cOccurences);
          PredictionStatistics<IsRegression(countCompilerClassificationTargetStates)> * pPredictionStatistics = &pBinnedBucketEntry->aPredictionStatistics[0];
          size_t iVector = 0;
@@ -258,7 +365,7 @@ void BinDataSetTraining(BinnedBucket<IsRegression(countCompilerClassificationTar
          FractionalDataType residualTotalDebug = 0;
 #endif // NDEBUG
          do {
-            const FractionalDataType residualError = *pResidualError;
+            const FractionalDataType residualError = static_cast<FractionalDataType>(*pResidualError);
             EBM_ASSERT(!IsClassification(countCompilerClassificationTargetStates) || 2 == cTargetStates && !bExpandBinaryLogits || static_cast<ptrdiff_t>(iVector) != k_iZeroResidual || 0 == residualError);
 #ifndef NDEBUG
             residualTotalDebug += residualError;
@@ -276,14 +383,15 @@ void BinDataSetTraining(BinnedBucket<IsRegression(countCompilerClassificationTar
             // the compiler seems to not mind if we make this a for loop or do loop in terms of collapsing away the loop
          } while(iVector < cVectorLength);
 
-         EBM_ASSERT(!IsClassification(countCompilerClassificationTargetStates) || 2 == cTargetStates && !bExpandBinaryLogits || 0 <= k_iZeroResidual || -0.0000001 < residualTotalDebug && residualTotalDebug < 0.0000001);
+         // single precision residuals are each rounded separately, so they only cancel to within float precision
+         EBM_ASSERT(!IsClassification(countCompilerClassificationTargetStates) || 2 == cTargetStates && !bExpandBinaryLogits || 0 <= k_iZeroResidual || (std::is_same<TFloat, float>::value) && -0.0001 < residualTotalDebug && residualTotalDebug < 0.0001 || -0.0000001 < residualTotalDebug && residualTotalDebug < 0.0000001);
 
          iBinCombined >>= cBitsPerItemMax;
          // TODO : try replacing cItemsRemaining with a pResidualErrorInnerLoopEnd which eliminates one subtact operation, but might make it harder for the compiler to optimize the loop away
          --cItemsRemaining;
       } while(0 != cItemsRemaining);
    }
-   const FractionalDataType * const pResidualErrorEnd = pResidualErrorLastItemWhereNextLoopCouldDoFullLoopOrLessAndComplete + cVectorLength * cItemsPerBitPackDataUnit;
+   const TFloat * const pResidualErrorEnd = pResidualErrorLastItemWhereNextLoopCouldDoFullLoopOrLessAndComplete + cVectorLength * cItemsPerBitPackDataUnit;
    if(pResidualError < pResidualErrorEnd) {
       LOG(TraceLevelVerbose, "Handling last BinDataSetTraining loop");
 
@@ -299,55 +407,528 @@ void BinDataSetTraining(BinnedBucket<IsRegression(countCompilerClassificationTar
    LOG(TraceLevelVerbose, "Exited BinDataSetTraining");
 }
 
-template<ptrdiff_t countCompilerClassificationTargetStates, size_t cCompilerDimensions>
-class RecursiveBinDataSetTraining {
-   // C++ does not allow partial function specialization, so we need to use these cumbersome inline static class functions to do partial function specialization
-public:
-   TML_INLINE static void Recursive(const size_t cRuntimeDimensions, BinnedBucket<IsRegression(countCompilerClassificationTargetStates)> * const aBinnedBuckets, const AttributeCombinationCore * const pAttributeCombination, const SamplingMethod * const pTrainingSet, const size_t cTargetStates
+template<ptrdiff_t countCompilerClassificationTargetStates, typename TFloat, typename TCountOccurrences>
+struct BinDataSetTrainingSimd final {
+   template<typename... TArgs>
+   TML_INLINE static void Run(const TArgs... args) {
+      BinDataSetTraining<countCompilerClassificationTargetStates, TFloat, TCountOccurrences>(args...);
+   }
+};
+
+// picks the BinDataSetTraining instantiation that matches how pTrainingSet stores its occurrences and how its data set stores its residuals.  We branch here once per call
+// so that the loops inside BinDataSetTraining are specialized for both
+template<ptrdiff_t countCompilerClassificationTargetStates, typename TFloat>
+TML_INLINE void BinDataSetTrainingOccurrencesDispatch(BinnedBucket<IsRegression(countCompilerClassificationTargetStates)> * const aBinnedBuckets, const AttributeCombinationCore * const pAttributeCombination, const SamplingMethod * const pTrainingSet, const size_t cTargetStates, const size_t iCaseStart, const size_t cCases
 #ifndef NDEBUG
-      , const unsigned char * const aBinnedBucketsEndDebug
+   , const unsigned char * const aBinnedBucketsEndDebug
 #endif // NDEBUG
-   ) {
-      EBM_ASSERT(cRuntimeDimensions < k_cDimensionsMax);
-      static_assert(cCompilerDimensions < k_cDimensionsMax, "cCompilerDimensions must be less than or equal to k_cDimensionsMax.  This line only handles the less than part, but we handle the equals in a partial specialization template.");
-      if(cCompilerDimensions == cRuntimeDimensions) {
-         BinDataSetTraining<countCompilerClassificationTargetStates, cCompilerDimensions>(aBinnedBuckets, pAttributeCombination, pTrainingSet, cTargetStates
+) {
+   if(SamplingTypeCore::FlatCore == pTrainingSet->m_samplingType) {
+      RunSimdVariant<BinDataSetTrainingSimd<countCompilerClassificationTargetStates, TFloat, CountOccurrencesFlat>>(aBinnedBuckets, pAttributeCombination, pTrainingSet, cTargetStates, iCaseStart, cCases
 #ifndef NDEBUG
-            , aBinnedBucketsEndDebug
+         , aBinnedBucketsEndDebug
 #endif // NDEBUG
-         );
-      } else {
-         RecursiveBinDataSetTraining<countCompilerClassificationTargetStates, 1 + cCompilerDimensions>::Recursive(cRuntimeDimensions, aBinnedBuckets, pAttributeCombination, pTrainingSet, cTargetStates
+      );
+   } else if(SamplingTypeCore::WithoutReplacementCore == pTrainingSet->m_samplingType) {
+      RunSimdVariant<BinDataSetTrainingSimd<countCompilerClassificationTargetStates, TFloat, CountOccurrencesWithoutReplacement>>(aBinnedBuckets, pAttributeCombination, pTrainingSet, cTargetStates, iCaseStart, cCases
 #ifndef NDEBUG
-            , aBinnedBucketsEndDebug
+         , aBinnedBucketsEndDebug
 #endif // NDEBUG
-         );
+      );
+   } else {
+      RunSimdVariant<BinDataSetTrainingSimd<countCompilerClassificationTargetStates, TFloat, CountOccurrencesWithReplacement>>(aBinnedBuckets, pAttributeCombination, pTrainingSet, cTargetStates, iCaseStart, cCases
+#ifndef NDEBUG
+         , aBinnedBucketsEndDebug
+#endif // NDEBUG
+      );
+   }
+}
+
+template<ptrdiff_t countCompilerClassificationTargetStates>
+TML_INLINE void BinDataSetTrainingDispatch(BinnedBucket<IsRegression(countCompilerClassificationTargetStates)> * const aBinnedBuckets, const AttributeCombinationCore * const pAttributeCombination, const SamplingMethod * const pTrainingSet, const size_t cTargetStates, const size_t iCaseStart, const size_t cCases
+#ifndef NDEBUG
+   , const unsigned char * const aBinnedBucketsEndDebug
+#endif // NDEBUG
+) {
+   if(pTrainingSet->m_pOriginDataSet->IsSinglePrecision()) {
+      BinDataSetTrainingOccurrencesDispatch<countCompilerClassificationTargetStates, float>(aBinnedBuckets, pAttributeCombination, pTrainingSet, cTargetStates, iCaseStart, cCases
+#ifndef NDEBUG
+         , aBinnedBucketsEndDebug
+#endif // NDEBUG
+      );
+   } else {
+      BinDataSetTrainingOccurrencesDispatch<countCompilerClassificationTargetStates, FractionalDataType>(aBinnedBuckets, pAttributeCombination, pTrainingSet, cTargetStates, iCaseStart, cCases
+#ifndef NDEBUG
+         , aBinnedBucketsEndDebug
+#endif // NDEBUG
+      );
+   }
+}
+
+// bins [iCaseStart, iCaseStart + cCases) one stream block at a time.  Binning consecutive blocks into the same histogram adds the cases in the same order as
+// binning the whole range at once, so out of core datasets get bit for bit identical histograms to in memory datasets
+template<ptrdiff_t countCompilerClassificationTargetStates>
+void BinDataSetTrainingStreamed(BinnedBucket<IsRegression(countCompilerClassificationTargetStates)> * const aBinnedBuckets, const AttributeCombinationCore * const pAttributeCombination, const SamplingMethod * const pTrainingSet, const size_t cTargetStates, const size_t iCaseStart, const size_t cCases
+#ifndef NDEBUG
+   , const unsigned char * const aBinnedBucketsEndDebug
+#endif // NDEBUG
+) {
+   StreamBlocks streamBlocks(pTrainingSet->m_pOriginDataSet, pAttributeCombination, iCaseStart, cCases);
+   size_t iBlockCaseStart;
+   size_t cBlockCases;
+   while(streamBlocks.Next(&iBlockCaseStart, &cBlockCases)) {
+      BinDataSetTrainingDispatch<countCompilerClassificationTargetStates>(aBinnedBuckets, pAttributeCombination, pTrainingSet, cTargetStates, iBlockCaseStart, cBlockCases
+#ifndef NDEBUG
+         , aBinnedBucketsEndDebug
+#endif // NDEBUG
+      );
+   }
+}
+
+// Splitting binning across threads requires that each thread bin into its own private histogram, and then we merge the private histograms together.  Merging
+// costs about one add per bucket per vector item for each partition, whereas binning costs about one add per case per vector item plus a random memory access, so
+// we only split when every partition bins many more cases than it has histogram slots to merge.  The partition boundaries depend only on the number of cases
+// and the histogram size (never on the number of threads) and we merge in partition order, so we get identical results regardless of how many threads are available.
+// Once we split, the sums are added in a different order than a single serial pass, so those histograms can differ in the last bits from releases that didn't
+// partition.  We partition even with one thread rather than fall back to the serial order, since otherwise our results would depend on the thread count
+constexpr size_t k_cCasesPerBinPartitionMin = 32768;
+constexpr size_t k_cBinPartitionsMax = 64;
+constexpr size_t k_cCasesPerBinnedBucketMergeMin = 16;
+
+// returns the number of partitions to bin cCases in, which is 1 if we shouldn't split.  cHistogramItems is the total number of PredictionStatistics items that
+// each partition would need to merge.  Every partition except the last has *pcCasesPerPartition cases, which is a multiple of cItemsPerBitPackDataUnit
+TML_INLINE size_t GetBinPartitionCount(const size_t cCases, const size_t cHistogramItems, const size_t cItemsPerBitPackDataUnit, size_t * const pcCasesPerPartition) {
+   EBM_ASSERT(0 < cCases);
+   EBM_ASSERT(0 < cHistogramItems);
+   EBM_ASSERT(0 < cItemsPerBitPackDataUnit);
+
+   *pcCasesPerPartition = cCases;
+
+   size_t cPartitions = cCases / k_cCasesPerBinPartitionMin;
+   cPartitions = k_cBinPartitionsMax < cPartitions ? k_cBinPartitionsMax : cPartitions;
+   if(IsMultiplyError(cHistogramItems, k_cCasesPerBinnedBucketMergeMin)) {
+      return 1;
+   }
+   const size_t cPartitionsMergeLimit = cCases / (cHistogramItems * k_cCasesPerBinnedBucketMergeMin);
+   cPartitions = cPartitionsMergeLimit < cPartitions ? cPartitionsMergeLimit : cPartitions;
+   if(cPartitions <= 1) {
+      return 1;
+   }
+
+   // every partition except the last needs to end on a bit pack boundary so that the next partition can start on one
+   size_t cCasesPerPartition = (cCases + cPartitions - 1) / cPartitions;
+   cCasesPerPartition = (cCasesPerPartition + cItemsPerBitPackDataUnit - 1) / cItemsPerBitPackDataUnit * cItemsPerBitPackDataUnit;
+   // rounding up might leave the last partition empty, so recalculate
+   cPartitions = (cCases + cCasesPerPartition - 1) / cCasesPerPartition;
+   *pcCasesPerPartition = cCasesPerPartition;
+   return cPartitions;
+}
+
+template<ptrdiff_t countCompilerClassificationTargetStates>
+class BinDataSetTrainingPartitionsContext final {
+public:
+   BinnedBucket<IsRegression(countCompilerClassificationTargetStates)> * const m_aBinnedBuckets;
+   // partition zero bins directly into m_aBinnedBuckets, and all the other partitions bin into their own histogram here
+   BinnedBucket<IsRegression(countCompilerClassificationTargetStates)> * const m_aPrivateBinnedBuckets;
+   const size_t m_cBytesHistogram;
+   const AttributeCombinationCore * const m_pAttributeCombination;
+   const SamplingMethod * const m_pTrainingSet;
+   const size_t m_cTargetStates;
+   const size_t m_cCasesPerPartition;
+
+   BinDataSetTrainingPartitionsContext(BinnedBucket<IsRegression(countCompilerClassificationTargetStates)> * const aBinnedBuckets, BinnedBucket<IsRegression(countCompilerClassificationTargetStates)> * const aPrivateBinnedBuckets, const size_t cBytesHistogram, const AttributeCombinationCore * const pAttributeCombination, const SamplingMethod * const pTrainingSet, const size_t cTargetStates, const size_t cCasesPerPartition)
+      : m_aBinnedBuckets(aBinnedBuckets)
+      , m_aPrivateBinnedBuckets(aPrivateBinnedBuckets)
+      , m_cBytesHistogram(cBytesHistogram)
+      , m_pAttributeCombination(pAttributeCombination)
+      , m_pTrainingSet(pTrainingSet)
+      , m_cTargetStates(cTargetStates)
+      , m_cCasesPerPartition(cCasesPerPartition) {
+   }
+
+   TML_INLINE BinnedBucket<IsRegression(countCompilerClassificationTargetStates)> * GetHistogram(const size_t iPartition) const {
+      if(0 == iPartition) {
+         return m_aBinnedBuckets;
       }
+      return reinterpret_cast<BinnedBucket<IsRegression(countCompilerClassificationTargetStates)> *>(reinterpret_cast<char *>(m_aPrivateBinnedBuckets) + (iPartition - 1) * m_cBytesHistogram);
    }
 };
 
 template<ptrdiff_t countCompilerClassificationTargetStates>
-class RecursiveBinDataSetTraining<countCompilerClassificationTargetStates, k_cDimensionsMax> {
-   // C++ does not allow partial function specialization, so we need to use these cumbersome inline static class functions to do partial function specialization
-public:
-   TML_INLINE static void Recursive(const size_t cRuntimeDimensions, BinnedBucket<IsRegression(countCompilerClassificationTargetStates)> * const aBinnedBuckets, const AttributeCombinationCore * const pAttributeCombination, const SamplingMethod * const pTrainingSet, const size_t cTargetStates
+void BinDataSetTrainingPartitionTask(void * const pContext, const size_t iPartition) {
+   const BinDataSetTrainingPartitionsContext<countCompilerClassificationTargetStates> * const pBinDataSetTrainingPartitionsContext = static_cast<const BinDataSetTrainingPartitionsContext<countCompilerClassificationTargetStates> *>(pContext);
+
+   BinnedBucket<IsRegression(countCompilerClassificationTargetStates)> * const aHistogram = pBinDataSetTrainingPartitionsContext->GetHistogram(iPartition);
+   if(0 != iPartition) {
+      // our caller zeroed the main histogram, but the private ones are ours to zero, which spreads that work across the threads too
+      memset(aHistogram, 0, pBinDataSetTrainingPartitionsContext->m_cBytesHistogram);
+   }
+
+   const size_t cCasesTotal = pBinDataSetTrainingPartitionsContext->m_pTrainingSet->m_pOriginDataSet->GetCountCases();
+   const size_t iCaseStart = iPartition * pBinDataSetTrainingPartitionsContext->m_cCasesPerPartition;
+   EBM_ASSERT(iCaseStart < cCasesTotal);
+   const size_t cCasesRemaining = cCasesTotal - iCaseStart;
+   const size_t cCases = cCasesRemaining < pBinDataSetTrainingPartitionsContext->m_cCasesPerPartition ? cCasesRemaining : pBinDataSetTrainingPartitionsContext->m_cCasesPerPartition;
+
+   BinDataSetTrainingStreamed<countCompilerClassificationTargetStates>(aHistogram, pBinDataSetTrainingPartitionsContext->m_pAttributeCombination, pBinDataSetTrainingPartitionsContext->m_pTrainingSet, pBinDataSetTrainingPartitionsContext->m_cTargetStates, iCaseStart, cCases
+#ifndef NDEBUG
+      , reinterpret_cast<const unsigned char *>(aHistogram) + pBinDataSetTrainingPartitionsContext->m_cBytesHistogram
+#endif // NDEBUG
+   );
+}
+
+// bins all the cases in pTrainingSet into the first cBinnedBuckets of aBinnedBuckets, which our caller needs to have zeroed.  Returns true on error
+template<ptrdiff_t countCompilerClassificationTargetStates>
+bool BinDataSetTrainingParallel(CachedTrainingThreadResources<IsRegression(countCompilerClassificationTargetStates)> * const pCachedThreadResources, BinnedBucket<IsRegression(countCompilerClassificationTargetStates)> * const aBinnedBuckets, const size_t cBinnedBuckets, const AttributeCombinationCore * const pAttributeCombination, const SamplingMethod * const pTrainingSet, const size_t cTargetStates
+#ifndef NDEBUG
+   , const unsigned char * const aBinnedBucketsEndDebug
+#endif // NDEBUG
+) {
+   LOG(TraceLevelVerbose, "Entered BinDataSetTrainingParallel");
+
+   EBM_ASSERT(1 <= pAttributeCombination->m_cAttributes);
+   EBM_ASSERT(1 <= cBinnedBuckets);
+
+   const size_t cVectorLength = GET_VECTOR_LENGTH(countCompilerClassificationTargetStates, cTargetStates);
+   const size_t cCases = pTrainingSet->m_pOriginDataSet->GetCountCases();
+   EBM_ASSERT(0 < cCases);
+
+   if(SamplingTypeCore::FlatCore == pTrainingSet->m_samplingType) {
+      // our case counts per bin never change, so SamplingFlat counted them once at initialization.  The binning loops for SamplingFlat don't touch
+      // cCasesInBucket, and the private partition histograms are zeroed, so we can fill in the counts before we bin
+      const size_t * const aCountCasesInBins = static_cast<const SamplingFlat *>(pTrainingSet)->GetCountCasesInBins(pAttributeCombination->m_iInputData);
+      EBM_ASSERT(!GetBinnedBucketSizeOverflow<IsRegression(countCompilerClassificationTargetStates)>(cVectorLength)); // our caller checked this
+      const size_t cBytesPerBinnedBucketFlat = GetBinnedBucketSize<IsRegression(countCompilerClassificationTargetStates)>(cVectorLength);
+      for(size_t iBucket = 0; iBucket < cBinnedBuckets; ++iBucket) {
+         BinnedBucket<IsRegression(countCompilerClassificationTargetStates)> * const pBinnedBucket = GetBinnedBucketByIndex(cBytesPerBinnedBucketFlat, aBinnedBuckets, iBucket);
+         ASSERT_BINNED_BUCKET_OK(cBytesPerBinnedBucketFlat, pBinnedBucket, aBinnedBucketsEndDebug);
+         pBinnedBucket->cCasesInBucket = aCountCasesInBins[iBucket];
+      }
+   }
+
+   // cBinnedBuckets * cVectorLength can't overflow since our caller has already allocated a histogram that big
+   size_t cCasesPerPartition;
+   const size_t cPartitions = GetBinPartitionCount(cCases, cBinnedBuckets * cVectorLength, pAttributeCombination->m_cItemsPerBitPackDataUnit, &cCasesPerPartition);
+   if(cPartitions <= 1) {
+      // small datasets, or large histograms, are better off single threaded without any merging
+      BinDataSetTrainingStreamed<countCompilerClassificationTargetStates>(aBinnedBuckets, pAttributeCombination, pTrainingSet, cTargetStates, 0, cCases
+#ifndef NDEBUG
+         , aBinnedBucketsEndDebug
+#endif // NDEBUG
+      );
+      LOG(TraceLevelVerbose, "Exited BinDataSetTrainingParallel single partition");
+      return false;
+   }
+
+   EBM_ASSERT(2 <= cPartitions);
+
+   EBM_ASSERT(!GetBinnedBucketSizeOverflow<IsRegression(countCompilerClassificationTargetStates)>(cVectorLength)); // our caller checked this
+   const size_t cBytesHistogram = cBinnedBuckets * GetBinnedBucketSize<IsRegression(countCompilerClassificationTargetStates)>(cVectorLength);
+   // this can't overflow since cPartitions is limited by the number of cases, which we already hold in memory many times over
+   BinnedBucket<IsRegression(countCompilerClassificationTargetStates)> * const aPrivateBinnedBuckets = static_cast<BinnedBucket<IsRegression(countCompilerClassificationTargetStates)> *>(pCachedThreadResources->GetThreadByteBuffer3(cBytesHistogram * (cPartitions - 1)));
+   if(UNLIKELY(nullptr == aPrivateBinnedBuckets)) {
+      LOG(TraceLevelWarning, "WARNING BinDataSetTrainingParallel nullptr == aPrivateBinnedBuckets");
+      return true;
+   }
+
+   BinDataSetTrainingPartitionsContext<countCompilerClassificationTargetStates> binDataSetTrainingPartitionsContext(aBinnedBuckets, aPrivateBinnedBuckets, cBytesHistogram, pAttributeCombination, pTrainingSet, cTargetStates, cCasesPerPartition);
+   ExecuteParallel(cPartitions, &BinDataSetTrainingPartitionTask<countCompilerClassificationTargetStates>, &binDataSetTrainingPartitionsContext);
+
+   // merge in partition order so that our floating point sums are done in the same order each time
+   const size_t cBytesPerBinnedBucket = GetBinnedBucketSize<IsRegression(countCompilerClassificationTargetStates)>(cVectorLength);
+   for(size_t iPartition = 1; iPartition < cPartitions; ++iPartition) {
+      const BinnedBucket<IsRegression(countCompilerClassificationTargetStates)> * const aPrivateHistogram = binDataSetTrainingPartitionsContext.GetHistogram(iPartition);
+      for(size_t iBucket = 0; iBucket < cBinnedBuckets; ++iBucket) {
+         BinnedBucket<IsRegression(countCompilerClassificationTargetStates)> * const pBinnedBucket = GetBinnedBucketByIndex(cBytesPerBinnedBucket, aBinnedBuckets, iBucket);
+         ASSERT_BINNED_BUCKET_OK(cBytesPerBinnedBucket, pBinnedBucket, aBinnedBucketsEndDebug);
+         pBinnedBucket->template Add<countCompilerClassificationTargetStates>(*GetBinnedBucketByIndex(cBytesPerBinnedBucket, aPrivateHistogram, iBucket), cTargetStates);
+      }
+   }
+
+   LOG(TraceLevelVerbose, "Exited BinDataSetTrainingParallel");
+   return false;
+}
+
+// When we have inner bags, every bag bins the same packed input data and the same residuals and only the occurrence counts differ, so binning each bag
+// separately streams the input data and residuals from memory once per bag.  This fused version reads each packed data unit and each residual once and then
+// scatters it into all the bag histograms, which are laid out one after another in aBinnedBucketsAllSamplingSets, each taking cBytesHistogram bytes.
+// Our results are identical to calling BinDataSetTraining for each bag since each bag's histogram receives its additions in the same order
+// bins the cases in the range [iCaseStart, iCaseStart + cCases).  iCaseStart needs to be on a bit pack boundary
+template<ptrdiff_t countCompilerClassificationTargetStates, typename TFloat, typename TCountOccurrences>
+TML_INLINE void BinDataSetTrainingFused(BinnedBucket<IsRegression(countCompilerClassificationTargetStates)> * const aBinnedBucketsAllSamplingSets, const size_t cBytesHistogram, const size_t cSamplingSets, const SamplingMethod * const * const apSamplingSets, const AttributeCombinationCore * const pAttributeCombination, const size_t cTargetStates, const size_t iCaseStart, const size_t cCases
+#ifndef NDEBUG
+   , const unsigned char * const aBinnedBucketsEndDebug
+#endif // NDEBUG
+) {
+   LOG(TraceLevelVerbose, "Entered BinDataSetTrainingFused");
+
+   EBM_ASSERT(1 <= pAttributeCombination->m_cAttributes);
+   EBM_ASSERT(1 <= cSamplingSets);
+
+   const size_t cVectorLength = GET_VECTOR_LENGTH(countCompilerClassificationTargetStates, cTargetStates);
+   const size_t cItemsPerBitPackDataUnit = pAttributeCombination->m_cItemsPerBitPackDataUnit;
+   const size_t cBitsPerItemMax = GetCountBits(cItemsPerBitPackDataUnit);
+   const size_t maskBits = std::numeric_limits<size_t>::max() >> (k_cBitsForStorageType - cBitsPerItemMax);
+   EBM_ASSERT(!GetBinnedBucketSizeOverflow<IsRegression(countCompilerClassificationTargetStates)>(cVectorLength)); // we're accessing allocated memory
+   const size_t cBytesPerBinnedBucket = GetBinnedBucketSize<IsRegression(countCompilerClassificationTargetStates)>(cVectorLength);
+
+   EBM_ASSERT(0 < cCases);
+   const DataSetAttributeCombination * const pOriginDataSet = apSamplingSets[0]->m_pOriginDataSet;
+   EBM_ASSERT(iCaseStart + cCases <= pOriginDataSet->GetCountCases());
+   EBM_ASSERT(0 == iCaseStart % cItemsPerBitPackDataUnit);
+
+   const StorageDataTypeCore * pInputData = pOriginDataSet->GetDataPointer(pAttributeCombination) + iCaseStart / cItemsPerBitPackDataUnit;
+   const TFloat * pResidualError = pOriginDataSet->GetResidualPointer<TFloat>() + cVectorLength * iCaseStart;
+
+   size_t iCase = iCaseStart;
+   const size_t iCaseEnd = iCaseStart + cCases;
+   do {
+      // we store the already multiplied dimensional value in *pInputData
+      size_t iBinCombined = static_cast<size_t>(*pInputData);
+      ++pInputData;
+      const size_t cItemsRemainingInRange = iCaseEnd - iCase;
+      size_t cItemsRemaining = cItemsRemainingInRange < cItemsPerBitPackDataUnit ? cItemsRemainingInRange : cItemsPerBitPackDataUnit;
+      do {
+         const size_t iBin = maskBits & iBinCombined;
+         unsigned char * pBinnedBucketEntryBytes = reinterpret_cast<unsigned char *>(GetBinnedBucketByIndex(cBytesPerBinnedBucket, aBinnedBucketsAllSamplingSets, iBin));
+
+         size_t iSamplingSet = 0;
+         do {
+            BinnedBucket<IsRegression(countCompilerClassificationTargetStates)> * const pBinnedBucketEntry = reinterpret_cast<BinnedBucket<IsRegression(countCompilerClassificationTargetStates)> *>(pBinnedBucketEntryBytes);
+            ASSERT_BINNED_BUCKET_OK(cBytesPerBinnedBucket, pBinnedBucketEntry, aBinnedBucketsEndDebug);
+
+            const size_t cOccurences = TCountOccurrences::GetCountOccurrences(apSamplingSets[iSamplingSet], iCase);
+            pBinnedBucketEntry->cCasesInBucket += cOccurences;
+            const FractionalDataType cFloatOccurences = static_cast<FractionalDataType>(cOccurences);
+            PredictionStatistics<IsRegression(countCompilerClassificationTargetStates)> * const pPredictionStatistics = &pBinnedBucketEntry->aPredictionStatistics[0];
+            size_t iVector = 0;
+            do {
+               // the residuals for this case were pulled into cache by the first bag, so subsequent bags read them from cache instead of main memory
+               const FractionalDataType residualError = static_cast<FractionalDataType>(pResidualError[iVector]);
+               pPredictionStatistics[iVector].sumResidualError += cFloatOccurences * residualError;
+               if(IsClassification(countCompilerClassificationTargetStates)) {
+                  const FractionalDataType absResidualError = std::abs(residualError); // abs will return the same type that it is given, either float or double
+                  pPredictionStatistics[iVector].SetSumDenominator(pPredictionStatistics[iVector].GetSumDenominator() + cFloatOccurences * (absResidualError * (1 - absResidualError)));
+               }
+               ++iVector;
+            } while(iVector < cVectorLength);
+
+            pBinnedBucketEntryBytes += cBytesHistogram;
+            ++iSamplingSet;
+         } while(iSamplingSet < cSamplingSets);
+
+         pResidualError += cVectorLength;
+         ++iCase;
+         iBinCombined >>= cBitsPerItemMax;
+         --cItemsRemaining;
+      } while(0 != cItemsRemaining);
+   } while(iCase < iCaseEnd);
+
+   LOG(TraceLevelVerbose, "Exited BinDataSetTrainingFused");
+}
+
+template<ptrdiff_t countCompilerClassificationTargetStates, typename TFloat, typename TCountOccurrences>
+struct BinDataSetTrainingFusedSimd final {
+   template<typename... TArgs>
+   TML_INLINE static void Run(const TArgs... args) {
+      BinDataSetTrainingFused<countCompilerClassificationTargetStates, TFloat, TCountOccurrences>(args...);
+   }
+};
+
+// all of our bags are generated by the same SamplingMethod, so the first one tells us how they all store their occurrences.  We only fuse when we have
+// multiple bags, so we never see a SamplingFlat here
+template<ptrdiff_t countCompilerClassificationTargetStates, typename TFloat>
+TML_INLINE void BinDataSetTrainingFusedOccurrencesDispatch(BinnedBucket<IsRegression(countCompilerClassificationTargetStates)> * const aBinnedBucketsAllSamplingSets, const size_t cBytesHistogram, const size_t cSamplingSets, const SamplingMethod * const * const apSamplingSets, const AttributeCombinationCore * const pAttributeCombination, const size_t cTargetStates, const size_t iCaseStart, const size_t cCases
 #ifndef NDEBUG
-      , const unsigned char * const aBinnedBucketsEndDebug
+   , const unsigned char * const aBinnedBucketsEndDebug
 #endif // NDEBUG
-   ) {
-      UNUSED(cRuntimeDimensions);
-      EBM_ASSERT(k_cDimensionsMax == cRuntimeDimensions);
-      BinDataSetTraining<countCompilerClassificationTargetStates, k_cDimensionsMax>(aBinnedBuckets, pAttributeCombination, pTrainingSet, cTargetStates
+) {
+   EBM_ASSERT(SamplingTypeCore::FlatCore != apSamplingSets[0]->m_samplingType);
+   if(SamplingTypeCore::WithoutReplacementCore == apSamplingSets[0]->m_samplingType) {
+      RunSimdVariant<BinDataSetTrainingFusedSimd<countCompilerClassificationTargetStates, TFloat, CountOccurrencesWithoutReplacement>>(aBinnedBucketsAllSamplingSets, cBytesHistogram, cSamplingSets, apSamplingSets, pAttributeCombination, cTargetStates, iCaseStart, cCases
+#ifndef NDEBUG
+         , aBinnedBucketsEndDebug
+#endif // NDEBUG
+      );
+   } else {
+      RunSimdVariant<BinDataSetTrainingFusedSimd<countCompilerClassificationTargetStates, TFloat, CountOccurrencesWithReplacement>>(aBinnedBucketsAllSamplingSets, cBytesHistogram, cSamplingSets, apSamplingSets, pAttributeCombination, cTargetStates, iCaseStart, cCases
 #ifndef NDEBUG
          , aBinnedBucketsEndDebug
 #endif // NDEBUG
       );
    }
+}
+
+template<ptrdiff_t countCompilerClassificationTargetStates>
+class BinDataSetTrainingFusedPartitionsContext final {
+public:
+   // each partition gets cSamplingSets histograms, one after another, and partition zero holds the merged results when we're done
+   BinnedBucket<IsRegression(countCompilerClassificationTargetStates)> * const m_aBinnedBucketsAllPartitions;
+   const size_t m_cBytesHistogram;
+   const size_t m_cSamplingSets;
+   const SamplingMethod * const * const m_apSamplingSets;
+   const AttributeCombinationCore * const m_pAttributeCombination;
+   const size_t m_cTargetStates;
+   const size_t m_cCasesPerPartition;
+
+   BinDataSetTrainingFusedPartitionsContext(BinnedBucket<IsRegression(countCompilerClassificationTargetStates)> * const aBinnedBucketsAllPartitions, const size_t cBytesHistogram, const size_t cSamplingSets, const SamplingMethod * const * const apSamplingSets, const AttributeCombinationCore * const pAttributeCombination, const size_t cTargetStates, const size_t cCasesPerPartition)
+      : m_aBinnedBucketsAllPartitions(aBinnedBucketsAllPartitions)
+      , m_cBytesHistogram(cBytesHistogram)
+      , m_cSamplingSets(cSamplingSets)
+      , m_apSamplingSets(apSamplingSets)
+      , m_pAttributeCombination(pAttributeCombination)
+      , m_cTargetStates(cTargetStates)
+      , m_cCasesPerPartition(cCasesPerPartition) {
+   }
+
+   TML_INLINE BinnedBucket<IsRegression(countCompilerClassificationTargetStates)> * GetHistograms(const size_t iPartition) const {
+      return reinterpret_cast<BinnedBucket<IsRegression(countCompilerClassificationTargetStates)> *>(reinterpret_cast<char *>(m_aBinnedBucketsAllPartitions) + iPartition * m_cSamplingSets * m_cBytesHistogram);
+   }
 };
 
-// TODO: make the number of dimensions (pAttributeCombination->m_cAttributes) a template parameter so that we don't have to have the inner loop that is very bad for performance.  Since the data will be stored contiguously and have the same length in the future, we can just loop based on the number of dimensions, so we might as well have a couple of different values
 template<ptrdiff_t countCompilerClassificationTargetStates>
-void BinDataSetInteraction(BinnedBucket<IsRegression(countCompilerClassificationTargetStates)> * const aBinnedBuckets, const AttributeCombinationCore * const pAttributeCombination, const DataSetInternalCore * const pDataSet, const size_t cTargetStates
+void BinDataSetTrainingFusedPartitionTask(void * const pContext, const size_t iPartition) {
+   const BinDataSetTrainingFusedPartitionsContext<countCompilerClassificationTargetStates> * const pBinDataSetTrainingFusedPartitionsContext = static_cast<const BinDataSetTrainingFusedPartitionsContext<countCompilerClassificationTargetStates> *>(pContext);
+
+   const size_t cBytesAllSamplingSets = pBinDataSetTrainingFusedPartitionsContext->m_cSamplingSets * pBinDataSetTrainingFusedPartitionsContext->m_cBytesHistogram;
+   BinnedBucket<IsRegression(countCompilerClassificationTargetStates)> * const aHistograms = pBinDataSetTrainingFusedPartitionsContext->GetHistograms(iPartition);
+   memset(aHistograms, 0, cBytesAllSamplingSets);
+
+   const size_t cCasesTotal = pBinDataSetTrainingFusedPartitionsContext->m_apSamplingSets[0]->m_pOriginDataSet->GetCountCases();
+   const size_t iCaseStart = iPartition * pBinDataSetTrainingFusedPartitionsContext->m_cCasesPerPartition;
+   EBM_ASSERT(iCaseStart < cCasesTotal);
+   const size_t cCasesRemaining = cCasesTotal - iCaseStart;
+   const size_t cCases = cCasesRemaining < pBinDataSetTrainingFusedPartitionsContext->m_cCasesPerPartition ? cCasesRemaining : pBinDataSetTrainingFusedPartitionsContext->m_cCasesPerPartition;
+
+   // binning consecutive blocks into the same histograms adds the cases in the same order as binning the whole partition at once
+   const DataSetAttributeCombination * const pOriginDataSet = pBinDataSetTrainingFusedPartitionsContext->m_apSamplingSets[0]->m_pOriginDataSet;
+   StreamBlocks streamBlocks(pOriginDataSet, pBinDataSetTrainingFusedPartitionsContext->m_pAttributeCombination, iCaseStart, cCases);
+   size_t iBlockCaseStart;
+   size_t cBlockCases;
+   while(streamBlocks.Next(&iBlockCaseStart, &cBlockCases)) {
+      if(pOriginDataSet->IsSinglePrecision()) {
+         BinDataSetTrainingFusedOccurrencesDispatch<countCompilerClassificationTargetStates, float>(aHistograms, pBinDataSetTrainingFusedPartitionsContext->m_cBytesHistogram, pBinDataSetTrainingFusedPartitionsContext->m_cSamplingSets, pBinDataSetTrainingFusedPartitionsContext->m_apSamplingSets, pBinDataSetTrainingFusedPartitionsContext->m_pAttributeCombination, pBinDataSetTrainingFusedPartitionsContext->m_cTargetStates, iBlockCaseStart, cBlockCases
+#ifndef NDEBUG
+            , reinterpret_cast<const unsigned char *>(aHistograms) + cBytesAllSamplingSets
+#endif // NDEBUG
+         );
+      } else {
+         BinDataSetTrainingFusedOccurrencesDispatch<countCompilerClassificationTargetStates, FractionalDataType>(aHistograms, pBinDataSetTrainingFusedPartitionsContext->m_cBytesHistogram, pBinDataSetTrainingFusedPartitionsContext->m_cSamplingSets, pBinDataSetTrainingFusedPartitionsContext->m_apSamplingSets, pBinDataSetTrainingFusedPartitionsContext->m_pAttributeCombination, pBinDataSetTrainingFusedPartitionsContext->m_cTargetStates, iBlockCaseStart, cBlockCases
+#ifndef NDEBUG
+            , reinterpret_cast<const unsigned char *>(aHistograms) + cBytesAllSamplingSets
+#endif // NDEBUG
+         );
+      }
+   }
+}
+
+// the fused scratch holds a histogram for every sampling set in every partition, which grows with the product of all three.  Above this many bytes the
+// single pass over the data no longer pays for itself (the histograms fall out of cache and we'd hold a very large buffer for the life of the booster), so
+// our callers fall back to binning each sampling set separately with BinDataSetTrainingParallel.  Both split the cases into the same partitions and merge
+// them in the same order, so crossing this limit doesn't change the histograms
+constexpr size_t k_cBytesFusedBinningMax = size_t { 16 } << 20;
+
+// returns the number of bytes that BinDataSetTrainingFusedParallel needs for aBinnedBucketsAllPartitions, or 0 on overflow.  *pcPartitions and
+// *pcCasesPerPartition need to be passed on to BinDataSetTrainingFusedParallel.  Callers should bin each sampling set separately if this is 0 or over
+// k_cBytesFusedBinningMax
+template<ptrdiff_t countCompilerClassificationTargetStates>
+size_t GetBinDataSetTrainingFusedBytes(const size_t cBinnedBuckets, const size_t cSamplingSets, const size_t cCases, const AttributeCombinationCore * const pAttributeCombination, const size_t cTargetStates, size_t * const pcPartitions, size_t * const pcCasesPerPartition) {
+   const size_t cVectorLength = GET_VECTOR_LENGTH(countCompilerClassificationTargetStates, cTargetStates);
+   if(GetBinnedBucketSizeOverflow<IsRegression(countCompilerClassificationTargetStates)>(cVectorLength)) {
+      return 0;
+   }
+   const size_t cBytesPerBinnedBucket = GetBinnedBucketSize<IsRegression(countCompilerClassificationTargetStates)>(cVectorLength);
+   if(IsMultiplyError(cBinnedBuckets, cBytesPerBinnedBucket)) {
+      return 0;
+   }
+   const size_t cBytesHistogram = cBinnedBuckets * cBytesPerBinnedBucket;
+   if(IsMultiplyError(cBytesHistogram, cSamplingSets)) {
+      return 0;
+   }
+   const size_t cBytesAllSamplingSets = cBytesHistogram * cSamplingSets;
+   // we partition by the size of one sampling set's histogram, exactly like BinDataSetTrainingParallel does, so that each sampling set's histogram gets its
+   // floating point additions in the same order whichever of us bins it.  cBinnedBuckets * cVectorLength can't overflow since the byte count is larger than it
+   const size_t cPartitions = GetBinPartitionCount(cCases, cBinnedBuckets * cVectorLength, pAttributeCombination->m_cItemsPerBitPackDataUnit, pcCasesPerPartition);
+   *pcPartitions = cPartitions;
+   if(IsMultiplyError(cBytesAllSamplingSets, cPartitions)) {
+      return 0;
+   }
+   return cBytesAllSamplingSets * cPartitions;
+}
+
+// bins all the cases for every sampling set in a single pass over the data.  aBinnedBucketsAllPartitions needs to be GetBinDataSetTrainingFusedBytes bytes
+// and doesn't need to be zeroed.  When we return, the first cSamplingSets histograms in aBinnedBucketsAllPartitions hold the binned results for each sampling set
+template<ptrdiff_t countCompilerClassificationTargetStates>
+void BinDataSetTrainingFusedParallel(BinnedBucket<IsRegression(countCompilerClassificationTargetStates)> * const aBinnedBucketsAllPartitions, const size_t cPartitions, const size_t cCasesPerPartition, const size_t cBinnedBuckets, const size_t cSamplingSets, const SamplingMethod * const * const apSamplingSets, const AttributeCombinationCore * const pAttributeCombination, const size_t cTargetStates) {
+   LOG(TraceLevelVerbose, "Entered BinDataSetTrainingFusedParallel");
+
+   EBM_ASSERT(1 <= cPartitions);
+   EBM_ASSERT(1 <= cBinnedBuckets);
+   EBM_ASSERT(1 <= cSamplingSets);
+
+   const size_t cVectorLength = GET_VECTOR_LENGTH(countCompilerClassificationTargetStates, cTargetStates);
+   EBM_ASSERT(!GetBinnedBucketSizeOverflow<IsRegression(countCompilerClassificationTargetStates)>(cVectorLength)); // GetBinDataSetTrainingFusedBytes checked this
+   const size_t cBytesPerBinnedBucket = GetBinnedBucketSize<IsRegression(countCompilerClassificationTargetStates)>(cVectorLength);
+   const size_t cBytesHistogram = cBinnedBuckets * cBytesPerBinnedBucket;
+
+   BinDataSetTrainingFusedPartitionsContext<countCompilerClassificationTargetStates> binDataSetTrainingFusedPartitionsContext(aBinnedBucketsAllPartitions, cBytesHistogram, cSamplingSets, apSamplingSets, pAttributeCombination, cTargetStates, cCasesPerPartition);
+   if(1 == cPartitions) {
+      BinDataSetTrainingFusedPartitionTask<countCompilerClassificationTargetStates>(&binDataSetTrainingFusedPartitionsContext, 0);
+   } else {
+      ExecuteParallel(cPartitions, &BinDataSetTrainingFusedPartitionTask<countCompilerClassificationTargetStates>, &binDataSetTrainingFusedPartitionsContext);
+   }
+
+   // merge in partition order so that our floating point sums are done in the same order each time.  The bag histograms are contiguous within each
+   // partition, so we can merge all the bags at once as if they were one big histogram
+   const size_t cBinnedBucketsAllSamplingSets = cBinnedBuckets * cSamplingSets;
+   for(size_t iPartition = 1; iPartition < cPartitions; ++iPartition) {
+      const BinnedBucket<IsRegression(countCompilerClassificationTargetStates)> * const aPrivateHistograms = binDataSetTrainingFusedPartitionsContext.GetHistograms(iPartition);
+      for(size_t iBucket = 0; iBucket < cBinnedBucketsAllSamplingSets; ++iBucket) {
+         BinnedBucket<IsRegression(countCompilerClassificationTargetStates)> * const pBinnedBucket = GetBinnedBucketByIndex(cBytesPerBinnedBucket, aBinnedBucketsAllPartitions, iBucket);
+         pBinnedBucket->template Add<countCompilerClassificationTargetStates>(*GetBinnedBucketByIndex(cBytesPerBinnedBucket, aPrivateHistograms, iBucket), cTargetStates);
+      }
+   }
+
+   LOG(TraceLevelVerbose, "Exited BinDataSetTrainingFusedParallel");
+}
+
+// the input column and the tensor stride of each dimension of an attribute combination, which turns binning a case into straight index arithmetic.  We
+// fill this in once before walking the cases instead of going through the attribute pointers for each dimension of each case, and with a compile time
+// number of dimensions the loop over the dimensions unrolls completely
+template<size_t countCompilerDimensions>
+class InteractionBucketIndexer final {
+   TensorStrides<countCompilerDimensions> m_tensorStrides;
+   const StorageDataTypeCore * m_aInputData[countCompilerDimensions <= 0 ? k_cDimensionsMax : countCompilerDimensions];
+
+public:
+
+   TML_INLINE void Initialize(const AttributeCombinationCore * const pAttributeCombination, const DataSetInternalCore * const pDataSet) {
+      m_tensorStrides.Initialize(pAttributeCombination);
+      const size_t cDimensions = m_tensorStrides.GetCountDimensions();
+      for(size_t iDimension = 0; iDimension < cDimensions; ++iDimension) {
+         m_aInputData[iDimension] = pDataSet->GetDataPointer(pAttributeCombination->m_AttributeCombinationEntry[iDimension].m_pAttribute);
+      }
+   }
+
+   TML_INLINE size_t GetBucketIndex(const size_t iCase) const {
+      const size_t cDimensions = m_tensorStrides.GetCountDimensions();
+      EBM_ASSERT(1 <= cDimensions); // for interactions, we just return 0 for interactions with zero attributes
+      size_t iBucket = 0;
+      size_t iDimension = 0;
+      do {
+         const StorageDataTypeCore data = m_aInputData[iDimension][iCase];
+         EBM_ASSERT((IsNumberConvertable<size_t, StorageDataTypeCore>(data)));
+         const size_t iState = static_cast<size_t>(data);
+         EBM_ASSERT(iState < m_tensorStrides.GetCountStates(iDimension));
+         iBucket += m_tensorStrides.GetStride(iDimension) * iState;
+         ++iDimension;
+      } while(iDimension < cDimensions);
+      return iBucket;
+   }
+};
+
+template<ptrdiff_t countCompilerClassificationTargetStates, size_t countCompilerDimensions>
+TML_INLINE void BinDataSetInteraction(BinnedBucket<IsRegression(countCompilerClassificationTargetStates)> * const aBinnedBuckets, const AttributeCombinationCore * const pAttributeCombination, const DataSetInternalCore * const pDataSet, const size_t cTargetStates
 #ifndef NDEBUG
    , const unsigned char * const aBinnedBucketsEndDebug
 #endif // NDEBUG
@@ -361,34 +942,18 @@ void BinDataSetInteraction(BinnedBucket<IsRegression(countCompilerClassification
    const FractionalDataType * pResidualError = pDataSet->GetResidualPointer();
    const FractionalDataType * const pResidualErrorEnd = pResidualError + cVectorLength * pDataSet->GetCountCases();
 
-   size_t cAttributes = pAttributeCombination->m_cAttributes;
-   EBM_ASSERT(1 <= cAttributes); // for interactions, we just return 0 for interactions with zero attributes
+   InteractionBucketIndexer<countCompilerDimensions> bucketIndexer;
+   bucketIndexer.Initialize(pAttributeCombination, pDataSet);
+
    for(size_t iCase = 0; pResidualErrorEnd != pResidualError; ++iCase) {
       // this loop gets about twice as slow if you add a single unpredictable branching if statement based on count, even if you still access all the memory in complete sequential order, so we'll probably want to use non-branching instructions for any solution like conditional selection or multiplication
       // this loop gets about 3 times slower if you use a bad pseudo random number generator like rand(), although it might be better if you inlined rand().
       // this loop gets about 10 times slower if you use a proper pseudo random number generator like std::default_random_engine
       // taking all the above together, it seems unlikley we'll use a method of separating sets via single pass randomized set splitting.  Even if count is stored in memory if shouldn't increase the time spent fetching it by 2 times, unless our bottleneck when threading is overwhelmingly memory pressure related, and even then we could store the count for a single bit aleviating the memory pressure greatly, if we use the right sampling method 
 
-      // TODO : try using a sampling method with non-repeating cases, and put the count into a bit.  Then unwind that loop either at the byte level (8 times) or the uint64_t level.  This can be done without branching and doesn't require random number generators
-
       // TODO : we can elminate the inner vector loop for regression at least, and also if we add a templated bool for binary class.  Propegate this change to all places that we loop on the vector
 
-      size_t cBuckets = 1;
-      size_t iBucket = 0;
-      size_t iDimension = 0;
-      do {
-         const AttributeInternalCore * const pInputAttribute = pAttributeCombination->m_AttributeCombinationEntry[iDimension].m_pAttribute;
-         const size_t cStates = pInputAttribute->m_cStates;
-         const StorageDataTypeCore * pInputData = pDataSet->GetDataPointer(pInputAttribute);
-         pInputData += iCase;
-         StorageDataTypeCore data = *pInputData;
-         EBM_ASSERT((IsNumberConvertable<size_t, StorageDataTypeCore>(data)));
-         size_t iState = static_cast<size_t>(data);
-         EBM_ASSERT(iState < cStates);
-         iBucket += cBuckets * iState;
-         cBuckets *= cStates;
-         ++iDimension;
-      } while(iDimension < cAttributes);
+      const size_t iBucket = bucketIndexer.GetBucketIndex(iCase);
  
       BinnedBucket<IsRegression(countCompilerClassificationTargetStates)> * pBinnedBucketEntry = GetBinnedBucketByIndex<IsRegression(countCompilerClassificationTargetStates)>(cBytesPerBinnedBucket, aBinnedBuckets, iBucket);
       ASSERT_BINNED_BUCKET_OK(cBytesPerBinnedBucket, pBinnedBucketEntry, aBinnedBucketsEndDebug);
@@ -406,6 +971,86 @@ void BinDataSetInteraction(BinnedBucket<IsRegression(countCompilerClassification
    LOG(TraceLevelVerbose, "Exited BinDataSetInteraction");
 }
 
+template<ptrdiff_t countCompilerClassificationTargetStates, size_t countCompilerDimensions>
+struct BinDataSetInteractionSimd final {
+   template<typename... TArgs>
+   TML_INLINE static void Run(const TArgs... args) {
+      BinDataSetInteraction<countCompilerClassificationTargetStates, countCompilerDimensions>(args...);
+   }
+};
+
+// BinDataSetInteraction streams the full input columns and residuals for every attribute combination that we score, so scoring all pairs of a wide dataset
+// reads the residuals once per pair.  Here we bin a whole block of attribute combinations together by walking the cases in tiles that fit comfortably in
+// the L2 cache along with the input columns that the block uses.  Each tile of residuals is loaded from memory once and then re-used from the cache for every
+// combination in the block.  Each histogram still receives its cases in the original order, so the results are identical to BinDataSetInteraction
+constexpr size_t k_cCasesPerInteractionTile = 2048;
+
+// bins the cases from iCaseTileStart to iCaseTileEnd of a single attribute combination for BinDataSetInteractionTiled
+template<ptrdiff_t countCompilerClassificationTargetStates, size_t countCompilerDimensions>
+TML_INLINE void BinDataSetInteractionTile(BinnedBucket<IsRegression(countCompilerClassificationTargetStates)> * const aBinnedBuckets, const AttributeCombinationCore * const pAttributeCombination, const DataSetInternalCore * const pDataSet, const size_t cTargetStates, const size_t iCaseTileStart, const size_t iCaseTileEnd) {
+   const size_t cVectorLength = GET_VECTOR_LENGTH(countCompilerClassificationTargetStates, cTargetStates);
+   EBM_ASSERT(!GetBinnedBucketSizeOverflow<IsRegression(countCompilerClassificationTargetStates)>(cVectorLength)); // we're accessing allocated memory
+   const size_t cBytesPerBinnedBucket = GetBinnedBucketSize<IsRegression(countCompilerClassificationTargetStates)>(cVectorLength);
+
+   InteractionBucketIndexer<countCompilerDimensions> bucketIndexer;
+   bucketIndexer.Initialize(pAttributeCombination, pDataSet);
+
+   const FractionalDataType * pResidualError = pDataSet->GetResidualPointer() + cVectorLength * iCaseTileStart;
+   for(size_t iCase = iCaseTileStart; iCase < iCaseTileEnd; ++iCase) {
+      const size_t iBucket = bucketIndexer.GetBucketIndex(iCase);
+
+      BinnedBucket<IsRegression(countCompilerClassificationTargetStates)> * const pBinnedBucketEntry = GetBinnedBucketByIndex<IsRegression(countCompilerClassificationTargetStates)>(cBytesPerBinnedBucket, aBinnedBuckets, iBucket);
+      pBinnedBucketEntry->cCasesInBucket += 1;
+      for(size_t iVector = 0; iVector < cVectorLength; ++iVector) {
+         pBinnedBucketEntry->aPredictionStatistics[iVector].sumResidualError += *pResidualError;
+         if(IsClassification(countCompilerClassificationTargetStates)) {
+            const FractionalDataType absResidualError = std::abs(*pResidualError); // abs will return the same type that it is given, either float or double
+            pBinnedBucketEntry->aPredictionStatistics[iVector].SetSumDenominator(pBinnedBucketEntry->aPredictionStatistics[iVector].GetSumDenominator() + absResidualError * (1 - absResidualError));
+         }
+         ++pResidualError;
+      }
+   }
+}
+
+template<ptrdiff_t countCompilerClassificationTargetStates, size_t countCompilerDimensions>
+struct BinDataSetInteractionTileDimensions final {
+   template<typename... TArgs>
+   TML_INLINE static void Run(const TArgs... args) {
+      BinDataSetInteractionTile<countCompilerClassificationTargetStates, countCompilerDimensions>(args...);
+   }
+};
+
+// bins all the cases into aaBinnedBuckets[iAttributeCombination] for each of the cAttributeCombinations, which our caller needs to have zeroed.  The
+// combinations in a block can have different numbers of dimensions, so we pick the dimension specialization separately for each of them
+template<ptrdiff_t countCompilerClassificationTargetStates>
+TML_INLINE void BinDataSetInteractionTiled(const size_t cAttributeCombinations, const AttributeCombinationCore * const * const apAttributeCombinations, BinnedBucket<IsRegression(countCompilerClassificationTargetStates)> * const * const aaBinnedBuckets, const DataSetInternalCore * const pDataSet, const size_t cTargetStates) {
+   LOG(TraceLevelVerbose, "Entered BinDataSetInteractionTiled");
+
+   EBM_ASSERT(1 <= cAttributeCombinations);
+
+   const size_t cCases = pDataSet->GetCountCases();
+
+   for(size_t iCaseTileStart = 0; iCaseTileStart < cCases; iCaseTileStart += k_cCasesPerInteractionTile) {
+      const size_t cCasesRemaining = cCases - iCaseTileStart;
+      const size_t iCaseTileEnd = iCaseTileStart + (cCasesRemaining < k_cCasesPerInteractionTile ? cCasesRemaining : k_cCasesPerInteractionTile);
+
+      for(size_t iAttributeCombination = 0; iAttributeCombination < cAttributeCombinations; ++iAttributeCombination) {
+         const AttributeCombinationCore * const pAttributeCombination = apAttributeCombinations[iAttributeCombination];
+         EBM_ASSERT(1 <= pAttributeCombination->m_cAttributes); // for interactions, we just return 0 for interactions with zero attributes
+         CompilerRecursiveDimensions<BinDataSetInteractionTileDimensions, countCompilerClassificationTargetStates>::Run(pAttributeCombination->m_cAttributes, aaBinnedBuckets[iAttributeCombination], pAttributeCombination, pDataSet, cTargetStates, iCaseTileStart, iCaseTileEnd);
+      }
+   }
+   LOG(TraceLevelVerbose, "Exited BinDataSetInteractionTiled");
+}
+
+template<ptrdiff_t countCompilerClassificationTargetStates>
+struct BinDataSetInteractionTiledSimd final {
+   template<typename... TArgs>
+   TML_INLINE static void Run(const TArgs... args) {
+      BinDataSetInteractionTiled<countCompilerClassificationTargetStates>(args...);
+   }
+};
+
 // TODO: change our downstream code to not need this Compression.  This compression often won't do anything because most of the time every bin will have data, and if there is sparse data with lots of values then maybe we don't want to do a complete sweep of this data moving it arround anyways.  We only do a minimial # of splits anyways.  I can calculate the sums in the loop that builds the bins instead of here!
 template<ptrdiff_t countCompilerClassificationTargetStates>
 size_t CompressBinnedBuckets(const SamplingMethod * const pTrainingSet, const size_t cBinnedBuckets, BinnedBucket<IsRegression(countCompilerClassificationTargetStates)> * const aBinnedBuckets, size_t * const pcCasesTotal, PredictionStatistics<IsRegression(countCompilerClassificationTargetStates)> * const aSumPredictionStatistics, const size_t cTargetStates
@@ -15,6 +15,18 @@
 template<bool bRegression>
 class TreeNode;
 
+// our scratch buffers grow to twice what they were asked for, so that a slightly bigger request later doesn't need another allocation.  EstimateMemoryUsage
+// predicts our buffer sizes with these same functions, so keep any change to how we grow here
+constexpr TML_INLINE size_t GetThreadByteBufferGrowth(const size_t cBytesRequired) {
+   return MultiplySaturate(cBytesRequired, 2);
+}
+// GrowThreadByteBuffer2 keeps the existing tree nodes, so it doubles what it has and adds cByteBoundaries, which keeps its size a whole number of tree nodes
+constexpr TML_INLINE size_t GetThreadByteBuffer2Growth(const size_t cBytesCapacity, const size_t cByteBoundaries) {
+   return AddSaturate(cByteBoundaries, MultiplySaturate(cBytesCapacity, 2));
+}
+// GrowDecisionTree starts with 1 TreeNode for the root, 1 for the left child of the root and 1 for the right child of the root
+constexpr size_t k_cTreeNodesInitial = 3;
+
 template<bool bRegression>
 class CompareTreeNodeSplittingGain final {
 public:
@@ -40,6 +52,10 @@ class CachedTrainingThreadResources {
    void * m_aThreadByteBuffer2;
    size_t m_cThreadByteBufferCapacity2;
 
+   // holds the private histograms that we bin into when binning is split across threads.  Kept separate from ThreadByteBuffer1 since that holds the merged histogram
+   void * m_aThreadByteBuffer3;
+   size_t m_cThreadByteBufferCapacity3;
+
 public:
 
    PredictionStatistics<bRegression> * const m_aSumPredictionStatistics;
@@ -59,6 +75,8 @@ public:
       , m_cThreadByteBufferCapacity1(0)
       , m_aThreadByteBuffer2(nullptr)
       , m_cThreadByteBufferCapacity2(0)
+      , m_aThreadByteBuffer3(nullptr)
+      , m_cThreadByteBufferCapacity3(0)
       , m_aSumPredictionStatistics(new (std::nothrow) PredictionStatistics<bRegression>[cVectorLength])
       , m_aSumPredictionStatistics1(new (std::nothrow) PredictionStatistics<bRegression>[cVectorLength])
       , m_aSumPredictionStatisticsBest(new (std::nothrow) PredictionStatistics<bRegression>[cVectorLength])
@@ -85,6 +103,7 @@ public:
 
       free(m_aThreadByteBuffer1);
       free(m_aThreadByteBuffer2);
+      free(m_aThreadByteBuffer3);
       delete[] m_aSumPredictionStatistics;
       delete[] m_aSumPredictionStatistics1;
       delete[] m_aSumPredictionStatisticsBest;
@@ -95,7 +114,7 @@ public:
 
    TML_INLINE void * GetThreadByteBuffer1(const size_t cBytesRequired) {
       if(UNLIKELY(m_cThreadByteBufferCapacity1 < cBytesRequired)) {
-         m_cThreadByteBufferCapacity1 = cBytesRequired << 1;
+         m_cThreadByteBufferCapacity1 = GetThreadByteBufferGrowth(cBytesRequired);
          LOG(TraceLevelInfo, "Growing CachedTrainingThreadResources::ThreadByteBuffer1 to %zu", m_cThreadByteBufferCapacity1);
          // TODO : use malloc here instead of realloc.  We don't need to copy the data, and if we free first then we can either slot the new memory in the old slot or it can be moved
          void * const aNewThreadByteBuffer = realloc(m_aThreadByteBuffer1, m_cThreadByteBufferCapacity1);
@@ -115,7 +134,7 @@ public:
       //   1) we ensure that if we have zero size, we'll get some size that we'll get a non-zero size after the shift
       //   2) we'll always get back an odd number of items, which is good because we always have an odd number of TreeNodeChilden
       EBM_ASSERT(0 == m_cThreadByteBufferCapacity2 % cByteBoundaries);
-      m_cThreadByteBufferCapacity2 = cByteBoundaries + (m_cThreadByteBufferCapacity2 << 1);
+      m_cThreadByteBufferCapacity2 = GetThreadByteBuffer2Growth(m_cThreadByteBufferCapacity2, cByteBoundaries);
       LOG(TraceLevelInfo, "Growing CachedTrainingThreadResources::ThreadByteBuffer2 to %zu", m_cThreadByteBufferCapacity2);
       // TODO : can we use malloc here?  We only need realloc if we need to keep the existing data
       void * const aNewThreadByteBuffer = realloc(m_aThreadByteBuffer2, m_cThreadByteBufferCapacity2);
@@ -136,6 +155,26 @@ public:
       return m_cThreadByteBufferCapacity2;
    }
 
+   TML_INLINE void * GetThreadByteBuffer3(const size_t cBytesRequired) {
+      if(UNLIKELY(m_cThreadByteBufferCapacity3 < cBytesRequired)) {
+         m_cThreadByteBufferCapacity3 = GetThreadByteBufferGrowth(cBytesRequired);
+         LOG(TraceLevelInfo, "Growing CachedTrainingThreadResources::ThreadByteBuffer3 to %zu", m_cThreadByteBufferCapacity3);
+         // we don't need to keep the old contents, so free first which gives the allocator a chance to reuse the old slot
+         free(m_aThreadByteBuffer3);
+         m_aThreadByteBuffer3 = malloc(m_cThreadByteBufferCapacity3);
+         if(UNLIKELY(nullptr == m_aThreadByteBuffer3)) {
+            m_cThreadByteBufferCapacity3 = 0;
+            return nullptr;
+         }
+      }
+      return m_aThreadByteBuffer3;
+   }
+
+   // the histogram, tree node and partition buffers that we've grown so far.  These never shrink until we're destroyed
+   TML_INLINE size_t GetThreadByteBufferBytes() const {
+      return m_cThreadByteBufferCapacity1 + m_cThreadByteBufferCapacity2 + m_cThreadByteBufferCapacity3;
+   }
+
    TML_INLINE bool IsError() const {
       return m_bError || nullptr == m_aSumPredictionStatistics || nullptr == m_aSumPredictionStatistics1 || nullptr == m_aSumPredictionStatisticsBest || nullptr == m_aSumResidualErrors2;
    }
@@ -146,24 +185,39 @@ class CachedInteractionThreadResources {
    void * m_aThreadByteBuffer1;
    size_t m_cThreadByteBufferCapacity1;
 
+   // holds the histograms for a block of attribute combinations that we bin together in CalculateInteractionScores
+   void * m_aThreadByteBuffer2;
+   size_t m_cThreadByteBufferCapacity2;
+
+   // holds the AttributeCombinationCore objects for a block of attribute combinations that we score together.  A full block is tens of kilobytes, which
+   // we don't want on the stack of our worker threads since they only get 1MB by default on Windows
+   void * m_aAttributeCombinationsBlock;
+   size_t m_cAttributeCombinationsBlockCapacity;
+
 public:
 
    CachedInteractionThreadResources()
       : m_aThreadByteBuffer1(nullptr)
-      , m_cThreadByteBufferCapacity1(0) {
+      , m_cThreadByteBufferCapacity1(0)
+      , m_aThreadByteBuffer2(nullptr)
+      , m_cThreadByteBufferCapacity2(0)
+      , m_aAttributeCombinationsBlock(nullptr)
+      , m_cAttributeCombinationsBlockCapacity(0) {
    }
 
    ~CachedInteractionThreadResources() {
       LOG(TraceLevelInfo, "Entered ~CachedInteractionThreadResources");
 
       free(m_aThreadByteBuffer1);
+      free(m_aThreadByteBuffer2);
+      free(m_aAttributeCombinationsBlock);
 
       LOG(TraceLevelInfo, "Exited ~CachedInteractionThreadResources");
    }
 
    TML_INLINE void * GetThreadByteBuffer1(const size_t cBytesRequired) {
       if(UNLIKELY(m_cThreadByteBufferCapacity1 < cBytesRequired)) {
-         m_cThreadByteBufferCapacity1 = cBytesRequired << 1;
+         m_cThreadByteBufferCapacity1 = GetThreadByteBufferGrowth(cBytesRequired);
          LOG(TraceLevelInfo, "Growing CachedInteractionThreadResources::ThreadByteBuffer1 to %zu", m_cThreadByteBufferCapacity1);
          // TODO : use malloc here instead of realloc.  We don't need to copy the data, and if we free first then we can either slot the new memory in the old slot or it can be moved
          void * const aNewThreadByteBuffer = realloc(m_aThreadByteBuffer1, m_cThreadByteBufferCapacity1);
@@ -176,6 +230,36 @@ public:
       }
       return m_aThreadByteBuffer1;
    }
+
+   TML_INLINE void * GetThreadByteBuffer2(const size_t cBytesRequired) {
+      if(UNLIKELY(m_cThreadByteBufferCapacity2 < cBytesRequired)) {
+         m_cThreadByteBufferCapacity2 = GetThreadByteBufferGrowth(cBytesRequired);
+         LOG(TraceLevelInfo, "Growing CachedInteractionThreadResources::ThreadByteBuffer2 to %zu", m_cThreadByteBufferCapacity2);
+         // we don't need to keep the old contents, so free first which gives the allocator a chance to reuse the old slot
+         free(m_aThreadByteBuffer2);
+         m_aThreadByteBuffer2 = malloc(m_cThreadByteBufferCapacity2);
+         if(UNLIKELY(nullptr == m_aThreadByteBuffer2)) {
+            m_cThreadByteBufferCapacity2 = 0;
+            return nullptr;
+         }
+      }
+      return m_aThreadByteBuffer2;
+   }
+
+   // we always ask for the same size, so this only allocates the first time that a thread scores interactions
+   TML_INLINE void * GetAttributeCombinationsBlock(const size_t cBytesRequired) {
+      if(UNLIKELY(m_cAttributeCombinationsBlockCapacity < cBytesRequired)) {
+         LOG(TraceLevelInfo, "Growing CachedInteractionThreadResources::AttributeCombinationsBlock to %zu", cBytesRequired);
+         free(m_aAttributeCombinationsBlock);
+         m_aAttributeCombinationsBlock = malloc(cBytesRequired);
+         if(UNLIKELY(nullptr == m_aAttributeCombinationsBlock)) {
+            m_cAttributeCombinationsBlockCapacity = 0;
+            return nullptr;
+         }
+         m_cAttributeCombinationsBlockCapacity = cBytesRequired;
+      }
+      return m_aAttributeCombinationsBlock;
+   }
 };
 
 #endif // CACHED_THREAD_RESOURCES_H
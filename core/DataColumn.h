@@ -0,0 +1,115 @@
+// Copyright (c) 2018 Microsoft Corporation
+// Licensed under the MIT license.
+// Author: Paul Koch <code@koch.ninja>
+
+#ifndef DATA_COLUMN_H
+#define DATA_COLUMN_H
+
+#include <stdlib.h> // malloc, free
+#include <string.h> // memcpy
+#include <stddef.h> // size_t, ptrdiff_t
+#include <stdint.h> // uint8_t, uint16_t, uint32_t
+
+#include "ebmcore.h" // EbmDataColumn
+#include "EbmInternal.h" // TML_INLINE
+#include "Logging.h" // EBM_ASSERT & LOG
+
+enum class DataColumnTypeCore { Int64Core = 0, UInt8Core = 1, UInt16Core = 2, UInt32Core = 3 };
+
+// reads one binned attribute column directly out of our caller's memory.  We only construct our packed datasets once, so the switch on the column type
+// inside Next() is cheap compared to widening the whole matrix into IntegerDataType before we start, which is what we used to require of our caller
+class DataColumnReader final {
+   const unsigned char * m_pData;
+   ptrdiff_t m_cBytesStride;
+   DataColumnTypeCore m_dataType;
+
+public:
+
+   // this class is kept in fixed size arrays on the stack, so we initialize it through a function instead of a constructor
+   TML_INLINE void Initialize(const EbmDataColumn * const pColumn) {
+      EBM_ASSERT(nullptr != pColumn);
+      EBM_ASSERT(nullptr != pColumn->data);
+      EBM_ASSERT((IsNumberConvertable<ptrdiff_t, IntegerDataType>(pColumn->strideBytes))); // checked when we were given the columns
+      m_pData = static_cast<const unsigned char *>(pColumn->data);
+      m_cBytesStride = static_cast<ptrdiff_t>(pColumn->strideBytes);
+      m_dataType = static_cast<DataColumnTypeCore>(pColumn->dataType);
+   }
+
+   TML_INLINE IntegerDataType Next() {
+      IntegerDataType data;
+      // our caller is allowed to give us unaligned data (eg: a uint16 column inside a packed record), so read through memcpy which compiles to a plain load
+      switch(m_dataType) {
+      case DataColumnTypeCore::UInt8Core:
+         data = static_cast<IntegerDataType>(*m_pData);
+         break;
+      case DataColumnTypeCore::UInt16Core: {
+         uint16_t value;
+         memcpy(&value, m_pData, sizeof(value));
+         data = static_cast<IntegerDataType>(value);
+         break;
+      }
+      case DataColumnTypeCore::UInt32Core: {
+         uint32_t value;
+         memcpy(&value, m_pData, sizeof(value));
+         data = static_cast<IntegerDataType>(value);
+         break;
+      }
+      default: {
+         EBM_ASSERT(DataColumnTypeCore::Int64Core == m_dataType);
+         memcpy(&data, m_pData, sizeof(data));
+         break;
+      }
+      }
+      m_pData += m_cBytesStride;
+      return data;
+   }
+};
+
+// returns true if all the columns have a type we understand and a stride we can use.  A null columns array is legal if there are no cases or no attributes
+TML_INLINE static bool IsDataColumnsError(const size_t cAttributes, const EbmDataColumn * const aColumns) {
+   if(nullptr == aColumns) {
+      return false;
+   }
+   for(size_t iAttribute = 0; iAttribute < cAttributes; ++iAttribute) {
+      const EbmDataColumn * const pColumn = &aColumns[iAttribute];
+      if(DataColumnTypeInt64 != pColumn->dataType && DataColumnTypeUInt8 != pColumn->dataType && DataColumnTypeUInt16 != pColumn->dataType && DataColumnTypeUInt32 != pColumn->dataType) {
+         LOG(TraceLevelWarning, "WARNING IsDataColumnsError unknown dataType");
+         return true;
+      }
+      if(nullptr == pColumn->data) {
+         LOG(TraceLevelWarning, "WARNING IsDataColumnsError nullptr == pColumn->data");
+         return true;
+      }
+      if(!IsNumberConvertable<ptrdiff_t, IntegerDataType>(pColumn->strideBytes)) {
+         LOG(TraceLevelWarning, "WARNING IsDataColumnsError !IsNumberConvertable<ptrdiff_t, IntegerDataType>(pColumn->strideBytes)");
+         return true;
+      }
+   }
+   return false;
+}
+
+// our original API takes a Fortran ordered IntegerDataType matrix.  We describe each column of that matrix with an EbmDataColumn so that
+// there is only one path through which we ingest data.  The caller needs to free the result
+TML_INLINE static EbmDataColumn * ConstructInt64DataColumns(const size_t cAttributes, const size_t cCases, const IntegerDataType * const aData) {
+   if(nullptr == aData || 0 == cAttributes) {
+      return nullptr;
+   }
+   if(IsMultiplyError(sizeof(EbmDataColumn), cAttributes)) {
+      LOG(TraceLevelWarning, "WARNING ConstructInt64DataColumns IsMultiplyError(sizeof(EbmDataColumn), cAttributes)");
+      return nullptr;
+   }
+   EbmDataColumn * const aColumns = static_cast<EbmDataColumn *>(malloc(sizeof(EbmDataColumn) * cAttributes));
+   if(nullptr == aColumns) {
+      LOG(TraceLevelWarning, "WARNING ConstructInt64DataColumns nullptr == aColumns");
+      return nullptr;
+   }
+   for(size_t iAttribute = 0; iAttribute < cAttributes; ++iAttribute) {
+      // our caller allocated the full matrix, so iAttribute * cCases can't overflow
+      aColumns[iAttribute].data = &aData[iAttribute * cCases];
+      aColumns[iAttribute].dataType = DataColumnTypeInt64;
+      aColumns[iAttribute].strideBytes = static_cast<IntegerDataType>(sizeof(IntegerDataType));
+   }
+   return aColumns;
+}
+
+#endif // DATA_COLUMN_H
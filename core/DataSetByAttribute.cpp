@@ -6,12 +6,15 @@
 
 #include <assert.h>
 #include <stdlib.h> // malloc, realloc, free
+#include <string.h> // memcpy
 #include <stddef.h> // size_t, ptrdiff_t
+#include <new> // std::nothrow
 
 #include "ebmcore.h" // FractionalDataType
 #include "EbmInternal.h" // AttributeTypeCore
 #include "Logging.h" // EBM_ASSERT & LOG
 #include "AttributeInternal.h"
+#include "DataColumn.h"
 #include "DataSetByAttribute.h"
 #include "InitializeResiduals.h"
 
@@ -53,7 +56,7 @@ TML_INLINE static const FractionalDataType * ConstructResidualErrors(const bool
    return aResidualErrors;
 }
 
-TML_INLINE static const StorageDataTypeCore * const * ConstructInputData(const size_t cAttributes, const AttributeInternalCore * const aAttributes, const size_t cCases, const IntegerDataType * const aInputDataFrom) {
+TML_INLINE static const StorageDataTypeCore * const * ConstructInputData(const size_t cAttributes, const AttributeInternalCore * const aAttributes, const size_t cCases, const EbmDataColumn * const aInputDataFrom) {
    LOG(TraceLevelInfo, "Entered DataSetInternalCore::ConstructInputData");
 
    EBM_ASSERT(0 < cAttributes);
@@ -91,18 +94,18 @@ TML_INLINE static const StorageDataTypeCore * const * ConstructInputData(const s
       *paInputDataTo = pInputDataTo;
       ++paInputDataTo;
 
-      const IntegerDataType * pInputDataFrom = &aInputDataFrom[pAttribute->m_iAttributeData * cCases];
-      const IntegerDataType * pInputDataFromEnd = &pInputDataFrom[cCases];
+      DataColumnReader column;
+      column.Initialize(&aInputDataFrom[pAttribute->m_iAttributeData]);
+      const StorageDataTypeCore * const pInputDataToEnd = &pInputDataTo[cCases];
       do {
-         const IntegerDataType data = *pInputDataFrom;
+         const IntegerDataType data = column.Next();
          EBM_ASSERT(0 <= data);
          EBM_ASSERT((IsNumberConvertable<size_t, IntegerDataType>(data))); // data must be lower than cTargetStates and cTargetStates fits into a size_t which we checked earlier
          EBM_ASSERT(static_cast<size_t>(data) < pAttribute->m_cStates);
          EBM_ASSERT((IsNumberConvertable<StorageDataTypeCore, IntegerDataType>(data)));
          *pInputDataTo = static_cast<StorageDataTypeCore>(data);
          ++pInputDataTo;
-         ++pInputDataFrom;
-      } while(pInputDataFromEnd != pInputDataFrom);
+      } while(pInputDataToEnd != pInputDataTo);
 
       ++pAttribute;
    } while(pAttributeEnd != pAttribute);
@@ -119,13 +122,119 @@ free_all:
    return nullptr;
 }
 
-DataSetInternalCore::DataSetInternalCore(const bool bRegression, const size_t cAttributes, const AttributeInternalCore * const aAttributes, const size_t cCases, const IntegerDataType * const aInputDataFrom, const void * const aTargetData, const FractionalDataType * const aPredictionScores, const size_t cTargetStates)
+TML_INLINE static const FractionalDataType * ConstructResidualErrorsSubset(const FractionalDataType * const aResidualErrorsFrom, const size_t cVectorLength, const size_t cCases, const size_t * const aiCases) {
+   LOG(TraceLevelInfo, "Entered DataSetInternalCore::ConstructResidualErrorsSubset");
+
+   EBM_ASSERT(nullptr != aResidualErrorsFrom);
+   EBM_ASSERT(1 <= cVectorLength);
+   EBM_ASSERT(1 <= cCases);
+   EBM_ASSERT(nullptr != aiCases);
+
+   // our caller's dataset was already allocated with at least this many items, so none of these multiplications can overflow
+   EBM_ASSERT(!IsMultiplyError(cCases, cVectorLength));
+   EBM_ASSERT(!IsMultiplyError(sizeof(FractionalDataType), cCases * cVectorLength));
+   FractionalDataType * const aResidualErrors = static_cast<FractionalDataType *>(malloc(sizeof(FractionalDataType) * cCases * cVectorLength));
+   if(nullptr == aResidualErrors) {
+      LOG(TraceLevelWarning, "WARNING DataSetInternalCore::ConstructResidualErrorsSubset nullptr == aResidualErrors");
+      return nullptr;
+   }
+
+   FractionalDataType * pResidualErrorTo = aResidualErrors;
+   const size_t * piCase = aiCases;
+   const size_t * const piCaseEnd = aiCases + cCases;
+   do {
+      memcpy(pResidualErrorTo, &aResidualErrorsFrom[*piCase * cVectorLength], sizeof(FractionalDataType) * cVectorLength);
+      pResidualErrorTo += cVectorLength;
+      ++piCase;
+   } while(piCaseEnd != piCase);
+
+   LOG(TraceLevelInfo, "Exited DataSetInternalCore::ConstructResidualErrorsSubset");
+   return aResidualErrors;
+}
+
+TML_INLINE static const StorageDataTypeCore * const * ConstructInputDataSubset(const StorageDataTypeCore * const * const aaInputDataFrom, const size_t cAttributes, const size_t cCases, const size_t * const aiCases) {
+   LOG(TraceLevelInfo, "Entered DataSetInternalCore::ConstructInputDataSubset");
+
+   EBM_ASSERT(nullptr != aaInputDataFrom);
+   EBM_ASSERT(0 < cAttributes);
+   EBM_ASSERT(0 < cCases);
+   EBM_ASSERT(nullptr != aiCases);
+
+   // our caller's dataset was already allocated with at least this many items, so none of these multiplications can overflow
+   EBM_ASSERT(!IsMultiplyError(sizeof(StorageDataTypeCore), cCases));
+   EBM_ASSERT(!IsMultiplyError(sizeof(void *), cAttributes));
+   StorageDataTypeCore ** const aaInputDataTo = static_cast<StorageDataTypeCore * *>(malloc(sizeof(void *) * cAttributes));
+   if(nullptr == aaInputDataTo) {
+      LOG(TraceLevelWarning, "WARNING DataSetInternalCore::ConstructInputDataSubset nullptr == aaInputDataTo");
+      return nullptr;
+   }
+
+   StorageDataTypeCore ** paInputDataTo = aaInputDataTo;
+   const StorageDataTypeCore * const * paInputDataFrom = aaInputDataFrom;
+   const StorageDataTypeCore * const * const paInputDataFromEnd = aaInputDataFrom + cAttributes;
+   do {
+      StorageDataTypeCore * pInputDataTo = static_cast<StorageDataTypeCore *>(malloc(sizeof(StorageDataTypeCore) * cCases));
+      if(nullptr == pInputDataTo) {
+         LOG(TraceLevelWarning, "WARNING DataSetInternalCore::ConstructInputDataSubset nullptr == pInputDataTo");
+         goto free_all;
+      }
+      *paInputDataTo = pInputDataTo;
+      ++paInputDataTo;
+
+      const StorageDataTypeCore * const aInputDataFrom = *paInputDataFrom;
+      const size_t * piCase = aiCases;
+      const size_t * const piCaseEnd = aiCases + cCases;
+      do {
+         *pInputDataTo = aInputDataFrom[*piCase];
+         ++pInputDataTo;
+         ++piCase;
+      } while(piCaseEnd != piCase);
+
+      ++paInputDataFrom;
+   } while(paInputDataFromEnd != paInputDataFrom);
+
+   LOG(TraceLevelInfo, "Exited DataSetInternalCore::ConstructInputDataSubset");
+   return aaInputDataTo;
+
+free_all:
+   while(aaInputDataTo != paInputDataTo) {
+      --paInputDataTo;
+      free(*paInputDataTo);
+   }
+   free(aaInputDataTo);
+   return nullptr;
+}
+
+DataSetInternalCore::DataSetInternalCore(const bool bRegression, const size_t cAttributes, const AttributeInternalCore * const aAttributes, const size_t cCases, const EbmDataColumn * const aInputDataFrom, const void * const aTargetData, const FractionalDataType * const aPredictionScores, const size_t cTargetStates)
    : m_aResidualErrors(ConstructResidualErrors(bRegression, cCases, aTargetData, aPredictionScores, cTargetStates))
    , m_aaInputData(0 == cAttributes ? nullptr : ConstructInputData(cAttributes, aAttributes, cCases, aInputDataFrom))
    , m_cCases(cCases)
-   , m_cAttributes(cAttributes) {
+   , m_cAttributes(cAttributes)
+   , m_pDataSetShared(nullptr) {
+
+   EBM_ASSERT(0 < cCases);
+}
+
+DataSetInternalCore::DataSetInternalCore(const bool bRegression, DataSetShared * const pDataSetShared, const void * const aTargetData, const FractionalDataType * const aPredictionScores, const size_t cTargetStates)
+   : m_aResidualErrors(ConstructResidualErrors(bRegression, pDataSetShared->GetCountCases(), aTargetData, aPredictionScores, cTargetStates))
+   , m_aaInputData(pDataSetShared->GetInputData())
+   , m_cCases(pDataSetShared->GetCountCases())
+   , m_cAttributes(pDataSetShared->GetCountAttributes())
+   , m_pDataSetShared(pDataSetShared) {
+
+   EBM_ASSERT(0 < m_cCases);
+   pDataSetShared->AddReference();
+}
+
+DataSetInternalCore::DataSetInternalCore(const DataSetInternalCore & dataSetFrom, const size_t cVectorLength, const size_t cCases, const size_t * const aiCases)
+   : m_aResidualErrors(ConstructResidualErrorsSubset(dataSetFrom.m_aResidualErrors, cVectorLength, cCases, aiCases))
+   , m_aaInputData(0 == dataSetFrom.m_cAttributes ? nullptr : ConstructInputDataSubset(dataSetFrom.m_aaInputData, dataSetFrom.m_cAttributes, cCases, aiCases))
+   , m_cCases(cCases)
+   , m_cAttributes(dataSetFrom.m_cAttributes)
+   , m_pDataSetShared(nullptr) {
 
    EBM_ASSERT(0 < cCases);
+   EBM_ASSERT(cCases <= dataSetFrom.m_cCases);
 }
 
 DataSetInternalCore::~DataSetInternalCore() {
@@ -133,7 +242,9 @@ DataSetInternalCore::~DataSetInternalCore() {
 
    FractionalDataType * aResidualErrors = const_cast<FractionalDataType *>(m_aResidualErrors);
    free(aResidualErrors);
-   if(nullptr != m_aaInputData) {
+   if(nullptr != m_pDataSetShared) {
+      DataSetShared::Release(m_pDataSetShared);
+   } else if(nullptr != m_aaInputData) {
       EBM_ASSERT(1 <= m_cAttributes);
       const StorageDataTypeCore * const * paInputData = m_aaInputData;
       const StorageDataTypeCore * const * const paInputDataEnd = m_aaInputData + m_cAttributes;
@@ -147,3 +258,151 @@ DataSetInternalCore::~DataSetInternalCore() {
 
    LOG(TraceLevelInfo, "Exited ~DataSetInternalCore");
 }
+
+bool DataSetShared::IsAttributesError(const size_t cAttributes, const EbmAttribute * const aAttributes, const bool bStrict) {
+   for(size_t iAttribute = 0; iAttribute < cAttributes; ++iAttribute) {
+      const EbmAttribute * const pAttribute = &aAttributes[iAttribute];
+      if(!IsNumberConvertable<size_t, IntegerDataType>(pAttribute->countStates) || pAttribute->countStates < 1) {
+         LOG(TraceLevelWarning, "WARNING DataSetShared::IsAttributesError bad countStates");
+         return true;
+      }
+      if(bStrict && (AttributeTypeOrdinal != pAttribute->attributeType && AttributeTypeNominal != pAttribute->attributeType || 0 != pAttribute->hasMissing && 1 != pAttribute->hasMissing)) {
+         LOG(TraceLevelWarning, "WARNING DataSetShared::IsAttributesError bad attributeType or hasMissing");
+         return true;
+      }
+   }
+   return false;
+}
+
+DataSetShared * DataSetShared::Allocate(const size_t cAttributes, const EbmAttribute * const aAttributes, const size_t cCases, const EbmDataColumn * const aColumns) {
+   LOG(TraceLevelInfo, "Entered DataSetShared::Allocate");
+
+   EBM_ASSERT(0 == cAttributes || nullptr != aAttributes);
+   EBM_ASSERT(0 == cAttributes || 0 == cCases || nullptr != aColumns);
+
+   if(IsDataColumnsError(cAttributes, aColumns)) {
+      LOG(TraceLevelWarning, "WARNING DataSetShared::Allocate IsDataColumnsError(cAttributes, aColumns)");
+      return nullptr;
+   }
+   if(IsMultiplyError(sizeof(EbmAttribute), cAttributes) || IsMultiplyError(sizeof(AttributeInternalCore), cAttributes) || IsMultiplyError(sizeof(EbmDataColumn), cAttributes)) {
+      LOG(TraceLevelWarning, "WARNING DataSetShared::Allocate IsMultiplyError(sizeof(EbmAttribute), cAttributes) || IsMultiplyError(sizeof(AttributeInternalCore), cAttributes) || IsMultiplyError(sizeof(EbmDataColumn), cAttributes)");
+      return nullptr;
+   }
+
+   DataSetShared * const pDataSetShared = new (std::nothrow) DataSetShared(cAttributes, cCases);
+   if(nullptr == pDataSetShared) {
+      LOG(TraceLevelWarning, "WARNING DataSetShared::Allocate nullptr == pDataSetShared");
+      return nullptr;
+   }
+   if(0 != cAttributes) {
+      pDataSetShared->m_aAttributes = static_cast<EbmAttribute *>(malloc(sizeof(EbmAttribute) * cAttributes));
+      if(nullptr == pDataSetShared->m_aAttributes) {
+         LOG(TraceLevelWarning, "WARNING DataSetShared::Allocate nullptr == m_aAttributes");
+         delete pDataSetShared;
+         return nullptr;
+      }
+      memcpy(pDataSetShared->m_aAttributes, aAttributes, sizeof(EbmAttribute) * cAttributes);
+
+      if(0 != cCases) {
+         if(IsAttributesError(cAttributes, aAttributes, false)) {
+            LOG(TraceLevelWarning, "WARNING DataSetShared::Allocate IsAttributesError(cAttributes, aAttributes, false)");
+            delete pDataSetShared;
+            return nullptr;
+         }
+         // ConstructInputData only needs the state counts and data indexes, which is all we fill in here
+         AttributeInternalCore * const aAttributesInternal = static_cast<AttributeInternalCore *>(malloc(sizeof(AttributeInternalCore) * cAttributes));
+         if(nullptr == aAttributesInternal) {
+            LOG(TraceLevelWarning, "WARNING DataSetShared::Allocate nullptr == aAttributesInternal");
+            delete pDataSetShared;
+            return nullptr;
+         }
+         for(size_t iAttribute = 0; iAttribute < cAttributes; ++iAttribute) {
+            const EbmAttribute * const pAttribute = &aAttributes[iAttribute];
+            new (&aAttributesInternal[iAttribute]) AttributeInternalCore(static_cast<size_t>(pAttribute->countStates), iAttribute, static_cast<AttributeTypeCore>(pAttribute->attributeType), 0 != pAttribute->hasMissing);
+         }
+         pDataSetShared->m_aaInputData = ConstructInputData(cAttributes, aAttributesInternal, cCases, aColumns);
+         free(aAttributesInternal);
+         if(nullptr == pDataSetShared->m_aaInputData) {
+            LOG(TraceLevelWarning, "WARNING DataSetShared::Allocate nullptr == m_aaInputData");
+            delete pDataSetShared;
+            return nullptr;
+         }
+
+         pDataSetShared->m_aColumns = static_cast<EbmDataColumn *>(malloc(sizeof(EbmDataColumn) * cAttributes));
+         if(nullptr == pDataSetShared->m_aColumns) {
+            LOG(TraceLevelWarning, "WARNING DataSetShared::Allocate nullptr == m_aColumns");
+            delete pDataSetShared;
+            return nullptr;
+         }
+         static_assert(sizeof(StorageDataTypeCore) == sizeof(uint32_t) || sizeof(StorageDataTypeCore) == sizeof(IntegerDataType), "StorageDataTypeCore must be readable as one of our column types");
+         for(size_t iAttribute = 0; iAttribute < cAttributes; ++iAttribute) {
+            pDataSetShared->m_aColumns[iAttribute].data = pDataSetShared->m_aaInputData[iAttribute];
+            pDataSetShared->m_aColumns[iAttribute].dataType = sizeof(StorageDataTypeCore) == sizeof(uint32_t) ? DataColumnTypeUInt32 : DataColumnTypeInt64;
+            pDataSetShared->m_aColumns[iAttribute].strideBytes = static_cast<IntegerDataType>(sizeof(StorageDataTypeCore));
+         }
+      }
+   }
+
+   LOG(TraceLevelInfo, "Exited DataSetShared::Allocate");
+   return pDataSetShared;
+}
+
+DataSetShared::~DataSetShared() {
+   LOG(TraceLevelInfo, "Entered ~DataSetShared");
+
+   free(m_aColumns);
+   if(nullptr != m_aaInputData) {
+      EBM_ASSERT(1 <= m_cAttributes);
+      if(nullptr == m_pFileMapping) {
+         for(size_t iAttribute = 0; iAttribute < m_cAttributes; ++iAttribute) {
+            free(const_cast<StorageDataTypeCore *>(m_aaInputData[iAttribute]));
+         }
+      }
+      free(const_cast<StorageDataTypeCore * *>(m_aaInputData));
+   }
+   free(m_aAttributes);
+   if(nullptr != m_pFileMapping) {
+      UnmapFile(m_pFileMapping, m_cBytesFileMapping);
+   }
+
+   LOG(TraceLevelInfo, "Exited ~DataSetShared");
+}
+
+void DataSetShared::Release(DataSetShared * const pDataSetShared) {
+   if(nullptr != pDataSetShared) {
+      // acq_rel so that everything the other owners did with the dataset happens before we free it
+      if(1 == pDataSetShared->m_cReferences.fetch_sub(1, std::memory_order_acq_rel)) {
+         delete pDataSetShared;
+      }
+   }
+}
+
+EBMCORE_IMPORT_EXPORT PEbmDataSet EBMCORE_CALLING_CONVENTION InitializeDataSet(IntegerDataType countAttributes, const EbmAttribute * attributes, IntegerDataType countCases, const EbmDataColumn * columns) {
+   LOG(TraceLevelInfo, "Entered InitializeDataSet: countAttributes=%" IntegerDataTypePrintf ", attributes=%p, countCases=%" IntegerDataTypePrintf ", columns=%p", countAttributes, static_cast<const void *>(attributes), countCases, static_cast<const void *>(columns));
+
+   if(!IsNumberConvertable<size_t, IntegerDataType>(countAttributes)) {
+      LOG(TraceLevelWarning, "WARNING InitializeDataSet !IsNumberConvertable<size_t, IntegerDataType>(countAttributes)");
+      return nullptr;
+   }
+   if(!IsNumberConvertable<size_t, IntegerDataType>(countCases)) {
+      LOG(TraceLevelWarning, "WARNING InitializeDataSet !IsNumberConvertable<size_t, IntegerDataType>(countCases)");
+      return nullptr;
+   }
+   const size_t cAttributes = static_cast<size_t>(countAttributes);
+   const size_t cCases = static_cast<size_t>(countCases);
+   if(0 != cAttributes && nullptr == attributes || 0 != cAttributes && 0 != cCases && nullptr == columns) {
+      LOG(TraceLevelWarning, "WARNING InitializeDataSet 0 != cAttributes && nullptr == attributes || 0 != cAttributes && 0 != cCases && nullptr == columns");
+      return nullptr;
+   }
+
+   PEbmDataSet pEbmDataSet = reinterpret_cast<PEbmDataSet>(DataSetShared::Allocate(cAttributes, attributes, cCases, columns));
+   LOG(TraceLevelInfo, "Exited InitializeDataSet %p", static_cast<void *>(pEbmDataSet));
+   return pEbmDataSet;
+}
+
+EBMCORE_IMPORT_EXPORT void EBMCORE_CALLING_CONVENTION FreeDataSet(PEbmDataSet ebmDataSet) {
+   LOG(TraceLevelInfo, "Entered FreeDataSet: ebmDataSet=%p", static_cast<void *>(ebmDataSet));
+   // any training or interaction states created from this dataset hold their own references, so this only frees the memory if they are all gone
+   DataSetShared::Release(reinterpret_cast<DataSetShared *>(ebmDataSet));
+   LOG(TraceLevelInfo, "Exited FreeDataSet");
+}
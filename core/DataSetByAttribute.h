@@ -7,22 +7,98 @@
 
 #include <assert.h>
 #include <stddef.h> // size_t, ptrdiff_t
+#include <atomic>
 
 #include "ebmcore.h" // FractionalDataType
 #include "EbmInternal.h" // TML_INLINE
 #include "Logging.h" // EBM_ASSERT & LOG
 #include "AttributeInternal.h"
 
+// binned attribute data without any targets or residuals, which is what our PEbmDataSet handles point to.  The same binned data gets used by
+// training on different targets, by interaction detection and by multiple outer bags, so we keep a single copy alive for as long as anything
+// references it.  Interaction states use our columns directly, and training states pack their attribute combinations from our columns on demand
+class DataSetShared final {
+   std::atomic<size_t> m_cReferences;
+   const size_t m_cAttributes;
+   const size_t m_cCases;
+   EbmAttribute * m_aAttributes;
+   const StorageDataTypeCore * const * m_aaInputData;
+   // describes m_aaInputData, so that anything which ingests EbmDataColumns can read from us
+   EbmDataColumn * m_aColumns;
+   // if we were loaded from a file then our columns point into this read-only mapping of it, and m_aaInputData only owns the array of pointers
+   const void * m_pFileMapping;
+   size_t m_cBytesFileMapping;
+
+   DataSetShared(const size_t cAttributes, const size_t cCases)
+      : m_cReferences(1)
+      , m_cAttributes(cAttributes)
+      , m_cCases(cCases)
+      , m_aAttributes(nullptr)
+      , m_aaInputData(nullptr)
+      , m_aColumns(nullptr)
+      , m_pFileMapping(nullptr)
+      , m_cBytesFileMapping(0) {
+   }
+   ~DataSetShared();
+
+   // these are in DataSetFile.cpp, which keeps the platform specific file mapping headers out of everything else
+   static void UnmapFile(const void * const pFileMapping, const size_t cBytesFileMapping);
+
+   // returns true if any attribute has a countStates that we can't use.  With bStrict we also require a known attributeType and a hasMissing of 0 or 1,
+   // which our callers only promise through asserts, but which any file that we wrote ourselves has
+   static bool IsAttributesError(const size_t cAttributes, const EbmAttribute * const aAttributes, const bool bStrict);
+
+public:
+
+   // returns a dataset with a reference count of 1, or nullptr on error
+   static DataSetShared * Allocate(const size_t cAttributes, const EbmAttribute * const aAttributes, const size_t cCases, const EbmDataColumn * const aColumns);
+
+   TML_INLINE void AddReference() {
+      m_cReferences.fetch_add(1, std::memory_order_relaxed);
+   }
+   // frees the dataset once the last reference is released.  pDataSetShared can be nullptr
+   static void Release(DataSetShared * const pDataSetShared);
+
+   // writes our attributes and binned columns to a versioned binary file.  Returns true on error
+   bool SaveToFile(const char * const filePath) const;
+   // maps a file written by SaveToFile read-only, so processes on the same host share one page cache copy of the binned data and skip ingestion.
+   // The file holds our unpacked columns and no targets, since attribute combinations and targets are chosen per training state, so training states
+   // loaded this way still pack their combinations at initialization.  Every attribute and bin is checked here, which reads the whole file once
+   static DataSetShared * LoadFromFile(const char * const filePath);
+
+   TML_INLINE size_t GetCountAttributes() const {
+      return m_cAttributes;
+   }
+   TML_INLINE size_t GetCountCases() const {
+      return m_cCases;
+   }
+   TML_INLINE const EbmAttribute * GetAttributes() const {
+      return m_aAttributes;
+   }
+   TML_INLINE const StorageDataTypeCore * const * GetInputData() const {
+      return m_aaInputData;
+   }
+   TML_INLINE const EbmDataColumn * GetColumns() const {
+      return m_aColumns;
+   }
+};
+
 // TODO: rename this to DataSetByAttribute
 class DataSetInternalCore final {
    const FractionalDataType * const m_aResidualErrors;
    const StorageDataTypeCore * const * const m_aaInputData;
    const size_t m_cCases;
    const size_t m_cAttributes;
+   // if we were constructed from a shared dataset then m_aaInputData belongs to it and we hold a reference instead of freeing m_aaInputData
+   DataSetShared * const m_pDataSetShared;
 
 public:
 
-   DataSetInternalCore(const bool bRegression, const size_t cAttributes, const AttributeInternalCore * const aAttributes, const size_t cCases, const IntegerDataType * const aInputDataFrom, const void * const aTargetData, const FractionalDataType * const aPredictionScores, const size_t cTargetStates);
+   DataSetInternalCore(const bool bRegression, const size_t cAttributes, const AttributeInternalCore * const aAttributes, const size_t cCases, const EbmDataColumn * const aInputDataFrom, const void * const aTargetData, const FractionalDataType * const aPredictionScores, const size_t cTargetStates);
+   // uses the binned data inside pDataSetShared without copying it
+   DataSetInternalCore(const bool bRegression, DataSetShared * const pDataSetShared, const void * const aTargetData, const FractionalDataType * const aPredictionScores, const size_t cTargetStates);
+   // copies the cases listed in aiCases (which must be valid indexes into dataSetFrom) into a new, smaller dataset.  The cases keep the order of aiCases
+   DataSetInternalCore(const DataSetInternalCore & dataSetFrom, const size_t cVectorLength, const size_t cCases, const size_t * const aiCases);
    ~DataSetInternalCore();
 
    TML_INLINE bool IsError() const {
@@ -8,17 +8,338 @@
 #include <string.h> // memset
 #include <stdlib.h> // malloc, realloc, free
 #include <stddef.h> // size_t, ptrdiff_t
+#include <stdint.h> // uint64_t, uintptr_t
+
+#if defined(_WIN32)
+#include <malloc.h> // _aligned_malloc, _aligned_free
+// we don't want to require windows.h in our precompiled header since then it will be needed in linux builds, which doesn't make sense
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else // platform
+#include <sys/mman.h> // mmap, munmap, madvise
+#include <unistd.h> // ftruncate, unlink, close, sysconf
+#include <fcntl.h> // posix_fallocate, fcntl
+#endif // platform
 
 #include "ebmcore.h" // FractionalDataType
 #include "EbmInternal.h" // AttributeTypeCore
 #include "Logging.h" // EBM_ASSERT & LOG
 #include "AttributeInternal.h"
 #include "AttributeCombinationInternal.h"
+#include "DataColumn.h"
 #include "DataSetByAttributeCombination.h"
 
 #define INVALID_POINTER (reinterpret_cast<void *>(~ size_t { 0 }))
 
-TML_INLINE static FractionalDataType * ConstructResidualErrors(const size_t cCases, const size_t cVectorLength) {
+// all of our per-case arrays are carved out of a single arena, which we size before allocating.  Each array starts on a cache line boundary so
+// that no two arrays share a cache line, and so that SIMD loads at the start of each array are aligned
+static constexpr size_t k_cBytesArenaAlignment = 64;
+// on linux we can ask for transparent huge pages on big arenas, which cuts TLB misses when we stream through millions of cases each boosting step
+static constexpr size_t k_cBytesHugePage = size_t { 2 } * 1024 * 1024;
+static constexpr size_t k_cBytesArenaError = ~size_t { 0 };
+
+TML_INLINE static size_t AlignArenaBytes(const size_t cBytes, const size_t cBytesAlignment) {
+   EBM_ASSERT(!IsAddError(cBytes, cBytesAlignment - 1));
+   return (cBytes + cBytesAlignment - 1) & ~(cBytesAlignment - 1);
+}
+
+// adds an array of cItems items of cBytesItem bytes each to our arena plan.  Returns true on overflow
+TML_INLINE static bool PlanArenaArray(size_t * const pcBytesArena, const size_t cBytesItem, const size_t cItems) {
+   if(IsMultiplyError(cBytesItem, cItems)) {
+      return true;
+   }
+   const size_t cBytes = cBytesItem * cItems;
+   if(IsAddError(cBytes, k_cBytesArenaAlignment - 1)) {
+      return true;
+   }
+   const size_t cBytesAligned = AlignArenaBytes(cBytes, k_cBytesArenaAlignment);
+   if(IsAddError(*pcBytesArena, cBytesAligned)) {
+      return true;
+   }
+   *pcBytesArena += cBytesAligned;
+   return false;
+}
+
+size_t DataSetAttributeCombination::GetPlannedCaseArrayBytes(const bool bAllocateResidualErrors, const bool bAllocatePredictionScores, const bool bAllocateTargetData, const size_t cCases, const size_t cTargetStates, const size_t cVectorLength, const bool bSinglePrecision) {
+   EBM_ASSERT(0 < cCases);
+   EBM_ASSERT(0 < cVectorLength);
+
+   if(IsMultiplyError(cCases, cVectorLength)) {
+      LOG(TraceLevelWarning, "WARNING DataSetAttributeCombination::GetPlannedCaseArrayBytes IsMultiplyError(cCases, cVectorLength)");
+      return k_cBytesArenaError;
+   }
+   const size_t cElements = cCases * cVectorLength;
+   const size_t cBytesFloat = bSinglePrecision ? sizeof(float) : sizeof(FractionalDataType);
+
+   size_t cBytesArena = 0;
+   bool bError = bAllocateResidualErrors && PlanArenaArray(&cBytesArena, cBytesFloat, cElements);
+   bError = bError || bAllocatePredictionScores && PlanArenaArray(&cBytesArena, cBytesFloat, cElements);
+   if(bAllocateTargetData) {
+      const size_t cItemsPerUnit = GetCountItemsBitPacked(GetCountBitsPerTarget(cTargetStates));
+      bError = bError || PlanArenaArray(&cBytesArena, sizeof(StorageDataTypeCore), (cCases - 1) / cItemsPerUnit + 1);
+   }
+   if(bError) {
+      LOG(TraceLevelWarning, "WARNING DataSetAttributeCombination::GetPlannedCaseArrayBytes arena size overflows");
+      return k_cBytesArenaError;
+   }
+   return cBytesArena;
+}
+
+size_t DataSetAttributeCombination::GetPlannedInputDataBytes(const size_t cAttributeCombinations, const AttributeCombinationCore * const * const apAttributeCombination, const size_t cCases) {
+   EBM_ASSERT(0 < cCases);
+
+   size_t cBytesArena = 0;
+   if(0 != cAttributeCombinations) {
+      bool bError = PlanArenaArray(&cBytesArena, sizeof(void *), cAttributeCombinations);
+      for(size_t iAttributeCombination = 0; iAttributeCombination < cAttributeCombinations; ++iAttributeCombination) {
+         const AttributeCombinationCore * const pAttributeCombination = apAttributeCombination[iAttributeCombination];
+         if(0 != pAttributeCombination->m_cAttributes) {
+            const size_t cDataUnits = (cCases - 1) / pAttributeCombination->m_cItemsPerBitPackDataUnit + 1; // this can't overflow or underflow
+            bError = bError || PlanArenaArray(&cBytesArena, sizeof(StorageDataTypeCore), cDataUnits);
+         }
+      }
+      if(bError) {
+         LOG(TraceLevelWarning, "WARNING DataSetAttributeCombination::GetPlannedInputDataBytes arena size overflows");
+         return k_cBytesArenaError;
+      }
+   }
+   return cBytesArena;
+}
+
+// this needs to plan exactly the arrays that the Construct* functions below carve, in any order
+static size_t GetArenaBytes(const bool bAllocateResidualErrors, const bool bAllocatePredictionScores, const bool bAllocateTargetData, const size_t cAttributeCombinations, const AttributeCombinationCore * const * const apAttributeCombination, const size_t cCases, const size_t cTargetStates, const size_t cVectorLength, const bool bSinglePrecision) {
+   const size_t cBytesCaseArrays = DataSetAttributeCombination::GetPlannedCaseArrayBytes(bAllocateResidualErrors, bAllocatePredictionScores, bAllocateTargetData, cCases, cTargetStates, cVectorLength, bSinglePrecision);
+   const size_t cBytesInputData = DataSetAttributeCombination::GetPlannedInputDataBytes(cAttributeCombinations, apAttributeCombination, cCases);
+   // k_cBytesArenaError is the maximum size_t, so adding it to anything overflows
+   if(IsAddError(cBytesCaseArrays, cBytesInputData)) {
+      return k_cBytesArenaError;
+   }
+   return cBytesCaseArrays + cBytesInputData;
+}
+
+// creates a temporary file of cBytes bytes that is deleted as soon as we unmap it, and maps it into our address space.  The file goes in the directory named by
+// the TMPDIR environment variable on posix (falling back to /tmp), and in the user's temp directory on Windows.  Returns nullptr on error
+static void * MapArenaFile(const size_t cBytes) {
+#if defined(_WIN32)
+   char directoryPath[MAX_PATH + 1];
+   const DWORD cDirectoryChars = GetTempPathA(sizeof(directoryPath), directoryPath);
+   if(0 == cDirectoryChars || sizeof(directoryPath) <= cDirectoryChars) {
+      LOG(TraceLevelWarning, "WARNING MapArenaFile GetTempPathA failed");
+      return nullptr;
+   }
+   char filePath[MAX_PATH + 1];
+   if(0 == GetTempFileNameA(directoryPath, "ebm", 0, filePath)) {
+      LOG(TraceLevelWarning, "WARNING MapArenaFile GetTempFileNameA failed");
+      return nullptr;
+   }
+   // the file is deleted when the last handle to it closes, which is our view since we close our own handles below
+   const HANDLE hFile = CreateFileA(filePath, GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE, nullptr);
+   if(INVALID_HANDLE_VALUE == hFile) {
+      LOG(TraceLevelWarning, "WARNING MapArenaFile CreateFileA failed");
+      return nullptr;
+   }
+   const uint64_t cBytes64 = static_cast<uint64_t>(cBytes);
+   // extending a file that isn't marked sparse allocates its clusters, so if the disk is full we find out here instead of with an in-page error
+   // when we later write to the view
+   LARGE_INTEGER endOfFile;
+   endOfFile.QuadPart = static_cast<LONGLONG>(cBytes64);
+   if(!SetFilePointerEx(hFile, endOfFile, nullptr, FILE_BEGIN) || !SetEndOfFile(hFile)) {
+      LOG(TraceLevelWarning, "WARNING MapArenaFile SetEndOfFile failed");
+      CloseHandle(hFile);
+      return nullptr;
+   }
+   const HANDLE hMapping = CreateFileMappingA(hFile, nullptr, PAGE_READWRITE, static_cast<DWORD>(cBytes64 >> 32), static_cast<DWORD>(cBytes64), nullptr);
+   CloseHandle(hFile);
+   if(nullptr == hMapping) {
+      LOG(TraceLevelWarning, "WARNING MapArenaFile CreateFileMappingA failed");
+      return nullptr;
+   }
+   void * const pView = MapViewOfFile(hMapping, FILE_MAP_ALL_ACCESS, 0, 0, cBytes);
+   CloseHandle(hMapping);
+   return pView;
+#else // platform
+   const char * directoryPath = getenv("TMPDIR");
+   if(nullptr == directoryPath || '\0' == *directoryPath) {
+      directoryPath = "/tmp";
+   }
+   static constexpr char k_fileTemplate[] = "/ebm-arena-XXXXXX";
+   const size_t cDirectoryChars = strlen(directoryPath);
+   char * const filePath = static_cast<char *>(malloc(cDirectoryChars + sizeof(k_fileTemplate)));
+   if(nullptr == filePath) {
+      LOG(TraceLevelWarning, "WARNING MapArenaFile nullptr == filePath");
+      return nullptr;
+   }
+   memcpy(filePath, directoryPath, cDirectoryChars);
+   memcpy(filePath + cDirectoryChars, k_fileTemplate, sizeof(k_fileTemplate));
+   const int fd = mkstemp(filePath);
+   if(fd < 0) {
+      LOG(TraceLevelWarning, "WARNING MapArenaFile mkstemp failed");
+      free(filePath);
+      return nullptr;
+   }
+   // the mapping keeps the file alive after it has no name and we close our descriptor, so nothing is left behind on disk even if we crash
+   unlink(filePath);
+   free(filePath);
+   // we need the disk blocks reserved up front.  ftruncate alone leaves a sparse file, and if the disk fills while we write to a sparse shared mapping
+   // the kernel has nowhere to put the page and kills us with SIGBUS instead of giving us an error to return
+   if(!IsNumberConvertable<off_t, size_t>(cBytes)) {
+      LOG(TraceLevelWarning, "WARNING MapArenaFile !IsNumberConvertable<off_t, size_t>(cBytes)");
+      close(fd);
+      return nullptr;
+   }
+#if defined(__APPLE__)
+   // macOS doesn't have posix_fallocate.  F_PREALLOCATE reserves the blocks without changing the file size, so we still need ftruncate
+   fstore_t fileStore;
+   fileStore.fst_flags = F_ALLOCATEALL;
+   fileStore.fst_posmode = F_PEOFPOSMODE;
+   fileStore.fst_offset = 0;
+   fileStore.fst_length = static_cast<off_t>(cBytes);
+   fileStore.fst_bytesalloc = 0;
+   const bool bReserved = -1 != fcntl(fd, F_PREALLOCATE, &fileStore) && 0 == ftruncate(fd, static_cast<off_t>(cBytes));
+#else // platform
+   // posix_fallocate returns the error instead of setting errno.  It also sets the file size
+   const bool bReserved = 0 == posix_fallocate(fd, 0, static_cast<off_t>(cBytes));
+#endif // platform
+   if(!bReserved) {
+      LOG(TraceLevelWarning, "WARNING MapArenaFile unable to reserve %zu bytes on disk", cBytes);
+      close(fd);
+      return nullptr;
+   }
+   void * const pMapping = mmap(nullptr, cBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+   close(fd);
+   if(MAP_FAILED == pMapping) {
+      LOG(TraceLevelWarning, "WARNING MapArenaFile mmap failed");
+      return nullptr;
+   }
+   return pMapping;
+#endif // platform
+}
+
+static void * AllocateArena(size_t cBytes, const ArenaBackingCore arenaBacking) {
+   if(k_cBytesArenaError == cBytes) {
+      return nullptr;
+   }
+   if(0 == cBytes) {
+      // we don't want a nullptr to mean success, so always allocate something
+      cBytes = k_cBytesArenaAlignment;
+   }
+   if(ArenaBackingCore::FileCore == arenaBacking) {
+      // mappings start on a page boundary, which is more aligned than we need
+      return MapArenaFile(cBytes);
+   }
+#if defined(_WIN32)
+   return _aligned_malloc(cBytes, k_cBytesArenaAlignment);
+#else // platform
+   size_t cBytesAlignment = k_cBytesArenaAlignment;
+#if defined(__linux__)
+   if(ArenaBackingCore::HugePagesCore == arenaBacking && k_cBytesHugePage <= cBytes && !IsAddError(cBytes, k_cBytesHugePage - 1)) {
+      // the kernel can only back whole aligned huge pages, so align the start and pad the end
+      cBytesAlignment = k_cBytesHugePage;
+      cBytes = AlignArenaBytes(cBytes, k_cBytesHugePage);
+   }
+#endif // platform
+   void * pArena;
+   if(0 != posix_memalign(&pArena, cBytesAlignment, cBytes)) {
+      return nullptr;
+   }
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+   if(k_cBytesHugePage == cBytesAlignment) {
+      // this is only a hint.  If transparent huge pages are disabled we still have a perfectly good arena made of normal pages
+      madvise(pArena, cBytes, MADV_HUGEPAGE);
+   }
+#endif // platform
+   return pArena;
+#endif // platform
+}
+
+// cBytes and arenaBacking need to be what we passed to AllocateArena
+static void FreeArena(void * const pArena, const size_t cBytes, const ArenaBackingCore arenaBacking) {
+   if(ArenaBackingCore::FileCore == arenaBacking) {
+      if(nullptr != pArena) {
+#if defined(_WIN32)
+         UNUSED(cBytes);
+         UnmapViewOfFile(pArena);
+#else // platform
+         munmap(pArena, 0 == cBytes ? k_cBytesArenaAlignment : cBytes);
+#endif // platform
+      }
+      return;
+   }
+   UNUSED(cBytes);
+#if defined(_WIN32)
+   _aligned_free(pArena);
+#else // platform
+   free(pArena);
+#endif // platform
+}
+
+// hints that the bytes [pStart, pStart + cBytes) of a file backed arena will be needed soon.  The OS starts reading them in the background
+static void ReadAheadBytes(const void * const pStart, const size_t cBytes) {
+   if(0 == cBytes) {
+      return;
+   }
+#if defined(_WIN32)
+#if defined(_WIN32_WINNT) && 0x0602 <= _WIN32_WINNT
+   WIN32_MEMORY_RANGE_ENTRY range;
+   range.VirtualAddress = const_cast<void *>(pStart);
+   range.NumberOfBytes = cBytes;
+   PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#else // _WIN32_WINNT
+   // PrefetchVirtualMemory needs Windows 8, so older targets rely on the demand paging of the mapping
+   UNUSED(pStart);
+   UNUSED(cBytes);
+#endif // _WIN32_WINNT
+#else // platform
+   // madvise needs a page aligned start.  Our arena starts on a page boundary, so rounding down stays inside our mapping
+   static const size_t s_cBytesPage = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+   const uintptr_t iStart = reinterpret_cast<uintptr_t>(pStart);
+   const uintptr_t iStartPage = iStart / s_cBytesPage * s_cBytesPage;
+   madvise(reinterpret_cast<void *>(iStartPage), cBytes + static_cast<size_t>(iStart - iStartPage), MADV_WILLNEED);
+#endif // platform
+}
+
+// hands out consecutive cache line aligned pieces of an arena.  It only lives until our constructor finishes, after which the arena belongs to
+// the dataset.  If the arena couldn't be allocated then every Carve returns nullptr, which our IsError check picks up
+class ArenaCarver final {
+   unsigned char * const m_pArena;
+   unsigned char * m_pNext;
+   const size_t m_cBytes;
+   const ArenaBackingCore m_arenaBacking;
+
+public:
+   ArenaCarver(const size_t cBytes, const ArenaBackingCore arenaBacking)
+      : m_pArena(static_cast<unsigned char *>(AllocateArena(cBytes, arenaBacking)))
+      , m_pNext(m_pArena)
+      , m_cBytes(cBytes)
+      , m_arenaBacking(arenaBacking) {
+   }
+
+   TML_INLINE void * GetArena() const {
+      return m_pArena;
+   }
+
+   TML_INLINE size_t GetCountBytes() const {
+      return m_cBytes;
+   }
+
+   TML_INLINE ArenaBackingCore GetArenaBacking() const {
+      return m_arenaBacking;
+   }
+
+   TML_INLINE void * Carve(const size_t cBytes) {
+      if(nullptr == m_pArena) {
+         return nullptr;
+      }
+      void * const pCarved = m_pNext;
+      m_pNext += AlignArenaBytes(cBytes, k_cBytesArenaAlignment);
+      EBM_ASSERT(static_cast<size_t>(m_pNext - m_pArena) <= m_cBytes); // GetArenaBytes must have planned for every array that we carve
+      return pCarved;
+   }
+};
+
+template<typename TFloat>
+TML_INLINE static void * ConstructResidualErrors(ArenaCarver & carver, const size_t cCases, const size_t cVectorLength) {
    LOG(TraceLevelInfo, "Entered DataSetAttributeCombination::ConstructResidualErrors");
 
    EBM_ASSERT(1 <= cCases);
@@ -31,19 +352,20 @@ TML_INLINE static FractionalDataType * ConstructResidualErrors(const size_t cCas
 
    const size_t cElements = cCases * cVectorLength;
 
-   if(IsMultiplyError(sizeof(FractionalDataType), cElements)) {
-      LOG(TraceLevelWarning, "WARNING DataSetAttributeCombination::ConstructResidualErrors IsMultiplyError(sizeof(FractionalDataType), cElements)");
+   if(IsMultiplyError(sizeof(TFloat), cElements)) {
+      LOG(TraceLevelWarning, "WARNING DataSetAttributeCombination::ConstructResidualErrors IsMultiplyError(sizeof(TFloat), cElements)");
       return nullptr;
    }
 
-   const size_t cBytes = sizeof(FractionalDataType) * cElements;
-   FractionalDataType * aResidualErrors = static_cast<FractionalDataType *>(malloc(cBytes));
+   const size_t cBytes = sizeof(TFloat) * cElements;
+   TFloat * aResidualErrors = static_cast<TFloat *>(carver.Carve(cBytes));
 
    LOG(TraceLevelInfo, "Exited DataSetAttributeCombination::ConstructResidualErrors");
    return aResidualErrors;
 }
 
-TML_INLINE static FractionalDataType * ConstructPredictionScores(const size_t cCases, const size_t cVectorLength, const FractionalDataType * const aPredictionScoresFrom) {
+template<typename TFloat>
+TML_INLINE static void * ConstructPredictionScores(ArenaCarver & carver, const size_t cCases, const size_t cVectorLength, const FractionalDataType * const aPredictionScoresFrom) {
    LOG(TraceLevelInfo, "Entered DataSetAttributeCombination::ConstructPredictionScores");
 
    EBM_ASSERT(0 < cCases);
@@ -56,13 +378,13 @@ TML_INLINE static FractionalDataType * ConstructPredictionScores(const size_t cC
 
    const size_t cElements = cCases * cVectorLength;
 
-   if(IsMultiplyError(sizeof(FractionalDataType), cElements)) {
-      LOG(TraceLevelWarning, "WARNING DataSetAttributeCombination::ConstructPredictionScores IsMultiplyError(sizeof(FractionalDataType), cElements)");
+   if(IsMultiplyError(sizeof(TFloat), cElements)) {
+      LOG(TraceLevelWarning, "WARNING DataSetAttributeCombination::ConstructPredictionScores IsMultiplyError(sizeof(TFloat), cElements)");
       return nullptr;
    }
 
-   const size_t cBytes = sizeof(FractionalDataType) * cElements;
-   FractionalDataType * const aPredictionScoresTo = static_cast<FractionalDataType *>(malloc(cBytes));
+   const size_t cBytes = sizeof(TFloat) * cElements;
+   TFloat * const aPredictionScoresTo = static_cast<TFloat *>(carver.Carve(cBytes));
    if(nullptr == aPredictionScoresTo) {
       LOG(TraceLevelWarning, "WARNING DataSetAttributeCombination::ConstructPredictionScores nullptr == aPredictionScoresTo");
       return nullptr;
@@ -71,39 +393,42 @@ TML_INLINE static FractionalDataType * ConstructPredictionScores(const size_t cC
    if(nullptr == aPredictionScoresFrom) {
       memset(aPredictionScoresTo, 0, cBytes);
    } else {
-      memcpy(aPredictionScoresTo, aPredictionScoresFrom, cBytes);
+      // we convert to TFloat and subtract the zeroed logit in the same pass, so that single precision storage never holds the unshifted scores
       constexpr bool bZeroingLogits = 0 <= k_iZeroClassificationLogitAtInitialize;
-      if(bZeroingLogits) {
-         // TODO : integrate this subtraction into the copy instead of doing it afterwards
-         FractionalDataType * pScore = aPredictionScoresTo;
-         const FractionalDataType * const pScoreExteriorEnd = pScore + cVectorLength * cCases;
+      const FractionalDataType * pScoreFrom = aPredictionScoresFrom;
+      TFloat * pScoreTo = aPredictionScoresTo;
+      const TFloat * const pScoreToExteriorEnd = pScoreTo + cElements;
+      do {
+         const FractionalDataType scoreShift = bZeroingLogits ? pScoreFrom[k_iZeroClassificationLogitAtInitialize] : FractionalDataType { 0 };
+         const TFloat * const pScoreToInteriorEnd = pScoreTo + cVectorLength;
          do {
-            FractionalDataType scoreShift = pScore[k_iZeroClassificationLogitAtInitialize];
-            const FractionalDataType * const pScoreInteriorEnd = pScore + cVectorLength;
-            do {
-               *pScore -= scoreShift;
-               ++pScore;
-            } while(pScoreInteriorEnd != pScore);
-         } while(pScoreExteriorEnd != pScore);
-      }
+            *pScoreTo = static_cast<TFloat>(*pScoreFrom - scoreShift);
+            ++pScoreFrom;
+            ++pScoreTo;
+         } while(pScoreToInteriorEnd != pScoreTo);
+      } while(pScoreToExteriorEnd != pScoreTo);
    }
 
    LOG(TraceLevelInfo, "Exited DataSetAttributeCombination::ConstructPredictionScores");
    return aPredictionScoresTo;
 }
 
-TML_INLINE static const StorageDataTypeCore * ConstructTargetData(const size_t cCases, const IntegerDataType * const aTargets) {
+TML_INLINE static const StorageDataTypeCore * ConstructTargetData(ArenaCarver & carver, const size_t cCases, const IntegerDataType * const aTargets, const size_t cTargetBitsPerItem) {
    LOG(TraceLevelInfo, "Entered DataSetAttributeCombination::ConstructTargetData");
 
    EBM_ASSERT(0 < cCases);
    EBM_ASSERT(nullptr != aTargets);
+   EBM_ASSERT(1 <= cTargetBitsPerItem);
+   EBM_ASSERT(cTargetBitsPerItem <= k_cBitsForStorageType);
 
-   if(IsMultiplyError(sizeof(StorageDataTypeCore), cCases)) {
+   const size_t cItemsPerUnit = GetCountItemsBitPacked(cTargetBitsPerItem);
+   const size_t cUnits = (cCases - 1) / cItemsPerUnit + 1; // this can't overflow or underflow
+   if(IsMultiplyError(sizeof(StorageDataTypeCore), cUnits)) {
       LOG(TraceLevelWarning, "WARNING DataSetAttributeCombination::ConstructTargetData");
       return nullptr;
    }
-   const size_t cTargetArrayBytes = sizeof(StorageDataTypeCore) * cCases;
-   StorageDataTypeCore * const aTargetData = static_cast<StorageDataTypeCore *>(malloc(cTargetArrayBytes));
+   const size_t cTargetArrayBytes = sizeof(StorageDataTypeCore) * cUnits;
+   StorageDataTypeCore * const aTargetData = static_cast<StorageDataTypeCore *>(carver.Carve(cTargetArrayBytes));
    if(nullptr == aTargetData) {
       LOG(TraceLevelWarning, "WARNING nullptr == aTargetData");
       return nullptr;
@@ -113,25 +438,37 @@ TML_INLINE static const StorageDataTypeCore * ConstructTargetData(const size_t c
    const IntegerDataType * const pTargetFromEnd = aTargets + cCases;
    StorageDataTypeCore * pTargetTo = aTargetData;
    do {
-      const IntegerDataType data = *pTargetFrom;
-      EBM_ASSERT(0 <= data);
-      EBM_ASSERT((IsNumberConvertable<StorageDataTypeCore, IntegerDataType>(data)));
-      // we can't check the upper range of our target here since we don't have that information, so we have a function at the allocation entry point that checks it there.  See CheckTargets(..)
-      *pTargetTo = static_cast<StorageDataTypeCore>(data);
+      // the last unit can be partially filled, and we leave its unused high bits as zero
+      StorageDataTypeCore bits = 0;
+      size_t shift = 0;
+      size_t cItemsRemaining = cItemsPerUnit;
+      do {
+         const IntegerDataType data = *pTargetFrom;
+         EBM_ASSERT(0 <= data);
+         EBM_ASSERT((IsNumberConvertable<StorageDataTypeCore, IntegerDataType>(data)));
+         // we can't check the upper range of our target here since we don't have that information, so we have a function at the allocation entry point that checks it there.  See CheckTargets(..)
+         EBM_ASSERT(cTargetBitsPerItem == k_cBitsForStorageType || static_cast<StorageDataTypeCore>(data) >> cTargetBitsPerItem == 0);
+         // shift is always less than k_cBitsForStorageType since we only have cItemsPerUnit items
+         bits |= static_cast<StorageDataTypeCore>(data) << shift;
+         shift += cTargetBitsPerItem;
+         ++pTargetFrom;
+         --cItemsRemaining;
+      } while(0 != cItemsRemaining && pTargetFromEnd != pTargetFrom);
+      *pTargetTo = bits;
       ++pTargetTo;
-      ++pTargetFrom;
    } while(pTargetFromEnd != pTargetFrom);
+   EBM_ASSERT(aTargetData + cUnits == pTargetTo);
 
    LOG(TraceLevelInfo, "Exited DataSetAttributeCombination::ConstructTargetData");
    return aTargetData;
 }
 
 struct InputDataPointerAndCountStates {
-   const IntegerDataType * m_pInputData;
+   DataColumnReader m_column;
    size_t m_cStates;
 };
 
-TML_INLINE static const StorageDataTypeCore * const * ConstructInputData(const size_t cAttributeCombinations, const AttributeCombinationCore * const * const apAttributeCombination, const size_t cCases, const IntegerDataType * const aInputDataFrom) {
+TML_INLINE static const StorageDataTypeCore * const * ConstructInputData(ArenaCarver & carver, const size_t cAttributeCombinations, const AttributeCombinationCore * const * const apAttributeCombination, const size_t cCases, const EbmDataColumn * const aInputDataFrom) {
    LOG(TraceLevelInfo, "Entered DataSetAttributeCombination::ConstructInputData");
 
    EBM_ASSERT(0 < cAttributeCombinations);
@@ -144,7 +481,7 @@ TML_INLINE static const StorageDataTypeCore * const * ConstructInputData(const s
       return nullptr;
    }
    const size_t cBytesMemoryArray = sizeof(void *) * cAttributeCombinations;
-   StorageDataTypeCore ** const aaInputDataTo = static_cast<StorageDataTypeCore * *>(malloc(cBytesMemoryArray));
+   StorageDataTypeCore ** const aaInputDataTo = static_cast<StorageDataTypeCore * *>(carver.Carve(cBytesMemoryArray));
    if(nullptr == aaInputDataTo) {
       LOG(TraceLevelWarning, "WARNING DataSetAttributeCombination::ConstructInputData nullptr == aaInputDataTo");
       return nullptr;
@@ -158,7 +495,7 @@ TML_INLINE static const StorageDataTypeCore * const * ConstructInputData(const s
       EBM_ASSERT(nullptr != pAttributeCombination);
       const size_t cAttributes = pAttributeCombination->m_cAttributes;
       if(0 == cAttributes) {
-         *paInputDataTo = nullptr; // free will skip over these later
+         *paInputDataTo = nullptr;
       } else {
          const size_t cItemsPerBitPackDataUnit = pAttributeCombination->m_cItemsPerBitPackDataUnit;
          EBM_ASSERT(cItemsPerBitPackDataUnit <= CountBitsRequiredPositiveMax<StorageDataTypeCore>()); // for a 32/64 bit storage item, we can't have more than 32/64 bit packed items stored
@@ -170,14 +507,12 @@ TML_INLINE static const StorageDataTypeCore * const * ConstructInputData(const s
 
          if(IsMultiplyError(sizeof(StorageDataTypeCore), cDataUnits)) {
             LOG(TraceLevelWarning, "WARNING DataSetAttributeCombination::ConstructInputData IsMultiplyError(sizeof(StorageDataTypeCore), cDataUnits)");
-            goto free_all;
+            return nullptr;
          }
          const size_t cBytesData = sizeof(StorageDataTypeCore) * cDataUnits;
-         StorageDataTypeCore * pInputDataTo = static_cast<StorageDataTypeCore *>(malloc(cBytesData));
-         if(nullptr == pInputDataTo) {
-            LOG(TraceLevelWarning, "WARNING DataSetAttributeCombination::ConstructInputData nullptr == pInputDataTo");
-            goto free_all;
-         }
+         // the pointer array came out of the same arena, so if it succeeded then this can't fail
+         StorageDataTypeCore * pInputDataTo = static_cast<StorageDataTypeCore *>(carver.Carve(cBytesData));
+         EBM_ASSERT(nullptr != pInputDataTo);
          *paInputDataTo = pInputDataTo;
 
          // stop on the last item in our array AND then do one special last loop with less or equal iterations to the normal loop
@@ -193,7 +528,7 @@ TML_INLINE static const StorageDataTypeCore * const * ConstructInputData(const s
          const InputDataPointerAndCountStates * const pDimensionInfoEnd = &dimensionInfo[cAttributes];
          do {
             const AttributeInternalCore * const pAttribute = pAttributeCombinationEntry->m_pAttribute;
-            pDimensionInfo->m_pInputData = &aInputDataFrom[pAttribute->m_iAttributeData * cCases];
+            pDimensionInfo->m_column.Initialize(&aInputDataFrom[pAttribute->m_iAttributeData]);
             pDimensionInfo->m_cStates = pAttribute->m_cStates;
             ++pAttributeCombinationEntry;
             ++pDimensionInfo;
@@ -216,9 +551,7 @@ TML_INLINE static const StorageDataTypeCore * const * ConstructInputData(const s
                size_t tensorIndex = 0;
                pDimensionInfo = &dimensionInfo[0];
                do {
-                  const IntegerDataType * pInputData = pDimensionInfo->m_pInputData;
-                  const IntegerDataType inputData = *pInputData;
-                  pDimensionInfo->m_pInputData = pInputData + 1;
+                  const IntegerDataType inputData = pDimensionInfo->m_column.Next();
 
                   EBM_ASSERT(0 <= inputData);
                   EBM_ASSERT((IsNumberConvertable<size_t, IntegerDataType>(inputData))); // data must be lower than cTargetStates and cTargetStates fits into a size_t which we checked earlier
@@ -255,23 +588,27 @@ TML_INLINE static const StorageDataTypeCore * const * ConstructInputData(const s
 
    LOG(TraceLevelInfo, "Exited DataSetAttributeCombination::ConstructInputData");
    return aaInputDataTo;
+}
 
-free_all:
-   while(aaInputDataTo != paInputDataTo) {
-      --paInputDataTo;
-      free(*paInputDataTo);
-   }
-   free(aaInputDataTo);
-   return nullptr;
+DataSetAttributeCombination::DataSetAttributeCombination(const bool bAllocateResidualErrors, const bool bAllocatePredictionScores, const bool bAllocateTargetData, const size_t cAttributeCombinations, const AttributeCombinationCore * const * const apAttributeCombination, const size_t cCases, const EbmDataColumn * const aInputDataFrom, const void * const aTargets, const size_t cTargetStates, const FractionalDataType * const aPredictionScoresFrom, const size_t cVectorLength, const bool bSinglePrecision, const ArenaBackingCore arenaBacking)
+   : DataSetAttributeCombination(bAllocateResidualErrors, bAllocatePredictionScores, bAllocateTargetData, cAttributeCombinations, apAttributeCombination, cCases, aInputDataFrom, aTargets, cTargetStates, aPredictionScoresFrom, cVectorLength, bSinglePrecision, ArenaCarver(GetArenaBytes(bAllocateResidualErrors, bAllocatePredictionScores, bAllocateTargetData, cAttributeCombinations, apAttributeCombination, cCases, cTargetStates, cVectorLength, bSinglePrecision), arenaBacking)) {
 }
 
-DataSetAttributeCombination::DataSetAttributeCombination(const bool bAllocateResidualErrors, const bool bAllocatePredictionScores, const bool bAllocateTargetData, const size_t cAttributeCombinations, const AttributeCombinationCore * const * const apAttributeCombination, const size_t cCases, const IntegerDataType * const aInputDataFrom, const void * const aTargets, const FractionalDataType * const aPredictionScoresFrom, const size_t cVectorLength)
-   : m_aResidualErrors(bAllocateResidualErrors ? ConstructResidualErrors(cCases, cVectorLength) : static_cast<FractionalDataType *>(INVALID_POINTER))
-   , m_aPredictionScores(bAllocatePredictionScores ? ConstructPredictionScores(cCases, cVectorLength, aPredictionScoresFrom) : static_cast<FractionalDataType *>(INVALID_POINTER))
-   , m_aTargetData(bAllocateTargetData ? ConstructTargetData(cCases, static_cast<const IntegerDataType *>(aTargets)) : static_cast<const StorageDataTypeCore *>(INVALID_POINTER))
-   , m_aaInputData(0 == cAttributeCombinations ? nullptr : ConstructInputData(cAttributeCombinations, apAttributeCombination, cCases, aInputDataFrom))
+// the carver temporary lives until our delegating constructor above finishes, so all our members can stay const and be carved in our initialization list
+DataSetAttributeCombination::DataSetAttributeCombination(const bool bAllocateResidualErrors, const bool bAllocatePredictionScores, const bool bAllocateTargetData, const size_t cAttributeCombinations, const AttributeCombinationCore * const * const apAttributeCombination, const size_t cCases, const EbmDataColumn * const aInputDataFrom, const void * const aTargets, const size_t cTargetStates, const FractionalDataType * const aPredictionScoresFrom, const size_t cVectorLength, const bool bSinglePrecision, ArenaCarver && carver)
+   : m_pArena(carver.GetArena())
+   , m_aResidualErrors(bAllocateResidualErrors ? (bSinglePrecision ? ConstructResidualErrors<float>(carver, cCases, cVectorLength) : ConstructResidualErrors<FractionalDataType>(carver, cCases, cVectorLength)) : INVALID_POINTER)
+   , m_aPredictionScores(bAllocatePredictionScores ? (bSinglePrecision ? ConstructPredictionScores<float>(carver, cCases, cVectorLength, aPredictionScoresFrom) : ConstructPredictionScores<FractionalDataType>(carver, cCases, cVectorLength, aPredictionScoresFrom)) : INVALID_POINTER)
+   , m_aTargetData(bAllocateTargetData ? ConstructTargetData(carver, cCases, static_cast<const IntegerDataType *>(aTargets), GetCountBitsPerTarget(cTargetStates)) : static_cast<const StorageDataTypeCore *>(INVALID_POINTER))
+   , m_aaInputData(0 == cAttributeCombinations ? nullptr : ConstructInputData(carver, cAttributeCombinations, apAttributeCombination, cCases, aInputDataFrom))
    , m_cCases(cCases)
-   , m_cAttributeCombinations(cAttributeCombinations) {
+   , m_cAttributeCombinations(cAttributeCombinations)
+   , m_bSinglePrecision(bSinglePrecision)
+   , m_cTargetBitsPerItem(GetCountBitsPerTarget(cTargetStates))
+   , m_cVectorLength(cVectorLength)
+   , m_arenaBacking(carver.GetArenaBacking())
+   , m_cBytesArena(nullptr == carver.GetArena() ? size_t { 0 } : carver.GetCountBytes())
+   , m_cBytesInputData(nullptr == carver.GetArena() ? size_t { 0 } : GetPlannedInputDataBytes(cAttributeCombinations, apAttributeCombination, cCases)) {
 
    EBM_ASSERT(0 < cCases);
 }
@@ -279,25 +616,35 @@ DataSetAttributeCombination::DataSetAttributeCombination(const bool bAllocateRes
 DataSetAttributeCombination::~DataSetAttributeCombination() {
    LOG(TraceLevelInfo, "Entered ~DataSetAttributeCombination");
 
+   // every array we hold was carved out of our arena, so there is nothing else to free
+   FreeArena(m_pArena, m_cBytesArena, m_arenaBacking);
+
+   LOG(TraceLevelInfo, "Exited ~DataSetAttributeCombination");
+}
+
+void DataSetAttributeCombination::ReadAhead(const AttributeCombinationCore * const pAttributeCombination, const size_t iCaseStart, const size_t cCases) const {
+   EBM_ASSERT(iCaseStart + cCases <= m_cCases);
+   if(!IsOutOfCore() || 0 == cCases) {
+      return;
+   }
+   // all of these were carved from our arena when we were constructed, so none of these byte counts can overflow
+   const size_t cBytesFloat = m_bSinglePrecision ? sizeof(float) : sizeof(FractionalDataType);
+   const size_t cBytesPerCase = cBytesFloat * m_cVectorLength;
    if(INVALID_POINTER != m_aResidualErrors) {
-      free(m_aResidualErrors);
+      ReadAheadBytes(static_cast<const char *>(m_aResidualErrors) + cBytesPerCase * iCaseStart, cBytesPerCase * cCases);
    }
    if(INVALID_POINTER != m_aPredictionScores) {
-      free(m_aPredictionScores);
+      ReadAheadBytes(static_cast<const char *>(m_aPredictionScores) + cBytesPerCase * iCaseStart, cBytesPerCase * cCases);
    }
-   if(INVALID_POINTER != m_aTargetData) {
-      free(const_cast<StorageDataTypeCore *>(m_aTargetData));
+   const size_t iCaseLast = iCaseStart + cCases - 1;
+   if(static_cast<const StorageDataTypeCore *>(INVALID_POINTER) != m_aTargetData) {
+      const size_t cItemsPerUnit = GetCountItemsBitPacked(m_cTargetBitsPerItem);
+      const size_t iUnitStart = iCaseStart / cItemsPerUnit;
+      ReadAheadBytes(m_aTargetData + iUnitStart, sizeof(StorageDataTypeCore) * (iCaseLast / cItemsPerUnit + 1 - iUnitStart));
    }
-   if(nullptr != m_aaInputData) {
-      EBM_ASSERT(0 < m_cAttributeCombinations);
-      const StorageDataTypeCore * const * paInputData = m_aaInputData;
-      const StorageDataTypeCore * const * const paInputDataEnd = m_aaInputData + m_cAttributeCombinations;
-      do {
-         free(const_cast<StorageDataTypeCore *>(*paInputData));
-         ++paInputData;
-      } while(paInputDataEnd != paInputData);
-      free(const_cast<StorageDataTypeCore **>(m_aaInputData));
+   if(nullptr != pAttributeCombination && 0 != pAttributeCombination->m_cAttributes) {
+      const size_t cItemsPerBitPackDataUnit = pAttributeCombination->m_cItemsPerBitPackDataUnit;
+      const size_t iUnitStart = iCaseStart / cItemsPerBitPackDataUnit;
+      ReadAheadBytes(GetDataPointer(pAttributeCombination) + iUnitStart, sizeof(StorageDataTypeCore) * (iCaseLast / cItemsPerBitPackDataUnit + 1 - iUnitStart));
    }
-
-   LOG(TraceLevelInfo, "Exited ~DataSetAttributeCombination");
 }
@@ -8,51 +8,156 @@
 #include <assert.h>
 #include <stdlib.h> // malloc, realloc, free
 #include <stddef.h> // size_t, ptrdiff_t
+#include <stdint.h> // int64_t
+#include <type_traits> // std::is_same
+#include <limits> // numeric_limits
 
 #include "ebmcore.h" // FractionalDataType
 #include "EbmInternal.h" // TML_INLINE
 #include "Logging.h" // EBM_ASSERT & LOG
 #include "AttributeCombinationInternal.h"
 
+// classification targets are bit packed into StorageDataTypeCore units with this many bits per target, with the first case in the least significant bits.  We only
+// use power of two widths so that every unit is completely filled and so that the training and validation loops can be templated on the width.  A binary
+// target takes 1 bit per case instead of a full StorageDataTypeCore
+TML_INLINE size_t GetCountBitsPerTarget(const size_t cTargetStates) {
+   if(cTargetStates <= size_t { 1 } << 1) {
+      return 1;
+   } else if(cTargetStates <= size_t { 1 } << 2) {
+      return 2;
+   } else if(cTargetStates <= size_t { 1 } << 4) {
+      return 4;
+   } else if(cTargetStates <= size_t { 1 } << 8) {
+      return 8;
+   } else if(cTargetStates <= size_t { 1 } << 16) {
+      return 16;
+   } else if(static_cast<uint64_t>(cTargetStates) <= uint64_t { 1 } << 32) {
+      // if this is a 32 bit system, then cTargetStates can't be 0x100000000 or above, because we would have checked that when converting the 64 bit numbers into size_t, and cTargetStates will be promoted to a 64 bit number for the above comparison
+      // if this is a 64 bit system, then this comparison is fine
+      return 32;
+   } else {
+      // our interface doesn't allow more than 64 bits, so even if size_t was bigger then we don't need to examine higher
+      static_assert(63 == CountBitsRequiredPositiveMax<IntegerDataType>(), "");
+      return 64;
+   }
+}
+
+// carves our arrays out of a single allocation.  Only used while constructing, and defined in DataSetByAttributeCombination.cpp
+class ArenaCarver;
+
+// where the arena of a DataSetAttributeCombination lives.  FileCore puts it in a temporary file that we map into memory, which lets us train on datasets that
+// are larger than RAM.  The OS pages blocks of the file in and out as we stream through them, and our histograms and models stay in normal memory
+enum class ArenaBackingCore { MemoryCore = 0, HugePagesCore = 1, FileCore = 2 };
+
+// out of core datasets are streamed through in blocks of this many cases (rounded down to a bit pack boundary).  Before we process each block we ask the OS to
+// start reading the next one, so the disk is busy while we compute.  In memory datasets are processed as a single block
+constexpr size_t k_cCasesPerStreamBlock = 65536;
+
 // TODO: let's take how clean this class is (with almost everything const and the arrays constructed in initialization list) and apply it to as many other classes as we can
 // TODO: rename this to DataSetByAttributeCombination
+//
+// the residuals and prediction scores are stored either as FractionalDataType or as float depending on bSinglePrecision.  They are the only per-case
+// floating point arrays that we stream through on every boosting step, so storing them as float halves our memory bandwidth.  All the sums that we
+// build from them (PredictionStatistics, the validation metric, etc) are still accumulated in FractionalDataType
+//
+// all of our arrays (residuals, prediction scores, packed targets and every packed attribute combination column) are sized up front and carved out of
+// a single 64 byte aligned arena, which can be backed by transparent huge pages on linux, or by a temporary file for out of core training.  This means one
+// allocation and one free per dataset
 class DataSetAttributeCombination final {
-   FractionalDataType * const m_aResidualErrors;
-   FractionalDataType * const m_aPredictionScores;
+   // m_pArena needs to be our first member since it's initialized before any of the arrays that are carved out of it
+   void * const m_pArena;
+   void * const m_aResidualErrors;
+   void * const m_aPredictionScores;
    const StorageDataTypeCore * const m_aTargetData;
    const StorageDataTypeCore * const * const m_aaInputData;
    const size_t m_cCases;
    const size_t m_cAttributeCombinations;
+   const bool m_bSinglePrecision;
+   const size_t m_cTargetBitsPerItem;
+   const size_t m_cVectorLength;
+   const ArenaBackingCore m_arenaBacking;
+   // the size of our arena, and how much of it holds the packed attribute combination columns (the rest holds the per-case arrays)
+   const size_t m_cBytesArena;
+   const size_t m_cBytesInputData;
+
+   DataSetAttributeCombination(const bool bAllocateResidualErrors, const bool bAllocatePredictionScores, const bool bAllocateTargetData, const size_t cAttributeCombinations, const AttributeCombinationCore * const * const apAttributeCombination, const size_t cCases, const EbmDataColumn * const aInputDataFrom, const void * const aTargets, const size_t cTargetStates, const FractionalDataType * const aPredictionScoresFrom, const size_t cVectorLength, const bool bSinglePrecision, ArenaCarver && carver);
 
 public:
 
-   DataSetAttributeCombination(const bool bAllocateResidualErrors, const bool bAllocatePredictionScores, const bool bAllocateTargetData, const size_t cAttributeCombinations, const AttributeCombinationCore * const * const apAttributeCombination, const size_t cCases, const IntegerDataType * const aInputDataFrom, const void * const aTargets, const FractionalDataType * const aPredictionScoresFrom, const size_t cVectorLength);
+   DataSetAttributeCombination(const bool bAllocateResidualErrors, const bool bAllocatePredictionScores, const bool bAllocateTargetData, const size_t cAttributeCombinations, const AttributeCombinationCore * const * const apAttributeCombination, const size_t cCases, const EbmDataColumn * const aInputDataFrom, const void * const aTargets, const size_t cTargetStates, const FractionalDataType * const aPredictionScoresFrom, const size_t cVectorLength, const bool bSinglePrecision, const ArenaBackingCore arenaBacking);
    ~DataSetAttributeCombination();
 
+   // the bytes that a dataset built with the same arguments will carve out of its arena for the residuals, prediction scores and targets, and for the packed
+   // attribute combination columns.  These only need the attribute combinations, so we can use them to estimate our memory before we have any data.
+   // Both return the maximum size_t on overflow
+   static size_t GetPlannedCaseArrayBytes(const bool bAllocateResidualErrors, const bool bAllocatePredictionScores, const bool bAllocateTargetData, const size_t cCases, const size_t cTargetStates, const size_t cVectorLength, const bool bSinglePrecision);
+   static size_t GetPlannedInputDataBytes(const size_t cAttributeCombinations, const AttributeCombinationCore * const * const apAttributeCombination, const size_t cCases);
+
+   TML_INLINE size_t GetInputDataBytes() const {
+      return m_cBytesInputData;
+   }
+   TML_INLINE size_t GetCaseArrayBytes() const {
+      return m_cBytesArena - m_cBytesInputData;
+   }
+
    TML_INLINE bool IsError() const {
-      return nullptr == m_aResidualErrors || nullptr == m_aPredictionScores || nullptr == m_aTargetData || 0 != m_cAttributeCombinations && nullptr == m_aaInputData;
+      return nullptr == m_pArena || nullptr == m_aResidualErrors || nullptr == m_aPredictionScores || nullptr == m_aTargetData || 0 != m_cAttributeCombinations && nullptr == m_aaInputData;
    }
 
-   TML_INLINE FractionalDataType * GetResidualPointer() {
+   TML_INLINE bool IsSinglePrecision() const {
+      return m_bSinglePrecision;
+   }
+
+   TML_INLINE bool IsOutOfCore() const {
+      return ArenaBackingCore::FileCore == m_arenaBacking;
+   }
+   // the number of cases that passes over pAttributeCombination should process between read ahead requests.  This is a multiple of the bit packing
+   // of pAttributeCombination, so every block except the last one of a range ends on a bit pack boundary
+   TML_INLINE size_t GetCountCasesPerStreamBlock(const AttributeCombinationCore * const pAttributeCombination) const {
+      if(!IsOutOfCore()) {
+         return m_cCases;
+      }
+      const size_t cItemsPerBitPackDataUnit = pAttributeCombination->m_cItemsPerBitPackDataUnit;
+      EBM_ASSERT(cItemsPerBitPackDataUnit <= k_cCasesPerStreamBlock);
+      return k_cCasesPerStreamBlock / cItemsPerBitPackDataUnit * cItemsPerBitPackDataUnit;
+   }
+   // asks the OS to start reading the per-case arrays and the packed column of pAttributeCombination for [iCaseStart, iCaseStart + cCases) into memory, and
+   // returns without waiting for them.  This does nothing for in memory datasets, and iCaseStart can be anywhere, including at the end of our cases
+   void ReadAhead(const AttributeCombinationCore * const pAttributeCombination, const size_t iCaseStart, const size_t cCases) const;
+   // TFloat needs to be float if IsSinglePrecision() is true, and FractionalDataType otherwise.  Our callers branch once on IsSinglePrecision() outside
+   // of their loops and then call templated code that works with the correct type
+   template<typename TFloat>
+   TML_INLINE TFloat * GetResidualPointer() {
       EBM_ASSERT(nullptr != m_aResidualErrors);
-      return m_aResidualErrors;
+      EBM_ASSERT((std::is_same<TFloat, float>::value == m_bSinglePrecision));
+      return static_cast<TFloat *>(m_aResidualErrors);
    }
-   TML_INLINE const FractionalDataType * GetResidualPointer() const {
+   template<typename TFloat>
+   TML_INLINE const TFloat * GetResidualPointer() const {
       EBM_ASSERT(nullptr != m_aResidualErrors);
-      return m_aResidualErrors;
+      EBM_ASSERT((std::is_same<TFloat, float>::value == m_bSinglePrecision));
+      return static_cast<const TFloat *>(m_aResidualErrors);
    }
-   TML_INLINE FractionalDataType * GetPredictionScores() {
+   template<typename TFloat>
+   TML_INLINE TFloat * GetPredictionScores() {
       EBM_ASSERT(nullptr != m_aPredictionScores);
-      return m_aPredictionScores;
+      EBM_ASSERT((std::is_same<TFloat, float>::value == m_bSinglePrecision));
+      return static_cast<TFloat *>(m_aPredictionScores);
    }
-   TML_INLINE const FractionalDataType * GetPredictionScores() const {
+   template<typename TFloat>
+   TML_INLINE const TFloat * GetPredictionScores() const {
       EBM_ASSERT(nullptr != m_aPredictionScores);
-      return m_aPredictionScores;
+      EBM_ASSERT((std::is_same<TFloat, float>::value == m_bSinglePrecision));
+      return static_cast<const TFloat *>(m_aPredictionScores);
    }
+   // the targets are bit packed with GetTargetBitsPerItem() bits each.  Use BitPackedTargetReader to read them
    TML_INLINE const StorageDataTypeCore * GetTargetDataPointer() const {
       EBM_ASSERT(nullptr != m_aTargetData);
       return m_aTargetData;
    }
+   TML_INLINE size_t GetTargetBitsPerItem() const {
+      return m_cTargetBitsPerItem;
+   }
    // TODO: we can change this to take the m_iInputData value directly, which we get from the user! (this also applies to the other dataset)
    // TODO: rename this to GetInputDataPointer
    TML_INLINE const StorageDataTypeCore * GetDataPointer(const AttributeCombinationCore * const pAttributeCombination) const {
@@ -69,4 +174,136 @@ public:
    }
 };
 
+// reads the bit packed targets of consecutive cases starting from iCaseStart, which doesn't need to be on a unit boundary.  cTargetBits needs to match
+// GetTargetBitsPerItem() of the data set.  We only branch once per unit to load the next one, which is predictable since it happens every
+// k_cItemsPerUnit cases
+template<unsigned int cTargetBits>
+class BitPackedTargetReader final {
+   static_assert(1 <= cTargetBits && cTargetBits <= k_cBitsForStorageType, "cTargetBits must fit in our storage type");
+   static constexpr size_t k_cItemsPerUnit = k_cBitsForStorageType / cTargetBits;
+   static constexpr StorageDataTypeCore k_maskBits = std::numeric_limits<StorageDataTypeCore>::max() >> (k_cBitsForStorageType - cTargetBits);
+
+   const StorageDataTypeCore * m_pTargetData;
+   StorageDataTypeCore m_targetBits;
+   size_t m_cItemsRemaining;
+
+public:
+   TML_INLINE BitPackedTargetReader(const DataSetAttributeCombination * const pDataSet, const size_t iCaseStart)
+      : m_pTargetData(pDataSet->GetTargetDataPointer() + iCaseStart / k_cItemsPerUnit)
+      , m_targetBits(0)
+      , m_cItemsRemaining(0) {
+      EBM_ASSERT(cTargetBits == pDataSet->GetTargetBitsPerItem());
+      EBM_ASSERT(iCaseStart < pDataSet->GetCountCases());
+      const size_t iItemInUnit = iCaseStart % k_cItemsPerUnit;
+      if(0 != iItemInUnit) {
+         // iItemInUnit can only be non-zero if we have more than one item per unit, so this shift is less than k_cBitsForStorageType
+         m_targetBits = *m_pTargetData >> (iItemInUnit * cTargetBits);
+         ++m_pTargetData;
+         m_cItemsRemaining = k_cItemsPerUnit - iItemInUnit;
+      }
+   }
+
+   TML_INLINE StorageDataTypeCore Next() {
+      if(0 == m_cItemsRemaining) {
+         // we only load a unit once we need a case from it, so we never read past the end of our targets
+         m_targetBits = *m_pTargetData;
+         ++m_pTargetData;
+         m_cItemsRemaining = k_cItemsPerUnit;
+      }
+      const StorageDataTypeCore targetData = m_targetBits & k_maskBits;
+      if(1 != k_cItemsPerUnit) {
+         // shifting by the full width of our type is undefined, but when we have one item per unit we reload before using m_targetBits again
+         m_targetBits >>= (1 == k_cItemsPerUnit ? 0 : cTargetBits);
+      }
+      --m_cItemsRemaining;
+      return targetData;
+   }
+};
+
+// unpacks the bin indexes of pAttributeCombination and the targets of consecutive cases into buffers for our vectorized kernels.  We unpack whole bit pack
+// units at a time, so iCaseStart needs to be on a unit boundary.  With zero attributes every case is in bin zero and there is no packed data to read
+template<unsigned int cTargetBits>
+class BitPackedCaseUnpacker final {
+   const StorageDataTypeCore * m_pInputData;
+   const size_t m_cItemsPerBitPackDataUnit;
+   const size_t m_cBitsPerItemMax;
+   const size_t m_maskBits;
+   BitPackedTargetReader<cTargetBits> m_targetReader;
+
+public:
+   TML_INLINE BitPackedCaseUnpacker(const DataSetAttributeCombination * const pDataSet, const AttributeCombinationCore * const pAttributeCombination, const size_t iCaseStart)
+      : m_pInputData(0 == pAttributeCombination->m_cAttributes ? nullptr : pDataSet->GetDataPointer(pAttributeCombination) + iCaseStart / pAttributeCombination->m_cItemsPerBitPackDataUnit)
+      , m_cItemsPerBitPackDataUnit(0 == pAttributeCombination->m_cAttributes ? k_cBitsForStorageType : pAttributeCombination->m_cItemsPerBitPackDataUnit)
+      , m_cBitsPerItemMax(GetCountBits(m_cItemsPerBitPackDataUnit))
+      , m_maskBits(std::numeric_limits<size_t>::max() >> (k_cBitsForStorageType - m_cBitsPerItemMax))
+      , m_targetReader(pDataSet, iCaseStart) {
+      // chunks need to start on a bit pack boundary so that we can find the first item by indexing into the packed data
+      EBM_ASSERT(nullptr == m_pInputData || 0 == iCaseStart % m_cItemsPerBitPackDataUnit);
+   }
+
+   // fills our caller's buffers with whole units until the next unit wouldn't fit into cBufferCases, or until we've unpacked cCasesRemaining.  Returns
+   // the number of cases unpacked, which is always at least one unit or cCasesRemaining, whichever is smaller
+   TML_INLINE size_t Unpack(int64_t * const aiBins, int64_t * const aTargets, const size_t cBufferCases, const size_t cCasesRemaining) {
+      EBM_ASSERT(0 < cCasesRemaining);
+      EBM_ASSERT(m_cItemsPerBitPackDataUnit <= cBufferCases);
+      size_t cUnpackedCases = 0;
+      do {
+         size_t iBinCombined = 0;
+         if(nullptr != m_pInputData) {
+            iBinCombined = static_cast<size_t>(*m_pInputData);
+            ++m_pInputData;
+         }
+         const size_t cUnitCases = cCasesRemaining - cUnpackedCases < m_cItemsPerBitPackDataUnit ? cCasesRemaining - cUnpackedCases : m_cItemsPerBitPackDataUnit;
+         for(size_t iUnitCase = 0; iUnitCase < cUnitCases; ++iUnitCase) {
+            aiBins[cUnpackedCases] = static_cast<int64_t>(m_maskBits & iBinCombined);
+            aTargets[cUnpackedCases] = static_cast<int64_t>(m_targetReader.Next());
+            ++cUnpackedCases;
+            iBinCombined >>= m_cBitsPerItemMax;
+         }
+      } while(cUnpackedCases < cCasesRemaining && cUnpackedCases + m_cItemsPerBitPackDataUnit <= cBufferCases);
+      return cUnpackedCases;
+   }
+};
+
+// walks the cases [iCaseStart, iCaseStart + cCases) of a pass over pAttributeCombination in stream blocks, requesting each block from the OS one block before
+// we need it.  For in memory datasets the whole range is a single block, and there are no read ahead requests
+class StreamBlocks final {
+   const DataSetAttributeCombination * const m_pDataSet;
+   const AttributeCombinationCore * const m_pAttributeCombination;
+   const size_t m_cCasesPerBlock;
+   const size_t m_iCaseEnd;
+   size_t m_iCaseNext;
+
+public:
+   TML_INLINE StreamBlocks(const DataSetAttributeCombination * const pDataSet, const AttributeCombinationCore * const pAttributeCombination, const size_t iCaseStart, const size_t cCases)
+      : m_pDataSet(pDataSet)
+      , m_pAttributeCombination(pAttributeCombination)
+      , m_cCasesPerBlock(pDataSet->GetCountCasesPerStreamBlock(pAttributeCombination))
+      , m_iCaseEnd(iCaseStart + cCases)
+      , m_iCaseNext(iCaseStart) {
+      EBM_ASSERT(0 < cCases);
+      if(pDataSet->IsOutOfCore()) {
+         pDataSet->ReadAhead(pAttributeCombination, iCaseStart, cCases < m_cCasesPerBlock ? cCases : m_cCasesPerBlock);
+      }
+   }
+
+   // returns false once every block has been handed out
+   TML_INLINE bool Next(size_t * const piCaseStart, size_t * const pcCases) {
+      if(m_iCaseEnd == m_iCaseNext) {
+         return false;
+      }
+      const size_t cCasesRemaining = m_iCaseEnd - m_iCaseNext;
+      const size_t cCases = cCasesRemaining < m_cCasesPerBlock ? cCasesRemaining : m_cCasesPerBlock;
+      *piCaseStart = m_iCaseNext;
+      *pcCases = cCases;
+      m_iCaseNext += cCases;
+      if(m_iCaseEnd != m_iCaseNext) {
+         EBM_ASSERT(m_pDataSet->IsOutOfCore());
+         const size_t cCasesAfter = m_iCaseEnd - m_iCaseNext;
+         m_pDataSet->ReadAhead(m_pAttributeCombination, m_iCaseNext, cCasesAfter < m_cCasesPerBlock ? cCasesAfter : m_cCasesPerBlock);
+      }
+      return true;
+   }
+};
+
 #endif // DATA_SET_ATTRIBUTE_COMBINATION_H
@@ -0,0 +1,275 @@
+// Copyright (c) 2018 Microsoft Corporation
+// Licensed under the MIT license.
+// Author: Paul Koch <code@koch.ninja>
+
+#include "PrecompiledHeader.h"
+
+#include <assert.h>
+#include <stdio.h> // FILE, fopen, fwrite, fclose
+#include <stdlib.h> // malloc, free
+#include <string.h> // memcpy
+#include <stddef.h> // size_t, ptrdiff_t
+#include <stdint.h> // uint64_t
+
+#if defined(_WIN32)
+// we don't want to require windows.h in our precompiled header since then it will be needed in linux builds, which doesn't make sense
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else // platform
+#include <sys/mman.h> // mmap, munmap
+#include <sys/stat.h> // fstat
+#include <fcntl.h> // open
+#include <unistd.h> // close
+#endif // platform
+
+#include "ebmcore.h"
+#include "EbmInternal.h" // TML_INLINE
+#include "Logging.h" // EBM_ASSERT & LOG
+#include "DataColumn.h"
+#include "DataSetByAttribute.h"
+
+// File layout.  Every field is a 64 bit integer in the byte order of the machine that wrote the file:
+//   magic, version, sizeof(StorageDataTypeCore), cAttributes, cCases
+//   cAttributes EbmAttribute records
+//   cAttributes columns of cCases StorageDataTypeCore binned values each
+// Our header is a multiple of 8 bytes and mappings start on a page boundary, so the columns are aligned in memory when we map the file.  We don't
+// convert between byte orders or storage widths.  A file from a different kind of machine fails the magic or storage width check and the caller
+// needs to rebuild it from the original data.  If we change the layout, we increment k_dataSetFileVersion
+static constexpr uint64_t k_dataSetFileMagic = uint64_t { 0x3154455341444245 }; // "EBDASET1" when read as little endian bytes
+static constexpr uint64_t k_dataSetFileVersion = 1;
+static constexpr size_t k_cDataSetFileHeaderItems = 5;
+
+static_assert(sizeof(EbmAttribute) == 3 * sizeof(uint64_t), "EbmAttribute is written to our file as 3 64 bit integers");
+
+TML_INLINE static bool WriteFileBytes(FILE * const pFile, const void * const pBytes, const size_t cBytes) {
+   return 0 != cBytes && cBytes != fwrite(pBytes, 1, cBytes, pFile);
+}
+
+bool DataSetShared::SaveToFile(const char * const filePath) const {
+   LOG(TraceLevelInfo, "Entered DataSetShared::SaveToFile");
+
+   EBM_ASSERT(nullptr != filePath);
+
+   FILE * const pFile = fopen(filePath, "wb");
+   if(nullptr == pFile) {
+      LOG(TraceLevelWarning, "WARNING DataSetShared::SaveToFile nullptr == pFile");
+      return true;
+   }
+
+   const uint64_t header[k_cDataSetFileHeaderItems] = { k_dataSetFileMagic, k_dataSetFileVersion, uint64_t { sizeof(StorageDataTypeCore) }, static_cast<uint64_t>(m_cAttributes), static_cast<uint64_t>(m_cCases) };
+   bool bError = WriteFileBytes(pFile, header, sizeof(header));
+   // our attributes were allocated with this size, so it can't overflow
+   bError = bError || WriteFileBytes(pFile, m_aAttributes, sizeof(EbmAttribute) * m_cAttributes);
+   if(nullptr != m_aaInputData) {
+      // our columns were allocated with this size, so it can't overflow
+      const size_t cBytesColumn = sizeof(StorageDataTypeCore) * m_cCases;
+      for(size_t iAttribute = 0; iAttribute < m_cAttributes; ++iAttribute) {
+         bError = bError || WriteFileBytes(pFile, m_aaInputData[iAttribute], cBytesColumn);
+      }
+   }
+   // fclose can be where we find out that the final buffered write failed
+   if(0 != fclose(pFile) || bError) {
+      LOG(TraceLevelWarning, "WARNING DataSetShared::SaveToFile failed writing the file");
+      return true;
+   }
+
+   LOG(TraceLevelInfo, "Exited DataSetShared::SaveToFile");
+   return false;
+}
+
+// returns true if any of the cCases bins isn't below cStates.  We OR the comparisons together instead of returning at the first bad bin, which
+// lets the compiler vectorize the loop on files that are valid, which is almost all of them
+static bool IsBinOutOfRange(const StorageDataTypeCore * const aInputData, const size_t cCases, const size_t cStates) {
+   bool bOutOfRange = false;
+   for(size_t iCase = 0; iCase < cCases; ++iCase) {
+      bOutOfRange |= cStates <= static_cast<size_t>(aInputData[iCase]);
+   }
+   return bOutOfRange;
+}
+
+// returns nullptr on error
+static const void * MapFile(const char * const filePath, size_t * const pcBytes) {
+#if defined(_WIN32)
+   const HANDLE hFile = CreateFileA(filePath, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+   if(INVALID_HANDLE_VALUE == hFile) {
+      return nullptr;
+   }
+   LARGE_INTEGER size;
+   if(!GetFileSizeEx(hFile, &size) || 0 == size.QuadPart || !IsNumberConvertable<size_t, LONGLONG>(size.QuadPart)) {
+      CloseHandle(hFile);
+      return nullptr;
+   }
+   const HANDLE hMapping = CreateFileMappingA(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+   // the view keeps the file and mapping alive after we close our handles to them
+   CloseHandle(hFile);
+   if(nullptr == hMapping) {
+      return nullptr;
+   }
+   const void * const pView = MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+   CloseHandle(hMapping);
+   *pcBytes = static_cast<size_t>(size.QuadPart);
+   return pView;
+#else // platform
+   const int fd = open(filePath, O_RDONLY);
+   if(fd < 0) {
+      return nullptr;
+   }
+   struct stat fileStatus;
+   if(0 != fstat(fd, &fileStatus) || fileStatus.st_size <= 0 || !IsNumberConvertable<size_t, off_t>(fileStatus.st_size)) {
+      close(fd);
+      return nullptr;
+   }
+   const size_t cBytes = static_cast<size_t>(fileStatus.st_size);
+   // MAP_SHARED on a read-only mapping lets every process that loads this file use the same page cache pages
+   void * const pMapping = mmap(nullptr, cBytes, PROT_READ, MAP_SHARED, fd, 0);
+   // the mapping keeps the file alive after we close our descriptor
+   close(fd);
+   if(MAP_FAILED == pMapping) {
+      return nullptr;
+   }
+   *pcBytes = cBytes;
+   return pMapping;
+#endif // platform
+}
+
+void DataSetShared::UnmapFile(const void * const pFileMapping, const size_t cBytesFileMapping) {
+   EBM_ASSERT(nullptr != pFileMapping);
+#if defined(_WIN32)
+   UNUSED(cBytesFileMapping);
+   UnmapViewOfFile(pFileMapping);
+#else // platform
+   munmap(const_cast<void *>(pFileMapping), cBytesFileMapping);
+#endif // platform
+}
+
+DataSetShared * DataSetShared::LoadFromFile(const char * const filePath) {
+   LOG(TraceLevelInfo, "Entered DataSetShared::LoadFromFile");
+
+   EBM_ASSERT(nullptr != filePath);
+
+   size_t cBytesFile = 0;
+   const void * const pFileMapping = MapFile(filePath, &cBytesFile);
+   if(nullptr == pFileMapping) {
+      LOG(TraceLevelWarning, "WARNING DataSetShared::LoadFromFile nullptr == pFileMapping");
+      return nullptr;
+   }
+   const unsigned char * const pFileBytes = static_cast<const unsigned char *>(pFileMapping);
+
+   uint64_t header[k_cDataSetFileHeaderItems];
+   if(cBytesFile < sizeof(header)) {
+      LOG(TraceLevelWarning, "WARNING DataSetShared::LoadFromFile cBytesFile < sizeof(header)");
+      UnmapFile(pFileMapping, cBytesFile);
+      return nullptr;
+   }
+   memcpy(header, pFileBytes, sizeof(header));
+   if(k_dataSetFileMagic != header[0] || k_dataSetFileVersion != header[1] || sizeof(StorageDataTypeCore) != header[2]) {
+      LOG(TraceLevelWarning, "WARNING DataSetShared::LoadFromFile the file is not a dataset written by this version on this kind of machine");
+      UnmapFile(pFileMapping, cBytesFile);
+      return nullptr;
+   }
+   if(!IsNumberConvertable<size_t, uint64_t>(header[3]) || !IsNumberConvertable<size_t, uint64_t>(header[4]) || !IsNumberConvertable<IntegerDataType, uint64_t>(header[3]) || !IsNumberConvertable<IntegerDataType, uint64_t>(header[4])) {
+      LOG(TraceLevelWarning, "WARNING DataSetShared::LoadFromFile counts in the file are too large");
+      UnmapFile(pFileMapping, cBytesFile);
+      return nullptr;
+   }
+   const size_t cAttributes = static_cast<size_t>(header[3]);
+   const size_t cCases = static_cast<size_t>(header[4]);
+
+   // the file size has to be exactly what the counts describe, so a truncated file can't have us reading past the end of the mapping
+   bool bBadSize = IsMultiplyError(sizeof(EbmAttribute), cAttributes) || IsMultiplyError(sizeof(StorageDataTypeCore), cCases) || IsMultiplyError(sizeof(StorageDataTypeCore) * cCases, cAttributes) || IsMultiplyError(sizeof(void *), cAttributes) || IsMultiplyError(sizeof(EbmDataColumn), cAttributes);
+   const size_t cBytesAttributes = bBadSize ? 0 : sizeof(EbmAttribute) * cAttributes;
+   const size_t cBytesColumn = bBadSize ? 0 : sizeof(StorageDataTypeCore) * cCases;
+   const size_t cBytesColumns = bBadSize ? 0 : cBytesColumn * cAttributes;
+   bBadSize = bBadSize || IsAddError(sizeof(header), cBytesAttributes) || IsAddError(sizeof(header) + cBytesAttributes, cBytesColumns);
+   bBadSize = bBadSize || sizeof(header) + cBytesAttributes + cBytesColumns != cBytesFile;
+   if(bBadSize) {
+      LOG(TraceLevelWarning, "WARNING DataSetShared::LoadFromFile the file size does not match its header");
+      UnmapFile(pFileMapping, cBytesFile);
+      return nullptr;
+   }
+
+   DataSetShared * const pDataSetShared = new (std::nothrow) DataSetShared(cAttributes, cCases);
+   if(nullptr == pDataSetShared) {
+      LOG(TraceLevelWarning, "WARNING DataSetShared::LoadFromFile nullptr == pDataSetShared");
+      UnmapFile(pFileMapping, cBytesFile);
+      return nullptr;
+   }
+   // from here on our destructor unmaps the file
+   pDataSetShared->m_pFileMapping = pFileMapping;
+   pDataSetShared->m_cBytesFileMapping = cBytesFile;
+
+   if(0 != cAttributes) {
+      // the attributes are tiny, and copying them lets every other part of the dataset treat them the same way regardless of where we came from
+      pDataSetShared->m_aAttributes = static_cast<EbmAttribute *>(malloc(cBytesAttributes));
+      if(nullptr == pDataSetShared->m_aAttributes) {
+         LOG(TraceLevelWarning, "WARNING DataSetShared::LoadFromFile nullptr == m_aAttributes");
+         delete pDataSetShared;
+         return nullptr;
+      }
+      memcpy(pDataSetShared->m_aAttributes, pFileBytes + sizeof(header), cBytesAttributes);
+      if(IsAttributesError(cAttributes, pDataSetShared->m_aAttributes, true)) {
+         LOG(TraceLevelWarning, "WARNING DataSetShared::LoadFromFile IsAttributesError(cAttributes, m_aAttributes, true)");
+         delete pDataSetShared;
+         return nullptr;
+      }
+
+      if(0 != cCases) {
+         const StorageDataTypeCore ** const aaInputData = static_cast<const StorageDataTypeCore **>(malloc(sizeof(void *) * cAttributes));
+         if(nullptr == aaInputData) {
+            LOG(TraceLevelWarning, "WARNING DataSetShared::LoadFromFile nullptr == aaInputData");
+            delete pDataSetShared;
+            return nullptr;
+         }
+         pDataSetShared->m_aaInputData = aaInputData;
+         pDataSetShared->m_aColumns = static_cast<EbmDataColumn *>(malloc(sizeof(EbmDataColumn) * cAttributes));
+         if(nullptr == pDataSetShared->m_aColumns) {
+            LOG(TraceLevelWarning, "WARNING DataSetShared::LoadFromFile nullptr == m_aColumns");
+            delete pDataSetShared;
+            return nullptr;
+         }
+         const unsigned char * pColumn = pFileBytes + sizeof(header) + cBytesAttributes;
+         for(size_t iAttribute = 0; iAttribute < cAttributes; ++iAttribute) {
+            const StorageDataTypeCore * const aInputData = reinterpret_cast<const StorageDataTypeCore *>(pColumn);
+            // everything downstream only asserts that bins are below countStates, and then indexes histograms with them, so a corrupt or mismatched
+            // file has to be caught here.  This reads the whole file once, which training would do anyways when it packs its attribute combinations
+            if(IsBinOutOfRange(aInputData, cCases, static_cast<size_t>(pDataSetShared->m_aAttributes[iAttribute].countStates))) {
+               LOG(TraceLevelWarning, "WARNING DataSetShared::LoadFromFile a bin in the file is not below its attribute's countStates");
+               delete pDataSetShared;
+               return nullptr;
+            }
+            aaInputData[iAttribute] = aInputData;
+            pDataSetShared->m_aColumns[iAttribute].data = pColumn;
+            pDataSetShared->m_aColumns[iAttribute].dataType = sizeof(StorageDataTypeCore) == sizeof(uint32_t) ? DataColumnTypeUInt32 : DataColumnTypeInt64;
+            pDataSetShared->m_aColumns[iAttribute].strideBytes = static_cast<IntegerDataType>(sizeof(StorageDataTypeCore));
+            pColumn += cBytesColumn;
+         }
+      }
+   }
+
+   LOG(TraceLevelInfo, "Exited DataSetShared::LoadFromFile");
+   return pDataSetShared;
+}
+
+EBMCORE_IMPORT_EXPORT IntegerDataType EBMCORE_CALLING_CONVENTION SaveDataSet(PEbmDataSet ebmDataSet, const char * filePath) {
+   LOG(TraceLevelInfo, "Entered SaveDataSet: ebmDataSet=%p, filePath=%p", static_cast<void *>(ebmDataSet), static_cast<const void *>(filePath));
+   const DataSetShared * const pDataSetShared = reinterpret_cast<const DataSetShared *>(ebmDataSet);
+   if(nullptr == pDataSetShared || nullptr == filePath) {
+      LOG(TraceLevelWarning, "WARNING SaveDataSet nullptr == pDataSetShared || nullptr == filePath");
+      return 1;
+   }
+   const IntegerDataType ret = pDataSetShared->SaveToFile(filePath) ? 1 : 0;
+   LOG(TraceLevelInfo, "Exited SaveDataSet %" IntegerDataTypePrintf, ret);
+   return ret;
+}
+
+EBMCORE_IMPORT_EXPORT PEbmDataSet EBMCORE_CALLING_CONVENTION LoadDataSet(const char * filePath) {
+   LOG(TraceLevelInfo, "Entered LoadDataSet: filePath=%p", static_cast<const void *>(filePath));
+   if(nullptr == filePath) {
+      LOG(TraceLevelWarning, "WARNING LoadDataSet nullptr == filePath");
+      return nullptr;
+   }
+   PEbmDataSet pEbmDataSet = reinterpret_cast<PEbmDataSet>(DataSetShared::LoadFromFile(filePath));
+   LOG(TraceLevelInfo, "Exited LoadDataSet %p", static_cast<void *>(pEbmDataSet));
+   return pEbmDataSet;
+}
@@ -230,6 +230,41 @@ constexpr size_t k_cBitsForSizeTCore = CountBitsRequiredPositiveMax<size_t>();
 constexpr size_t k_cDimensionsMax = k_cBitsForSizeTCore - 1;
 static_assert(k_cDimensionsMax < k_cBitsForSizeTCore, "reserve the highest bit for bit manipulation space");
 
+// the attribute combination dimension counts that we compile specialized versions of our interaction binning, tensor totals and interaction scoring for.
+// With a compile time dimension count all of the per dimension index arithmetic unrolls, so pairs and triples don't loop over their dimensions for each
+// case or cut.  Any other number of dimensions uses our runtime version (countCompilerDimensions of 0).  Each specialization gets compiled for every
+// compiler optimized target state count and every instruction set that we dispatch to, so raising this costs compile time and module size quickly
+constexpr size_t k_cCompilerOptimizedDimensionsMin = 2;
+constexpr size_t k_cCompilerOptimizedDimensionsMax = 3;
+static_assert(k_cCompilerOptimizedDimensionsMin <= k_cCompilerOptimizedDimensionsMax, "we need at least one dimension count to specialize");
+static_assert(k_cCompilerOptimizedDimensionsMax <= k_cDimensionsMax, "we can't have more dimensions than k_cDimensionsMax");
+
+// calls TVariant<countCompilerClassificationTargetStates, cRuntimeDimensions>::Run(args...) if cRuntimeDimensions is one of the dimension counts that we
+// specialize, and TVariant<countCompilerClassificationTargetStates, 0>::Run(args...) otherwise.  We can't partially specialize functions, so the
+// recursion goes through this class with its cumbersome inline static class functions.  Run is forced inline, so if our caller is compiled for a wider
+// instruction set (see RunSimdVariant) then all of the specialized variants get inlined and compiled for that instruction set as well
+template<template<ptrdiff_t, size_t> class TVariant, ptrdiff_t countCompilerClassificationTargetStates, size_t iPossibleCompilerOptimizedDimensions = k_cCompilerOptimizedDimensionsMin>
+class CompilerRecursiveDimensions final {
+public:
+   template<typename... TArgs>
+   TML_INLINE static auto Run(const size_t cRuntimeDimensions, const TArgs... args) -> decltype(TVariant<countCompilerClassificationTargetStates, 0>::Run(args...)) {
+      if(iPossibleCompilerOptimizedDimensions == cRuntimeDimensions) {
+         return TVariant<countCompilerClassificationTargetStates, iPossibleCompilerOptimizedDimensions>::Run(args...);
+      }
+      return CompilerRecursiveDimensions<TVariant, countCompilerClassificationTargetStates, iPossibleCompilerOptimizedDimensions + 1>::Run(cRuntimeDimensions, args...);
+   }
+};
+
+template<template<ptrdiff_t, size_t> class TVariant, ptrdiff_t countCompilerClassificationTargetStates>
+class CompilerRecursiveDimensions<TVariant, countCompilerClassificationTargetStates, k_cCompilerOptimizedDimensionsMax + 1> final {
+public:
+   template<typename... TArgs>
+   TML_INLINE static auto Run(const size_t cRuntimeDimensions, const TArgs... args) -> decltype(TVariant<countCompilerClassificationTargetStates, 0>::Run(args...)) {
+      UNUSED(cRuntimeDimensions);
+      return TVariant<countCompilerClassificationTargetStates, 0>::Run(args...);
+   }
+};
+
 constexpr size_t k_cBitsForStorageType = CountBitsRequiredPositiveMax<StorageDataTypeCore>();
 constexpr size_t k_cCountItemsBitPackedMax = k_cBitsForStorageType; // if each item is a bit, then the number of items will equal the number of bits
 
@@ -245,6 +280,18 @@ constexpr TML_INLINE size_t GetNextCountItemsBitPacked(const size_t cItemsBitPac
    return k_cBitsForStorageType / ((k_cBitsForStorageType / cItemsBitPackedPrev) + 1);
 }
 
+constexpr size_t GetGreatestCommonDivisor(const size_t num1, const size_t num2) {
+   return 0 == num2 ? num1 : GetGreatestCommonDivisor(num2, num1 % num2);
+}
+constexpr size_t GetLeastCommonMultiple(const size_t num1, const size_t num2) {
+   return num1 / GetGreatestCommonDivisor(num1, num2) * num2;
+}
+// the smallest number of cases that is a whole number of bit pack units for every number of bits per item from cBits up to k_cBitsForStorageType.  For
+// 64 bits this is 20160 = 64 * 9 * 5 * 7.  Splitting the cases on multiples of this puts the split at the same case for every attribute combination
+constexpr size_t GetCountItemsBitPackedCommonMultiple(const size_t cBits = 1) {
+   return k_cBitsForStorageType < cBits ? size_t { 1 } : GetLeastCommonMultiple(GetCountItemsBitPacked(cBits), GetCountItemsBitPackedCommonMultiple(cBits + 1));
+}
+
 WARNING_PUSH
 WARNING_DISABLE_POTENTIAL_DIVIDE_BY_ZERO
 // TODO : also check for places where to convert a size_t into a ptrdiff_t and check for overflow there throughout our code
@@ -266,6 +313,16 @@ constexpr TML_INLINE bool IsAddError(const size_t num1, const size_t num2) {
    return num1 + num2 < num1;
 }
 
+// our memory estimates add up sizes for datasets that we haven't checked yet.  Instead of failing on overflow, they stick at the maximum, which is a fine
+// answer to "how much memory will this take"
+constexpr TML_INLINE size_t AddSaturate(const size_t num1, const size_t num2) {
+   return IsAddError(num1, num2) ? std::numeric_limits<size_t>::max() : num1 + num2;
+}
+
+constexpr TML_INLINE size_t MultiplySaturate(const size_t num1, const size_t num2) {
+   return IsMultiplyError(num1, num2) ? std::numeric_limits<size_t>::max() : num1 * num2;
+}
+
 // TODO : keep this constant, but make it global and compile out the costs... we want to document that it's possible and how, but we have tested it and found it's worse
 static constexpr ptrdiff_t k_iZeroResidual = -1;
 static constexpr ptrdiff_t k_iZeroClassificationLogitAtInitialize = -1;
@@ -78,10 +78,11 @@ public:
       return result;
    }
 
-   TML_INLINE static FractionalDataType ComputeClassificationResidualErrorMulticlass(const FractionalDataType sumExp, const FractionalDataType trainingLogWeight, const StorageDataTypeCore binnedActualValue, const StorageDataTypeCore iVector) {
+   // trainingExp is exp(trainingLogWeight).  Our callers already calculate it for each logit when summing sumExp, so we take it instead of calculating it again
+   TML_INLINE static FractionalDataType ComputeClassificationResidualErrorMulticlass(const FractionalDataType sumExp, const FractionalDataType trainingExp, const StorageDataTypeCore binnedActualValue, const StorageDataTypeCore iVector) {
       // TODO: is it better to use the non-branching conditional below, or is it better to assign all the items the negation case and then AFTERWARDS adding one to the single case that is equal to iVector 
       const FractionalDataType yi = UNPREDICTABLE(iVector == binnedActualValue) ? FractionalDataType { 1 } : static_cast<FractionalDataType>(0);
-      const FractionalDataType ret = yi - std::exp(trainingLogWeight) / sumExp;
+      const FractionalDataType ret = yi - trainingExp / sumExp;
       return ret;
    }
 
@@ -90,8 +91,8 @@ public:
       const FractionalDataType yi = UNPREDICTABLE(isMatch) ? FractionalDataType { 1 } : FractionalDataType { 0 };
       const FractionalDataType ret = yi - FractionalDataType { 1 } / sumExp;
 
-      EBM_ASSERT(!isMatch || ComputeClassificationResidualErrorMulticlass(sumExp, 0, 1, 1) == ret);
-      EBM_ASSERT(isMatch || ComputeClassificationResidualErrorMulticlass(sumExp, 0, 1, 2) == ret);
+      EBM_ASSERT(!isMatch || ComputeClassificationResidualErrorMulticlass(sumExp, 1, 1, 1) == ret);
+      EBM_ASSERT(isMatch || ComputeClassificationResidualErrorMulticlass(sumExp, 1, 1, 2) == ret);
 
       return ret;
    }
@@ -113,10 +114,18 @@ public:
       return std::log(1 + std::exp(UNPREDICTABLE(0 == binnedActualValue) ? validationLogOddsPrediction : -validationLogOddsPrediction)); // log & exp will return the same type that it is given, either float or double
    }
 
-   TML_INLINE static FractionalDataType ComputeClassificationSingleCaseLogLossMulticlass(const FractionalDataType sumExp, const FractionalDataType * const aValidationLogWeight, const StorageDataTypeCore binnedActualValue) {
+   // validationExp is exp(validationLogWeight) of the actual target state, which our callers already calculated when summing sumExp
+   TML_INLINE static FractionalDataType ComputeClassificationProbabilityMulticlass(const FractionalDataType sumExp, const FractionalDataType validationExp) {
+      return validationExp / sumExp;
+   }
+
+   // logProbability is the log of ComputeClassificationProbabilityMulticlass.  Our callers take the logs of a whole buffer of cases at once with the
+   // log kernel of their math backend, which is std::log unless the caller asked for fast math
+   TML_INLINE static FractionalDataType ComputeClassificationSingleCaseLogLossMulticlass(const FractionalDataType logProbability) {
       // TODO: is there any way to avoid doing the negation below, like changing sumExp or what we store in memory?
-      return -std::log(std::exp(aValidationLogWeight[binnedActualValue]) / sumExp);
+      return -logProbability;
    }
+
 };
 
 #endif // STATISTICS_H
\ No newline at end of file
@@ -7,6 +7,8 @@
 
 #include <assert.h>
 #include <stddef.h> // size_t, ptrdiff_t
+#include <string.h> // memcpy
+#include <type_traits> // std::is_same
 
 #include "ebmcore.h"
 #include "EbmStatistics.h"
@@ -15,8 +17,9 @@
 // a*PredictionScores = logOdds for binary classification
 // a*PredictionScores = logWeights for multiclass classification
 // a*PredictionScores = predictedValue for regression
-template<ptrdiff_t countCompilerClassificationTargetStates>
-static void InitializeResiduals(const size_t cCases, const void * const aTargetData, const FractionalDataType * const aPredictionScores, FractionalDataType * pResidualError, const size_t cTargetStates) {
+// TFloat is the type that our data set stores its residuals as.  We compute everything in FractionalDataType and round only when storing
+template<ptrdiff_t countCompilerClassificationTargetStates, typename TFloat>
+static void InitializeResiduals(const size_t cCases, const void * const aTargetData, const FractionalDataType * const aPredictionScores, TFloat * pResidualError, const size_t cTargetStates) {
    LOG(TraceLevelInfo, "Entered InitializeResiduals");
 
    // TODO : review this function to see if iZeroResidual was set to a valid index, does that affect the number of items in pPredictionScores (I assume so), and does it affect any calculations below like sumExp += std::exp(predictionScore) and the equivalent.  Should we use cVectorLength or cTargetStates for some of the addition
@@ -30,13 +33,24 @@ static void InitializeResiduals(const size_t cCases, const void * const aTargetD
    EBM_ASSERT(!IsMultiplyError(cVectorLength, cCases)); // if we couldn't multiply these then we should not have been able to allocate pResidualError before calling this function
    const size_t cVectoredItems = cVectorLength * cCases;
    EBM_ASSERT(!IsMultiplyError(cVectoredItems, sizeof(pResidualError[0]))); // if we couldn't multiply these then we should not have been able to allocate pResidualError before calling this function
-   const FractionalDataType * const pResidualErrorEnd = pResidualError + cVectoredItems;
+   const TFloat * const pResidualErrorEnd = pResidualError + cVectoredItems;
 
    if(nullptr == aPredictionScores) {
       // TODO: do we really need to handle the case where pPredictionScores is null? In the future, we'll probably initialize our data with the intercept, in which case we'll always have existing predictions
       if(IsRegression(countCompilerClassificationTargetStates)) {
          // calling ComputeRegressionResidualError(predictionScore, data) with predictionScore as zero gives just data, so we can memcopy these values
-         memcpy(pResidualError, aTargetData, cCases * sizeof(pResidualError[0]));
+         if(std::is_same<TFloat, FractionalDataType>::value) {
+            memcpy(pResidualError, aTargetData, cCases * sizeof(pResidualError[0]));
+         } else {
+            // our residuals are stored in a narrower type than our targets, so we need to convert them one at a time
+            const FractionalDataType * pTargetDataFrom = static_cast<const FractionalDataType *>(aTargetData);
+            TFloat * pResidualErrorTo = pResidualError;
+            do {
+               *pResidualErrorTo = static_cast<TFloat>(*pTargetDataFrom);
+               ++pTargetDataFrom;
+               ++pResidualErrorTo;
+            } while(pResidualErrorEnd != pResidualErrorTo);
+         }
 #ifndef NDEBUG
          const FractionalDataType * pTargetData = static_cast<const FractionalDataType *>(aTargetData);
          do {
@@ -45,7 +59,7 @@ static void InitializeResiduals(const size_t cCases, const void * const aTargetD
             EBM_ASSERT(!std::isinf(data));
             const FractionalDataType predictionScore = 0;
             const FractionalDataType residualError = EbmStatistics::ComputeRegressionResidualError(predictionScore, data);
-            EBM_ASSERT(*pResidualError == residualError);
+            EBM_ASSERT(*pResidualError == static_cast<TFloat>(residualError));
             ++pTargetData;
             ++pResidualError;
          } while(pResidualErrorEnd != pResidualError);
@@ -71,13 +85,13 @@ static void InitializeResiduals(const size_t cCases, const void * const aTargetD
 
             if(IsBinaryClassification(countCompilerClassificationTargetStates)) {
                const FractionalDataType residualError = EbmStatistics::ComputeClassificationResidualErrorBinaryclass(data);
-               *pResidualError = residualError;
+               *pResidualError = static_cast<TFloat>(residualError);
                ++pResidualError;
             } else {
                for(StorageDataTypeCore iVector = 0; iVector < cVectorLengthStorage; ++iVector) {
                   const FractionalDataType residualError = EbmStatistics::ComputeClassificationResidualErrorMulticlass(data, iVector, matchValue, nonMatchValue);
-                  EBM_ASSERT(EbmStatistics::ComputeClassificationResidualErrorMulticlass(static_cast<FractionalDataType>(cVectorLength), 0, data, iVector) == residualError);
-                  *pResidualError = residualError;
+                  EBM_ASSERT(EbmStatistics::ComputeClassificationResidualErrorMulticlass(static_cast<FractionalDataType>(cVectorLength), 1, data, iVector) == residualError);
+                  *pResidualError = static_cast<TFloat>(residualError);
                   ++pResidualError;
                }
                // TODO: this works as a way to remove one parameter, but it obviously insn't as efficient as omitting the parameter
@@ -106,7 +120,7 @@ static void InitializeResiduals(const size_t cCases, const void * const aTargetD
             EBM_ASSERT(!std::isinf(data));
             const FractionalDataType predictionScore = *pPredictionScores;
             const FractionalDataType residualError = EbmStatistics::ComputeRegressionResidualError(predictionScore, data);
-            *pResidualError = residualError;
+            *pResidualError = static_cast<TFloat>(residualError);
             ++pTargetData;
             ++pPredictionScores;
             ++pResidualError;
@@ -130,7 +144,7 @@ static void InitializeResiduals(const size_t cCases, const void * const aTargetD
             if(IsBinaryClassification(countCompilerClassificationTargetStates)) {
                const FractionalDataType predictionScore = *pPredictionScores;
                const FractionalDataType residualError = EbmStatistics::ComputeClassificationResidualErrorBinaryclass(predictionScore, data);
-               *pResidualError = residualError;
+               *pResidualError = static_cast<TFloat>(residualError);
                ++pPredictionScores;
                ++pResidualError;
             } else {
@@ -149,9 +163,9 @@ static void InitializeResiduals(const size_t cCases, const void * const aTargetD
 
                for(StorageDataTypeCore iVector = 0; iVector < cVectorLengthStorage; ++iVector) {
                   const FractionalDataType predictionScore = *pPredictionScores - subtract;
-                  // TODO : we're calculating exp(predictionScore) above, and then again in ComputeClassificationResidualErrorMulticlass.  exp(..) is expensive so we should just do it once instead and store the result in a small memory array here
-                  const FractionalDataType residualError = EbmStatistics::ComputeClassificationResidualErrorMulticlass(sumExp, predictionScore, data, iVector);
-                  *pResidualError = residualError;
+                  // we only initialize once, so unlike our training loops we don't keep the exp values from above in a buffer
+                  const FractionalDataType residualError = EbmStatistics::ComputeClassificationResidualErrorMulticlass(sumExp, std::exp(predictionScore), data, iVector);
+                  *pResidualError = static_cast<TFloat>(residualError);
                   ++pPredictionScores;
                   ++pResidualError;
                }
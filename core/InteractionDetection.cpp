@@ -8,6 +8,8 @@
 #include <stdlib.h> // malloc, realloc, free
 #include <stddef.h> // size_t, ptrdiff_t
 #include <limits> // numeric_limits
+#include <algorithm> // partial_sort
+#include <cmath> // ceil, isnan
 
 #include "ebmcore.h"
 #include "EbmInternal.h"
@@ -15,9 +17,12 @@
 // attribute includes
 #include "AttributeInternal.h"
 // dataset depends on attributes
+#include "DataColumn.h"
 #include "DataSetByAttribute.h"
 // depends on the above
 #include "MultiDimensionalTraining.h"
+#include "ThreadPool.h"
+#include "RandomStream.h"
 
 // TODO : rename this to EbmInteractionState
 class TmlInteractionState {
@@ -30,8 +35,11 @@ public:
    AttributeInternalCore * const m_aAttributes;
    DataSetInternalCore * m_pDataSet;
 
-   unsigned int m_cLogEnterMessages;
-   unsigned int m_cLogExitMessages;
+   // scratch space for the non-reentrant GetInteractionScores and GetInteractionScoresScreened functions.  We keep these between calls so that we don't need to
+   // reallocate our binning buffers for every attribute combination, and we keep one per task so that the tasks in a batch can score in parallel.
+   // GetInteractionScore doesn't use these.  It keeps its scratch space on the stack so that, like before, it can be called from multiple threads at once
+   size_t m_cCachedThreadResources;
+   CachedInteractionThreadResources ** m_apCachedThreadResources;
 
    TmlInteractionState(const bool bRegression, const size_t cTargetStates, const size_t cAttributes)
       : m_bRegression(bRegression)
@@ -39,20 +47,52 @@ public:
       , m_cAttributes(cAttributes)
       , m_aAttributes(0 == cAttributes || IsMultiplyError(sizeof(AttributeInternalCore), cAttributes) ? nullptr : static_cast<AttributeInternalCore *>(malloc(sizeof(AttributeInternalCore) * cAttributes)))
       , m_pDataSet(nullptr)
-      , m_cLogEnterMessages (1000)
-      , m_cLogExitMessages(1000) {
+      , m_cCachedThreadResources(0)
+      , m_apCachedThreadResources(nullptr) {
    }
 
    ~TmlInteractionState() {
       LOG(TraceLevelInfo, "Entered ~EbmInteractionState");
 
+      for(size_t iCachedThreadResources = 0; iCachedThreadResources < m_cCachedThreadResources; ++iCachedThreadResources) {
+         delete m_apCachedThreadResources[iCachedThreadResources];
+      }
+      free(m_apCachedThreadResources);
       delete m_pDataSet;
       free(m_aAttributes);
 
       LOG(TraceLevelInfo, "Exited ~EbmInteractionState");
    }
 
-   bool InitializeInteraction(const EbmAttribute * const aAttributes, const size_t cCases, const void * const aTargets, const IntegerDataType * const aInputData, const FractionalDataType * const aPredictionScores) {
+   // returns true on error.  On success the first cCachedThreadResources items of m_apCachedThreadResources are valid
+   bool EnsureCachedThreadResources(const size_t cCachedThreadResources) {
+      if(LIKELY(cCachedThreadResources <= m_cCachedThreadResources)) {
+         return false;
+      }
+      if(IsMultiplyError(sizeof(*m_apCachedThreadResources), cCachedThreadResources)) {
+         LOG(TraceLevelWarning, "WARNING EnsureCachedThreadResources IsMultiplyError(sizeof(*m_apCachedThreadResources), cCachedThreadResources)");
+         return true;
+      }
+      CachedInteractionThreadResources ** const apCachedThreadResources = static_cast<CachedInteractionThreadResources **>(realloc(m_apCachedThreadResources, sizeof(*m_apCachedThreadResources) * cCachedThreadResources));
+      if(UNLIKELY(nullptr == apCachedThreadResources)) {
+         // realloc leaves the old memory valid on failure, and we still own it
+         LOG(TraceLevelWarning, "WARNING EnsureCachedThreadResources nullptr == apCachedThreadResources");
+         return true;
+      }
+      m_apCachedThreadResources = apCachedThreadResources;
+      do {
+         CachedInteractionThreadResources * const pCachedThreadResources = new (std::nothrow) CachedInteractionThreadResources();
+         if(UNLIKELY(nullptr == pCachedThreadResources)) {
+            LOG(TraceLevelWarning, "WARNING EnsureCachedThreadResources nullptr == pCachedThreadResources");
+            return true;
+         }
+         m_apCachedThreadResources[m_cCachedThreadResources] = pCachedThreadResources;
+         ++m_cCachedThreadResources;
+      } while(m_cCachedThreadResources < cCachedThreadResources);
+      return false;
+   }
+
+   bool InitializeInteraction(const EbmAttribute * const aAttributes, const size_t cCases, const void * const aTargets, const EbmDataColumn * const aInputData, DataSetShared * const pDataSetShared, const FractionalDataType * const aPredictionScores) {
       LOG(TraceLevelInfo, "Entered InitializeInteraction");
 
       if(0 != m_cAttributes && nullptr == m_aAttributes) {
@@ -103,7 +143,13 @@ public:
       LOG(TraceLevelInfo, "Entered DataSetInternalCore");
       EBM_ASSERT(nullptr == m_pDataSet);
       if(0 != cCases) {
-         m_pDataSet = new (std::nothrow) DataSetInternalCore(m_bRegression, m_cAttributes, m_aAttributes, cCases, aInputData, aTargets, aPredictionScores, m_cTargetStates);
+         if(nullptr != pDataSetShared) {
+            // share the binned data instead of making our own copy of it
+            EBM_ASSERT(cCases == pDataSetShared->GetCountCases());
+            m_pDataSet = new (std::nothrow) DataSetInternalCore(m_bRegression, pDataSetShared, aTargets, aPredictionScores, m_cTargetStates);
+         } else {
+            m_pDataSet = new (std::nothrow) DataSetInternalCore(m_bRegression, m_cAttributes, m_aAttributes, cCases, aInputData, aTargets, aPredictionScores, m_cTargetStates);
+         }
          if(nullptr == m_pDataSet || m_pDataSet->IsError()) {
             LOG(TraceLevelWarning, "WARNING InitializeInteraction nullptr == pDataSet || pDataSet->IsError()");
             return true;
@@ -123,7 +169,7 @@ public:
 // a*PredictionScores = logOdds for binary classification
 // a*PredictionScores = logWeights for multiclass classification
 // a*PredictionScores = predictedValue for regression
-TmlInteractionState * AllocateCoreInteraction(bool bRegression, IntegerDataType countAttributes, const EbmAttribute * attributes, IntegerDataType countTargetStates, IntegerDataType countCases, const void * targets, const IntegerDataType * data, const FractionalDataType * predictionScores) {
+TmlInteractionState * AllocateCoreInteraction(bool bRegression, IntegerDataType countAttributes, const EbmAttribute * attributes, IntegerDataType countTargetStates, IntegerDataType countCases, const void * targets, const EbmDataColumn * data, DataSetShared * pDataSetShared, const FractionalDataType * predictionScores) {
    EBM_ASSERT(0 <= countAttributes);
    EBM_ASSERT(0 == countAttributes || nullptr != attributes);
    EBM_ASSERT(bRegression && 0 == countTargetStates || !bRegression && (1 <= countTargetStates || 0 == countTargetStates && 0 == countCases));
@@ -149,6 +195,11 @@ TmlInteractionState * AllocateCoreInteraction(bool bRegression, IntegerDataType
    size_t cTargetStates = static_cast<size_t>(countTargetStates);
    size_t cCases = static_cast<size_t>(countCases);
 
+   if(IsDataColumnsError(cAttributes, data)) {
+      LOG(TraceLevelWarning, "WARNING AllocateCoreInteraction IsDataColumnsError(cAttributes, data)");
+      return nullptr;
+   }
+
    LOG(TraceLevelInfo, "Entered EbmInteractionState");
    TmlInteractionState * const pEbmInteractionState = new (std::nothrow) TmlInteractionState(bRegression, cTargetStates, cAttributes);
    LOG(TraceLevelInfo, "Exited EbmInteractionState %p", static_cast<void *>(pEbmInteractionState));
@@ -156,7 +207,7 @@ TmlInteractionState * AllocateCoreInteraction(bool bRegression, IntegerDataType
       LOG(TraceLevelWarning, "WARNING AllocateCoreInteraction nullptr == pEbmInteractionState");
       return nullptr;
    }
-   if(UNLIKELY(pEbmInteractionState->InitializeInteraction(attributes, cCases, targets, data, predictionScores))) {
+   if(UNLIKELY(pEbmInteractionState->InitializeInteraction(attributes, cCases, targets, data, pDataSetShared, predictionScores))) {
       LOG(TraceLevelWarning, "WARNING AllocateCoreInteraction pEbmInteractionState->InitializeInteraction");
       delete pEbmInteractionState;
       return nullptr;
@@ -164,63 +215,125 @@ TmlInteractionState * AllocateCoreInteraction(bool bRegression, IntegerDataType
    return pEbmInteractionState;
 }
 
+// our IntegerDataType matrix APIs are thin wrappers that describe each column of the Fortran ordered matrix with an EbmDataColumn
+static TmlInteractionState * AllocateCoreInteractionInt64(bool bRegression, IntegerDataType countAttributes, const EbmAttribute * attributes, IntegerDataType countTargetStates, IntegerDataType countCases, const void * targets, const IntegerDataType * data, const FractionalDataType * predictionScores) {
+   if(!IsNumberConvertable<size_t, IntegerDataType>(countAttributes)) {
+      LOG(TraceLevelWarning, "WARNING AllocateCoreInteractionInt64 !IsNumberConvertable<size_t, IntegerDataType>(countAttributes)");
+      return nullptr;
+   }
+   if(!IsNumberConvertable<size_t, IntegerDataType>(countCases)) {
+      LOG(TraceLevelWarning, "WARNING AllocateCoreInteractionInt64 !IsNumberConvertable<size_t, IntegerDataType>(countCases)");
+      return nullptr;
+   }
+   const size_t cAttributes = static_cast<size_t>(countAttributes);
+
+   EbmDataColumn * const aColumns = ConstructInt64DataColumns(cAttributes, static_cast<size_t>(countCases), data);
+   if(0 != cAttributes && nullptr != data && nullptr == aColumns) {
+      LOG(TraceLevelWarning, "WARNING AllocateCoreInteractionInt64 ConstructInt64DataColumns failed");
+      return nullptr;
+   }
+   TmlInteractionState * const pEbmInteractionState = AllocateCoreInteraction(bRegression, countAttributes, attributes, countTargetStates, countCases, targets, aColumns, nullptr, predictionScores);
+   free(aColumns);
+   return pEbmInteractionState;
+}
+
 EBMCORE_IMPORT_EXPORT PEbmInteraction EBMCORE_CALLING_CONVENTION InitializeInteractionRegression(IntegerDataType countAttributes, const EbmAttribute * attributes, IntegerDataType countCases, const FractionalDataType * targets, const IntegerDataType * data, const FractionalDataType * predictionScores) {
    LOG(TraceLevelInfo, "Entered InitializeInteractionRegression: countAttributes=%" IntegerDataTypePrintf ", attributes=%p, countCases=%" IntegerDataTypePrintf ", targets=%p, data=%p, predictionScores=%p", countAttributes, static_cast<const void *>(attributes), countCases, static_cast<const void *>(targets), static_cast<const void *>(data), static_cast<const void *>(predictionScores));
-   PEbmInteraction pEbmInteraction = reinterpret_cast<PEbmInteraction>(AllocateCoreInteraction(true, countAttributes, attributes, 0, countCases, targets, data, predictionScores));
+   PEbmInteraction pEbmInteraction = reinterpret_cast<PEbmInteraction>(AllocateCoreInteractionInt64(true, countAttributes, attributes, 0, countCases, targets, data, predictionScores));
    LOG(TraceLevelInfo, "Exited InitializeInteractionRegression %p", static_cast<void *>(pEbmInteraction));
    return pEbmInteraction;
 }
 
+EBMCORE_IMPORT_EXPORT PEbmInteraction EBMCORE_CALLING_CONVENTION InitializeInteractionRegressionColumns(IntegerDataType countAttributes, const EbmAttribute * attributes, IntegerDataType countCases, const FractionalDataType * targets, const EbmDataColumn * columns, const FractionalDataType * predictionScores) {
+   LOG(TraceLevelInfo, "Entered InitializeInteractionRegressionColumns: countAttributes=%" IntegerDataTypePrintf ", attributes=%p, countCases=%" IntegerDataTypePrintf ", targets=%p, columns=%p, predictionScores=%p", countAttributes, static_cast<const void *>(attributes), countCases, static_cast<const void *>(targets), static_cast<const void *>(columns), static_cast<const void *>(predictionScores));
+   PEbmInteraction pEbmInteraction = reinterpret_cast<PEbmInteraction>(AllocateCoreInteraction(true, countAttributes, attributes, 0, countCases, targets, columns, nullptr, predictionScores));
+   LOG(TraceLevelInfo, "Exited InitializeInteractionRegressionColumns %p", static_cast<void *>(pEbmInteraction));
+   return pEbmInteraction;
+}
+
 EBMCORE_IMPORT_EXPORT PEbmInteraction EBMCORE_CALLING_CONVENTION InitializeInteractionClassification(IntegerDataType countAttributes, const EbmAttribute * attributes, IntegerDataType countTargetStates, IntegerDataType countCases, const IntegerDataType * targets, const IntegerDataType * data, const FractionalDataType * predictionScores) {
    LOG(TraceLevelInfo, "Entered InitializeInteractionClassification: countAttributes=%" IntegerDataTypePrintf ", attributes=%p, countTargetStates=%" IntegerDataTypePrintf ", countCases=%" IntegerDataTypePrintf ", targets=%p, data=%p, predictionScores=%p", countAttributes, static_cast<const void *>(attributes), countTargetStates, countCases, static_cast<const void *>(targets), static_cast<const void *>(data), static_cast<const void *>(predictionScores));
-   PEbmInteraction pEbmInteraction = reinterpret_cast<PEbmInteraction>(AllocateCoreInteraction(false, countAttributes, attributes, countTargetStates, countCases, targets, data, predictionScores));
+   PEbmInteraction pEbmInteraction = reinterpret_cast<PEbmInteraction>(AllocateCoreInteractionInt64(false, countAttributes, attributes, countTargetStates, countCases, targets, data, predictionScores));
    LOG(TraceLevelInfo, "Exited InitializeInteractionClassification %p", static_cast<void *>(pEbmInteraction));
    return pEbmInteraction;
 }
 
-template<ptrdiff_t countCompilerClassificationTargetStates>
-static IntegerDataType GetInteractionScorePerTargetStates(TmlInteractionState * const pEbmInteractionState, const AttributeCombinationCore * const pAttributeCombination, FractionalDataType * const pInteractionScoreReturn) {
-   // TODO : be smarter about our CachedInteractionThreadResources, otherwise why have it?
-   CachedInteractionThreadResources * const pCachedThreadResources = new (std::nothrow) CachedInteractionThreadResources();
+EBMCORE_IMPORT_EXPORT PEbmInteraction EBMCORE_CALLING_CONVENTION InitializeInteractionClassificationColumns(IntegerDataType countAttributes, const EbmAttribute * attributes, IntegerDataType countTargetStates, IntegerDataType countCases, const IntegerDataType * targets, const EbmDataColumn * columns, const FractionalDataType * predictionScores) {
+   LOG(TraceLevelInfo, "Entered InitializeInteractionClassificationColumns: countAttributes=%" IntegerDataTypePrintf ", attributes=%p, countTargetStates=%" IntegerDataTypePrintf ", countCases=%" IntegerDataTypePrintf ", targets=%p, columns=%p, predictionScores=%p", countAttributes, static_cast<const void *>(attributes), countTargetStates, countCases, static_cast<const void *>(targets), static_cast<const void *>(columns), static_cast<const void *>(predictionScores));
+   PEbmInteraction pEbmInteraction = reinterpret_cast<PEbmInteraction>(AllocateCoreInteraction(false, countAttributes, attributes, countTargetStates, countCases, targets, columns, nullptr, predictionScores));
+   LOG(TraceLevelInfo, "Exited InitializeInteractionClassificationColumns %p", static_cast<void *>(pEbmInteraction));
+   return pEbmInteraction;
+}
+
+static TmlInteractionState * AllocateCoreInteractionFromDataSet(bool bRegression, PEbmDataSet dataSet, IntegerDataType countTargetStates, const void * targets, const FractionalDataType * predictionScores) {
+   DataSetShared * const pDataSetShared = reinterpret_cast<DataSetShared *>(dataSet);
+   if(nullptr == pDataSetShared) {
+      LOG(TraceLevelWarning, "WARNING AllocateCoreInteractionFromDataSet nullptr == pDataSetShared");
+      return nullptr;
+   }
+   // the dataset was allocated with these counts, so they fit into an IntegerDataType
+   EBM_ASSERT((IsNumberConvertable<IntegerDataType, size_t>(pDataSetShared->GetCountAttributes())));
+   EBM_ASSERT((IsNumberConvertable<IntegerDataType, size_t>(pDataSetShared->GetCountCases())));
+   return AllocateCoreInteraction(bRegression, static_cast<IntegerDataType>(pDataSetShared->GetCountAttributes()), pDataSetShared->GetAttributes(), countTargetStates, static_cast<IntegerDataType>(pDataSetShared->GetCountCases()), targets, pDataSetShared->GetColumns(), pDataSetShared, predictionScores);
+}
 
-   if(CalculateInteractionScore<countCompilerClassificationTargetStates, 0>(pEbmInteractionState->m_cTargetStates, pCachedThreadResources, pEbmInteractionState->m_pDataSet, pAttributeCombination, pInteractionScoreReturn)) {
-      delete pCachedThreadResources;
+EBMCORE_IMPORT_EXPORT PEbmInteraction EBMCORE_CALLING_CONVENTION InitializeInteractionRegressionFromDataSet(PEbmDataSet dataSet, const FractionalDataType * targets, const FractionalDataType * predictionScores) {
+   LOG(TraceLevelInfo, "Entered InitializeInteractionRegressionFromDataSet: dataSet=%p, targets=%p, predictionScores=%p", static_cast<void *>(dataSet), static_cast<const void *>(targets), static_cast<const void *>(predictionScores));
+   PEbmInteraction pEbmInteraction = reinterpret_cast<PEbmInteraction>(AllocateCoreInteractionFromDataSet(true, dataSet, 0, targets, predictionScores));
+   LOG(TraceLevelInfo, "Exited InitializeInteractionRegressionFromDataSet %p", static_cast<void *>(pEbmInteraction));
+   return pEbmInteraction;
+}
+
+EBMCORE_IMPORT_EXPORT PEbmInteraction EBMCORE_CALLING_CONVENTION InitializeInteractionClassificationFromDataSet(PEbmDataSet dataSet, IntegerDataType countTargetStates, const IntegerDataType * targets, const FractionalDataType * predictionScores) {
+   LOG(TraceLevelInfo, "Entered InitializeInteractionClassificationFromDataSet: dataSet=%p, countTargetStates=%" IntegerDataTypePrintf ", targets=%p, predictionScores=%p", static_cast<void *>(dataSet), countTargetStates, static_cast<const void *>(targets), static_cast<const void *>(predictionScores));
+   PEbmInteraction pEbmInteraction = reinterpret_cast<PEbmInteraction>(AllocateCoreInteractionFromDataSet(false, dataSet, countTargetStates, targets, predictionScores));
+   LOG(TraceLevelInfo, "Exited InitializeInteractionClassificationFromDataSet %p", static_cast<void *>(pEbmInteraction));
+   return pEbmInteraction;
+}
+
+template<ptrdiff_t countCompilerClassificationTargetStates>
+static IntegerDataType GetInteractionScoresPerTargetStates(const TmlInteractionState * const pEbmInteractionState, const DataSetInternalCore * const pDataSet, CachedInteractionThreadResources * const pCachedThreadResources, const size_t cAttributeCombinations, const AttributeCombinationCore * const * const apAttributeCombinations, FractionalDataType * const * const apInteractionScoresReturn) {
+   if(CalculateInteractionScores<countCompilerClassificationTargetStates>(pEbmInteractionState->m_cTargetStates, pCachedThreadResources, pDataSet, cAttributeCombinations, apAttributeCombinations, apInteractionScoresReturn)) {
       return 1;
    }
-   delete pCachedThreadResources;
    return 0;
 }
 
 template<ptrdiff_t iPossibleCompilerOptimizedTargetStates>
-TML_INLINE IntegerDataType CompilerRecursiveGetInteractionScore(const size_t cRuntimeTargetStates, TmlInteractionState * const pEbmInteractionState, const AttributeCombinationCore * const pAttributeCombination, FractionalDataType * const pInteractionScoreReturn) {
+TML_INLINE IntegerDataType CompilerRecursiveGetInteractionScores(const size_t cRuntimeTargetStates, const TmlInteractionState * const pEbmInteractionState, const DataSetInternalCore * const pDataSet, CachedInteractionThreadResources * const pCachedThreadResources, const size_t cAttributeCombinations, const AttributeCombinationCore * const * const apAttributeCombinations, FractionalDataType * const * const apInteractionScoresReturn) {
    EBM_ASSERT(IsClassification(iPossibleCompilerOptimizedTargetStates));
    if(cRuntimeTargetStates == iPossibleCompilerOptimizedTargetStates) {
       EBM_ASSERT(cRuntimeTargetStates <= k_cCompilerOptimizedTargetStatesMax);
-      return GetInteractionScorePerTargetStates<iPossibleCompilerOptimizedTargetStates>(pEbmInteractionState, pAttributeCombination, pInteractionScoreReturn);
+      return GetInteractionScoresPerTargetStates<iPossibleCompilerOptimizedTargetStates>(pEbmInteractionState, pDataSet, pCachedThreadResources, cAttributeCombinations, apAttributeCombinations, apInteractionScoresReturn);
    } else {
-      return CompilerRecursiveGetInteractionScore<iPossibleCompilerOptimizedTargetStates + 1>(cRuntimeTargetStates, pEbmInteractionState, pAttributeCombination, pInteractionScoreReturn);
+      return CompilerRecursiveGetInteractionScores<iPossibleCompilerOptimizedTargetStates + 1>(cRuntimeTargetStates, pEbmInteractionState, pDataSet, pCachedThreadResources, cAttributeCombinations, apAttributeCombinations, apInteractionScoresReturn);
    }
 }
 
 template<>
-TML_INLINE IntegerDataType CompilerRecursiveGetInteractionScore<k_cCompilerOptimizedTargetStatesMax + 1>(const size_t cRuntimeTargetStates, TmlInteractionState * const pEbmInteractionState, const AttributeCombinationCore * const pAttributeCombination, FractionalDataType * const pInteractionScoreReturn) {
+TML_INLINE IntegerDataType CompilerRecursiveGetInteractionScores<k_cCompilerOptimizedTargetStatesMax + 1>(const size_t cRuntimeTargetStates, const TmlInteractionState * const pEbmInteractionState, const DataSetInternalCore * const pDataSet, CachedInteractionThreadResources * const pCachedThreadResources, const size_t cAttributeCombinations, const AttributeCombinationCore * const * const apAttributeCombinations, FractionalDataType * const * const apInteractionScoresReturn) {
    UNUSED(cRuntimeTargetStates);
    // it is logically possible, but uninteresting to have a classification with 1 target state, so let our runtime system handle those unlikley and uninteresting cases
    EBM_ASSERT(k_cCompilerOptimizedTargetStatesMax < cRuntimeTargetStates);
-   return GetInteractionScorePerTargetStates<k_DynamicClassification>(pEbmInteractionState, pAttributeCombination, pInteractionScoreReturn);
+   return GetInteractionScoresPerTargetStates<k_DynamicClassification>(pEbmInteractionState, pDataSet, pCachedThreadResources, cAttributeCombinations, apAttributeCombinations, apInteractionScoresReturn);
 }
 
-// we made this a global because if we had put this variable inside the TmlInteractionState object, then we would need to dereference that before getting the count.  By making this global we can send a log message incase a bad TmlInteractionState object is sent into us
-// we only decrease the count if the count is non-zero, so at worst if there is a race condition then we'll output this log message more times than desired, but we can live with that
-static unsigned int g_cLogGetInteractionScoreParametersMessages = 10;
-
-EBMCORE_IMPORT_EXPORT IntegerDataType EBMCORE_CALLING_CONVENTION GetInteractionScore(PEbmInteraction ebmInteraction, IntegerDataType countAttributesInCombination, const IntegerDataType * attributeIndexes, FractionalDataType * interactionScoreReturn) {
-   LOG_COUNTED(&g_cLogGetInteractionScoreParametersMessages, TraceLevelInfo, TraceLevelVerbose, "GetInteractionScore parameters: ebmInteraction=%p, countAttributesInCombination=%" IntegerDataTypePrintf ", attributeIndexes=%p, interactionScoreReturn=%p", static_cast<void *>(ebmInteraction), countAttributesInCombination, static_cast<const void *>(attributeIndexes), static_cast<void *>(interactionScoreReturn));
-
-   EBM_ASSERT(nullptr != ebmInteraction);
-   TmlInteractionState * pEbmInteractionState = reinterpret_cast<TmlInteractionState *>(ebmInteraction);
+// scores attribute combinations that PrepareAttributeCombination has accepted against pDataSet, which is normally pEbmInteractionState->m_pDataSet but can
+// be a subsample of it.  It only reads pEbmInteractionState, so it can be called from multiple threads at once as long as each thread has its own pCachedThreadResources
+static IntegerDataType ScoreAttributeCombinations(const TmlInteractionState * const pEbmInteractionState, const DataSetInternalCore * const pDataSet, CachedInteractionThreadResources * const pCachedThreadResources, const size_t cAttributeCombinations, const AttributeCombinationCore * const * const apAttributeCombinations, FractionalDataType * const * const apInteractionScoresReturn) {
+   if(pEbmInteractionState->m_bRegression) {
+      return GetInteractionScoresPerTargetStates<k_Regression>(pEbmInteractionState, pDataSet, pCachedThreadResources, cAttributeCombinations, apAttributeCombinations, apInteractionScoresReturn);
+   } else {
+      EBM_ASSERT(2 <= pEbmInteractionState->m_cTargetStates); // PrepareAttributeCombination handles the other cases
+      return CompilerRecursiveGetInteractionScores<2>(pEbmInteractionState->m_cTargetStates, pEbmInteractionState, pDataSet, pCachedThreadResources, cAttributeCombinations, apAttributeCombinations, apInteractionScoresReturn);
+   }
+}
 
-   LOG_COUNTED(&pEbmInteractionState->m_cLogEnterMessages, TraceLevelInfo, TraceLevelVerbose, "Entered GetInteractionScore");
+// checks the attribute indexes that our caller gave us and fills in pAttributeCombination (which needs k_cBytesAttributeCombinationMax bytes).  Returns 1 on error.
+// If the interaction score is trivially zero (no cases, attributes with a single state, etc) we write the score ourselves and set *pbScored to true, otherwise
+// pAttributeCombination is ready for ScoreAttributeCombinations
+static IntegerDataType PrepareAttributeCombination(const TmlInteractionState * const pEbmInteractionState, const IntegerDataType countAttributesInCombination, const IntegerDataType * const attributeIndexes, AttributeCombinationCore * const pAttributeCombination, FractionalDataType * const interactionScoreReturn, bool * const pbScored) {
+   *pbScored = false;
 
    EBM_ASSERT(0 <= countAttributesInCombination);
    EBM_ASSERT(0 == countAttributesInCombination || nullptr != attributeIndexes);
@@ -236,15 +349,16 @@ EBMCORE_IMPORT_EXPORT IntegerDataType EBMCORE_CALLING_CONVENTION GetInteractionS
       if(nullptr != interactionScoreReturn) {
          *interactionScoreReturn = 0; // we return the lowest value possible for the interaction score, but we don't return an error since we handle it even though we'd prefer our caler be smarter about this condition
       }
+      *pbScored = true;
       return 0;
    }
-
    if(nullptr == pEbmInteractionState->m_pDataSet) {
       // if pEbmInteractionState->m_pDataSet is null, then we have a dataset with zero cases.  If there are zero data cases, there isn't much basis to say whether there are interactions, so just return zero
       LOG(TraceLevelError, "ERROR GetInteractionScore Our higher level caller should filter out dataset with zero cases");
       if(nullptr != interactionScoreReturn) {
          *interactionScoreReturn = 0; // we return the lowest value possible for the interaction score, but we don't return an error since we handle it even though we'd prefer our caler be smarter about this condition
       }
+      *pbScored = true;
       return 0;
    }
 
@@ -267,6 +381,7 @@ EBMCORE_IMPORT_EXPORT IntegerDataType EBMCORE_CALLING_CONVENTION GetInteractionS
          if(nullptr != interactionScoreReturn) {
             *interactionScoreReturn = 0; // we return the lowest value possible for the interaction score, but we don't return an error since we handle it even though we'd prefer our caler be smarter about this condition
          }
+         *pbScored = true;
          return 0;
       }
       ++pAttributeCombinationIndex;
@@ -278,9 +393,15 @@ EBMCORE_IMPORT_EXPORT IntegerDataType EBMCORE_CALLING_CONVENTION GetInteractionS
       return 1;
    }
 
-   // put the pAttributeCombination object on the stack. We want to put it into a AttributeCombinationCore object since we want to share code with training, which calls things like building the tensor totals (which is templated to be compiled many times)
-   char AttributeCombinationBuffer[k_cBytesAttributeCombinationMax];
-   AttributeCombinationCore * const pAttributeCombination = reinterpret_cast<AttributeCombinationCore *>(&AttributeCombinationBuffer);
+   if(!pEbmInteractionState->m_bRegression && pEbmInteractionState->m_cTargetStates <= 1) {
+      LOG(TraceLevelError, "ERROR GetInteractionScore Our higher level caller should filter out situations where there is only 0 OR 1 classification target ");
+      if(nullptr != interactionScoreReturn) {
+         *interactionScoreReturn = 0; // if there is only 1 classification target, then we can predict the outcome with 100% accuracy and there is no need for logits or interactions or anything else.  We return 0 since interactions have no benefit
+      }
+      *pbScored = true;
+      return 0;
+   }
+
    pAttributeCombination->Initialize(cAttributesInCombination, 0);
 
    pAttributeCombinationIndex = attributeIndexes; // restart from the start
@@ -299,29 +420,414 @@ EBMCORE_IMPORT_EXPORT IntegerDataType EBMCORE_CALLING_CONVENTION GetInteractionS
       ++pAttributeCombinationIndex;
    } while(pAttributeCombinationIndexEnd != pAttributeCombinationIndex);
 
-   IntegerDataType ret;
-   if(pEbmInteractionState->m_bRegression) {
-      ret = GetInteractionScorePerTargetStates<k_Regression>(pEbmInteractionState, pAttributeCombination, interactionScoreReturn);
-   } else {
-      const size_t cTargetStates = pEbmInteractionState->m_cTargetStates;
-      if(cTargetStates <= 1) {
-         LOG(TraceLevelError, "ERROR GetInteractionScore Our higher level caller should filter out situations where there is only 0 OR 1 classification target ");
-         if(nullptr != interactionScoreReturn) {
-            *interactionScoreReturn = 0; // if there is only 1 classification target, then we can predict the outcome with 100% accuracy and there is no need for logits or interactions or anything else.  We return 0 since interactions have no benefit
-         }
-         return 0;
-      }
-      ret = CompilerRecursiveGetInteractionScore<2>(cTargetStates, pEbmInteractionState, pAttributeCombination, interactionScoreReturn);
+   return 0;
+}
+
+EBMCORE_IMPORT_EXPORT IntegerDataType EBMCORE_CALLING_CONVENTION GetInteractionScore(PEbmInteraction ebmInteraction, IntegerDataType countAttributesInCombination, const IntegerDataType * attributeIndexes, FractionalDataType * interactionScoreReturn) {
+   // this function can be called from multiple threads at once, so we can't use LOG_COUNTED here since its counters aren't atomic.  Every message is verbose instead
+   LOG(TraceLevelVerbose, "GetInteractionScore parameters: ebmInteraction=%p, countAttributesInCombination=%" IntegerDataTypePrintf ", attributeIndexes=%p, interactionScoreReturn=%p", static_cast<void *>(ebmInteraction), countAttributesInCombination, static_cast<const void *>(attributeIndexes), static_cast<void *>(interactionScoreReturn));
+
+   EBM_ASSERT(nullptr != ebmInteraction);
+   TmlInteractionState * pEbmInteractionState = reinterpret_cast<TmlInteractionState *>(ebmInteraction);
+
+   LOG(TraceLevelVerbose, "Entered GetInteractionScore");
+
+   // our scratch space only allocates its buffers once we bin, so keeping it on the stack costs nothing for combinations that PrepareAttributeCombination rejects
+   CachedInteractionThreadResources cachedThreadResources;
+
+   // put the pAttributeCombination object on the stack. We want to put it into a AttributeCombinationCore object since we want to share code with training, which calls things like building the tensor totals (which is templated to be compiled many times)
+   char AttributeCombinationBuffer[k_cBytesAttributeCombinationMax];
+   AttributeCombinationCore * const pAttributeCombination = reinterpret_cast<AttributeCombinationCore *>(&AttributeCombinationBuffer);
+   bool bScored;
+   IntegerDataType ret = PrepareAttributeCombination(pEbmInteractionState, countAttributesInCombination, attributeIndexes, pAttributeCombination, interactionScoreReturn, &bScored);
+   if(0 == ret && !bScored) {
+      const AttributeCombinationCore * const apAttributeCombinations[1] = { pAttributeCombination };
+      FractionalDataType * const apInteractionScoresReturn[1] = { interactionScoreReturn };
+      ret = ScoreAttributeCombinations(pEbmInteractionState, pEbmInteractionState->m_pDataSet, &cachedThreadResources, 1, apAttributeCombinations, apInteractionScoresReturn);
    }
    if(0 != ret) {
       LOG(TraceLevelWarning, "WARNING GetInteractionScore returned %" IntegerDataTypePrintf, ret);
    }
    if(nullptr != interactionScoreReturn) {
       EBM_ASSERT(0 <= *interactionScoreReturn);
-      LOG_COUNTED(&pEbmInteractionState->m_cLogExitMessages, TraceLevelInfo, TraceLevelVerbose, "Exited GetInteractionScore %" FractionalDataTypePrintf, *interactionScoreReturn);
+      LOG(TraceLevelVerbose, "Exited GetInteractionScore %" FractionalDataTypePrintf, *interactionScoreReturn);
+   } else {
+      LOG(TraceLevelVerbose, "Exited GetInteractionScore");
+   }
+   return ret;
+}
+
+class InteractionScoresContext final {
+public:
+   const TmlInteractionState * const m_pEbmInteractionState;
+   const DataSetInternalCore * const m_pDataSet;
+   const size_t m_cAttributeCombinations;
+   const EbmAttributeCombination * const m_aAttributeCombinations;
+   // the start of each attribute combination's indexes within attributeCombinationIndexes, which we calculate up front since the combinations can differ in size
+   const IntegerDataType * const * const m_apAttributeCombinationIndexes;
+   FractionalDataType * const m_aInteractionScores;
+   const size_t m_cTasks;
+   // one per task
+   bool * const m_abError;
+
+   InteractionScoresContext(const TmlInteractionState * const pEbmInteractionState, const DataSetInternalCore * const pDataSet, const size_t cAttributeCombinations, const EbmAttributeCombination * const aAttributeCombinations, const IntegerDataType * const * const apAttributeCombinationIndexes, FractionalDataType * const aInteractionScores, const size_t cTasks, bool * const abError)
+      : m_pEbmInteractionState(pEbmInteractionState)
+      , m_pDataSet(pDataSet)
+      , m_cAttributeCombinations(cAttributeCombinations)
+      , m_aAttributeCombinations(aAttributeCombinations)
+      , m_apAttributeCombinationIndexes(apAttributeCombinationIndexes)
+      , m_aInteractionScores(aInteractionScores)
+      , m_cTasks(cTasks)
+      , m_abError(abError) {
+   }
+};
+
+static void InteractionScoresTask(void * const pContext, const size_t iTask) {
+   const InteractionScoresContext * const pInteractionScoresContext = static_cast<const InteractionScoresContext *>(pContext);
+   const TmlInteractionState * const pEbmInteractionState = pInteractionScoresContext->m_pEbmInteractionState;
+   CachedInteractionThreadResources * const pCachedThreadResources = pEbmInteractionState->m_apCachedThreadResources[iTask];
+
+   // we collect the attribute combinations that need real work into blocks so that CalculateInteractionScores can bin a whole block in a single pass over the data
+   static_assert(0 == k_cBytesAttributeCombinationMax % sizeof(size_t), "each AttributeCombinationCore in the block needs to stay aligned");
+   char * const aAttributeCombinationsBlock = static_cast<char *>(pCachedThreadResources->GetAttributeCombinationsBlock(k_cInteractionCombinationsPerBlockMax * k_cBytesAttributeCombinationMax));
+   if(UNLIKELY(nullptr == aAttributeCombinationsBlock)) {
+      LOG(TraceLevelWarning, "WARNING InteractionScoresTask nullptr == aAttributeCombinationsBlock");
+      pInteractionScoresContext->m_abError[iTask] = true;
+      return;
+   }
+   const AttributeCombinationCore * apAttributeCombinations[k_cInteractionCombinationsPerBlockMax];
+   FractionalDataType * apInteractionScoresReturn[k_cInteractionCombinationsPerBlockMax];
+   size_t cBlock = 0;
+
+   // we interleave the attribute combinations between the tasks instead of giving each task a contiguous range.  Callers usually enumerate pairs in order,
+   // so neighbouring combinations tend to have similar tensor sizes, and interleaving balances the work better.  Each score is independent of the others, so
+   // the number of tasks doesn't affect our results
+   bool bError = false;
+   for(size_t iAttributeCombination = iTask; iAttributeCombination < pInteractionScoresContext->m_cAttributeCombinations; iAttributeCombination += pInteractionScoresContext->m_cTasks) {
+      FractionalDataType * const pInteractionScoreReturn = &pInteractionScoresContext->m_aInteractionScores[iAttributeCombination];
+      AttributeCombinationCore * const pAttributeCombination = reinterpret_cast<AttributeCombinationCore *>(aAttributeCombinationsBlock + cBlock * k_cBytesAttributeCombinationMax);
+      bool bScored;
+      if(0 != PrepareAttributeCombination(pEbmInteractionState, pInteractionScoresContext->m_aAttributeCombinations[iAttributeCombination].countAttributesInCombination, pInteractionScoresContext->m_apAttributeCombinationIndexes[iAttributeCombination], pAttributeCombination, pInteractionScoreReturn, &bScored)) {
+         // keep going so that the other scores are still filled in, but remember that we failed
+         *pInteractionScoreReturn = 0;
+         bError = true;
+         continue;
+      }
+      if(bScored) {
+         continue;
+      }
+      apAttributeCombinations[cBlock] = pAttributeCombination;
+      apInteractionScoresReturn[cBlock] = pInteractionScoreReturn;
+      ++cBlock;
+      if(k_cInteractionCombinationsPerBlockMax == cBlock) {
+         if(0 != ScoreAttributeCombinations(pEbmInteractionState, pInteractionScoresContext->m_pDataSet, pCachedThreadResources, cBlock, apAttributeCombinations, apInteractionScoresReturn)) {
+            bError = true;
+         }
+         cBlock = 0;
+      }
+   }
+   if(0 != cBlock) {
+      if(0 != ScoreAttributeCombinations(pEbmInteractionState, pInteractionScoresContext->m_pDataSet, pCachedThreadResources, cBlock, apAttributeCombinations, apInteractionScoresReturn)) {
+         bError = true;
+      }
+   }
+   pInteractionScoresContext->m_abError[iTask] = bError;
+}
+
+// the attribute indexes for all our attribute combinations are packed together in attributeCombinationIndexes, but each combination can have a different number
+// of attributes, so we find where each combination's indexes start up front.  Returns nullptr on error, otherwise our caller needs to free the result
+static const IntegerDataType ** MakeAttributeCombinationIndexes(const size_t cAttributeCombinations, const EbmAttributeCombination * const aAttributeCombinations, const IntegerDataType * const attributeCombinationIndexes) {
+   EBM_ASSERT(1 <= cAttributeCombinations);
+   EBM_ASSERT(nullptr != aAttributeCombinations);
+
+   if(IsMultiplyError(sizeof(const IntegerDataType *), cAttributeCombinations)) {
+      LOG(TraceLevelWarning, "WARNING MakeAttributeCombinationIndexes IsMultiplyError(sizeof(const IntegerDataType *), cAttributeCombinations)");
+      return nullptr;
+   }
+   const IntegerDataType ** const apAttributeCombinationIndexes = static_cast<const IntegerDataType **>(malloc(sizeof(const IntegerDataType *) * cAttributeCombinations));
+   if(nullptr == apAttributeCombinationIndexes) {
+      LOG(TraceLevelWarning, "WARNING MakeAttributeCombinationIndexes nullptr == apAttributeCombinationIndexes");
+      return nullptr;
+   }
+   const IntegerDataType * pAttributeCombinationIndex = attributeCombinationIndexes;
+   for(size_t iAttributeCombination = 0; iAttributeCombination < cAttributeCombinations; ++iAttributeCombination) {
+      const IntegerDataType countAttributesInCombination = aAttributeCombinations[iAttributeCombination].countAttributesInCombination;
+      EBM_ASSERT(0 <= countAttributesInCombination);
+      if(!IsNumberConvertable<size_t, IntegerDataType>(countAttributesInCombination)) {
+         LOG(TraceLevelWarning, "WARNING MakeAttributeCombinationIndexes !IsNumberConvertable<size_t, IntegerDataType>(countAttributesInCombination)");
+         free(apAttributeCombinationIndexes);
+         return nullptr;
+      }
+      apAttributeCombinationIndexes[iAttributeCombination] = pAttributeCombinationIndex;
+      pAttributeCombinationIndex += static_cast<size_t>(countAttributesInCombination);
+   }
+   return apAttributeCombinationIndexes;
+}
+
+// scores every attribute combination against pDataSet in parallel and puts the results in aInteractionScoresReturn.  Returns 1 on error
+static IntegerDataType ScoreAttributeCombinationsParallel(TmlInteractionState * const pEbmInteractionState, const DataSetInternalCore * const pDataSet, const size_t cAttributeCombinations, const EbmAttributeCombination * const aAttributeCombinations, const IntegerDataType * const * const apAttributeCombinationIndexes, FractionalDataType * const aInteractionScoresReturn) {
+   EBM_ASSERT(1 <= cAttributeCombinations);
+
+   // unlike training, the scores don't get reduced together, so it's fine for the number of tasks to depend on the number of threads
+   const size_t cThreads = GetParallelThreadCount();
+   const size_t cTasks = cAttributeCombinations < cThreads ? cAttributeCombinations : cThreads;
+   EBM_ASSERT(1 <= cTasks);
+
+   bool * const abError = new (std::nothrow) bool[cTasks];
+   if(nullptr == abError || pEbmInteractionState->EnsureCachedThreadResources(cTasks)) {
+      LOG(TraceLevelWarning, "WARNING ScoreAttributeCombinationsParallel nullptr == abError || pEbmInteractionState->EnsureCachedThreadResources(cTasks)");
+      delete[] abError;
+      return 1;
+   }
+
+   InteractionScoresContext interactionScoresContext(pEbmInteractionState, pDataSet, cAttributeCombinations, aAttributeCombinations, apAttributeCombinationIndexes, aInteractionScoresReturn, cTasks, abError);
+   ExecuteParallel(cTasks, &InteractionScoresTask, &interactionScoresContext);
+
+   IntegerDataType ret = 0;
+   for(size_t iTask = 0; iTask < cTasks; ++iTask) {
+      if(abError[iTask]) {
+         ret = 1;
+      }
+   }
+   delete[] abError;
+   return ret;
+}
+
+EBMCORE_IMPORT_EXPORT IntegerDataType EBMCORE_CALLING_CONVENTION GetInteractionScores(PEbmInteraction ebmInteraction, IntegerDataType countAttributeCombinations, const EbmAttributeCombination * attributeCombinations, const IntegerDataType * attributeCombinationIndexes, FractionalDataType * interactionScoresReturn) {
+   LOG(TraceLevelInfo, "Entered GetInteractionScores: ebmInteraction=%p, countAttributeCombinations=%" IntegerDataTypePrintf ", attributeCombinations=%p, attributeCombinationIndexes=%p, interactionScoresReturn=%p", static_cast<void *>(ebmInteraction), countAttributeCombinations, static_cast<const void *>(attributeCombinations), static_cast<const void *>(attributeCombinationIndexes), static_cast<void *>(interactionScoresReturn));
+
+   EBM_ASSERT(nullptr != ebmInteraction);
+   TmlInteractionState * pEbmInteractionState = reinterpret_cast<TmlInteractionState *>(ebmInteraction);
+
+   EBM_ASSERT(0 <= countAttributeCombinations);
+   EBM_ASSERT(0 == countAttributeCombinations || nullptr != attributeCombinations);
+   EBM_ASSERT(0 == countAttributeCombinations || nullptr != interactionScoresReturn);
+
+   if(!IsNumberConvertable<size_t, IntegerDataType>(countAttributeCombinations)) {
+      LOG(TraceLevelWarning, "WARNING GetInteractionScores !IsNumberConvertable<size_t, IntegerDataType>(countAttributeCombinations)");
+      return 1;
+   }
+   const size_t cAttributeCombinations = static_cast<size_t>(countAttributeCombinations);
+   if(0 == cAttributeCombinations) {
+      LOG(TraceLevelInfo, "Exited GetInteractionScores no attribute combinations");
+      return 0;
+   }
+   if(nullptr == attributeCombinations || nullptr == interactionScoresReturn) {
+      LOG(TraceLevelWarning, "WARNING GetInteractionScores nullptr == attributeCombinations || nullptr == interactionScoresReturn");
+      return 1;
+   }
+
+   const IntegerDataType ** const apAttributeCombinationIndexes = MakeAttributeCombinationIndexes(cAttributeCombinations, attributeCombinations, attributeCombinationIndexes);
+   if(nullptr == apAttributeCombinationIndexes) {
+      LOG(TraceLevelWarning, "WARNING GetInteractionScores nullptr == apAttributeCombinationIndexes");
+      return 1;
+   }
+
+   const IntegerDataType ret = ScoreAttributeCombinationsParallel(pEbmInteractionState, pEbmInteractionState->m_pDataSet, cAttributeCombinations, attributeCombinations, apAttributeCombinationIndexes, interactionScoresReturn);
+   free(apAttributeCombinationIndexes);
+
+   if(0 != ret) {
+      LOG(TraceLevelWarning, "WARNING GetInteractionScores returned %" IntegerDataTypePrintf, ret);
+   }
+   LOG(TraceLevelInfo, "Exited GetInteractionScores");
+   return ret;
+}
+
+// picks cCasesSubsample distinct cases out of the full dataset and copies them into a new dataset.  We use selection sampling, which visits the cases in order and
+// keeps each one with probability (cases still needed) / (cases still available), so the subsample is uniform, keeps the original case order, and depends
+// only on randomSeed.  Returns nullptr on error
+static DataSetInternalCore * MakeScreeningDataSet(const TmlInteractionState * const pEbmInteractionState, const size_t cCasesSubsample, const IntegerDataType randomSeed) {
+   const DataSetInternalCore * const pDataSet = pEbmInteractionState->m_pDataSet;
+   EBM_ASSERT(nullptr != pDataSet);
+   const size_t cCases = pDataSet->GetCountCases();
+   EBM_ASSERT(1 <= cCasesSubsample);
+   EBM_ASSERT(cCasesSubsample < cCases);
+
+   if(IsMultiplyError(sizeof(size_t), cCasesSubsample)) {
+      LOG(TraceLevelWarning, "WARNING MakeScreeningDataSet IsMultiplyError(sizeof(size_t), cCasesSubsample)");
+      return nullptr;
+   }
+   size_t * const aiCases = static_cast<size_t *>(malloc(sizeof(size_t) * cCasesSubsample));
+   if(nullptr == aiCases) {
+      LOG(TraceLevelWarning, "WARNING MakeScreeningDataSet nullptr == aiCases");
+      return nullptr;
+   }
+
+   RandomStream randomStream(randomSeed);
+   size_t * piCase = aiCases;
+   size_t cCasesRemainingToSelect = cCasesSubsample;
+   for(size_t iCase = 0; 0 != cCasesRemainingToSelect; ++iCase) {
+      EBM_ASSERT(iCase < cCases);
+      const size_t cCasesRemaining = cCases - iCase;
+      if(randomStream.Next(cCasesRemaining - 1) < cCasesRemainingToSelect) {
+         *piCase = iCase;
+         ++piCase;
+         --cCasesRemainingToSelect;
+      }
+   }
+   EBM_ASSERT(aiCases + cCasesSubsample == piCase);
+
+   DataSetInternalCore * const pDataSetSubsample = new (std::nothrow) DataSetInternalCore(*pDataSet, GetVectorLengthFlatCore(pEbmInteractionState->m_cTargetStates), cCasesSubsample, aiCases);
+   free(aiCases);
+   if(nullptr == pDataSetSubsample || pDataSetSubsample->IsError()) {
+      LOG(TraceLevelWarning, "WARNING MakeScreeningDataSet nullptr == pDataSetSubsample || pDataSetSubsample->IsError()");
+      delete pDataSetSubsample;
+      return nullptr;
+   }
+   return pDataSetSubsample;
+}
+
+// orders the attribute combination indexes in aiAttributeCombinations so that the first cFirst items are the best ones in descending order of score.  Ties go
+// to the lower index so that our results don't depend on the sort implementation
+static void RankAttributeCombinations(const FractionalDataType * const aInteractionScores, const size_t cAttributeCombinations, size_t * const aiAttributeCombinations, const size_t cFirst) {
+   EBM_ASSERT(cFirst <= cAttributeCombinations);
+   std::partial_sort(aiAttributeCombinations, aiAttributeCombinations + cFirst, aiAttributeCombinations + cAttributeCombinations, [aInteractionScores](const size_t iLeft, const size_t iRight) {
+      return aInteractionScores[iRight] < aInteractionScores[iLeft] || aInteractionScores[iRight] == aInteractionScores[iLeft] && iLeft < iRight;
+   });
+}
+
+EBMCORE_IMPORT_EXPORT IntegerDataType EBMCORE_CALLING_CONVENTION GetInteractionScoresScreened(PEbmInteraction ebmInteraction, IntegerDataType countAttributeCombinations, const EbmAttributeCombination * attributeCombinations, const IntegerDataType * attributeCombinationIndexes, IntegerDataType countCasesScreening, FractionalDataType oversamplingFactor, IntegerDataType randomSeed, IntegerDataType countTopAttributeCombinations, IntegerDataType * topAttributeCombinationsReturn, FractionalDataType * topInteractionScoresReturn) {
+   LOG(TraceLevelInfo, "Entered GetInteractionScoresScreened: ebmInteraction=%p, countAttributeCombinations=%" IntegerDataTypePrintf ", attributeCombinations=%p, attributeCombinationIndexes=%p, countCasesScreening=%" IntegerDataTypePrintf ", oversamplingFactor=%" FractionalDataTypePrintf ", randomSeed=%" IntegerDataTypePrintf ", countTopAttributeCombinations=%" IntegerDataTypePrintf ", topAttributeCombinationsReturn=%p, topInteractionScoresReturn=%p", static_cast<void *>(ebmInteraction), countAttributeCombinations, static_cast<const void *>(attributeCombinations), static_cast<const void *>(attributeCombinationIndexes), countCasesScreening, oversamplingFactor, randomSeed, countTopAttributeCombinations, static_cast<void *>(topAttributeCombinationsReturn), static_cast<void *>(topInteractionScoresReturn));
+
+   EBM_ASSERT(nullptr != ebmInteraction);
+   TmlInteractionState * pEbmInteractionState = reinterpret_cast<TmlInteractionState *>(ebmInteraction);
+
+   EBM_ASSERT(0 <= countAttributeCombinations);
+   EBM_ASSERT(0 == countAttributeCombinations || nullptr != attributeCombinations);
+   EBM_ASSERT(0 <= countCasesScreening);
+   EBM_ASSERT(0 <= countTopAttributeCombinations);
+   EBM_ASSERT(0 == countTopAttributeCombinations || nullptr != topAttributeCombinationsReturn);
+   // topInteractionScoresReturn can be nullptr
+
+   if(!IsNumberConvertable<size_t, IntegerDataType>(countAttributeCombinations)) {
+      LOG(TraceLevelWarning, "WARNING GetInteractionScoresScreened !IsNumberConvertable<size_t, IntegerDataType>(countAttributeCombinations)");
+      return 1;
+   }
+   if(!IsNumberConvertable<size_t, IntegerDataType>(countCasesScreening)) {
+      LOG(TraceLevelWarning, "WARNING GetInteractionScoresScreened !IsNumberConvertable<size_t, IntegerDataType>(countCasesScreening)");
+      return 1;
+   }
+   if(!IsNumberConvertable<size_t, IntegerDataType>(countTopAttributeCombinations)) {
+      LOG(TraceLevelWarning, "WARNING GetInteractionScoresScreened !IsNumberConvertable<size_t, IntegerDataType>(countTopAttributeCombinations)");
+      return 1;
+   }
+   const size_t cAttributeCombinations = static_cast<size_t>(countAttributeCombinations);
+   const size_t cCasesScreening = static_cast<size_t>(countCasesScreening);
+   // we can't return more attribute combinations than we were given
+   const size_t cTop = cAttributeCombinations < static_cast<size_t>(countTopAttributeCombinations) ? cAttributeCombinations : static_cast<size_t>(countTopAttributeCombinations);
+   if(0 == cTop) {
+      LOG(TraceLevelInfo, "Exited GetInteractionScoresScreened no attribute combinations");
+      return 0;
+   }
+   if(nullptr == attributeCombinations || nullptr == topAttributeCombinationsReturn) {
+      LOG(TraceLevelWarning, "WARNING GetInteractionScoresScreened nullptr == attributeCombinations || nullptr == topAttributeCombinationsReturn");
+      return 1;
+   }
+
+   // we rescore cTop * oversamplingFactor candidates on the full data.  Anything below 1 (including NaN) would give us fewer candidates than we need to return,
+   // so we treat it as 1
+   size_t cCandidates = cAttributeCombinations;
+   if(oversamplingFactor < FractionalDataType { 1 } || std::isnan(oversamplingFactor)) {
+      cCandidates = cTop;
    } else {
-      LOG_COUNTED(&pEbmInteractionState->m_cLogExitMessages, TraceLevelInfo, TraceLevelVerbose, "Exited GetInteractionScore");
+      const FractionalDataType cCandidatesFractional = std::ceil(static_cast<FractionalDataType>(cTop) * oversamplingFactor);
+      if(cCandidatesFractional < static_cast<FractionalDataType>(cAttributeCombinations)) {
+         cCandidates = static_cast<size_t>(cCandidatesFractional);
+      }
+   }
+   EBM_ASSERT(cTop <= cCandidates);
+   EBM_ASSERT(cCandidates <= cAttributeCombinations);
+
+   const DataSetInternalCore * const pDataSet = pEbmInteractionState->m_pDataSet;
+   // screening only helps if we'd rescore fewer combinations than we started with on a dataset that is really smaller than the full one.  Otherwise we just score
+   // everything exactly, which gives the same answer that screening would converge to
+   const bool bScreen = cCandidates < cAttributeCombinations && 0 != cCasesScreening && nullptr != pDataSet && cCasesScreening < pDataSet->GetCountCases();
+   if(!bScreen) {
+      cCandidates = cAttributeCombinations;
+   }
+
+   const IntegerDataType ** const apAttributeCombinationIndexes = MakeAttributeCombinationIndexes(cAttributeCombinations, attributeCombinations, attributeCombinationIndexes);
+   if(nullptr == apAttributeCombinationIndexes) {
+      LOG(TraceLevelWarning, "WARNING GetInteractionScoresScreened nullptr == apAttributeCombinationIndexes");
+      return 1;
+   }
+   if(IsMultiplyError(sizeof(FractionalDataType), cAttributeCombinations) || IsMultiplyError(sizeof(size_t), cAttributeCombinations) || IsMultiplyError(sizeof(EbmAttributeCombination), cAttributeCombinations)) {
+      // cCandidates <= cAttributeCombinations, so these checks cover the candidate arrays too
+      LOG(TraceLevelWarning, "WARNING GetInteractionScoresScreened IsMultiplyError");
+      free(apAttributeCombinationIndexes);
+      return 1;
+   }
+   FractionalDataType * const aInteractionScores = static_cast<FractionalDataType *>(malloc(sizeof(FractionalDataType) * cAttributeCombinations));
+   size_t * const aiAttributeCombinations = static_cast<size_t *>(malloc(sizeof(size_t) * cAttributeCombinations));
+   // the candidates that survive screening are packed together so that we can score them with the normal batch code
+   EbmAttributeCombination * const aCandidateAttributeCombinations = static_cast<EbmAttributeCombination *>(malloc(sizeof(EbmAttributeCombination) * cCandidates));
+   const IntegerDataType ** const apCandidateAttributeCombinationIndexes = static_cast<const IntegerDataType **>(malloc(sizeof(const IntegerDataType *) * cCandidates));
+   FractionalDataType * const aCandidateInteractionScores = static_cast<FractionalDataType *>(malloc(sizeof(FractionalDataType) * cCandidates));
+
+   IntegerDataType ret = 1;
+   if(nullptr == aInteractionScores || nullptr == aiAttributeCombinations || nullptr == aCandidateAttributeCombinations || nullptr == apCandidateAttributeCombinationIndexes || nullptr == aCandidateInteractionScores) {
+      LOG(TraceLevelWarning, "WARNING GetInteractionScoresScreened out of memory");
+      goto exit_free;
+   }
+   for(size_t iAttributeCombination = 0; iAttributeCombination < cAttributeCombinations; ++iAttributeCombination) {
+      aiAttributeCombinations[iAttributeCombination] = iAttributeCombination;
+   }
+
+   if(bScreen) {
+      // stage 1: score every attribute combination on a subsample and keep the best cCandidates of them
+      LOG(TraceLevelInfo, "GetInteractionScoresScreened screening %zu attribute combinations down to %zu", cAttributeCombinations, cCandidates);
+      DataSetInternalCore * const pDataSetScreening = MakeScreeningDataSet(pEbmInteractionState, cCasesScreening, randomSeed);
+      if(nullptr == pDataSetScreening) {
+         LOG(TraceLevelWarning, "WARNING GetInteractionScoresScreened nullptr == pDataSetScreening");
+         goto exit_free;
+      }
+      const IntegerDataType retScreening = ScoreAttributeCombinationsParallel(pEbmInteractionState, pDataSetScreening, cAttributeCombinations, attributeCombinations, apAttributeCombinationIndexes, aInteractionScores);
+      delete pDataSetScreening;
+      if(0 != retScreening) {
+         LOG(TraceLevelWarning, "WARNING GetInteractionScoresScreened ScoreAttributeCombinationsParallel screening");
+         goto exit_free;
+      }
+      RankAttributeCombinations(aInteractionScores, cAttributeCombinations, aiAttributeCombinations, cCandidates);
+   }
+
+   // stage 2: score the candidates exactly on the full data
+   for(size_t iCandidate = 0; iCandidate < cCandidates; ++iCandidate) {
+      const size_t iAttributeCombination = aiAttributeCombinations[iCandidate];
+      aCandidateAttributeCombinations[iCandidate] = attributeCombinations[iAttributeCombination];
+      apCandidateAttributeCombinationIndexes[iCandidate] = apAttributeCombinationIndexes[iAttributeCombination];
+   }
+   if(0 != ScoreAttributeCombinationsParallel(pEbmInteractionState, pDataSet, cCandidates, aCandidateAttributeCombinations, apCandidateAttributeCombinationIndexes, aCandidateInteractionScores)) {
+      LOG(TraceLevelWarning, "WARNING GetInteractionScoresScreened ScoreAttributeCombinationsParallel");
+      goto exit_free;
+   }
+   // the screening scores of the candidates are replaced by their exact scores, and only the candidates take part in the final ranking
+   for(size_t iCandidate = 0; iCandidate < cCandidates; ++iCandidate) {
+      aInteractionScores[aiAttributeCombinations[iCandidate]] = aCandidateInteractionScores[iCandidate];
+   }
+   RankAttributeCombinations(aInteractionScores, cCandidates, aiAttributeCombinations, cTop);
+
+   for(size_t iTop = 0; iTop < cTop; ++iTop) {
+      const size_t iAttributeCombination = aiAttributeCombinations[iTop];
+      EBM_ASSERT((IsNumberConvertable<IntegerDataType, size_t>(iAttributeCombination))); // our caller gave us countAttributeCombinations as an IntegerDataType
+      topAttributeCombinationsReturn[iTop] = static_cast<IntegerDataType>(iAttributeCombination);
+      if(nullptr != topInteractionScoresReturn) {
+         topInteractionScoresReturn[iTop] = aInteractionScores[iAttributeCombination];
+      }
+   }
+   ret = 0;
+
+exit_free:
+   free(aCandidateInteractionScores);
+   free(apCandidateAttributeCombinationIndexes);
+   free(aCandidateAttributeCombinations);
+   free(aiAttributeCombinations);
+   free(aInteractionScores);
+   free(apAttributeCombinationIndexes);
+
+   if(0 != ret) {
+      LOG(TraceLevelWarning, "WARNING GetInteractionScoresScreened returned %" IntegerDataTypePrintf, ret);
    }
+   LOG(TraceLevelInfo, "Exited GetInteractionScoresScreened");
    return ret;
 }
 
@@ -384,8 +384,9 @@ struct FastTotalState {
    size_t cStates;
 };
 
+// we're forced inline so that BuildFastTotalsSimd can compile us for each instruction set
 template<ptrdiff_t countCompilerClassificationTargetStates, size_t countCompilerDimensions>
-void BuildFastTotals(BinnedBucket<IsRegression(countCompilerClassificationTargetStates)> * const aBinnedBuckets, const size_t cTargetStates, const AttributeCombinationCore * const pAttributeCombination, BinnedBucket<IsRegression(countCompilerClassificationTargetStates)> * pBucketAuxiliaryBuildZone
+TML_INLINE void BuildFastTotals(BinnedBucket<IsRegression(countCompilerClassificationTargetStates)> * const aBinnedBuckets, const size_t cTargetStates, const AttributeCombinationCore * const pAttributeCombination, BinnedBucket<IsRegression(countCompilerClassificationTargetStates)> * pBucketAuxiliaryBuildZone
 #ifndef NDEBUG
    , const BinnedBucket<IsRegression(countCompilerClassificationTargetStates)> * const aBinnedBucketsDebugCopy, const unsigned char * const aBinnedBucketsEndDebug
 #endif // NDEBUG
@@ -499,6 +500,14 @@ void BuildFastTotals(BinnedBucket<IsRegression(countCompilerClassificationTarget
    }
 }
 
+template<ptrdiff_t countCompilerClassificationTargetStates, size_t countCompilerDimensions>
+struct BuildFastTotalsSimd final {
+   template<typename... TArgs>
+   TML_INLINE static void Run(const TArgs... args) {
+      BuildFastTotals<countCompilerClassificationTargetStates, countCompilerDimensions>(args...);
+   }
+};
+
 
 struct CurrentIndexAndCountStates {
    ptrdiff_t multipliedIndexCur;
@@ -697,8 +706,11 @@ struct TotalsDimension {
    size_t cLast;
 };
 
+// we're called inside the sweeps over every cut, so we're forced inline into them and get compiled for the same instruction set as our caller.  Our
+// caller fills in pTensorStrides once for the whole sweep.  With a compile time number of dimensions, and the constant direction vectors that our
+// callers pass us, the loops below over the dimensions unroll completely
 template<ptrdiff_t countCompilerClassificationTargetStates, size_t countCompilerDimensions>
-void GetTotals(const BinnedBucket<IsRegression(countCompilerClassificationTargetStates)> * const aBinnedBuckets, const AttributeCombinationCore * const pAttributeCombination, const size_t * const aiPoint, const size_t directionVector, const size_t cTargetStates, BinnedBucket<IsRegression(countCompilerClassificationTargetStates)> * const pRet
+TML_INLINE void GetTotals(const BinnedBucket<IsRegression(countCompilerClassificationTargetStates)> * const aBinnedBuckets, const AttributeCombinationCore * const pAttributeCombination, const TensorStrides<countCompilerDimensions> * const pTensorStrides, const size_t * const aiPoint, const size_t directionVector, const size_t cTargetStates, BinnedBucket<IsRegression(countCompilerClassificationTargetStates)> * const pRet
 #ifndef NDEBUG
    , const BinnedBucket<IsRegression(countCompilerClassificationTargetStates)> * const aBinnedBucketsDebugCopy, const unsigned char * const aBinnedBucketsEndDebug
 #endif // NDEBUG
@@ -706,36 +718,25 @@ void GetTotals(const BinnedBucket<IsRegression(countCompilerClassificationTarget
    // don't LOG this!  It would create way too much chatter!
 
    static_assert(k_cDimensionsMax < k_cBitsForSizeTCore, "reserve the highest bit for bit manipulation space");
-   const size_t cDimensions = GET_ATTRIBUTE_COMBINATION_DIMENSIONS(countCompilerDimensions, pAttributeCombination->m_cAttributes);
+   const size_t cDimensions = pTensorStrides->GetCountDimensions();
+   EBM_ASSERT(cDimensions == pAttributeCombination->m_cAttributes);
    EBM_ASSERT(1 <= cDimensions);
    EBM_ASSERT(cDimensions < k_cBitsForSizeTCore);
+   UNUSED(pAttributeCombination); // we only use this in debug builds
 
    const size_t cVectorLength = GET_VECTOR_LENGTH(countCompilerClassificationTargetStates, cTargetStates);
    EBM_ASSERT(!GetBinnedBucketSizeOverflow<IsRegression(countCompilerClassificationTargetStates)>(cVectorLength)); // we're accessing allocated memory
    const size_t cBytesPerBinnedBucket = GetBinnedBucketSize<IsRegression(countCompilerClassificationTargetStates)>(cVectorLength);
 
-   size_t multipleTotalInitialize = 1;
    size_t startingOffset = 0;
-   const AttributeCombinationCore::AttributeCombinationEntry * pAttributeCombinationEntry = &pAttributeCombination->m_AttributeCombinationEntry[0];
-   const AttributeCombinationCore::AttributeCombinationEntry * const pAttributeCombinationEntryEnd = &pAttributeCombination->m_AttributeCombinationEntry[cDimensions];
-   const size_t * piPointInitialize = aiPoint;
 
    if(0 == directionVector) {
       // we would require a check in our inner loop below to handle the case of zero AttributeCombinationEntry items, so let's handle it separetly here instead
-      EBM_ASSERT(1 <= cDimensions);
-      do {
-         size_t cStates = pAttributeCombinationEntry->m_pAttribute->m_cStates;
-         EBM_ASSERT(1 <= cStates); // this function can handle 1 == cStates even though that's a degenerate case that shouldn't be trained on (dimensions with 1 state don't contribute anything since they always have the same value)
-         EBM_ASSERT(*piPointInitialize < cStates);
-         EBM_ASSERT(!IsMultiplyError(*piPointInitialize, multipleTotalInitialize)); // we're accessing allocated memory, so this needs to multiply
-         size_t addValue = multipleTotalInitialize * (*piPointInitialize);
-         EBM_ASSERT(!IsAddError(startingOffset, addValue)); // we're accessing allocated memory, so this needs to add
-         startingOffset += addValue;
-         EBM_ASSERT(!IsMultiplyError(cStates, multipleTotalInitialize)); // we're accessing allocated memory, so this needs to multiply
-         multipleTotalInitialize *= cStates;
-         ++pAttributeCombinationEntry;
-         ++piPointInitialize;
-      } while(LIKELY(pAttributeCombinationEntryEnd != pAttributeCombinationEntry));
+      for(size_t iDimension = 0; iDimension < cDimensions; ++iDimension) {
+         EBM_ASSERT(aiPoint[iDimension] < pTensorStrides->GetCountStates(iDimension));
+         // the tensor was allocated, so none of these can overflow
+         startingOffset += pTensorStrides->GetStride(iDimension) * aiPoint[iDimension];
+      }
       const BinnedBucket<IsRegression(countCompilerClassificationTargetStates)> * const pBinnedBucket = GetBinnedBucketByIndex<IsRegression(countCompilerClassificationTargetStates)>(cBytesPerBinnedBucket, aBinnedBuckets, startingOffset);
       ASSERT_BINNED_BUCKET_OK(cBytesPerBinnedBucket, pRet, aBinnedBucketsEndDebug);
       ASSERT_BINNED_BUCKET_OK(cBytesPerBinnedBucket, pBinnedBucket, aBinnedBucketsEndDebug);
@@ -753,33 +754,21 @@ void GetTotals(const BinnedBucket<IsRegression(countCompilerClassificationTarget
    //   }
    //}
 
-   TotalsDimension totalsDimension[k_cDimensionsMax];
+   TotalsDimension totalsDimension[countCompilerDimensions <= 0 ? k_cDimensionsMax : countCompilerDimensions];
    TotalsDimension * pTotalsDimensionEnd = totalsDimension;
-   {
-      size_t directionVectorDestroy = directionVector;
-      EBM_ASSERT(0 < cDimensions);
-      do {
-         size_t cStates = pAttributeCombinationEntry->m_pAttribute->m_cStates;
-         EBM_ASSERT(1 <= cStates); // this function can handle 1 == cStates even though that's a degenerate case that shouldn't be trained on (dimensions with 1 state don't contribute anything since they always have the same value)
-         if(UNPREDICTABLE(0 != (1 & directionVectorDestroy))) {
-            EBM_ASSERT(!IsMultiplyError(cStates - 1, multipleTotalInitialize)); // we're accessing allocated memory, so this needs to multiply
-            size_t cLast = multipleTotalInitialize * (cStates - 1);
-            EBM_ASSERT(!IsMultiplyError(*piPointInitialize, multipleTotalInitialize)); // we're accessing allocated memory, so this needs to multiply
-            pTotalsDimensionEnd->cIncrement = multipleTotalInitialize * (*piPointInitialize);
-            pTotalsDimensionEnd->cLast = cLast;
-            multipleTotalInitialize += cLast;
-            ++pTotalsDimensionEnd;
-         } else {
-            EBM_ASSERT(!IsMultiplyError(*piPointInitialize, multipleTotalInitialize)); // we're accessing allocated memory, so this needs to multiply
-            size_t addValue = multipleTotalInitialize * (*piPointInitialize);
-            EBM_ASSERT(!IsAddError(startingOffset, addValue)); // we're accessing allocated memory, so this needs to add
-            startingOffset += addValue;
-            multipleTotalInitialize *= cStates;
-         }
-         ++pAttributeCombinationEntry;
-         ++piPointInitialize;
-         directionVectorDestroy >>= 1;
-      } while(LIKELY(pAttributeCombinationEntryEnd != pAttributeCombinationEntry));
+   for(size_t iDimension = 0; iDimension < cDimensions; ++iDimension) {
+      const size_t cStates = pTensorStrides->GetCountStates(iDimension);
+      const size_t cStride = pTensorStrides->GetStride(iDimension);
+      EBM_ASSERT(1 <= cStates); // this function can handle 1 == cStates even though that's a degenerate case that shouldn't be trained on (dimensions with 1 state don't contribute anything since they always have the same value)
+      EBM_ASSERT(aiPoint[iDimension] < cStates);
+      // the tensor was allocated, so none of these can overflow
+      if(UNPREDICTABLE(0 != (1 & (directionVector >> iDimension)))) {
+         pTotalsDimensionEnd->cIncrement = cStride * aiPoint[iDimension];
+         pTotalsDimensionEnd->cLast = cStride * (cStates - 1);
+         ++pTotalsDimensionEnd;
+      } else {
+         startingOffset += cStride * aiPoint[iDimension];
+      }
    }
    const unsigned int cAllBits = static_cast<unsigned int>(pTotalsDimensionEnd - totalsDimension);
    EBM_ASSERT(cAllBits < k_cBitsForSizeTCore);
@@ -819,8 +808,9 @@ void GetTotals(const BinnedBucket<IsRegression(countCompilerClassificationTarget
 #endif // NDEBUG
 }
 
+// we're forced inline so that SweepMultiDiemensionalSimd can compile us for each instruction set
 template<ptrdiff_t countCompilerClassificationTargetStates, size_t countCompilerDimensions>
-FractionalDataType SweepMultiDiemensional(const BinnedBucket<IsRegression(countCompilerClassificationTargetStates)> * const aBinnedBuckets, const AttributeCombinationCore * const pAttributeCombination, size_t * const aiPoint, const size_t directionVectorLow, const unsigned int iDimensionSweep, const size_t cTargetStates, BinnedBucket<IsRegression(countCompilerClassificationTargetStates)> * const pBinnedBucketBestAndTemp, size_t * const piBestCut
+TML_INLINE FractionalDataType SweepMultiDiemensional(const BinnedBucket<IsRegression(countCompilerClassificationTargetStates)> * const aBinnedBuckets, const AttributeCombinationCore * const pAttributeCombination, size_t * const aiPoint, const size_t directionVectorLow, const unsigned int iDimensionSweep, const size_t cTargetStates, BinnedBucket<IsRegression(countCompilerClassificationTargetStates)> * const pBinnedBucketBestAndTemp, size_t * const piBestCut
 #ifndef NDEBUG
    , const BinnedBucket<IsRegression(countCompilerClassificationTargetStates)> * const aBinnedBucketsDebugCopy, const unsigned char * const aBinnedBucketsEndDebug
 #endif // NDEBUG
@@ -843,7 +833,10 @@ FractionalDataType SweepMultiDiemensional(const BinnedBucket<IsRegression(countC
    *piPoint = 0;
    size_t directionVectorHigh = directionVectorLow | size_t { 1 } << iDimensionSweep;
 
-   const size_t cStates = pAttributeCombination->m_AttributeCombinationEntry[iDimensionSweep].m_pAttribute->m_cStates;
+   TensorStrides<countCompilerDimensions> tensorStrides;
+   tensorStrides.Initialize(pAttributeCombination);
+
+   const size_t cStates = tensorStrides.GetCountStates(iDimensionSweep);
    EBM_ASSERT(2 <= cStates);
 
    size_t iBestCut = 0;
@@ -859,13 +852,13 @@ FractionalDataType SweepMultiDiemensional(const BinnedBucket<IsRegression(countC
    do {
       *piPoint = iState;
 
-      GetTotals<countCompilerClassificationTargetStates, countCompilerDimensions>(aBinnedBuckets, pAttributeCombination, aiPoint, directionVectorLow, cTargetStates, pTotalsLow
+      GetTotals<countCompilerClassificationTargetStates, countCompilerDimensions>(aBinnedBuckets, pAttributeCombination, &tensorStrides, aiPoint, directionVectorLow, cTargetStates, pTotalsLow
 #ifndef NDEBUG
          , aBinnedBucketsDebugCopy, aBinnedBucketsEndDebug
 #endif // NDEBUG
       );
 
-      GetTotals<countCompilerClassificationTargetStates, countCompilerDimensions>(aBinnedBuckets, pAttributeCombination, aiPoint, directionVectorHigh, cTargetStates, pTotalsHigh
+      GetTotals<countCompilerClassificationTargetStates, countCompilerDimensions>(aBinnedBuckets, pAttributeCombination, &tensorStrides, aiPoint, directionVectorHigh, cTargetStates, pTotalsHigh
 #ifndef NDEBUG
          , aBinnedBucketsDebugCopy, aBinnedBucketsEndDebug
 #endif // NDEBUG
@@ -894,34 +887,53 @@ FractionalDataType SweepMultiDiemensional(const BinnedBucket<IsRegression(countC
    return bestSplit;
 }
 
+template<ptrdiff_t countCompilerClassificationTargetStates, size_t countCompilerDimensions>
+struct SweepMultiDiemensionalSimd final {
+   template<typename... TArgs>
+   TML_INLINE static FractionalDataType Run(const TArgs... args) {
+      return SweepMultiDiemensional<countCompilerClassificationTargetStates, countCompilerDimensions>(args...);
+   }
+};
+
+// SweepMultiDiemensional needs 4 auxillary buckets PAST the pointer we pass into it, and we pass in index 20 at max, so splitting needs 24
+constexpr size_t k_cAuxillaryBucketsForSplitting = 24;
+
+// the auxillary buckets that TrainMultiDimensional puts after the main histogram space.  BuildFastTotals and splitting use the same auxillary buckets, so we need
+// whichever of the two is larger.  EstimateMemoryUsage calls this too, so that its histogram sizes match ours
+TML_INLINE static size_t GetAuxiliaryBucketCount(const AttributeCombinationCore * const pAttributeCombination) {
+   size_t cAuxillaryBucketsForBuildFastTotals = 0;
+   size_t cTotalBucketsMainSpace = 1;
+   for(size_t iDimension = 0; iDimension < pAttributeCombination->m_cAttributes; ++iDimension) {
+      // each dimension has at least 2 states, so cAuxillaryBucketsForBuildFastTotals stays below cTotalBucketsMainSpace, which we checked at allocation doesn't overflow
+      cAuxillaryBucketsForBuildFastTotals += cTotalBucketsMainSpace;
+      cTotalBucketsMainSpace *= pAttributeCombination->m_AttributeCombinationEntry[iDimension].m_pAttribute->m_cStates;
+   }
+   return cAuxillaryBucketsForBuildFastTotals < k_cAuxillaryBucketsForSplitting ? k_cAuxillaryBucketsForSplitting : cAuxillaryBucketsForBuildFastTotals;
+}
+
 WARNING_PUSH
 WARNING_DISABLE_UNINITIALIZED_LOCAL_VARIABLE
 
 // TODO: consider adding controls to disallow cuts that would leave too few cases in a region
 // TODO: for higher dimensional spaces, we need to add/subtract individual cells alot and the denominator isn't required in order to make decisions about where to cut.  For dimensions higher than 2, we might want to copy the tensor to a new tensor AFTER binning that keeps only the residuals and then go back to our original tensor after splits to determine the denominator
 // TODO: do we really require countCompilerDimensions here?  Does it make any of the code below faster... or alternatively, should we puth the distinction down into a sub-function
+// if aBinnedBucketsPreBinned is not nullptr, then it holds our already binned main space (from BinDataSetTrainingFusedParallel) and we copy it instead of binning
 template<ptrdiff_t countCompilerClassificationTargetStates, size_t countCompilerDimensions>
-bool TrainMultiDimensional(CachedTrainingThreadResources<IsRegression(countCompilerClassificationTargetStates)> * const pCachedThreadResources, const SamplingMethod * const pTrainingSet, const AttributeCombinationCore * const pAttributeCombination, SegmentedRegionCore<ActiveDataType, FractionalDataType> * const pSmallChangeToModelOverwriteSingleSamplingSet, const size_t cTargetStates) {
+bool TrainMultiDimensional(CachedTrainingThreadResources<IsRegression(countCompilerClassificationTargetStates)> * const pCachedThreadResources, const SamplingMethod * const pTrainingSet, const AttributeCombinationCore * const pAttributeCombination, SegmentedRegionCore<ActiveDataType, FractionalDataType> * const pSmallChangeToModelOverwriteSingleSamplingSet, const size_t cTargetStates, const BinnedBucket<IsRegression(countCompilerClassificationTargetStates)> * const aBinnedBucketsPreBinned) {
    LOG(TraceLevelVerbose, "Entered TrainMultiDimensional");
 
    // TODO: we can just re-generate this code 63 times and eliminate the dynamic cDimensions value.  We can also do this in several other places like for SegmentedRegion and other critical places
    const size_t cDimensions = GET_ATTRIBUTE_COMBINATION_DIMENSIONS(countCompilerDimensions, pAttributeCombination->m_cAttributes);
    EBM_ASSERT(2 <= cDimensions);
 
-   size_t cAuxillaryBucketsForBuildFastTotals = 0;
    size_t cTotalBucketsMainSpace = 1;
    for(size_t iDimension = 0; iDimension < cDimensions; ++iDimension) {
       const size_t cStates = pAttributeCombination->m_AttributeCombinationEntry[iDimension].m_pAttribute->m_cStates;
-      EBM_ASSERT(2 <= cStates); // we filer out 1 == cStates in allocation.  If cStates could be 1, then we'd need to check at runtime for overflow of cAuxillaryBucketsForBuildFastTotals
-      EBM_ASSERT(cAuxillaryBucketsForBuildFastTotals < cTotalBucketsMainSpace); // if this wasn't true then we'd have to check IsAddError(cAuxillaryBucketsForBuildFastTotals, cTotalBucketsMainSpace) at runtime
-      EBM_ASSERT(!IsAddError(cAuxillaryBucketsForBuildFastTotals, cTotalBucketsMainSpace)); // since cStates must be 2 or more, cAuxillaryBucketsForBuildFastTotals must grow slower than cTotalBucketsMainSpace, and we checked at allocation that cTotalBucketsMainSpace would not overflow
-      cAuxillaryBucketsForBuildFastTotals += cTotalBucketsMainSpace;
+      EBM_ASSERT(2 <= cStates); // we filer out 1 == cStates in allocation.  If cStates could be 1, then GetAuxiliaryBucketCount would need to check at runtime for overflow
       EBM_ASSERT(!IsMultiplyError(cTotalBucketsMainSpace, cStates)); // we check for simple multiplication overflow from m_cStates in TmlTrainingState->Initialize when we unpack attributeCombinationIndexes
       cTotalBucketsMainSpace *= cStates;
-      EBM_ASSERT(cAuxillaryBucketsForBuildFastTotals < cTotalBucketsMainSpace); // if this wasn't true then we'd have to check IsAddError(cAuxillaryBucketsForBuildFastTotals, cTotalBucketsMainSpace) at runtime
    }
-   const size_t cAuxillaryBucketsForSplitting = 24; // we need to reserve 4 PAST the pointer we pass into SweepMultiDiemensional!!!!.  We pass in index 20 at max, so we need 24
-   const size_t cAuxillaryBuckets = cAuxillaryBucketsForBuildFastTotals < cAuxillaryBucketsForSplitting ? cAuxillaryBucketsForSplitting : cAuxillaryBucketsForBuildFastTotals;
+   const size_t cAuxillaryBuckets = GetAuxiliaryBucketCount(pAttributeCombination);
    if(IsAddError(cTotalBucketsMainSpace, cAuxillaryBuckets)) {
       LOG(TraceLevelWarning, "WARNING TrainMultiDimensional IsAddError(cTotalBucketsMainSpace, cAuxillaryBuckets)");
       return true;
@@ -953,11 +965,20 @@ bool TrainMultiDimensional(CachedTrainingThreadResources<IsRegression(countCompi
    const unsigned char * const aBinnedBucketsEndDebug = reinterpret_cast<unsigned char *>(aBinnedBuckets) + cBytesBuffer;
 #endif // NDEBUG
 
-   RecursiveBinDataSetTraining<countCompilerClassificationTargetStates, 2>::Recursive(cDimensions, aBinnedBuckets, pAttributeCombination, pTrainingSet, cTargetStates
+   if(nullptr != aBinnedBucketsPreBinned) {
+      // BuildFastTotals modifies our histogram, so we need our own copy.  The auxillary buckets were zeroed above
+      memcpy(aBinnedBuckets, aBinnedBucketsPreBinned, cTotalBucketsMainSpace * cBytesPerBinnedBucket);
+   } else {
+      // the auxillary buckets aren't touched by binning, so we only need to bin (and merge) the main space
+      if(BinDataSetTrainingParallel<countCompilerClassificationTargetStates>(pCachedThreadResources, aBinnedBuckets, cTotalBucketsMainSpace, pAttributeCombination, pTrainingSet, cTargetStates
 #ifndef NDEBUG
-      , aBinnedBucketsEndDebug
+         , aBinnedBucketsEndDebug
 #endif // NDEBUG
-   );
+      )) {
+         LOG(TraceLevelWarning, "WARNING TrainMultiDimensional BinDataSetTrainingParallel failed");
+         return true;
+      }
+   }
 
 #ifndef NDEBUG
    // make a copy of the original binned buckets for debugging purposes
@@ -976,7 +997,7 @@ bool TrainMultiDimensional(CachedTrainingThreadResources<IsRegression(countCompi
    }
 #endif // NDEBUG
 
-   BuildFastTotals<countCompilerClassificationTargetStates, countCompilerDimensions>(aBinnedBuckets, cTargetStates, pAttributeCombination, pAuxiliaryBucketZone
+   RunSimdVariant<BuildFastTotalsSimd<countCompilerClassificationTargetStates, countCompilerDimensions>>(aBinnedBuckets, cTargetStates, pAttributeCombination, pAuxiliaryBucketZone
 #ifndef NDEBUG
       , aBinnedBucketsDebugCopy, aBinnedBucketsEndDebug
 #endif // NDEBUG
@@ -1114,7 +1135,7 @@ bool TrainMultiDimensional(CachedTrainingThreadResources<IsRegression(countCompi
          size_t cutSecond1LowBest;
          BinnedBucket<IsRegression(countCompilerClassificationTargetStates)> * pTotals2LowLowBest = GetBinnedBucketByIndex<IsRegression(countCompilerClassificationTargetStates)>(cBytesPerBinnedBucket, pAuxiliaryBucketZone, 4);
          BinnedBucket<IsRegression(countCompilerClassificationTargetStates)> * pTotals2LowHighBest = GetBinnedBucketByIndex<IsRegression(countCompilerClassificationTargetStates)>(cBytesPerBinnedBucket, pAuxiliaryBucketZone, 5);
-         splittingScore += SweepMultiDiemensional<countCompilerClassificationTargetStates, countCompilerDimensions>(aBinnedBuckets, pAttributeCombination, aiStart, 0x0, 1, cTargetStates, pTotals2LowLowBest, &cutSecond1LowBest
+         splittingScore += RunSimdVariant<SweepMultiDiemensionalSimd<countCompilerClassificationTargetStates, countCompilerDimensions>>(aBinnedBuckets, pAttributeCombination, aiStart, 0x0, 1, cTargetStates, pTotals2LowLowBest, &cutSecond1LowBest
 #ifndef NDEBUG
             , aBinnedBucketsDebugCopy, aBinnedBucketsEndDebug
 #endif // NDEBUG
@@ -1124,7 +1145,7 @@ bool TrainMultiDimensional(CachedTrainingThreadResources<IsRegression(countCompi
          size_t cutSecond1HighBest;
          BinnedBucket<IsRegression(countCompilerClassificationTargetStates)> * pTotals2HighLowBest = GetBinnedBucketByIndex<IsRegression(countCompilerClassificationTargetStates)>(cBytesPerBinnedBucket, pAuxiliaryBucketZone, 8);
          BinnedBucket<IsRegression(countCompilerClassificationTargetStates)> * pTotals2HighHighBest = GetBinnedBucketByIndex<IsRegression(countCompilerClassificationTargetStates)>(cBytesPerBinnedBucket, pAuxiliaryBucketZone, 9);
-         splittingScore += SweepMultiDiemensional<countCompilerClassificationTargetStates, countCompilerDimensions>(aBinnedBuckets, pAttributeCombination, aiStart, 0x1, 1, cTargetStates, pTotals2HighLowBest, &cutSecond1HighBest
+         splittingScore += RunSimdVariant<SweepMultiDiemensionalSimd<countCompilerClassificationTargetStates, countCompilerDimensions>>(aBinnedBuckets, pAttributeCombination, aiStart, 0x1, 1, cTargetStates, pTotals2HighLowBest, &cutSecond1HighBest
 #ifndef NDEBUG
             , aBinnedBucketsDebugCopy, aBinnedBucketsEndDebug
 #endif // NDEBUG
@@ -1166,7 +1187,7 @@ bool TrainMultiDimensional(CachedTrainingThreadResources<IsRegression(countCompi
          size_t cutSecond2LowBest;
          BinnedBucket<IsRegression(countCompilerClassificationTargetStates)> * pTotals1LowLowBestInner = GetBinnedBucketByIndex<IsRegression(countCompilerClassificationTargetStates)>(cBytesPerBinnedBucket, pAuxiliaryBucketZone, 16);
          BinnedBucket<IsRegression(countCompilerClassificationTargetStates)> * pTotals1LowHighBestInner = GetBinnedBucketByIndex<IsRegression(countCompilerClassificationTargetStates)>(cBytesPerBinnedBucket, pAuxiliaryBucketZone, 17);
-         splittingScore += SweepMultiDiemensional<countCompilerClassificationTargetStates, countCompilerDimensions>(aBinnedBuckets, pAttributeCombination, aiStart, 0x0, 0, cTargetStates, pTotals1LowLowBestInner, &cutSecond2LowBest
+         splittingScore += RunSimdVariant<SweepMultiDiemensionalSimd<countCompilerClassificationTargetStates, countCompilerDimensions>>(aBinnedBuckets, pAttributeCombination, aiStart, 0x0, 0, cTargetStates, pTotals1LowLowBestInner, &cutSecond2LowBest
 #ifndef NDEBUG
             , aBinnedBucketsDebugCopy, aBinnedBucketsEndDebug
 #endif // NDEBUG
@@ -1176,7 +1197,7 @@ bool TrainMultiDimensional(CachedTrainingThreadResources<IsRegression(countCompi
          size_t cutSecond2HighBest;
          BinnedBucket<IsRegression(countCompilerClassificationTargetStates)> * pTotals1HighLowBestInner = GetBinnedBucketByIndex<IsRegression(countCompilerClassificationTargetStates)>(cBytesPerBinnedBucket, pAuxiliaryBucketZone, 20);
          BinnedBucket<IsRegression(countCompilerClassificationTargetStates)> * pTotals1HighHighBestInner = GetBinnedBucketByIndex<IsRegression(countCompilerClassificationTargetStates)>(cBytesPerBinnedBucket, pAuxiliaryBucketZone, 21);
-         splittingScore += SweepMultiDiemensional<countCompilerClassificationTargetStates, countCompilerDimensions>(aBinnedBuckets, pAttributeCombination, aiStart, 0x2, 0, cTargetStates, pTotals1HighLowBestInner, &cutSecond2HighBest
+         splittingScore += RunSimdVariant<SweepMultiDiemensionalSimd<countCompilerClassificationTargetStates, countCompilerDimensions>>(aBinnedBuckets, pAttributeCombination, aiStart, 0x2, 0, cTargetStates, pTotals1HighLowBestInner, &cutSecond2HighBest
 #ifndef NDEBUG
             , aBinnedBucketsDebugCopy, aBinnedBucketsEndDebug
 #endif // NDEBUG
@@ -1432,6 +1453,14 @@ bool TrainMultiDimensional(CachedTrainingThreadResources<IsRegression(countCompi
 }
 WARNING_POP
 
+template<ptrdiff_t countCompilerClassificationTargetStates, size_t countCompilerDimensions>
+struct TrainMultiDimensionalDimensions final {
+   template<typename... TArgs>
+   TML_INLINE static bool Run(const TArgs... args) {
+      return TrainMultiDimensional<countCompilerClassificationTargetStates, countCompilerDimensions>(args...);
+   }
+};
+
 //template<ptrdiff_t countCompilerClassificationTargetStates, size_t countCompilerDimensions>
 //bool TrainMultiDimensionalPaulAlgorithm(CachedThreadResources<IsRegression(countCompilerClassificationTargetStates)> * const pCachedThreadResources, const AttributeInternal * const pTargetAttribute, SamplingMethod const * const pTrainingSet, const AttributeCombinationCore * const pAttributeCombination, SegmentedRegion<ActiveDataType, FractionalDataType> * const pSmallChangeToModelOverwriteSingleSamplingSet) {
 //   BinnedBucket<IsRegression(countCompilerClassificationTargetStates)> * const aBinnedBuckets = BinDataSet<countCompilerClassificationTargetStates>(pCachedThreadResources, pAttributeCombination, pTrainingSet, pTargetAttribute);
@@ -1710,8 +1739,97 @@ WARNING_POP
 
 
 
+// returns the best score over every pair of cuts for a pair of attributes.  BuildFastTotals needs to have already turned aBinnedBuckets into totals, and
+// pAuxiliaryBucketZone needs to have room for 4 buckets.  We're forced inline so that SweepInteractionPairSimd can compile us for each instruction set
+template<ptrdiff_t countCompilerClassificationTargetStates, size_t countCompilerDimensions>
+TML_INLINE FractionalDataType SweepInteractionPair(const BinnedBucket<IsRegression(countCompilerClassificationTargetStates)> * const aBinnedBuckets, const AttributeCombinationCore * const pAttributeCombination, const size_t cTargetStates, BinnedBucket<IsRegression(countCompilerClassificationTargetStates)> * const pAuxiliaryBucketZone
+#ifndef NDEBUG
+   , const BinnedBucket<IsRegression(countCompilerClassificationTargetStates)> * const aBinnedBucketsDebugCopy, const unsigned char * const aBinnedBucketsEndDebug
+#endif // NDEBUG
+) {
+   EBM_ASSERT(2 == pAttributeCombination->m_cAttributes);
+
+   const size_t cVectorLength = GET_VECTOR_LENGTH(countCompilerClassificationTargetStates, cTargetStates);
+   EBM_ASSERT(!GetBinnedBucketSizeOverflow<IsRegression(countCompilerClassificationTargetStates)>(cVectorLength)); // we're accessing allocated memory
+   const size_t cBytesPerBinnedBucket = GetBinnedBucketSize<IsRegression(countCompilerClassificationTargetStates)>(cVectorLength);
+
+   size_t aiStart[k_cDimensionsMax];
+
+   BinnedBucket<IsRegression(countCompilerClassificationTargetStates)> * pTotalsLowLow = GetBinnedBucketByIndex<IsRegression(countCompilerClassificationTargetStates)>(cBytesPerBinnedBucket, pAuxiliaryBucketZone, 0);
+   BinnedBucket<IsRegression(countCompilerClassificationTargetStates)> * pTotalsLowHigh = GetBinnedBucketByIndex<IsRegression(countCompilerClassificationTargetStates)>(cBytesPerBinnedBucket, pAuxiliaryBucketZone, 1);
+   BinnedBucket<IsRegression(countCompilerClassificationTargetStates)> * pTotalsHighLow = GetBinnedBucketByIndex<IsRegression(countCompilerClassificationTargetStates)>(cBytesPerBinnedBucket, pAuxiliaryBucketZone, 2);
+   BinnedBucket<IsRegression(countCompilerClassificationTargetStates)> * pTotalsHighHigh = GetBinnedBucketByIndex<IsRegression(countCompilerClassificationTargetStates)>(cBytesPerBinnedBucket, pAuxiliaryBucketZone, 3);
+
+   TensorStrides<countCompilerDimensions> tensorStrides;
+   tensorStrides.Initialize(pAttributeCombination);
+
+   const size_t cStatesDimension1 = tensorStrides.GetCountStates(0);
+   const size_t cStatesDimension2 = tensorStrides.GetCountStates(1);
+   EBM_ASSERT(1 <= cStatesDimension1); // this function can handle 1 == cStates even though that's a degenerate case that shouldn't be trained on (dimensions with 1 state don't contribute anything since they always have the same value)
+   EBM_ASSERT(1 <= cStatesDimension2); // this function can handle 1 == cStates even though that's a degenerate case that shouldn't be trained on (dimensions with 1 state don't contribute anything since they always have the same value)
+
+   FractionalDataType bestSplittingScore = FractionalDataType { -std::numeric_limits<FractionalDataType>::infinity() };
+
+   // note : if cStatesDimension1 can be 1 then we can't use a do loop
+   for(size_t iState1 = 0; iState1 < cStatesDimension1 - 1; ++iState1) {
+      aiStart[0] = iState1;
+      // note : if cStatesDimension2 can be 1 then we can't use a do loop
+      for(size_t iState2 = 0; iState2 < cStatesDimension2 - 1; ++iState2) {
+         aiStart[1] = iState2;
+
+         GetTotals<countCompilerClassificationTargetStates, countCompilerDimensions>(aBinnedBuckets, pAttributeCombination, &tensorStrides, aiStart, 0x00, cTargetStates, pTotalsLowLow
+#ifndef NDEBUG
+            , aBinnedBucketsDebugCopy, aBinnedBucketsEndDebug
+#endif // NDEBUG
+            );
+
+         GetTotals<countCompilerClassificationTargetStates, countCompilerDimensions>(aBinnedBuckets, pAttributeCombination, &tensorStrides, aiStart, 0x02, cTargetStates, pTotalsLowHigh
+#ifndef NDEBUG
+            , aBinnedBucketsDebugCopy, aBinnedBucketsEndDebug
+#endif // NDEBUG
+            );
+
+         GetTotals<countCompilerClassificationTargetStates, countCompilerDimensions>(aBinnedBuckets, pAttributeCombination, &tensorStrides, aiStart, 0x01, cTargetStates, pTotalsHighLow
+#ifndef NDEBUG
+            , aBinnedBucketsDebugCopy, aBinnedBucketsEndDebug
+#endif // NDEBUG
+            );
+
+         GetTotals<countCompilerClassificationTargetStates, countCompilerDimensions>(aBinnedBuckets, pAttributeCombination, &tensorStrides, aiStart, 0x03, cTargetStates, pTotalsHighHigh
+#ifndef NDEBUG
+            , aBinnedBucketsDebugCopy, aBinnedBucketsEndDebug
+#endif // NDEBUG
+            );
+
+         FractionalDataType splittingScore = 0;
+         for(size_t iVector = 0; iVector < cVectorLength; ++iVector) {
+            splittingScore += 0 == pTotalsLowLow->cCasesInBucket ? 0 : EbmStatistics::ComputeNodeSplittingScore(pTotalsLowLow->aPredictionStatistics[iVector].sumResidualError, pTotalsLowLow->cCasesInBucket);
+            splittingScore += 0 == pTotalsLowHigh->cCasesInBucket ? 0 : EbmStatistics::ComputeNodeSplittingScore(pTotalsLowHigh->aPredictionStatistics[iVector].sumResidualError, pTotalsLowHigh->cCasesInBucket);
+            splittingScore += 0 == pTotalsHighLow->cCasesInBucket ? 0 : EbmStatistics::ComputeNodeSplittingScore(pTotalsHighLow->aPredictionStatistics[iVector].sumResidualError, pTotalsHighLow->cCasesInBucket);
+            splittingScore += 0 == pTotalsHighHigh->cCasesInBucket ? 0 : EbmStatistics::ComputeNodeSplittingScore(pTotalsHighHigh->aPredictionStatistics[iVector].sumResidualError, pTotalsHighHigh->cCasesInBucket);
+            EBM_ASSERT(0 <= splittingScore);
+         }
+         EBM_ASSERT(0 <= splittingScore);
+
+         if(bestSplittingScore < splittingScore) {
+            bestSplittingScore = splittingScore;
+         }
+      }
+   }
+   return bestSplittingScore;
+}
+
 template<ptrdiff_t countCompilerClassificationTargetStates, size_t countCompilerDimensions>
-bool CalculateInteractionScore(const size_t cTargetStates, CachedInteractionThreadResources * const pCachedThreadResources, const DataSetInternalCore * const pDataSet, const AttributeCombinationCore * const pAttributeCombination, FractionalDataType * const pInteractionScoreReturn) {
+struct SweepInteractionPairSimd final {
+   template<typename... TArgs>
+   TML_INLINE static FractionalDataType Run(const TArgs... args) {
+      return SweepInteractionPair<countCompilerClassificationTargetStates, countCompilerDimensions>(args...);
+   }
+};
+
+// if aBinnedBucketsPreBinned is not nullptr, then it holds our already binned main space (from BinDataSetInteractionTiled) and we copy it instead of binning
+template<ptrdiff_t countCompilerClassificationTargetStates, size_t countCompilerDimensions>
+bool CalculateInteractionScore(const size_t cTargetStates, CachedInteractionThreadResources * const pCachedThreadResources, const DataSetInternalCore * const pDataSet, const AttributeCombinationCore * const pAttributeCombination, FractionalDataType * const pInteractionScoreReturn, const BinnedBucket<IsRegression(countCompilerClassificationTargetStates)> * const aBinnedBucketsPreBinned) {
    // TODO : we NEVER use the denominator term when calculating interaction scores, but we're calculating it and it's taking precious memory.  We should eliminate the denominator term HERE in our datastructures!!!
 
    LOG(TraceLevelVerbose, "Entered CalculateInteractionScore");
@@ -1776,12 +1894,16 @@ bool CalculateInteractionScore(const size_t cTargetStates, CachedInteractionThre
 
    // TODO : we don't seem to use the denmoninator in PredictionStatistics, so we could remove that variable for classification
    
-   // TODO : use the fancy recursive binner that we use in the training version of this function
-   BinDataSetInteraction<countCompilerClassificationTargetStates>(aBinnedBuckets, pAttributeCombination, pDataSet, cTargetStates
+   if(nullptr != aBinnedBucketsPreBinned) {
+      // BuildFastTotals modifies our histogram, so we need our own copy.  The auxillary buckets were zeroed above
+      memcpy(aBinnedBuckets, aBinnedBucketsPreBinned, cTotalBucketsMainSpace * cBytesPerBinnedBucket);
+   } else {
+      RunSimdVariant<BinDataSetInteractionSimd<countCompilerClassificationTargetStates, countCompilerDimensions>>(aBinnedBuckets, pAttributeCombination, pDataSet, cTargetStates
 #ifndef NDEBUG
-      , aBinnedBucketsEndDebug
+         , aBinnedBucketsEndDebug
 #endif // NDEBUG
-      );
+         );
+   }
 
 #ifndef NDEBUG
    // make a copy of the original binned buckets for debugging purposes
@@ -1800,74 +1922,20 @@ bool CalculateInteractionScore(const size_t cTargetStates, CachedInteractionThre
    }
 #endif // NDEBUG
 
-   BuildFastTotals<countCompilerClassificationTargetStates, countCompilerDimensions>(aBinnedBuckets, cTargetStates, pAttributeCombination, pAuxiliaryBucketZone
+   RunSimdVariant<BuildFastTotalsSimd<countCompilerClassificationTargetStates, countCompilerDimensions>>(aBinnedBuckets, cTargetStates, pAttributeCombination, pAuxiliaryBucketZone
 #ifndef NDEBUG
       , aBinnedBucketsDebugCopy, aBinnedBucketsEndDebug
 #endif // NDEBUG
       );
 
-   size_t aiStart[k_cDimensionsMax];
-
    if(2 == cDimensions) {
-      BinnedBucket<IsRegression(countCompilerClassificationTargetStates)> * pTotalsLowLow = GetBinnedBucketByIndex<IsRegression(countCompilerClassificationTargetStates)>(cBytesPerBinnedBucket, pAuxiliaryBucketZone, 0);
-      BinnedBucket<IsRegression(countCompilerClassificationTargetStates)> * pTotalsLowHigh = GetBinnedBucketByIndex<IsRegression(countCompilerClassificationTargetStates)>(cBytesPerBinnedBucket, pAuxiliaryBucketZone, 1);
-      BinnedBucket<IsRegression(countCompilerClassificationTargetStates)> * pTotalsHighLow = GetBinnedBucketByIndex<IsRegression(countCompilerClassificationTargetStates)>(cBytesPerBinnedBucket, pAuxiliaryBucketZone, 2);
-      BinnedBucket<IsRegression(countCompilerClassificationTargetStates)> * pTotalsHighHigh = GetBinnedBucketByIndex<IsRegression(countCompilerClassificationTargetStates)>(cBytesPerBinnedBucket, pAuxiliaryBucketZone, 3);
-
-      const size_t cStatesDimension1 = pAttributeCombination->m_AttributeCombinationEntry[0].m_pAttribute->m_cStates;
-      const size_t cStatesDimension2 = pAttributeCombination->m_AttributeCombinationEntry[1].m_pAttribute->m_cStates;
-      EBM_ASSERT(1 <= cStatesDimension1); // this function can handle 1 == cStates even though that's a degenerate case that shouldn't be trained on (dimensions with 1 state don't contribute anything since they always have the same value)
-      EBM_ASSERT(1 <= cStatesDimension2); // this function can handle 1 == cStates even though that's a degenerate case that shouldn't be trained on (dimensions with 1 state don't contribute anything since they always have the same value)
-
-      FractionalDataType bestSplittingScore = FractionalDataType { -std::numeric_limits<FractionalDataType>::infinity() };
-
       LOG(TraceLevelVerbose, "CalculateInteractionScore Starting state sweep loop");
-      // note : if cStatesDimension1 can be 1 then we can't use a do loop
-      for(size_t iState1 = 0; iState1 < cStatesDimension1 - 1; ++iState1) {
-         aiStart[0] = iState1;
-         // note : if cStatesDimension2 can be 1 then we can't use a do loop
-         for(size_t iState2 = 0; iState2 < cStatesDimension2 - 1; ++iState2) {
-            aiStart[1] = iState2;
-
-            GetTotals<countCompilerClassificationTargetStates, countCompilerDimensions>(aBinnedBuckets, pAttributeCombination, aiStart, 0x00, cTargetStates, pTotalsLowLow
-#ifndef NDEBUG
-               , aBinnedBucketsDebugCopy, aBinnedBucketsEndDebug
-#endif // NDEBUG
-               );
-
-            GetTotals<countCompilerClassificationTargetStates, countCompilerDimensions>(aBinnedBuckets, pAttributeCombination, aiStart, 0x02, cTargetStates, pTotalsLowHigh
-#ifndef NDEBUG
-               , aBinnedBucketsDebugCopy, aBinnedBucketsEndDebug
-#endif // NDEBUG
-               );
-
-            GetTotals<countCompilerClassificationTargetStates, countCompilerDimensions>(aBinnedBuckets, pAttributeCombination, aiStart, 0x01, cTargetStates, pTotalsHighLow
-#ifndef NDEBUG
-               , aBinnedBucketsDebugCopy, aBinnedBucketsEndDebug
-#endif // NDEBUG
-               );
-
-            GetTotals<countCompilerClassificationTargetStates, countCompilerDimensions>(aBinnedBuckets, pAttributeCombination, aiStart, 0x03, cTargetStates, pTotalsHighHigh
+      // we only get here for pairs, so the sweep can always use the pair specialization even if we were called with the runtime number of dimensions
+      const FractionalDataType bestSplittingScore = RunSimdVariant<SweepInteractionPairSimd<countCompilerClassificationTargetStates, 2>>(aBinnedBuckets, pAttributeCombination, cTargetStates, pAuxiliaryBucketZone
 #ifndef NDEBUG
-               , aBinnedBucketsDebugCopy, aBinnedBucketsEndDebug
+         , aBinnedBucketsDebugCopy, aBinnedBucketsEndDebug
 #endif // NDEBUG
-               );
-
-            FractionalDataType splittingScore = 0;
-            for(size_t iVector = 0; iVector < cVectorLength; ++iVector) {
-               splittingScore += 0 == pTotalsLowLow->cCasesInBucket ? 0 : EbmStatistics::ComputeNodeSplittingScore(pTotalsLowLow->aPredictionStatistics[iVector].sumResidualError, pTotalsLowLow->cCasesInBucket);
-               splittingScore += 0 == pTotalsLowHigh->cCasesInBucket ? 0 : EbmStatistics::ComputeNodeSplittingScore(pTotalsLowHigh->aPredictionStatistics[iVector].sumResidualError, pTotalsLowHigh->cCasesInBucket);
-               splittingScore += 0 == pTotalsHighLow->cCasesInBucket ? 0 : EbmStatistics::ComputeNodeSplittingScore(pTotalsHighLow->aPredictionStatistics[iVector].sumResidualError, pTotalsHighLow->cCasesInBucket);
-               splittingScore += 0 == pTotalsHighHigh->cCasesInBucket ? 0 : EbmStatistics::ComputeNodeSplittingScore(pTotalsHighHigh->aPredictionStatistics[iVector].sumResidualError, pTotalsHighHigh->cCasesInBucket);
-               EBM_ASSERT(0 <= splittingScore);
-            }
-            EBM_ASSERT(0 <= splittingScore);
-
-            if(bestSplittingScore < splittingScore) {
-               bestSplittingScore = splittingScore;
-            }
-         }
-      }
+      );
       LOG(TraceLevelVerbose, "CalculateInteractionScore Done state sweep loop");
 
       if(nullptr != pInteractionScoreReturn) {
@@ -1891,4 +1959,94 @@ bool CalculateInteractionScore(const size_t cTargetStates, CachedInteractionThre
    return false;
 }
 
+template<ptrdiff_t countCompilerClassificationTargetStates, size_t countCompilerDimensions>
+struct CalculateInteractionScoreDimensions final {
+   template<typename... TArgs>
+   TML_INLINE static bool Run(const TArgs... args) {
+      return CalculateInteractionScore<countCompilerClassificationTargetStates, countCompilerDimensions>(args...);
+   }
+};
+
+// the most attribute combinations that CalculateInteractionScores accepts at once
+constexpr size_t k_cInteractionCombinationsPerBlockMax = 64;
+// the histograms for a block need to stay in cache while we stream the case tiles through them, otherwise we'd just be trading residual reads for histogram
+// reads.  A single combination with a larger histogram than this is still fine, it just gets binned on its own
+constexpr size_t k_cBytesInteractionBlockMax = size_t { 1 } << 20;
+
+// scores cAttributeCombinations (at most k_cInteractionCombinationsPerBlockMax) attribute combinations, binning them in blocks that share each pass over the
+// data.  Scores are written to *apInteractionScoresReturn[iAttributeCombination], which can be nullptr.  Returns true if any of the scores failed
+template<ptrdiff_t countCompilerClassificationTargetStates>
+bool CalculateInteractionScores(const size_t cTargetStates, CachedInteractionThreadResources * const pCachedThreadResources, const DataSetInternalCore * const pDataSet, const size_t cAttributeCombinations, const AttributeCombinationCore * const * const apAttributeCombinations, FractionalDataType * const * const apInteractionScoresReturn) {
+   LOG(TraceLevelVerbose, "Entered CalculateInteractionScores");
+
+   EBM_ASSERT(1 <= cAttributeCombinations);
+   EBM_ASSERT(cAttributeCombinations <= k_cInteractionCombinationsPerBlockMax);
+
+   const size_t cVectorLength = GET_VECTOR_LENGTH(countCompilerClassificationTargetStates, cTargetStates);
+   if(GetBinnedBucketSizeOverflow<IsRegression(countCompilerClassificationTargetStates)>(cVectorLength)) {
+      LOG(TraceLevelWarning, "WARNING CalculateInteractionScores GetBinnedBucketSizeOverflow<IsRegression(countCompilerClassificationTargetStates)>(cVectorLength)");
+      return true;
+   }
+   const size_t cBytesPerBinnedBucket = GetBinnedBucketSize<IsRegression(countCompilerClassificationTargetStates)>(cVectorLength);
+
+   bool bError = false;
+   size_t iBlockStart = 0;
+   do {
+      // gather the next block of attribute combinations whose histograms fit in our budget together
+      size_t aiByteOffsets[k_cInteractionCombinationsPerBlockMax];
+      size_t cBytesBlock = 0;
+      size_t iBlockEnd = iBlockStart;
+      do {
+         const AttributeCombinationCore * const pAttributeCombination = apAttributeCombinations[iBlockEnd];
+         size_t cBytesHistogram = cBytesPerBinnedBucket;
+         for(size_t iDimension = 0; iDimension < pAttributeCombination->m_cAttributes; ++iDimension) {
+            const size_t cStates = pAttributeCombination->m_AttributeCombinationEntry[iDimension].m_pAttribute->m_cStates;
+            if(IsMultiplyError(cBytesHistogram, cStates)) {
+               // CalculateInteractionScore will report the overflow properly if this ends up in a block by itself
+               cBytesHistogram = std::numeric_limits<size_t>::max();
+               break;
+            }
+            cBytesHistogram *= cStates;
+         }
+         if(iBlockStart != iBlockEnd && (IsAddError(cBytesBlock, cBytesHistogram) || k_cBytesInteractionBlockMax < cBytesBlock + cBytesHistogram)) {
+            break;
+         }
+         aiByteOffsets[iBlockEnd - iBlockStart] = cBytesBlock;
+         cBytesBlock = IsAddError(cBytesBlock, cBytesHistogram) ? std::numeric_limits<size_t>::max() : cBytesBlock + cBytesHistogram;
+         ++iBlockEnd;
+      } while(iBlockEnd < cAttributeCombinations);
+
+      const size_t cBlock = iBlockEnd - iBlockStart;
+      if(1 == cBlock) {
+         // there's nothing to share our pass over the data with, so bin directly into the scoring buffer
+         if(CompilerRecursiveDimensions<CalculateInteractionScoreDimensions, countCompilerClassificationTargetStates>::Run(apAttributeCombinations[iBlockStart]->m_cAttributes, cTargetStates, pCachedThreadResources, pDataSet, apAttributeCombinations[iBlockStart], apInteractionScoresReturn[iBlockStart], nullptr)) {
+            bError = true;
+         }
+      } else {
+         unsigned char * const aBlockBuffer = static_cast<unsigned char *>(pCachedThreadResources->GetThreadByteBuffer2(cBytesBlock));
+         if(UNLIKELY(nullptr == aBlockBuffer)) {
+            LOG(TraceLevelWarning, "WARNING CalculateInteractionScores nullptr == aBlockBuffer");
+            return true;
+         }
+         memset(aBlockBuffer, 0, cBytesBlock);
+
+         BinnedBucket<IsRegression(countCompilerClassificationTargetStates)> * aaBinnedBuckets[k_cInteractionCombinationsPerBlockMax];
+         for(size_t iBlock = 0; iBlock < cBlock; ++iBlock) {
+            aaBinnedBuckets[iBlock] = reinterpret_cast<BinnedBucket<IsRegression(countCompilerClassificationTargetStates)> *>(aBlockBuffer + aiByteOffsets[iBlock]);
+         }
+         RunSimdVariant<BinDataSetInteractionTiledSimd<countCompilerClassificationTargetStates>>(cBlock, &apAttributeCombinations[iBlockStart], aaBinnedBuckets, pDataSet, cTargetStates);
+
+         for(size_t iBlock = 0; iBlock < cBlock; ++iBlock) {
+            if(CompilerRecursiveDimensions<CalculateInteractionScoreDimensions, countCompilerClassificationTargetStates>::Run(apAttributeCombinations[iBlockStart + iBlock]->m_cAttributes, cTargetStates, pCachedThreadResources, pDataSet, apAttributeCombinations[iBlockStart + iBlock], apInteractionScoresReturn[iBlockStart + iBlock], aaBinnedBuckets[iBlock])) {
+               bError = true;
+            }
+         }
+      }
+      iBlockStart = iBlockEnd;
+   } while(iBlockStart < cAttributeCombinations);
+
+   LOG(TraceLevelVerbose, "Exited CalculateInteractionScores");
+   return bError;
+}
+
 #endif // MULTI_DIMENSIONAL_TRAINING_H
@@ -18,3 +18,5 @@
 #include <tuple>
 #include <stdio.h> // snprintf/vsnprintf for logging
 #include <stdarg.h> // va_start, va_end
+#include <atomic>
+#include <thread>
@@ -7,10 +7,13 @@
 #include <string.h> // memset
 #include <stdlib.h> // malloc, realloc, free
 #include <stddef.h> // size_t, ptrdiff_t
+#include <limits> // numeric_limits
+#include <cmath> // ceil
 
 #include "EbmInternal.h" // TML_INLINE & UNLIKLEY
 #include "Logging.h" // EBM_ASSERT & LOG
 #include "RandomStream.h" // our header didn't need the full definition, but we use the RandomStream in here, so we need it
+#include "AttributeCombinationInternal.h" // AttributeCombinationCore
 #include "DataSetByAttributeCombination.h" // we use an iterator which requires a full definition.  TODO : in the future we'll be eliminating the iterator, so check back here to see if we can eliminate this include file
 #include "SamplingWithReplacement.h"
 
@@ -33,6 +36,11 @@ size_t SamplingWithReplacement::GetTotalCountCaseOccurrences() const {
    return cTotalCountCaseOccurrences;
 }
 
+size_t SamplingWithReplacement::GetMemoryBytes() const {
+   // we allocated this array, so this can't overflow
+   return sizeof(*this) + sizeof(size_t) * m_pOriginDataSet->GetCountCases();
+}
+
 SamplingWithReplacement * SamplingWithReplacement::GenerateSingleSamplingSet(RandomStream * const pRandomStream, const DataSetAttributeCombination * const pOriginDataSet) {
    LOG(TraceLevelVerbose, "Entered SamplingWithReplacement::GenerateSingleSamplingSet");
 
@@ -78,37 +86,214 @@ SamplingWithReplacement * SamplingWithReplacement::GenerateSingleSamplingSet(Ran
    return pRet;
 }
 
-SamplingWithReplacement * SamplingWithReplacement::GenerateFlatSamplingSet(const DataSetAttributeCombination * const pOriginDataSet) {
-   LOG(TraceLevelInfo, "Entered SamplingWithReplacement::GenerateFlatSamplingSet");
+SamplingFlat::~SamplingFlat() {
+   LOG(TraceLevelInfo, "Entered ~SamplingFlat");
+   if(nullptr != m_aaCountCasesInBins) {
+      for(size_t iAttributeCombination = 0; iAttributeCombination < m_cAttributeCombinations; ++iAttributeCombination) {
+         free(m_aaCountCasesInBins[iAttributeCombination]);
+      }
+      free(const_cast<size_t **>(m_aaCountCasesInBins));
+   }
+   LOG(TraceLevelInfo, "Exited ~SamplingFlat");
+}
+
+size_t SamplingFlat::GetTotalCountCaseOccurrences() const {
+   // every case occurs exactly once
+   return m_pOriginDataSet->GetCountCases();
+}
+
+size_t SamplingFlat::GetMemoryBytes() const {
+   return sizeof(*this) + sizeof(size_t *) * m_cAttributeCombinations + m_cBytesCountCasesInBins;
+}
+
+TML_INLINE static size_t GetCountBins(const AttributeCombinationCore * const pAttributeCombination) {
+   size_t cBins = 1;
+   for(size_t iDimension = 0; iDimension < pAttributeCombination->m_cAttributes; ++iDimension) {
+      // we checked for overflow of this product in the attribute combination allocation
+      cBins *= pAttributeCombination->m_AttributeCombinationEntry[iDimension].m_pAttribute->m_cStates;
+   }
+   return cBins;
+}
+
+// counts the number of cases in each bin by unpacking the bit packed input data the same way BinDataSetTraining does
+static size_t * CountCasesInBins(const DataSetAttributeCombination * const pOriginDataSet, const AttributeCombinationCore * const pAttributeCombination) {
+   EBM_ASSERT(1 <= pAttributeCombination->m_cAttributes);
+
+   const size_t cBins = GetCountBins(pAttributeCombination);
+   if(IsMultiplyError(sizeof(size_t), cBins)) {
+      LOG(TraceLevelWarning, "WARNING CountCasesInBins IsMultiplyError(sizeof(size_t), cBins)");
+      return nullptr;
+   }
+   const size_t cBytesCounts = sizeof(size_t) * cBins;
+   size_t * const aCountCasesInBins = static_cast<size_t *>(malloc(cBytesCounts));
+   if(nullptr == aCountCasesInBins) {
+      LOG(TraceLevelWarning, "WARNING CountCasesInBins nullptr == aCountCasesInBins");
+      return nullptr;
+   }
+   memset(aCountCasesInBins, 0, cBytesCounts);
+
+   const size_t cItemsPerBitPackDataUnit = pAttributeCombination->m_cItemsPerBitPackDataUnit;
+   const size_t cBitsPerItemMax = GetCountBits(cItemsPerBitPackDataUnit);
+   const size_t maskBits = std::numeric_limits<size_t>::max() >> (k_cBitsForStorageType - cBitsPerItemMax);
+
+   const StorageDataTypeCore * pInputData = pOriginDataSet->GetDataPointer(pAttributeCombination);
+   const size_t cCases = pOriginDataSet->GetCountCases();
+   size_t iCase = 0;
+   do {
+      size_t iBinCombined = static_cast<size_t>(*pInputData);
+      ++pInputData;
+      const size_t cItemsRemainingInData = cCases - iCase;
+      size_t cItemsRemaining = cItemsRemainingInData < cItemsPerBitPackDataUnit ? cItemsRemainingInData : cItemsPerBitPackDataUnit;
+      iCase += cItemsRemaining;
+      do {
+         const size_t iBin = maskBits & iBinCombined;
+         EBM_ASSERT(iBin < cBins);
+         ++aCountCasesInBins[iBin];
+         iBinCombined >>= cBitsPerItemMax;
+         --cItemsRemaining;
+      } while(0 != cItemsRemaining);
+   } while(iCase < cCases);
+
+   return aCountCasesInBins;
+}
+
+SamplingFlat * SamplingFlat::GenerateFlatSamplingSet(const DataSetAttributeCombination * const pOriginDataSet, const size_t cAttributeCombinations, const AttributeCombinationCore * const * const apAttributeCombinations) {
+   LOG(TraceLevelInfo, "Entered SamplingFlat::GenerateFlatSamplingSet");
 
-   // TODO: someday eliminate the need for generating this flat set by specially handling the case of no internal bagging
    EBM_ASSERT(nullptr != pOriginDataSet);
+   EBM_ASSERT(0 < pOriginDataSet->GetCountCases()); // if there were no cases, we wouldn't be called
+   EBM_ASSERT(cAttributeCombinations == pOriginDataSet->GetCountAttributeCombinations());
+
+   size_t ** aaCountCasesInBins = nullptr;
+   size_t cBytesCountCasesInBins = 0;
+   if(0 != cAttributeCombinations) {
+      EBM_ASSERT(nullptr != apAttributeCombinations);
+      if(IsMultiplyError(sizeof(size_t *), cAttributeCombinations)) {
+         LOG(TraceLevelWarning, "WARNING SamplingFlat::GenerateFlatSamplingSet IsMultiplyError(sizeof(size_t *), cAttributeCombinations)");
+         return nullptr;
+      }
+      const size_t cBytesArray = sizeof(size_t *) * cAttributeCombinations;
+      aaCountCasesInBins = static_cast<size_t **>(malloc(cBytesArray));
+      if(nullptr == aaCountCasesInBins) {
+         LOG(TraceLevelWarning, "WARNING SamplingFlat::GenerateFlatSamplingSet nullptr == aaCountCasesInBins");
+         return nullptr;
+      }
+      // zero everything first so that our destructor, or our error path, can free the whole array if we fail part way through
+      memset(aaCountCasesInBins, 0, cBytesArray);
+      for(size_t iAttributeCombination = 0; iAttributeCombination < cAttributeCombinations; ++iAttributeCombination) {
+         const AttributeCombinationCore * const pAttributeCombination = apAttributeCombinations[iAttributeCombination];
+         EBM_ASSERT(iAttributeCombination == pAttributeCombination->m_iInputData);
+         if(0 != pAttributeCombination->m_cAttributes) {
+            size_t * const aCountCasesInBins = CountCasesInBins(pOriginDataSet, pAttributeCombination);
+            if(nullptr == aCountCasesInBins) {
+               LOG(TraceLevelWarning, "WARNING SamplingFlat::GenerateFlatSamplingSet nullptr == aCountCasesInBins");
+               for(size_t iAttributeCombinationFree = 0; iAttributeCombinationFree < iAttributeCombination; ++iAttributeCombinationFree) {
+                  free(aaCountCasesInBins[iAttributeCombinationFree]);
+               }
+               free(aaCountCasesInBins);
+               return nullptr;
+            }
+            aaCountCasesInBins[iAttributeCombination] = aCountCasesInBins;
+            // CountCasesInBins checked that this doesn't overflow, and the total is less than the memory we've already allocated
+            cBytesCountCasesInBins += sizeof(size_t) * GetCountBins(pAttributeCombination);
+         }
+      }
+   }
+
+   SamplingFlat * pRet = new (std::nothrow) SamplingFlat(pOriginDataSet, aaCountCasesInBins, cAttributeCombinations, cBytesCountCasesInBins);
+   if(nullptr == pRet) {
+      LOG(TraceLevelWarning, "WARNING SamplingFlat::GenerateFlatSamplingSet nullptr == pRet");
+      if(nullptr != aaCountCasesInBins) {
+         for(size_t iAttributeCombination = 0; iAttributeCombination < cAttributeCombinations; ++iAttributeCombination) {
+            free(aaCountCasesInBins[iAttributeCombination]);
+         }
+         free(aaCountCasesInBins);
+      }
+      return nullptr;
+   }
+
+   LOG(TraceLevelInfo, "Exited SamplingFlat::GenerateFlatSamplingSet");
+   return pRet;
+}
+
+SamplingWithoutReplacement::~SamplingWithoutReplacement() {
+   LOG(TraceLevelInfo, "Entered ~SamplingWithoutReplacement");
+   free(const_cast<size_t *>(m_aSelectedBits));
+   LOG(TraceLevelInfo, "Exited ~SamplingWithoutReplacement");
+}
+
+size_t SamplingWithoutReplacement::GetTotalCountCaseOccurrences() const {
+#ifndef NDEBUG
+   size_t cTotalCountCaseOccurrencesDebug = 0;
+   for(size_t i = 0; i < m_pOriginDataSet->GetCountCases(); ++i) {
+      cTotalCountCaseOccurrencesDebug += GetCountOccurrences(i);
+   }
+   EBM_ASSERT(cTotalCountCaseOccurrencesDebug == m_cSelectedCases);
+#endif // NDEBUG
+   return m_cSelectedCases;
+}
+
+size_t SamplingWithoutReplacement::GetMemoryBytes() const {
+   const size_t cWords = (m_pOriginDataSet->GetCountCases() - 1) / k_cBitsForSizeTCore + 1; // this can't overflow or underflow
+   return sizeof(*this) + sizeof(size_t) * cWords;
+}
+
+SamplingWithoutReplacement * SamplingWithoutReplacement::GenerateSingleSamplingSet(RandomStream * const pRandomStream, const DataSetAttributeCombination * const pOriginDataSet) {
+   LOG(TraceLevelVerbose, "Entered SamplingWithoutReplacement::GenerateSingleSamplingSet");
+
+   EBM_ASSERT(nullptr != pRandomStream);
+   EBM_ASSERT(nullptr != pOriginDataSet);
+
    const size_t cCases = pOriginDataSet->GetCountCases();
    EBM_ASSERT(0 < cCases); // if there were no cases, we wouldn't be called
 
-   const size_t cBytesData = sizeof(size_t) * cCases;
-   size_t * const aCountOccurrences = static_cast<size_t *>(malloc(cBytesData));
-   if(nullptr == aCountOccurrences) {
-      LOG(TraceLevelWarning, "WARNING SamplingWithReplacement::GenerateFlatSamplingSet nullptr == aCountOccurrences");
+   // converting cCases to a double can round it up for huge datasets, so we need to clamp the result
+   const size_t cSelectedCasesUnclamped = static_cast<size_t>(std::ceil(k_samplingWithoutReplacementFraction * static_cast<double>(cCases)));
+   const size_t cSelectedCases = cCases < cSelectedCasesUnclamped ? cCases : cSelectedCasesUnclamped;
+   EBM_ASSERT(1 <= cSelectedCases);
+
+   const size_t cWords = (cCases - 1) / k_cBitsForSizeTCore + 1; // this can't overflow or underflow
+   const size_t cBytesData = sizeof(size_t) * cWords; // this can't overflow since we have fewer words than cases, and we have a size_t per case in our other arrays
+   size_t * const aSelectedBits = static_cast<size_t *>(malloc(cBytesData));
+   if(nullptr == aSelectedBits) {
+      LOG(TraceLevelWarning, "WARNING SamplingWithoutReplacement::GenerateSingleSamplingSet nullptr == aSelectedBits");
       return nullptr;
    }
 
-   for(size_t iCase = 0; iCase < cCases; ++iCase) {
-      aCountOccurrences[iCase] = 1;
+   memset(aSelectedBits, 0, cBytesData);
+
+   try {
+      // selection sampling (Knuth's Algorithm S).  Each case is selected with probability (cases still needed) / (cases remaining), which gives every subset
+      // of size cSelectedCases the same chance of being chosen and finishes with exactly cSelectedCases selected in a single pass
+      size_t cSelectedRemaining = cSelectedCases;
+      for(size_t iCase = 0; iCase < cCases; ++iCase) {
+         const size_t cCasesRemaining = cCases - iCase;
+         if(pRandomStream->Next(size_t { 0 }, cCasesRemaining - 1) < cSelectedRemaining) {
+            aSelectedBits[iCase / k_cBitsForSizeTCore] |= size_t { 1 } << (iCase % k_cBitsForSizeTCore);
+            --cSelectedRemaining;
+         }
+      }
+      EBM_ASSERT(0 == cSelectedRemaining);
+   } catch(...) {
+      // Next could in theory throw an exception
+      LOG(TraceLevelWarning, "WARNING SamplingWithoutReplacement::GenerateSingleSamplingSet exception");
+      free(aSelectedBits);
+      return nullptr;
    }
 
-   SamplingWithReplacement * pRet = new (std::nothrow) SamplingWithReplacement(pOriginDataSet, aCountOccurrences);
+   SamplingWithoutReplacement * pRet = new (std::nothrow) SamplingWithoutReplacement(pOriginDataSet, aSelectedBits, cSelectedCases);
    if(nullptr == pRet) {
-      LOG(TraceLevelWarning, "WARNING SamplingWithReplacement::GenerateFlatSamplingSet nullptr == pRet");
-      free(aCountOccurrences);
+      LOG(TraceLevelWarning, "WARNING SamplingWithoutReplacement::GenerateSingleSamplingSet nullptr == pRet");
+      free(aSelectedBits);
+      return nullptr;
    }
 
-   LOG(TraceLevelInfo, "Exited SamplingWithReplacement::GenerateFlatSamplingSet");
+   LOG(TraceLevelVerbose, "Exited SamplingWithoutReplacement::GenerateSingleSamplingSet");
    return pRet;
 }
 
-void SamplingWithReplacement::FreeSamplingSets(const size_t cSamplingSets, SamplingMethod ** apSamplingSets) {
-   LOG(TraceLevelInfo, "Entered SamplingWithReplacement::FreeSamplingSets");
+void SamplingMethod::FreeSamplingSets(const size_t cSamplingSets, SamplingMethod ** apSamplingSets) {
+   LOG(TraceLevelInfo, "Entered SamplingMethod::FreeSamplingSets");
    if(LIKELY(nullptr != apSamplingSets)) {
       const size_t cSamplingSetsAfterZero = 0 == cSamplingSets ? 1 : cSamplingSets;
       for(size_t iSamplingSet = 0; iSamplingSet < cSamplingSetsAfterZero; ++iSamplingSet) {
@@ -116,11 +301,39 @@ void SamplingWithReplacement::FreeSamplingSets(const size_t cSamplingSets, Sampl
       }
       delete[] apSamplingSets;
    }
-   LOG(TraceLevelInfo, "Exited SamplingWithReplacement::FreeSamplingSets");
+   LOG(TraceLevelInfo, "Exited SamplingMethod::FreeSamplingSets");
+}
+
+size_t SamplingMethod::GetSamplingSetsMemoryBytes(const size_t cSamplingSets, const SamplingMethod * const * const apSamplingSets) {
+   if(nullptr == apSamplingSets) {
+      return 0;
+   }
+   const size_t cSamplingSetsAfterZero = 0 == cSamplingSets ? 1 : cSamplingSets;
+   size_t cBytes = sizeof(*apSamplingSets) * cSamplingSetsAfterZero;
+   for(size_t iSamplingSet = 0; iSamplingSet < cSamplingSetsAfterZero; ++iSamplingSet) {
+      cBytes += apSamplingSets[iSamplingSet]->GetMemoryBytes();
+   }
+   return cBytes;
+}
+
+size_t SamplingMethod::GetSamplingSetsPlannedBytes(const size_t cCases, const size_t cAttributeCombinations, const AttributeCombinationCore * const * const apAttributeCombinations, const size_t cSamplingSets, const bool bWithoutReplacement) {
+   EBM_ASSERT(0 < cCases);
+   if(0 == cSamplingSets) {
+      size_t cBytesFlat = sizeof(SamplingMethod *) + sizeof(SamplingFlat) + sizeof(size_t *) * cAttributeCombinations;
+      for(size_t iAttributeCombination = 0; iAttributeCombination < cAttributeCombinations; ++iAttributeCombination) {
+         const AttributeCombinationCore * const pAttributeCombination = apAttributeCombinations[iAttributeCombination];
+         if(0 != pAttributeCombination->m_cAttributes) {
+            cBytesFlat = AddSaturate(cBytesFlat, MultiplySaturate(sizeof(size_t), GetCountBins(pAttributeCombination)));
+         }
+      }
+      return cBytesFlat;
+   }
+   const size_t cBytesSamplingSet = bWithoutReplacement ? sizeof(SamplingWithoutReplacement) + sizeof(size_t) * ((cCases - 1) / k_cBitsForSizeTCore + 1) : AddSaturate(sizeof(SamplingWithReplacement), MultiplySaturate(sizeof(size_t), cCases));
+   return MultiplySaturate(AddSaturate(sizeof(SamplingMethod *), cBytesSamplingSet), cSamplingSets);
 }
 
-SamplingMethod ** SamplingWithReplacement::GenerateSamplingSets(RandomStream * const pRandomStream, const DataSetAttributeCombination * const pOriginDataSet, const size_t cSamplingSets) {
-   LOG(TraceLevelInfo, "Entered SamplingWithReplacement::GenerateSamplingSets");
+SamplingMethod ** SamplingMethod::GenerateSamplingSets(RandomStream * const pRandomStream, const DataSetAttributeCombination * const pOriginDataSet, const size_t cAttributeCombinations, const AttributeCombinationCore * const * const apAttributeCombinations, const size_t cSamplingSets, const bool bWithoutReplacement) {
+   LOG(TraceLevelInfo, "Entered SamplingMethod::GenerateSamplingSets");
 
    EBM_ASSERT(nullptr != pRandomStream);
    EBM_ASSERT(nullptr != pOriginDataSet);
@@ -129,13 +342,13 @@ SamplingMethod ** SamplingWithReplacement::GenerateSamplingSets(RandomStream * c
 
    SamplingMethod ** apSamplingSets = new (std::nothrow) SamplingMethod *[cSamplingSetsAfterZero];
    if(UNLIKELY(nullptr == apSamplingSets)) {
-      LOG(TraceLevelWarning, "WARNING SamplingWithReplacement::GenerateSamplingSets nullptr == apSamplingSets");
+      LOG(TraceLevelWarning, "WARNING SamplingMethod::GenerateSamplingSets nullptr == apSamplingSets");
       return nullptr;
    }
    if(0 == cSamplingSets) {
-      SamplingWithReplacement * const pSingleSamplingSet = GenerateFlatSamplingSet(pOriginDataSet);
+      SamplingFlat * const pSingleSamplingSet = SamplingFlat::GenerateFlatSamplingSet(pOriginDataSet, cAttributeCombinations, apAttributeCombinations);
       if(UNLIKELY(nullptr == pSingleSamplingSet)) {
-         LOG(TraceLevelWarning, "WARNING SamplingWithReplacement::GenerateSamplingSets nullptr == pSingleSamplingSet");
+         LOG(TraceLevelWarning, "WARNING SamplingMethod::GenerateSamplingSets nullptr == pSingleSamplingSet");
          free(apSamplingSets);
          return nullptr;
       }
@@ -143,15 +356,15 @@ SamplingMethod ** SamplingWithReplacement::GenerateSamplingSets(RandomStream * c
    } else {
       memset(apSamplingSets, 0, sizeof(*apSamplingSets) * cSamplingSets);
       for(size_t iSamplingSet = 0; iSamplingSet < cSamplingSets; ++iSamplingSet) {
-         SamplingWithReplacement * const pSingleSamplingSet = GenerateSingleSamplingSet(pRandomStream, pOriginDataSet);
+         SamplingMethod * const pSingleSamplingSet = bWithoutReplacement ? static_cast<SamplingMethod *>(SamplingWithoutReplacement::GenerateSingleSamplingSet(pRandomStream, pOriginDataSet)) : static_cast<SamplingMethod *>(SamplingWithReplacement::GenerateSingleSamplingSet(pRandomStream, pOriginDataSet));
          if(UNLIKELY(nullptr == pSingleSamplingSet)) {
-            LOG(TraceLevelWarning, "WARNING SamplingWithReplacement::GenerateSamplingSets nullptr == pSingleSamplingSet");
+            LOG(TraceLevelWarning, "WARNING SamplingMethod::GenerateSamplingSets nullptr == pSingleSamplingSet");
             FreeSamplingSets(cSamplingSets, apSamplingSets);
             return nullptr;
          }
          apSamplingSets[iSamplingSet] = pSingleSamplingSet;
       }
    }
-   LOG(TraceLevelInfo, "Exited SamplingWithReplacement::GenerateSamplingSets");
+   LOG(TraceLevelInfo, "Exited SamplingMethod::GenerateSamplingSets");
    return apSamplingSets;
 }
\ No newline at end of file
@@ -13,14 +13,21 @@
 
 class RandomStream;
 class DataSetAttributeCombination;
+class AttributeCombinationCore;
+
+// our binning loops need to know how the occurrences are stored so that they can read them without a virtual call per case
+enum class SamplingTypeCore { WithReplacementCore = 0, WithoutReplacementCore = 1, FlatCore = 2 };
 
 // TODO: if/when we decide we want to keep SamplingWithReplacement, we should create a SamplingMethod.h and SamplingMethod.cpp
 class SamplingMethod {
 public:
    const DataSetAttributeCombination * const m_pOriginDataSet;
+   // SamplingWithReplacement, SamplingWithoutReplacement or SamplingFlat.  We can static_cast to the matching class
+   const SamplingTypeCore m_samplingType;
 
-   TML_INLINE SamplingMethod(const DataSetAttributeCombination * const pOriginDataSet)
-      : m_pOriginDataSet(pOriginDataSet) {
+   TML_INLINE SamplingMethod(const DataSetAttributeCombination * const pOriginDataSet, const SamplingTypeCore samplingType)
+      : m_pOriginDataSet(pOriginDataSet)
+      , m_samplingType(samplingType) {
       EBM_ASSERT(nullptr != pOriginDataSet);
    }
 
@@ -28,6 +35,17 @@ public:
    }
 
    virtual size_t GetTotalCountCaseOccurrences() const = 0;
+   // the bytes this sampling set holds, including the object itself
+   virtual size_t GetMemoryBytes() const = 0;
+
+   static void FreeSamplingSets(const size_t cSamplingSets, SamplingMethod ** apSamplingSets);
+   static size_t GetSamplingSetsMemoryBytes(const size_t cSamplingSets, const SamplingMethod * const * const apSamplingSets);
+   // the bytes that GenerateSamplingSets will allocate for a dataset with cCases cases.  We only need the attribute combinations, so this can be called before
+   // we have any data.  This saturates instead of overflowing
+   static size_t GetSamplingSetsPlannedBytes(const size_t cCases, const size_t cAttributeCombinations, const AttributeCombinationCore * const * const apAttributeCombinations, const size_t cSamplingSets, const bool bWithoutReplacement);
+   // if cSamplingSets is zero we generate a single SamplingFlat that includes every case once.  bWithoutReplacement chooses between
+   // SamplingWithoutReplacement and SamplingWithReplacement for the bags when cSamplingSets is non-zero
+   static SamplingMethod ** GenerateSamplingSets(RandomStream * const pRandomStream, const DataSetAttributeCombination * const pOriginDataSet, const size_t cAttributeCombinations, const AttributeCombinationCore * const * const apAttributeCombinations, const size_t cSamplingSets, const bool bWithoutReplacement);
 };
 
 // SamplingWithReplacement this is the more theoretically correct method of sampling, but it has the drawback that we need to keep a count of the number of times each case is selected in the dataset.  Sampling without replacement would require 1 bit per case, so it can be faster.
@@ -38,19 +56,85 @@ public:
 
    // we take owernship of the aCounts array.  We do not take ownership of the pOriginDataSet since many SamplingWithReplacement objects will refer to the original one
    TML_INLINE SamplingWithReplacement(const DataSetAttributeCombination * const pOriginDataSet, const size_t * const aCountOccurrences)
-      : SamplingMethod(pOriginDataSet)
+      : SamplingMethod(pOriginDataSet, SamplingTypeCore::WithReplacementCore)
       , m_aCountOccurrences(aCountOccurrences) {
       EBM_ASSERT(nullptr != aCountOccurrences);
    }
 
    virtual ~SamplingWithReplacement() final override;
    virtual size_t GetTotalCountCaseOccurrences() const final override;
+   virtual size_t GetMemoryBytes() const final override;
 
    static SamplingWithReplacement * GenerateSingleSamplingSet(RandomStream * const pRandomStream, const DataSetAttributeCombination * const pOriginDataSet);
-   static SamplingWithReplacement * GenerateFlatSamplingSet(const DataSetAttributeCombination * const pOriginDataSet);
+};
 
-   static void FreeSamplingSets(const size_t cSamplingSets, SamplingMethod ** apSamplingSets);
-   static SamplingMethod ** GenerateSamplingSets(RandomStream * const pRandomStream, const DataSetAttributeCombination * const pOriginDataSet, const size_t cSamplingSets);
+// the fraction of the training cases that SamplingWithoutReplacement puts in each bag.  Half is the usual subsampling rate for stochastic gradient boosting, and
+// it's the rate that TrainingOptionsSamplingWithoutReplacement documents in ebmcore.h, so change both together.  trainingOptions only carries on/off bits, so
+// callers can't choose the rate.  Exposing it would need a new argument on every InitializeTraining* entry point.  We round the number of cases up so that a
+// bag is never empty
+constexpr double k_samplingWithoutReplacementFraction = 0.5;
+static_assert(0 < k_samplingWithoutReplacementFraction && k_samplingWithoutReplacementFraction <= 1, "a bag needs to hold some, but no more than all, of the cases");
+
+// SamplingWithoutReplacement selects k_samplingWithoutReplacementFraction of the cases for each bag, and each case is either in or out, so we only need to keep 1 bit per case.  The bits are
+// packed into size_t words with case iCase in bit (iCase % k_cBitsForSizeTCore) of word (iCase / k_cBitsForSizeTCore).  For 100M cases this is 12.5MB per bag instead of the 800MB
+// that SamplingWithReplacement needs for its counts, and our binning loops read 64 times less occurrence data
+class SamplingWithoutReplacement final : public SamplingMethod {
+public:
+   const size_t * const m_aSelectedBits;
+   const size_t m_cSelectedCases;
+
+   // we take owernship of the aSelectedBits array.  We do not take ownership of the pOriginDataSet since many SamplingWithoutReplacement objects will refer to the original one
+   TML_INLINE SamplingWithoutReplacement(const DataSetAttributeCombination * const pOriginDataSet, const size_t * const aSelectedBits, const size_t cSelectedCases)
+      : SamplingMethod(pOriginDataSet, SamplingTypeCore::WithoutReplacementCore)
+      , m_aSelectedBits(aSelectedBits)
+      , m_cSelectedCases(cSelectedCases) {
+      EBM_ASSERT(nullptr != aSelectedBits);
+   }
+
+   virtual ~SamplingWithoutReplacement() final override;
+   virtual size_t GetTotalCountCaseOccurrences() const final override;
+   virtual size_t GetMemoryBytes() const final override;
+
+   // returns 1 if the case is in our bag, otherwise 0.  This doesn't branch, so it can be used inside our binning loops
+   TML_INLINE size_t GetCountOccurrences(const size_t iCase) const {
+      return (m_aSelectedBits[iCase / k_cBitsForSizeTCore] >> (iCase % k_cBitsForSizeTCore)) & size_t { 1 };
+   }
+
+   static SamplingWithoutReplacement * GenerateSingleSamplingSet(RandomStream * const pRandomStream, const DataSetAttributeCombination * const pOriginDataSet);
+};
+
+// SamplingFlat is what we use when there is no inner bagging.  Every case occurs exactly once, so we don't store any occurrences and our binning loops don't
+// read or multiply by them.  The number of cases in each bin never changes between boosting steps, so we count them once here and our binning copies them
+// into the histogram instead of incrementing a count per case
+class SamplingFlat final : public SamplingMethod {
+public:
+   // indexed by AttributeCombinationCore::m_iInputData.  Each array has one count per bin of its attribute combination (the product of the m_cStates of each
+   // dimension).  Attribute combinations with zero dimensions have a nullptr here, since their single bin holds every case
+   size_t * const * const m_aaCountCasesInBins;
+   const size_t m_cAttributeCombinations;
+   // the sum of the sizes of the arrays in m_aaCountCasesInBins, which we need for GetMemoryBytes since we don't keep the attribute combinations
+   const size_t m_cBytesCountCasesInBins;
+
+   // we take owernship of aaCountCasesInBins and each of the arrays in it
+   TML_INLINE SamplingFlat(const DataSetAttributeCombination * const pOriginDataSet, size_t * const * const aaCountCasesInBins, const size_t cAttributeCombinations, const size_t cBytesCountCasesInBins)
+      : SamplingMethod(pOriginDataSet, SamplingTypeCore::FlatCore)
+      , m_aaCountCasesInBins(aaCountCasesInBins)
+      , m_cAttributeCombinations(cAttributeCombinations)
+      , m_cBytesCountCasesInBins(cBytesCountCasesInBins) {
+      EBM_ASSERT(0 == cAttributeCombinations || nullptr != aaCountCasesInBins);
+   }
+
+   virtual ~SamplingFlat() final override;
+   virtual size_t GetTotalCountCaseOccurrences() const final override;
+   virtual size_t GetMemoryBytes() const final override;
+
+   TML_INLINE const size_t * GetCountCasesInBins(const size_t iInputData) const {
+      EBM_ASSERT(iInputData < m_cAttributeCombinations);
+      EBM_ASSERT(nullptr != m_aaCountCasesInBins[iInputData]);
+      return m_aaCountCasesInBins[iInputData];
+   }
+
+   static SamplingFlat * GenerateFlatSamplingSet(const DataSetAttributeCombination * const pOriginDataSet, const size_t cAttributeCombinations, const AttributeCombinationCore * const * const apAttributeCombinations);
 };
 
 #endif // SAMPLING_WITH_REPLACEMENT_H
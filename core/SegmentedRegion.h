@@ -74,7 +74,7 @@ public:
       const size_t cBytesValues = sizeof(TValues) * cValueCapacity;
 
       // this can't overflow since cDimensionsMax can't be bigger than k_cDimensionsMax, which is arround 64
-      const size_t cBytesSegmentedRegion = sizeof(SegmentedRegionCore) - sizeof(DimensionInfo) + sizeof(DimensionInfo) * cDimensionsMax;
+      const size_t cBytesSegmentedRegion = GetHeaderBytes(cDimensionsMax);
       SegmentedRegionCore * const pSegmentedRegion = static_cast<SegmentedRegionCore *>(malloc(cBytesSegmentedRegion));
       if(UNLIKELY(nullptr == pSegmentedRegion)) {
          LOG(TraceLevelWarning, "WARNING Allocate nullptr == pSegmentedRegion");
@@ -127,6 +127,35 @@ public:
       }
    }
 
+   TML_INLINE static size_t GetHeaderBytes(const size_t cDimensionsMax) {
+      return sizeof(SegmentedRegionCore) - sizeof(DimensionInfo) + sizeof(DimensionInfo) * cDimensionsMax;
+   }
+
+   // the bytes that we hold right now, including any capacity that we've grown into but aren't currently using
+   TML_INLINE size_t GetMemoryBytes() const {
+      size_t cBytes = GetHeaderBytes(m_cDimensionsMax) + sizeof(TValues) * m_cValueCapacity;
+      for(size_t iDimension = 0; iDimension < m_cDimensionsMax; ++iDimension) {
+         cBytes += sizeof(TDivisions) * m_aDimensions[iDimension].cDivisionCapacity;
+      }
+      return cBytes;
+   }
+
+   // the bytes that a SegmentedRegion from Allocate(cDimensionsMax, cVectorLength) holds after it has needed cValues values and acDivisions[iDimension] divisions in
+   // each of its first cDimensions dimensions.  This follows the growth rules of EnsureValueCapacity and SetCountDivisions, so it's exact if the region grew in
+   // a single step (as it does when we Expand a new model), and an upper bound otherwise.  This is used for estimates, so it saturates instead of overflowing
+   TML_INLINE static size_t GetGrownMemoryBytes(const size_t cDimensionsMax, const size_t cVectorLength, const size_t cValues, const size_t cDimensions, const size_t * const acDivisions) {
+      EBM_ASSERT(cDimensions <= cDimensionsMax);
+      const size_t cValueCapacityInitial = MultiplySaturate(cVectorLength, k_initialValueCapacity);
+      const size_t cValueCapacity = cValues <= cValueCapacityInitial ? cValueCapacityInitial : AddSaturate(cValues, cValues >> 1);
+      size_t cBytes = AddSaturate(GetHeaderBytes(cDimensionsMax), MultiplySaturate(sizeof(TValues), cValueCapacity));
+      for(size_t iDimension = 0; iDimension < cDimensionsMax; ++iDimension) {
+         const size_t cDivisions = iDimension < cDimensions ? acDivisions[iDimension] : size_t { 0 };
+         const size_t cDivisionCapacity = cDivisions <= k_initialDivisionCapacity ? k_initialDivisionCapacity : AddSaturate(cDivisions, cDivisions >> 1);
+         cBytes = AddSaturate(cBytes, MultiplySaturate(sizeof(TDivisions), cDivisionCapacity));
+      }
+      return cBytes;
+   }
+
    TML_INLINE void SetCountDimensions(const size_t cDimensions) {
       EBM_ASSERT(cDimensions <= m_cDimensionsMax);
       m_cDimensions = cDimensions;
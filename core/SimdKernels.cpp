@@ -0,0 +1,799 @@
+// Copyright (c) 2018 Microsoft Corporation
+// Licensed under the MIT license.
+// Author: Paul Koch <code@koch.ninja>
+
+#include "PrecompiledHeader.h"
+
+#include <stddef.h> // size_t, ptrdiff_t
+#include <stdint.h> // int64_t
+#include <string.h> // memcpy
+#include <cmath> // std::exp, std::log, std::nearbyint
+#include <limits> // numeric_limits
+
+#include <stdlib.h> // getenv
+#include <atomic>
+
+#include "ebmcore.h" // FractionalDataType
+#include "EbmInternal.h" // TML_INLINE
+#include "Logging.h" // EBM_ASSERT & LOG
+#include "EbmStatistics.h"
+#include "SimdKernels.h"
+
+#ifdef SIMD_KERNELS_X86
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h> // __cpuid, __cpuidex, _xgetbv
+#endif // _MSC_VER
+#endif // SIMD_KERNELS_X86
+
+static_assert(std::is_same<FractionalDataType, double>::value, "our vectorized kernels do their math in double");
+
+template<typename TFloat>
+static void BinaryclassResidualScalar(const FractionalDataType * const aModelUpdateTensor, const int64_t * const aiBins, const int64_t * const aTargets, TFloat * const aPredictionScores, TFloat * const aResidualErrors, const size_t cCases) {
+   for(size_t iCase = 0; iCase < cCases; ++iCase) {
+      const FractionalDataType smallChangeToPredictionScores = aModelUpdateTensor[static_cast<size_t>(aiBins[iCase])];
+      const TFloat trainingPredictionScore = static_cast<TFloat>(static_cast<FractionalDataType>(aPredictionScores[iCase]) + smallChangeToPredictionScores);
+      aPredictionScores[iCase] = trainingPredictionScore;
+      const FractionalDataType residualError = EbmStatistics::ComputeClassificationResidualErrorBinaryclass(static_cast<FractionalDataType>(trainingPredictionScore), static_cast<StorageDataTypeCore>(aTargets[iCase]));
+      aResidualErrors[iCase] = static_cast<TFloat>(residualError);
+   }
+}
+
+template<typename TFloat>
+static void ExpScalar(const TFloat * const aValues, FractionalDataType * const aExps, const size_t cValues) {
+   for(size_t iValue = 0; iValue < cValues; ++iValue) {
+      aExps[iValue] = std::exp(static_cast<FractionalDataType>(aValues[iValue]));
+   }
+}
+
+// exp(x) = 2^n * exp(r) where n = round(x / ln(2)) and |r| <= ln(2) / 2.  We split ln(2) into a high part with trailing zeros and a low part so
+// that x - n * ln(2) is exact for all the n that we can reach.  Within |r| <= ln(2) / 2 the Taylor series to degree 13 has a truncation error of
+// under 0.05 ULP, and evaluating it with FMA Horner steps keeps us within 1 ULP of the correctly rounded result.  Our fast exp
+// starts the same series at 1/8!, which has a truncation error of at most 3e-10 relative to exp(r)
+constexpr double k_expLog2E = 1.4426950408889634;
+constexpr double k_expLn2High = 6.93147180369123816490e-01;
+constexpr double k_expLn2Low = 1.90821492927058770002e-10;
+// below k_expMin exp rounds to zero, and above k_expMax it overflows to infinity.  Clamping keeps 2^n within our two step scaling below
+constexpr double k_expMin = -746.0;
+constexpr double k_expMax = 710.0;
+constexpr double k_aExpTaylor[] = {
+   1.0 / 6227020800.0, // 1/13!
+   1.0 / 479001600.0,
+   1.0 / 39916800.0,
+   1.0 / 3628800.0,
+   1.0 / 362880.0,
+   1.0 / 40320.0,
+   1.0 / 5040.0,
+   1.0 / 720.0,
+   1.0 / 120.0,
+   1.0 / 24.0,
+   1.0 / 6.0,
+   1.0 / 2.0,
+   1.0,
+   1.0 // 1/0!
+};
+constexpr size_t k_cExpTaylor = sizeof(k_aExpTaylor) / sizeof(k_aExpTaylor[0]);
+constexpr size_t k_iExpTaylorExact = 0;
+constexpr size_t k_iExpTaylorFast = 5; // 1/8!
+constexpr int64_t k_doubleSignBit = static_cast<int64_t>(uint64_t { 1 } << 63);
+constexpr int k_doubleExponentBias = 1023;
+constexpr int k_doubleMantissaBits = 52;
+constexpr uint64_t k_doubleMantissaMask = (uint64_t { 1 } << k_doubleMantissaBits) - 1;
+constexpr uint64_t k_doubleOneBits = uint64_t { k_doubleExponentBias } << k_doubleMantissaBits;
+
+// log(x) = e * ln(2) + log(m) where x = m * 2^e and sqrt(1/2) < m <= sqrt(2).  With s = (m - 1) / (m + 1), which is within +-0.1716, the series
+// log(m) = 2 * (s + s^3 / 3 + s^5 / 5 + ...) to s^11 has a truncation error of under 1e-10 relative to log(m).  We scale subnormals up by 2^54 first so
+// that their exponent bits are meaningful
+constexpr double k_logSqrt2 = 1.41421356237309504880;
+constexpr double k_logSubnormalScale = 18014398509481984.0; // 2^54
+constexpr double k_logSubnormalExponent = 54.0;
+constexpr double k_aLogAtanh[] = {
+   2.0 / 11.0,
+   2.0 / 9.0,
+   2.0 / 7.0,
+   2.0 / 5.0,
+   2.0 / 3.0,
+   2.0
+};
+constexpr size_t k_cLogAtanh = sizeof(k_aLogAtanh) / sizeof(k_aLogAtanh[0]);
+// adding 2^52 to a small integer as bits and then subtracting it as a double converts the integer without needing AVX512DQ
+constexpr double k_twoPow52 = 4503599627370496.0;
+
+TML_INLINE static double ScaleFromExponent(const int64_t exponent) {
+   const uint64_t bits = static_cast<uint64_t>(exponent + k_doubleExponentBias) << k_doubleMantissaBits;
+   double scale;
+   memcpy(&scale, &bits, sizeof(scale));
+   return scale;
+}
+
+// the portable versions of our fast exp and log follow the same steps as the vectorized versions below without any branches, so compilers can
+// vectorize loops over them on processors that we don't have hand written kernels for.  We avoid std::fma since it's a slow library call on
+// processors without FMA instructions.  The products with k_expLn2High are exact without it, since k_expLn2High has 32 trailing zero bits
+TML_INLINE static double ExpFast(double x) {
+   // comparisons with NaN are false, so NaN flows through both clamps
+   x = k_expMax < x ? k_expMax : x;
+   x = x < k_expMin ? k_expMin : x;
+   const double n = std::nearbyint(x * k_expLog2E);
+   const double r = (x - n * k_expLn2High) - n * k_expLn2Low;
+   double poly = k_aExpTaylor[k_iExpTaylorFast];
+   for(size_t iTerm = k_iExpTaylorFast + 1; iTerm < k_cExpTaylor; ++iTerm) {
+      poly = poly * r + k_aExpTaylor[iTerm];
+   }
+   // NaN can't be converted to an integer, but poly is already NaN in that case
+   const int64_t nInt = std::isnan(n) ? 0 : static_cast<int64_t>(n);
+   const int64_t nHalf1 = nInt / 2;
+   return poly * ScaleFromExponent(nHalf1) * ScaleFromExponent(nInt - nHalf1);
+}
+
+TML_INLINE static double LogFast(const double x) {
+   const bool bSubnormal = x < std::numeric_limits<double>::min();
+   const double xNormal = bSubnormal ? x * k_logSubnormalScale : x;
+   uint64_t bits;
+   memcpy(&bits, &xNormal, sizeof(bits));
+   double exponent = static_cast<double>(bits >> k_doubleMantissaBits) - (bSubnormal ? k_doubleExponentBias + k_logSubnormalExponent : k_doubleExponentBias);
+   bits = (bits & k_doubleMantissaMask) | k_doubleOneBits;
+   double mantissa;
+   memcpy(&mantissa, &bits, sizeof(mantissa));
+   const bool bHigh = k_logSqrt2 < mantissa;
+   mantissa = bHigh ? mantissa * 0.5 : mantissa;
+   exponent = bHigh ? exponent + 1.0 : exponent;
+
+   const double s = (mantissa - 1.0) / (mantissa + 1.0);
+   const double s2 = s * s;
+   double poly = k_aLogAtanh[0];
+   for(size_t iTerm = 1; iTerm < k_cLogAtanh; ++iTerm) {
+      poly = poly * s2 + k_aLogAtanh[iTerm];
+   }
+   const double result = exponent * k_expLn2High + (exponent * k_expLn2Low + s * poly);
+   // our bit manipulation above is meaningless for these, but they all have simple answers
+   return 0.0 == x ? -std::numeric_limits<double>::infinity() : x < 0.0 ? std::numeric_limits<double>::quiet_NaN() : x < std::numeric_limits<double>::infinity() ? result : x;
+}
+
+// log(1 + exp(x)) = max(x, 0) + log1p(exp(-|x|)).  exp(-|x|) is in [0, 1], so this can't overflow, and log1p(y) = log(u) - ((u - 1) - y) / u with
+// u = 1 + y corrects for the rounding of 1 + y
+TML_INLINE static double SoftplusFast(const double x) {
+   const double y = ExpFast(-std::abs(x));
+   const double u = 1.0 + y;
+   return (0.0 < x ? x : 0.0) + (LogFast(u) - ((u - 1.0) - y) / u);
+}
+
+template<typename TFloat>
+static void BinaryclassResidualFastScalar(const FractionalDataType * const aModelUpdateTensor, const int64_t * const aiBins, const int64_t * const aTargets, TFloat * const aPredictionScores, TFloat * const aResidualErrors, const size_t cCases) {
+   for(size_t iCase = 0; iCase < cCases; ++iCase) {
+      const FractionalDataType smallChangeToPredictionScores = aModelUpdateTensor[static_cast<size_t>(aiBins[iCase])];
+      const TFloat trainingPredictionScore = static_cast<TFloat>(static_cast<FractionalDataType>(aPredictionScores[iCase]) + smallChangeToPredictionScores);
+      aPredictionScores[iCase] = trainingPredictionScore;
+      // the same calculation as ComputeClassificationResidualErrorBinaryclass with our fast exp
+      const bool bTargetZero = 0 == aTargets[iCase];
+      const FractionalDataType residualError = (bTargetZero ? -1.0 : 1.0) / (1.0 + ExpFast(bTargetZero ? -static_cast<FractionalDataType>(trainingPredictionScore) : static_cast<FractionalDataType>(trainingPredictionScore)));
+      aResidualErrors[iCase] = static_cast<TFloat>(residualError);
+   }
+}
+
+template<typename TFloat>
+static void ExpFastScalar(const TFloat * const aValues, FractionalDataType * const aExps, const size_t cValues) {
+   for(size_t iValue = 0; iValue < cValues; ++iValue) {
+      aExps[iValue] = ExpFast(static_cast<FractionalDataType>(aValues[iValue]));
+   }
+}
+
+template<typename TFloat>
+static void BinaryclassLogLossScalar(const FractionalDataType * const aModelUpdateTensor, const int64_t * const aiBins, const int64_t * const aTargets, TFloat * const aPredictionScores, FractionalDataType * const aLogLosses, const size_t cCases) {
+   for(size_t iCase = 0; iCase < cCases; ++iCase) {
+      const FractionalDataType smallChangeToPredictionScores = aModelUpdateTensor[static_cast<size_t>(aiBins[iCase])];
+      const TFloat validationPredictionScore = static_cast<TFloat>(static_cast<FractionalDataType>(aPredictionScores[iCase]) + smallChangeToPredictionScores);
+      aPredictionScores[iCase] = validationPredictionScore;
+      aLogLosses[iCase] = EbmStatistics::ComputeClassificationSingleCaseLogLossBinaryclass(static_cast<FractionalDataType>(validationPredictionScore), static_cast<StorageDataTypeCore>(aTargets[iCase]));
+   }
+}
+
+template<typename TFloat>
+static void BinaryclassLogLossFastScalar(const FractionalDataType * const aModelUpdateTensor, const int64_t * const aiBins, const int64_t * const aTargets, TFloat * const aPredictionScores, FractionalDataType * const aLogLosses, const size_t cCases) {
+   for(size_t iCase = 0; iCase < cCases; ++iCase) {
+      const FractionalDataType smallChangeToPredictionScores = aModelUpdateTensor[static_cast<size_t>(aiBins[iCase])];
+      const TFloat validationPredictionScore = static_cast<TFloat>(static_cast<FractionalDataType>(aPredictionScores[iCase]) + smallChangeToPredictionScores);
+      aPredictionScores[iCase] = validationPredictionScore;
+      const FractionalDataType score = static_cast<FractionalDataType>(validationPredictionScore);
+      aLogLosses[iCase] = SoftplusFast(0 == aTargets[iCase] ? score : -score);
+   }
+}
+
+static void LogScalar(const FractionalDataType * const aValues, FractionalDataType * const aLogs, const size_t cValues) {
+   for(size_t iValue = 0; iValue < cValues; ++iValue) {
+      aLogs[iValue] = std::log(aValues[iValue]);
+   }
+}
+
+static void LogFastScalar(const FractionalDataType * const aValues, FractionalDataType * const aLogs, const size_t cValues) {
+   for(size_t iValue = 0; iValue < cValues; ++iValue) {
+      aLogs[iValue] = LogFast(aValues[iValue]);
+   }
+}
+
+#ifdef SIMD_KERNELS_X86
+
+// iFirstTerm selects where we start in k_aExpTaylor, which is k_iExpTaylorExact or k_iExpTaylorFast
+template<size_t iFirstTerm>
+TARGET_AVX2 static __m256d ExpAvx2(__m256d x) {
+   // min and max return their second operand if either is a NaN, so putting x second lets NaN flow through to our result
+   x = _mm256_min_pd(_mm256_set1_pd(k_expMax), _mm256_max_pd(_mm256_set1_pd(k_expMin), x));
+   const __m256d n = _mm256_round_pd(_mm256_mul_pd(x, _mm256_set1_pd(k_expLog2E)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+   __m256d r = _mm256_fnmadd_pd(n, _mm256_set1_pd(k_expLn2High), x);
+   r = _mm256_fnmadd_pd(n, _mm256_set1_pd(k_expLn2Low), r);
+
+   __m256d poly = _mm256_set1_pd(k_aExpTaylor[iFirstTerm]);
+   for(size_t iTerm = iFirstTerm + 1; iTerm < k_cExpTaylor; ++iTerm) {
+      poly = _mm256_fmadd_pd(poly, r, _mm256_set1_pd(k_aExpTaylor[iTerm]));
+   }
+
+   // n can be anywhere in [-1076, 1024], which doesn't fit into a double's exponent, so we multiply by 2^(n/2) twice.  This also gets us gradual
+   // underflow and overflow to infinity for free
+   const __m128i nInt = _mm256_cvtpd_epi32(n);
+   const __m128i nHalf1 = _mm_srai_epi32(nInt, 1);
+   const __m128i nHalf2 = _mm_sub_epi32(nInt, nHalf1);
+   const __m256i bias = _mm256_set1_epi64x(k_doubleExponentBias);
+   const __m256d scale1 = _mm256_castsi256_pd(_mm256_slli_epi64(_mm256_add_epi64(_mm256_cvtepi32_epi64(nHalf1), bias), k_doubleMantissaBits));
+   const __m256d scale2 = _mm256_castsi256_pd(_mm256_slli_epi64(_mm256_add_epi64(_mm256_cvtepi32_epi64(nHalf2), bias), k_doubleMantissaBits));
+   return _mm256_mul_pd(_mm256_mul_pd(poly, scale1), scale2);
+}
+
+// see LogFast for a description of this calculation
+TARGET_AVX2 static __m256d LogFastAvx2(const __m256d x) {
+   const __m256d isSubnormal = _mm256_cmp_pd(x, _mm256_set1_pd(std::numeric_limits<double>::min()), _CMP_LT_OQ);
+   const __m256i bits = _mm256_castpd_si256(_mm256_blendv_pd(x, _mm256_mul_pd(x, _mm256_set1_pd(k_logSubnormalScale)), isSubnormal));
+   const __m256d twoPow52 = _mm256_set1_pd(k_twoPow52);
+   const __m256d exponentBits = _mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(_mm256_srli_epi64(bits, k_doubleMantissaBits), _mm256_castpd_si256(twoPow52))), twoPow52);
+   __m256d exponent = _mm256_sub_pd(exponentBits, _mm256_blendv_pd(_mm256_set1_pd(k_doubleExponentBias), _mm256_set1_pd(k_doubleExponentBias + k_logSubnormalExponent), isSubnormal));
+   __m256d mantissa = _mm256_castsi256_pd(_mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi64x(static_cast<int64_t>(k_doubleMantissaMask))), _mm256_set1_epi64x(static_cast<int64_t>(k_doubleOneBits))));
+   const __m256d isHigh = _mm256_cmp_pd(mantissa, _mm256_set1_pd(k_logSqrt2), _CMP_GT_OQ);
+   const __m256d one = _mm256_set1_pd(1.0);
+   mantissa = _mm256_blendv_pd(mantissa, _mm256_mul_pd(mantissa, _mm256_set1_pd(0.5)), isHigh);
+   exponent = _mm256_add_pd(exponent, _mm256_and_pd(isHigh, one));
+
+   const __m256d s = _mm256_div_pd(_mm256_sub_pd(mantissa, one), _mm256_add_pd(mantissa, one));
+   const __m256d s2 = _mm256_mul_pd(s, s);
+   __m256d poly = _mm256_set1_pd(k_aLogAtanh[0]);
+   for(size_t iTerm = 1; iTerm < k_cLogAtanh; ++iTerm) {
+      poly = _mm256_fmadd_pd(poly, s2, _mm256_set1_pd(k_aLogAtanh[iTerm]));
+   }
+   __m256d result = _mm256_fmadd_pd(exponent, _mm256_set1_pd(k_expLn2High), _mm256_fmadd_pd(exponent, _mm256_set1_pd(k_expLn2Low), _mm256_mul_pd(s, poly)));
+
+   const __m256d zero = _mm256_setzero_pd();
+   result = _mm256_blendv_pd(result, x, _mm256_cmp_pd(x, _mm256_set1_pd(std::numeric_limits<double>::infinity()), _CMP_NLT_UQ));
+   result = _mm256_blendv_pd(result, _mm256_set1_pd(-std::numeric_limits<double>::infinity()), _mm256_cmp_pd(x, zero, _CMP_EQ_OQ));
+   return _mm256_blendv_pd(result, _mm256_set1_pd(std::numeric_limits<double>::quiet_NaN()), _mm256_cmp_pd(x, zero, _CMP_LT_OQ));
+}
+
+// see SoftplusFast for a description of this calculation
+TARGET_AVX2 static __m256d SoftplusFastAvx2(const __m256d x) {
+   const __m256d absX = _mm256_andnot_pd(_mm256_set1_pd(-0.0), x);
+   const __m256d y = ExpAvx2<k_iExpTaylorFast>(_mm256_sub_pd(_mm256_setzero_pd(), absX));
+   const __m256d one = _mm256_set1_pd(1.0);
+   const __m256d u = _mm256_add_pd(one, y);
+   const __m256d log1p = _mm256_sub_pd(LogFastAvx2(u), _mm256_div_pd(_mm256_sub_pd(_mm256_sub_pd(u, one), y), u));
+   // max returns its second operand if either is a NaN, which keeps NaN
+   return _mm256_add_pd(_mm256_max_pd(_mm256_setzero_pd(), x), log1p);
+}
+
+TARGET_AVX2 TML_INLINE static __m256d LoadAvx2(const double * const a) {
+   return _mm256_loadu_pd(a);
+}
+TARGET_AVX2 TML_INLINE static __m256d LoadAvx2(const float * const a) {
+   return _mm256_cvtps_pd(_mm_loadu_ps(a));
+}
+TARGET_AVX2 TML_INLINE static void StoreAvx2(double * const a, const __m256d value) {
+   _mm256_storeu_pd(a, value);
+}
+TARGET_AVX2 TML_INLINE static void StoreAvx2(float * const a, const __m256d value) {
+   _mm_storeu_ps(a, _mm256_cvtpd_ps(value));
+}
+// returns the value that was stored, which is rounded to TFloat
+TARGET_AVX2 TML_INLINE static __m256d RoundAvx2(const double *, const __m256d value) {
+   return value;
+}
+TARGET_AVX2 TML_INLINE static __m256d RoundAvx2(const float *, const __m256d value) {
+   return _mm256_cvtps_pd(_mm256_cvtpd_ps(value));
+}
+
+template<typename TFloat, size_t iFirstTerm>
+TARGET_AVX2 static void BinaryclassResidualAvx2Step(const FractionalDataType * const aModelUpdateTensor, const int64_t * const aiBins, const int64_t * const aTargets, TFloat * const aPredictionScores, TFloat * const aResidualErrors) {
+   const __m256d smallChangeToPredictionScores = _mm256_i64gather_pd(aModelUpdateTensor, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(aiBins)), sizeof(double));
+   const __m256d trainingPredictionScores = RoundAvx2(aPredictionScores, _mm256_add_pd(LoadAvx2(aPredictionScores), smallChangeToPredictionScores));
+   StoreAvx2(aPredictionScores, trainingPredictionScores);
+
+   // ComputeClassificationResidualErrorBinaryclass negates both the prediction score and the result when the target is zero, which is flipping the sign bit
+   const __m256i isTargetZero = _mm256_cmpeq_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(aTargets)), _mm256_setzero_si256());
+   const __m256d signFlip = _mm256_castsi256_pd(_mm256_and_si256(isTargetZero, _mm256_set1_epi64x(k_doubleSignBit)));
+   const __m256d one = _mm256_set1_pd(1.0);
+   const __m256d expValues = ExpAvx2<iFirstTerm>(_mm256_xor_pd(trainingPredictionScores, signFlip));
+   const __m256d residualError = _mm256_xor_pd(_mm256_div_pd(one, _mm256_add_pd(one, expValues)), signFlip);
+   StoreAvx2(aResidualErrors, residualError);
+}
+
+template<typename TFloat, size_t iFirstTerm>
+TARGET_AVX2 static void BinaryclassResidualAvx2(const FractionalDataType * const aModelUpdateTensor, const int64_t * const aiBins, const int64_t * const aTargets, TFloat * const aPredictionScores, TFloat * const aResidualErrors, const size_t cCases) {
+   constexpr size_t cLanes = 4;
+   size_t iCase = 0;
+   for(; iCase + cLanes <= cCases; iCase += cLanes) {
+      BinaryclassResidualAvx2Step<TFloat, iFirstTerm>(aModelUpdateTensor, &aiBins[iCase], &aTargets[iCase], &aPredictionScores[iCase], &aResidualErrors[iCase]);
+   }
+   const size_t cRemaining = cCases - iCase;
+   if(0 != cRemaining) {
+      // we put the last few cases through the same vector calculation so that every case gets the same result regardless of where our caller splits
+      // the cases.  The padding lanes look up bin zero, which always exists
+      int64_t aiBinsTail[cLanes] = { 0 };
+      int64_t aTargetsTail[cLanes] = { 0 };
+      TFloat aPredictionScoresTail[cLanes] = { 0 };
+      TFloat aResidualErrorsTail[cLanes];
+      for(size_t iTail = 0; iTail < cRemaining; ++iTail) {
+         aiBinsTail[iTail] = aiBins[iCase + iTail];
+         aTargetsTail[iTail] = aTargets[iCase + iTail];
+         aPredictionScoresTail[iTail] = aPredictionScores[iCase + iTail];
+      }
+      BinaryclassResidualAvx2Step<TFloat, iFirstTerm>(aModelUpdateTensor, aiBinsTail, aTargetsTail, aPredictionScoresTail, aResidualErrorsTail);
+      for(size_t iTail = 0; iTail < cRemaining; ++iTail) {
+         aPredictionScores[iCase + iTail] = aPredictionScoresTail[iTail];
+         aResidualErrors[iCase + iTail] = aResidualErrorsTail[iTail];
+      }
+   }
+}
+
+// g++ 12 warns about the deliberately undefined vectors inside its own avx512fintrin.h helpers when they're inlined into our functions
+WARNING_PUSH
+WARNING_DISABLE_UNINITIALIZED_LOCAL_VARIABLE
+
+template<typename TFloat, size_t iFirstTerm>
+TARGET_AVX2 static void ExpKernelAvx2(const TFloat * const aValues, FractionalDataType * const aExps, const size_t cValues) {
+   constexpr size_t cLanes = 4;
+   size_t iValue = 0;
+   for(; iValue + cLanes <= cValues; iValue += cLanes) {
+      _mm256_storeu_pd(&aExps[iValue], ExpAvx2<iFirstTerm>(LoadAvx2(&aValues[iValue])));
+   }
+   const size_t cRemaining = cValues - iValue;
+   if(0 != cRemaining) {
+      // see BinaryclassResidualAvx2 for why we don't finish with scalar code
+      TFloat aValuesTail[cLanes] = { 0 };
+      FractionalDataType aExpsTail[cLanes];
+      for(size_t iTail = 0; iTail < cRemaining; ++iTail) {
+         aValuesTail[iTail] = aValues[iValue + iTail];
+      }
+      _mm256_storeu_pd(aExpsTail, ExpAvx2<iFirstTerm>(LoadAvx2(aValuesTail)));
+      for(size_t iTail = 0; iTail < cRemaining; ++iTail) {
+         aExps[iValue + iTail] = aExpsTail[iTail];
+      }
+   }
+}
+
+template<typename TFloat>
+TARGET_AVX2 static void BinaryclassLogLossAvx2Step(const FractionalDataType * const aModelUpdateTensor, const int64_t * const aiBins, const int64_t * const aTargets, TFloat * const aPredictionScores, FractionalDataType * const aLogLosses) {
+   const __m256d smallChangeToPredictionScores = _mm256_i64gather_pd(aModelUpdateTensor, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(aiBins)), sizeof(double));
+   const __m256d validationPredictionScores = RoundAvx2(aPredictionScores, _mm256_add_pd(LoadAvx2(aPredictionScores), smallChangeToPredictionScores));
+   StoreAvx2(aPredictionScores, validationPredictionScores);
+
+   // ComputeClassificationSingleCaseLogLossBinaryclass negates the prediction score when the target is one
+   const __m256i isTargetOne = _mm256_cmpeq_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(aTargets)), _mm256_set1_epi64x(1));
+   const __m256d signFlip = _mm256_castsi256_pd(_mm256_and_si256(isTargetOne, _mm256_set1_epi64x(k_doubleSignBit)));
+   _mm256_storeu_pd(aLogLosses, SoftplusFastAvx2(_mm256_xor_pd(validationPredictionScores, signFlip)));
+}
+
+template<typename TFloat>
+TARGET_AVX2 static void BinaryclassLogLossAvx2(const FractionalDataType * const aModelUpdateTensor, const int64_t * const aiBins, const int64_t * const aTargets, TFloat * const aPredictionScores, FractionalDataType * const aLogLosses, const size_t cCases) {
+   constexpr size_t cLanes = 4;
+   size_t iCase = 0;
+   for(; iCase + cLanes <= cCases; iCase += cLanes) {
+      BinaryclassLogLossAvx2Step<TFloat>(aModelUpdateTensor, &aiBins[iCase], &aTargets[iCase], &aPredictionScores[iCase], &aLogLosses[iCase]);
+   }
+   const size_t cRemaining = cCases - iCase;
+   if(0 != cRemaining) {
+      // see BinaryclassResidualAvx2 for why we don't finish with scalar code
+      int64_t aiBinsTail[cLanes] = { 0 };
+      int64_t aTargetsTail[cLanes] = { 0 };
+      TFloat aPredictionScoresTail[cLanes] = { 0 };
+      FractionalDataType aLogLossesTail[cLanes];
+      for(size_t iTail = 0; iTail < cRemaining; ++iTail) {
+         aiBinsTail[iTail] = aiBins[iCase + iTail];
+         aTargetsTail[iTail] = aTargets[iCase + iTail];
+         aPredictionScoresTail[iTail] = aPredictionScores[iCase + iTail];
+      }
+      BinaryclassLogLossAvx2Step<TFloat>(aModelUpdateTensor, aiBinsTail, aTargetsTail, aPredictionScoresTail, aLogLossesTail);
+      for(size_t iTail = 0; iTail < cRemaining; ++iTail) {
+         aPredictionScores[iCase + iTail] = aPredictionScoresTail[iTail];
+         aLogLosses[iCase + iTail] = aLogLossesTail[iTail];
+      }
+   }
+}
+
+TARGET_AVX2 static void LogFastKernelAvx2(const FractionalDataType * const aValues, FractionalDataType * const aLogs, const size_t cValues) {
+   constexpr size_t cLanes = 4;
+   size_t iValue = 0;
+   for(; iValue + cLanes <= cValues; iValue += cLanes) {
+      _mm256_storeu_pd(&aLogs[iValue], LogFastAvx2(_mm256_loadu_pd(&aValues[iValue])));
+   }
+   const size_t cRemaining = cValues - iValue;
+   if(0 != cRemaining) {
+      FractionalDataType aValuesTail[cLanes] = { 1.0, 1.0, 1.0, 1.0 };
+      FractionalDataType aLogsTail[cLanes];
+      for(size_t iTail = 0; iTail < cRemaining; ++iTail) {
+         aValuesTail[iTail] = aValues[iValue + iTail];
+      }
+      _mm256_storeu_pd(aLogsTail, LogFastAvx2(_mm256_loadu_pd(aValuesTail)));
+      for(size_t iTail = 0; iTail < cRemaining; ++iTail) {
+         aLogs[iValue + iTail] = aLogsTail[iTail];
+      }
+   }
+}
+
+template<size_t iFirstTerm>
+TARGET_AVX512 static __m512d ExpAvx512(__m512d x) {
+   // see ExpAvx2 for a description of this calculation.  It differs only in vector width
+   x = _mm512_min_pd(_mm512_set1_pd(k_expMax), _mm512_max_pd(_mm512_set1_pd(k_expMin), x));
+   const __m512d n = _mm512_roundscale_pd(_mm512_mul_pd(x, _mm512_set1_pd(k_expLog2E)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+   __m512d r = _mm512_fnmadd_pd(n, _mm512_set1_pd(k_expLn2High), x);
+   r = _mm512_fnmadd_pd(n, _mm512_set1_pd(k_expLn2Low), r);
+
+   __m512d poly = _mm512_set1_pd(k_aExpTaylor[iFirstTerm]);
+   for(size_t iTerm = iFirstTerm + 1; iTerm < k_cExpTaylor; ++iTerm) {
+      poly = _mm512_fmadd_pd(poly, r, _mm512_set1_pd(k_aExpTaylor[iTerm]));
+   }
+
+   const __m256i nInt = _mm512_cvtpd_epi32(n);
+   const __m256i nHalf1 = _mm256_srai_epi32(nInt, 1);
+   const __m256i nHalf2 = _mm256_sub_epi32(nInt, nHalf1);
+   const __m512i bias = _mm512_set1_epi64(k_doubleExponentBias);
+   const __m512d scale1 = _mm512_castsi512_pd(_mm512_slli_epi64(_mm512_add_epi64(_mm512_cvtepi32_epi64(nHalf1), bias), k_doubleMantissaBits));
+   const __m512d scale2 = _mm512_castsi512_pd(_mm512_slli_epi64(_mm512_add_epi64(_mm512_cvtepi32_epi64(nHalf2), bias), k_doubleMantissaBits));
+   return _mm512_mul_pd(_mm512_mul_pd(poly, scale1), scale2);
+}
+
+// see LogFast for a description of this calculation.  Like BinaryclassResidualAvx512Step we stick to AVX512F, so our bit manipulations are integer instructions
+TARGET_AVX512 static __m512d LogFastAvx512(const __m512d x) {
+   const __mmask8 isSubnormal = _mm512_cmp_pd_mask(x, _mm512_set1_pd(std::numeric_limits<double>::min()), _CMP_LT_OQ);
+   const __m512i bits = _mm512_castpd_si512(_mm512_mask_mul_pd(x, isSubnormal, x, _mm512_set1_pd(k_logSubnormalScale)));
+   const __m512d twoPow52 = _mm512_set1_pd(k_twoPow52);
+   const __m512d exponentBits = _mm512_sub_pd(_mm512_castsi512_pd(_mm512_or_si512(_mm512_srli_epi64(bits, k_doubleMantissaBits), _mm512_castpd_si512(twoPow52))), twoPow52);
+   __m512d exponent = _mm512_sub_pd(exponentBits, _mm512_mask_blend_pd(isSubnormal, _mm512_set1_pd(k_doubleExponentBias), _mm512_set1_pd(k_doubleExponentBias + k_logSubnormalExponent)));
+   __m512d mantissa = _mm512_castsi512_pd(_mm512_or_si512(_mm512_and_si512(bits, _mm512_set1_epi64(static_cast<int64_t>(k_doubleMantissaMask))), _mm512_set1_epi64(static_cast<int64_t>(k_doubleOneBits))));
+   const __mmask8 isHigh = _mm512_cmp_pd_mask(mantissa, _mm512_set1_pd(k_logSqrt2), _CMP_GT_OQ);
+   const __m512d one = _mm512_set1_pd(1.0);
+   mantissa = _mm512_mask_mul_pd(mantissa, isHigh, mantissa, _mm512_set1_pd(0.5));
+   exponent = _mm512_mask_add_pd(exponent, isHigh, exponent, one);
+
+   const __m512d s = _mm512_div_pd(_mm512_sub_pd(mantissa, one), _mm512_add_pd(mantissa, one));
+   const __m512d s2 = _mm512_mul_pd(s, s);
+   __m512d poly = _mm512_set1_pd(k_aLogAtanh[0]);
+   for(size_t iTerm = 1; iTerm < k_cLogAtanh; ++iTerm) {
+      poly = _mm512_fmadd_pd(poly, s2, _mm512_set1_pd(k_aLogAtanh[iTerm]));
+   }
+   __m512d result = _mm512_fmadd_pd(exponent, _mm512_set1_pd(k_expLn2High), _mm512_fmadd_pd(exponent, _mm512_set1_pd(k_expLn2Low), _mm512_mul_pd(s, poly)));
+
+   const __m512d zero = _mm512_setzero_pd();
+   result = _mm512_mask_blend_pd(_mm512_cmp_pd_mask(x, _mm512_set1_pd(std::numeric_limits<double>::infinity()), _CMP_NLT_UQ), result, x);
+   result = _mm512_mask_blend_pd(_mm512_cmp_pd_mask(x, zero, _CMP_EQ_OQ), result, _mm512_set1_pd(-std::numeric_limits<double>::infinity()));
+   return _mm512_mask_blend_pd(_mm512_cmp_pd_mask(x, zero, _CMP_LT_OQ), result, _mm512_set1_pd(std::numeric_limits<double>::quiet_NaN()));
+}
+
+TARGET_AVX512 static __m512d SoftplusFastAvx512(const __m512d x) {
+   const __m512d absX = _mm512_castsi512_pd(_mm512_and_si512(_mm512_castpd_si512(x), _mm512_set1_epi64(static_cast<int64_t>(~static_cast<uint64_t>(k_doubleSignBit)))));
+   const __m512d y = ExpAvx512<k_iExpTaylorFast>(_mm512_sub_pd(_mm512_setzero_pd(), absX));
+   const __m512d one = _mm512_set1_pd(1.0);
+   const __m512d u = _mm512_add_pd(one, y);
+   const __m512d log1p = _mm512_sub_pd(LogFastAvx512(u), _mm512_div_pd(_mm512_sub_pd(_mm512_sub_pd(u, one), y), u));
+   return _mm512_add_pd(_mm512_max_pd(_mm512_setzero_pd(), x), log1p);
+}
+
+TARGET_AVX512 TML_INLINE static __m512d LoadAvx512(const double * const a) {
+   return _mm512_loadu_pd(a);
+}
+TARGET_AVX512 TML_INLINE static __m512d LoadAvx512(const float * const a) {
+   return _mm512_cvtps_pd(_mm256_loadu_ps(a));
+}
+TARGET_AVX512 TML_INLINE static void StoreAvx512(double * const a, const __m512d value) {
+   _mm512_storeu_pd(a, value);
+}
+TARGET_AVX512 TML_INLINE static void StoreAvx512(float * const a, const __m512d value) {
+   _mm256_storeu_ps(a, _mm512_cvtpd_ps(value));
+}
+TARGET_AVX512 TML_INLINE static __m512d RoundAvx512(const double *, const __m512d value) {
+   return value;
+}
+TARGET_AVX512 TML_INLINE static __m512d RoundAvx512(const float *, const __m512d value) {
+   return _mm512_cvtps_pd(_mm512_cvtpd_ps(value));
+}
+
+template<typename TFloat, size_t iFirstTerm>
+TARGET_AVX512 static void BinaryclassResidualAvx512Step(const FractionalDataType * const aModelUpdateTensor, const int64_t * const aiBins, const int64_t * const aTargets, TFloat * const aPredictionScores, TFloat * const aResidualErrors) {
+   const __m512d smallChangeToPredictionScores = _mm512_i64gather_pd(_mm512_loadu_si512(aiBins), aModelUpdateTensor, sizeof(double));
+   const __m512d trainingPredictionScores = RoundAvx512(aPredictionScores, _mm512_add_pd(LoadAvx512(aPredictionScores), smallChangeToPredictionScores));
+   StoreAvx512(aPredictionScores, trainingPredictionScores);
+
+   // xor on doubles needs AVX512DQ, so we flip the sign bits with integer instructions to only require AVX512F
+   const __mmask8 isTargetZero = _mm512_cmpeq_epi64_mask(_mm512_loadu_si512(aTargets), _mm512_setzero_si512());
+   const __m512i signFlip = _mm512_maskz_mov_epi64(isTargetZero, _mm512_set1_epi64(k_doubleSignBit));
+   const __m512d one = _mm512_set1_pd(1.0);
+   const __m512d expValues = ExpAvx512<iFirstTerm>(_mm512_castsi512_pd(_mm512_xor_si512(_mm512_castpd_si512(trainingPredictionScores), signFlip)));
+   const __m512d residualError = _mm512_castsi512_pd(_mm512_xor_si512(_mm512_castpd_si512(_mm512_div_pd(one, _mm512_add_pd(one, expValues))), signFlip));
+   StoreAvx512(aResidualErrors, residualError);
+}
+
+template<typename TFloat, size_t iFirstTerm>
+TARGET_AVX512 static void BinaryclassResidualAvx512(const FractionalDataType * const aModelUpdateTensor, const int64_t * const aiBins, const int64_t * const aTargets, TFloat * const aPredictionScores, TFloat * const aResidualErrors, const size_t cCases) {
+   constexpr size_t cLanes = 8;
+   size_t iCase = 0;
+   for(; iCase + cLanes <= cCases; iCase += cLanes) {
+      BinaryclassResidualAvx512Step<TFloat, iFirstTerm>(aModelUpdateTensor, &aiBins[iCase], &aTargets[iCase], &aPredictionScores[iCase], &aResidualErrors[iCase]);
+   }
+   const size_t cRemaining = cCases - iCase;
+   if(0 != cRemaining) {
+      // see BinaryclassResidualAvx2 for why we don't finish with scalar code
+      int64_t aiBinsTail[cLanes] = { 0 };
+      int64_t aTargetsTail[cLanes] = { 0 };
+      TFloat aPredictionScoresTail[cLanes] = { 0 };
+      TFloat aResidualErrorsTail[cLanes];
+      for(size_t iTail = 0; iTail < cRemaining; ++iTail) {
+         aiBinsTail[iTail] = aiBins[iCase + iTail];
+         aTargetsTail[iTail] = aTargets[iCase + iTail];
+         aPredictionScoresTail[iTail] = aPredictionScores[iCase + iTail];
+      }
+      BinaryclassResidualAvx512Step<TFloat, iFirstTerm>(aModelUpdateTensor, aiBinsTail, aTargetsTail, aPredictionScoresTail, aResidualErrorsTail);
+      for(size_t iTail = 0; iTail < cRemaining; ++iTail) {
+         aPredictionScores[iCase + iTail] = aPredictionScoresTail[iTail];
+         aResidualErrors[iCase + iTail] = aResidualErrorsTail[iTail];
+      }
+   }
+}
+
+template<typename TFloat, size_t iFirstTerm>
+TARGET_AVX512 static void ExpKernelAvx512(const TFloat * const aValues, FractionalDataType * const aExps, const size_t cValues) {
+   constexpr size_t cLanes = 8;
+   size_t iValue = 0;
+   for(; iValue + cLanes <= cValues; iValue += cLanes) {
+      _mm512_storeu_pd(&aExps[iValue], ExpAvx512<iFirstTerm>(LoadAvx512(&aValues[iValue])));
+   }
+   const size_t cRemaining = cValues - iValue;
+   if(0 != cRemaining) {
+      TFloat aValuesTail[cLanes] = { 0 };
+      FractionalDataType aExpsTail[cLanes];
+      for(size_t iTail = 0; iTail < cRemaining; ++iTail) {
+         aValuesTail[iTail] = aValues[iValue + iTail];
+      }
+      _mm512_storeu_pd(aExpsTail, ExpAvx512<iFirstTerm>(LoadAvx512(aValuesTail)));
+      for(size_t iTail = 0; iTail < cRemaining; ++iTail) {
+         aExps[iValue + iTail] = aExpsTail[iTail];
+      }
+   }
+}
+
+template<typename TFloat>
+TARGET_AVX512 static void BinaryclassLogLossAvx512Step(const FractionalDataType * const aModelUpdateTensor, const int64_t * const aiBins, const int64_t * const aTargets, TFloat * const aPredictionScores, FractionalDataType * const aLogLosses) {
+   const __m512d smallChangeToPredictionScores = _mm512_i64gather_pd(_mm512_loadu_si512(aiBins), aModelUpdateTensor, sizeof(double));
+   const __m512d validationPredictionScores = RoundAvx512(aPredictionScores, _mm512_add_pd(LoadAvx512(aPredictionScores), smallChangeToPredictionScores));
+   StoreAvx512(aPredictionScores, validationPredictionScores);
+
+   const __mmask8 isTargetOne = _mm512_cmpeq_epi64_mask(_mm512_loadu_si512(aTargets), _mm512_set1_epi64(1));
+   const __m512i signFlip = _mm512_maskz_mov_epi64(isTargetOne, _mm512_set1_epi64(k_doubleSignBit));
+   _mm512_storeu_pd(aLogLosses, SoftplusFastAvx512(_mm512_castsi512_pd(_mm512_xor_si512(_mm512_castpd_si512(validationPredictionScores), signFlip))));
+}
+
+template<typename TFloat>
+TARGET_AVX512 static void BinaryclassLogLossAvx512(const FractionalDataType * const aModelUpdateTensor, const int64_t * const aiBins, const int64_t * const aTargets, TFloat * const aPredictionScores, FractionalDataType * const aLogLosses, const size_t cCases) {
+   constexpr size_t cLanes = 8;
+   size_t iCase = 0;
+   for(; iCase + cLanes <= cCases; iCase += cLanes) {
+      BinaryclassLogLossAvx512Step<TFloat>(aModelUpdateTensor, &aiBins[iCase], &aTargets[iCase], &aPredictionScores[iCase], &aLogLosses[iCase]);
+   }
+   const size_t cRemaining = cCases - iCase;
+   if(0 != cRemaining) {
+      int64_t aiBinsTail[cLanes] = { 0 };
+      int64_t aTargetsTail[cLanes] = { 0 };
+      TFloat aPredictionScoresTail[cLanes] = { 0 };
+      FractionalDataType aLogLossesTail[cLanes];
+      for(size_t iTail = 0; iTail < cRemaining; ++iTail) {
+         aiBinsTail[iTail] = aiBins[iCase + iTail];
+         aTargetsTail[iTail] = aTargets[iCase + iTail];
+         aPredictionScoresTail[iTail] = aPredictionScores[iCase + iTail];
+      }
+      BinaryclassLogLossAvx512Step<TFloat>(aModelUpdateTensor, aiBinsTail, aTargetsTail, aPredictionScoresTail, aLogLossesTail);
+      for(size_t iTail = 0; iTail < cRemaining; ++iTail) {
+         aPredictionScores[iCase + iTail] = aPredictionScoresTail[iTail];
+         aLogLosses[iCase + iTail] = aLogLossesTail[iTail];
+      }
+   }
+}
+
+TARGET_AVX512 static void LogFastKernelAvx512(const FractionalDataType * const aValues, FractionalDataType * const aLogs, const size_t cValues) {
+   constexpr size_t cLanes = 8;
+   size_t iValue = 0;
+   for(; iValue + cLanes <= cValues; iValue += cLanes) {
+      _mm512_storeu_pd(&aLogs[iValue], LogFastAvx512(_mm512_loadu_pd(&aValues[iValue])));
+   }
+   const size_t cRemaining = cValues - iValue;
+   if(0 != cRemaining) {
+      FractionalDataType aValuesTail[cLanes] = { 1.0, 1.0, 1.0, 1.0, 1.0, 1.0, 1.0, 1.0 };
+      FractionalDataType aLogsTail[cLanes];
+      for(size_t iTail = 0; iTail < cRemaining; ++iTail) {
+         aValuesTail[iTail] = aValues[iValue + iTail];
+      }
+      _mm512_storeu_pd(aLogsTail, LogFastAvx512(_mm512_loadu_pd(aValuesTail)));
+      for(size_t iTail = 0; iTail < cRemaining; ++iTail) {
+         aLogs[iValue + iTail] = aLogsTail[iTail];
+      }
+   }
+}
+
+WARNING_POP
+
+static SimdLevelCore DetectSimdLevel() {
+#if defined(_MSC_VER) && !defined(__clang__)
+   int aCpuInfo[4];
+   __cpuid(aCpuInfo, 0);
+   if(aCpuInfo[0] < 7) {
+      return SimdLevelCore::ScalarCore;
+   }
+   __cpuid(aCpuInfo, 1);
+   constexpr int k_bitFma = 1 << 12;
+   constexpr int k_bitOsXSave = 1 << 27;
+   constexpr int k_bitAvx = 1 << 28;
+   if((k_bitFma | k_bitOsXSave | k_bitAvx) != ((k_bitFma | k_bitOsXSave | k_bitAvx) & aCpuInfo[2])) {
+      return SimdLevelCore::ScalarCore;
+   }
+   // the OS needs to save the upper register state on context switches before we can use it
+   const unsigned __int64 osSavedState = _xgetbv(0);
+   constexpr unsigned __int64 k_stateAvx = 0x6; // SSE and AVX
+   constexpr unsigned __int64 k_stateAvx512 = 0xE6; // SSE, AVX, opmask and both halves of the upper ZMM registers
+   if(k_stateAvx != (k_stateAvx & osSavedState)) {
+      return SimdLevelCore::ScalarCore;
+   }
+   __cpuidex(aCpuInfo, 7, 0);
+   constexpr int k_bitAvx2 = 1 << 5;
+   constexpr int k_bitAvx512F = 1 << 16;
+   if(0 == (k_bitAvx2 & aCpuInfo[1])) {
+      return SimdLevelCore::ScalarCore;
+   }
+   if(0 != (k_bitAvx512F & aCpuInfo[1]) && k_stateAvx512 == (k_stateAvx512 & osSavedState)) {
+      return SimdLevelCore::Avx512Core;
+   }
+   return SimdLevelCore::Avx2Core;
+#else // compiler
+   // __builtin_cpu_supports checks that the OS saves the wider registers in addition to checking the processor
+   __builtin_cpu_init();
+   if(__builtin_cpu_supports("avx512f")) {
+      return SimdLevelCore::Avx512Core;
+   }
+   if(__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+      return SimdLevelCore::Avx2Core;
+   }
+   return SimdLevelCore::ScalarCore;
+#endif // compiler
+}
+
+#else // SIMD_KERNELS_X86
+
+static SimdLevelCore DetectSimdLevel() {
+   return SimdLevelCore::ScalarCore;
+}
+
+#endif // SIMD_KERNELS_X86
+
+// EBM_SIMD_LEVEL lets benchmarks compare our variants without any code changes.  It can be "scalar", "avx2" or "avx512", and we ignore anything
+// else.  Asking for more than the processor supports gives the widest variant that it does support
+static SimdLevelCore GetInitialSimdLevel(const SimdLevelCore simdLevelDetected) {
+   const char * const sSimdLevel = getenv("EBM_SIMD_LEVEL");
+   if(nullptr == sSimdLevel) {
+      return simdLevelDetected;
+   }
+   SimdLevelCore simdLevelRequested;
+   if(0 == strcmp("scalar", sSimdLevel)) {
+      simdLevelRequested = SimdLevelCore::ScalarCore;
+   } else if(0 == strcmp("avx2", sSimdLevel)) {
+      simdLevelRequested = SimdLevelCore::Avx2Core;
+   } else if(0 == strcmp("avx512", sSimdLevel)) {
+      simdLevelRequested = SimdLevelCore::Avx512Core;
+   } else {
+      return simdLevelDetected;
+   }
+   return simdLevelRequested < simdLevelDetected ? simdLevelRequested : simdLevelDetected;
+}
+
+// we detect the processor once while we're being loaded.  Anything that runs before our initialization sees the zero initialized value, which
+// is our baseline variant and works everywhere
+static const SimdLevelCore g_simdLevelDetected = DetectSimdLevel();
+static std::atomic<SimdLevelCore> g_simdLevel(GetInitialSimdLevel(g_simdLevelDetected));
+
+SimdLevelCore GetSimdLevelCore() {
+   // each kernel call picks its variant independently, so we don't need any ordering with SetSimdLevel.  The variants don't all give the same results though.
+   // The vectorized binary classification residuals use our own exp and can be up to k_cBinaryclassResidualUlps from the scalar ones, so changing the
+   // level in the middle of training, or training on a processor with different instruction sets, can change classification models in their last bits
+   return g_simdLevel.load(std::memory_order_relaxed);
+}
+
+EBMCORE_IMPORT_EXPORT IntegerDataType EBMCORE_CALLING_CONVENTION SetSimdLevel(IntegerDataType simdLevel) {
+   LOG(TraceLevelInfo, "Entered SetSimdLevel: simdLevel=%" IntegerDataTypePrintf, simdLevel);
+
+   if(simdLevel < SimdLevelScalar || SimdLevelAvx512 < simdLevel) {
+      LOG(TraceLevelWarning, "WARNING SetSimdLevel unknown simdLevel");
+      return 1;
+   }
+   const SimdLevelCore simdLevelRequested = static_cast<SimdLevelCore>(simdLevel);
+   const SimdLevelCore simdLevelNew = simdLevelRequested < g_simdLevelDetected ? simdLevelRequested : g_simdLevelDetected;
+   g_simdLevel.store(simdLevelNew, std::memory_order_relaxed);
+
+   LOG(TraceLevelInfo, "Exited SetSimdLevel");
+   return 0;
+}
+
+EBMCORE_IMPORT_EXPORT IntegerDataType EBMCORE_CALLING_CONVENTION GetSimdLevel() {
+   return static_cast<IntegerDataType>(GetSimdLevelCore());
+}
+
+template<typename TFloat>
+BinaryclassResidualKernel<TFloat> GetBinaryclassResidualKernel(const MathBackendCore mathBackend) {
+   const bool bFast = MathBackendCore::FastCore == mathBackend;
+#ifdef SIMD_KERNELS_X86
+   const SimdLevelCore simdLevel = GetSimdLevelCore();
+   if(SimdLevelCore::Avx512Core == simdLevel) {
+      return bFast ? &BinaryclassResidualAvx512<TFloat, k_iExpTaylorFast> : &BinaryclassResidualAvx512<TFloat, k_iExpTaylorExact>;
+   }
+   if(SimdLevelCore::Avx2Core == simdLevel) {
+      return bFast ? &BinaryclassResidualAvx2<TFloat, k_iExpTaylorFast> : &BinaryclassResidualAvx2<TFloat, k_iExpTaylorExact>;
+   }
+#endif // SIMD_KERNELS_X86
+   return bFast ? &BinaryclassResidualFastScalar<TFloat> : &BinaryclassResidualScalar<TFloat>;
+}
+
+template BinaryclassResidualKernel<float> GetBinaryclassResidualKernel<float>(const MathBackendCore mathBackend);
+template BinaryclassResidualKernel<double> GetBinaryclassResidualKernel<double>(const MathBackendCore mathBackend);
+
+template<typename TFloat>
+BinaryclassLogLossKernel<TFloat> GetBinaryclassLogLossKernel(const MathBackendCore mathBackend) {
+   if(MathBackendCore::FastCore != mathBackend) {
+      // we don't have a vectorized log that matches std::log closely, so the exact log loss stays on libm
+      return &BinaryclassLogLossScalar<TFloat>;
+   }
+#ifdef SIMD_KERNELS_X86
+   const SimdLevelCore simdLevel = GetSimdLevelCore();
+   if(SimdLevelCore::Avx512Core == simdLevel) {
+      return &BinaryclassLogLossAvx512<TFloat>;
+   }
+   if(SimdLevelCore::Avx2Core == simdLevel) {
+      return &BinaryclassLogLossAvx2<TFloat>;
+   }
+#endif // SIMD_KERNELS_X86
+   return &BinaryclassLogLossFastScalar<TFloat>;
+}
+
+template BinaryclassLogLossKernel<float> GetBinaryclassLogLossKernel<float>(const MathBackendCore mathBackend);
+template BinaryclassLogLossKernel<double> GetBinaryclassLogLossKernel<double>(const MathBackendCore mathBackend);
+
+template<typename TFloat>
+ExpKernel<TFloat> GetExpKernel(const MathBackendCore mathBackend) {
+   const bool bFast = MathBackendCore::FastCore == mathBackend;
+#ifdef SIMD_KERNELS_X86
+   const SimdLevelCore simdLevel = GetSimdLevelCore();
+   if(SimdLevelCore::Avx512Core == simdLevel) {
+      return bFast ? &ExpKernelAvx512<TFloat, k_iExpTaylorFast> : &ExpKernelAvx512<TFloat, k_iExpTaylorExact>;
+   }
+   if(SimdLevelCore::Avx2Core == simdLevel) {
+      return bFast ? &ExpKernelAvx2<TFloat, k_iExpTaylorFast> : &ExpKernelAvx2<TFloat, k_iExpTaylorExact>;
+   }
+#endif // SIMD_KERNELS_X86
+   return bFast ? &ExpFastScalar<TFloat> : &ExpScalar<TFloat>;
+}
+
+template ExpKernel<float> GetExpKernel<float>(const MathBackendCore mathBackend);
+template ExpKernel<double> GetExpKernel<double>(const MathBackendCore mathBackend);
+
+LogKernel GetLogKernel(const MathBackendCore mathBackend) {
+   if(MathBackendCore::FastCore != mathBackend) {
+      return &LogScalar;
+   }
+#ifdef SIMD_KERNELS_X86
+   const SimdLevelCore simdLevel = GetSimdLevelCore();
+   if(SimdLevelCore::Avx512Core == simdLevel) {
+      return &LogFastKernelAvx512;
+   }
+   if(SimdLevelCore::Avx2Core == simdLevel) {
+      return &LogFastKernelAvx2;
+   }
+#endif // SIMD_KERNELS_X86
+   return &LogFastScalar;
+}
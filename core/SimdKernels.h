@@ -0,0 +1,205 @@
+// Copyright (c) 2018 Microsoft Corporation
+// Licensed under the MIT license.
+// Author: Paul Koch <code@koch.ninja>
+
+#ifndef SIMD_KERNELS_H
+#define SIMD_KERNELS_H
+
+#include <stddef.h> // size_t, ptrdiff_t
+#include <stdint.h> // int64_t, uint64_t, uint32_t
+#include <string.h> // memcpy
+#include <cmath> // std::isnan
+#include <limits> // numeric_limits
+#include <type_traits> // is_same
+
+#include "ebmcore.h" // FractionalDataType
+#include "EbmInternal.h" // TML_INLINE
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define SIMD_KERNELS_X86
+#endif // x86
+
+#if defined(SIMD_KERNELS_X86) && (defined(__clang__) || defined(__GNUC__))
+// g++ and clang only let us use intrinsics from instruction sets that are enabled for the function that uses them.  We compile for core2, so we
+// enable the wider instruction sets one function at a time.  Visual Studio allows any intrinsic anywhere, but it can't compile a function for a wider
+// instruction set than the rest of the module, so there RunSimdVariant below only has our baseline variant
+#define SIMD_TARGET_VARIANTS
+#define TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define TARGET_AVX512 __attribute__((target("avx512f,avx2,fma")))
+#else // SIMD_KERNELS_X86 && compiler
+#define TARGET_AVX2
+#define TARGET_AVX512
+#endif // SIMD_KERNELS_X86 && compiler
+
+// the instruction sets that we have hand written kernels and compiled variants of our hot loops for.  We compile for a baseline x64 processor
+// (-march=core2) and select the wider variants at runtime after checking that both the processor and the OS support them.  The values match
+// SimdLevelScalar, SimdLevelAvx2 and SimdLevelAvx512 in ebmcore.h
+enum class SimdLevelCore { ScalarCore = 0, Avx2Core = 1, Avx512Core = 2 };
+
+// returns the instruction set that our kernels should use.  We check the processor once when we're loaded and start with the widest instruction set that
+// both we and the processor support, or with a narrower one if the EBM_SIMD_LEVEL environment variable asks for it.  SetSimdLevel can change it later
+// for benchmarking, and it takes effect on the next call that picks a kernel
+SimdLevelCore GetSimdLevelCore();
+
+// Runs TVariant::Run(args...) compiled for the instruction set that GetSimdLevelCore() selects.  TVariant::Run needs to be TML_INLINE, which
+// lets the compiler inline the whole hot loop into each of the wrappers below and then auto-vectorize it separately for each instruction set.  Any
+// functions that the loop calls which aren't forced inline stay compiled for our baseline.  Each wrapper is a separate static template function,
+// so unlike compiling whole files with different flags, no inline function in a header can end up compiled for a wider instruction set than the
+// processor that calls it.  We compile with -ffp-contract=off so that the compiler doesn't fuse multiplies and adds differently in each variant,
+// which keeps the results of any loop that only adds and multiplies bit for bit identical regardless of the variant.  Kernels that calculate exp
+// with our own polynomial instead of libm, like the binary classification residuals below, only promise to stay within a bound of the scalar results
+template<typename TVariant, typename... TArgs>
+TARGET_AVX2 static auto RunAvx2Variant(const TArgs... args) -> decltype(TVariant::Run(args...)) {
+   return TVariant::Run(args...);
+}
+
+template<typename TVariant, typename... TArgs>
+TARGET_AVX512 static auto RunAvx512Variant(const TArgs... args) -> decltype(TVariant::Run(args...)) {
+   return TVariant::Run(args...);
+}
+
+template<typename TVariant, typename... TArgs>
+TML_INLINE static auto RunSimdVariant(const TArgs... args) -> decltype(TVariant::Run(args...)) {
+#ifdef SIMD_TARGET_VARIANTS
+   const SimdLevelCore simdLevel = GetSimdLevelCore();
+   if(SimdLevelCore::Avx512Core == simdLevel) {
+      return RunAvx512Variant<TVariant>(args...);
+   }
+   if(SimdLevelCore::Avx2Core == simdLevel) {
+      return RunAvx2Variant<TVariant>(args...);
+   }
+#endif // SIMD_TARGET_VARIANTS
+   return TVariant::Run(args...);
+}
+
+// the math library that our kernels use for exp and log.  ExactCore uses libm, or our own vectorized exp which is within 1 ULP of the correctly rounded
+// result.  FastCore uses shorter polynomials for exp and log which have no branches and vectorize, and whose relative error is within
+// k_fastMathRelativeError.  Each training chooses its backend through TrainingOptionsFastMath
+enum class MathBackendCore { ExactCore = 0, FastCore = 1 };
+
+// the relative error of our fast exp, log and log1p for results that are normal doubles.  The exp polynomial has a truncation error of at most 3e-10
+// and the log polynomial at most 1e-10 relative to the exact result, and the rounding in both adds only a few ULP on top of that.  Validation log loss
+// only needs to be precise enough to compare one boosting step against the next, which this is by a wide margin
+constexpr double k_fastMathRelativeError = 1e-9;
+
+// the number of cases that our callers unpack into stack buffers before calling a kernel.  It needs to hold at least one full bit pack unit of cases
+constexpr size_t k_cSimdKernelCases = 256;
+static_assert(k_cBitsForStorageType <= k_cSimdKernelCases, "we need to be able to unpack at least one full StorageDataTypeCore into our buffers");
+
+// Applies a binary classification model update to cCases training cases and recomputes their residuals:
+//   aPredictionScores[i] = TFloat(aPredictionScores[i] + aModelUpdateTensor[aiBins[i]])
+//   aResidualErrors[i] = EbmStatistics::ComputeClassificationResidualErrorBinaryclass(aPredictionScores[i], aTargets[i])
+// aTargets holds 0 or 1 for each case.  The prediction scores are always bit identical to the scalar calculation since it's a single addition and
+// rounding.  The vectorized kernels use our own exp instead of std::exp, so their residuals are within k_cBinaryclassResidualUlps of the scalar residuals
+// when both are normal numbers in TFloat.  Residuals below the smallest normal TFloat occur only at prediction scores beyond +-708 where exp is about
+// to overflow, and in that range we only promise that both residuals are tiny.  Each case is calculated identically regardless of its position in the
+// buffer, so our results don't depend on how our caller splits the cases into chunks or threads
+template<typename TFloat>
+using BinaryclassResidualKernel = void (*)(
+   const FractionalDataType * const aModelUpdateTensor,
+   const int64_t * const aiBins,
+   const int64_t * const aTargets,
+   TFloat * const aPredictionScores,
+   TFloat * const aResidualErrors,
+   const size_t cCases
+);
+
+// our exp and std::exp are each within 1 ULP of the correctly rounded exp, so they're within 2 ULP of eachother.  Adding one keeps them within 3 ULP,
+// and taking the reciprocal can double that distance when it crosses a power of two, plus 1 ULP for rounding the division.  In practice we see at most 4
+constexpr uint64_t k_cBinaryclassResidualUlps = 8;
+
+// with MathBackendCore::FastCore the residuals are instead within k_fastMathRelativeError of the scalar residuals, plus the rounding to TFloat
+template<typename TFloat>
+BinaryclassResidualKernel<TFloat> GetBinaryclassResidualKernel(const MathBackendCore mathBackend);
+
+// Applies a binary classification model update to cCases validation cases and calculates their log loss:
+//   aPredictionScores[i] = TFloat(aPredictionScores[i] + aModelUpdateTensor[aiBins[i]])
+//   aLogLosses[i] = EbmStatistics::ComputeClassificationSingleCaseLogLossBinaryclass(aPredictionScores[i], aTargets[i])
+// We return the log loss of each case instead of their sum so that our caller adds them up in case order, which keeps the sum independent of the
+// vector width.  The exact kernel is the scalar libm calculation, so its log losses are bit identical to calling EbmStatistics one case at a time.  The
+// fast kernels calculate log(1 + exp(x)) as max(x, 0) + log1p(exp(-|x|)), which can't overflow, and are within k_fastMathRelativeError of the exact log loss.
+// Once exp(x) is below epsilon, libm's log(1 + exp(x)) rounds to zero while ours keeps the tiny log loss, so there they differ by up to epsilon instead
+template<typename TFloat>
+using BinaryclassLogLossKernel = void (*)(
+   const FractionalDataType * const aModelUpdateTensor,
+   const int64_t * const aiBins,
+   const int64_t * const aTargets,
+   TFloat * const aPredictionScores,
+   FractionalDataType * const aLogLosses,
+   const size_t cCases
+);
+
+template<typename TFloat>
+BinaryclassLogLossKernel<TFloat> GetBinaryclassLogLossKernel(const MathBackendCore mathBackend);
+
+// the number of values that our callers gather into stack buffers for our element wise kernels.  Multiclass callers put as many whole cases as fit
+constexpr size_t k_cSimdKernelValues = 2048;
+
+// Calculates aExps[i] = exp(aValues[i]) for cValues values, which lets multiclass callers calculate the exp of each logit once and then use the buffer
+// both for the softmax denominator and for the residuals or log loss.  The vectorized kernels use the same exp as our binary classification kernels, which
+// is within 1 ULP of the correctly rounded exp and therefore within 2 ULP of std::exp.  The scalar kernel calls std::exp.  With MathBackendCore::FastCore
+// the exps are within k_fastMathRelativeError of exp
+template<typename TFloat>
+using ExpKernel = void (*)(
+   const TFloat * const aValues,
+   FractionalDataType * const aExps,
+   const size_t cValues
+);
+
+template<typename TFloat>
+ExpKernel<TFloat> GetExpKernel(const MathBackendCore mathBackend);
+
+// Calculates aLogs[i] = log(aValues[i]) for cValues values.  aLogs can be the same buffer as aValues.  The exact kernel calls std::log, and the fast
+// kernels are within k_fastMathRelativeError of it.  Both return -infinity for zero, NaN for negative numbers, and infinity and NaN unchanged
+using LogKernel = void (*)(
+   const FractionalDataType * const aValues,
+   FractionalDataType * const aLogs,
+   const size_t cValues
+);
+
+LogKernel GetLogKernel(const MathBackendCore mathBackend);
+
+// true if the two values are within cUlps representable values of eachother.  We use this to check our vectorized kernels against the scalar
+// calculation in debug builds
+template<typename TFloat>
+TML_INLINE static bool IsWithinUlps(const TFloat value1, const TFloat value2, const uint64_t cUlps) {
+   static_assert(std::is_same<TFloat, float>::value || std::is_same<TFloat, double>::value, "TFloat must be float or double");
+   if(std::isnan(value1) || std::isnan(value2)) {
+      return std::isnan(value1) && std::isnan(value2);
+   }
+   if(value1 == value2) {
+      // this handles infinities and positive vs negative zero
+      return true;
+   }
+   // mapping the sign magnitude floating point representation onto a monotonic integer line lets us count the representable values between them
+   typedef typename std::conditional<std::is_same<TFloat, float>::value, uint32_t, uint64_t>::type TBits;
+   constexpr TBits signBit = TBits { 1 } << (sizeof(TBits) * 8 - 1);
+   TBits bits1;
+   TBits bits2;
+   memcpy(&bits1, &value1, sizeof(bits1));
+   memcpy(&bits2, &value2, sizeof(bits2));
+   bits1 = 0 != (signBit & bits1) ? signBit - (bits1 & ~signBit) : signBit + bits1;
+   bits2 = 0 != (signBit & bits2) ? signBit - (bits2 & ~signBit) : signBit + bits2;
+   const TBits distance = bits1 < bits2 ? bits2 - bits1 : bits1 - bits2;
+   return static_cast<uint64_t>(distance) <= cUlps;
+}
+
+// true if the two values are within relativeError of eachother, relative to the larger magnitude of the two.  We use this to check our fast math
+// kernels against the exact calculation in debug builds
+template<typename TFloat>
+TML_INLINE static bool IsWithinRelativeError(const TFloat value1, const TFloat value2, const double relativeError) {
+   if(std::isnan(value1) || std::isnan(value2)) {
+      return std::isnan(value1) && std::isnan(value2);
+   }
+   if(value1 == value2) {
+      return true;
+   }
+   if(std::isinf(value1) || std::isinf(value2)) {
+      return false;
+   }
+   const double magnitude1 = std::abs(static_cast<double>(value1));
+   const double magnitude2 = std::abs(static_cast<double>(value2));
+   return std::abs(static_cast<double>(value1) - static_cast<double>(value2)) <= relativeError * (magnitude1 < magnitude2 ? magnitude2 : magnitude1);
+}
+
+#endif // SIMD_KERNELS_H
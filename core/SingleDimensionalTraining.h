@@ -377,7 +377,7 @@ bool GrowDecisionTree(CachedTrainingThreadResources<IsRegression(countCompilerCl
 
 retry_with_bigger_tree_node_children_array:
    size_t cBytesBuffer2 = pCachedThreadResources->GetThreadByteBuffer2Size();
-   const size_t cBytesInitialNeededAllocation = 3 * cBytesPerTreeNode; // we need 1 TreeNode for the root, 1 for the left child of the root and 1 for the right child of the root
+   const size_t cBytesInitialNeededAllocation = k_cTreeNodesInitial * cBytesPerTreeNode; // we need 1 TreeNode for the root, 1 for the left child of the root and 1 for the right child of the root
    if(cBytesBuffer2 < cBytesInitialNeededAllocation) {
       // TODO : we can eliminate this check as long as we ensure that the ThreadByteBuffer2 is always initialized to be equal to the size of three TreeNodes (left and right) == GET_SIZEOF_ONE_TREE_NODE_CHILDREN(cBytesPerTreeNode)
       if(pCachedThreadResources->GrowThreadByteBuffer2(cBytesInitialNeededAllocation)) {
@@ -581,7 +581,7 @@ bool TrainZeroDimensional(CachedTrainingThreadResources<IsRegression(countCompil
    }
    memset(pBinnedBucket, 0, cBytesPerBinnedBucket);
 
-   BinDataSetTrainingZeroDimensions<countCompilerClassificationTargetStates>(pBinnedBucket, pTrainingSet, cTargetStates);
+   BinDataSetTrainingZeroDimensionsDispatch<countCompilerClassificationTargetStates>(pBinnedBucket, pTrainingSet, cTargetStates);
 
    const PredictionStatistics<IsRegression(countCompilerClassificationTargetStates)> * const aSumPredictionStatistics = &pBinnedBucket->aPredictionStatistics[0];
    if(IsRegression(countCompilerClassificationTargetStates)) {
@@ -602,8 +602,9 @@ bool TrainZeroDimensional(CachedTrainingThreadResources<IsRegression(countCompil
 }
 
 // TODO : make variable ordering consistent with BinDataSet call below (put the attribute first since that's a definition that happens before the training data set)
+// if aBinnedBucketsPreBinned is not nullptr, then it holds our already binned histogram (from BinDataSetTrainingFusedParallel) and we copy it instead of binning
 template<ptrdiff_t countCompilerClassificationTargetStates>
-bool TrainSingleDimensional(CachedTrainingThreadResources<IsRegression(countCompilerClassificationTargetStates)> * const pCachedThreadResources, const SamplingMethod * const pTrainingSet, const AttributeCombinationCore * const pAttributeCombination, const size_t cTreeSplitsMax, const size_t cCasesRequiredForSplitParentMin, SegmentedRegionCore<ActiveDataType, FractionalDataType> * const pSmallChangeToModelOverwriteSingleSamplingSet, FractionalDataType * const pTotalGain, const size_t cTargetStates) {
+bool TrainSingleDimensional(CachedTrainingThreadResources<IsRegression(countCompilerClassificationTargetStates)> * const pCachedThreadResources, const SamplingMethod * const pTrainingSet, const AttributeCombinationCore * const pAttributeCombination, const size_t cTreeSplitsMax, const size_t cCasesRequiredForSplitParentMin, SegmentedRegionCore<ActiveDataType, FractionalDataType> * const pSmallChangeToModelOverwriteSingleSamplingSet, FractionalDataType * const pTotalGain, const size_t cTargetStates, const BinnedBucket<IsRegression(countCompilerClassificationTargetStates)> * const aBinnedBucketsPreBinned) {
    LOG(TraceLevelVerbose, "Entered TrainSingleDimensional");
 
    EBM_ASSERT(1 == pAttributeCombination->m_cAttributes);
@@ -627,18 +628,26 @@ bool TrainSingleDimensional(CachedTrainingThreadResources<IsRegression(countComp
       LOG(TraceLevelWarning, "WARNING TrainSingleDimensional nullptr == aBinnedBuckets");
       return true;
    }
-   // !!! VERY IMPORTANT: zero our one extra bucket for BuildFastTotals to use for multi-dimensional !!!!
-   memset(aBinnedBuckets, 0, cBytesBuffer);
-
 #ifndef NDEBUG
    const unsigned char * const aBinnedBucketsEndDebug = reinterpret_cast<unsigned char *>(aBinnedBuckets) + cBytesBuffer;
 #endif // NDEBUG
 
-   BinDataSetTraining<countCompilerClassificationTargetStates, 1>(aBinnedBuckets, pAttributeCombination, pTrainingSet, cTargetStates
+   if(nullptr != aBinnedBucketsPreBinned) {
+      // CompressBinnedBuckets and GrowDecisionTree modify our histogram, so we need our own copy
+      memcpy(aBinnedBuckets, aBinnedBucketsPreBinned, cBytesBuffer);
+   } else {
+      // !!! VERY IMPORTANT: zero our one extra bucket for BuildFastTotals to use for multi-dimensional !!!!
+      memset(aBinnedBuckets, 0, cBytesBuffer);
+
+      if(BinDataSetTrainingParallel<countCompilerClassificationTargetStates>(pCachedThreadResources, aBinnedBuckets, cTotalBuckets, pAttributeCombination, pTrainingSet, cTargetStates
 #ifndef NDEBUG
-      , aBinnedBucketsEndDebug
+         , aBinnedBucketsEndDebug
 #endif // NDEBUG
-   );
+      )) {
+         LOG(TraceLevelWarning, "WARNING TrainSingleDimensional BinDataSetTrainingParallel failed");
+         return true;
+      }
+   }
 
    PredictionStatistics<IsRegression(countCompilerClassificationTargetStates)> * const aSumPredictionStatistics = pCachedThreadResources->m_aSumPredictionStatistics;
    memset(aSumPredictionStatistics, 0, sizeof(*aSumPredictionStatistics) * cVectorLength); // can't overflow, accessing existing memory
@@ -0,0 +1,423 @@
+// Copyright (c) 2018 Microsoft Corporation
+// Licensed under the MIT license.
+// Author: Paul Koch <code@koch.ninja>
+
+#include "PrecompiledHeader.h"
+
+#include <assert.h>
+#include <stddef.h> // size_t, ptrdiff_t
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+
+#if defined(_WIN32)
+// we don't want to require windows.h in our precompiled header since then it will be needed in linux builds, which doesn't make sense
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h> // pthread_setaffinity_np
+#include <sched.h> // cpu_set_t
+#endif // platform
+
+#include "ebmcore.h"
+
+#include "EbmInternal.h" // TML_INLINE
+#include "Logging.h" // EBM_ASSERT & LOG
+#include "ThreadPool.h"
+
+// the number of tasks that the current thread is in the middle of executing.  Tasks can submit nested jobs, so this can be more than one.  Worker threads only
+// ever run tasks, so this is non-zero on a worker thread any time it's running our code
+static thread_local size_t g_cTasksRunningOnThread = 0;
+
+class ParallelJob final {
+   const size_t m_cTasks;
+   const ParallelTaskFunction m_pTaskFunction;
+   void * const m_pContext;
+   std::atomic<size_t> m_iTaskNext;
+
+public:
+
+   // the number of worker threads currently draining this job.  Only accessed while holding the ThreadPool mutex.  The thread that submitted the job can't
+   // remove it from the pool and return until this drops to zero, otherwise a worker could be left holding a pointer to a job that no longer exists
+   size_t m_cWorkersActive;
+
+   ParallelJob(const size_t cTasks, const ParallelTaskFunction pTaskFunction, void * const pContext)
+      : m_cTasks(cTasks)
+      , m_pTaskFunction(pTaskFunction)
+      , m_pContext(pContext)
+      , m_iTaskNext(0)
+      , m_cWorkersActive(0) {
+   }
+
+   TML_INLINE bool IsExhausted() const {
+      return m_cTasks <= m_iTaskNext.load(std::memory_order_relaxed);
+   }
+
+   // every participating thread, including the calling thread, pulls tasks off the front of the job until it's empty.  Tasks are claimed one at a time so that
+   // threads that happen to get short tasks (or that start late) steal the remaining work from threads that get long ones
+   void Drain() {
+      while(true) {
+         const size_t iTask = m_iTaskNext.fetch_add(1, std::memory_order_relaxed);
+         if(m_cTasks <= iTask) {
+            break;
+         }
+         ++g_cTasksRunningOnThread;
+         (*m_pTaskFunction)(m_pContext, iTask);
+         --g_cTasksRunningOnThread;
+      }
+   }
+};
+
+// The ThreadPool keeps its worker threads alive between calls to ExecuteParallel so that we don't pay the cost of creating threads on every training step.
+// Any thread can submit a job, including worker threads that are executing a task from another job, and including multiple unrelated threads
+// at the same time (for instance GenerateModelUpdateThreadSafe called from separate threads), so we keep a list of in flight jobs and idle workers pick
+// up whichever job still has unclaimed tasks.  The submitting thread always drains its own job too, so a job completes even if every worker is busy
+// elsewhere, which is also what prevents deadlocks when tasks submit nested jobs
+class ThreadPool final {
+   std::mutex m_mutex;
+   std::condition_variable m_conditionWorkAvailable;
+   std::condition_variable m_conditionWorkerLeft;
+
+   // these are protected by m_mutex
+   std::vector<ParallelJob *> m_apJobs;
+   size_t m_cWorkerThreads;
+   bool m_bStopping;
+
+   // protects the configuration below and serializes starting and stopping the workers.  Always taken before m_mutex
+   std::mutex m_mutexConfiguration;
+   size_t m_cThreadsRequested;
+   std::vector<size_t> m_aiCpus;
+   std::vector<std::thread> m_workerThreads;
+   // read without holding m_mutexConfiguration on every ExecuteParallel call.  It stays true until after the old workers have been joined, which matters
+   // because a worker that submits a nested job while we're stopping it can't be allowed to block waiting on m_mutexConfiguration
+   std::atomic<bool> m_bStarted;
+
+   ParallelJob * GetJobWithWork() {
+      // must be called while holding m_mutex
+      for(ParallelJob * const pJob : m_apJobs) {
+         if(!pJob->IsExhausted()) {
+            return pJob;
+         }
+      }
+      return nullptr;
+   }
+
+   void WorkerLoop() {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      while(true) {
+         ParallelJob * pJob;
+         while(nullptr == (pJob = GetJobWithWork())) {
+            if(m_bStopping) {
+               return;
+            }
+            m_conditionWorkAvailable.wait(lock);
+         }
+         ++pJob->m_cWorkersActive;
+         lock.unlock();
+
+         pJob->Drain();
+
+         lock.lock();
+         EBM_ASSERT(0 < pJob->m_cWorkersActive);
+         --pJob->m_cWorkersActive;
+         if(0 == pJob->m_cWorkersActive) {
+            m_conditionWorkerLeft.notify_all();
+         }
+      }
+   }
+
+   static void WorkerThreadEntry(ThreadPool * const pThreadPool) {
+      pThreadPool->WorkerLoop();
+   }
+
+   static bool PinThread(std::thread & workerThread, const size_t iCpu) {
+#if defined(_WIN32)
+      if(k_cBitsForSizeTCore <= iCpu) {
+         // SetThreadAffinityMask only handles the processors in the current processor group
+         return true;
+      }
+      return 0 == SetThreadAffinityMask(workerThread.native_handle(), DWORD_PTR { 1 } << iCpu);
+#elif defined(__linux__)
+      if(CPU_SETSIZE <= iCpu) {
+         return true;
+      }
+      cpu_set_t cpuSet;
+      CPU_ZERO(&cpuSet);
+      CPU_SET(iCpu, &cpuSet);
+      return 0 != pthread_setaffinity_np(workerThread.native_handle(), sizeof(cpuSet), &cpuSet);
+#else // platform
+      // mac doesn't allow explicitly pinning threads to cores
+      UNUSED(workerThread);
+      UNUSED(iCpu);
+      return true;
+#endif // platform
+   }
+
+   // must be called while holding m_mutexConfiguration.  Returns true if we weren't able to launch all the requested threads or pin them, but
+   // the pool is usable either way since the submitting thread can always do all the work itself
+   bool StartWorkers() {
+      EBM_ASSERT(m_workerThreads.empty());
+
+      size_t cThreads = m_cThreadsRequested;
+      if(0 == cThreads) {
+         // hardware_concurrency is allowed to return 0 if the value isn't computable, in which case we just run everything on the submitting thread
+         cThreads = static_cast<size_t>(std::thread::hardware_concurrency());
+      }
+      if(cThreads <= 1) {
+         m_bStarted = true;
+         LOG(TraceLevelInfo, "ThreadPool started without worker threads");
+         return false;
+      }
+
+      bool bError = false;
+      try {
+         // the submitting thread does work too, so we need one less worker than the number of threads
+         m_workerThreads.reserve(cThreads - 1);
+         for(size_t iThread = 1; iThread < cThreads; ++iThread) {
+            m_workerThreads.emplace_back(&ThreadPool::WorkerThreadEntry, this);
+         }
+      } catch(...) {
+         // if we can't launch a thread (out of memory, or the OS refused), we still have the threads that did launch plus the submitting thread
+         LOG(TraceLevelWarning, "WARNING ThreadPool::StartWorkers exception launching worker threads.  Continuing with %zu threads", m_workerThreads.size() + 1);
+         bError = true;
+      }
+
+      if(!m_aiCpus.empty()) {
+         for(size_t iThread = 0; iThread < m_workerThreads.size(); ++iThread) {
+            // the submitting thread isn't ours to pin, so we assign the workers round robin starting from the first cpu
+            const size_t iCpu = m_aiCpus[iThread % m_aiCpus.size()];
+            if(PinThread(m_workerThreads[iThread], iCpu)) {
+               LOG(TraceLevelWarning, "WARNING ThreadPool::StartWorkers unable to pin worker thread %zu to cpu %zu", iThread, iCpu);
+               bError = true;
+            }
+         }
+      }
+
+      {
+         std::lock_guard<std::mutex> lock(m_mutex);
+         m_cWorkerThreads = m_workerThreads.size();
+      }
+      m_bStarted = true;
+
+      LOG(TraceLevelInfo, "ThreadPool started with %zu worker threads", m_workerThreads.size());
+      return bError;
+   }
+
+   // must be called while holding m_mutexConfiguration.  Any jobs in flight are completed by the threads that submitted them
+   void StopWorkers() {
+      {
+         std::lock_guard<std::mutex> lock(m_mutex);
+         m_bStopping = true;
+         m_cWorkerThreads = 0;
+      }
+      m_conditionWorkAvailable.notify_all();
+      for(std::thread & workerThread : m_workerThreads) {
+         workerThread.join();
+      }
+      m_workerThreads.clear();
+      {
+         std::lock_guard<std::mutex> lock(m_mutex);
+         m_bStopping = false;
+      }
+      m_bStarted = false;
+   }
+
+   void EnsureStarted() {
+      if(m_bStarted.load()) {
+         return;
+      }
+      std::lock_guard<std::mutex> lockConfiguration(m_mutexConfiguration);
+      if(!m_bStarted.load()) {
+         StartWorkers();
+      }
+   }
+
+public:
+
+   ThreadPool()
+      : m_cWorkerThreads(0)
+      , m_bStopping(false)
+      , m_cThreadsRequested(0)
+      , m_bStarted(false) {
+   }
+
+   // we don't have a destructor that joins the workers.  The pool lives until the process exits, and joining threads while our library is being
+   // unloaded isn't safe on Windows since we'd be holding the loader lock.  The OS cleans up the sleeping worker threads at process exit
+
+   // reconfiguring joins every worker thread, so it can't be done from inside a task.  A worker would join itself, and the thread that submitted the job
+   // would join workers that might be waiting on its task to finish
+   static bool IsInsideTask() {
+      return 0 != g_cTasksRunningOnThread;
+   }
+
+   bool SetThreadCount(const size_t cThreads) {
+      std::lock_guard<std::mutex> lockConfiguration(m_mutexConfiguration);
+      m_cThreadsRequested = cThreads;
+      if(m_bStarted) {
+         StopWorkers();
+      }
+      // start immediately so that the caller hears about any problems launching the threads
+      return StartWorkers();
+   }
+
+   bool SetThreadAffinity(const size_t cCpus, const size_t * const aiCpus) {
+      std::lock_guard<std::mutex> lockConfiguration(m_mutexConfiguration);
+      try {
+         m_aiCpus.assign(aiCpus, aiCpus + cCpus);
+      } catch(...) {
+         LOG(TraceLevelWarning, "WARNING ThreadPool::SetThreadAffinity exception");
+         return true;
+      }
+      if(m_bStarted) {
+         StopWorkers();
+      }
+      // threads can only be pinned after they're launched, so restarting the workers is the simplest way to apply new settings (or to remove the old ones)
+      return StartWorkers();
+   }
+
+   size_t GetThreadCount() {
+      EnsureStarted();
+      std::lock_guard<std::mutex> lock(m_mutex);
+      // the submitting thread works on its own jobs too
+      return m_cWorkerThreads + 1;
+   }
+
+   void Execute(const size_t cTasks, const ParallelTaskFunction pTaskFunction, void * const pContext) {
+      EnsureStarted();
+
+      ParallelJob parallelJob(cTasks, pTaskFunction, pContext);
+
+      bool bSubmitted = false;
+      {
+         std::lock_guard<std::mutex> lock(m_mutex);
+         if(0 != m_cWorkerThreads) {
+            try {
+               m_apJobs.push_back(&parallelJob);
+               bSubmitted = true;
+            } catch(...) {
+               // if we can't add the job to the list, we'll just do all the work ourselves
+               LOG(TraceLevelWarning, "WARNING ThreadPool::Execute exception submitting job");
+            }
+         }
+      }
+      if(bSubmitted) {
+         m_conditionWorkAvailable.notify_all();
+      }
+
+      parallelJob.Drain();
+
+      if(bSubmitted) {
+         std::unique_lock<std::mutex> lock(m_mutex);
+         // all tasks have been claimed by the time our Drain returns, but workers might still be running the tasks that they claimed
+         while(0 != parallelJob.m_cWorkersActive) {
+            m_conditionWorkerLeft.wait(lock);
+         }
+         for(std::vector<ParallelJob *>::iterator it = m_apJobs.begin(); m_apJobs.end() != it; ++it) {
+            if(&parallelJob == *it) {
+               m_apJobs.erase(it);
+               break;
+            }
+         }
+      }
+   }
+};
+
+static ThreadPool * GetThreadPool() {
+   // allocated on first use and never freed.  See the comment in ThreadPool about why we don't join the workers at unload.  Function local statics are
+   // initialized in a thread safe way in C++11
+   static ThreadPool * const pThreadPool = new ThreadPool();
+   return pThreadPool;
+}
+
+void ExecuteParallel(const size_t cTasks, const ParallelTaskFunction pTaskFunction, void * const pContext) {
+   LOG(TraceLevelVerbose, "Entered ExecuteParallel: cTasks=%zu", cTasks);
+
+   EBM_ASSERT(nullptr != pTaskFunction);
+
+   if(cTasks <= 1) {
+      // no point in waking up the workers if there's nobody to share the work with
+      if(1 == cTasks) {
+         (*pTaskFunction)(pContext, 0);
+      }
+      LOG(TraceLevelVerbose, "Exited ExecuteParallel single task");
+      return;
+   }
+
+   GetThreadPool()->Execute(cTasks, pTaskFunction, pContext);
+
+   LOG(TraceLevelVerbose, "Exited ExecuteParallel");
+}
+
+size_t GetParallelThreadCount() {
+   return GetThreadPool()->GetThreadCount();
+}
+
+EBMCORE_IMPORT_EXPORT IntegerDataType EBMCORE_CALLING_CONVENTION SetThreadCount(IntegerDataType countThreads) {
+   LOG(TraceLevelInfo, "Entered SetThreadCount: countThreads=%" IntegerDataTypePrintf, countThreads);
+
+   if(ThreadPool::IsInsideTask()) {
+      LOG(TraceLevelWarning, "WARNING SetThreadCount called from inside a task");
+      return 1;
+   }
+
+   if(countThreads < 0) {
+      LOG(TraceLevelWarning, "WARNING SetThreadCount countThreads < 0");
+      return 1;
+   }
+   size_t cThreads = static_cast<size_t>(countThreads);
+   if(!IsNumberConvertable<size_t, IntegerDataType>(countThreads)) {
+      // nobody has this many cores, so we'll be limited by the OS refusing to launch more threads anyways
+      cThreads = std::numeric_limits<size_t>::max();
+   }
+   const bool bError = GetThreadPool()->SetThreadCount(cThreads);
+
+   LOG(TraceLevelInfo, "Exited SetThreadCount");
+   return bError ? IntegerDataType { 1 } : IntegerDataType { 0 };
+}
+
+EBMCORE_IMPORT_EXPORT IntegerDataType EBMCORE_CALLING_CONVENTION SetThreadAffinity(IntegerDataType countCpus, const IntegerDataType * cpuIndexes) {
+   LOG(TraceLevelInfo, "Entered SetThreadAffinity: countCpus=%" IntegerDataTypePrintf ", cpuIndexes=%p", countCpus, static_cast<const void *>(cpuIndexes));
+
+   if(ThreadPool::IsInsideTask()) {
+      LOG(TraceLevelWarning, "WARNING SetThreadAffinity called from inside a task");
+      return 1;
+   }
+
+   if(countCpus < 0) {
+      LOG(TraceLevelWarning, "WARNING SetThreadAffinity countCpus < 0");
+      return 1;
+   }
+   if(0 != countCpus && nullptr == cpuIndexes) {
+      LOG(TraceLevelWarning, "WARNING SetThreadAffinity 0 != countCpus && nullptr == cpuIndexes");
+      return 1;
+   }
+   if(!IsNumberConvertable<size_t, IntegerDataType>(countCpus) || IsMultiplyError(sizeof(size_t), static_cast<size_t>(countCpus))) {
+      LOG(TraceLevelWarning, "WARNING SetThreadAffinity countCpus too large");
+      return 1;
+   }
+   const size_t cCpus = static_cast<size_t>(countCpus);
+
+   std::vector<size_t> aiCpus;
+   try {
+      aiCpus.reserve(cCpus);
+   } catch(...) {
+      LOG(TraceLevelWarning, "WARNING SetThreadAffinity exception");
+      return 1;
+   }
+   for(size_t iCpuIndex = 0; iCpuIndex < cCpus; ++iCpuIndex) {
+      const IntegerDataType indexCpu = cpuIndexes[iCpuIndex];
+      if(indexCpu < 0 || !IsNumberConvertable<size_t, IntegerDataType>(indexCpu)) {
+         LOG(TraceLevelWarning, "WARNING SetThreadAffinity invalid cpu index %" IntegerDataTypePrintf, indexCpu);
+         return 1;
+      }
+      aiCpus.push_back(static_cast<size_t>(indexCpu));
+   }
+
+   const bool bError = GetThreadPool()->SetThreadAffinity(cCpus, 0 == cCpus ? nullptr : &aiCpus[0]);
+
+   LOG(TraceLevelInfo, "Exited SetThreadAffinity");
+   return bError ? IntegerDataType { 1 } : IntegerDataType { 0 };
+}
@@ -0,0 +1,25 @@
+// Copyright (c) 2018 Microsoft Corporation
+// Licensed under the MIT license.
+// Author: Paul Koch <code@koch.ninja>
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <stddef.h> // size_t, ptrdiff_t
+
+// the task function is called once for each iTask in the range [0, cTasks).  Tasks can be executed in any order and on any thread, including the calling thread,
+// so the task function must only write to memory that is owned by the iTask that it was given.  Errors need to be communicated back through the context object
+// since the task function has no return value (we don't want to abort the other tasks in flight when one of them fails, and we need to clean up after all of them anyways)
+typedef void (* ParallelTaskFunction)(void * const pContext, const size_t iTask);
+
+// runs all tasks on the shared persistent thread pool and returns only after every one of them has completed.  The calling thread works on the tasks too.
+// The number of threads is controlled through SetThreadCount and SetThreadAffinity.  It's legal to call this from multiple threads at once, and from
+// inside a task.  If we're unable to launch worker threads we fall back to executing the tasks on the calling thread, so this function can't fail
+void ExecuteParallel(const size_t cTasks, const ParallelTaskFunction pTaskFunction, void * const pContext);
+
+// returns the number of threads (including the calling thread) that ExecuteParallel can currently spread tasks across.  This is useful for sizing per task
+// scratch space when the tasks are independent, but it can change at any time through SetThreadCount, so it must never be used to decide how to split
+// work whose results get reduced together, otherwise our results would depend on the number of threads
+size_t GetParallelThreadCount();
+
+#endif // THREAD_POOL_H
@@ -5,7 +5,7 @@
 #include "PrecompiledHeader.h"
 
 #include <assert.h>
-#include <string.h> // memset
+#include <string.h> // memset, memcmp
 #include <stdlib.h> // malloc, realloc, free
 #include <stddef.h> // size_t, ptrdiff_t
 #include <limits> // numeric_limits
@@ -27,12 +27,16 @@
 // AttributeCombination.h depends on AttributeInternal.h
 #include "AttributeCombinationInternal.h"
 // dataset depends on attributes
+#include "DataColumn.h"
+#include "DataSetByAttribute.h"
 #include "DataSetByAttributeCombination.h"
 // samples is somewhat independent from datasets, but relies on an indirect coupling with them
 #include "SamplingWithReplacement.h"
 // TreeNode depends on almost everything
 #include "SingleDimensionalTraining.h"
 #include "MultiDimensionalTraining.h"
+#include "ThreadPool.h"
+#include "SimdKernels.h"
 
 static void DeleteSegmentsCore(const size_t cAttributeCombinations, SegmentedRegionCore<ActiveDataType, FractionalDataType> ** const apSegmentedRegions) {
    LOG(TraceLevelInfo, "Entered DeleteSegmentsCore");
@@ -106,69 +110,152 @@ static SegmentedRegionCore<ActiveDataType, FractionalDataType> ** InitializeSegm
    return apSegmentedRegions;
 }
 
-// a*PredictionScores = logOdds for binary classification
-// a*PredictionScores = logWeights for multiclass classification
-// a*PredictionScores = predictedValue for regression
-template<unsigned int cInputBits, unsigned int cTargetBits, ptrdiff_t countCompilerClassificationTargetStates>
-static void TrainingSetTargetAttributeLoop(const AttributeCombinationCore * const pAttributeCombination, DataSetAttributeCombination * const pTrainingSet, const FractionalDataType * const aModelUpdateTensor, const size_t cTargetStates) {
-   LOG(TraceLevelVerbose, "Entered TrainingSetTargetAttributeLoop");
+// binary classification is the case that almost everyone trains, so we give it a separate loop that unpacks whole StorageDataTypeCore units of bin indexes
+// and targets into stack buffers and then hands those buffers to a vectorized kernel, which gathers the updates and calculates exp over 4 or 8 cases
+// per instruction.  See GetBinaryclassResidualKernel for how closely the vectorized residuals match the scalar ones
+template<unsigned int cTargetBits, typename TFloat>
+static void TrainingSetBinaryclassLoop(const AttributeCombinationCore * const pAttributeCombination, DataSetAttributeCombination * const pTrainingSet, const FractionalDataType * const aModelUpdateTensor, const size_t iCaseStart, const size_t cCases, const MathBackendCore mathBackend) {
+   LOG(TraceLevelVerbose, "Entered TrainingSetBinaryclassLoop");
+
+   EBM_ASSERT(0 < cCases);
+   EBM_ASSERT(iCaseStart + cCases <= pTrainingSet->GetCountCases());
+
+   const BinaryclassResidualKernel<TFloat> binaryclassResidualKernel = GetBinaryclassResidualKernel<TFloat>(mathBackend);
+
+   TFloat * pTrainingPredictionScores = pTrainingSet->GetPredictionScores<TFloat>() + iCaseStart;
+   TFloat * pResidualError = pTrainingSet->GetResidualPointer<TFloat>() + iCaseStart;
+   BitPackedCaseUnpacker<cTargetBits> caseUnpacker(pTrainingSet, pAttributeCombination, iCaseStart);
+
+   int64_t aiBins[k_cSimdKernelCases];
+   int64_t aTargets[k_cSimdKernelCases];
+
+   size_t cCasesRemaining = cCases;
+   do {
+      const size_t cBufferedCases = caseUnpacker.Unpack(aiBins, aTargets, k_cSimdKernelCases, cCasesRemaining);
+
+#ifndef NDEBUG
+      TFloat aPredictionScoresDebug[k_cSimdKernelCases];
+      memcpy(aPredictionScoresDebug, pTrainingPredictionScores, sizeof(TFloat) * cBufferedCases);
+#endif // NDEBUG
+
+      (*binaryclassResidualKernel)(aModelUpdateTensor, aiBins, aTargets, pTrainingPredictionScores, pResidualError, cBufferedCases);
+
+#ifndef NDEBUG
+      for(size_t iCase = 0; iCase < cBufferedCases; ++iCase) {
+         // check the vectorized kernel against the scalar calculation that it replaces
+         const TFloat trainingPredictionScore = static_cast<TFloat>(static_cast<FractionalDataType>(aPredictionScoresDebug[iCase]) + aModelUpdateTensor[static_cast<size_t>(aiBins[iCase])]);
+         EBM_ASSERT(trainingPredictionScore == pTrainingPredictionScores[iCase] || std::isnan(trainingPredictionScore));
+         const TFloat residualError = static_cast<TFloat>(EbmStatistics::ComputeClassificationResidualErrorBinaryclass(static_cast<FractionalDataType>(trainingPredictionScore), static_cast<StorageDataTypeCore>(aTargets[iCase])));
+         // the fast residuals can also round to the other side of a TFloat value from the exact ones
+         EBM_ASSERT(MathBackendCore::FastCore == mathBackend ? IsWithinRelativeError(residualError, pResidualError[iCase], k_fastMathRelativeError + 2 * static_cast<double>(std::numeric_limits<TFloat>::epsilon())) : IsWithinUlps(residualError, pResidualError[iCase], k_cBinaryclassResidualUlps) || std::abs(residualError) < std::numeric_limits<TFloat>::min() && std::abs(pResidualError[iCase]) < std::numeric_limits<TFloat>::min());
+      }
+#endif // NDEBUG
+
+      pTrainingPredictionScores += cBufferedCases;
+      pResidualError += cBufferedCases;
+      cCasesRemaining -= cBufferedCases;
+   } while(0 != cCasesRemaining);
+
+   LOG(TraceLevelVerbose, "Exited TrainingSetBinaryclassLoop");
+}
+
+// adds the model updates of the bins in aiBins to the logits of cCases cases, rounding each new logit to TFloat as it's stored
+template<ptrdiff_t countCompilerClassificationTargetStates, typename TFloat>
+TML_INLINE static void ApplyMulticlassModelUpdate(const FractionalDataType * const aModelUpdateTensor, const int64_t * const aiBins, TFloat * pPredictionScores, const size_t cVectorLength, const size_t cCases) {
+   EBM_ASSERT(cVectorLength == GET_VECTOR_LENGTH(countCompilerClassificationTargetStates, cVectorLength));
+   for(size_t iCase = 0; iCase < cCases; ++iCase) {
+      const FractionalDataType * const pValues = &aModelUpdateTensor[static_cast<size_t>(aiBins[iCase]) * cVectorLength];
+      size_t iVector = 0;
+      do {
+         // this will apply a small fix to our existing PredictionScores, either positive or negative, whichever is needed
+         pPredictionScores[iVector] = static_cast<TFloat>(static_cast<FractionalDataType>(pPredictionScores[iVector]) + pValues[iVector]);
+         ++iVector;
+      } while(iVector < GET_VECTOR_LENGTH(countCompilerClassificationTargetStates, cVectorLength));
+      pPredictionScores += cVectorLength;
+   }
+}
+
+// returns the sum of the exps of the logits of a single case that has more logits than fit into aExps.  We calculate the exps in pieces, so our caller
+// needs to calculate any exp that it needs afterwards again, which is only worth doing for a case with more than k_cSimdKernelValues classes
+template<typename TFloat>
+static FractionalDataType SumExpInPieces(const ExpKernel<TFloat> expKernel, const TFloat * const aPredictionScores, const size_t cVectorLength, FractionalDataType * const aExps) {
+   FractionalDataType sumExp = 0;
+   for(size_t iVectorStart = 0; iVectorStart < cVectorLength; iVectorStart += k_cSimdKernelValues) {
+      const size_t cPiece = cVectorLength - iVectorStart < k_cSimdKernelValues ? cVectorLength - iVectorStart : k_cSimdKernelValues;
+      (*expKernel)(&aPredictionScores[iVectorStart], aExps, cPiece);
+      for(size_t iVector = 0; iVector < cPiece; ++iVector) {
+         sumExp += aExps[iVector];
+      }
+   }
+   return sumExp;
+}
+
+// multiclass needs exp(logit) for every logit of a case, both in the softmax denominator and for the residuals.  We calculate the exps of a whole buffer of
+// cases in one call to our vectorized exp kernel and keep them in aExps, so we only calculate each exp once
+template<unsigned int cTargetBits, ptrdiff_t countCompilerClassificationTargetStates, typename TFloat>
+static void TrainingSetMulticlassLoop(const AttributeCombinationCore * const pAttributeCombination, DataSetAttributeCombination * const pTrainingSet, const FractionalDataType * const aModelUpdateTensor, const size_t cTargetStates, const size_t iCaseStart, const size_t cCases, const MathBackendCore mathBackend) {
+   LOG(TraceLevelVerbose, "Entered TrainingSetMulticlassLoop");
 
    const size_t cVectorLength = GET_VECTOR_LENGTH(countCompilerClassificationTargetStates, cTargetStates);
-   const size_t cCases = pTrainingSet->GetCountCases();
    EBM_ASSERT(0 < cCases);
+   EBM_ASSERT(iCaseStart + cCases <= pTrainingSet->GetCountCases());
+   EBM_ASSERT((IsNumberConvertable<StorageDataTypeCore, size_t>(cVectorLength)));
+   const StorageDataTypeCore cVectorLengthStorage = static_cast<StorageDataTypeCore>(cVectorLength);
 
-   if(0 == pAttributeCombination->m_cAttributes) {
-      FractionalDataType * pResidualError = pTrainingSet->GetResidualPointer();
-      const FractionalDataType * const pResidualErrorEnd = pResidualError + cVectorLength * cCases;
-      if(IsRegression(countCompilerClassificationTargetStates)) {
-         const FractionalDataType smallChangeToPrediction = aModelUpdateTensor[0];
-         while(pResidualErrorEnd != pResidualError) {
-            // this will apply a small fix to our existing TrainingPredictionScores, either positive or negative, whichever is needed
-            const FractionalDataType residualError = EbmStatistics::ComputeRegressionResidualError(*pResidualError - smallChangeToPrediction);
-            *pResidualError = residualError;
-            ++pResidualError;
-         }
-      } else {
-         EBM_ASSERT(IsClassification(countCompilerClassificationTargetStates));
-         FractionalDataType * pTrainingPredictionScores = pTrainingSet->GetPredictionScores();
-         const StorageDataTypeCore * pTargetData = pTrainingSet->GetTargetDataPointer();
-         if(IsBinaryClassification(countCompilerClassificationTargetStates)) {
-            const FractionalDataType smallChangeToPredictionScores = aModelUpdateTensor[0];
-            while(pResidualErrorEnd != pResidualError) {
-               StorageDataTypeCore targetData = *pTargetData;
-               // TODO : because there is only one bin for a zero attribute attribute combination, we can move the fetch of smallChangeToPredictionScores outside of our loop so that the code doesn't have this dereference each loop
-               // this will apply a small fix to our existing TrainingPredictionScores, either positive or negative, whichever is needed
-               const FractionalDataType trainingPredictionScore = *pTrainingPredictionScores + smallChangeToPredictionScores;
-               *pTrainingPredictionScores = trainingPredictionScore;
-               const FractionalDataType residualError = EbmStatistics::ComputeClassificationResidualErrorBinaryclass(trainingPredictionScore, targetData);
-               *pResidualError = residualError;
-               ++pResidualError;
-               ++pTrainingPredictionScores;
-               ++pTargetData;
+   const ExpKernel<TFloat> expKernel = GetExpKernel<TFloat>(mathBackend);
+
+   TFloat * pTrainingPredictionScores = pTrainingSet->GetPredictionScores<TFloat>() + cVectorLength * iCaseStart;
+   TFloat * pResidualError = pTrainingSet->GetResidualPointer<TFloat>() + cVectorLength * iCaseStart;
+   BitPackedCaseUnpacker<cTargetBits> caseUnpacker(pTrainingSet, pAttributeCombination, iCaseStart);
+
+   int64_t aiBins[k_cSimdKernelCases];
+   int64_t aTargets[k_cSimdKernelCases];
+   FractionalDataType aExps[k_cSimdKernelValues];
+   // zero if a single case has more logits than fit into aExps
+   const size_t cCasesPerExpBatch = k_cSimdKernelValues / cVectorLength;
+
+   size_t cCasesRemaining = cCases;
+   do {
+      const size_t cBufferedCases = caseUnpacker.Unpack(aiBins, aTargets, k_cSimdKernelCases, cCasesRemaining);
+      ApplyMulticlassModelUpdate<countCompilerClassificationTargetStates, TFloat>(aModelUpdateTensor, aiBins, pTrainingPredictionScores, cVectorLength, cBufferedCases);
+
+      size_t iBufferedCase = 0;
+      do {
+         size_t cExpBatchCases = cBufferedCases - iBufferedCase < cCasesPerExpBatch ? cBufferedCases - iBufferedCase : cCasesPerExpBatch;
+         if(UNLIKELY(0 == cExpBatchCases)) {
+            // we can't fit all the logits of this case into aExps, so we sum them in pieces and then calculate them again for the residuals
+            cExpBatchCases = 1;
+            const StorageDataTypeCore targetData = static_cast<StorageDataTypeCore>(aTargets[iBufferedCase]);
+            const FractionalDataType sumExp = SumExpInPieces(expKernel, pTrainingPredictionScores, cVectorLength, aExps);
+            for(size_t iVectorStart = 0; iVectorStart < cVectorLength; iVectorStart += k_cSimdKernelValues) {
+               const size_t cPiece = cVectorLength - iVectorStart < k_cSimdKernelValues ? cVectorLength - iVectorStart : k_cSimdKernelValues;
+               (*expKernel)(&pTrainingPredictionScores[iVectorStart], aExps, cPiece);
+               for(size_t iVector = 0; iVector < cPiece; ++iVector) {
+                  const FractionalDataType residualError = EbmStatistics::ComputeClassificationResidualErrorMulticlass(sumExp, aExps[iVector], targetData, static_cast<StorageDataTypeCore>(iVectorStart + iVector));
+                  pResidualError[iVectorStart + iVector] = static_cast<TFloat>(residualError);
+               }
+            }
+            constexpr bool bZeroingResiduals = 0 <= k_iZeroResidual;
+            if(bZeroingResiduals) {
+               pResidualError[k_iZeroResidual] = 0;
             }
+            pResidualError += cVectorLength;
          } else {
-            const FractionalDataType * pValues = aModelUpdateTensor;
-            while(pResidualErrorEnd != pResidualError) {
-               StorageDataTypeCore targetData = *pTargetData;
+            (*expKernel)(pTrainingPredictionScores, aExps, cExpBatchCases * cVectorLength);
+            const FractionalDataType * pExps = aExps;
+            for(size_t iExpBatchCase = 0; iExpBatchCase < cExpBatchCases; ++iExpBatchCase) {
+               const StorageDataTypeCore targetData = static_cast<StorageDataTypeCore>(aTargets[iBufferedCase + iExpBatchCase]);
                FractionalDataType sumExp = 0;
                size_t iVector1 = 0;
                do {
-                  // TODO : because there is only one bin for a zero attribute attribute combination, we could move these values to the stack where the copmiler could reason about their visibility and optimize small arrays into registers
-                  const FractionalDataType smallChangeToPredictionScores = pValues[iVector1];
-                  // this will apply a small fix to our existing TrainingPredictionScores, either positive or negative, whichever is needed
-                  const FractionalDataType trainingPredictionScores = pTrainingPredictionScores[iVector1] + smallChangeToPredictionScores;
-                  pTrainingPredictionScores[iVector1] = trainingPredictionScores;
-                  sumExp += std::exp(trainingPredictionScores);
+                  sumExp += pExps[iVector1];
                   ++iVector1;
-               } while(iVector1 < cVectorLength);
+               } while(iVector1 < GET_VECTOR_LENGTH(countCompilerClassificationTargetStates, cVectorLength));
 
-               EBM_ASSERT((IsNumberConvertable<StorageDataTypeCore, size_t>(cVectorLength)));
-               const StorageDataTypeCore cVectorLengthStorage = static_cast<StorageDataTypeCore>(cVectorLength);
                StorageDataTypeCore iVector2 = 0;
                do {
-                  // TODO : we're calculating exp(predictionScore) above, and then again in ComputeClassificationResidualErrorMulticlass.  exp(..) is expensive so we should just do it once instead and store the result in a small memory array here
-                  const FractionalDataType residualError = EbmStatistics::ComputeClassificationResidualErrorMulticlass(sumExp, pTrainingPredictionScores[iVector2], targetData, iVector2);
-                  *pResidualError = residualError;
+                  const FractionalDataType residualError = EbmStatistics::ComputeClassificationResidualErrorMulticlass(sumExp, pExps[iVector2], targetData, iVector2);
+                  *pResidualError = static_cast<TFloat>(residualError);
                   ++pResidualError;
                   ++iVector2;
                } while(iVector2 < cVectorLengthStorage);
@@ -184,12 +271,37 @@ static void TrainingSetTargetAttributeLoop(const AttributeCombinationCore * cons
                if(bZeroingResiduals) {
                   pResidualError[k_iZeroResidual - static_cast<ptrdiff_t>(cVectorLength)] = 0;
                }
-               pTrainingPredictionScores += cVectorLength;
-               ++pTargetData;
+               pExps += cVectorLength;
             }
          }
+         pTrainingPredictionScores += cVectorLength * cExpBatchCases;
+         iBufferedCase += cExpBatchCases;
+      } while(iBufferedCase < cBufferedCases);
+
+      cCasesRemaining -= cBufferedCases;
+   } while(0 != cCasesRemaining);
+
+   LOG(TraceLevelVerbose, "Exited TrainingSetMulticlassLoop");
+}
+
+// applies a regression model update to the training cases in the range [iCaseStart, iCaseStart + cCases).  Regression residuals need only a subtraction,
+// so this loop is bound by how quickly we can unpack the bins and gather the model update.  We're forced inline so that TrainingSetRegressionLoopSimd
+// can compile us for each instruction set
+template<typename TFloat>
+TML_INLINE static void TrainingSetRegressionLoop(const AttributeCombinationCore * const pAttributeCombination, DataSetAttributeCombination * const pTrainingSet, const FractionalDataType * const aModelUpdateTensor, const size_t iCaseStart, const size_t cCases) {
+   LOG(TraceLevelVerbose, "Entered TrainingSetRegressionLoop");
+
+   if(0 == pAttributeCombination->m_cAttributes) {
+      TFloat * pResidualError = pTrainingSet->GetResidualPointer<TFloat>() + iCaseStart;
+      const TFloat * const pResidualErrorEnd = pResidualError + cCases;
+      const FractionalDataType smallChangeToPrediction = aModelUpdateTensor[0];
+      while(pResidualErrorEnd != pResidualError) {
+         // this will apply a small fix to our existing TrainingPredictionScores, either positive or negative, whichever is needed
+         const FractionalDataType residualError = EbmStatistics::ComputeRegressionResidualError(static_cast<FractionalDataType>(*pResidualError) - smallChangeToPrediction);
+         *pResidualError = static_cast<TFloat>(residualError);
+         ++pResidualError;
       }
-      LOG(TraceLevelVerbose, "Exited TrainingSetTargetAttributeLoop - Zero dimensions");
+      LOG(TraceLevelVerbose, "Exited TrainingSetRegressionLoop - Zero dimensions");
       return;
    }
 
@@ -197,384 +309,388 @@ static void TrainingSetTargetAttributeLoop(const AttributeCombinationCore * cons
    const size_t cBitsPerItemMax = GetCountBits(cItemsPerBitPackDataUnit);
    const size_t maskBits = std::numeric_limits<size_t>::max() >> (k_cBitsForStorageType - cBitsPerItemMax);
 
-   const StorageDataTypeCore * pInputData = pTrainingSet->GetDataPointer(pAttributeCombination);
-   FractionalDataType * pResidualError = pTrainingSet->GetResidualPointer();
-   const FractionalDataType * const pResidualErrorLastItemWhereNextLoopCouldDoFullLoopOrLessAndComplete = pResidualError + cVectorLength * (static_cast<ptrdiff_t>(cCases) - cItemsPerBitPackDataUnit);
-
-   if(IsRegression(countCompilerClassificationTargetStates)) {
-      size_t cItemsRemaining;
-      while(pResidualError < pResidualErrorLastItemWhereNextLoopCouldDoFullLoopOrLessAndComplete) {
-         cItemsRemaining = cItemsPerBitPackDataUnit;
-         // TODO : jumping back into this loop and changing cItemsRemaining to a dynamic value that isn't compile time determinable
-         // causes this function to NOT be optimized as much as it could if we had two separate loops.  We're just trying this out for now though
-      one_last_loop_regression:;
-         // we store the already multiplied dimensional value in *pInputData
-         size_t iBinCombined = static_cast<size_t>(*pInputData);
-         ++pInputData;
-         do {
-            const size_t iBin = maskBits & iBinCombined;
-            const FractionalDataType smallChangeToPrediction = aModelUpdateTensor[iBin * cVectorLength];
-            // this will apply a small fix to our existing TrainingPredictionScores, either positive or negative, whichever is needed
-            const FractionalDataType residualError = EbmStatistics::ComputeRegressionResidualError(*pResidualError - smallChangeToPrediction);
-            *pResidualError = residualError;
-            ++pResidualError;
-
-            iBinCombined >>= cBitsPerItemMax;
-            // TODO : try replacing cItemsRemaining with a pResidualErrorInnerLoopEnd which eliminates one subtact operation, but might make it harder for the compiler to optimize the loop away
-            --cItemsRemaining;
-         } while(0 != cItemsRemaining);
-      }
-      const FractionalDataType * const pResidualErrorEnd = pResidualErrorLastItemWhereNextLoopCouldDoFullLoopOrLessAndComplete + cVectorLength * cItemsPerBitPackDataUnit;
-      if(pResidualError < pResidualErrorEnd) {
-         // first time through?
-         EBM_ASSERT(0 == (pResidualErrorEnd - pResidualError) % cVectorLength);
-         cItemsRemaining = (pResidualErrorEnd - pResidualError) / cVectorLength;
-         EBM_ASSERT(0 < cItemsRemaining);
-         EBM_ASSERT(cItemsRemaining <= cItemsPerBitPackDataUnit);
-         goto one_last_loop_regression;
-      }
-      EBM_ASSERT(pResidualError == pResidualErrorEnd); // after our second iteration we should have finished everything!
-   } else {
-      EBM_ASSERT(IsClassification(countCompilerClassificationTargetStates));
-      FractionalDataType * pTrainingPredictionScores = pTrainingSet->GetPredictionScores();
-      const StorageDataTypeCore * pTargetData = pTrainingSet->GetTargetDataPointer();
-
-      size_t cItemsRemaining;
-
-      while(pResidualError < pResidualErrorLastItemWhereNextLoopCouldDoFullLoopOrLessAndComplete) {
-         cItemsRemaining = cItemsPerBitPackDataUnit;
-         // TODO : jumping back into this loop and changing cItemsRemaining to a dynamic value that isn't compile time determinable
-         // causes this function to NOT be optimized as much as it could if we had two separate loops.  We're just trying this out for now though
-      one_last_loop_classification:;
-         // we store the already multiplied dimensional value in *pInputData
-         size_t iBinCombined = static_cast<size_t>(*pInputData);
-         ++pInputData;
-         do {
-            StorageDataTypeCore targetData = *pTargetData;
-
-            const size_t iBin = maskBits & iBinCombined;
-            const FractionalDataType * pValues = &aModelUpdateTensor[iBin * cVectorLength];
-
-            if(IsBinaryClassification(countCompilerClassificationTargetStates)) {
-               const FractionalDataType smallChangeToPredictionScores = pValues[0];
-               // this will apply a small fix to our existing TrainingPredictionScores, either positive or negative, whichever is needed
-               const FractionalDataType trainingPredictionScore = *pTrainingPredictionScores + smallChangeToPredictionScores;
-               *pTrainingPredictionScores = trainingPredictionScore;
-               const FractionalDataType residualError = EbmStatistics::ComputeClassificationResidualErrorBinaryclass(trainingPredictionScore, targetData);
-               *pResidualError = residualError;
-               ++pResidualError;
-            } else {
-               FractionalDataType sumExp = 0;
-               size_t iVector1 = 0;
-               do {
-                  const FractionalDataType smallChangeToPredictionScores = pValues[iVector1];
-                  // this will apply a small fix to our existing TrainingPredictionScores, either positive or negative, whichever is needed
-                  const FractionalDataType trainingPredictionScores = pTrainingPredictionScores[iVector1] + smallChangeToPredictionScores;
-                  pTrainingPredictionScores[iVector1] = trainingPredictionScores;
-                  sumExp += std::exp(trainingPredictionScores);
-                  ++iVector1;
-               } while(iVector1 < cVectorLength);
+   // chunks need to start on a bit pack boundary so that we can find the first item by indexing into the packed data
+   EBM_ASSERT(0 == iCaseStart % cItemsPerBitPackDataUnit);
+   const StorageDataTypeCore * pInputData = pTrainingSet->GetDataPointer(pAttributeCombination) + iCaseStart / cItemsPerBitPackDataUnit;
+   TFloat * pResidualError = pTrainingSet->GetResidualPointer<TFloat>() + iCaseStart;
+   const TFloat * const pResidualErrorLastItemWhereNextLoopCouldDoFullLoopOrLessAndComplete = pResidualError + (static_cast<ptrdiff_t>(cCases) - cItemsPerBitPackDataUnit);
+
+   size_t cItemsRemaining;
+   while(pResidualError < pResidualErrorLastItemWhereNextLoopCouldDoFullLoopOrLessAndComplete) {
+      cItemsRemaining = cItemsPerBitPackDataUnit;
+      // TODO : jumping back into this loop and changing cItemsRemaining to a dynamic value that isn't compile time determinable
+      // causes this function to NOT be optimized as much as it could if we had two separate loops.  We're just trying this out for now though
+   one_last_loop_regression:;
+      // we store the already multiplied dimensional value in *pInputData
+      size_t iBinCombined = static_cast<size_t>(*pInputData);
+      ++pInputData;
+      do {
+         const size_t iBin = maskBits & iBinCombined;
+         const FractionalDataType smallChangeToPrediction = aModelUpdateTensor[iBin];
+         // this will apply a small fix to our existing TrainingPredictionScores, either positive or negative, whichever is needed
+         const FractionalDataType residualError = EbmStatistics::ComputeRegressionResidualError(static_cast<FractionalDataType>(*pResidualError) - smallChangeToPrediction);
+         *pResidualError = static_cast<TFloat>(residualError);
+         ++pResidualError;
+
+         iBinCombined >>= cBitsPerItemMax;
+         // TODO : try replacing cItemsRemaining with a pResidualErrorInnerLoopEnd which eliminates one subtact operation, but might make it harder for the compiler to optimize the loop away
+         --cItemsRemaining;
+      } while(0 != cItemsRemaining);
+   }
+   const TFloat * const pResidualErrorEnd = pResidualErrorLastItemWhereNextLoopCouldDoFullLoopOrLessAndComplete + cItemsPerBitPackDataUnit;
+   if(pResidualError < pResidualErrorEnd) {
+      // first time through?
+      cItemsRemaining = static_cast<size_t>(pResidualErrorEnd - pResidualError);
+      EBM_ASSERT(0 < cItemsRemaining);
+      EBM_ASSERT(cItemsRemaining <= cItemsPerBitPackDataUnit);
+      goto one_last_loop_regression;
+   }
+   EBM_ASSERT(pResidualError == pResidualErrorEnd); // after our second iteration we should have finished everything!
 
-               EBM_ASSERT((IsNumberConvertable<StorageDataTypeCore, size_t>(cVectorLength)));
-               const StorageDataTypeCore cVectorLengthStorage = static_cast<StorageDataTypeCore>(cVectorLength);
-               StorageDataTypeCore iVector2 = 0;
-               do {
-                  // TODO : we're calculating exp(predictionScore) above, and then again in ComputeClassificationResidualErrorMulticlass.  exp(..) is expensive so we should just do it once instead and store the result in a small memory array here
-                  const FractionalDataType residualError = EbmStatistics::ComputeClassificationResidualErrorMulticlass(sumExp, pTrainingPredictionScores[iVector2], targetData, iVector2);
-                  *pResidualError = residualError;
-                  ++pResidualError;
-                  ++iVector2;
-               } while(iVector2 < cVectorLengthStorage);
-               // TODO: this works as a way to remove one parameter, but it obviously insn't as efficient as omitting the parameter
-               // 
-               // this works out in the math as making the first model vector parameter equal to zero, which in turn removes one degree of freedom
-               // from the model vector parameters.  Since the model vector weights need to be normalized to sum to a probabilty of 100%, we can set the first
-               // one to the constant 1 (0 in log space) and force the other parameters to adjust to that scale which fixes them to a single valid set of values
-               // insted of allowing them to be scaled.  
-               // Probability = exp(T1 + I1) / [exp(T1 + I1) + exp(T2 + I2) + exp(T3 + I3)] => we can add a constant inside each exp(..) term, which will be multiplication outside the exp(..), which
-               // means the numerator and denominator are multiplied by the same constant, which cancels eachother out.  We can thus set exp(T2 + I2) to exp(0) and adjust the other terms
-               constexpr bool bZeroingResiduals = 0 <= k_iZeroResidual;
-               if(bZeroingResiduals) {
-                  pResidualError[k_iZeroResidual - static_cast<ptrdiff_t>(cVectorLength)] = 0;
-               }
-            }
-            pTrainingPredictionScores += cVectorLength;
-            ++pTargetData;
+   LOG(TraceLevelVerbose, "Exited TrainingSetRegressionLoop");
+}
 
-            iBinCombined >>= cBitsPerItemMax;
-            // TODO : try replacing cItemsRemaining with a pResidualErrorInnerLoopEnd which eliminates one subtact operation, but might make it harder for the compiler to optimize the loop away
-            --cItemsRemaining;
-         } while(0 != cItemsRemaining);
-      }
-      const FractionalDataType * const pResidualErrorEnd = pResidualErrorLastItemWhereNextLoopCouldDoFullLoopOrLessAndComplete + cVectorLength * cItemsPerBitPackDataUnit;
-      if(pResidualError < pResidualErrorEnd) {
-         // first time through?
-         EBM_ASSERT(0 == (pResidualErrorEnd - pResidualError) % cVectorLength);
-         cItemsRemaining = (pResidualErrorEnd - pResidualError) / cVectorLength;
-         EBM_ASSERT(0 < cItemsRemaining);
-         EBM_ASSERT(cItemsRemaining <= cItemsPerBitPackDataUnit);
-         goto one_last_loop_classification;
-      }
-      EBM_ASSERT(pResidualError == pResidualErrorEnd); // after our second iteration we should have finished everything!
+template<typename TFloat>
+struct TrainingSetRegressionLoopSimd final {
+   template<typename... TArgs>
+   TML_INLINE static void Run(const TArgs... args) {
+      TrainingSetRegressionLoop<TFloat>(args...);
    }
-   LOG(TraceLevelVerbose, "Exited TrainingSetTargetAttributeLoop");
-}
+};
 
 // a*PredictionScores = logOdds for binary classification
 // a*PredictionScores = logWeights for multiclass classification
 // a*PredictionScores = predictedValue for regression
-template<unsigned int cInputBits, ptrdiff_t countCompilerClassificationTargetStates>
-static void TrainingSetInputAttributeLoop(const AttributeCombinationCore * const pAttributeCombination, DataSetAttributeCombination * const pTrainingSet, const FractionalDataType * const aModelUpdateTensor, const size_t cTargetStates) {
-   if(cTargetStates <= 1 << 1) {
-      TrainingSetTargetAttributeLoop<cInputBits, 1, countCompilerClassificationTargetStates>(pAttributeCombination, pTrainingSet, aModelUpdateTensor, cTargetStates);
-   } else if(cTargetStates <= 1 << 2) {
-      TrainingSetTargetAttributeLoop<cInputBits, 2, countCompilerClassificationTargetStates>(pAttributeCombination, pTrainingSet, aModelUpdateTensor, cTargetStates);
-   } else if(cTargetStates <= 1 << 4) {
-      TrainingSetTargetAttributeLoop<cInputBits, 4, countCompilerClassificationTargetStates>(pAttributeCombination, pTrainingSet, aModelUpdateTensor, cTargetStates);
-   } else if(cTargetStates <= 1 << 8) {
-      TrainingSetTargetAttributeLoop<cInputBits, 8, countCompilerClassificationTargetStates>(pAttributeCombination, pTrainingSet, aModelUpdateTensor, cTargetStates);
-   } else if(cTargetStates <= 1 << 16) {
-      TrainingSetTargetAttributeLoop<cInputBits, 16, countCompilerClassificationTargetStates>(pAttributeCombination, pTrainingSet, aModelUpdateTensor, cTargetStates);
-   } else if(static_cast<uint64_t>(cTargetStates) <= uint64_t { 1 } << 32) {
-      // if this is a 32 bit system, then m_cStates can't be 0x100000000 or above, because we would have checked that when converting the 64 bit numbers into size_t, and m_cStates will be promoted to a 64 bit number for the above comparison
-      // if this is a 64 bit system, then this comparison is fine
-
-      // TODO : perhaps we should change m_cStates into m_iStateMax so that we don't need to do the above promotion to 64 bits.. we can make it <= 0xFFFFFFFF.  Write a function to fill the lowest bits with ones for any number of bits
-
-      TrainingSetTargetAttributeLoop<cInputBits, 32, countCompilerClassificationTargetStates>(pAttributeCombination, pTrainingSet, aModelUpdateTensor, cTargetStates);
-   } else {
-      // our interface doesn't allow more than 64 bits, so even if size_t was bigger then we don't need to examine higher
-      static_assert(63 == CountBitsRequiredPositiveMax<IntegerDataType>(), "");
-      TrainingSetTargetAttributeLoop<cInputBits, 64, countCompilerClassificationTargetStates>(pAttributeCombination, pTrainingSet, aModelUpdateTensor, cTargetStates);
+// TFloat is the type that pTrainingSet stores its residuals and prediction scores as.  We do all of our math in FractionalDataType and round each new
+// prediction score to TFloat before computing its residual so that the residual we store always agrees with the prediction score that we store
+template<unsigned int cInputBits, unsigned int cTargetBits, ptrdiff_t countCompilerClassificationTargetStates, typename TFloat>
+static void TrainingSetTargetAttributeLoop(const AttributeCombinationCore * const pAttributeCombination, DataSetAttributeCombination * const pTrainingSet, const FractionalDataType * const aModelUpdateTensor, const size_t cTargetStates, const size_t iCaseStart, const size_t cCases, const MathBackendCore mathBackend) {
+   LOG(TraceLevelVerbose, "Entered TrainingSetTargetAttributeLoop");
+
+   // we process the cases in the range [iCaseStart, iCaseStart + cCases), which allows our caller to split the cases into chunks that can be processed on separate threads
+   EBM_ASSERT(0 < cCases);
+   EBM_ASSERT(iCaseStart + cCases <= pTrainingSet->GetCountCases());
+
+   if(IsBinaryClassification(countCompilerClassificationTargetStates)) {
+      TrainingSetBinaryclassLoop<cTargetBits, TFloat>(pAttributeCombination, pTrainingSet, aModelUpdateTensor, iCaseStart, cCases, mathBackend);
+      LOG(TraceLevelVerbose, "Exited TrainingSetTargetAttributeLoop - Binary classification");
+      return;
    }
+   if(IsClassification(countCompilerClassificationTargetStates)) {
+      TrainingSetMulticlassLoop<cTargetBits, countCompilerClassificationTargetStates, TFloat>(pAttributeCombination, pTrainingSet, aModelUpdateTensor, cTargetStates, iCaseStart, cCases, mathBackend);
+      LOG(TraceLevelVerbose, "Exited TrainingSetTargetAttributeLoop - Multiclass");
+      return;
+   }
+   EBM_ASSERT(IsRegression(countCompilerClassificationTargetStates));
+   RunSimdVariant<TrainingSetRegressionLoopSimd<TFloat>>(pAttributeCombination, pTrainingSet, aModelUpdateTensor, iCaseStart, cCases);
+   LOG(TraceLevelVerbose, "Exited TrainingSetTargetAttributeLoop");
 }
 
 // a*PredictionScores = logOdds for binary classification
 // a*PredictionScores = logWeights for multiclass classification
 // a*PredictionScores = predictedValue for regression
-template<unsigned int cInputBits, unsigned int cTargetBits, ptrdiff_t countCompilerClassificationTargetStates>
-static FractionalDataType ValidationSetTargetAttributeLoop(const AttributeCombinationCore * const pAttributeCombination, DataSetAttributeCombination * const pValidationSet, const FractionalDataType * const aModelUpdateTensor, const size_t cTargetStates) {
-   LOG(TraceLevelVerbose, "Entering ValidationSetTargetAttributeLoop");
+template<unsigned int cInputBits, ptrdiff_t countCompilerClassificationTargetStates, typename TFloat>
+static void TrainingSetInputAttributeLoop(const AttributeCombinationCore * const pAttributeCombination, DataSetAttributeCombination * const pTrainingSet, const FractionalDataType * const aModelUpdateTensor, const size_t cTargetStates, const size_t iCaseStart, const size_t cCases, const MathBackendCore mathBackend) {
+   // our targets are bit packed with the width that GetCountBitsPerTarget chooses, so we need to read them with the matching BitPackedTargetReader
+   const size_t cTargetBits = pTrainingSet->GetTargetBitsPerItem();
+   EBM_ASSERT(IsRegression(countCompilerClassificationTargetStates) || GetCountBitsPerTarget(cTargetStates) == cTargetBits);
+   switch(cTargetBits) {
+   case 1:
+      TrainingSetTargetAttributeLoop<cInputBits, 1, countCompilerClassificationTargetStates, TFloat>(pAttributeCombination, pTrainingSet, aModelUpdateTensor, cTargetStates, iCaseStart, cCases, mathBackend);
+      break;
+   case 2:
+      TrainingSetTargetAttributeLoop<cInputBits, 2, countCompilerClassificationTargetStates, TFloat>(pAttributeCombination, pTrainingSet, aModelUpdateTensor, cTargetStates, iCaseStart, cCases, mathBackend);
+      break;
+   case 4:
+      TrainingSetTargetAttributeLoop<cInputBits, 4, countCompilerClassificationTargetStates, TFloat>(pAttributeCombination, pTrainingSet, aModelUpdateTensor, cTargetStates, iCaseStart, cCases, mathBackend);
+      break;
+   case 8:
+      TrainingSetTargetAttributeLoop<cInputBits, 8, countCompilerClassificationTargetStates, TFloat>(pAttributeCombination, pTrainingSet, aModelUpdateTensor, cTargetStates, iCaseStart, cCases, mathBackend);
+      break;
+   case 16:
+      TrainingSetTargetAttributeLoop<cInputBits, 16, countCompilerClassificationTargetStates, TFloat>(pAttributeCombination, pTrainingSet, aModelUpdateTensor, cTargetStates, iCaseStart, cCases, mathBackend);
+      break;
+   case 32:
+      TrainingSetTargetAttributeLoop<cInputBits, 32, countCompilerClassificationTargetStates, TFloat>(pAttributeCombination, pTrainingSet, aModelUpdateTensor, cTargetStates, iCaseStart, cCases, mathBackend);
+      break;
+   default:
+      EBM_ASSERT(64 == cTargetBits);
+      TrainingSetTargetAttributeLoop<cInputBits, 64, countCompilerClassificationTargetStates, TFloat>(pAttributeCombination, pTrainingSet, aModelUpdateTensor, cTargetStates, iCaseStart, cCases, mathBackend);
+      break;
+   }
+}
+
+// writes the log loss of each case in the range [iCaseStart, iCaseStart + cCases) to aCaseLosses.  Like TrainingSetBinaryclassLoop, we unpack whole
+// StorageDataTypeCore units into stack buffers and have a kernel calculate the log loss of each case
+template<unsigned int cTargetBits, typename TFloat>
+static void ValidationSetBinaryclassLoop(const AttributeCombinationCore * const pAttributeCombination, DataSetAttributeCombination * const pValidationSet, const FractionalDataType * const aModelUpdateTensor, const size_t iCaseStart, const size_t cCases, const MathBackendCore mathBackend, FractionalDataType * const aCaseLosses) {
+   LOG(TraceLevelVerbose, "Entering ValidationSetBinaryclassLoop");
 
-   const size_t cVectorLength = GET_VECTOR_LENGTH(countCompilerClassificationTargetStates, cTargetStates);
-   const size_t cCases = pValidationSet->GetCountCases();
    EBM_ASSERT(0 < cCases);
+   EBM_ASSERT(iCaseStart + cCases <= pValidationSet->GetCountCases());
 
-   if(0 == pAttributeCombination->m_cAttributes) {
-      if(IsRegression(countCompilerClassificationTargetStates)) {
-         FractionalDataType * pResidualError = pValidationSet->GetResidualPointer();
-         const FractionalDataType * const pResidualErrorEnd = pResidualError + cCases;
-
-         const FractionalDataType smallChangeToPrediction = aModelUpdateTensor[0];
-
-         FractionalDataType rootMeanSquareError = 0;
-         while(pResidualErrorEnd != pResidualError) {
-            // this will apply a small fix to our existing ValidationPredictionScores, either positive or negative, whichever is needed
-            const FractionalDataType residualError = EbmStatistics::ComputeRegressionResidualError(*pResidualError - smallChangeToPrediction);
-            rootMeanSquareError += residualError * residualError;
-            *pResidualError = residualError;
-            ++pResidualError;
-         }
+   const BinaryclassLogLossKernel<TFloat> binaryclassLogLossKernel = GetBinaryclassLogLossKernel<TFloat>(mathBackend);
 
-         rootMeanSquareError /= pValidationSet->GetCountCases();
-         LOG(TraceLevelVerbose, "Exited ValidationSetTargetAttributeLoop - Zero dimensions");
-         return sqrt(rootMeanSquareError);
-      } else {
-         EBM_ASSERT(IsClassification(countCompilerClassificationTargetStates));
-         FractionalDataType * pValidationPredictionScores = pValidationSet->GetPredictionScores();
-         const StorageDataTypeCore * pTargetData = pValidationSet->GetTargetDataPointer();
-
-         const FractionalDataType * const pValidationPredictionEnd = pValidationPredictionScores + cVectorLength * cCases;
-
-         FractionalDataType sumLogLoss = 0;
-         if(IsBinaryClassification(countCompilerClassificationTargetStates)) {
-            const FractionalDataType smallChangeToPredictionScores = aModelUpdateTensor[0];
-            while(pValidationPredictionEnd != pValidationPredictionScores) {
-               StorageDataTypeCore targetData = *pTargetData;
-               // this will apply a small fix to our existing ValidationPredictionScores, either positive or negative, whichever is needed
-               const FractionalDataType validationPredictionScores = *pValidationPredictionScores + smallChangeToPredictionScores;
-               *pValidationPredictionScores = validationPredictionScores;
-               sumLogLoss += EbmStatistics::ComputeClassificationSingleCaseLogLossBinaryclass(validationPredictionScores, targetData);
-               ++pValidationPredictionScores;
-               ++pTargetData;
-            }
+   TFloat * pValidationPredictionScores = pValidationSet->GetPredictionScores<TFloat>() + iCaseStart;
+   BitPackedCaseUnpacker<cTargetBits> caseUnpacker(pValidationSet, pAttributeCombination, iCaseStart);
+
+   int64_t aiBins[k_cSimdKernelCases];
+   int64_t aTargets[k_cSimdKernelCases];
+
+   FractionalDataType * pCaseLosses = aCaseLosses;
+   size_t cCasesRemaining = cCases;
+   do {
+      const size_t cBufferedCases = caseUnpacker.Unpack(aiBins, aTargets, k_cSimdKernelCases, cCasesRemaining);
+
+#ifndef NDEBUG
+      TFloat aPredictionScoresDebug[k_cSimdKernelCases];
+      memcpy(aPredictionScoresDebug, pValidationPredictionScores, sizeof(TFloat) * cBufferedCases);
+#endif // NDEBUG
+
+      (*binaryclassLogLossKernel)(aModelUpdateTensor, aiBins, aTargets, pValidationPredictionScores, pCaseLosses, cBufferedCases);
+
+#ifndef NDEBUG
+      for(size_t iCase = 0; iCase < cBufferedCases; ++iCase) {
+         const TFloat validationPredictionScore = static_cast<TFloat>(static_cast<FractionalDataType>(aPredictionScoresDebug[iCase]) + aModelUpdateTensor[static_cast<size_t>(aiBins[iCase])]);
+         EBM_ASSERT(validationPredictionScore == pValidationPredictionScores[iCase] || std::isnan(validationPredictionScore));
+         const FractionalDataType logLoss = EbmStatistics::ComputeClassificationSingleCaseLogLossBinaryclass(static_cast<FractionalDataType>(validationPredictionScore), static_cast<StorageDataTypeCore>(aTargets[iCase]));
+         // libm's log(1 + exp(x)) rounds to zero once exp(x) is below epsilon, which the fast kernels don't do, so we also allow an absolute difference there
+         EBM_ASSERT(MathBackendCore::FastCore == mathBackend ? IsWithinRelativeError(logLoss, pCaseLosses[iCase], k_fastMathRelativeError) || std::abs(logLoss - pCaseLosses[iCase]) <= std::numeric_limits<FractionalDataType>::epsilon() : logLoss == pCaseLosses[iCase] || std::isnan(logLoss));
+      }
+#endif // NDEBUG
+
+      pCaseLosses += cBufferedCases;
+      pValidationPredictionScores += cBufferedCases;
+      cCasesRemaining -= cBufferedCases;
+   } while(0 != cCasesRemaining);
+
+   LOG(TraceLevelVerbose, "Exited ValidationSetBinaryclassLoop");
+}
+
+// writes the log loss of each case in the range [iCaseStart, iCaseStart + cCases) to aCaseLosses.  Like TrainingSetMulticlassLoop, we calculate the exps of
+// a whole buffer of cases at once and take both the softmax denominator and the exp of the actual target state from that buffer.  We then take the logs of
+// the probabilities of the whole buffer at once
+template<unsigned int cTargetBits, ptrdiff_t countCompilerClassificationTargetStates, typename TFloat>
+static void ValidationSetMulticlassLoop(const AttributeCombinationCore * const pAttributeCombination, DataSetAttributeCombination * const pValidationSet, const FractionalDataType * const aModelUpdateTensor, const size_t cTargetStates, const size_t iCaseStart, const size_t cCases, const MathBackendCore mathBackend, FractionalDataType * const aCaseLosses) {
+   LOG(TraceLevelVerbose, "Entering ValidationSetMulticlassLoop");
+
+   const size_t cVectorLength = GET_VECTOR_LENGTH(countCompilerClassificationTargetStates, cTargetStates);
+   EBM_ASSERT(0 < cCases);
+   EBM_ASSERT(iCaseStart + cCases <= pValidationSet->GetCountCases());
+
+   const ExpKernel<TFloat> expKernel = GetExpKernel<TFloat>(mathBackend);
+   const LogKernel logKernel = GetLogKernel(mathBackend);
+
+   // TODO : this is no longer a prediction for multiclass.  It is a weight.  Change all instances of this naming. -> validationLogWeight
+   TFloat * pValidationPredictionScores = pValidationSet->GetPredictionScores<TFloat>() + cVectorLength * iCaseStart;
+   BitPackedCaseUnpacker<cTargetBits> caseUnpacker(pValidationSet, pAttributeCombination, iCaseStart);
+
+   int64_t aiBins[k_cSimdKernelCases];
+   int64_t aTargets[k_cSimdKernelCases];
+   FractionalDataType aExps[k_cSimdKernelValues];
+   // zero if a single case has more logits than fit into aExps
+   const size_t cCasesPerExpBatch = k_cSimdKernelValues / cVectorLength;
+   // the probability of each case's actual target state, which our log kernel then replaces with its log
+   FractionalDataType aLogProbabilities[k_cSimdKernelCases];
+
+   FractionalDataType * pCaseLosses = aCaseLosses;
+   size_t cCasesRemaining = cCases;
+   do {
+      const size_t cBufferedCases = caseUnpacker.Unpack(aiBins, aTargets, k_cSimdKernelCases, cCasesRemaining);
+      ApplyMulticlassModelUpdate<countCompilerClassificationTargetStates, TFloat>(aModelUpdateTensor, aiBins, pValidationPredictionScores, cVectorLength, cBufferedCases);
+
+      size_t iBufferedCase = 0;
+      do {
+         size_t cExpBatchCases = cBufferedCases - iBufferedCase < cCasesPerExpBatch ? cBufferedCases - iBufferedCase : cCasesPerExpBatch;
+         if(UNLIKELY(0 == cExpBatchCases)) {
+            // we can't fit all the logits of this case into aExps, so we sum them in pieces and then calculate the one that we need again
+            cExpBatchCases = 1;
+            const size_t iTarget = static_cast<size_t>(aTargets[iBufferedCase]);
+            const FractionalDataType sumExp = SumExpInPieces(expKernel, pValidationPredictionScores, cVectorLength, aExps);
+            (*expKernel)(&pValidationPredictionScores[iTarget], aExps, 1);
+            aLogProbabilities[iBufferedCase] = EbmStatistics::ComputeClassificationProbabilityMulticlass(sumExp, aExps[0]);
          } else {
-            const FractionalDataType * pValues = aModelUpdateTensor;
-            while(pValidationPredictionEnd != pValidationPredictionScores) {
-               StorageDataTypeCore targetData = *pTargetData;
+            (*expKernel)(pValidationPredictionScores, aExps, cExpBatchCases * cVectorLength);
+            const FractionalDataType * pExps = aExps;
+            for(size_t iExpBatchCase = 0; iExpBatchCase < cExpBatchCases; ++iExpBatchCase) {
                FractionalDataType sumExp = 0;
                size_t iVector = 0;
                do {
-                  const FractionalDataType smallChangeToPredictionScores = pValues[iVector];
-                  // this will apply a small fix to our existing validationPredictionScores, either positive or negative, whichever is needed
-
-                  // TODO : this is no longer a prediction for multiclass.  It is a weight.  Change all instances of this naming. -> validationLogWeight
-                  const FractionalDataType validationPredictionScores = *pValidationPredictionScores + smallChangeToPredictionScores;
-                  *pValidationPredictionScores = validationPredictionScores;
-                  sumExp += std::exp(validationPredictionScores);
-                  ++pValidationPredictionScores;
-
-                  // TODO : consider replacing iVector with pValidationPredictionScoresInnerEnd
+                  sumExp += pExps[iVector];
                   ++iVector;
-               } while(iVector < cVectorLength);
-               // TODO: store the result of std::exp above for the index that we care about above since exp(..) is going to be expensive and probably even more expensive than an unconditional branch
-               sumLogLoss += EbmStatistics::ComputeClassificationSingleCaseLogLossMulticlass(sumExp, pValidationPredictionScores - cVectorLength, targetData);
-               ++pTargetData;
+               } while(iVector < GET_VECTOR_LENGTH(countCompilerClassificationTargetStates, cVectorLength));
+               aLogProbabilities[iBufferedCase + iExpBatchCase] = EbmStatistics::ComputeClassificationProbabilityMulticlass(sumExp, pExps[static_cast<size_t>(aTargets[iBufferedCase + iExpBatchCase])]);
+               pExps += cVectorLength;
             }
          }
-         LOG(TraceLevelVerbose, "Exited ValidationSetTargetAttributeLoop - Zero dimensions");
-         return sumLogLoss;
+         pValidationPredictionScores += cVectorLength * cExpBatchCases;
+         iBufferedCase += cExpBatchCases;
+      } while(iBufferedCase < cBufferedCases);
+
+#ifndef NDEBUG
+      FractionalDataType aProbabilitiesDebug[k_cSimdKernelCases];
+      memcpy(aProbabilitiesDebug, aLogProbabilities, sizeof(FractionalDataType) * cBufferedCases);
+#endif // NDEBUG
+
+      (*logKernel)(aLogProbabilities, aLogProbabilities, cBufferedCases);
+
+#ifndef NDEBUG
+      for(size_t iCase = 0; iCase < cBufferedCases; ++iCase) {
+         const FractionalDataType logProbability = std::log(aProbabilitiesDebug[iCase]);
+         EBM_ASSERT(MathBackendCore::FastCore == mathBackend ? IsWithinRelativeError(logProbability, aLogProbabilities[iCase], k_fastMathRelativeError) : logProbability == aLogProbabilities[iCase] || std::isnan(logProbability));
       }
-      EBM_ASSERT(false);
+#endif // NDEBUG
+
+      for(size_t iCase = 0; iCase < cBufferedCases; ++iCase) {
+         pCaseLosses[iCase] = EbmStatistics::ComputeClassificationSingleCaseLogLossMulticlass(aLogProbabilities[iCase]);
+      }
+      pCaseLosses += cBufferedCases;
+      cCasesRemaining -= cBufferedCases;
+   } while(0 != cCasesRemaining);
+
+   LOG(TraceLevelVerbose, "Exited ValidationSetMulticlassLoop");
+}
+
+// applies a regression model update to the validation cases in the range [iCaseStart, iCaseStart + cCases) and writes their squared errors to aCaseLosses.
+// We're forced inline so that ValidationSetRegressionLoopSimd can compile us for each instruction set
+template<typename TFloat>
+TML_INLINE static void ValidationSetRegressionLoop(const AttributeCombinationCore * const pAttributeCombination, DataSetAttributeCombination * const pValidationSet, const FractionalDataType * const aModelUpdateTensor, const size_t iCaseStart, const size_t cCases, FractionalDataType * const aCaseLosses) {
+   LOG(TraceLevelVerbose, "Entered ValidationSetRegressionLoop");
+
+   if(0 == pAttributeCombination->m_cAttributes) {
+      TFloat * pResidualError = pValidationSet->GetResidualPointer<TFloat>() + iCaseStart;
+      const TFloat * const pResidualErrorEnd = pResidualError + cCases;
+
+      const FractionalDataType smallChangeToPrediction = aModelUpdateTensor[0];
+
+      FractionalDataType * pCaseLoss = aCaseLosses;
+      while(pResidualErrorEnd != pResidualError) {
+         // this will apply a small fix to our existing ValidationPredictionScores, either positive or negative, whichever is needed
+         const FractionalDataType residualError = EbmStatistics::ComputeRegressionResidualError(static_cast<FractionalDataType>(*pResidualError) - smallChangeToPrediction);
+         *pCaseLoss = residualError * residualError;
+         ++pCaseLoss;
+         *pResidualError = static_cast<TFloat>(residualError);
+         ++pResidualError;
+      }
+
+      LOG(TraceLevelVerbose, "Exited ValidationSetRegressionLoop - Zero dimensions");
+      return;
    }
 
    const size_t cItemsPerBitPackDataUnit = pAttributeCombination->m_cItemsPerBitPackDataUnit;
    const size_t cBitsPerItemMax = GetCountBits(cItemsPerBitPackDataUnit);
    const size_t maskBits = std::numeric_limits<size_t>::max() >> (k_cBitsForStorageType - cBitsPerItemMax);
-   const StorageDataTypeCore * pInputData = pValidationSet->GetDataPointer(pAttributeCombination);
-
-   if(IsRegression(countCompilerClassificationTargetStates)) {
-      FractionalDataType * pResidualError = pValidationSet->GetResidualPointer();
-      const FractionalDataType * const pResidualErrorLastItemWhereNextLoopCouldDoFullLoopOrLessAndComplete = pResidualError + (static_cast<ptrdiff_t>(cCases) - cItemsPerBitPackDataUnit);
-
-      FractionalDataType rootMeanSquareError = 0;
-      size_t cItemsRemaining;
-      while(pResidualError < pResidualErrorLastItemWhereNextLoopCouldDoFullLoopOrLessAndComplete) {
-         cItemsRemaining = cItemsPerBitPackDataUnit;
-         // TODO : jumping back into this loop and changing cItemsRemaining to a dynamic value that isn't compile time determinable
-         // causes this function to NOT be optimized as much as it could if we had two separate loops.  We're just trying this out for now though
-      one_last_loop_regression:;
-         // we store the already multiplied dimensional value in *pInputData
-         size_t iBinCombined = static_cast<size_t>(*pInputData);
-         ++pInputData;
-         do {
-            const size_t iBin = maskBits & iBinCombined;
-            const FractionalDataType smallChangeToPrediction = aModelUpdateTensor[iBin * cVectorLength];
-            // this will apply a small fix to our existing ValidationPredictionScores, either positive or negative, whichever is needed
-            const FractionalDataType residualError = EbmStatistics::ComputeRegressionResidualError(*pResidualError - smallChangeToPrediction);
-            rootMeanSquareError += residualError * residualError;
-            *pResidualError = residualError;
-            ++pResidualError;
-
-            iBinCombined >>= cBitsPerItemMax;
-            // TODO : try replacing cItemsRemaining with a pResidualErrorInnerLoopEnd which eliminates one subtact operation, but might make it harder for the compiler to optimize the loop away
-            --cItemsRemaining;
-         } while(0 != cItemsRemaining);
-      }
-      const FractionalDataType * const pResidualErrorEnd = pResidualErrorLastItemWhereNextLoopCouldDoFullLoopOrLessAndComplete + cVectorLength * cItemsPerBitPackDataUnit;
-      if(pResidualError < pResidualErrorEnd) {
-         // first time through?
-         EBM_ASSERT(0 == (pResidualErrorEnd - pResidualError) % cVectorLength);
-         cItemsRemaining = (pResidualErrorEnd - pResidualError) / cVectorLength;
-         EBM_ASSERT(0 < cItemsRemaining);
-         EBM_ASSERT(cItemsRemaining <= cItemsPerBitPackDataUnit);
-         goto one_last_loop_regression;
-      }
-      EBM_ASSERT(pResidualError == pResidualErrorEnd); // after our second iteration we should have finished everything!
-
-      rootMeanSquareError /= pValidationSet->GetCountCases();
-      LOG(TraceLevelVerbose, "Exited ValidationSetTargetAttributeLoop");
-      return sqrt(rootMeanSquareError);
-   } else {
-      EBM_ASSERT(IsClassification(countCompilerClassificationTargetStates));
-      FractionalDataType * pValidationPredictionScores = pValidationSet->GetPredictionScores();
-      const StorageDataTypeCore * pTargetData = pValidationSet->GetTargetDataPointer();
-
-      size_t cItemsRemaining;
-
-      const FractionalDataType * const pValidationPredictionScoresLastItemWhereNextLoopCouldDoFullLoopOrLessAndComplete = pValidationPredictionScores + cVectorLength * (static_cast<ptrdiff_t>(cCases) - cItemsPerBitPackDataUnit);
-
-      FractionalDataType sumLogLoss = 0;
-      while(pValidationPredictionScores < pValidationPredictionScoresLastItemWhereNextLoopCouldDoFullLoopOrLessAndComplete) {
-         cItemsRemaining = cItemsPerBitPackDataUnit;
-         // TODO : jumping back into this loop and changing cItemsRemaining to a dynamic value that isn't compile time determinable
-         // causes this function to NOT be optimized as much as it could if we had two separate loops.  We're just trying this out for now though
-      one_last_loop_classification:;
-         // we store the already multiplied dimensional value in *pInputData
-         size_t iBinCombined = static_cast<size_t>(*pInputData);
-         ++pInputData;
-         do {
-            StorageDataTypeCore targetData = *pTargetData;
-
-            const size_t iBin = maskBits & iBinCombined;
-            const FractionalDataType * pValues = &aModelUpdateTensor[iBin * cVectorLength];
-
-            if(IsBinaryClassification(countCompilerClassificationTargetStates)) {
-               const FractionalDataType smallChangeToPredictionScores = pValues[0];
-               // this will apply a small fix to our existing ValidationPredictionScores, either positive or negative, whichever is needed
-               const FractionalDataType validationPredictionScores = *pValidationPredictionScores + smallChangeToPredictionScores;
-               *pValidationPredictionScores = validationPredictionScores;
-               sumLogLoss += EbmStatistics::ComputeClassificationSingleCaseLogLossBinaryclass(validationPredictionScores, targetData);
-               ++pValidationPredictionScores;
-            } else {
-               FractionalDataType sumExp = 0;
-               size_t iVector = 0;
-               do {
-                  const FractionalDataType smallChangeToPredictionScores = pValues[iVector];
-                  // this will apply a small fix to our existing validationPredictionScores, either positive or negative, whichever is needed
+   // chunks need to start on a bit pack boundary so that we can find the first item by indexing into the packed data
+   EBM_ASSERT(0 == iCaseStart % cItemsPerBitPackDataUnit);
+   const StorageDataTypeCore * pInputData = pValidationSet->GetDataPointer(pAttributeCombination) + iCaseStart / cItemsPerBitPackDataUnit;
+
+   TFloat * pResidualError = pValidationSet->GetResidualPointer<TFloat>() + iCaseStart;
+   const TFloat * const pResidualErrorLastItemWhereNextLoopCouldDoFullLoopOrLessAndComplete = pResidualError + (static_cast<ptrdiff_t>(cCases) - cItemsPerBitPackDataUnit);
+
+   FractionalDataType * pCaseLoss = aCaseLosses;
+   size_t cItemsRemaining;
+   while(pResidualError < pResidualErrorLastItemWhereNextLoopCouldDoFullLoopOrLessAndComplete) {
+      cItemsRemaining = cItemsPerBitPackDataUnit;
+      // TODO : jumping back into this loop and changing cItemsRemaining to a dynamic value that isn't compile time determinable
+      // causes this function to NOT be optimized as much as it could if we had two separate loops.  We're just trying this out for now though
+   one_last_loop_regression:;
+      // we store the already multiplied dimensional value in *pInputData
+      size_t iBinCombined = static_cast<size_t>(*pInputData);
+      ++pInputData;
+      do {
+         const size_t iBin = maskBits & iBinCombined;
+         const FractionalDataType smallChangeToPrediction = aModelUpdateTensor[iBin];
+         // this will apply a small fix to our existing ValidationPredictionScores, either positive or negative, whichever is needed
+         const FractionalDataType residualError = EbmStatistics::ComputeRegressionResidualError(static_cast<FractionalDataType>(*pResidualError) - smallChangeToPrediction);
+         *pCaseLoss = residualError * residualError;
+         ++pCaseLoss;
+         *pResidualError = static_cast<TFloat>(residualError);
+         ++pResidualError;
+
+         iBinCombined >>= cBitsPerItemMax;
+         // TODO : try replacing cItemsRemaining with a pResidualErrorInnerLoopEnd which eliminates one subtact operation, but might make it harder for the compiler to optimize the loop away
+         --cItemsRemaining;
+      } while(0 != cItemsRemaining);
+   }
+   const TFloat * const pResidualErrorEnd = pResidualErrorLastItemWhereNextLoopCouldDoFullLoopOrLessAndComplete + cItemsPerBitPackDataUnit;
+   if(pResidualError < pResidualErrorEnd) {
+      // first time through?
+      cItemsRemaining = static_cast<size_t>(pResidualErrorEnd - pResidualError);
+      EBM_ASSERT(0 < cItemsRemaining);
+      EBM_ASSERT(cItemsRemaining <= cItemsPerBitPackDataUnit);
+      goto one_last_loop_regression;
+   }
+   EBM_ASSERT(pResidualError == pResidualErrorEnd); // after our second iteration we should have finished everything!
 
-                  // TODO : this is no longer a prediction for multiclass.  It is a weight.  Change all instances of this naming. -> validationLogWeight
-                  const FractionalDataType validationPredictionScores = *pValidationPredictionScores + smallChangeToPredictionScores;
-                  *pValidationPredictionScores = validationPredictionScores;
-                  sumExp += std::exp(validationPredictionScores);
-                  ++pValidationPredictionScores;
+   LOG(TraceLevelVerbose, "Exited ValidationSetRegressionLoop");
+}
 
-                  // TODO : consider replacing iVector with pValidationPredictionScoresInnerEnd
-                  ++iVector;
-               } while(iVector < cVectorLength);
-               // TODO: store the result of std::exp above for the index that we care about above since exp(..) is going to be expensive and probably even more expensive than an unconditional branch
-               sumLogLoss += EbmStatistics::ComputeClassificationSingleCaseLogLossMulticlass(sumExp, pValidationPredictionScores - cVectorLength, targetData);
-            }
-            ++pTargetData;
+template<typename TFloat>
+struct ValidationSetRegressionLoopSimd final {
+   template<typename... TArgs>
+   TML_INLINE static void Run(const TArgs... args) {
+      ValidationSetRegressionLoop<TFloat>(args...);
+   }
+};
 
-            iBinCombined >>= cBitsPerItemMax;
-            // TODO : try replacing cItemsRemaining with a pResidualErrorInnerLoopEnd which eliminates one subtact operation, but might make it harder for the compiler to optimize the loop away
-            --cItemsRemaining;
-         } while(0 != cItemsRemaining);
-      }
+// a*PredictionScores = logOdds for binary classification
+// a*PredictionScores = logWeights for multiclass classification
+// a*PredictionScores = predictedValue for regression
+// writes the squared error for regression, or the log loss for classification, of each case in the range [iCaseStart, iCaseStart + cCases) to aCaseLosses.  Our
+// caller adds them up in case order into the final metric
+template<unsigned int cInputBits, unsigned int cTargetBits, ptrdiff_t countCompilerClassificationTargetStates, typename TFloat>
+static void ValidationSetTargetAttributeLoop(const AttributeCombinationCore * const pAttributeCombination, DataSetAttributeCombination * const pValidationSet, const FractionalDataType * const aModelUpdateTensor, const size_t cTargetStates, const size_t iCaseStart, const size_t cCases, const MathBackendCore mathBackend, FractionalDataType * const aCaseLosses) {
+   LOG(TraceLevelVerbose, "Entering ValidationSetTargetAttributeLoop");
 
-      const FractionalDataType * const pValidationPredictionScoresEnd = pValidationPredictionScoresLastItemWhereNextLoopCouldDoFullLoopOrLessAndComplete + cVectorLength * cItemsPerBitPackDataUnit;
-      if(pValidationPredictionScores < pValidationPredictionScoresEnd) {
-         // first time through?
-         EBM_ASSERT(0 == (pValidationPredictionScoresEnd - pValidationPredictionScores) % cVectorLength);
-         cItemsRemaining = (pValidationPredictionScoresEnd - pValidationPredictionScores) / cVectorLength;
-         EBM_ASSERT(0 < cItemsRemaining);
-         EBM_ASSERT(cItemsRemaining <= cItemsPerBitPackDataUnit);
-         goto one_last_loop_classification;
-      }
-      EBM_ASSERT(pValidationPredictionScores == pValidationPredictionScoresEnd); // after our second iteration we should have finished everything!
+   EBM_ASSERT(0 < cCases);
+   EBM_ASSERT(iCaseStart + cCases <= pValidationSet->GetCountCases());
 
-      LOG(TraceLevelVerbose, "Exited ValidationSetTargetAttributeLoop");
-      return sumLogLoss;
+   if(IsBinaryClassification(countCompilerClassificationTargetStates)) {
+      ValidationSetBinaryclassLoop<cTargetBits, TFloat>(pAttributeCombination, pValidationSet, aModelUpdateTensor, iCaseStart, cCases, mathBackend, aCaseLosses);
+      LOG(TraceLevelVerbose, "Exited ValidationSetTargetAttributeLoop - Binary classification");
+      return;
+   }
+   if(IsClassification(countCompilerClassificationTargetStates)) {
+      ValidationSetMulticlassLoop<cTargetBits, countCompilerClassificationTargetStates, TFloat>(pAttributeCombination, pValidationSet, aModelUpdateTensor, cTargetStates, iCaseStart, cCases, mathBackend, aCaseLosses);
+      LOG(TraceLevelVerbose, "Exited ValidationSetTargetAttributeLoop - Multiclass");
+      return;
    }
+   EBM_ASSERT(IsRegression(countCompilerClassificationTargetStates));
+   RunSimdVariant<ValidationSetRegressionLoopSimd<TFloat>>(pAttributeCombination, pValidationSet, aModelUpdateTensor, iCaseStart, cCases, aCaseLosses);
+   LOG(TraceLevelVerbose, "Exited ValidationSetTargetAttributeLoop");
 }
 
 // a*PredictionScores = logOdds for binary classification
 // a*PredictionScores = logWeights for multiclass classification
 // a*PredictionScores = predictedValue for regression
-template<unsigned int cInputBits, ptrdiff_t countCompilerClassificationTargetStates>
-static FractionalDataType ValidationSetInputAttributeLoop(const AttributeCombinationCore * const pAttributeCombination, DataSetAttributeCombination * const pValidationSet, const FractionalDataType * const aModelUpdateTensor, const size_t cTargetStates) {
-   if(cTargetStates <= 1 << 1) {
-      return ValidationSetTargetAttributeLoop<cInputBits, 1, countCompilerClassificationTargetStates>(pAttributeCombination, pValidationSet, aModelUpdateTensor, cTargetStates);
-   } else if(cTargetStates <= 1 << 2) {
-      return ValidationSetTargetAttributeLoop<cInputBits, 2, countCompilerClassificationTargetStates>(pAttributeCombination, pValidationSet, aModelUpdateTensor, cTargetStates);
-   } else if(cTargetStates <= 1 << 4) {
-      return ValidationSetTargetAttributeLoop<cInputBits, 4, countCompilerClassificationTargetStates>(pAttributeCombination, pValidationSet, aModelUpdateTensor, cTargetStates);
-   } else if(cTargetStates <= 1 << 8) {
-      return ValidationSetTargetAttributeLoop<cInputBits, 8, countCompilerClassificationTargetStates>(pAttributeCombination, pValidationSet, aModelUpdateTensor, cTargetStates);
-   } else if(cTargetStates <= 1 << 16) {
-      return ValidationSetTargetAttributeLoop<cInputBits, 16, countCompilerClassificationTargetStates>(pAttributeCombination, pValidationSet, aModelUpdateTensor, cTargetStates);
-   } else if(static_cast<uint64_t>(cTargetStates) <= uint64_t { 1 } << 32) {
-      // if this is a 32 bit system, then m_cStates can't be 0x100000000 or above, because we would have checked that when converting the 64 bit numbers into size_t, and m_cStates will be promoted to a 64 bit number for the above comparison
-      // if this is a 64 bit system, then this comparison is fine
-
-      // TODO : perhaps we should change m_cStates into m_iStateMax so that we don't need to do the above promotion to 64 bits.. we can make it <= 0xFFFFFFFF.  Write a function to fill the lowest bits with ones for any number of bits
-
-      return ValidationSetTargetAttributeLoop<cInputBits, 32, countCompilerClassificationTargetStates>(pAttributeCombination, pValidationSet, aModelUpdateTensor, cTargetStates);
-   } else {
-      // our interface doesn't allow more than 64 bits, so even if size_t was bigger then we don't need to examine higher
-      static_assert(63 == CountBitsRequiredPositiveMax<IntegerDataType>(), "");
-      return ValidationSetTargetAttributeLoop<cInputBits, 64, countCompilerClassificationTargetStates>(pAttributeCombination, pValidationSet, aModelUpdateTensor, cTargetStates);
+template<unsigned int cInputBits, ptrdiff_t countCompilerClassificationTargetStates, typename TFloat>
+static void ValidationSetInputAttributeLoop(const AttributeCombinationCore * const pAttributeCombination, DataSetAttributeCombination * const pValidationSet, const FractionalDataType * const aModelUpdateTensor, const size_t cTargetStates, const size_t iCaseStart, const size_t cCases, const MathBackendCore mathBackend, FractionalDataType * const aCaseLosses) {
+   // our targets are bit packed with the width that GetCountBitsPerTarget chooses, so we need to read them with the matching BitPackedTargetReader
+   const size_t cTargetBits = pValidationSet->GetTargetBitsPerItem();
+   EBM_ASSERT(IsRegression(countCompilerClassificationTargetStates) || GetCountBitsPerTarget(cTargetStates) == cTargetBits);
+   switch(cTargetBits) {
+   case 1:
+      ValidationSetTargetAttributeLoop<cInputBits, 1, countCompilerClassificationTargetStates, TFloat>(pAttributeCombination, pValidationSet, aModelUpdateTensor, cTargetStates, iCaseStart, cCases, mathBackend, aCaseLosses);
+      break;
+   case 2:
+      ValidationSetTargetAttributeLoop<cInputBits, 2, countCompilerClassificationTargetStates, TFloat>(pAttributeCombination, pValidationSet, aModelUpdateTensor, cTargetStates, iCaseStart, cCases, mathBackend, aCaseLosses);
+      break;
+   case 4:
+      ValidationSetTargetAttributeLoop<cInputBits, 4, countCompilerClassificationTargetStates, TFloat>(pAttributeCombination, pValidationSet, aModelUpdateTensor, cTargetStates, iCaseStart, cCases, mathBackend, aCaseLosses);
+      break;
+   case 8:
+      ValidationSetTargetAttributeLoop<cInputBits, 8, countCompilerClassificationTargetStates, TFloat>(pAttributeCombination, pValidationSet, aModelUpdateTensor, cTargetStates, iCaseStart, cCases, mathBackend, aCaseLosses);
+      break;
+   case 16:
+      ValidationSetTargetAttributeLoop<cInputBits, 16, countCompilerClassificationTargetStates, TFloat>(pAttributeCombination, pValidationSet, aModelUpdateTensor, cTargetStates, iCaseStart, cCases, mathBackend, aCaseLosses);
+      break;
+   case 32:
+      ValidationSetTargetAttributeLoop<cInputBits, 32, countCompilerClassificationTargetStates, TFloat>(pAttributeCombination, pValidationSet, aModelUpdateTensor, cTargetStates, iCaseStart, cCases, mathBackend, aCaseLosses);
+      break;
+   default:
+      EBM_ASSERT(64 == cTargetBits);
+      ValidationSetTargetAttributeLoop<cInputBits, 64, countCompilerClassificationTargetStates, TFloat>(pAttributeCombination, pValidationSet, aModelUpdateTensor, cTargetStates, iCaseStart, cCases, mathBackend, aCaseLosses);
+      break;
    }
 }
 
@@ -606,11 +722,199 @@ union CachedThreadResourcesUnion {
    }
 };
 
+// everything that a single sampling set needs to build its model update independently of the other sampling sets.  We keep one of these per sampling set so that
+// all of our sampling sets can be trained simultaneously on different threads without sharing any scratch space.  The results are combined afterwards by the calling thread
+class SamplingSetScratch final {
+public:
+   const bool m_bRegression;
+   SegmentedRegionCore<ActiveDataType, FractionalDataType> * const m_pSmallChangeToModelOverwriteSingleSamplingSet;
+   FractionalDataType m_gain;
+   bool m_bTrainingError;
+
+   CachedThreadResourcesUnion m_cachedThreadResourcesUnion;
+
+   SamplingSetScratch(const bool bRegression, const size_t cVectorLength)
+      : m_bRegression(bRegression)
+      , m_pSmallChangeToModelOverwriteSingleSamplingSet(SegmentedRegionCore<ActiveDataType, FractionalDataType>::Allocate(k_cDimensionsMax, cVectorLength))
+      , m_gain(0)
+      , m_bTrainingError(false)
+      // we catch any errors in the constructor, so this should not be able to throw
+      , m_cachedThreadResourcesUnion(bRegression, cVectorLength) {
+   }
+
+   ~SamplingSetScratch() {
+      if(m_bRegression) {
+         // member classes inside a union requre explicit call to destructor
+         m_cachedThreadResourcesUnion.regression.~CachedTrainingThreadResources();
+      } else {
+         // member classes inside a union requre explicit call to destructor
+         m_cachedThreadResourcesUnion.classification.~CachedTrainingThreadResources();
+      }
+      SegmentedRegionCore<ActiveDataType, FractionalDataType>::Free(m_pSmallChangeToModelOverwriteSingleSamplingSet);
+   }
+
+   TML_INLINE bool IsError() const {
+      if(nullptr == m_pSmallChangeToModelOverwriteSingleSamplingSet) {
+         return true;
+      }
+      return m_bRegression ? m_cachedThreadResourcesUnion.regression.IsError() : m_cachedThreadResourcesUnion.classification.IsError();
+   }
+
+   static void FreeSamplingSetScratches(const size_t cSamplingSetScratches, SamplingSetScratch ** const apSamplingSetScratches) {
+      LOG(TraceLevelInfo, "Entered FreeSamplingSetScratches");
+      if(nullptr != apSamplingSetScratches) {
+         for(size_t iSamplingSetScratch = 0; iSamplingSetScratch < cSamplingSetScratches; ++iSamplingSetScratch) {
+            delete apSamplingSetScratches[iSamplingSetScratch];
+         }
+         delete[] apSamplingSetScratches;
+      }
+      LOG(TraceLevelInfo, "Exited FreeSamplingSetScratches");
+   }
+
+   static SamplingSetScratch ** AllocateSamplingSetScratches(const bool bRegression, const size_t cVectorLength, const size_t cSamplingSetScratches) {
+      LOG(TraceLevelInfo, "Entered AllocateSamplingSetScratches");
+
+      EBM_ASSERT(1 <= cSamplingSetScratches);
+
+      SamplingSetScratch ** const apSamplingSetScratches = new (std::nothrow) SamplingSetScratch *[cSamplingSetScratches];
+      if(UNLIKELY(nullptr == apSamplingSetScratches)) {
+         LOG(TraceLevelWarning, "WARNING AllocateSamplingSetScratches nullptr == apSamplingSetScratches");
+         return nullptr;
+      }
+      for(size_t iSamplingSetScratch = 0; iSamplingSetScratch < cSamplingSetScratches; ++iSamplingSetScratch) {
+         apSamplingSetScratches[iSamplingSetScratch] = nullptr;
+      }
+      for(size_t iSamplingSetScratch = 0; iSamplingSetScratch < cSamplingSetScratches; ++iSamplingSetScratch) {
+         SamplingSetScratch * const pSamplingSetScratch = new (std::nothrow) SamplingSetScratch(bRegression, cVectorLength);
+         // assign our pointer directly to our array right now so that we can't loose the memory if we decide to exit due to an error below
+         apSamplingSetScratches[iSamplingSetScratch] = pSamplingSetScratch;
+         if(UNLIKELY(nullptr == pSamplingSetScratch || pSamplingSetScratch->IsError())) {
+            LOG(TraceLevelWarning, "WARNING AllocateSamplingSetScratches nullptr == pSamplingSetScratch || pSamplingSetScratch->IsError()");
+            FreeSamplingSetScratches(cSamplingSetScratches, apSamplingSetScratches);
+            return nullptr;
+         }
+      }
+
+      LOG(TraceLevelInfo, "Exited AllocateSamplingSetScratches");
+      return apSamplingSetScratches;
+   }
+};
+
+// all the scratch space that GenerateModelUpdate writes to.  The EbmTrainingState object owns one of these for the non-reentrant GenerateModelUpdate, and callers that want to
+// generate updates for multiple attribute combinations simultaneously can allocate one per thread through AllocateTrainingThreadState.  Everything else that GenerateModelUpdate
+// touches in the EbmTrainingState is read only, so as long as each thread has its own TrainingThreadState, there is no shared mutable state
+class TrainingThreadState final {
+public:
+   const bool m_bRegression;
+   const size_t m_cVectorLength;
+   const size_t m_cSamplingSetScratches;
+
+   SegmentedRegionCore<ActiveDataType, FractionalDataType> * const m_pSmallChangeToModelAccumulatedFromSamplingSets;
+
+   // we have one of these per sampling set (or just one if there are zero sampling sets) so that we can train all our sampling sets in parallel
+   SamplingSetScratch ** const m_apSamplingSetScratches;
+
+   // holds the histograms for all the sampling sets when we bin them all in a single pass with BinDataSetTrainingFusedParallel
+   void * m_aFusedBinnedBuckets;
+   size_t m_cBytesFusedBinnedBucketsCapacity;
+
+   TrainingThreadState(const bool bRegression, const size_t cVectorLength, const size_t cSamplingSets)
+      : m_bRegression(bRegression)
+      , m_cVectorLength(cVectorLength)
+      , m_cSamplingSetScratches(0 == cSamplingSets ? 1 : cSamplingSets)
+      , m_pSmallChangeToModelAccumulatedFromSamplingSets(SegmentedRegionCore<ActiveDataType, FractionalDataType>::Allocate(k_cDimensionsMax, cVectorLength))
+      , m_apSamplingSetScratches(SamplingSetScratch::AllocateSamplingSetScratches(bRegression, cVectorLength, 0 == cSamplingSets ? 1 : cSamplingSets))
+      , m_aFusedBinnedBuckets(nullptr)
+      , m_cBytesFusedBinnedBucketsCapacity(0) {
+   }
+
+   ~TrainingThreadState() {
+      free(m_aFusedBinnedBuckets);
+      SamplingSetScratch::FreeSamplingSetScratches(m_cSamplingSetScratches, m_apSamplingSetScratches);
+      SegmentedRegionCore<ActiveDataType, FractionalDataType>::Free(m_pSmallChangeToModelAccumulatedFromSamplingSets);
+   }
+
+   TML_INLINE void * GetFusedBinnedBuckets(const size_t cBytesRequired) {
+      if(UNLIKELY(m_cBytesFusedBinnedBucketsCapacity < cBytesRequired)) {
+         // we don't need to preserve the contents, so free first which gives the allocator a chance to reuse the space
+         free(m_aFusedBinnedBuckets);
+         m_cBytesFusedBinnedBucketsCapacity = GetThreadByteBufferGrowth(cBytesRequired);
+         LOG(TraceLevelInfo, "Growing TrainingThreadState::FusedBinnedBuckets to %zu", m_cBytesFusedBinnedBucketsCapacity);
+         m_aFusedBinnedBuckets = malloc(m_cBytesFusedBinnedBucketsCapacity);
+         if(UNLIKELY(nullptr == m_aFusedBinnedBuckets)) {
+            m_cBytesFusedBinnedBucketsCapacity = 0;
+            return nullptr;
+         }
+      }
+      return m_aFusedBinnedBuckets;
+   }
+
+   TML_INLINE bool IsError() const {
+      return nullptr == m_pSmallChangeToModelAccumulatedFromSamplingSets || nullptr == m_apSamplingSetScratches;
+   }
+
+   // the buffers that our CachedTrainingThreadResources and our fused binning have grown to so far
+   size_t GetHistogramBufferBytes() const {
+      size_t cBytes = m_cBytesFusedBinnedBucketsCapacity;
+      if(nullptr != m_apSamplingSetScratches) {
+         for(size_t iSamplingSetScratch = 0; iSamplingSetScratch < m_cSamplingSetScratches; ++iSamplingSetScratch) {
+            const SamplingSetScratch * const pSamplingSetScratch = m_apSamplingSetScratches[iSamplingSetScratch];
+            cBytes += m_bRegression ? pSamplingSetScratch->m_cachedThreadResourcesUnion.regression.GetThreadByteBufferBytes() : pSamplingSetScratch->m_cachedThreadResourcesUnion.classification.GetThreadByteBufferBytes();
+         }
+      }
+      return cBytes;
+   }
+
+   // our model update scratch space, which grows to fit the largest attribute combination that we've generated an update for
+   size_t GetModelUpdateBytes() const {
+      size_t cBytes = nullptr == m_pSmallChangeToModelAccumulatedFromSamplingSets ? size_t { 0 } : m_pSmallChangeToModelAccumulatedFromSamplingSets->GetMemoryBytes();
+      if(nullptr != m_apSamplingSetScratches) {
+         for(size_t iSamplingSetScratch = 0; iSamplingSetScratch < m_cSamplingSetScratches; ++iSamplingSetScratch) {
+            cBytes += m_apSamplingSetScratches[iSamplingSetScratch]->m_pSmallChangeToModelOverwriteSingleSamplingSet->GetMemoryBytes();
+         }
+      }
+      return cBytes;
+   }
+
+   // everything we allocate in our constructor apart from the model update scratch space.  None of this depends on the data
+   static size_t GetFixedBytes(const bool bRegression, const size_t cVectorLength, const size_t cSamplingSets) {
+      const size_t cSamplingSetScratches = 0 == cSamplingSets ? 1 : cSamplingSets;
+      const size_t cBytesPredictionStatistics = bRegression ? sizeof(PredictionStatistics<true>) : sizeof(PredictionStatistics<false>);
+      // CachedTrainingThreadResources holds 3 PredictionStatistics arrays and 1 FractionalDataType array, each of cVectorLength items
+      const size_t cBytesPerScratch = sizeof(SamplingSetScratch *) + sizeof(SamplingSetScratch) + (3 * cBytesPredictionStatistics + sizeof(FractionalDataType)) * cVectorLength;
+      return MultiplySaturate(cBytesPerScratch, cSamplingSetScratches);
+   }
+};
+
+// we split the cases into chunks of this many cases when applying model updates so that the chunks can be processed on separate threads.  It's a multiple of
+// every possible m_cItemsPerBitPackDataUnit, so every chunk except the last one starts and ends on a bit pack boundary, and the chunk boundaries fall on the
+// same cases for every attribute combination and every number of threads.  The validation chunks write the loss of each case into a buffer instead of
+// summing them, and we add the buffer up in case order after the chunks finish, so the validation metric is exactly what a single serial loop over every
+// case would return, for any number of threads
+constexpr size_t k_cCasesPerApplyModelUpdateChunk = GetCountItemsBitPackedCommonMultiple();
+static_assert(16384 <= k_cCasesPerApplyModelUpdateChunk && k_cCasesPerApplyModelUpdateChunk <= 65536, "our chunks should be big enough to amortize dispatching them to a thread, but small enough to balance the work");
+
+// the validation chunks run in waves of two chunks per thread, and we only buffer the losses of one wave at a time so that our buffer doesn't grow with the
+// validation set.  Two chunks per thread keeps the threads busy when the chunks take uneven times.  We allocate the buffer once when we initialize, so
+// ApplyModelUpdate has nothing that can fail after it starts changing the model
+TML_INLINE static size_t GetValidationCaseLossesCount(const size_t cValidationCases) {
+   const size_t cCasesPerWave = MultiplySaturate(GetParallelThreadCount() * 2, k_cCasesPerApplyModelUpdateChunk);
+   return cValidationCases < cCasesPerWave ? cValidationCases : cCasesPerWave;
+}
+
 // TODO: rename this EbmTrainingState
 class TmlState {
 public:
    const bool m_bRegression;
    const size_t m_cTargetStates;
+   // if true, our data sets store their residuals and prediction scores as float instead of FractionalDataType
+   const bool m_bSinglePrecision;
+   // if true, our inner bags are drawn without replacement and stored as a bit per case (see SamplingWithoutReplacement)
+   const bool m_bSamplingWithoutReplacement;
+   // where our data sets put their arenas.  Huge pages on request, or a temporary file for out of core training
+   const ArenaBackingCore m_arenaBacking;
+   // whether our residuals and validation log loss use libm or our fast polynomial exp and log (see MathBackendCore)
+   const MathBackendCore m_mathBackend;
 
    const size_t m_cAttributeCombinations;
    AttributeCombinationCore ** const m_apAttributeCombinations;
@@ -618,6 +922,9 @@ public:
    // TODO : can we internalize these so that they are not pointers and are therefore subsumed into our class
    DataSetAttributeCombination * m_pTrainingSet;
    DataSetAttributeCombination * m_pValidationSet;
+   // the loss of each validation case in the wave of chunks that ApplyModelUpdate is running.  See GetValidationCaseLossesCount
+   FractionalDataType * m_aValidationCaseLosses;
+   size_t m_cValidationCaseLosses;
 
    const size_t m_cSamplingSets;
 
@@ -627,52 +934,53 @@ public:
 
    FractionalDataType m_bestModelMetric;
 
-   SegmentedRegionCore<ActiveDataType, FractionalDataType> * const m_pSmallChangeToModelOverwriteSingleSamplingSet;
-   SegmentedRegionCore<ActiveDataType, FractionalDataType> * const m_pSmallChangeToModelAccumulatedFromSamplingSets;
-
    const size_t m_cAttributes;
    // TODO : in the future, we can allocate this inside a function so that even the objects inside are const
    AttributeInternalCore * const m_aAttributes;
 
-   CachedThreadResourcesUnion m_cachedThreadResourcesUnion;
+   // scratch space for the non-reentrant GenerateModelUpdate function
+   TrainingThreadState m_trainingThreadState;
+
+   // CancelTraining can be called from any thread while RunCyclicBoosting is running, so this needs to be atomic.  RunCyclicBoosting clears it when it starts
+   std::atomic<bool> m_bCancelled;
 
-   TmlState(const bool bRegression, const size_t cTargetStates, const size_t cAttributes, const size_t cAttributeCombinations, const size_t cSamplingSets)
+   // the largest memory use that GetMemoryUsage has seen.  Updated at the end of the calls that can allocate
+   size_t m_cBytesPeak;
+
+   TmlState(const bool bRegression, const size_t cTargetStates, const bool bSinglePrecision, const bool bSamplingWithoutReplacement, const ArenaBackingCore arenaBacking, const MathBackendCore mathBackend, const size_t cAttributes, const size_t cAttributeCombinations, const size_t cSamplingSets)
       : m_bRegression(bRegression)
       , m_cTargetStates(cTargetStates)
+      , m_bSinglePrecision(bSinglePrecision)
+      , m_bSamplingWithoutReplacement(bSamplingWithoutReplacement)
+      , m_arenaBacking(arenaBacking)
+      , m_mathBackend(mathBackend)
       , m_cAttributeCombinations(cAttributeCombinations)
       , m_apAttributeCombinations(0 == cAttributeCombinations ? nullptr : AttributeCombinationCore::AllocateAttributeCombinations(cAttributeCombinations))
       , m_pTrainingSet(nullptr)
       , m_pValidationSet(nullptr)
+      , m_aValidationCaseLosses(nullptr)
+      , m_cValidationCaseLosses(0)
       , m_cSamplingSets(cSamplingSets)
       , m_apSamplingSets(nullptr)
       , m_apCurrentModel(nullptr)
       , m_apBestModel(nullptr)
       , m_bestModelMetric(FractionalDataType { std::numeric_limits<FractionalDataType>::infinity() })
-      , m_pSmallChangeToModelOverwriteSingleSamplingSet(SegmentedRegionCore<ActiveDataType, FractionalDataType>::Allocate(k_cDimensionsMax, GetVectorLengthFlatCore(cTargetStates)))
-      , m_pSmallChangeToModelAccumulatedFromSamplingSets(SegmentedRegionCore<ActiveDataType, FractionalDataType>::Allocate(k_cDimensionsMax, GetVectorLengthFlatCore(cTargetStates)))
       , m_cAttributes(cAttributes)
       , m_aAttributes(0 == cAttributes || IsMultiplyError(sizeof(AttributeInternalCore), cAttributes) ? nullptr : static_cast<AttributeInternalCore *>(malloc(sizeof(AttributeInternalCore) * cAttributes)))
       // we catch any errors in the constructor, so this should not be able to throw
-      , m_cachedThreadResourcesUnion(bRegression, GetVectorLengthFlatCore(cTargetStates)) {
+      , m_trainingThreadState(bRegression, GetVectorLengthFlatCore(cTargetStates), cSamplingSets)
+      , m_bCancelled(false)
+      , m_cBytesPeak(0) {
    }
    
    ~TmlState() {
       LOG(TraceLevelInfo, "Entered ~EbmTrainingState");
 
-      if(m_bRegression) {
-         // member classes inside a union requre explicit call to destructor
-         LOG(TraceLevelInfo, "~EbmTrainingState identified as regression type");
-         m_cachedThreadResourcesUnion.regression.~CachedTrainingThreadResources();
-      } else {
-         // member classes inside a union requre explicit call to destructor
-         LOG(TraceLevelInfo, "~EbmTrainingState identified as classification type");
-         m_cachedThreadResourcesUnion.classification.~CachedTrainingThreadResources();
-      }
-
-      SamplingWithReplacement::FreeSamplingSets(m_cSamplingSets, m_apSamplingSets);
+      SamplingMethod::FreeSamplingSets(m_cSamplingSets, m_apSamplingSets);
 
       delete m_pTrainingSet;
       delete m_pValidationSet;
+      delete[] m_aValidationCaseLosses;
 
       AttributeCombinationCore::FreeAttributeCombinations(m_cAttributeCombinations, m_apAttributeCombinations);
 
@@ -680,187 +988,384 @@ public:
 
       DeleteSegmentsCore(m_cAttributeCombinations, m_apCurrentModel);
       DeleteSegmentsCore(m_cAttributeCombinations, m_apBestModel);
-      SegmentedRegionCore<ActiveDataType, FractionalDataType>::Free(m_pSmallChangeToModelOverwriteSingleSamplingSet);
-      SegmentedRegionCore<ActiveDataType, FractionalDataType>::Free(m_pSmallChangeToModelAccumulatedFromSamplingSets);
 
       LOG(TraceLevelInfo, "Exited ~EbmTrainingState");
    }
 
-   bool Initialize(const IntegerDataType randomSeed, const EbmAttribute * const aAttributes, const EbmAttributeCombination * const aAttributeCombinations, const IntegerDataType * attributeCombinationIndexes, const size_t cTrainingCases, const void * const aTrainingTargets, const IntegerDataType * const aTrainingData, const FractionalDataType * const aTrainingPredictionScores, const size_t cValidationCases, const void * const aValidationTargets, const IntegerDataType * const aValidationData, const FractionalDataType * const aValidationPredictionScores) {
-      LOG(TraceLevelInfo, "Entered EbmTrainingState::Initialize");
-      try {
-         if(m_bRegression) {
-            if(m_cachedThreadResourcesUnion.regression.IsError()) {
-               LOG(TraceLevelWarning, "WARNING EbmTrainingState::Initialize m_cachedThreadResourcesUnion.regression.IsError()");
-               return true;
+   // TFloat needs to be float if m_bSinglePrecision is set, and FractionalDataType otherwise
+   template<typename TFloat>
+   void InitializeDataSetResiduals(const size_t cTrainingCases, const void * const aTrainingTargets, const FractionalDataType * const aTrainingPredictionScores, const size_t cValidationCases, const void * const aValidationTargets, const FractionalDataType * const aValidationPredictionScores) {
+      if(m_bRegression) {
+         if(0 != cTrainingCases) {
+            InitializeResiduals<k_Regression>(cTrainingCases, aTrainingTargets, aTrainingPredictionScores, m_pTrainingSet->GetResidualPointer<TFloat>(), 0);
+         }
+         if(0 != cValidationCases) {
+            InitializeResiduals<k_Regression>(cValidationCases, aValidationTargets, aValidationPredictionScores, m_pValidationSet->GetResidualPointer<TFloat>(), 0);
+         }
+      } else {
+         if(2 == m_cTargetStates) {
+            if(0 != cTrainingCases) {
+               InitializeResiduals<2>(cTrainingCases, aTrainingTargets, aTrainingPredictionScores, m_pTrainingSet->GetResidualPointer<TFloat>(), m_cTargetStates);
             }
          } else {
-            if(m_cachedThreadResourcesUnion.classification.IsError()) {
-               LOG(TraceLevelWarning, "WARNING EbmTrainingState::Initialize m_cachedThreadResourcesUnion.classification.IsError()");
-               return true;
+            if(0 != cTrainingCases) {
+               InitializeResiduals<k_DynamicClassification>(cTrainingCases, aTrainingTargets, aTrainingPredictionScores, m_pTrainingSet->GetResidualPointer<TFloat>(), m_cTargetStates);
             }
          }
+      }
+   }
 
-         if(0 != m_cAttributes && nullptr == m_aAttributes) {
-            LOG(TraceLevelWarning, "WARNING EbmTrainingState::Initialize 0 != m_cAttributes && nullptr == m_aAttributes");
-            return true;
-         }
+   static size_t SetMemoryUsage(EbmMemoryUsage * const pMemoryUsage, const size_t cBytesInputData, const size_t cBytesCaseArrays, const size_t cBytesSamplingSets, const size_t cBytesHistogramBuffers, const size_t cBytesModels, const size_t cBytesOther, const size_t cBytesPeak) {
+      const size_t cBytesCurrent = AddSaturate(AddSaturate(AddSaturate(cBytesInputData, cBytesCaseArrays), AddSaturate(cBytesSamplingSets, cBytesHistogramBuffers)), AddSaturate(cBytesModels, cBytesOther));
+      if(nullptr != pMemoryUsage) {
+         pMemoryUsage->packedDataBytes = ClipBytes(cBytesInputData);
+         pMemoryUsage->residualBytes = ClipBytes(cBytesCaseArrays);
+         pMemoryUsage->samplingSetBytes = ClipBytes(cBytesSamplingSets);
+         pMemoryUsage->histogramBufferBytes = ClipBytes(cBytesHistogramBuffers);
+         pMemoryUsage->modelBytes = ClipBytes(cBytesModels);
+         pMemoryUsage->otherBytes = ClipBytes(cBytesOther);
+         pMemoryUsage->currentBytes = ClipBytes(cBytesCurrent);
+         pMemoryUsage->peakBytes = ClipBytes(cBytesPeak < cBytesCurrent ? cBytesCurrent : cBytesPeak);
+      }
+      return cBytesCurrent;
+   }
 
-         if(UNLIKELY(0 != m_cAttributeCombinations && nullptr == m_apAttributeCombinations)) {
-            LOG(TraceLevelWarning, "WARNING EbmTrainingState::Initialize 0 != m_cAttributeCombinations && nullptr == m_apAttributeCombinations");
-            return true;
+   // estimates can exceed what IntegerDataType holds on 32 bit platforms, and anything that large can't be allocated anyways
+   static IntegerDataType ClipBytes(const size_t cBytes) {
+      return IsNumberConvertable<IntegerDataType, size_t>(cBytes) ? static_cast<IntegerDataType>(cBytes) : std::numeric_limits<IntegerDataType>::max();
+   }
+
+   static size_t GetModelsMemoryBytes(const size_t cAttributeCombinations, const SegmentedRegionCore<ActiveDataType, FractionalDataType> * const * const apModels) {
+      if(nullptr == apModels) {
+         return 0;
+      }
+      size_t cBytes = sizeof(*apModels) * cAttributeCombinations;
+      for(size_t iAttributeCombination = 0; iAttributeCombination < cAttributeCombinations; ++iAttributeCombination) {
+         cBytes += apModels[iAttributeCombination]->GetMemoryBytes();
+      }
+      return cBytes;
+   }
+
+   // our attributes, attribute combinations and fixed size bookkeeping.  This only depends on our attribute combinations, so it's the same before and after we get data
+   size_t GetOtherBytes() const {
+      size_t cBytes = sizeof(*this) + TrainingThreadState::GetFixedBytes(m_bRegression, m_trainingThreadState.m_cVectorLength, m_cSamplingSets);
+      if(nullptr != m_aAttributes) {
+         cBytes += sizeof(AttributeInternalCore) * m_cAttributes;
+      }
+      if(nullptr != m_apAttributeCombinations) {
+         cBytes += sizeof(*m_apAttributeCombinations) * m_cAttributeCombinations;
+         for(size_t iAttributeCombination = 0; iAttributeCombination < m_cAttributeCombinations; ++iAttributeCombination) {
+            const AttributeCombinationCore * const pAttributeCombination = m_apAttributeCombinations[iAttributeCombination];
+            if(nullptr != pAttributeCombination) {
+               cBytes += AttributeCombinationCore::GetAttributeCombinationCountBytes(pAttributeCombination->m_cAttributes);
+            }
          }
+      }
+      return cBytes;
+   }
 
-         if(UNLIKELY(nullptr == m_pSmallChangeToModelOverwriteSingleSamplingSet)) {
-            LOG(TraceLevelWarning, "WARNING EbmTrainingState::Initialize nullptr == m_pSmallChangeToModelOverwriteSingleSamplingSet");
-            return true;
+   // fills pMemoryUsage (which can be nullptr) from the capacities of everything we hold, and returns the current total
+   size_t GetMemoryUsage(EbmMemoryUsage * const pMemoryUsage) const {
+      size_t cBytesInputData = 0;
+      size_t cBytesCaseArrays = 0;
+      if(nullptr != m_pTrainingSet) {
+         cBytesInputData += m_pTrainingSet->GetInputDataBytes();
+         cBytesCaseArrays += m_pTrainingSet->GetCaseArrayBytes();
+      }
+      if(nullptr != m_pValidationSet) {
+         cBytesInputData += m_pValidationSet->GetInputDataBytes();
+         cBytesCaseArrays += m_pValidationSet->GetCaseArrayBytes() + sizeof(*m_aValidationCaseLosses) * m_cValidationCaseLosses;
+      }
+      const size_t cBytesSamplingSets = SamplingMethod::GetSamplingSetsMemoryBytes(m_cSamplingSets, m_apSamplingSets);
+      const size_t cBytesHistogramBuffers = m_trainingThreadState.GetHistogramBufferBytes();
+      const size_t cBytesModels = GetModelsMemoryBytes(m_cAttributeCombinations, m_apCurrentModel) + GetModelsMemoryBytes(m_cAttributeCombinations, m_apBestModel) + m_trainingThreadState.GetModelUpdateBytes();
+      return SetMemoryUsage(pMemoryUsage, cBytesInputData, cBytesCaseArrays, cBytesSamplingSets, cBytesHistogramBuffers, cBytesModels, GetOtherBytes(), m_cBytesPeak);
+   }
+
+   // everything we hold only ever grows, except while realloc briefly holds both the old and new buffer, so sampling our usage after each call that can allocate
+   // gives us our high water mark
+   void UpdatePeakMemory() {
+      const size_t cBytesCurrent = GetMemoryUsage(nullptr);
+      m_cBytesPeak = m_cBytesPeak < cBytesCurrent ? cBytesCurrent : m_cBytesPeak;
+   }
+
+   // upper bounds on the histogram, tree node and partition buffers that our CachedTrainingThreadResources and fused binning grow to.  Each buffer is sized for one
+   // attribute combination at a time, so we take the largest request of each kind and grow it the same way that the allocators do
+   template<bool bRegression>
+   size_t EstimateHistogramBufferBytes(const size_t cTrainingCases) const {
+      const size_t cVectorLength = m_trainingThreadState.m_cVectorLength;
+      const size_t cBytesPerBinnedBucket = GetBinnedBucketSizeOverflow<bRegression>(cVectorLength) ? std::numeric_limits<size_t>::max() : GetBinnedBucketSize<bRegression>(cVectorLength);
+      const size_t cBytesPerTreeNode = GetTreeNodeSizeOverflow<bRegression>(cVectorLength) ? std::numeric_limits<size_t>::max() : GetTreeNodeSize<bRegression>(cVectorLength);
+
+      size_t cBytesHistogramMax = 0;
+      size_t cBytesTreeNodesMax = 0;
+      size_t cBytesPartitionsMax = 0;
+      size_t cBytesFusedMax = 0;
+      for(size_t iAttributeCombination = 0; iAttributeCombination < m_cAttributeCombinations; ++iAttributeCombination) {
+         const AttributeCombinationCore * const pAttributeCombination = m_apAttributeCombinations[iAttributeCombination];
+         const size_t cDimensions = pAttributeCombination->m_cAttributes;
+         size_t cBins = 1;
+         for(size_t iDimension = 0; iDimension < cDimensions; ++iDimension) {
+            // InitializeAttributes checked that this product doesn't overflow
+            cBins *= pAttributeCombination->m_AttributeCombinationEntry[iDimension].m_pAttribute->m_cStates;
+         }
+         size_t cBytesHistogram;
+         if(cDimensions <= 1) {
+            cBytesHistogram = MultiplySaturate(cBins, cBytesPerBinnedBucket);
+            if(1 == cDimensions) {
+               // a tree over cBins buckets has at most 2 * cBins - 1 nodes
+               const size_t cBytesTreeNodes = MultiplySaturate(AddSaturate(cBins, cBins), cBytesPerTreeNode);
+               cBytesTreeNodesMax = cBytesTreeNodesMax < cBytesTreeNodes ? cBytesTreeNodes : cBytesTreeNodesMax;
+            }
+         } else {
+            cBytesHistogram = MultiplySaturate(AddSaturate(cBins, GetAuxiliaryBucketCount(pAttributeCombination)), cBytesPerBinnedBucket);
+         }
+         cBytesHistogramMax = cBytesHistogramMax < cBytesHistogram ? cBytesHistogram : cBytesHistogramMax;
+
+         if(0 != cDimensions && 0 != cTrainingCases) {
+            const size_t cBytesBins = MultiplySaturate(cBins, cBytesPerBinnedBucket);
+            size_t cCasesPerPartition;
+            const size_t cPartitions = GetBinPartitionCount(cTrainingCases, MultiplySaturate(cBins, cVectorLength), pAttributeCombination->m_cItemsPerBitPackDataUnit, &cCasesPerPartition);
+            const size_t cBytesPartitions = MultiplySaturate(cBytesBins, cPartitions - 1);
+            cBytesPartitionsMax = cBytesPartitionsMax < cBytesPartitions ? cBytesPartitions : cBytesPartitionsMax;
+            if(2 <= m_cSamplingSets) {
+               // the fused scratch uses the same partitions as binning each sampling set separately
+               const size_t cBytesFused = MultiplySaturate(MultiplySaturate(cBytesBins, m_cSamplingSets), cPartitions);
+               if(cBytesFused <= k_cBytesFusedBinningMax) {
+                  // above the limit we bin each sampling set separately in its own scratch, which we counted above
+                  cBytesFusedMax = cBytesFusedMax < cBytesFused ? cBytesFused : cBytesFusedMax;
+               }
+            }
          }
+      }
+      // GrowThreadByteBuffer2 only grows while it holds less than it needs, and the initial tree nodes are the largest boundary that it grows by, so growing what we
+      // need by the initial tree nodes is an upper bound
+      const size_t cBytesTreeNodes = 0 == cBytesTreeNodesMax ? size_t { 0 } : GetThreadByteBuffer2Growth(cBytesTreeNodesMax, MultiplySaturate(cBytesPerTreeNode, k_cTreeNodesInitial));
+      const size_t cBytesPerScratch = AddSaturate(AddSaturate(GetThreadByteBufferGrowth(cBytesHistogramMax), cBytesTreeNodes), GetThreadByteBufferGrowth(cBytesPartitionsMax));
+      return AddSaturate(MultiplySaturate(cBytesPerScratch, m_trainingThreadState.m_cSamplingSetScratches), GetThreadByteBufferGrowth(cBytesFusedMax));
+   }
 
-         if(UNLIKELY(nullptr == m_pSmallChangeToModelAccumulatedFromSamplingSets)) {
-            LOG(TraceLevelWarning, "WARNING EbmTrainingState::Initialize nullptr == m_pSmallChangeToModelAccumulatedFromSamplingSets");
-            return true;
+   // predicts what GetMemoryUsage will report after we've trained on every attribute combination.  Only InitializeAttributes needs to have been called.  The datasets,
+   // sampling sets, models and bookkeeping are predicted exactly.  The histogram buffers and model update scratch space depend on the splits that we find, so we
+   // predict upper bounds for them
+   void EstimateMemoryUsage(const size_t cTrainingCases, const size_t cValidationCases, EbmMemoryUsage * const pMemoryUsage) const {
+      const size_t cVectorLength = m_trainingThreadState.m_cVectorLength;
+
+      size_t cBytesInputData = 0;
+      size_t cBytesCaseArrays = 0;
+      size_t cBytesSamplingSets = 0;
+      if(0 != cTrainingCases) {
+         cBytesInputData = DataSetAttributeCombination::GetPlannedInputDataBytes(m_cAttributeCombinations, m_apAttributeCombinations, cTrainingCases);
+         cBytesCaseArrays = DataSetAttributeCombination::GetPlannedCaseArrayBytes(true, !m_bRegression, !m_bRegression, cTrainingCases, m_cTargetStates, cVectorLength, m_bSinglePrecision);
+         cBytesSamplingSets = SamplingMethod::GetSamplingSetsPlannedBytes(cTrainingCases, m_cAttributeCombinations, m_apAttributeCombinations, m_cSamplingSets, m_bSamplingWithoutReplacement);
+      }
+      if(0 != cValidationCases) {
+         cBytesInputData = AddSaturate(cBytesInputData, DataSetAttributeCombination::GetPlannedInputDataBytes(m_cAttributeCombinations, m_apAttributeCombinations, cValidationCases));
+         cBytesCaseArrays = AddSaturate(cBytesCaseArrays, DataSetAttributeCombination::GetPlannedCaseArrayBytes(m_bRegression, !m_bRegression, !m_bRegression, cValidationCases, m_cTargetStates, cVectorLength, m_bSinglePrecision));
+         cBytesCaseArrays = AddSaturate(cBytesCaseArrays, MultiplySaturate(sizeof(FractionalDataType), GetValidationCaseLossesCount(cValidationCases)));
+      }
+
+      const size_t cBytesHistogramBuffers = m_bRegression ? EstimateHistogramBufferBytes<true>(cTrainingCases) : EstimateHistogramBufferBytes<false>(cTrainingCases);
+
+      // our current and best models are expanded to the full tensor of every attribute combination when we allocate them.  Our model update scratch space
+      // has k_cDimensionsMax dimensions and grows to fit the largest values and divisions that any attribute combination needs
+      size_t cBytesModel = 0;
+      size_t cValuesMax = 0;
+      size_t acDivisionsMax[k_cDimensionsMax] = { 0 };
+      for(size_t iAttributeCombination = 0; iAttributeCombination < m_cAttributeCombinations; ++iAttributeCombination) {
+         const AttributeCombinationCore * const pAttributeCombination = m_apAttributeCombinations[iAttributeCombination];
+         const size_t cDimensions = pAttributeCombination->m_cAttributes;
+         size_t acDivisions[k_cDimensionsMax];
+         size_t cValues = cVectorLength;
+         for(size_t iDimension = 0; iDimension < cDimensions; ++iDimension) {
+            const size_t cStates = pAttributeCombination->m_AttributeCombinationEntry[iDimension].m_pAttribute->m_cStates;
+            acDivisions[iDimension] = cStates - 1;
+            acDivisionsMax[iDimension] = acDivisionsMax[iDimension] < cStates - 1 ? cStates - 1 : acDivisionsMax[iDimension];
+            cValues = MultiplySaturate(cValues, cStates);
          }
+         cValuesMax = cValuesMax < cValues ? cValues : cValuesMax;
+         cBytesModel = AddSaturate(cBytesModel, SegmentedRegionCore<ActiveDataType, FractionalDataType>::GetGrownMemoryBytes(cDimensions, cVectorLength, cValues, cDimensions, acDivisions));
+      }
+      size_t cBytesModels = 0;
+      if(0 != m_cAttributeCombinations && (m_bRegression || 2 <= m_cTargetStates)) {
+         cBytesModels = MultiplySaturate(AddSaturate(cBytesModel, sizeof(SegmentedRegionCore<ActiveDataType, FractionalDataType> *) * m_cAttributeCombinations), 2);
+      }
+      const size_t cBytesModelUpdate = SegmentedRegionCore<ActiveDataType, FractionalDataType>::GetGrownMemoryBytes(k_cDimensionsMax, cVectorLength, cValuesMax, k_cDimensionsMax, acDivisionsMax);
+      // one for the accumulated update and one for each sampling set
+      cBytesModels = AddSaturate(cBytesModels, MultiplySaturate(cBytesModelUpdate, m_trainingThreadState.m_cSamplingSetScratches + 1));
 
-         LOG(TraceLevelInfo, "EbmTrainingState::Initialize starting attribute processing");
-         if(0 != m_cAttributes) {
-            EBM_ASSERT(!IsMultiplyError(m_cAttributes, sizeof(*aAttributes))); // if this overflows then our caller should not have been able to allocate the array
-            const EbmAttribute * pAttributeInitialize = aAttributes;
-            const EbmAttribute * const pAttributeEnd = &aAttributes[m_cAttributes];
-            EBM_ASSERT(pAttributeInitialize < pAttributeEnd);
-            size_t iAttributeInitialize = 0;
-            do {
-               static_assert(AttributeTypeCore::OrdinalCore == static_cast<AttributeTypeCore>(AttributeTypeOrdinal), "AttributeTypeCore::OrdinalCore must have the same value as AttributeTypeOrdinal");
-               static_assert(AttributeTypeCore::NominalCore == static_cast<AttributeTypeCore>(AttributeTypeNominal), "AttributeTypeCore::NominalCore must have the same value as AttributeTypeNominal");
-               EBM_ASSERT(AttributeTypeOrdinal == pAttributeInitialize->attributeType || AttributeTypeNominal == pAttributeInitialize->attributeType);
-               AttributeTypeCore attributeTypeCore = static_cast<AttributeTypeCore>(pAttributeInitialize->attributeType);
-
-               IntegerDataType countStates = pAttributeInitialize->countStates;
-               EBM_ASSERT(1 <= countStates); // we can handle 1 == cStates even though that's a degenerate case that shouldn't be trained on (dimensions with 1 state don't contribute anything since they always have the same value)
-               if(!IsNumberConvertable<size_t, IntegerDataType>(countStates)) {
-                  LOG(TraceLevelWarning, "WARNING EbmTrainingState::Initialize !IsNumberConvertable<size_t, IntegerDataType>(countStates)");
-                  return true;
-               }
-               size_t cStates = static_cast<size_t>(countStates);
-               if(1 == cStates) {
-                  LOG(TraceLevelError, "ERROR EbmTrainingState::Initialize Our higher level caller should filter out features with a single state since these provide no useful information");
-               }
+      const size_t cBytesCurrent = SetMemoryUsage(pMemoryUsage, cBytesInputData, cBytesCaseArrays, cBytesSamplingSets, cBytesHistogramBuffers, cBytesModels, GetOtherBytes(), 0);
+      UNUSED(cBytesCurrent);
+   }
 
-               EBM_ASSERT(0 == pAttributeInitialize->hasMissing || 1 == pAttributeInitialize->hasMissing);
-               bool bMissing = 0 != pAttributeInitialize->hasMissing;
+   // unpacks our attributes and attribute combinations.  This is the part of Initialize that doesn't depend on the data, so EstimateTrainingMemory uses it on
+   // its own to get the attribute combinations that size everything else
+   bool InitializeAttributes(const EbmAttribute * const aAttributes, const EbmAttributeCombination * const aAttributeCombinations, const IntegerDataType * attributeCombinationIndexes) {
+      if(m_trainingThreadState.IsError()) {
+         LOG(TraceLevelWarning, "WARNING EbmTrainingState::InitializeAttributes m_trainingThreadState.IsError()");
+         return true;
+      }
 
-               // this is an in-place new, so there is no new memory allocated, and we already knew where it was going, so we don't need the resulting pointer returned
-               new (&m_aAttributes[iAttributeInitialize]) AttributeInternalCore(cStates, iAttributeInitialize, attributeTypeCore, bMissing);
-               // we don't allocate memory and our constructor doesn't have errors, so we shouldn't have an error here
+      if(0 != m_cAttributes && nullptr == m_aAttributes) {
+         LOG(TraceLevelWarning, "WARNING EbmTrainingState::InitializeAttributes 0 != m_cAttributes && nullptr == m_aAttributes");
+         return true;
+      }
 
-               EBM_ASSERT(0 == pAttributeInitialize->hasMissing); // TODO : implement this, then remove this assert
-               EBM_ASSERT(AttributeTypeOrdinal == pAttributeInitialize->attributeType); // TODO : implement this, then remove this assert
+      if(UNLIKELY(0 != m_cAttributeCombinations && nullptr == m_apAttributeCombinations)) {
+         LOG(TraceLevelWarning, "WARNING EbmTrainingState::InitializeAttributes 0 != m_cAttributeCombinations && nullptr == m_apAttributeCombinations");
+         return true;
+      }
 
-               ++iAttributeInitialize;
-               ++pAttributeInitialize;
-            } while(pAttributeEnd != pAttributeInitialize);
-         }
-         LOG(TraceLevelInfo, "EbmTrainingState::Initialize done attribute processing");
-
-         LOG(TraceLevelInfo, "EbmTrainingState::Initialize starting attribute combination processing");
-         if(0 != m_cAttributeCombinations) {
-            const IntegerDataType * pAttributeCombinationIndex = attributeCombinationIndexes;
-            size_t iAttributeCombination = 0;
-            do {
-               const EbmAttributeCombination * const pAttributeCombinationInterop = &aAttributeCombinations[iAttributeCombination];
-
-               IntegerDataType countAttributesInCombination = pAttributeCombinationInterop->countAttributesInCombination;
-               EBM_ASSERT(0 <= countAttributesInCombination);
-               if(!IsNumberConvertable<size_t, IntegerDataType>(countAttributesInCombination)) {
-                  LOG(TraceLevelWarning, "WARNING EbmTrainingState::Initialize !IsNumberConvertable<size_t, IntegerDataType>(countAttributesInCombination)");
-                  return true;
-               }
-               size_t cAttributesInCombination = static_cast<size_t>(countAttributesInCombination);
-               EBM_ASSERT(cAttributesInCombination <= m_cAttributes); // we don't allow duplicates, so we can't have more attributes in an attribute combination than we have attributes.
-               size_t cSignificantAttributesInCombination = 0;
-               const IntegerDataType * const pAttributeCombinationIndexEnd = pAttributeCombinationIndex + cAttributesInCombination;
-               if(UNLIKELY(0 == cAttributesInCombination)) {
-                  LOG(TraceLevelError, "ERROR EbmTrainingState::Initialize Our higher level caller should filter out AttributeCombinations with zero attributes since these provide no useful information for training");
-               } else {
-                  assert(nullptr != attributeCombinationIndexes);
-                  const IntegerDataType * pAttributeCombinationIndexTemp = pAttributeCombinationIndex;
-                  do {
-                     const IntegerDataType indexAttributeInterop = *pAttributeCombinationIndexTemp;
-                     EBM_ASSERT(0 <= indexAttributeInterop);
-                     if(!IsNumberConvertable<size_t, IntegerDataType>(indexAttributeInterop)) {
-                        LOG(TraceLevelWarning, "WARNING EbmTrainingState::Initialize !IsNumberConvertable<size_t, IntegerDataType>(indexAttributeInterop)");
-                        return true;
-                     }
-                     const size_t iAttributeForCombination = static_cast<size_t>(indexAttributeInterop);
-                     EBM_ASSERT(iAttributeForCombination < m_cAttributes);
-                     AttributeInternalCore * const pInputAttribute = &m_aAttributes[iAttributeForCombination];
-                     if(LIKELY(1 != pInputAttribute->m_cStates)) {
-                        // if we have only 1 state, then we can eliminate the attribute from consideration since the resulting tensor loses one dimension but is otherwise indistinquishable from the original data
-                        ++cSignificantAttributesInCombination;
-                     } else {
-                        LOG(TraceLevelError, "ERROR EbmTrainingState::Initialize Our higher level caller should filter out AttributeCombination features with a single state since these provide no useful information");
-                     }
-                     ++pAttributeCombinationIndexTemp;
-                  } while(pAttributeCombinationIndexEnd != pAttributeCombinationIndexTemp);
+      LOG(TraceLevelInfo, "EbmTrainingState::InitializeAttributes starting attribute processing");
+      if(0 != m_cAttributes) {
+         EBM_ASSERT(!IsMultiplyError(m_cAttributes, sizeof(*aAttributes))); // if this overflows then our caller should not have been able to allocate the array
+         const EbmAttribute * pAttributeInitialize = aAttributes;
+         const EbmAttribute * const pAttributeEnd = &aAttributes[m_cAttributes];
+         EBM_ASSERT(pAttributeInitialize < pAttributeEnd);
+         size_t iAttributeInitialize = 0;
+         do {
+            static_assert(AttributeTypeCore::OrdinalCore == static_cast<AttributeTypeCore>(AttributeTypeOrdinal), "AttributeTypeCore::OrdinalCore must have the same value as AttributeTypeOrdinal");
+            static_assert(AttributeTypeCore::NominalCore == static_cast<AttributeTypeCore>(AttributeTypeNominal), "AttributeTypeCore::NominalCore must have the same value as AttributeTypeNominal");
+            EBM_ASSERT(AttributeTypeOrdinal == pAttributeInitialize->attributeType || AttributeTypeNominal == pAttributeInitialize->attributeType);
+            AttributeTypeCore attributeTypeCore = static_cast<AttributeTypeCore>(pAttributeInitialize->attributeType);
+
+            IntegerDataType countStates = pAttributeInitialize->countStates;
+            EBM_ASSERT(1 <= countStates); // we can handle 1 == cStates even though that's a degenerate case that shouldn't be trained on (dimensions with 1 state don't contribute anything since they always have the same value)
+            if(!IsNumberConvertable<size_t, IntegerDataType>(countStates)) {
+               LOG(TraceLevelWarning, "WARNING EbmTrainingState::InitializeAttributes !IsNumberConvertable<size_t, IntegerDataType>(countStates)");
+               return true;
+            }
+            size_t cStates = static_cast<size_t>(countStates);
+            if(1 == cStates) {
+               LOG(TraceLevelError, "ERROR EbmTrainingState::InitializeAttributes Our higher level caller should filter out features with a single state since these provide no useful information");
+            }
 
-                  // TODO : we can allow more dimensions, if some of the dimensions have only 1 state
-                  if(k_cDimensionsMax < cSignificantAttributesInCombination) {
-                     // if we try to run with more than k_cDimensionsMax we'll exceed our memory capacity, so let's exit here instead
-                     LOG(TraceLevelWarning, "WARNING EbmTrainingState::Initialize k_cDimensionsMax < cSignificantAttributesInCombination");
+            EBM_ASSERT(0 == pAttributeInitialize->hasMissing || 1 == pAttributeInitialize->hasMissing);
+            bool bMissing = 0 != pAttributeInitialize->hasMissing;
+
+            // this is an in-place new, so there is no new memory allocated, and we already knew where it was going, so we don't need the resulting pointer returned
+            new (&m_aAttributes[iAttributeInitialize]) AttributeInternalCore(cStates, iAttributeInitialize, attributeTypeCore, bMissing);
+            // we don't allocate memory and our constructor doesn't have errors, so we shouldn't have an error here
+
+            EBM_ASSERT(0 == pAttributeInitialize->hasMissing); // TODO : implement this, then remove this assert
+            EBM_ASSERT(AttributeTypeOrdinal == pAttributeInitialize->attributeType); // TODO : implement this, then remove this assert
+
+            ++iAttributeInitialize;
+            ++pAttributeInitialize;
+         } while(pAttributeEnd != pAttributeInitialize);
+      }
+      LOG(TraceLevelInfo, "EbmTrainingState::InitializeAttributes done attribute processing");
+
+      LOG(TraceLevelInfo, "EbmTrainingState::InitializeAttributes starting attribute combination processing");
+      if(0 != m_cAttributeCombinations) {
+         const IntegerDataType * pAttributeCombinationIndex = attributeCombinationIndexes;
+         size_t iAttributeCombination = 0;
+         do {
+            const EbmAttributeCombination * const pAttributeCombinationInterop = &aAttributeCombinations[iAttributeCombination];
+
+            IntegerDataType countAttributesInCombination = pAttributeCombinationInterop->countAttributesInCombination;
+            EBM_ASSERT(0 <= countAttributesInCombination);
+            if(!IsNumberConvertable<size_t, IntegerDataType>(countAttributesInCombination)) {
+               LOG(TraceLevelWarning, "WARNING EbmTrainingState::InitializeAttributes !IsNumberConvertable<size_t, IntegerDataType>(countAttributesInCombination)");
+               return true;
+            }
+            size_t cAttributesInCombination = static_cast<size_t>(countAttributesInCombination);
+            EBM_ASSERT(cAttributesInCombination <= m_cAttributes); // we don't allow duplicates, so we can't have more attributes in an attribute combination than we have attributes.
+            size_t cSignificantAttributesInCombination = 0;
+            const IntegerDataType * const pAttributeCombinationIndexEnd = pAttributeCombinationIndex + cAttributesInCombination;
+            if(UNLIKELY(0 == cAttributesInCombination)) {
+               LOG(TraceLevelError, "ERROR EbmTrainingState::InitializeAttributes Our higher level caller should filter out AttributeCombinations with zero attributes since these provide no useful information for training");
+            } else {
+               assert(nullptr != attributeCombinationIndexes);
+               const IntegerDataType * pAttributeCombinationIndexTemp = pAttributeCombinationIndex;
+               do {
+                  const IntegerDataType indexAttributeInterop = *pAttributeCombinationIndexTemp;
+                  EBM_ASSERT(0 <= indexAttributeInterop);
+                  if(!IsNumberConvertable<size_t, IntegerDataType>(indexAttributeInterop)) {
+                     LOG(TraceLevelWarning, "WARNING EbmTrainingState::InitializeAttributes !IsNumberConvertable<size_t, IntegerDataType>(indexAttributeInterop)");
                      return true;
                   }
-               }
+                  const size_t iAttributeForCombination = static_cast<size_t>(indexAttributeInterop);
+                  EBM_ASSERT(iAttributeForCombination < m_cAttributes);
+                  AttributeInternalCore * const pInputAttribute = &m_aAttributes[iAttributeForCombination];
+                  if(LIKELY(1 != pInputAttribute->m_cStates)) {
+                     // if we have only 1 state, then we can eliminate the attribute from consideration since the resulting tensor loses one dimension but is otherwise indistinquishable from the original data
+                     ++cSignificantAttributesInCombination;
+                  } else {
+                     LOG(TraceLevelError, "ERROR EbmTrainingState::InitializeAttributes Our higher level caller should filter out AttributeCombination features with a single state since these provide no useful information");
+                  }
+                  ++pAttributeCombinationIndexTemp;
+               } while(pAttributeCombinationIndexEnd != pAttributeCombinationIndexTemp);
 
-               AttributeCombinationCore * pAttributeCombination = AttributeCombinationCore::Allocate(cSignificantAttributesInCombination, iAttributeCombination);
-               if(nullptr == pAttributeCombination) {
-                  LOG(TraceLevelWarning, "WARNING EbmTrainingState::Initialize nullptr == pAttributeCombination");
+               // TODO : we can allow more dimensions, if some of the dimensions have only 1 state
+               if(k_cDimensionsMax < cSignificantAttributesInCombination) {
+                  // if we try to run with more than k_cDimensionsMax we'll exceed our memory capacity, so let's exit here instead
+                  LOG(TraceLevelWarning, "WARNING EbmTrainingState::InitializeAttributes k_cDimensionsMax < cSignificantAttributesInCombination");
                   return true;
                }
-               // assign our pointer directly to our array right now so that we can't loose the memory if we decide to exit due to an error below
-               m_apAttributeCombinations[iAttributeCombination] = pAttributeCombination;
-
-               if(LIKELY(0 == cSignificantAttributesInCombination)) {
-                  // move our index forward to the next attribute.  
-                  // We won't be executing the loop below that would otherwise increment it by the number of attributes in this attribute combination
-                  pAttributeCombinationIndex = pAttributeCombinationIndexEnd;
-               } else {
-                  assert(nullptr != attributeCombinationIndexes);
-                  size_t cTensorStates = 1;
-                  AttributeCombinationCore::AttributeCombinationEntry * pAttributeCombinationEntry = &pAttributeCombination->m_AttributeCombinationEntry[0];
-                  do {
-                     const IntegerDataType indexAttributeInterop = *pAttributeCombinationIndex;
-                     EBM_ASSERT(0 <= indexAttributeInterop);
-                     EBM_ASSERT((IsNumberConvertable<size_t, IntegerDataType>(indexAttributeInterop))); // this was checked above
-                     const size_t iAttributeForCombination = static_cast<size_t>(indexAttributeInterop);
-                     EBM_ASSERT(iAttributeForCombination < m_cAttributes);
-                     const AttributeInternalCore * const pInputAttribute = &m_aAttributes[iAttributeForCombination];
-                     const size_t cStates = pInputAttribute->m_cStates;
-                     if(LIKELY(1 != cStates)) {
-                        // if we have only 1 state, then we can eliminate the attribute from consideration since the resulting tensor loses one dimension but is otherwise indistinquishable from the original data
-                        pAttributeCombinationEntry->m_pAttribute = pInputAttribute;
-                        ++pAttributeCombinationEntry;
-                        if(IsMultiplyError(cTensorStates, cStates)) {
-                           // if this overflows, we definetly won't be able to allocate it
-                           LOG(TraceLevelWarning, "WARNING EbmTrainingState::Initialize IsMultiplyError(cTensorStates, cStates)");
-                           return true;
-                        }
-                        cTensorStates *= cStates;
+            }
+
+            AttributeCombinationCore * pAttributeCombination = AttributeCombinationCore::Allocate(cSignificantAttributesInCombination, iAttributeCombination);
+            if(nullptr == pAttributeCombination) {
+               LOG(TraceLevelWarning, "WARNING EbmTrainingState::InitializeAttributes nullptr == pAttributeCombination");
+               return true;
+            }
+            // assign our pointer directly to our array right now so that we can't loose the memory if we decide to exit due to an error below
+            m_apAttributeCombinations[iAttributeCombination] = pAttributeCombination;
+
+            if(LIKELY(0 == cSignificantAttributesInCombination)) {
+               // move our index forward to the next attribute.  
+               // We won't be executing the loop below that would otherwise increment it by the number of attributes in this attribute combination
+               pAttributeCombinationIndex = pAttributeCombinationIndexEnd;
+            } else {
+               assert(nullptr != attributeCombinationIndexes);
+               size_t cTensorStates = 1;
+               AttributeCombinationCore::AttributeCombinationEntry * pAttributeCombinationEntry = &pAttributeCombination->m_AttributeCombinationEntry[0];
+               do {
+                  const IntegerDataType indexAttributeInterop = *pAttributeCombinationIndex;
+                  EBM_ASSERT(0 <= indexAttributeInterop);
+                  EBM_ASSERT((IsNumberConvertable<size_t, IntegerDataType>(indexAttributeInterop))); // this was checked above
+                  const size_t iAttributeForCombination = static_cast<size_t>(indexAttributeInterop);
+                  EBM_ASSERT(iAttributeForCombination < m_cAttributes);
+                  const AttributeInternalCore * const pInputAttribute = &m_aAttributes[iAttributeForCombination];
+                  const size_t cStates = pInputAttribute->m_cStates;
+                  if(LIKELY(1 != cStates)) {
+                     // if we have only 1 state, then we can eliminate the attribute from consideration since the resulting tensor loses one dimension but is otherwise indistinquishable from the original data
+                     pAttributeCombinationEntry->m_pAttribute = pInputAttribute;
+                     ++pAttributeCombinationEntry;
+                     if(IsMultiplyError(cTensorStates, cStates)) {
+                        // if this overflows, we definetly won't be able to allocate it
+                        LOG(TraceLevelWarning, "WARNING EbmTrainingState::InitializeAttributes IsMultiplyError(cTensorStates, cStates)");
+                        return true;
                      }
-                     ++pAttributeCombinationIndex;
-                  } while(pAttributeCombinationIndexEnd != pAttributeCombinationIndex);
-                  // if cSignificantAttributesInCombination is zero, don't both initializing pAttributeCombination->m_cItemsPerBitPackDataUnit
-                  const size_t cBitsRequiredMin = CountBitsRequiredCore(cTensorStates - 1);
-                  pAttributeCombination->m_cItemsPerBitPackDataUnit = GetCountItemsBitPacked(cBitsRequiredMin);
-               }
-               ++iAttributeCombination;
-            } while(iAttributeCombination < m_cAttributeCombinations);
+                     cTensorStates *= cStates;
+                  }
+                  ++pAttributeCombinationIndex;
+               } while(pAttributeCombinationIndexEnd != pAttributeCombinationIndex);
+               // if cSignificantAttributesInCombination is zero, don't both initializing pAttributeCombination->m_cItemsPerBitPackDataUnit
+               const size_t cBitsRequiredMin = CountBitsRequiredCore(cTensorStates - 1);
+               pAttributeCombination->m_cItemsPerBitPackDataUnit = GetCountItemsBitPacked(cBitsRequiredMin);
+            }
+            ++iAttributeCombination;
+         } while(iAttributeCombination < m_cAttributeCombinations);
+      }
+      LOG(TraceLevelInfo, "EbmTrainingState::InitializeAttributes finished attribute combination processing");
+      return false;
+   }
+
+   bool Initialize(const IntegerDataType randomSeed, const EbmAttribute * const aAttributes, const EbmAttributeCombination * const aAttributeCombinations, const IntegerDataType * attributeCombinationIndexes, const size_t cTrainingCases, const void * const aTrainingTargets, const EbmDataColumn * const aTrainingData, const FractionalDataType * const aTrainingPredictionScores, const size_t cValidationCases, const void * const aValidationTargets, const EbmDataColumn * const aValidationData, const FractionalDataType * const aValidationPredictionScores) {
+      LOG(TraceLevelInfo, "Entered EbmTrainingState::Initialize");
+      try {
+         if(InitializeAttributes(aAttributes, aAttributeCombinations, attributeCombinationIndexes)) {
+            LOG(TraceLevelWarning, "WARNING EbmTrainingState::Initialize InitializeAttributes");
+            return true;
          }
-         LOG(TraceLevelInfo, "EbmTrainingState::Initialize finished attribute combination processing");
 
          size_t cVectorLength = GetVectorLengthFlatCore(m_cTargetStates);
 
          LOG(TraceLevelInfo, "Entered DataSetAttributeCombination for m_pTrainingSet");
          if(0 != cTrainingCases) {
-            m_pTrainingSet = new (std::nothrow) DataSetAttributeCombination(true, !m_bRegression, !m_bRegression, m_cAttributeCombinations, m_apAttributeCombinations, cTrainingCases, aTrainingData, aTrainingTargets, aTrainingPredictionScores, cVectorLength);
+            m_pTrainingSet = new (std::nothrow) DataSetAttributeCombination(true, !m_bRegression, !m_bRegression, m_cAttributeCombinations, m_apAttributeCombinations, cTrainingCases, aTrainingData, aTrainingTargets, m_cTargetStates, aTrainingPredictionScores, cVectorLength, m_bSinglePrecision, m_arenaBacking);
             if(nullptr == m_pTrainingSet || m_pTrainingSet->IsError()) {
                LOG(TraceLevelWarning, "WARNING EbmTrainingState::Initialize nullptr == m_pTrainingSet || m_pTrainingSet->IsError()");
                return true;
@@ -870,11 +1375,17 @@ public:
 
          LOG(TraceLevelInfo, "Entered DataSetAttributeCombination for m_pValidationSet");
          if(0 != cValidationCases) {
-            m_pValidationSet = new (std::nothrow) DataSetAttributeCombination(m_bRegression, !m_bRegression, !m_bRegression, m_cAttributeCombinations, m_apAttributeCombinations, cValidationCases, aValidationData, aValidationTargets, aValidationPredictionScores, cVectorLength);
+            m_pValidationSet = new (std::nothrow) DataSetAttributeCombination(m_bRegression, !m_bRegression, !m_bRegression, m_cAttributeCombinations, m_apAttributeCombinations, cValidationCases, aValidationData, aValidationTargets, m_cTargetStates, aValidationPredictionScores, cVectorLength, m_bSinglePrecision, m_arenaBacking);
             if(nullptr == m_pValidationSet || m_pValidationSet->IsError()) {
                LOG(TraceLevelWarning, "WARNING EbmTrainingState::Initialize nullptr == m_pValidationSet || m_pValidationSet->IsError()");
                return true;
             }
+            m_cValidationCaseLosses = GetValidationCaseLossesCount(cValidationCases);
+            m_aValidationCaseLosses = new (std::nothrow) FractionalDataType[m_cValidationCaseLosses];
+            if(nullptr == m_aValidationCaseLosses) {
+               LOG(TraceLevelWarning, "WARNING EbmTrainingState::Initialize nullptr == m_aValidationCaseLosses");
+               return true;
+            }
          }
          LOG(TraceLevelInfo, "Exited DataSetAttributeCombination for m_pValidationSet %p", static_cast<void *>(m_pValidationSet));
 
@@ -882,7 +1393,7 @@ public:
 
          EBM_ASSERT(nullptr == m_apSamplingSets);
          if(0 != cTrainingCases) {
-            m_apSamplingSets = SamplingWithReplacement::GenerateSamplingSets(&randomStream, m_pTrainingSet, m_cSamplingSets);
+            m_apSamplingSets = SamplingMethod::GenerateSamplingSets(&randomStream, m_pTrainingSet, m_cAttributeCombinations, m_apAttributeCombinations, m_cSamplingSets, m_bSamplingWithoutReplacement);
             if(UNLIKELY(nullptr == m_apSamplingSets)) {
                LOG(TraceLevelWarning, "WARNING EbmTrainingState::Initialize nullptr == m_apSamplingSets");
                return true;
@@ -904,23 +1415,10 @@ public:
             }
          }
 
-         if(m_bRegression) {
-            if(0 != cTrainingCases) {
-               InitializeResiduals<k_Regression>(cTrainingCases, aTrainingTargets, aTrainingPredictionScores, m_pTrainingSet->GetResidualPointer(), 0);
-            }
-            if(0 != cValidationCases) {
-               InitializeResiduals<k_Regression>(cValidationCases, aValidationTargets, aValidationPredictionScores, m_pValidationSet->GetResidualPointer(), 0);
-            }
+         if(m_bSinglePrecision) {
+            InitializeDataSetResiduals<float>(cTrainingCases, aTrainingTargets, aTrainingPredictionScores, cValidationCases, aValidationTargets, aValidationPredictionScores);
          } else {
-            if(2 == m_cTargetStates) {
-               if(0 != cTrainingCases) {
-                  InitializeResiduals<2>(cTrainingCases, aTrainingTargets, aTrainingPredictionScores, m_pTrainingSet->GetResidualPointer(), m_cTargetStates);
-               }
-            } else {
-               if(0 != cTrainingCases) {
-                  InitializeResiduals<k_DynamicClassification>(cTrainingCases, aTrainingTargets, aTrainingPredictionScores, m_pTrainingSet->GetResidualPointer(), m_cTargetStates);
-               }
-            }
+            InitializeDataSetResiduals<FractionalDataType>(cTrainingCases, aTrainingTargets, aTrainingPredictionScores, cValidationCases, aValidationTargets, aValidationPredictionScores);
          }
          
          LOG(TraceLevelInfo, "Exited EbmTrainingState::Initialize");
@@ -962,12 +1460,29 @@ void CheckTargets(const size_t cTargetStates, const size_t cCases, const void *
       }
    }
 }
-#endif // NDEBUG
+#endif // NDEBUG
+
+constexpr IntegerDataType k_trainingOptionsKnown = TrainingOptionsSinglePrecision | TrainingOptionsSamplingWithoutReplacement | TrainingOptionsHugePages | TrainingOptionsOutOfCore | TrainingOptionsFastMath;
+
+// out of core wins over huge pages, since huge pages only apply to memory that we allocate ourselves
+TML_INLINE static ArenaBackingCore GetArenaBacking(const IntegerDataType trainingOptions) {
+   if(0 != (trainingOptions & TrainingOptionsOutOfCore)) {
+      return ArenaBackingCore::FileCore;
+   }
+   if(0 != (trainingOptions & TrainingOptionsHugePages)) {
+      return ArenaBackingCore::HugePagesCore;
+   }
+   return ArenaBackingCore::MemoryCore;
+}
+
+TML_INLINE static MathBackendCore GetMathBackend(const IntegerDataType trainingOptions) {
+   return 0 != (trainingOptions & TrainingOptionsFastMath) ? MathBackendCore::FastCore : MathBackendCore::ExactCore;
+}
 
 // a*PredictionScores = logOdds for binary classification
 // a*PredictionScores = logWeights for multiclass classification
 // a*PredictionScores = predictedValue for regression
-TmlState * AllocateCore(bool bRegression, IntegerDataType randomSeed, IntegerDataType countAttributes, const EbmAttribute * attributes, IntegerDataType countAttributeCombinations, const EbmAttributeCombination * attributeCombinations, const IntegerDataType * attributeCombinationIndexes, IntegerDataType countTargetStates, IntegerDataType countTrainingCases, const void * trainingTargets, const IntegerDataType * trainingData, const FractionalDataType * trainingPredictionScores, IntegerDataType countValidationCases, const void * validationTargets, const IntegerDataType * validationData, const FractionalDataType * validationPredictionScores, IntegerDataType countInnerBags) {
+TmlState * AllocateCore(bool bRegression, IntegerDataType randomSeed, IntegerDataType countAttributes, const EbmAttribute * attributes, IntegerDataType countAttributeCombinations, const EbmAttributeCombination * attributeCombinations, const IntegerDataType * attributeCombinationIndexes, IntegerDataType countTargetStates, IntegerDataType countTrainingCases, const void * trainingTargets, const EbmDataColumn * trainingData, const FractionalDataType * trainingPredictionScores, IntegerDataType countValidationCases, const void * validationTargets, const EbmDataColumn * validationData, const FractionalDataType * validationPredictionScores, IntegerDataType countInnerBags, IntegerDataType trainingOptions) {
    // randomSeed can be any value
    EBM_ASSERT(0 <= countAttributes);
    EBM_ASSERT(0 == countAttributes || nullptr != attributes);
@@ -1017,6 +1532,20 @@ TmlState * AllocateCore(bool bRegression, IntegerDataType randomSeed, IntegerDat
    size_t cValidationCases = static_cast<size_t>(countValidationCases);
    size_t cInnerBags = static_cast<size_t>(countInnerBags);
 
+   if(IsDataColumnsError(cAttributes, trainingData) || IsDataColumnsError(cAttributes, validationData)) {
+      LOG(TraceLevelWarning, "WARNING AllocateCore IsDataColumnsError(cAttributes, trainingData) || IsDataColumnsError(cAttributes, validationData)");
+      return nullptr;
+   }
+
+   if(0 != (trainingOptions & ~k_trainingOptionsKnown)) {
+      LOG(TraceLevelWarning, "WARNING AllocateCore unknown trainingOptions");
+      return nullptr;
+   }
+   const bool bSinglePrecision = 0 != (trainingOptions & TrainingOptionsSinglePrecision);
+   const bool bSamplingWithoutReplacement = 0 != (trainingOptions & TrainingOptionsSamplingWithoutReplacement);
+   const ArenaBackingCore arenaBacking = GetArenaBacking(trainingOptions);
+   const MathBackendCore mathBackend = GetMathBackend(trainingOptions);
+
    size_t cVectorLength = GetVectorLengthFlatCore(cTargetStates);
 
    if(IsMultiplyError(cVectorLength, cTrainingCases)) {
@@ -1034,7 +1563,7 @@ TmlState * AllocateCore(bool bRegression, IntegerDataType randomSeed, IntegerDat
 #endif // NDEBUG
 
    LOG(TraceLevelInfo, "Entered EbmTrainingState");
-   TmlState * const pTmlState = new (std::nothrow) TmlState(bRegression, cTargetStates, cAttributes, cAttributeCombinations, cInnerBags);
+   TmlState * const pTmlState = new (std::nothrow) TmlState(bRegression, cTargetStates, bSinglePrecision, bSamplingWithoutReplacement, arenaBacking, mathBackend, cAttributes, cAttributeCombinations, cInnerBags);
    LOG(TraceLevelInfo, "Exited EbmTrainingState %p", static_cast<void *>(pTmlState));
    if(UNLIKELY(nullptr == pTmlState)) {
       LOG(TraceLevelWarning, "WARNING AllocateCore nullptr == pTmlState");
@@ -1045,39 +1574,181 @@ TmlState * AllocateCore(bool bRegression, IntegerDataType randomSeed, IntegerDat
       delete pTmlState;
       return nullptr;
    }
+   pTmlState->UpdatePeakMemory();
+   return pTmlState;
+}
+
+// our IntegerDataType matrix APIs are thin wrappers that describe each column of the Fortran ordered matrix with an EbmDataColumn
+static TmlState * AllocateCoreInt64(bool bRegression, IntegerDataType randomSeed, IntegerDataType countAttributes, const EbmAttribute * attributes, IntegerDataType countAttributeCombinations, const EbmAttributeCombination * attributeCombinations, const IntegerDataType * attributeCombinationIndexes, IntegerDataType countTargetStates, IntegerDataType countTrainingCases, const void * trainingTargets, const IntegerDataType * trainingData, const FractionalDataType * trainingPredictionScores, IntegerDataType countValidationCases, const void * validationTargets, const IntegerDataType * validationData, const FractionalDataType * validationPredictionScores, IntegerDataType countInnerBags, IntegerDataType trainingOptions) {
+   if(!IsNumberConvertable<size_t, IntegerDataType>(countAttributes)) {
+      LOG(TraceLevelWarning, "WARNING AllocateCoreInt64 !IsNumberConvertable<size_t, IntegerDataType>(countAttributes)");
+      return nullptr;
+   }
+   if(!IsNumberConvertable<size_t, IntegerDataType>(countTrainingCases)) {
+      LOG(TraceLevelWarning, "WARNING AllocateCoreInt64 !IsNumberConvertable<size_t, IntegerDataType>(countTrainingCases)");
+      return nullptr;
+   }
+   if(!IsNumberConvertable<size_t, IntegerDataType>(countValidationCases)) {
+      LOG(TraceLevelWarning, "WARNING AllocateCoreInt64 !IsNumberConvertable<size_t, IntegerDataType>(countValidationCases)");
+      return nullptr;
+   }
+   const size_t cAttributes = static_cast<size_t>(countAttributes);
+
+   EbmDataColumn * const aTrainingColumns = ConstructInt64DataColumns(cAttributes, static_cast<size_t>(countTrainingCases), trainingData);
+   EbmDataColumn * const aValidationColumns = ConstructInt64DataColumns(cAttributes, static_cast<size_t>(countValidationCases), validationData);
+   TmlState * pTmlState = nullptr;
+   if(0 != cAttributes && (nullptr != trainingData && nullptr == aTrainingColumns || nullptr != validationData && nullptr == aValidationColumns)) {
+      LOG(TraceLevelWarning, "WARNING AllocateCoreInt64 ConstructInt64DataColumns failed");
+   } else {
+      pTmlState = AllocateCore(bRegression, randomSeed, countAttributes, attributes, countAttributeCombinations, attributeCombinations, attributeCombinationIndexes, countTargetStates, countTrainingCases, trainingTargets, aTrainingColumns, trainingPredictionScores, countValidationCases, validationTargets, aValidationColumns, validationPredictionScores, countInnerBags, trainingOptions);
+   }
+   free(aTrainingColumns);
+   free(aValidationColumns);
    return pTmlState;
 }
 
 EBMCORE_IMPORT_EXPORT PEbmTraining EBMCORE_CALLING_CONVENTION InitializeTrainingRegression(IntegerDataType randomSeed, IntegerDataType countAttributes, const EbmAttribute * attributes, IntegerDataType countAttributeCombinations, const EbmAttributeCombination * attributeCombinations, const IntegerDataType * attributeCombinationIndexes, IntegerDataType countTrainingCases, const FractionalDataType * trainingTargets, const IntegerDataType * trainingData, const FractionalDataType * trainingPredictionScores, IntegerDataType countValidationCases, const FractionalDataType * validationTargets, const IntegerDataType * validationData, const FractionalDataType * validationPredictionScores, IntegerDataType countInnerBags) {
    LOG(TraceLevelInfo, "Entered InitializeTrainingRegression: randomSeed=%" IntegerDataTypePrintf ", countAttributes=%" IntegerDataTypePrintf ", attributes=%p, countAttributeCombinations=%" IntegerDataTypePrintf ", attributeCombinations=%p, attributeCombinationIndexes=%p, countTrainingCases=%" IntegerDataTypePrintf ", trainingTargets=%p, trainingData=%p, trainingPredictionScores=%p, countValidationCases=%" IntegerDataTypePrintf ", validationTargets=%p, validationData=%p, validationPredictionScores=%p, countInnerBags=%" IntegerDataTypePrintf, randomSeed, countAttributes, static_cast<const void *>(attributes), countAttributeCombinations, static_cast<const void *>(attributeCombinations), static_cast<const void *>(attributeCombinationIndexes), countTrainingCases, static_cast<const void *>(trainingTargets), static_cast<const void *>(trainingData), static_cast<const void *>(trainingPredictionScores), countValidationCases, static_cast<const void *>(validationTargets), static_cast<const void *>(validationData), static_cast<const void *>(validationPredictionScores), countInnerBags);
-   PEbmTraining pEbmTraining = reinterpret_cast<PEbmTraining>(AllocateCore(true, randomSeed, countAttributes, attributes, countAttributeCombinations, attributeCombinations, attributeCombinationIndexes, 0, countTrainingCases, trainingTargets, trainingData, trainingPredictionScores, countValidationCases, validationTargets, validationData, validationPredictionScores, countInnerBags));
+   PEbmTraining pEbmTraining = reinterpret_cast<PEbmTraining>(AllocateCoreInt64(true, randomSeed, countAttributes, attributes, countAttributeCombinations, attributeCombinations, attributeCombinationIndexes, 0, countTrainingCases, trainingTargets, trainingData, trainingPredictionScores, countValidationCases, validationTargets, validationData, validationPredictionScores, countInnerBags, TrainingOptionsNone));
    LOG(TraceLevelInfo, "Exited InitializeTrainingRegression %p", static_cast<void *>(pEbmTraining));
    return pEbmTraining;
 }
 
+EBMCORE_IMPORT_EXPORT PEbmTraining EBMCORE_CALLING_CONVENTION InitializeTrainingRegressionEx(IntegerDataType randomSeed, IntegerDataType countAttributes, const EbmAttribute * attributes, IntegerDataType countAttributeCombinations, const EbmAttributeCombination * attributeCombinations, const IntegerDataType * attributeCombinationIndexes, IntegerDataType countTrainingCases, const FractionalDataType * trainingTargets, const IntegerDataType * trainingData, const FractionalDataType * trainingPredictionScores, IntegerDataType countValidationCases, const FractionalDataType * validationTargets, const IntegerDataType * validationData, const FractionalDataType * validationPredictionScores, IntegerDataType countInnerBags, IntegerDataType trainingOptions) {
+   LOG(TraceLevelInfo, "Entered InitializeTrainingRegressionEx: randomSeed=%" IntegerDataTypePrintf ", countAttributes=%" IntegerDataTypePrintf ", attributes=%p, countAttributeCombinations=%" IntegerDataTypePrintf ", attributeCombinations=%p, attributeCombinationIndexes=%p, countTrainingCases=%" IntegerDataTypePrintf ", trainingTargets=%p, trainingData=%p, trainingPredictionScores=%p, countValidationCases=%" IntegerDataTypePrintf ", validationTargets=%p, validationData=%p, validationPredictionScores=%p, countInnerBags=%" IntegerDataTypePrintf ", trainingOptions=%" IntegerDataTypePrintf, randomSeed, countAttributes, static_cast<const void *>(attributes), countAttributeCombinations, static_cast<const void *>(attributeCombinations), static_cast<const void *>(attributeCombinationIndexes), countTrainingCases, static_cast<const void *>(trainingTargets), static_cast<const void *>(trainingData), static_cast<const void *>(trainingPredictionScores), countValidationCases, static_cast<const void *>(validationTargets), static_cast<const void *>(validationData), static_cast<const void *>(validationPredictionScores), countInnerBags, trainingOptions);
+   PEbmTraining pEbmTraining = reinterpret_cast<PEbmTraining>(AllocateCoreInt64(true, randomSeed, countAttributes, attributes, countAttributeCombinations, attributeCombinations, attributeCombinationIndexes, 0, countTrainingCases, trainingTargets, trainingData, trainingPredictionScores, countValidationCases, validationTargets, validationData, validationPredictionScores, countInnerBags, trainingOptions));
+   LOG(TraceLevelInfo, "Exited InitializeTrainingRegressionEx %p", static_cast<void *>(pEbmTraining));
+   return pEbmTraining;
+}
+
+EBMCORE_IMPORT_EXPORT PEbmTraining EBMCORE_CALLING_CONVENTION InitializeTrainingRegressionColumns(IntegerDataType randomSeed, IntegerDataType countAttributes, const EbmAttribute * attributes, IntegerDataType countAttributeCombinations, const EbmAttributeCombination * attributeCombinations, const IntegerDataType * attributeCombinationIndexes, IntegerDataType countTrainingCases, const FractionalDataType * trainingTargets, const EbmDataColumn * trainingColumns, const FractionalDataType * trainingPredictionScores, IntegerDataType countValidationCases, const FractionalDataType * validationTargets, const EbmDataColumn * validationColumns, const FractionalDataType * validationPredictionScores, IntegerDataType countInnerBags, IntegerDataType trainingOptions) {
+   LOG(TraceLevelInfo, "Entered InitializeTrainingRegressionColumns: randomSeed=%" IntegerDataTypePrintf ", countAttributes=%" IntegerDataTypePrintf ", attributes=%p, countAttributeCombinations=%" IntegerDataTypePrintf ", attributeCombinations=%p, attributeCombinationIndexes=%p, countTrainingCases=%" IntegerDataTypePrintf ", trainingTargets=%p, trainingColumns=%p, trainingPredictionScores=%p, countValidationCases=%" IntegerDataTypePrintf ", validationTargets=%p, validationColumns=%p, validationPredictionScores=%p, countInnerBags=%" IntegerDataTypePrintf ", trainingOptions=%" IntegerDataTypePrintf, randomSeed, countAttributes, static_cast<const void *>(attributes), countAttributeCombinations, static_cast<const void *>(attributeCombinations), static_cast<const void *>(attributeCombinationIndexes), countTrainingCases, static_cast<const void *>(trainingTargets), static_cast<const void *>(trainingColumns), static_cast<const void *>(trainingPredictionScores), countValidationCases, static_cast<const void *>(validationTargets), static_cast<const void *>(validationColumns), static_cast<const void *>(validationPredictionScores), countInnerBags, trainingOptions);
+   PEbmTraining pEbmTraining = reinterpret_cast<PEbmTraining>(AllocateCore(true, randomSeed, countAttributes, attributes, countAttributeCombinations, attributeCombinations, attributeCombinationIndexes, 0, countTrainingCases, trainingTargets, trainingColumns, trainingPredictionScores, countValidationCases, validationTargets, validationColumns, validationPredictionScores, countInnerBags, trainingOptions));
+   LOG(TraceLevelInfo, "Exited InitializeTrainingRegressionColumns %p", static_cast<void *>(pEbmTraining));
+   return pEbmTraining;
+}
+
 EBMCORE_IMPORT_EXPORT PEbmTraining EBMCORE_CALLING_CONVENTION InitializeTrainingClassification(IntegerDataType randomSeed, IntegerDataType countAttributes, const EbmAttribute * attributes, IntegerDataType countAttributeCombinations, const EbmAttributeCombination * attributeCombinations, const IntegerDataType * attributeCombinationIndexes, IntegerDataType countTargetStates, IntegerDataType countTrainingCases, const IntegerDataType * trainingTargets, const IntegerDataType * trainingData, const FractionalDataType * trainingPredictionScores, IntegerDataType countValidationCases, const IntegerDataType * validationTargets, const IntegerDataType * validationData, const FractionalDataType * validationPredictionScores, IntegerDataType countInnerBags) {
    LOG(TraceLevelInfo, "Entered InitializeTrainingClassification: randomSeed=%" IntegerDataTypePrintf ", countAttributes=%" IntegerDataTypePrintf ", attributes=%p, countAttributeCombinations=%" IntegerDataTypePrintf ", attributeCombinations=%p, attributeCombinationIndexes=%p, countTargetStates=%" IntegerDataTypePrintf ", countTrainingCases=%" IntegerDataTypePrintf ", trainingTargets=%p, trainingData=%p, trainingPredictionScores=%p, countValidationCases=%" IntegerDataTypePrintf ", validationTargets=%p, validationData=%p, validationPredictionScores=%p, countInnerBags=%" IntegerDataTypePrintf, randomSeed, countAttributes, static_cast<const void *>(attributes), countAttributeCombinations, static_cast<const void *>(attributeCombinations), static_cast<const void *>(attributeCombinationIndexes), countTargetStates, countTrainingCases, static_cast<const void *>(trainingTargets), static_cast<const void *>(trainingData), static_cast<const void *>(trainingPredictionScores), countValidationCases, static_cast<const void *>(validationTargets), static_cast<const void *>(validationData), static_cast<const void *>(validationPredictionScores), countInnerBags);
-   PEbmTraining pEbmTraining = reinterpret_cast<PEbmTraining>(AllocateCore(false, randomSeed, countAttributes, attributes, countAttributeCombinations, attributeCombinations, attributeCombinationIndexes, countTargetStates, countTrainingCases, trainingTargets, trainingData, trainingPredictionScores, countValidationCases, validationTargets, validationData, validationPredictionScores, countInnerBags));
+   PEbmTraining pEbmTraining = reinterpret_cast<PEbmTraining>(AllocateCoreInt64(false, randomSeed, countAttributes, attributes, countAttributeCombinations, attributeCombinations, attributeCombinationIndexes, countTargetStates, countTrainingCases, trainingTargets, trainingData, trainingPredictionScores, countValidationCases, validationTargets, validationData, validationPredictionScores, countInnerBags, TrainingOptionsNone));
    LOG(TraceLevelInfo, "Exited InitializeTrainingClassification %p", static_cast<void *>(pEbmTraining));
    return pEbmTraining;
 }
 
+EBMCORE_IMPORT_EXPORT PEbmTraining EBMCORE_CALLING_CONVENTION InitializeTrainingClassificationEx(IntegerDataType randomSeed, IntegerDataType countAttributes, const EbmAttribute * attributes, IntegerDataType countAttributeCombinations, const EbmAttributeCombination * attributeCombinations, const IntegerDataType * attributeCombinationIndexes, IntegerDataType countTargetStates, IntegerDataType countTrainingCases, const IntegerDataType * trainingTargets, const IntegerDataType * trainingData, const FractionalDataType * trainingPredictionScores, IntegerDataType countValidationCases, const IntegerDataType * validationTargets, const IntegerDataType * validationData, const FractionalDataType * validationPredictionScores, IntegerDataType countInnerBags, IntegerDataType trainingOptions) {
+   LOG(TraceLevelInfo, "Entered InitializeTrainingClassificationEx: randomSeed=%" IntegerDataTypePrintf ", countAttributes=%" IntegerDataTypePrintf ", attributes=%p, countAttributeCombinations=%" IntegerDataTypePrintf ", attributeCombinations=%p, attributeCombinationIndexes=%p, countTargetStates=%" IntegerDataTypePrintf ", countTrainingCases=%" IntegerDataTypePrintf ", trainingTargets=%p, trainingData=%p, trainingPredictionScores=%p, countValidationCases=%" IntegerDataTypePrintf ", validationTargets=%p, validationData=%p, validationPredictionScores=%p, countInnerBags=%" IntegerDataTypePrintf ", trainingOptions=%" IntegerDataTypePrintf, randomSeed, countAttributes, static_cast<const void *>(attributes), countAttributeCombinations, static_cast<const void *>(attributeCombinations), static_cast<const void *>(attributeCombinationIndexes), countTargetStates, countTrainingCases, static_cast<const void *>(trainingTargets), static_cast<const void *>(trainingData), static_cast<const void *>(trainingPredictionScores), countValidationCases, static_cast<const void *>(validationTargets), static_cast<const void *>(validationData), static_cast<const void *>(validationPredictionScores), countInnerBags, trainingOptions);
+   PEbmTraining pEbmTraining = reinterpret_cast<PEbmTraining>(AllocateCoreInt64(false, randomSeed, countAttributes, attributes, countAttributeCombinations, attributeCombinations, attributeCombinationIndexes, countTargetStates, countTrainingCases, trainingTargets, trainingData, trainingPredictionScores, countValidationCases, validationTargets, validationData, validationPredictionScores, countInnerBags, trainingOptions));
+   LOG(TraceLevelInfo, "Exited InitializeTrainingClassificationEx %p", static_cast<void *>(pEbmTraining));
+   return pEbmTraining;
+}
+
+EBMCORE_IMPORT_EXPORT PEbmTraining EBMCORE_CALLING_CONVENTION InitializeTrainingClassificationColumns(IntegerDataType randomSeed, IntegerDataType countAttributes, const EbmAttribute * attributes, IntegerDataType countAttributeCombinations, const EbmAttributeCombination * attributeCombinations, const IntegerDataType * attributeCombinationIndexes, IntegerDataType countTargetStates, IntegerDataType countTrainingCases, const IntegerDataType * trainingTargets, const EbmDataColumn * trainingColumns, const FractionalDataType * trainingPredictionScores, IntegerDataType countValidationCases, const IntegerDataType * validationTargets, const EbmDataColumn * validationColumns, const FractionalDataType * validationPredictionScores, IntegerDataType countInnerBags, IntegerDataType trainingOptions) {
+   LOG(TraceLevelInfo, "Entered InitializeTrainingClassificationColumns: randomSeed=%" IntegerDataTypePrintf ", countAttributes=%" IntegerDataTypePrintf ", attributes=%p, countAttributeCombinations=%" IntegerDataTypePrintf ", attributeCombinations=%p, attributeCombinationIndexes=%p, countTargetStates=%" IntegerDataTypePrintf ", countTrainingCases=%" IntegerDataTypePrintf ", trainingTargets=%p, trainingColumns=%p, trainingPredictionScores=%p, countValidationCases=%" IntegerDataTypePrintf ", validationTargets=%p, validationColumns=%p, validationPredictionScores=%p, countInnerBags=%" IntegerDataTypePrintf ", trainingOptions=%" IntegerDataTypePrintf, randomSeed, countAttributes, static_cast<const void *>(attributes), countAttributeCombinations, static_cast<const void *>(attributeCombinations), static_cast<const void *>(attributeCombinationIndexes), countTargetStates, countTrainingCases, static_cast<const void *>(trainingTargets), static_cast<const void *>(trainingColumns), static_cast<const void *>(trainingPredictionScores), countValidationCases, static_cast<const void *>(validationTargets), static_cast<const void *>(validationColumns), static_cast<const void *>(validationPredictionScores), countInnerBags, trainingOptions);
+   PEbmTraining pEbmTraining = reinterpret_cast<PEbmTraining>(AllocateCore(false, randomSeed, countAttributes, attributes, countAttributeCombinations, attributeCombinations, attributeCombinationIndexes, countTargetStates, countTrainingCases, trainingTargets, trainingColumns, trainingPredictionScores, countValidationCases, validationTargets, validationColumns, validationPredictionScores, countInnerBags, trainingOptions));
+   LOG(TraceLevelInfo, "Exited InitializeTrainingClassificationColumns %p", static_cast<void *>(pEbmTraining));
+   return pEbmTraining;
+}
+
+// training packs its attribute combinations from the shared columns when it is created, so unlike interaction states we don't need to keep a reference
+static TmlState * AllocateCoreFromDataSets(bool bRegression, IntegerDataType randomSeed, IntegerDataType countAttributeCombinations, const EbmAttributeCombination * attributeCombinations, const IntegerDataType * attributeCombinationIndexes, IntegerDataType countTargetStates, const void * trainingTargets, PEbmDataSet trainingDataSet, const FractionalDataType * trainingPredictionScores, const void * validationTargets, PEbmDataSet validationDataSet, const FractionalDataType * validationPredictionScores, IntegerDataType countInnerBags, IntegerDataType trainingOptions) {
+   const DataSetShared * const pTrainingDataSet = reinterpret_cast<const DataSetShared *>(trainingDataSet);
+   const DataSetShared * const pValidationDataSet = reinterpret_cast<const DataSetShared *>(validationDataSet);
+   if(nullptr == pTrainingDataSet || nullptr == pValidationDataSet) {
+      LOG(TraceLevelWarning, "WARNING AllocateCoreFromDataSets nullptr == pTrainingDataSet || nullptr == pValidationDataSet");
+      return nullptr;
+   }
+   const size_t cAttributes = pTrainingDataSet->GetCountAttributes();
+   if(cAttributes != pValidationDataSet->GetCountAttributes() || 0 != cAttributes && 0 != memcmp(pTrainingDataSet->GetAttributes(), pValidationDataSet->GetAttributes(), sizeof(EbmAttribute) * cAttributes)) {
+      LOG(TraceLevelWarning, "WARNING AllocateCoreFromDataSets the training and validation datasets have different attributes");
+      return nullptr;
+   }
+   // the datasets were allocated with these counts, so they fit into an IntegerDataType
+   EBM_ASSERT((IsNumberConvertable<IntegerDataType, size_t>(cAttributes)));
+   EBM_ASSERT((IsNumberConvertable<IntegerDataType, size_t>(pTrainingDataSet->GetCountCases())));
+   EBM_ASSERT((IsNumberConvertable<IntegerDataType, size_t>(pValidationDataSet->GetCountCases())));
+   return AllocateCore(bRegression, randomSeed, static_cast<IntegerDataType>(cAttributes), pTrainingDataSet->GetAttributes(), countAttributeCombinations, attributeCombinations, attributeCombinationIndexes, countTargetStates, static_cast<IntegerDataType>(pTrainingDataSet->GetCountCases()), trainingTargets, pTrainingDataSet->GetColumns(), trainingPredictionScores, static_cast<IntegerDataType>(pValidationDataSet->GetCountCases()), validationTargets, pValidationDataSet->GetColumns(), validationPredictionScores, countInnerBags, trainingOptions);
+}
+
+EBMCORE_IMPORT_EXPORT PEbmTraining EBMCORE_CALLING_CONVENTION InitializeTrainingRegressionFromDataSets(IntegerDataType randomSeed, IntegerDataType countAttributeCombinations, const EbmAttributeCombination * attributeCombinations, const IntegerDataType * attributeCombinationIndexes, const FractionalDataType * trainingTargets, PEbmDataSet trainingDataSet, const FractionalDataType * trainingPredictionScores, const FractionalDataType * validationTargets, PEbmDataSet validationDataSet, const FractionalDataType * validationPredictionScores, IntegerDataType countInnerBags, IntegerDataType trainingOptions) {
+   LOG(TraceLevelInfo, "Entered InitializeTrainingRegressionFromDataSets: randomSeed=%" IntegerDataTypePrintf ", countAttributeCombinations=%" IntegerDataTypePrintf ", attributeCombinations=%p, attributeCombinationIndexes=%p, trainingTargets=%p, trainingDataSet=%p, trainingPredictionScores=%p, validationTargets=%p, validationDataSet=%p, validationPredictionScores=%p, countInnerBags=%" IntegerDataTypePrintf ", trainingOptions=%" IntegerDataTypePrintf, randomSeed, countAttributeCombinations, static_cast<const void *>(attributeCombinations), static_cast<const void *>(attributeCombinationIndexes), static_cast<const void *>(trainingTargets), static_cast<void *>(trainingDataSet), static_cast<const void *>(trainingPredictionScores), static_cast<const void *>(validationTargets), static_cast<void *>(validationDataSet), static_cast<const void *>(validationPredictionScores), countInnerBags, trainingOptions);
+   PEbmTraining pEbmTraining = reinterpret_cast<PEbmTraining>(AllocateCoreFromDataSets(true, randomSeed, countAttributeCombinations, attributeCombinations, attributeCombinationIndexes, 0, trainingTargets, trainingDataSet, trainingPredictionScores, validationTargets, validationDataSet, validationPredictionScores, countInnerBags, trainingOptions));
+   LOG(TraceLevelInfo, "Exited InitializeTrainingRegressionFromDataSets %p", static_cast<void *>(pEbmTraining));
+   return pEbmTraining;
+}
+
+EBMCORE_IMPORT_EXPORT PEbmTraining EBMCORE_CALLING_CONVENTION InitializeTrainingClassificationFromDataSets(IntegerDataType randomSeed, IntegerDataType countAttributeCombinations, const EbmAttributeCombination * attributeCombinations, const IntegerDataType * attributeCombinationIndexes, IntegerDataType countTargetStates, const IntegerDataType * trainingTargets, PEbmDataSet trainingDataSet, const FractionalDataType * trainingPredictionScores, const IntegerDataType * validationTargets, PEbmDataSet validationDataSet, const FractionalDataType * validationPredictionScores, IntegerDataType countInnerBags, IntegerDataType trainingOptions) {
+   LOG(TraceLevelInfo, "Entered InitializeTrainingClassificationFromDataSets: randomSeed=%" IntegerDataTypePrintf ", countAttributeCombinations=%" IntegerDataTypePrintf ", attributeCombinations=%p, attributeCombinationIndexes=%p, countTargetStates=%" IntegerDataTypePrintf ", trainingTargets=%p, trainingDataSet=%p, trainingPredictionScores=%p, validationTargets=%p, validationDataSet=%p, validationPredictionScores=%p, countInnerBags=%" IntegerDataTypePrintf ", trainingOptions=%" IntegerDataTypePrintf, randomSeed, countAttributeCombinations, static_cast<const void *>(attributeCombinations), static_cast<const void *>(attributeCombinationIndexes), countTargetStates, static_cast<const void *>(trainingTargets), static_cast<void *>(trainingDataSet), static_cast<const void *>(trainingPredictionScores), static_cast<const void *>(validationTargets), static_cast<void *>(validationDataSet), static_cast<const void *>(validationPredictionScores), countInnerBags, trainingOptions);
+   PEbmTraining pEbmTraining = reinterpret_cast<PEbmTraining>(AllocateCoreFromDataSets(false, randomSeed, countAttributeCombinations, attributeCombinations, attributeCombinationIndexes, countTargetStates, trainingTargets, trainingDataSet, trainingPredictionScores, validationTargets, validationDataSet, validationPredictionScores, countInnerBags, trainingOptions));
+   LOG(TraceLevelInfo, "Exited InitializeTrainingClassificationFromDataSets %p", static_cast<void *>(pEbmTraining));
+   return pEbmTraining;
+}
+
 template<bool bRegression>
-TML_INLINE CachedTrainingThreadResources<bRegression> * GetCachedThreadResources(TmlState * pTmlState);
+TML_INLINE CachedTrainingThreadResources<bRegression> * GetCachedThreadResources(SamplingSetScratch * pSamplingSetScratch);
 template<>
-TML_INLINE CachedTrainingThreadResources<false> * GetCachedThreadResources<false>(TmlState * pTmlState) {
-   return &pTmlState->m_cachedThreadResourcesUnion.classification;
+TML_INLINE CachedTrainingThreadResources<false> * GetCachedThreadResources<false>(SamplingSetScratch * pSamplingSetScratch) {
+   return &pSamplingSetScratch->m_cachedThreadResourcesUnion.classification;
 }
 template<>
-TML_INLINE CachedTrainingThreadResources<true> * GetCachedThreadResources<true>(TmlState * pTmlState) {
-   return &pTmlState->m_cachedThreadResourcesUnion.regression;
+TML_INLINE CachedTrainingThreadResources<true> * GetCachedThreadResources<true>(SamplingSetScratch * pSamplingSetScratch) {
+   return &pSamplingSetScratch->m_cachedThreadResourcesUnion.regression;
+}
+
+class TrainSamplingSetsContext final {
+public:
+   const TmlState * const m_pTmlState;
+   TrainingThreadState * const m_pTrainingThreadState;
+   const AttributeCombinationCore * const m_pAttributeCombination;
+   const size_t m_cTreeSplitsMax;
+   const size_t m_cCasesRequiredForSplitParentMin;
+   // if not nullptr, each sampling set's histogram has already been binned here by BinDataSetTrainingFusedParallel, one after another
+   const void * const m_aFusedBinnedBuckets;
+   const size_t m_cBytesFusedHistogram;
+
+   TrainSamplingSetsContext(const TmlState * const pTmlState, TrainingThreadState * const pTrainingThreadState, const AttributeCombinationCore * const pAttributeCombination, const size_t cTreeSplitsMax, const size_t cCasesRequiredForSplitParentMin, const void * const aFusedBinnedBuckets, const size_t cBytesFusedHistogram)
+      : m_pTmlState(pTmlState)
+      , m_pTrainingThreadState(pTrainingThreadState)
+      , m_pAttributeCombination(pAttributeCombination)
+      , m_cTreeSplitsMax(cTreeSplitsMax)
+      , m_cCasesRequiredForSplitParentMin(cCasesRequiredForSplitParentMin)
+      , m_aFusedBinnedBuckets(aFusedBinnedBuckets)
+      , m_cBytesFusedHistogram(cBytesFusedHistogram) {
+   }
+};
+
+// this is called once per sampling set, potentially on a worker thread.  Each sampling set only touches its own SamplingSetScratch, and only reads the shared training data, so no locking is required
+template<ptrdiff_t countCompilerClassificationTargetStates>
+static void TrainSamplingSetTask(void * const pContext, const size_t iSamplingSet) {
+   const TrainSamplingSetsContext * const pTrainSamplingSetsContext = static_cast<const TrainSamplingSetsContext *>(pContext);
+   const TmlState * const pTmlState = pTrainSamplingSetsContext->m_pTmlState;
+   const AttributeCombinationCore * const pAttributeCombination = pTrainSamplingSetsContext->m_pAttributeCombination;
+
+   SamplingSetScratch * const pSamplingSetScratch = pTrainSamplingSetsContext->m_pTrainingThreadState->m_apSamplingSetScratches[iSamplingSet];
+   CachedTrainingThreadResources<IsRegression(countCompilerClassificationTargetStates)> * const pCachedThreadResources = GetCachedThreadResources<IsRegression(countCompilerClassificationTargetStates)>(pSamplingSetScratch);
+   SegmentedRegionCore<ActiveDataType, FractionalDataType> * const pSmallChangeToModelOverwriteSingleSamplingSet = pSamplingSetScratch->m_pSmallChangeToModelOverwriteSingleSamplingSet;
+
+   pSmallChangeToModelOverwriteSingleSamplingSet->SetCountDimensions(pAttributeCombination->m_cAttributes);
+
+   const BinnedBucket<IsRegression(countCompilerClassificationTargetStates)> * const aBinnedBucketsPreBinned = nullptr == pTrainSamplingSetsContext->m_aFusedBinnedBuckets ? nullptr : reinterpret_cast<const BinnedBucket<IsRegression(countCompilerClassificationTargetStates)> *>(static_cast<const char *>(pTrainSamplingSetsContext->m_aFusedBinnedBuckets) + iSamplingSet * pTrainSamplingSetsContext->m_cBytesFusedHistogram);
+
+   FractionalDataType gain = 0;
+   bool bError;
+   if(0 == pAttributeCombination->m_cAttributes) {
+      bError = TrainZeroDimensional<countCompilerClassificationTargetStates>(pCachedThreadResources, pTmlState->m_apSamplingSets[iSamplingSet], pSmallChangeToModelOverwriteSingleSamplingSet, pTmlState->m_cTargetStates);
+   } else if(1 == pAttributeCombination->m_cAttributes) {
+      bError = TrainSingleDimensional<countCompilerClassificationTargetStates>(pCachedThreadResources, pTmlState->m_apSamplingSets[iSamplingSet], pAttributeCombination, pTrainSamplingSetsContext->m_cTreeSplitsMax, pTrainSamplingSetsContext->m_cCasesRequiredForSplitParentMin, pSmallChangeToModelOverwriteSingleSamplingSet, &gain, pTmlState->m_cTargetStates, aBinnedBucketsPreBinned);
+   } else {
+      bError = CompilerRecursiveDimensions<TrainMultiDimensionalDimensions, countCompilerClassificationTargetStates>::Run(pAttributeCombination->m_cAttributes, pCachedThreadResources, pTmlState->m_apSamplingSets[iSamplingSet], pAttributeCombination, pSmallChangeToModelOverwriteSingleSamplingSet, pTmlState->m_cTargetStates, aBinnedBucketsPreBinned);
+   }
+   pSamplingSetScratch->m_gain = gain;
+   pSamplingSetScratch->m_bTrainingError = bError;
 }
 
 // a*PredictionScores = logOdds for binary classification
 // a*PredictionScores = logWeights for multiclass classification
 // a*PredictionScores = predictedValue for regression
 template<ptrdiff_t countCompilerClassificationTargetStates>
-static FractionalDataType * GenerateModelUpdatePerTargetStates(TmlState * const pTmlState, const size_t iAttributeCombination, const FractionalDataType learningRate, const size_t cTreeSplitsMax, const size_t cCasesRequiredForSplitParentMin, const FractionalDataType * const aTrainingWeights, const FractionalDataType * const aValidationWeights, FractionalDataType * const pGainReturn) {
+static FractionalDataType * GenerateModelUpdatePerTargetStates(const TmlState * const pTmlState, TrainingThreadState * const pTrainingThreadState, const size_t iAttributeCombination, const FractionalDataType learningRate, const size_t cTreeSplitsMax, const size_t cCasesRequiredForSplitParentMin, const FractionalDataType * const aTrainingWeights, const FractionalDataType * const aValidationWeights, FractionalDataType * const pGainReturn) {
    // TODO remove this after we use aTrainingWeights and aValidationWeights into the GenerateModelUpdatePerTargetStates function
    UNUSED(aTrainingWeights);
    UNUSED(aValidationWeights);
@@ -1089,38 +1760,59 @@ static FractionalDataType * GenerateModelUpdatePerTargetStates(TmlState * const
    }
 
    const size_t cSamplingSetsAfterZero = (0 == pTmlState->m_cSamplingSets) ? 1 : pTmlState->m_cSamplingSets;
-   CachedTrainingThreadResources<IsRegression(countCompilerClassificationTargetStates)> * const pCachedThreadResources = GetCachedThreadResources<IsRegression(countCompilerClassificationTargetStates)>(pTmlState);
+   EBM_ASSERT(cSamplingSetsAfterZero == pTrainingThreadState->m_cSamplingSetScratches);
    const AttributeCombinationCore * const pAttributeCombination = pTmlState->m_apAttributeCombinations[iAttributeCombination];
    const size_t cDimensions = pAttributeCombination->m_cAttributes;
 
-   pTmlState->m_pSmallChangeToModelAccumulatedFromSamplingSets->SetCountDimensions(cDimensions);
-   pTmlState->m_pSmallChangeToModelAccumulatedFromSamplingSets->Reset();
+   pTrainingThreadState->m_pSmallChangeToModelAccumulatedFromSamplingSets->SetCountDimensions(cDimensions);
+   pTrainingThreadState->m_pSmallChangeToModelAccumulatedFromSamplingSets->Reset();
 
    // if pTmlState->m_apSamplingSets is nullptr, then we should have zero training cases
    // we can't be partially constructed here since then we wouldn't have returned our state pointer to our caller
    EBM_ASSERT(!pTmlState->m_apSamplingSets == !pTmlState->m_pTrainingSet); // m_pTrainingSet and m_apSamplingSets should be the same null-ness in that they should either both be null or both be non-null (although different non-null values)
    FractionalDataType totalGain = 0;
    if(nullptr != pTmlState->m_apSamplingSets) {
-      pTmlState->m_pSmallChangeToModelOverwriteSingleSamplingSet->SetCountDimensions(cDimensions);
-
-      for(size_t iSamplingSet = 0; iSamplingSet < cSamplingSetsAfterZero; ++iSamplingSet) {
-         FractionalDataType gain = 0;
-         if(0 == pAttributeCombination->m_cAttributes) {
-            if(TrainZeroDimensional<countCompilerClassificationTargetStates>(pCachedThreadResources, pTmlState->m_apSamplingSets[iSamplingSet], pTmlState->m_pSmallChangeToModelOverwriteSingleSamplingSet, pTmlState->m_cTargetStates)) {
-               return nullptr;
-            }
-         } else if(1 == pAttributeCombination->m_cAttributes) {
-            if(TrainSingleDimensional<countCompilerClassificationTargetStates>(pCachedThreadResources, pTmlState->m_apSamplingSets[iSamplingSet], pAttributeCombination, cTreeSplitsMax, cCasesRequiredForSplitParentMin, pTmlState->m_pSmallChangeToModelOverwriteSingleSamplingSet, &gain, pTmlState->m_cTargetStates)) {
-               return nullptr;
-            }
+      const void * aFusedBinnedBuckets = nullptr;
+      size_t cBytesFusedHistogram = 0;
+      if(2 <= pTmlState->m_cSamplingSets && 1 <= cDimensions) {
+         // every sampling set bins the same input data and residuals, so bin them all in a single pass over the data instead of once per sampling set.
+         // The sampling sets then copy their histograms out of our fused buffer
+         size_t cBinnedBuckets = 1;
+         for(size_t iDimension = 0; iDimension < cDimensions; ++iDimension) {
+            // we checked for overflow of this product in the attribute combination allocation
+            cBinnedBuckets *= pAttributeCombination->m_AttributeCombinationEntry[iDimension].m_pAttribute->m_cStates;
+         }
+         size_t cPartitions;
+         size_t cCasesPerPartition;
+         const size_t cBytesFused = GetBinDataSetTrainingFusedBytes<countCompilerClassificationTargetStates>(cBinnedBuckets, pTmlState->m_cSamplingSets, pTmlState->m_pTrainingSet->GetCountCases(), pAttributeCombination, pTmlState->m_cTargetStates, &cPartitions, &cCasesPerPartition);
+         if(0 == cBytesFused || k_cBytesFusedBinningMax < cBytesFused) {
+            // leaving aFusedBinnedBuckets as nullptr makes each sampling set bin itself with BinDataSetTrainingParallel, which uses the same partitions and
+            // so gives the same histograms
+            LOG(TraceLevelInfo, "GenerateModelUpdatePerTargetStates binning each sampling set separately since the fused scratch would need %zu bytes", cBytesFused);
          } else {
-            if(TrainMultiDimensional<countCompilerClassificationTargetStates, 0>(pCachedThreadResources, pTmlState->m_apSamplingSets[iSamplingSet], pAttributeCombination, pTmlState->m_pSmallChangeToModelOverwriteSingleSamplingSet, pTmlState->m_cTargetStates)) {
+            BinnedBucket<IsRegression(countCompilerClassificationTargetStates)> * const aBinnedBucketsAllPartitions = static_cast<BinnedBucket<IsRegression(countCompilerClassificationTargetStates)> *>(pTrainingThreadState->GetFusedBinnedBuckets(cBytesFused));
+            if(nullptr == aBinnedBucketsAllPartitions) {
+               LOG(TraceLevelWarning, "WARNING GenerateModelUpdatePerTargetStates nullptr == aBinnedBucketsAllPartitions");
                return nullptr;
             }
+            BinDataSetTrainingFusedParallel<countCompilerClassificationTargetStates>(aBinnedBucketsAllPartitions, cPartitions, cCasesPerPartition, cBinnedBuckets, pTmlState->m_cSamplingSets, pTmlState->m_apSamplingSets, pAttributeCombination, pTmlState->m_cTargetStates);
+            aFusedBinnedBuckets = aBinnedBucketsAllPartitions;
+            cBytesFusedHistogram = cBytesFused / cPartitions / pTmlState->m_cSamplingSets;
+         }
+      }
+
+      // each sampling set is independent of the others until we sum them, so train them all simultaneously, each into its own SegmentedRegion with its own thread resources
+      TrainSamplingSetsContext trainSamplingSetsContext(pTmlState, pTrainingThreadState, pAttributeCombination, cTreeSplitsMax, cCasesRequiredForSplitParentMin, aFusedBinnedBuckets, cBytesFusedHistogram);
+      ExecuteParallel(cSamplingSetsAfterZero, &TrainSamplingSetTask<countCompilerClassificationTargetStates>, &trainSamplingSetsContext);
+
+      // we combine the results on this thread in the same order that we would have if we had trained them sequentially, so our results are deterministic regardless of the number of threads
+      for(size_t iSamplingSet = 0; iSamplingSet < cSamplingSetsAfterZero; ++iSamplingSet) {
+         const SamplingSetScratch * const pSamplingSetScratch = pTrainingThreadState->m_apSamplingSetScratches[iSamplingSet];
+         if(pSamplingSetScratch->m_bTrainingError) {
+            return nullptr;
          }
-         totalGain += gain;
-         // TODO : when we thread this code, let's have each thread take a lock and update the combined line segment.  They'll each do it while the others are working, so there should be no blocking and our final result won't require adding by the main thread
-         if(pTmlState->m_pSmallChangeToModelAccumulatedFromSamplingSets->Add(*pTmlState->m_pSmallChangeToModelOverwriteSingleSamplingSet)) {
+         totalGain += pSamplingSetScratch->m_gain;
+         if(pTrainingThreadState->m_pSmallChangeToModelAccumulatedFromSamplingSets->Add(*pSamplingSetScratch->m_pSmallChangeToModelOverwriteSingleSamplingSet)) {
             return nullptr;
          }
       }
@@ -1140,32 +1832,32 @@ static FractionalDataType * GenerateModelUpdatePerTargetStates(TmlState * const
          //if(0 <= k_iZeroResidual || 2 == pTmlState->m_cTargetStates && bExpandBinaryLogits) {
          //   EBM_ASSERT(2 <= pTmlState->m_cTargetStates);
          //   // TODO : for classification with residual zeroing, is our learning rate essentially being inflated as pTmlState->m_cTargetStates goes up?  If so, maybe we should divide by pTmlState->m_cTargetStates here to keep learning rates as equivalent as possible..  Actually, I think the real solution here is that 
-         //   pTmlState->m_pSmallChangeToModelAccumulatedFromSamplingSets->Multiply(learningRate / cSamplingSetsAfterZero * (pTmlState->m_cTargetStates - 1) / pTmlState->m_cTargetStates);
+         //   pTrainingThreadState->m_pSmallChangeToModelAccumulatedFromSamplingSets->Multiply(learningRate / cSamplingSetsAfterZero * (pTmlState->m_cTargetStates - 1) / pTmlState->m_cTargetStates);
          //} else {
          //   // TODO : for classification, is our learning rate essentially being inflated as pTmlState->m_cTargetStates goes up?  If so, maybe we should divide by pTmlState->m_cTargetStates here to keep learning rates equivalent as possible
-         //   pTmlState->m_pSmallChangeToModelAccumulatedFromSamplingSets->Multiply(learningRate / cSamplingSetsAfterZero);
+         //   pTrainingThreadState->m_pSmallChangeToModelAccumulatedFromSamplingSets->Multiply(learningRate / cSamplingSetsAfterZero);
          //}
 
          constexpr bool bDividing = bExpandBinaryLogits && 2 == countCompilerClassificationTargetStates;
          if(bDividing) {
-            pTmlState->m_pSmallChangeToModelAccumulatedFromSamplingSets->Multiply(learningRate / cSamplingSetsAfterZero / 2);
+            pTrainingThreadState->m_pSmallChangeToModelAccumulatedFromSamplingSets->Multiply(learningRate / cSamplingSetsAfterZero / 2);
          } else {
-            pTmlState->m_pSmallChangeToModelAccumulatedFromSamplingSets->Multiply(learningRate / cSamplingSetsAfterZero);
+            pTrainingThreadState->m_pSmallChangeToModelAccumulatedFromSamplingSets->Multiply(learningRate / cSamplingSetsAfterZero);
          }
       } else {
-         pTmlState->m_pSmallChangeToModelAccumulatedFromSamplingSets->Multiply(learningRate / cSamplingSetsAfterZero);
+         pTrainingThreadState->m_pSmallChangeToModelAccumulatedFromSamplingSets->Multiply(learningRate / cSamplingSetsAfterZero);
       }
    }
 
    if(0 != cDimensions) {
-      // pTmlState->m_pSmallChangeToModelAccumulatedFromSamplingSets was reset above, so it isn't expanded.  We want to expand it before calling ValidationSetInputAttributeLoop so that we can more efficiently lookup the results by index rather than do a binary search
+      // pTrainingThreadState->m_pSmallChangeToModelAccumulatedFromSamplingSets was reset above, so it isn't expanded.  We want to expand it before calling ValidationSetInputAttributeLoop so that we can more efficiently lookup the results by index rather than do a binary search
       size_t acDivisionIntegersEnd[k_cDimensionsMax];
       size_t iDimension = 0;
       do {
          acDivisionIntegersEnd[iDimension] = pAttributeCombination->m_AttributeCombinationEntry[iDimension].m_pAttribute->m_cStates;
          ++iDimension;
       } while(iDimension < cDimensions);
-      if(pTmlState->m_pSmallChangeToModelAccumulatedFromSamplingSets->Expand(acDivisionIntegersEnd)) {
+      if(pTrainingThreadState->m_pSmallChangeToModelAccumulatedFromSamplingSets->Expand(acDivisionIntegersEnd)) {
          return nullptr;
       }
    }
@@ -1175,38 +1867,38 @@ static FractionalDataType * GenerateModelUpdatePerTargetStates(TmlState * const
    }
 
    LOG(TraceLevelVerbose, "Exited GenerateModelUpdatePerTargetStates");
-   return pTmlState->m_pSmallChangeToModelAccumulatedFromSamplingSets->m_aValues;
+   return pTrainingThreadState->m_pSmallChangeToModelAccumulatedFromSamplingSets->m_aValues;
 }
 
 template<ptrdiff_t iPossibleCompilerOptimizedTargetStates>
-TML_INLINE FractionalDataType * CompilerRecursiveGenerateModelUpdate(const size_t cRuntimeTargetStates, TmlState * const pTmlState, const size_t iAttributeCombination, const FractionalDataType learningRate, const size_t cTreeSplitsMax, const size_t cCasesRequiredForSplitParentMin, const FractionalDataType * const aTrainingWeights, const FractionalDataType * const aValidationWeights, FractionalDataType * const pGainReturn) {
+TML_INLINE FractionalDataType * CompilerRecursiveGenerateModelUpdate(const size_t cRuntimeTargetStates, const TmlState * const pTmlState, TrainingThreadState * const pTrainingThreadState, const size_t iAttributeCombination, const FractionalDataType learningRate, const size_t cTreeSplitsMax, const size_t cCasesRequiredForSplitParentMin, const FractionalDataType * const aTrainingWeights, const FractionalDataType * const aValidationWeights, FractionalDataType * const pGainReturn) {
    EBM_ASSERT(IsClassification(iPossibleCompilerOptimizedTargetStates));
    if(iPossibleCompilerOptimizedTargetStates == cRuntimeTargetStates) {
       EBM_ASSERT(cRuntimeTargetStates <= k_cCompilerOptimizedTargetStatesMax);
-      return GenerateModelUpdatePerTargetStates<iPossibleCompilerOptimizedTargetStates>(pTmlState, iAttributeCombination, learningRate, cTreeSplitsMax, cCasesRequiredForSplitParentMin, aTrainingWeights, aValidationWeights, pGainReturn);
+      return GenerateModelUpdatePerTargetStates<iPossibleCompilerOptimizedTargetStates>(pTmlState, pTrainingThreadState, iAttributeCombination, learningRate, cTreeSplitsMax, cCasesRequiredForSplitParentMin, aTrainingWeights, aValidationWeights, pGainReturn);
    } else {
-      return CompilerRecursiveGenerateModelUpdate<iPossibleCompilerOptimizedTargetStates + 1>(cRuntimeTargetStates, pTmlState, iAttributeCombination, learningRate, cTreeSplitsMax, cCasesRequiredForSplitParentMin, aTrainingWeights, aValidationWeights, pGainReturn);
+      return CompilerRecursiveGenerateModelUpdate<iPossibleCompilerOptimizedTargetStates + 1>(cRuntimeTargetStates, pTmlState, pTrainingThreadState, iAttributeCombination, learningRate, cTreeSplitsMax, cCasesRequiredForSplitParentMin, aTrainingWeights, aValidationWeights, pGainReturn);
    }
 }
 
 template<>
-TML_INLINE FractionalDataType * CompilerRecursiveGenerateModelUpdate<k_cCompilerOptimizedTargetStatesMax + 1>(const size_t cRuntimeTargetStates, TmlState * const pTmlState, const size_t iAttributeCombination, const FractionalDataType learningRate, const size_t cTreeSplitsMax, const size_t cCasesRequiredForSplitParentMin, const FractionalDataType * const aTrainingWeights, const FractionalDataType * const aValidationWeights, FractionalDataType * const pGainReturn) {
+TML_INLINE FractionalDataType * CompilerRecursiveGenerateModelUpdate<k_cCompilerOptimizedTargetStatesMax + 1>(const size_t cRuntimeTargetStates, const TmlState * const pTmlState, TrainingThreadState * const pTrainingThreadState, const size_t iAttributeCombination, const FractionalDataType learningRate, const size_t cTreeSplitsMax, const size_t cCasesRequiredForSplitParentMin, const FractionalDataType * const aTrainingWeights, const FractionalDataType * const aValidationWeights, FractionalDataType * const pGainReturn) {
    UNUSED(cRuntimeTargetStates);
    // it is logically possible, but uninteresting to have a classification with 1 target state, so let our runtime system handle those unlikley and uninteresting cases
    EBM_ASSERT(k_cCompilerOptimizedTargetStatesMax < cRuntimeTargetStates);
-   return GenerateModelUpdatePerTargetStates<k_DynamicClassification>(pTmlState, iAttributeCombination, learningRate, cTreeSplitsMax, cCasesRequiredForSplitParentMin, aTrainingWeights, aValidationWeights, pGainReturn);
+   return GenerateModelUpdatePerTargetStates<k_DynamicClassification>(pTmlState, pTrainingThreadState, iAttributeCombination, learningRate, cTreeSplitsMax, cCasesRequiredForSplitParentMin, aTrainingWeights, aValidationWeights, pGainReturn);
 }
 
 // we made this a global because if we had put this variable inside the EbmTrainingState object, then we would need to dereference that before getting the count.  By making this global we can send a log message incase a bad EbmTrainingState object is sent into us
 // we only decrease the count if the count is non-zero, so at worst if there is a race condition then we'll output this log message more times than desired, but we can live with that
 static unsigned int g_cLogGenerateModelUpdateParametersMessages = 10;
 
-// TODO : we can make GenerateModelUpdate callable by multiple threads so that this step could be parallelized before making a decision and applying one of the updates.  Right now we're accessing scratch space in the pTmlState object, but we can move that to a thread resident object.  Do do this, we would need to have our caller allocate our tensor, but that is a manageable operation
-EBMCORE_IMPORT_EXPORT FractionalDataType * EBMCORE_CALLING_CONVENTION GenerateModelUpdate(PEbmTraining ebmTraining, IntegerDataType indexAttributeCombination, FractionalDataType learningRate, IntegerDataType countTreeSplitsMax, IntegerDataType countCasesRequiredForSplitParentMin, const FractionalDataType * trainingWeights, const FractionalDataType * validationWeights, FractionalDataType * gainReturn) {
-   LOG_COUNTED(&g_cLogGenerateModelUpdateParametersMessages, TraceLevelInfo, TraceLevelVerbose, "GenerateModelUpdate parameters: ebmTraining=%p, indexAttributeCombination=%" IntegerDataTypePrintf ", learningRate=%" FractionalDataTypePrintf ", countTreeSplitsMax=%" IntegerDataTypePrintf ", countCasesRequiredForSplitParentMin=%" IntegerDataTypePrintf ", trainingWeights=%p, validationWeights=%p, gainReturn=%p", static_cast<void *>(ebmTraining), indexAttributeCombination, learningRate, countTreeSplitsMax, countCasesRequiredForSplitParentMin, static_cast<const void *>(trainingWeights), static_cast<const void *>(validationWeights), static_cast<void *>(gainReturn));
-
-   TmlState * pTmlState = reinterpret_cast<TmlState *>(ebmTraining);
+// shared by GenerateModelUpdate and GenerateModelUpdateThreadSafe.  Everything in pTmlState is treated as read only and all writes go to pTrainingThreadState, so
+// this function can be called from multiple threads simultaneously as long as each thread uses a different pTrainingThreadState.  That includes the LOG_COUNTED
+// counters, which are plain unsigned ints, so the counted enter/exit messages live in GenerateModelUpdate and the thread safe version only uses LOG
+static FractionalDataType * GenerateModelUpdateInternal(const TmlState * const pTmlState, TrainingThreadState * const pTrainingThreadState, const IntegerDataType indexAttributeCombination, const FractionalDataType learningRate, const IntegerDataType countTreeSplitsMax, const IntegerDataType countCasesRequiredForSplitParentMin, const FractionalDataType * const trainingWeights, const FractionalDataType * const validationWeights, FractionalDataType * const gainReturn) {
    EBM_ASSERT(nullptr != pTmlState);
+   EBM_ASSERT(nullptr != pTrainingThreadState);
 
    EBM_ASSERT(0 <= indexAttributeCombination);
    EBM_ASSERT((IsNumberConvertable<size_t, IntegerDataType>(indexAttributeCombination))); // we wouldn't have allowed the creation of an attribute set larger than size_t
@@ -1214,8 +1906,6 @@ EBMCORE_IMPORT_EXPORT FractionalDataType * EBMCORE_CALLING_CONVENTION GenerateMo
    EBM_ASSERT(iAttributeCombination < pTmlState->m_cAttributeCombinations);
    EBM_ASSERT(nullptr != pTmlState->m_apAttributeCombinations); // this is true because 0 < pTmlState->m_cAttributeCombinations since our caller needs to pass in a valid indexAttributeCombination to this function
 
-   LOG_COUNTED(&pTmlState->m_apAttributeCombinations[iAttributeCombination]->m_cLogEnterGenerateModelUpdateMessages, TraceLevelInfo, TraceLevelVerbose, "Entered GenerateModelUpdate");
-
    EBM_ASSERT(!std::isnan(learningRate));
    EBM_ASSERT(!std::isinf(learningRate));
 
@@ -1239,7 +1929,7 @@ EBMCORE_IMPORT_EXPORT FractionalDataType * EBMCORE_CALLING_CONVENTION GenerateMo
 
    FractionalDataType * aModelUpdateTensor;
    if(pTmlState->m_bRegression) {
-      aModelUpdateTensor = GenerateModelUpdatePerTargetStates<k_Regression>(pTmlState, iAttributeCombination, learningRate, cTreeSplitsMax, cCasesRequiredForSplitParentMin, trainingWeights, validationWeights, gainReturn);
+      aModelUpdateTensor = GenerateModelUpdatePerTargetStates<k_Regression>(pTmlState, pTrainingThreadState, iAttributeCombination, learningRate, cTreeSplitsMax, cCasesRequiredForSplitParentMin, trainingWeights, validationWeights, gainReturn);
    } else {
       const size_t cTargetStates = pTmlState->m_cTargetStates;
       if(cTargetStates <= 1) {
@@ -1251,19 +1941,238 @@ EBMCORE_IMPORT_EXPORT FractionalDataType * EBMCORE_CALLING_CONVENTION GenerateMo
          LOG(TraceLevelWarning, "WARNING GenerateModelUpdate cTargetStates <= 1");
          return nullptr;
       }
-      aModelUpdateTensor = CompilerRecursiveGenerateModelUpdate<2>(cTargetStates, pTmlState, iAttributeCombination, learningRate, cTreeSplitsMax, cCasesRequiredForSplitParentMin, trainingWeights, validationWeights, gainReturn);
+      aModelUpdateTensor = CompilerRecursiveGenerateModelUpdate<2>(cTargetStates, pTmlState, pTrainingThreadState, iAttributeCombination, learningRate, cTreeSplitsMax, cCasesRequiredForSplitParentMin, trainingWeights, validationWeights, gainReturn);
+   }
+
+   EBM_ASSERT(nullptr == gainReturn || *gainReturn <= 0.000000001);
+   if(nullptr == aModelUpdateTensor) {
+      LOG(TraceLevelWarning, "WARNING GenerateModelUpdate returned nullptr");
+   }
+   return aModelUpdateTensor;
+}
+
+EBMCORE_IMPORT_EXPORT FractionalDataType * EBMCORE_CALLING_CONVENTION GenerateModelUpdate(PEbmTraining ebmTraining, IntegerDataType indexAttributeCombination, FractionalDataType learningRate, IntegerDataType countTreeSplitsMax, IntegerDataType countCasesRequiredForSplitParentMin, const FractionalDataType * trainingWeights, const FractionalDataType * validationWeights, FractionalDataType * gainReturn) {
+   LOG_COUNTED(&g_cLogGenerateModelUpdateParametersMessages, TraceLevelInfo, TraceLevelVerbose, "GenerateModelUpdate parameters: ebmTraining=%p, indexAttributeCombination=%" IntegerDataTypePrintf ", learningRate=%" FractionalDataTypePrintf ", countTreeSplitsMax=%" IntegerDataTypePrintf ", countCasesRequiredForSplitParentMin=%" IntegerDataTypePrintf ", trainingWeights=%p, validationWeights=%p, gainReturn=%p", static_cast<void *>(ebmTraining), indexAttributeCombination, learningRate, countTreeSplitsMax, countCasesRequiredForSplitParentMin, static_cast<const void *>(trainingWeights), static_cast<const void *>(validationWeights), static_cast<void *>(gainReturn));
+
+   TmlState * pTmlState = reinterpret_cast<TmlState *>(ebmTraining);
+   EBM_ASSERT(nullptr != pTmlState);
+
+   EBM_ASSERT(0 <= indexAttributeCombination);
+   EBM_ASSERT((IsNumberConvertable<size_t, IntegerDataType>(indexAttributeCombination))); // we wouldn't have allowed the creation of an attribute set larger than size_t
+   EBM_ASSERT(static_cast<size_t>(indexAttributeCombination) < pTmlState->m_cAttributeCombinations);
+   AttributeCombinationCore * const pAttributeCombination = pTmlState->m_apAttributeCombinations[static_cast<size_t>(indexAttributeCombination)];
+
+   LOG_COUNTED(&pAttributeCombination->m_cLogEnterGenerateModelUpdateMessages, TraceLevelInfo, TraceLevelVerbose, "Entered GenerateModelUpdate");
+
+   // this version returns a pointer into the scratch space owned by pTmlState, so it isn't reentrant.  Use GenerateModelUpdateThreadSafe to generate updates from multiple threads
+   FractionalDataType * const aModelUpdateTensor = GenerateModelUpdateInternal(pTmlState, &pTmlState->m_trainingThreadState, indexAttributeCombination, learningRate, countTreeSplitsMax, countCasesRequiredForSplitParentMin, trainingWeights, validationWeights, gainReturn);
+
+   if(nullptr != gainReturn) {
+      LOG_COUNTED(&pAttributeCombination->m_cLogExitGenerateModelUpdateMessages, TraceLevelInfo, TraceLevelVerbose, "Exited GenerateModelUpdate %" FractionalDataTypePrintf, *gainReturn);
+   } else {
+      LOG_COUNTED(&pAttributeCombination->m_cLogExitGenerateModelUpdateMessages, TraceLevelInfo, TraceLevelVerbose, "Exited GenerateModelUpdate no gain");
+   }
+   // our own scratch space is the only thing that grows after we're allocated, and only this function uses it
+   pTmlState->UpdatePeakMemory();
+   return aModelUpdateTensor;
+}
+
+EBMCORE_IMPORT_EXPORT PEbmTrainingThreadState EBMCORE_CALLING_CONVENTION AllocateTrainingThreadState(PEbmTraining ebmTraining) {
+   LOG(TraceLevelInfo, "Entered AllocateTrainingThreadState: ebmTraining=%p", static_cast<void *>(ebmTraining));
+
+   const TmlState * const pTmlState = reinterpret_cast<const TmlState *>(ebmTraining);
+   EBM_ASSERT(nullptr != pTmlState);
+
+   // the TrainingThreadState needs to match the shape of the scratch space owned by the EbmTrainingState, since they're used interchangeably
+   TrainingThreadState * const pTrainingThreadState = new (std::nothrow) TrainingThreadState(pTmlState->m_bRegression, pTmlState->m_trainingThreadState.m_cVectorLength, pTmlState->m_cSamplingSets);
+   if(UNLIKELY(nullptr == pTrainingThreadState)) {
+      LOG(TraceLevelWarning, "WARNING AllocateTrainingThreadState nullptr == pTrainingThreadState");
+      return nullptr;
+   }
+   if(UNLIKELY(pTrainingThreadState->IsError())) {
+      LOG(TraceLevelWarning, "WARNING AllocateTrainingThreadState pTrainingThreadState->IsError()");
+      delete pTrainingThreadState;
+      return nullptr;
    }
 
+   LOG(TraceLevelInfo, "Exited AllocateTrainingThreadState %p", static_cast<void *>(pTrainingThreadState));
+   return reinterpret_cast<PEbmTrainingThreadState>(pTrainingThreadState);
+}
+
+EBMCORE_IMPORT_EXPORT void EBMCORE_CALLING_CONVENTION FreeTrainingThreadState(PEbmTrainingThreadState ebmTrainingThreadState) {
+   LOG(TraceLevelInfo, "Entered FreeTrainingThreadState: ebmTrainingThreadState=%p", static_cast<void *>(ebmTrainingThreadState));
+   TrainingThreadState * const pTrainingThreadState = reinterpret_cast<TrainingThreadState *>(ebmTrainingThreadState);
+   // it's legal to call free on nullptr, just like for free().  This is checked inside the TrainingThreadState destructor
+   delete pTrainingThreadState;
+   LOG(TraceLevelInfo, "Exited FreeTrainingThreadState");
+}
+
+// we made this a global because if we had put this variable inside the EbmTrainingState object, then we would need to dereference that before getting the count.  By making this global we can send a log message incase a bad EbmTrainingState object is sent into us
+// we only decrease the count if the count is non-zero, so at worst if there is a race condition then we'll output this log message more times than desired, but we can live with that
+EBMCORE_IMPORT_EXPORT IntegerDataType EBMCORE_CALLING_CONVENTION GenerateModelUpdateThreadSafe(PEbmTraining ebmTraining, PEbmTrainingThreadState ebmTrainingThreadState, IntegerDataType indexAttributeCombination, FractionalDataType learningRate, IntegerDataType countTreeSplitsMax, IntegerDataType countCasesRequiredForSplitParentMin, const FractionalDataType * trainingWeights, const FractionalDataType * validationWeights, FractionalDataType * gainReturn, FractionalDataType * modelUpdateTensorOut) {
+   // this function is called from multiple threads at once, so we can't use LOG_COUNTED here since its counters aren't atomic.  Every message is verbose instead
+   LOG(TraceLevelVerbose, "GenerateModelUpdateThreadSafe parameters: ebmTraining=%p, ebmTrainingThreadState=%p, indexAttributeCombination=%" IntegerDataTypePrintf ", learningRate=%" FractionalDataTypePrintf ", countTreeSplitsMax=%" IntegerDataTypePrintf ", countCasesRequiredForSplitParentMin=%" IntegerDataTypePrintf ", trainingWeights=%p, validationWeights=%p, gainReturn=%p, modelUpdateTensorOut=%p", static_cast<void *>(ebmTraining), static_cast<void *>(ebmTrainingThreadState), indexAttributeCombination, learningRate, countTreeSplitsMax, countCasesRequiredForSplitParentMin, static_cast<const void *>(trainingWeights), static_cast<const void *>(validationWeights), static_cast<void *>(gainReturn), static_cast<void *>(modelUpdateTensorOut));
+
+   const TmlState * const pTmlState = reinterpret_cast<const TmlState *>(ebmTraining);
+   EBM_ASSERT(nullptr != pTmlState);
+   TrainingThreadState * const pTrainingThreadState = reinterpret_cast<TrainingThreadState *>(ebmTrainingThreadState);
+   EBM_ASSERT(nullptr != pTrainingThreadState);
+   EBM_ASSERT(pTmlState->m_bRegression == pTrainingThreadState->m_bRegression);
+   EBM_ASSERT(pTmlState->m_trainingThreadState.m_cVectorLength == pTrainingThreadState->m_cVectorLength);
+
+   const FractionalDataType * const aModelUpdateTensor = GenerateModelUpdateInternal(pTmlState, pTrainingThreadState, indexAttributeCombination, learningRate, countTreeSplitsMax, countCasesRequiredForSplitParentMin, trainingWeights, validationWeights, gainReturn);
    if(nullptr != gainReturn) {
-      EBM_ASSERT(*gainReturn <= 0.000000001);
-      LOG_COUNTED(&pTmlState->m_apAttributeCombinations[iAttributeCombination]->m_cLogExitGenerateModelUpdateMessages, TraceLevelInfo, TraceLevelVerbose, "Exited GenerateModelUpdate %" FractionalDataTypePrintf, *gainReturn);
+      LOG(TraceLevelVerbose, "Exited GenerateModelUpdateThreadSafe %" FractionalDataTypePrintf, *gainReturn);
    } else {
-      LOG_COUNTED(&pTmlState->m_apAttributeCombinations[iAttributeCombination]->m_cLogExitGenerateModelUpdateMessages, TraceLevelInfo, TraceLevelVerbose, "Exited GenerateModelUpdate no gain");
+      LOG(TraceLevelVerbose, "Exited GenerateModelUpdateThreadSafe no gain");
    }
    if(nullptr == aModelUpdateTensor) {
-      LOG(TraceLevelWarning, "WARNING GenerateModelUpdate returned nullptr");
+      if(!pTmlState->m_bRegression && pTmlState->m_cTargetStates <= 1) {
+         // the model tensor has zero items for this case, so there is nothing to copy into modelUpdateTensorOut, and this isn't an error
+         return 0;
+      }
+      LOG(TraceLevelWarning, "WARNING GenerateModelUpdateThreadSafe nullptr == aModelUpdateTensor");
+      return 1;
    }
-   return aModelUpdateTensor;
+
+   // our tensor is in the fully expanded form, so the number of items is just the product of the attribute state counts times the vector length
+   const AttributeCombinationCore * const pAttributeCombination = pTmlState->m_apAttributeCombinations[static_cast<size_t>(indexAttributeCombination)];
+   size_t cItems = pTrainingThreadState->m_cVectorLength;
+   for(size_t iDimension = 0; iDimension < pAttributeCombination->m_cAttributes; ++iDimension) {
+      // we've allocated this memory already, so multiplying these together can't overflow
+      cItems *= pAttributeCombination->m_AttributeCombinationEntry[iDimension].m_pAttribute->m_cStates;
+   }
+   EBM_ASSERT(nullptr != modelUpdateTensorOut);
+   memcpy(modelUpdateTensorOut, aModelUpdateTensor, sizeof(*modelUpdateTensorOut) * cItems);
+   return 0;
+}
+
+class ApplyModelUpdateChunksContext final {
+public:
+   const AttributeCombinationCore * const m_pAttributeCombination;
+   DataSetAttributeCombination * const m_pDataSet;
+   const FractionalDataType * const m_aModelUpdateTensor;
+   const size_t m_cTargetStates;
+   const MathBackendCore m_mathBackend;
+   const size_t m_cCasesPerChunk;
+   // only used for validation sets.  The loss of each case in the chunks [m_iChunkFirst, m_iChunkFirst + the count of tasks) that are being run
+   FractionalDataType * const m_aCaseLosses;
+   size_t m_iChunkFirst;
+
+   ApplyModelUpdateChunksContext(const AttributeCombinationCore * const pAttributeCombination, DataSetAttributeCombination * const pDataSet, const FractionalDataType * const aModelUpdateTensor, const size_t cTargetStates, const MathBackendCore mathBackend, FractionalDataType * const aCaseLosses)
+      : m_pAttributeCombination(pAttributeCombination)
+      , m_pDataSet(pDataSet)
+      , m_aModelUpdateTensor(aModelUpdateTensor)
+      , m_cTargetStates(cTargetStates)
+      , m_mathBackend(mathBackend)
+      , m_cCasesPerChunk(k_cCasesPerApplyModelUpdateChunk)
+      , m_aCaseLosses(aCaseLosses)
+      , m_iChunkFirst(0) {
+      // m_cItemsPerBitPackDataUnit isn't initialized for attribute combinations with zero attributes, but those can be split on any case boundary
+      EBM_ASSERT(0 == pAttributeCombination->m_cAttributes || 0 == m_cCasesPerChunk % pAttributeCombination->m_cItemsPerBitPackDataUnit);
+   }
+
+   TML_INLINE size_t GetCountChunks() const {
+      const size_t cCases = m_pDataSet->GetCountCases();
+      return (cCases + m_cCasesPerChunk - 1) / m_cCasesPerChunk;
+   }
+
+   TML_INLINE size_t GetCaseStart(const size_t iChunk) const {
+      return iChunk * m_cCasesPerChunk;
+   }
+
+   TML_INLINE size_t GetCountCasesInChunk(const size_t iChunk) const {
+      const size_t cCasesRemaining = m_pDataSet->GetCountCases() - GetCaseStart(iChunk);
+      return cCasesRemaining < m_cCasesPerChunk ? cCasesRemaining : m_cCasesPerChunk;
+   }
+
+   // for out of core datasets, each chunk asks the OS to start reading the chunk after it before doing its own work.  Chunks are handed to threads in
+   // order, so the next chunk is usually the next one that a thread will pick up
+   TML_INLINE void ReadAheadNextChunk(const size_t iChunk) const {
+      if(m_pDataSet->IsOutOfCore() && iChunk + 1 < GetCountChunks()) {
+         m_pDataSet->ReadAhead(m_pAttributeCombination, GetCaseStart(iChunk + 1), GetCountCasesInChunk(iChunk + 1));
+      }
+   }
+};
+
+template<ptrdiff_t countCompilerClassificationTargetStates>
+static void TrainingSetChunkTask(void * const pContext, const size_t iChunk) {
+   const ApplyModelUpdateChunksContext * const pApplyModelUpdateChunksContext = static_cast<const ApplyModelUpdateChunksContext *>(pContext);
+   pApplyModelUpdateChunksContext->ReadAheadNextChunk(iChunk);
+   // each chunk covers a separate range of cases, so each thread writes to separate parts of the residual and prediction score arrays
+   if(pApplyModelUpdateChunksContext->m_pDataSet->IsSinglePrecision()) {
+      TrainingSetInputAttributeLoop<1, countCompilerClassificationTargetStates, float>(pApplyModelUpdateChunksContext->m_pAttributeCombination, pApplyModelUpdateChunksContext->m_pDataSet, pApplyModelUpdateChunksContext->m_aModelUpdateTensor, pApplyModelUpdateChunksContext->m_cTargetStates, pApplyModelUpdateChunksContext->GetCaseStart(iChunk), pApplyModelUpdateChunksContext->GetCountCasesInChunk(iChunk), pApplyModelUpdateChunksContext->m_mathBackend);
+   } else {
+      TrainingSetInputAttributeLoop<1, countCompilerClassificationTargetStates, FractionalDataType>(pApplyModelUpdateChunksContext->m_pAttributeCombination, pApplyModelUpdateChunksContext->m_pDataSet, pApplyModelUpdateChunksContext->m_aModelUpdateTensor, pApplyModelUpdateChunksContext->m_cTargetStates, pApplyModelUpdateChunksContext->GetCaseStart(iChunk), pApplyModelUpdateChunksContext->GetCountCasesInChunk(iChunk), pApplyModelUpdateChunksContext->m_mathBackend);
+   }
+}
+
+template<ptrdiff_t countCompilerClassificationTargetStates>
+static void ValidationSetChunkTask(void * const pContext, const size_t iTask) {
+   const ApplyModelUpdateChunksContext * const pApplyModelUpdateChunksContext = static_cast<const ApplyModelUpdateChunksContext *>(pContext);
+   EBM_ASSERT(nullptr != pApplyModelUpdateChunksContext->m_aCaseLosses);
+   const size_t iChunk = pApplyModelUpdateChunksContext->m_iChunkFirst + iTask;
+   pApplyModelUpdateChunksContext->ReadAheadNextChunk(iChunk);
+   // each chunk covers a separate range of cases, so each thread writes to separate parts of the residual, prediction score and loss arrays
+   FractionalDataType * const aCaseLosses = pApplyModelUpdateChunksContext->m_aCaseLosses + (pApplyModelUpdateChunksContext->GetCaseStart(iChunk) - pApplyModelUpdateChunksContext->GetCaseStart(pApplyModelUpdateChunksContext->m_iChunkFirst));
+   if(pApplyModelUpdateChunksContext->m_pDataSet->IsSinglePrecision()) {
+      ValidationSetInputAttributeLoop<1, countCompilerClassificationTargetStates, float>(pApplyModelUpdateChunksContext->m_pAttributeCombination, pApplyModelUpdateChunksContext->m_pDataSet, pApplyModelUpdateChunksContext->m_aModelUpdateTensor, pApplyModelUpdateChunksContext->m_cTargetStates, pApplyModelUpdateChunksContext->GetCaseStart(iChunk), pApplyModelUpdateChunksContext->GetCountCasesInChunk(iChunk), pApplyModelUpdateChunksContext->m_mathBackend, aCaseLosses);
+   } else {
+      ValidationSetInputAttributeLoop<1, countCompilerClassificationTargetStates, FractionalDataType>(pApplyModelUpdateChunksContext->m_pAttributeCombination, pApplyModelUpdateChunksContext->m_pDataSet, pApplyModelUpdateChunksContext->m_aModelUpdateTensor, pApplyModelUpdateChunksContext->m_cTargetStates, pApplyModelUpdateChunksContext->GetCaseStart(iChunk), pApplyModelUpdateChunksContext->GetCountCasesInChunk(iChunk), pApplyModelUpdateChunksContext->m_mathBackend, aCaseLosses);
+   }
+}
+
+template<ptrdiff_t countCompilerClassificationTargetStates>
+static void ApplyModelUpdateTrainingSet(const AttributeCombinationCore * const pAttributeCombination, DataSetAttributeCombination * const pTrainingSet, const FractionalDataType * const aModelUpdateTensor, const size_t cTargetStates, const MathBackendCore mathBackend) {
+   ApplyModelUpdateChunksContext applyModelUpdateChunksContext(pAttributeCombination, pTrainingSet, aModelUpdateTensor, cTargetStates, mathBackend, nullptr);
+   const size_t cChunks = applyModelUpdateChunksContext.GetCountChunks();
+   EBM_ASSERT(1 <= cChunks);
+   if(1 == cChunks) {
+      // avoid the overhead of dispatching to the thread pool for small datasets
+      TrainingSetChunkTask<countCompilerClassificationTargetStates>(&applyModelUpdateChunksContext, 0);
+   } else {
+      ExecuteParallel(cChunks, &TrainingSetChunkTask<countCompilerClassificationTargetStates>, &applyModelUpdateChunksContext);
+   }
+}
+
+// returns the sum of the squared errors (regression) or sum of the log loss (classification).  aCaseLosses holds the losses of one wave of chunks, so
+// cCaseLosses is either every case, or a whole number of chunks
+template<ptrdiff_t countCompilerClassificationTargetStates>
+static FractionalDataType ApplyModelUpdateValidationSet(const AttributeCombinationCore * const pAttributeCombination, DataSetAttributeCombination * const pValidationSet, const FractionalDataType * const aModelUpdateTensor, const size_t cTargetStates, const MathBackendCore mathBackend, FractionalDataType * const aCaseLosses, const size_t cCaseLosses) {
+   const size_t cCasesPerChunk = k_cCasesPerApplyModelUpdateChunk;
+   const size_t cCases = pValidationSet->GetCountCases();
+   const size_t cChunks = (cCases + cCasesPerChunk - 1) / cCasesPerChunk;
+   EBM_ASSERT(1 <= cChunks);
+   EBM_ASSERT(nullptr != aCaseLosses);
+   EBM_ASSERT(cCases == cCaseLosses || (cCaseLosses < cCases && 0 == cCaseLosses % cCasesPerChunk));
+
+   // the wave size comes from our buffer rather than the current thread count, which can change after we allocate the buffer.  The wave size only decides
+   // how many losses we buffer, and never the order that we add them in, so it's safe for it to depend on the number of threads
+   const size_t cChunksPerWave = (cCaseLosses + cCasesPerChunk - 1) / cCasesPerChunk;
+   EBM_ASSERT(1 <= cChunksPerWave && cChunksPerWave <= cChunks);
+   ApplyModelUpdateChunksContext applyModelUpdateChunksContext(pAttributeCombination, pValidationSet, aModelUpdateTensor, cTargetStates, mathBackend, aCaseLosses);
+   EBM_ASSERT(cChunks == applyModelUpdateChunksContext.GetCountChunks());
+
+   FractionalDataType sum = 0;
+   size_t iChunkFirst = 0;
+   do {
+      const size_t cChunksInWave = cChunks - iChunkFirst < cChunksPerWave ? cChunks - iChunkFirst : cChunksPerWave;
+      applyModelUpdateChunksContext.m_iChunkFirst = iChunkFirst;
+      if(1 == cChunksInWave) {
+         // avoid the overhead of dispatching to the thread pool for small datasets
+         ValidationSetChunkTask<countCompilerClassificationTargetStates>(&applyModelUpdateChunksContext, 0);
+      } else {
+         ExecuteParallel(cChunksInWave, &ValidationSetChunkTask<countCompilerClassificationTargetStates>, &applyModelUpdateChunksContext);
+      }
+      const size_t iCaseFirst = applyModelUpdateChunksContext.GetCaseStart(iChunkFirst);
+      iChunkFirst += cChunksInWave;
+      const size_t cCasesInWave = applyModelUpdateChunksContext.GetCaseStart(iChunkFirst - 1) + applyModelUpdateChunksContext.GetCountCasesInChunk(iChunkFirst - 1) - iCaseFirst;
+      // add in case order, which gives exactly the sum that a single loop over every case would, regardless of which threads ran the chunks
+      for(size_t iCase = 0; iCase < cCasesInWave; ++iCase) {
+         sum += aCaseLosses[iCase];
+      }
+   } while(iChunkFirst < cChunks);
+   return sum;
 }
 
 // a*PredictionScores = logOdds for binary classification
@@ -1277,14 +2186,31 @@ static IntegerDataType ApplyModelUpdatePerTargetStates(TmlState * const pTmlStat
    EBM_ASSERT(nullptr != pTmlState->m_apBestModel); // m_apCurrentModel can be null if there are no attributeCombinations (but we have an attribute combination index), or if the target has 1 or 0 states (which we check before calling this function), so it shouldn't be possible to be null
    EBM_ASSERT(nullptr != aModelUpdateTensor); // aModelUpdateTensor is checked for nullptr before calling this function   
 
-   pTmlState->m_apCurrentModel[iAttributeCombination]->AddExpanded(aModelUpdateTensor);
-
    const AttributeCombinationCore * const pAttributeCombination = pTmlState->m_apAttributeCombinations[iAttributeCombination];
 
+   // everything that can fail happens before we change anything, so a failed call leaves our models, residuals and prediction scores as they were.  A NaN
+   // or infinite update would poison every prediction that touches it, and we couldn't take it back out of the model, so we reject those
+   size_t cItems = GetVectorLengthFlatCore(pTmlState->m_cTargetStates);
+   for(size_t iDimension = 0; iDimension < pAttributeCombination->m_cAttributes; ++iDimension) {
+      // we've allocated this memory already, so multiplying these together can't overflow
+      cItems *= pAttributeCombination->m_AttributeCombinationEntry[iDimension].m_pAttribute->m_cStates;
+   }
+   for(size_t iItem = 0; iItem < cItems; ++iItem) {
+      if(UNLIKELY(std::isnan(aModelUpdateTensor[iItem]) || std::isinf(aModelUpdateTensor[iItem]))) {
+         if(nullptr != pValidationMetricReturn) {
+            *pValidationMetricReturn = 0; // on error set it to something instead of random bits
+         }
+         LOG(TraceLevelWarning, "WARNING ApplyModelUpdatePerTargetStates aModelUpdateTensor has a NaN or infinite value");
+         return 1;
+      }
+   }
+
+   pTmlState->m_apCurrentModel[iAttributeCombination]->AddExpanded(aModelUpdateTensor);
+
    // if the count of training cases is zero, then pTmlState->m_pTrainingSet will be nullptr
    if(nullptr != pTmlState->m_pTrainingSet) {
       // TODO : move the target bits branch inside TrainingSetInputAttributeLoop to here outside instead of the attribute combination.  The target # of bits is extremely predictable and so we get to only process one sub branch of code below that.  If we do attribute combinations here then we have to keep in instruction cache a whole bunch of options
-      TrainingSetInputAttributeLoop<1, countCompilerClassificationTargetStates>(pAttributeCombination, pTmlState->m_pTrainingSet, aModelUpdateTensor, pTmlState->m_cTargetStates);
+      ApplyModelUpdateTrainingSet<countCompilerClassificationTargetStates>(pAttributeCombination, pTmlState->m_pTrainingSet, aModelUpdateTensor, pTmlState->m_cTargetStates, pTmlState->m_mathBackend);
    }
 
    FractionalDataType modelMetric = 0;
@@ -1301,7 +2227,13 @@ static IntegerDataType ApplyModelUpdatePerTargetStates(TmlState * const pTmlStat
 
       // TODO : move the target bits branch inside TrainingSetInputAttributeLoop to here outside instead of the attribute combination.  The target # of bits is extremely predictable and so we get to only process one sub branch of code below that.  If we do attribute combinations here then we have to keep in instruction cache a whole bunch of options
 
-      modelMetric = ValidationSetInputAttributeLoop<1, countCompilerClassificationTargetStates>(pAttributeCombination, pTmlState->m_pValidationSet, aModelUpdateTensor, pTmlState->m_cTargetStates);
+      const FractionalDataType sumValidation = ApplyModelUpdateValidationSet<countCompilerClassificationTargetStates>(pAttributeCombination, pTmlState->m_pValidationSet, aModelUpdateTensor, pTmlState->m_cTargetStates, pTmlState->m_mathBackend, pTmlState->m_aValidationCaseLosses, pTmlState->m_cValidationCaseLosses);
+      if(IsRegression(countCompilerClassificationTargetStates)) {
+         // the chunks return the sum of the squared errors, so convert it to the root mean squared error here
+         modelMetric = sqrt(sumValidation / pTmlState->m_pValidationSet->GetCountCases());
+      } else {
+         modelMetric = sumValidation;
+      }
 
       // modelMetric is either logloss (classification) or rmse (regression).  In either case we want to minimize it.
       if(LIKELY(modelMetric < pTmlState->m_bestModelMetric)) {
@@ -1312,13 +2244,11 @@ static IntegerDataType ApplyModelUpdatePerTargetStates(TmlState * const pTmlStat
          size_t iModel = 0;
          size_t iModelEnd = pTmlState->m_cAttributeCombinations;
          do {
-            if(pTmlState->m_apBestModel[iModel]->Copy(*pTmlState->m_apCurrentModel[iModel])) {
-               if(nullptr != pValidationMetricReturn) {
-                  *pValidationMetricReturn = 0; // on error set it to something instead of random bits
-               }
-               LOG(TraceLevelVerbose, "Exited ApplyModelUpdatePerTargetStates with memory allocation error in copy");
-               return 1;
-            }
+            // our current and best models were both expanded to their full size when we allocated them, so copying one into the other never grows the best
+            // model and can't fail
+            const bool bCopyError = pTmlState->m_apBestModel[iModel]->Copy(*pTmlState->m_apCurrentModel[iModel]);
+            EBM_ASSERT(!bCopyError);
+            UNUSED(bCopyError);
             ++iModel;
          } while(iModel != iModelEnd);
       }
@@ -1438,6 +2368,82 @@ EBMCORE_IMPORT_EXPORT IntegerDataType EBMCORE_CALLING_CONVENTION TrainingStep(PE
    return ApplyModelUpdate(ebmTraining, indexAttributeCombination, pModelUpdateTensor, validationMetricReturn);
 }
 
+EBMCORE_IMPORT_EXPORT IntegerDataType EBMCORE_CALLING_CONVENTION RunCyclicBoosting(PEbmTraining ebmTraining, IntegerDataType countRounds, FractionalDataType learningRate, IntegerDataType countTreeSplitsMax, IntegerDataType countCasesRequiredForSplitParentMin, FractionalDataType earlyStoppingTolerance, IntegerDataType earlyStoppingRunLength, FractionalDataType * validationMetricReturn, IntegerDataType * countRoundsRunReturn) {
+   LOG(TraceLevelInfo, "Entered RunCyclicBoosting: ebmTraining=%p, countRounds=%" IntegerDataTypePrintf ", learningRate=%" FractionalDataTypePrintf ", countTreeSplitsMax=%" IntegerDataTypePrintf ", countCasesRequiredForSplitParentMin=%" IntegerDataTypePrintf ", earlyStoppingTolerance=%" FractionalDataTypePrintf ", earlyStoppingRunLength=%" IntegerDataTypePrintf ", validationMetricReturn=%p, countRoundsRunReturn=%p", static_cast<void *>(ebmTraining), countRounds, learningRate, countTreeSplitsMax, countCasesRequiredForSplitParentMin, earlyStoppingTolerance, earlyStoppingRunLength, static_cast<void *>(validationMetricReturn), static_cast<void *>(countRoundsRunReturn));
+
+   TmlState * pTmlState = reinterpret_cast<TmlState *>(ebmTraining);
+   EBM_ASSERT(nullptr != pTmlState);
+   EBM_ASSERT(0 <= countRounds);
+   EBM_ASSERT(!std::isnan(earlyStoppingTolerance));
+   // earlyStoppingRunLength can be negative, which disables early stopping
+
+   // a cancel only stops the call that it interrupts, so clear any cancel left over from an earlier call, which would otherwise stop every call after it
+   pTmlState->m_bCancelled.store(false, std::memory_order_relaxed);
+
+   // this is the same early stopping logic that our python caller used to do after each round.  We take the metric after the last attribute combination in each round and compare
+   // it against the metric that we had when the current run of non-improving rounds started.  If we don't beat that by earlyStoppingTolerance for earlyStoppingRunLength rounds, we stop.
+   // If we don't get to run any training step, then there is no metric to report, and like TrainingStep without a validation set we return 0
+   FractionalDataType currentMetric = 0;
+   FractionalDataType minMetric = std::numeric_limits<FractionalDataType>::infinity();
+   FractionalDataType runStartMetric = std::numeric_limits<FractionalDataType>::infinity();
+   IntegerDataType countNoChangeRunLength = 0;
+   IntegerDataType countRoundsRun = 0;
+   IntegerDataType ret = 0;
+
+   const IntegerDataType countAttributeCombinations = static_cast<IntegerDataType>(pTmlState->m_cAttributeCombinations);
+   if(0 == countAttributeCombinations) {
+      // there's nothing to train and our metric will never change, so don't bother running any rounds
+      LOG(TraceLevelWarning, "WARNING RunCyclicBoosting 0 == countAttributeCombinations");
+      currentMetric = 0;
+   } else {
+      while(countRoundsRun < countRounds) {
+         // check for cancellation once per attribute combination, since a single round can take a long time on large datasets with many attribute combinations
+         for(IntegerDataType indexAttributeCombination = 0; indexAttributeCombination < countAttributeCombinations; ++indexAttributeCombination) {
+            if(pTmlState->m_bCancelled.load(std::memory_order_relaxed)) {
+               LOG(TraceLevelInfo, "RunCyclicBoosting cancelled");
+               ret = RunCyclicBoostingCancelled;
+               goto exit_rounds;
+            }
+            if(0 != TrainingStep(ebmTraining, indexAttributeCombination, learningRate, countTreeSplitsMax, countCasesRequiredForSplitParentMin, nullptr, nullptr, &currentMetric)) {
+               LOG(TraceLevelWarning, "WARNING RunCyclicBoosting TrainingStep returned error");
+               if(nullptr != validationMetricReturn) {
+                  *validationMetricReturn = 0; // on error set it to something instead of random bits
+               }
+               if(nullptr != countRoundsRunReturn) {
+                  *countRoundsRunReturn = countRoundsRun;
+               }
+               return 1;
+            }
+         }
+         ++countRoundsRun;
+
+         minMetric = currentMetric < minMetric ? currentMetric : minMetric;
+         if(0 == countNoChangeRunLength) {
+            runStartMetric = minMetric;
+         }
+         if(currentMetric + earlyStoppingTolerance < runStartMetric) {
+            countNoChangeRunLength = 0;
+         } else {
+            ++countNoChangeRunLength;
+         }
+         if(0 <= earlyStoppingRunLength && earlyStoppingRunLength <= countNoChangeRunLength) {
+            LOG(TraceLevelInfo, "RunCyclicBoosting early stopping after %" IntegerDataTypePrintf " rounds", countRoundsRun);
+            break;
+         }
+      }
+   }
+exit_rounds:;
+
+   if(nullptr != validationMetricReturn) {
+      *validationMetricReturn = currentMetric;
+   }
+   if(nullptr != countRoundsRunReturn) {
+      *countRoundsRunReturn = countRoundsRun;
+   }
+   LOG(TraceLevelInfo, "Exited RunCyclicBoosting %" IntegerDataTypePrintf " rounds, %" FractionalDataTypePrintf ", %" IntegerDataTypePrintf, countRoundsRun, currentMetric, ret);
+   return ret;
+}
+
 EBMCORE_IMPORT_EXPORT FractionalDataType * EBMCORE_CALLING_CONVENTION GetCurrentModel(PEbmTraining ebmTraining, IntegerDataType indexAttributeCombination) {
    LOG(TraceLevelInfo, "Entered GetCurrentModel: ebmTraining=%p, indexAttributeCombination=%" IntegerDataTypePrintf, static_cast<void *>(ebmTraining), indexAttributeCombination);
 
@@ -1492,7 +2498,11 @@ EBMCORE_IMPORT_EXPORT FractionalDataType * EBMCORE_CALLING_CONVENTION GetBestMod
 
 EBMCORE_IMPORT_EXPORT void EBMCORE_CALLING_CONVENTION CancelTraining(PEbmTraining ebmTraining) {
    LOG(TraceLevelInfo, "Entered CancelTraining: ebmTraining=%p", static_cast<void *>(ebmTraining));
-   EBM_ASSERT(nullptr != ebmTraining);
+   TmlState * pTmlState = reinterpret_cast<TmlState *>(ebmTraining);
+   EBM_ASSERT(nullptr != pTmlState);
+   // RunCyclicBoosting checks this between training steps, so any step in progress will complete before it returns.  If RunCyclicBoosting isn't running then
+   // this has no effect, since RunCyclicBoosting clears it when it starts
+   pTmlState->m_bCancelled.store(true, std::memory_order_relaxed);
    LOG(TraceLevelInfo, "Exited CancelTraining");
 }
 
@@ -1503,3 +2513,93 @@ EBMCORE_IMPORT_EXPORT void EBMCORE_CALLING_CONVENTION FreeTraining(PEbmTraining
    delete pTmlState;
    LOG(TraceLevelInfo, "Exited FreeTraining");
 }
+
+EBMCORE_IMPORT_EXPORT IntegerDataType EBMCORE_CALLING_CONVENTION GetMemoryUsage(PEbmTraining ebmTraining, EbmMemoryUsage * memoryUsageOut) {
+   LOG(TraceLevelInfo, "Entered GetMemoryUsage: ebmTraining=%p, memoryUsageOut=%p", static_cast<void *>(ebmTraining), static_cast<void *>(memoryUsageOut));
+   const TmlState * const pTmlState = reinterpret_cast<const TmlState *>(ebmTraining);
+   EBM_ASSERT(nullptr != pTmlState);
+   if(nullptr == memoryUsageOut) {
+      LOG(TraceLevelWarning, "WARNING GetMemoryUsage nullptr == memoryUsageOut");
+      return 1;
+   }
+   pTmlState->GetMemoryUsage(memoryUsageOut);
+   LOG(TraceLevelInfo, "Exited GetMemoryUsage %" IntegerDataTypePrintf, memoryUsageOut->currentBytes);
+   return 0;
+}
+
+static IntegerDataType EstimateTrainingMemoryCore(bool bRegression, IntegerDataType countAttributes, const EbmAttribute * attributes, IntegerDataType countAttributeCombinations, const EbmAttributeCombination * attributeCombinations, const IntegerDataType * attributeCombinationIndexes, IntegerDataType countTargetStates, IntegerDataType countTrainingCases, IntegerDataType countValidationCases, IntegerDataType countInnerBags, IntegerDataType trainingOptions, EbmMemoryUsage * memoryUsageOut) {
+   EBM_ASSERT(0 <= countAttributes);
+   EBM_ASSERT(0 == countAttributes || nullptr != attributes);
+   EBM_ASSERT(0 <= countAttributeCombinations);
+   EBM_ASSERT(0 == countAttributeCombinations || nullptr != attributeCombinations);
+   EBM_ASSERT(0 <= countTrainingCases);
+   EBM_ASSERT(0 <= countValidationCases);
+   EBM_ASSERT(0 <= countInnerBags);
+
+   if(nullptr == memoryUsageOut) {
+      LOG(TraceLevelWarning, "WARNING EstimateTrainingMemoryCore nullptr == memoryUsageOut");
+      return 1;
+   }
+   if(!IsNumberConvertable<size_t, IntegerDataType>(countAttributes)) {
+      LOG(TraceLevelWarning, "WARNING EstimateTrainingMemoryCore !IsNumberConvertable<size_t, IntegerDataType>(countAttributes)");
+      return 1;
+   }
+   if(!IsNumberConvertable<size_t, IntegerDataType>(countAttributeCombinations)) {
+      LOG(TraceLevelWarning, "WARNING EstimateTrainingMemoryCore !IsNumberConvertable<size_t, IntegerDataType>(countAttributeCombinations)");
+      return 1;
+   }
+   if(!IsNumberConvertable<size_t, IntegerDataType>(countTargetStates)) {
+      LOG(TraceLevelWarning, "WARNING EstimateTrainingMemoryCore !IsNumberConvertable<size_t, IntegerDataType>(countTargetStates)");
+      return 1;
+   }
+   if(!IsNumberConvertable<size_t, IntegerDataType>(countTrainingCases)) {
+      LOG(TraceLevelWarning, "WARNING EstimateTrainingMemoryCore !IsNumberConvertable<size_t, IntegerDataType>(countTrainingCases)");
+      return 1;
+   }
+   if(!IsNumberConvertable<size_t, IntegerDataType>(countValidationCases)) {
+      LOG(TraceLevelWarning, "WARNING EstimateTrainingMemoryCore !IsNumberConvertable<size_t, IntegerDataType>(countValidationCases)");
+      return 1;
+   }
+   if(!IsNumberConvertable<size_t, IntegerDataType>(countInnerBags)) {
+      LOG(TraceLevelWarning, "WARNING EstimateTrainingMemoryCore !IsNumberConvertable<size_t, IntegerDataType>(countInnerBags)");
+      return 1;
+   }
+   if(0 != (trainingOptions & ~k_trainingOptionsKnown)) {
+      LOG(TraceLevelWarning, "WARNING EstimateTrainingMemoryCore unknown trainingOptions");
+      return 1;
+   }
+
+   const bool bSinglePrecision = 0 != (trainingOptions & TrainingOptionsSinglePrecision);
+   const bool bSamplingWithoutReplacement = 0 != (trainingOptions & TrainingOptionsSamplingWithoutReplacement);
+   const ArenaBackingCore arenaBacking = GetArenaBacking(trainingOptions);
+   const MathBackendCore mathBackend = GetMathBackend(trainingOptions);
+
+   // we build the same state that AllocateCore would, but we stop after unpacking the attribute combinations, which is only a small amount of metadata
+   TmlState * const pTmlState = new (std::nothrow) TmlState(bRegression, static_cast<size_t>(countTargetStates), bSinglePrecision, bSamplingWithoutReplacement, arenaBacking, mathBackend, static_cast<size_t>(countAttributes), static_cast<size_t>(countAttributeCombinations), static_cast<size_t>(countInnerBags));
+   if(UNLIKELY(nullptr == pTmlState)) {
+      LOG(TraceLevelWarning, "WARNING EstimateTrainingMemoryCore nullptr == pTmlState");
+      return 1;
+   }
+   if(UNLIKELY(pTmlState->InitializeAttributes(attributes, attributeCombinations, attributeCombinationIndexes))) {
+      LOG(TraceLevelWarning, "WARNING EstimateTrainingMemoryCore pTmlState->InitializeAttributes");
+      delete pTmlState;
+      return 1;
+   }
+   pTmlState->EstimateMemoryUsage(static_cast<size_t>(countTrainingCases), static_cast<size_t>(countValidationCases), memoryUsageOut);
+   delete pTmlState;
+   return 0;
+}
+
+EBMCORE_IMPORT_EXPORT IntegerDataType EBMCORE_CALLING_CONVENTION EstimateTrainingRegressionMemory(IntegerDataType countAttributes, const EbmAttribute * attributes, IntegerDataType countAttributeCombinations, const EbmAttributeCombination * attributeCombinations, const IntegerDataType * attributeCombinationIndexes, IntegerDataType countTrainingCases, IntegerDataType countValidationCases, IntegerDataType countInnerBags, IntegerDataType trainingOptions, EbmMemoryUsage * memoryUsageOut) {
+   LOG(TraceLevelInfo, "Entered EstimateTrainingRegressionMemory: countAttributes=%" IntegerDataTypePrintf ", attributes=%p, countAttributeCombinations=%" IntegerDataTypePrintf ", attributeCombinations=%p, attributeCombinationIndexes=%p, countTrainingCases=%" IntegerDataTypePrintf ", countValidationCases=%" IntegerDataTypePrintf ", countInnerBags=%" IntegerDataTypePrintf ", trainingOptions=%" IntegerDataTypePrintf ", memoryUsageOut=%p", countAttributes, static_cast<const void *>(attributes), countAttributeCombinations, static_cast<const void *>(attributeCombinations), static_cast<const void *>(attributeCombinationIndexes), countTrainingCases, countValidationCases, countInnerBags, trainingOptions, static_cast<void *>(memoryUsageOut));
+   const IntegerDataType ret = EstimateTrainingMemoryCore(true, countAttributes, attributes, countAttributeCombinations, attributeCombinations, attributeCombinationIndexes, 0, countTrainingCases, countValidationCases, countInnerBags, trainingOptions, memoryUsageOut);
+   LOG(TraceLevelInfo, "Exited EstimateTrainingRegressionMemory %" IntegerDataTypePrintf, ret);
+   return ret;
+}
+
+EBMCORE_IMPORT_EXPORT IntegerDataType EBMCORE_CALLING_CONVENTION EstimateTrainingClassificationMemory(IntegerDataType countAttributes, const EbmAttribute * attributes, IntegerDataType countAttributeCombinations, const EbmAttributeCombination * attributeCombinations, const IntegerDataType * attributeCombinationIndexes, IntegerDataType countTargetStates, IntegerDataType countTrainingCases, IntegerDataType countValidationCases, IntegerDataType countInnerBags, IntegerDataType trainingOptions, EbmMemoryUsage * memoryUsageOut) {
+   LOG(TraceLevelInfo, "Entered EstimateTrainingClassificationMemory: countAttributes=%" IntegerDataTypePrintf ", attributes=%p, countAttributeCombinations=%" IntegerDataTypePrintf ", attributeCombinations=%p, attributeCombinationIndexes=%p, countTargetStates=%" IntegerDataTypePrintf ", countTrainingCases=%" IntegerDataTypePrintf ", countValidationCases=%" IntegerDataTypePrintf ", countInnerBags=%" IntegerDataTypePrintf ", trainingOptions=%" IntegerDataTypePrintf ", memoryUsageOut=%p", countAttributes, static_cast<const void *>(attributes), countAttributeCombinations, static_cast<const void *>(attributeCombinations), static_cast<const void *>(attributeCombinationIndexes), countTargetStates, countTrainingCases, countValidationCases, countInnerBags, trainingOptions, static_cast<void *>(memoryUsageOut));
+   const IntegerDataType ret = EstimateTrainingMemoryCore(false, countAttributes, attributes, countAttributeCombinations, attributeCombinations, attributeCombinationIndexes, countTargetStates, countTrainingCases, countValidationCases, countInnerBags, trainingOptions, memoryUsageOut);
+   LOG(TraceLevelInfo, "Exited EstimateTrainingClassificationMemory %" IntegerDataTypePrintf, ret);
+   return ret;
+}
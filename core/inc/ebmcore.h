@@ -54,6 +54,14 @@ typedef struct {
    // this struct is to enforce that our caller doesn't mix EbmTraining and EbmInteraction pointers.  In C/C++ languages the caller will get an error if they try to mix these pointer types.
    char unused;
 } *PEbmInteraction;
+typedef struct {
+   // this struct is to enforce that our caller doesn't mix EbmTrainingThreadState pointers with EbmTraining or EbmInteraction pointers.  In C/C++ languages the caller will get an error if they try to mix these pointer types.
+   char unused;
+} *PEbmTrainingThreadState;
+typedef struct {
+   // this struct is to enforce that our caller doesn't mix EbmDataSet pointers with EbmTraining or EbmInteraction pointers.  In C/C++ languages the caller will get an error if they try to mix these pointer types.
+   char unused;
+} *PEbmDataSet;
 
 typedef double FractionalDataType;
 #define FractionalDataTypePrintf "f"
@@ -63,6 +71,28 @@ typedef int64_t IntegerDataType;
 const IntegerDataType AttributeTypeOrdinal = 0;
 const IntegerDataType AttributeTypeNominal = 1;
 
+// trainingOptions for the InitializeTraining* functions that take them.  These are bit flags that can be combined with a bitwise OR
+const IntegerDataType TrainingOptionsNone = 0;
+// store the per-case residuals and prediction scores as 32 bit floats, which halves the memory we stream through when training.  Histogram sums,
+// model updates and the models themselves are still calculated and returned as FractionalDataType
+const IntegerDataType TrainingOptionsSinglePrecision = 1;
+// draw each inner bag as a subsample of half the training cases without replacement instead of a bootstrap sample.  Each bag is stored as a single bit
+// per case instead of a count per case.  This has no effect if countInnerBags is 0, since we then train on all the training cases.  The rate is fixed
+// at half and can't currently be chosen by the caller.  A caller that needs a different rate can pass its own sampled cases as the training set
+const IntegerDataType TrainingOptionsSamplingWithoutReplacement = 2;
+// on linux, ask the kernel to back the training and validation datasets with transparent huge pages when they are large enough.  This is only a hint,
+// and it is ignored on other platforms or if transparent huge pages are disabled
+const IntegerDataType TrainingOptionsHugePages = 4;
+// keeps the packed data, residuals, prediction scores and targets of the training and validation sets in temporary files that are mapped into memory instead
+// of in RAM, so we can train on datasets that don't fit in memory.  Passes over the data read the files block by block with read ahead, while our
+// histograms and models stay in memory.  The results are identical to training in memory.  The files go in TMPDIR (or /tmp) on posix and
+// in the user's temp directory on Windows, and are deleted when training is freed
+const IntegerDataType TrainingOptionsOutOfCore = 8;
+// calculate the classification residuals and validation log loss with polynomial approximations of exp and log that have no branches and vectorize, instead
+// of with the C library's exp and log.  Their relative error is below 1e-9, which changes the model very slightly, and the validation metric by far less
+// than the differences that early stopping looks at.  Regression doesn't use exp or log, so this has no effect on it
+const IntegerDataType TrainingOptionsFastMath = 16;
+
 typedef struct {
    IntegerDataType attributeType;
    IntegerDataType hasMissing;
@@ -73,6 +103,44 @@ typedef struct {
    IntegerDataType countAttributesInCombination;
 } EbmAttributeCombination;
 
+// dataType values for EbmDataColumn.  Binned attribute values can be passed in any of these widths, and are read directly out of the caller's memory
+// instead of first being widened into an IntegerDataType matrix
+const IntegerDataType DataColumnTypeInt64 = 0;
+const IntegerDataType DataColumnTypeUInt8 = 1;
+const IntegerDataType DataColumnTypeUInt16 = 2;
+const IntegerDataType DataColumnTypeUInt32 = 3;
+
+typedef struct {
+   // points to the binned value of the first case.  Values do not need to be aligned
+   const void * data;
+   IntegerDataType dataType;
+   // distance in bytes from the value of one case to the value of the next case.  For a column in a Fortran ordered matrix this is the size of the
+   // element type, and for a column in a C ordered matrix this is the size of the element type multiplied by the number of columns in the matrix
+   IntegerDataType strideBytes;
+} EbmDataColumn;
+
+// bytes held by a training state, split by what holds them.  Buffers are counted at their allocated capacity, not at the part currently in use.  With
+// TrainingOptionsOutOfCore the packedDataBytes and residualBytes (except the validation losses) are held in temporary files, and only the blocks being
+// streamed through are in RAM
+typedef struct {
+   // binned attribute data packed for each attribute combination, for both the training and validation sets
+   IntegerDataType packedDataBytes;
+   // residual errors, prediction scores and targets for both the training and validation sets, plus the losses of the validation cases being scored
+   IntegerDataType residualBytes;
+   // case counts of each inner bag
+   IntegerDataType samplingSetBytes;
+   // histograms, tree nodes and per partition histograms that we grow while binning
+   IntegerDataType histogramBufferBytes;
+   // the current and best models plus the scratch space where we build model updates
+   IntegerDataType modelBytes;
+   // attributes, attribute combinations and fixed size bookkeeping
+   IntegerDataType otherBytes;
+   // the sum of all the above
+   IntegerDataType currentBytes;
+   // the largest currentBytes seen at the end of any call that can allocate
+   IntegerDataType peakBytes;
+} EbmMemoryUsage;
+
 const signed char TraceLevelOff = 0; // no messages will be output.  SetLogMessageFunction doesn't need to be called if the level is left at this value
 const signed char TraceLevelError = 1;
 const signed char TraceLevelWarning = 2;
@@ -84,6 +152,26 @@ typedef void (EBMCORE_CALLING_CONVENTION * LOG_MESSAGE_FUNCTION)(signed char tra
 
 EBMCORE_IMPORT_EXPORT void EBMCORE_CALLING_CONVENTION SetLogMessageFunction(LOG_MESSAGE_FUNCTION logMessageFunction);
 EBMCORE_IMPORT_EXPORT void EBMCORE_CALLING_CONVENTION SetTraceLevel(signed char traceLevel);
+// training sets of 65536 or more cases can be binned in fixed partitions whose histograms are then added together, depending on the histogram size.  That
+// is a different order of addition than older releases used, so models trained on those datasets can differ in the last bits from older releases.  The
+// partitions don't depend on the number of threads, so results are identical for every SetThreadCount, including a single thread.
+// SetThreadCount and SetThreadAffinity restart our worker threads, so they return an error instead of reconfiguring if they're called from one of our worker
+// threads or from inside work that we're running in parallel, which can happen through the function passed to SetLogMessageFunction
+EBMCORE_IMPORT_EXPORT IntegerDataType EBMCORE_CALLING_CONVENTION SetThreadCount(IntegerDataType countThreads);
+EBMCORE_IMPORT_EXPORT IntegerDataType EBMCORE_CALLING_CONVENTION SetThreadAffinity(IntegerDataType countCpus, const IntegerDataType * cpuIndexes);
+
+// we compile our hot loops for several instruction sets and use the widest one that the processor supports.  SetSimdLevel limits us to a narrower
+// one for benchmarking, and setting SimdLevelAvx512 goes back to the widest supported.  The EBM_SIMD_LEVEL environment variable ("scalar", "avx2" or
+// "avx512") does the same when we're loaded.  Regression gives identical results at every level.  Classification residuals and softmax
+// at the vectorized levels use our own exp, which can differ from the C library's by a few ULP, so classification models can differ in their last bits
+// between levels, including between processors that support different levels.  GetSimdLevel returns the level in use, which can be lower than the one
+// requested if the processor doesn't support it
+const IntegerDataType SimdLevelScalar = 0;
+const IntegerDataType SimdLevelAvx2 = 1;
+const IntegerDataType SimdLevelAvx512 = 2;
+
+EBMCORE_IMPORT_EXPORT IntegerDataType EBMCORE_CALLING_CONVENTION SetSimdLevel(IntegerDataType simdLevel);
+EBMCORE_IMPORT_EXPORT IntegerDataType EBMCORE_CALLING_CONVENTION GetSimdLevel();
 
 // BINARY VS MULTICLASS AND LOGIT REDUCTION
 // - I initially considered storing our model files as negated logits [storing them as (0 - mathematical_logit)], but that's a bad choice because:
@@ -160,19 +248,68 @@ EBMCORE_IMPORT_EXPORT void EBMCORE_CALLING_CONVENTION SetTraceLevel(signed char
 //       - we'll probably want to have special categorical processing since each slice in a tensoor can be considered completely independently.  I don't see any reason to have intermediate versions where we have 3 missing / categorical values and 4 ordinal values
 //       - if missing is in the 0th bin, we can do any cuts at the beginning of processing a range, and that means any cut in the model would be the first, so we can initialze it by writing the cut model directly without bothering to handle inserting into the tree at the end
 
+// an EbmDataSet holds one copy of binned attribute data that can be shared between any number of training and interaction states.  Each state that
+// uses the dataset holds its own reference, so FreeDataSet can be called as soon as the caller has finished creating states from it
+EBMCORE_IMPORT_EXPORT PEbmDataSet EBMCORE_CALLING_CONVENTION InitializeDataSet(IntegerDataType countAttributes, const EbmAttribute * attributes, IntegerDataType countCases, const EbmDataColumn * columns);
+EBMCORE_IMPORT_EXPORT void EBMCORE_CALLING_CONVENTION FreeDataSet(PEbmDataSet ebmDataSet);
+// writes the binned data of a dataset to a versioned binary file, returning 0 on success.  LoadDataSet maps that file read-only instead of reading it, so
+// worker processes on the same host share one page cache copy and don't re-bin anything.  filePath is a UTF-8 path on posix and an ANSI path on Windows.
+// The file holds unpacked bins and no targets, so training states created from a loaded dataset still pack their attribute combinations when they are
+// initialized.  LoadDataSet returns nullptr if any attribute in the file is invalid, or if any bin is not below its attribute's countStates
+EBMCORE_IMPORT_EXPORT IntegerDataType EBMCORE_CALLING_CONVENTION SaveDataSet(PEbmDataSet ebmDataSet, const char * filePath);
+EBMCORE_IMPORT_EXPORT PEbmDataSet EBMCORE_CALLING_CONVENTION LoadDataSet(const char * filePath);
+
 EBMCORE_IMPORT_EXPORT PEbmTraining EBMCORE_CALLING_CONVENTION InitializeTrainingRegression(IntegerDataType randomSeed, IntegerDataType countAttributes, const EbmAttribute * attributes, IntegerDataType countAttributeCombinations, const EbmAttributeCombination * attributeCombinations, const IntegerDataType * attributeCombinationIndexes, IntegerDataType countTrainingCases, const FractionalDataType * trainingTargets, const IntegerDataType * trainingData, const FractionalDataType * trainingPredictionScores, IntegerDataType countValidationCases, const FractionalDataType * validationTargets, const IntegerDataType * validationData, const FractionalDataType * validationPredictionScores, IntegerDataType countInnerBags);
 EBMCORE_IMPORT_EXPORT PEbmTraining EBMCORE_CALLING_CONVENTION InitializeTrainingClassification(IntegerDataType randomSeed, IntegerDataType countAttributes, const EbmAttribute * attributes, IntegerDataType countAttributeCombinations, const EbmAttributeCombination * attributeCombinations, const IntegerDataType * attributeCombinationIndexes, IntegerDataType countTargetStates, IntegerDataType countTrainingCases, const IntegerDataType * trainingTargets, const IntegerDataType * trainingData, const FractionalDataType * trainingPredictionScores, IntegerDataType countValidationCases, const IntegerDataType * validationTargets, const IntegerDataType * validationData, const FractionalDataType * validationPredictionScores, IntegerDataType countInnerBags);
+// the *Ex variants are identical to the functions above, except that they take trainingOptions.  The functions above train with TrainingOptionsNone and
+// keep their original signatures so that existing callers don't need to be rebuilt
+EBMCORE_IMPORT_EXPORT PEbmTraining EBMCORE_CALLING_CONVENTION InitializeTrainingRegressionEx(IntegerDataType randomSeed, IntegerDataType countAttributes, const EbmAttribute * attributes, IntegerDataType countAttributeCombinations, const EbmAttributeCombination * attributeCombinations, const IntegerDataType * attributeCombinationIndexes, IntegerDataType countTrainingCases, const FractionalDataType * trainingTargets, const IntegerDataType * trainingData, const FractionalDataType * trainingPredictionScores, IntegerDataType countValidationCases, const FractionalDataType * validationTargets, const IntegerDataType * validationData, const FractionalDataType * validationPredictionScores, IntegerDataType countInnerBags, IntegerDataType trainingOptions);
+EBMCORE_IMPORT_EXPORT PEbmTraining EBMCORE_CALLING_CONVENTION InitializeTrainingClassificationEx(IntegerDataType randomSeed, IntegerDataType countAttributes, const EbmAttribute * attributes, IntegerDataType countAttributeCombinations, const EbmAttributeCombination * attributeCombinations, const IntegerDataType * attributeCombinationIndexes, IntegerDataType countTargetStates, IntegerDataType countTrainingCases, const IntegerDataType * trainingTargets, const IntegerDataType * trainingData, const FractionalDataType * trainingPredictionScores, IntegerDataType countValidationCases, const IntegerDataType * validationTargets, const IntegerDataType * validationData, const FractionalDataType * validationPredictionScores, IntegerDataType countInnerBags, IntegerDataType trainingOptions);
+// the *Columns variants are identical to the functions above, except that instead of a Fortran ordered IntegerDataType matrix they take one EbmDataColumn
+// per attribute (in the same order as the attributes array), which allows binned data to be passed as narrow integers straight from the caller's buffers
+EBMCORE_IMPORT_EXPORT PEbmTraining EBMCORE_CALLING_CONVENTION InitializeTrainingRegressionColumns(IntegerDataType randomSeed, IntegerDataType countAttributes, const EbmAttribute * attributes, IntegerDataType countAttributeCombinations, const EbmAttributeCombination * attributeCombinations, const IntegerDataType * attributeCombinationIndexes, IntegerDataType countTrainingCases, const FractionalDataType * trainingTargets, const EbmDataColumn * trainingColumns, const FractionalDataType * trainingPredictionScores, IntegerDataType countValidationCases, const FractionalDataType * validationTargets, const EbmDataColumn * validationColumns, const FractionalDataType * validationPredictionScores, IntegerDataType countInnerBags, IntegerDataType trainingOptions);
+EBMCORE_IMPORT_EXPORT PEbmTraining EBMCORE_CALLING_CONVENTION InitializeTrainingClassificationColumns(IntegerDataType randomSeed, IntegerDataType countAttributes, const EbmAttribute * attributes, IntegerDataType countAttributeCombinations, const EbmAttributeCombination * attributeCombinations, const IntegerDataType * attributeCombinationIndexes, IntegerDataType countTargetStates, IntegerDataType countTrainingCases, const IntegerDataType * trainingTargets, const EbmDataColumn * trainingColumns, const FractionalDataType * trainingPredictionScores, IntegerDataType countValidationCases, const IntegerDataType * validationTargets, const EbmDataColumn * validationColumns, const FractionalDataType * validationPredictionScores, IntegerDataType countInnerBags, IntegerDataType trainingOptions);
+// the *FromDataSets variants take their attributes and binned data from EbmDataSets.  The training and validation datasets must have identical attributes
+EBMCORE_IMPORT_EXPORT PEbmTraining EBMCORE_CALLING_CONVENTION InitializeTrainingRegressionFromDataSets(IntegerDataType randomSeed, IntegerDataType countAttributeCombinations, const EbmAttributeCombination * attributeCombinations, const IntegerDataType * attributeCombinationIndexes, const FractionalDataType * trainingTargets, PEbmDataSet trainingDataSet, const FractionalDataType * trainingPredictionScores, const FractionalDataType * validationTargets, PEbmDataSet validationDataSet, const FractionalDataType * validationPredictionScores, IntegerDataType countInnerBags, IntegerDataType trainingOptions);
+EBMCORE_IMPORT_EXPORT PEbmTraining EBMCORE_CALLING_CONVENTION InitializeTrainingClassificationFromDataSets(IntegerDataType randomSeed, IntegerDataType countAttributeCombinations, const EbmAttributeCombination * attributeCombinations, const IntegerDataType * attributeCombinationIndexes, IntegerDataType countTargetStates, const IntegerDataType * trainingTargets, PEbmDataSet trainingDataSet, const FractionalDataType * trainingPredictionScores, const IntegerDataType * validationTargets, PEbmDataSet validationDataSet, const FractionalDataType * validationPredictionScores, IntegerDataType countInnerBags, IntegerDataType trainingOptions);
 EBMCORE_IMPORT_EXPORT FractionalDataType * EBMCORE_CALLING_CONVENTION GenerateModelUpdate(PEbmTraining ebmTraining, IntegerDataType indexAttributeCombination, FractionalDataType learningRate, IntegerDataType countTreeSplitsMax, IntegerDataType countCasesRequiredForSplitParentMin, const FractionalDataType * trainingWeights, const FractionalDataType * validationWeights, FractionalDataType * gainReturn);
+EBMCORE_IMPORT_EXPORT PEbmTrainingThreadState EBMCORE_CALLING_CONVENTION AllocateTrainingThreadState(PEbmTraining ebmTraining);
+EBMCORE_IMPORT_EXPORT void EBMCORE_CALLING_CONVENTION FreeTrainingThreadState(PEbmTrainingThreadState ebmTrainingThreadState);
+EBMCORE_IMPORT_EXPORT IntegerDataType EBMCORE_CALLING_CONVENTION GenerateModelUpdateThreadSafe(PEbmTraining ebmTraining, PEbmTrainingThreadState ebmTrainingThreadState, IntegerDataType indexAttributeCombination, FractionalDataType learningRate, IntegerDataType countTreeSplitsMax, IntegerDataType countCasesRequiredForSplitParentMin, const FractionalDataType * trainingWeights, const FractionalDataType * validationWeights, FractionalDataType * gainReturn, FractionalDataType * modelUpdateTensorOut);
+// ApplyModelUpdate returns nonzero without changing the training state if the update has a NaN or infinite value
 EBMCORE_IMPORT_EXPORT IntegerDataType EBMCORE_CALLING_CONVENTION ApplyModelUpdate(PEbmTraining ebmTraining, IntegerDataType indexAttributeCombination, const FractionalDataType * modelUpdateTensor, FractionalDataType * validationMetricReturn);
 EBMCORE_IMPORT_EXPORT IntegerDataType EBMCORE_CALLING_CONVENTION TrainingStep(PEbmTraining ebmTraining, IntegerDataType indexAttributeCombination, FractionalDataType learningRate, IntegerDataType countTreeSplitsMax, IntegerDataType countCasesRequiredForSplitParentMin, const FractionalDataType * trainingWeights, const FractionalDataType * validationWeights, FractionalDataType * validationMetricReturn);
+// RunCyclicBoosting runs TrainingStep on every attribute combination in order for up to countRounds rounds, stopping early if the validation metric after a
+// round doesn't improve on the start of the current run of rounds by earlyStoppingTolerance for earlyStoppingRunLength rounds (negative disables this).  It
+// returns 0 when it finishes or stops early, and RunCyclicBoostingCancelled if CancelTraining stopped it.  Either way validationMetricReturn gets the metric of
+// the last training step it ran, or 0 if it didn't run any, and countRoundsRunReturn gets the number of complete rounds.  Other nonzero returns are errors.
+// CancelTraining can be called from any thread, and stops a running RunCyclicBoosting before its next training step.  It has no effect on later calls, since
+// RunCyclicBoosting clears any earlier cancel when it starts
+const IntegerDataType RunCyclicBoostingCancelled = 2;
+EBMCORE_IMPORT_EXPORT IntegerDataType EBMCORE_CALLING_CONVENTION RunCyclicBoosting(PEbmTraining ebmTraining, IntegerDataType countRounds, FractionalDataType learningRate, IntegerDataType countTreeSplitsMax, IntegerDataType countCasesRequiredForSplitParentMin, FractionalDataType earlyStoppingTolerance, IntegerDataType earlyStoppingRunLength, FractionalDataType * validationMetricReturn, IntegerDataType * countRoundsRunReturn);
 EBMCORE_IMPORT_EXPORT FractionalDataType * EBMCORE_CALLING_CONVENTION GetCurrentModel(PEbmTraining ebmTraining, IntegerDataType indexAttributeCombination);
 EBMCORE_IMPORT_EXPORT FractionalDataType * EBMCORE_CALLING_CONVENTION GetBestModel(PEbmTraining ebmTraining, IntegerDataType indexAttributeCombination);
 EBMCORE_IMPORT_EXPORT void EBMCORE_CALLING_CONVENTION CancelTraining(PEbmTraining ebmTraining);
 EBMCORE_IMPORT_EXPORT void EBMCORE_CALLING_CONVENTION FreeTraining(PEbmTraining ebmTraining);
+// fills memoryUsageOut with what ebmTraining holds now, returning 0 on success.  Thread states from AllocateTrainingThreadState belong to the caller and aren't included
+EBMCORE_IMPORT_EXPORT IntegerDataType EBMCORE_CALLING_CONVENTION GetMemoryUsage(PEbmTraining ebmTraining, EbmMemoryUsage * memoryUsageOut);
+// predicts what GetMemoryUsage would report after one boosting round over every attribute combination, without needing any data, returning 0 on success.
+// Everything except histogramBufferBytes and modelBytes is exact.  Those two depend on the splits found during training, so they are upper bounds
+EBMCORE_IMPORT_EXPORT IntegerDataType EBMCORE_CALLING_CONVENTION EstimateTrainingRegressionMemory(IntegerDataType countAttributes, const EbmAttribute * attributes, IntegerDataType countAttributeCombinations, const EbmAttributeCombination * attributeCombinations, const IntegerDataType * attributeCombinationIndexes, IntegerDataType countTrainingCases, IntegerDataType countValidationCases, IntegerDataType countInnerBags, IntegerDataType trainingOptions, EbmMemoryUsage * memoryUsageOut);
+EBMCORE_IMPORT_EXPORT IntegerDataType EBMCORE_CALLING_CONVENTION EstimateTrainingClassificationMemory(IntegerDataType countAttributes, const EbmAttribute * attributes, IntegerDataType countAttributeCombinations, const EbmAttributeCombination * attributeCombinations, const IntegerDataType * attributeCombinationIndexes, IntegerDataType countTargetStates, IntegerDataType countTrainingCases, IntegerDataType countValidationCases, IntegerDataType countInnerBags, IntegerDataType trainingOptions, EbmMemoryUsage * memoryUsageOut);
 
 EBMCORE_IMPORT_EXPORT PEbmInteraction EBMCORE_CALLING_CONVENTION InitializeInteractionRegression(IntegerDataType countAttributes, const EbmAttribute * attributes, IntegerDataType countCases, const FractionalDataType * targets, const IntegerDataType * data, const FractionalDataType * predictionScores);
 EBMCORE_IMPORT_EXPORT PEbmInteraction EBMCORE_CALLING_CONVENTION InitializeInteractionClassification(IntegerDataType countAttributes, const EbmAttribute * attributes, IntegerDataType countTargetStates, IntegerDataType countCases, const IntegerDataType * targets, const IntegerDataType * data, const FractionalDataType * predictionScores);
+EBMCORE_IMPORT_EXPORT PEbmInteraction EBMCORE_CALLING_CONVENTION InitializeInteractionRegressionColumns(IntegerDataType countAttributes, const EbmAttribute * attributes, IntegerDataType countCases, const FractionalDataType * targets, const EbmDataColumn * columns, const FractionalDataType * predictionScores);
+EBMCORE_IMPORT_EXPORT PEbmInteraction EBMCORE_CALLING_CONVENTION InitializeInteractionClassificationColumns(IntegerDataType countAttributes, const EbmAttribute * attributes, IntegerDataType countTargetStates, IntegerDataType countCases, const IntegerDataType * targets, const EbmDataColumn * columns, const FractionalDataType * predictionScores);
+EBMCORE_IMPORT_EXPORT PEbmInteraction EBMCORE_CALLING_CONVENTION InitializeInteractionRegressionFromDataSet(PEbmDataSet dataSet, const FractionalDataType * targets, const FractionalDataType * predictionScores);
+EBMCORE_IMPORT_EXPORT PEbmInteraction EBMCORE_CALLING_CONVENTION InitializeInteractionClassificationFromDataSet(PEbmDataSet dataSet, IntegerDataType countTargetStates, const IntegerDataType * targets, const FractionalDataType * predictionScores);
+// GetInteractionScore keeps its scratch space per call, so it can be called from multiple threads on the same ebmInteraction.  GetInteractionScores and
+// GetInteractionScoresScreened reuse scratch space owned by ebmInteraction and already spread their work across our own threads, so don't call them while any
+// other call on the same ebmInteraction is running.  CancelInteraction is the exception, and can be called from any thread
 EBMCORE_IMPORT_EXPORT IntegerDataType EBMCORE_CALLING_CONVENTION GetInteractionScore(PEbmInteraction ebmInteraction, IntegerDataType countAttributesInCombination, const IntegerDataType * attributeIndexes, FractionalDataType * interactionScoreReturn);
+EBMCORE_IMPORT_EXPORT IntegerDataType EBMCORE_CALLING_CONVENTION GetInteractionScores(PEbmInteraction ebmInteraction, IntegerDataType countAttributeCombinations, const EbmAttributeCombination * attributeCombinations, const IntegerDataType * attributeCombinationIndexes, FractionalDataType * interactionScoresReturn);
+EBMCORE_IMPORT_EXPORT IntegerDataType EBMCORE_CALLING_CONVENTION GetInteractionScoresScreened(PEbmInteraction ebmInteraction, IntegerDataType countAttributeCombinations, const EbmAttributeCombination * attributeCombinations, const IntegerDataType * attributeCombinationIndexes, IntegerDataType countCasesScreening, FractionalDataType oversamplingFactor, IntegerDataType randomSeed, IntegerDataType countTopAttributeCombinations, IntegerDataType * topAttributeCombinationsReturn, FractionalDataType * topInteractionScoresReturn);
 EBMCORE_IMPORT_EXPORT void EBMCORE_CALLING_CONVENTION CancelInteraction(PEbmInteraction ebmInteraction);
 EBMCORE_IMPORT_EXPORT void EBMCORE_CALLING_CONVENTION FreeInteraction(PEbmInteraction ebmInteraction);
 
@@ -408,8 +408,8 @@ class BaseCoreEBM(BaseEstimator):
             interaction_indices = [
                 x for x in combinations(range(len(self.col_types)), 2)
             ]
-            for pair in interaction_indices:
-                score = native_ebm.fast_interaction_score(pair)
+            scores = native_ebm.fast_interaction_scores(interaction_indices)
+            for pair, score in zip(interaction_indices, scores):
                 interaction_scores.append((pair, score))
 
             ranked_scores = list(
@@ -517,6 +517,24 @@ class BaseCoreEBM(BaseEstimator):
 
     def _cyclic_gradient_boost(self, native_ebm, attribute_sets, name=None):
 
+        if self.training_step_episodes == 1 and len(attribute_sets) != 0:
+            # The native loop runs the same rounds and early stopping as the
+            # loop below, but without a call from python per training step.
+            # It has no notion of several episodes per training step, so
+            # those still go through the loop below.
+            log.info("Start boosting {0}".format(name))
+            curr_metric, rounds_run = native_ebm.cyclic_boosting(
+                self.data_n_episodes,
+                learning_rate=self.learning_rate,
+                max_tree_splits=self.max_tree_splits,
+                min_cases_for_split=self.min_cases_for_splits,
+                early_stopping_tolerance=self.early_stopping_tolerance,
+                early_stopping_run_length=self.early_stopping_run_length,
+            )
+            log.info("End boosting {0}".format(name))
+            # The loop below returns the index of its last episode.
+            return curr_metric, max(rounds_run - 1, 0)
+
         no_change_run_length = 0
         curr_metric = np.inf
         min_metric = np.inf
@@ -26,6 +26,14 @@ class Native:
     # Nominal = 1
     AttributeTypeNominal = 1
 
+    # trainingOptions bit flags : int64_t
+    TrainingOptionsNone = 0
+    TrainingOptionsSinglePrecision = 1
+    TrainingOptionsSamplingWithoutReplacement = 2
+    TrainingOptionsHugePages = 4
+    TrainingOptionsOutOfCore = 8
+    TrainingOptionsFastMath = 16
+
     class Attribute(ct.Structure):
         _fields_ = [
             # AttributeType attributeType;
@@ -42,6 +50,42 @@ class Native:
             ("countAttributes", ct.c_longlong)
         ]
 
+    # dataType values for DataColumn : int64_t
+    DataColumnTypeInt64 = 0
+    DataColumnTypeUInt8 = 1
+    DataColumnTypeUInt16 = 2
+    DataColumnTypeUInt32 = 3
+
+    class DataColumn(ct.Structure):
+        _fields_ = [
+            # const void * data;
+            ("data", ct.c_void_p),
+            # int64_t dataType;
+            ("dataType", ct.c_longlong),
+            # int64_t strideBytes;
+            ("strideBytes", ct.c_longlong),
+        ]
+
+    class MemoryUsage(ct.Structure):
+        _fields_ = [
+            # int64_t packedDataBytes;
+            ("packedDataBytes", ct.c_longlong),
+            # int64_t residualBytes;
+            ("residualBytes", ct.c_longlong),
+            # int64_t samplingSetBytes;
+            ("samplingSetBytes", ct.c_longlong),
+            # int64_t histogramBufferBytes;
+            ("histogramBufferBytes", ct.c_longlong),
+            # int64_t modelBytes;
+            ("modelBytes", ct.c_longlong),
+            # int64_t otherBytes;
+            ("otherBytes", ct.c_longlong),
+            # int64_t currentBytes;
+            ("currentBytes", ct.c_longlong),
+            # int64_t peakBytes;
+            ("peakBytes", ct.c_longlong),
+        ]
+
     LogFuncType = ct.CFUNCTYPE(None, ct.c_char, ct.c_char_p)
 
     # const signed char TraceLevelOff = 0;
@@ -55,6 +99,13 @@ class Native:
     # const signed char TraceLevelVerbose = 4;
     TraceLevelVerbose = 4
 
+    # const int64_t SimdLevelScalar = 0;
+    SimdLevelScalar = 0
+    # const int64_t SimdLevelAvx2 = 1;
+    SimdLevelAvx2 = 1
+    # const int64_t SimdLevelAvx512 = 2;
+    SimdLevelAvx512 = 2
+
     def __init__(self, is_debug=False, log_level=None):
         self.is_debug = is_debug
         self.log_level = log_level
@@ -73,7 +124,137 @@ class Native:
             # signed char traceLevel
             ct.c_char
         ]
-        self.lib.InitializeTrainingRegression.argtypes = [
+        self.lib.SetThreadCount.argtypes = [
+            # int64_t countThreads
+            ct.c_longlong
+        ]
+        self.lib.SetThreadCount.restype = ct.c_longlong
+        self.lib.SetThreadAffinity.argtypes = [
+            # int64_t countCpus
+            ct.c_longlong,
+            # int64_t * cpuIndexes
+            ct.c_void_p,
+        ]
+        self.lib.SetThreadAffinity.restype = ct.c_longlong
+        self.lib.SetSimdLevel.argtypes = [
+            # int64_t simdLevel
+            ct.c_longlong
+        ]
+        self.lib.SetSimdLevel.restype = ct.c_longlong
+        self.lib.GetSimdLevel.argtypes = []
+        self.lib.GetSimdLevel.restype = ct.c_longlong
+
+        self.lib.InitializeDataSet.argtypes = [
+            # int64_t countAttributes
+            ct.c_longlong,
+            # Attribute * attributes
+            ct.POINTER(self.Attribute),
+            # int64_t countCases
+            ct.c_longlong,
+            # DataColumn * columns
+            ct.POINTER(self.DataColumn),
+        ]
+        self.lib.InitializeDataSet.restype = ct.c_void_p
+
+        self.lib.FreeDataSet.argtypes = [
+            # void * ebmDataSet
+            ct.c_void_p
+        ]
+
+        self.lib.SaveDataSet.argtypes = [
+            # void * ebmDataSet
+            ct.c_void_p,
+            # const char * filePath
+            ct.c_char_p,
+        ]
+        self.lib.SaveDataSet.restype = ct.c_longlong
+
+        self.lib.LoadDataSet.argtypes = [
+            # const char * filePath
+            ct.c_char_p
+        ]
+        self.lib.LoadDataSet.restype = ct.c_void_p
+
+        self.lib.InitializeTrainingRegressionFromDataSets.argtypes = [
+            # int64_t randomSeed
+            ct.c_longlong,
+            # int64_t countAttributeSets
+            ct.c_longlong,
+            # AttributeSet * attributeSets
+            ct.POINTER(self.AttributeSet),
+            # int64_t * attributeSetIndexes
+            ndpointer(dtype=ct.c_longlong, flags="F_CONTIGUOUS", ndim=1),
+            # double * trainingTargets
+            ndpointer(dtype=ct.c_double, flags="F_CONTIGUOUS", ndim=1),
+            # void * trainingDataSet
+            ct.c_void_p,
+            # double * trainingPredictionScores
+            ndpointer(dtype=ct.c_double, flags="F_CONTIGUOUS", ndim=1),
+            # double * validationTargets
+            ndpointer(dtype=ct.c_double, flags="F_CONTIGUOUS", ndim=1),
+            # void * validationDataSet
+            ct.c_void_p,
+            # double * validationPredictionScores
+            ndpointer(dtype=ct.c_double, flags="F_CONTIGUOUS", ndim=1),
+            # int64_t countInnerBags
+            ct.c_longlong,
+            # int64_t trainingOptions
+            ct.c_longlong,
+        ]
+        self.lib.InitializeTrainingRegressionFromDataSets.restype = ct.c_void_p
+
+        self.lib.InitializeTrainingClassificationFromDataSets.argtypes = [
+            # int64_t randomSeed
+            ct.c_longlong,
+            # int64_t countAttributeSets
+            ct.c_longlong,
+            # AttributeSet * attributeSets
+            ct.POINTER(self.AttributeSet),
+            # int64_t * attributeSetIndexes
+            ndpointer(dtype=ct.c_longlong, flags="F_CONTIGUOUS", ndim=1),
+            # int64_t countTargetStates
+            ct.c_longlong,
+            # int64_t * trainingTargets
+            ndpointer(dtype=ct.c_longlong, flags="F_CONTIGUOUS", ndim=1),
+            # void * trainingDataSet
+            ct.c_void_p,
+            # double * trainingPredictionScores
+            ndpointer(dtype=ct.c_double, flags="F_CONTIGUOUS", ndim=1),
+            # int64_t * validationTargets
+            ndpointer(dtype=ct.c_longlong, flags="F_CONTIGUOUS", ndim=1),
+            # void * validationDataSet
+            ct.c_void_p,
+            # double * validationPredictionScores
+            ndpointer(dtype=ct.c_double, flags="F_CONTIGUOUS", ndim=1),
+            # int64_t countInnerBags
+            ct.c_longlong,
+            # int64_t trainingOptions
+            ct.c_longlong,
+        ]
+        self.lib.InitializeTrainingClassificationFromDataSets.restype = ct.c_void_p
+
+        self.lib.InitializeInteractionRegressionFromDataSet.argtypes = [
+            # void * ebmDataSet
+            ct.c_void_p,
+            # double * targets
+            ndpointer(dtype=ct.c_double, flags="F_CONTIGUOUS", ndim=1),
+            # double * predictionScores
+            ndpointer(dtype=ct.c_double, flags="F_CONTIGUOUS", ndim=1),
+        ]
+        self.lib.InitializeInteractionRegressionFromDataSet.restype = ct.c_void_p
+
+        self.lib.InitializeInteractionClassificationFromDataSet.argtypes = [
+            # void * ebmDataSet
+            ct.c_void_p,
+            # int64_t countTargetStates
+            ct.c_longlong,
+            # int64_t * targets
+            ndpointer(dtype=ct.c_longlong, flags="F_CONTIGUOUS", ndim=1),
+            # double * predictionScores
+            ndpointer(dtype=ct.c_double, flags="F_CONTIGUOUS", ndim=1),
+        ]
+        self.lib.InitializeInteractionClassificationFromDataSet.restype = ct.c_void_p
+        self.lib.InitializeTrainingRegressionEx.argtypes = [
             # int64_t randomSeed
             ct.c_longlong,
             # int64_t countAttributes
@@ -104,10 +285,48 @@ class Native:
             ndpointer(dtype=ct.c_double, flags="F_CONTIGUOUS", ndim=1),
             # int64_t countInnerBags
             ct.c_longlong,
+            # int64_t trainingOptions
+            ct.c_longlong,
         ]
-        self.lib.InitializeTrainingRegression.restype = ct.c_void_p
+        self.lib.InitializeTrainingRegressionEx.restype = ct.c_void_p
 
-        self.lib.InitializeTrainingClassification.argtypes = [
+        self.lib.InitializeTrainingRegressionColumns.argtypes = [
+            # int64_t randomSeed
+            ct.c_longlong,
+            # int64_t countAttributes
+            ct.c_longlong,
+            # Attribute * attributes
+            ct.POINTER(self.Attribute),
+            # int64_t countAttributeSets
+            ct.c_longlong,
+            # AttributeSet * attributeSets
+            ct.POINTER(self.AttributeSet),
+            # int64_t * attributeSetIndexes
+            ndpointer(dtype=ct.c_longlong, flags="F_CONTIGUOUS", ndim=1),
+            # int64_t countTrainingCases
+            ct.c_longlong,
+            # double * trainingTargets
+            ndpointer(dtype=ct.c_double, flags="F_CONTIGUOUS", ndim=1),
+            # DataColumn * trainingColumns
+            ct.POINTER(self.DataColumn),
+            # double * trainingPredictionScores
+            ndpointer(dtype=ct.c_double, flags="F_CONTIGUOUS", ndim=1),
+            # int64_t countValidationCases
+            ct.c_longlong,
+            # double * validationTargets
+            ndpointer(dtype=ct.c_double, flags="F_CONTIGUOUS", ndim=1),
+            # DataColumn * validationColumns
+            ct.POINTER(self.DataColumn),
+            # double * validationPredictionScores
+            ndpointer(dtype=ct.c_double, flags="F_CONTIGUOUS", ndim=1),
+            # int64_t countInnerBags
+            ct.c_longlong,
+            # int64_t trainingOptions
+            ct.c_longlong,
+        ]
+        self.lib.InitializeTrainingRegressionColumns.restype = ct.c_void_p
+
+        self.lib.InitializeTrainingClassificationEx.argtypes = [
             # int64_t randomSeed
             ct.c_longlong,
             # int64_t countAttributes
@@ -140,8 +359,48 @@ class Native:
             ndpointer(dtype=ct.c_double, flags="F_CONTIGUOUS", ndim=1),
             # int64_t countInnerBags
             ct.c_longlong,
+            # int64_t trainingOptions
+            ct.c_longlong,
+        ]
+        self.lib.InitializeTrainingClassificationEx.restype = ct.c_void_p
+
+        self.lib.InitializeTrainingClassificationColumns.argtypes = [
+            # int64_t randomSeed
+            ct.c_longlong,
+            # int64_t countAttributes
+            ct.c_longlong,
+            # Attribute * attributes
+            ct.POINTER(self.Attribute),
+            # int64_t countAttributeSets
+            ct.c_longlong,
+            # AttributeSet2 * attributeSets
+            ct.POINTER(self.AttributeSet),
+            # int64_t * attributeSetIndexes
+            ndpointer(dtype=ct.c_longlong, flags="F_CONTIGUOUS", ndim=1),
+            # int64_t countTargetStates
+            ct.c_longlong,
+            # int64_t countTrainingCases
+            ct.c_longlong,
+            # int64_t * trainingTargets
+            ndpointer(dtype=ct.c_longlong, flags="F_CONTIGUOUS", ndim=1),
+            # DataColumn * trainingColumns
+            ct.POINTER(self.DataColumn),
+            # double * trainingPredictionScores
+            ndpointer(dtype=ct.c_double, flags="F_CONTIGUOUS", ndim=1),
+            # int64_t countValidationCases
+            ct.c_longlong,
+            # int64_t * validationTargets
+            ndpointer(dtype=ct.c_longlong, flags="F_CONTIGUOUS", ndim=1),
+            # DataColumn * validationColumns
+            ct.POINTER(self.DataColumn),
+            # double * validationPredictionScores
+            ndpointer(dtype=ct.c_double, flags="F_CONTIGUOUS", ndim=1),
+            # int64_t countInnerBags
+            ct.c_longlong,
+            # int64_t trainingOptions
+            ct.c_longlong,
         ]
-        self.lib.InitializeTrainingClassification.restype = ct.c_void_p
+        self.lib.InitializeTrainingClassificationColumns.restype = ct.c_void_p
 
         self.lib.GenerateModelUpdate.argtypes = [
             # void * ebmTraining
@@ -177,6 +436,28 @@ class Native:
         ]
         self.lib.ApplyModelUpdate.restype = ct.c_longlong
 
+        self.lib.RunCyclicBoosting.argtypes = [
+            # void * ebmTraining
+            ct.c_void_p,
+            # int64_t countRounds
+            ct.c_longlong,
+            # double learningRate
+            ct.c_double,
+            # int64_t countTreeSplitsMax
+            ct.c_longlong,
+            # int64_t countCasesRequiredForSplitParentMin
+            ct.c_longlong,
+            # double earlyStoppingTolerance
+            ct.c_double,
+            # int64_t earlyStoppingRunLength
+            ct.c_longlong,
+            # double * validationMetricReturn
+            ct.POINTER(ct.c_double),
+            # int64_t * countRoundsRunReturn
+            ct.POINTER(ct.c_longlong),
+        ]
+        self.lib.RunCyclicBoosting.restype = ct.c_longlong
+
         self.lib.GetCurrentModel.argtypes = [
             # void * tml
             ct.c_void_p,
@@ -203,6 +484,14 @@ class Native:
             ct.c_void_p
         ]
 
+        self.lib.GetMemoryUsage.argtypes = [
+            # void * tml
+            ct.c_void_p,
+            # EbmMemoryUsage * memoryUsageOut
+            ct.POINTER(self.MemoryUsage),
+        ]
+        self.lib.GetMemoryUsage.restype = ct.c_longlong
+
         self.lib.InitializeInteractionClassification.argtypes = [
             # int64_t countAttributes
             ct.c_longlong,
@@ -237,6 +526,40 @@ class Native:
         ]
         self.lib.InitializeInteractionRegression.restype = ct.c_void_p
 
+        self.lib.InitializeInteractionClassificationColumns.argtypes = [
+            # int64_t countAttributes
+            ct.c_longlong,
+            # Attribute * attributes
+            ct.POINTER(self.Attribute),
+            # int64_t countTargetStates
+            ct.c_longlong,
+            # int64_t countCases
+            ct.c_longlong,
+            # int64_t * targets
+            ndpointer(dtype=ct.c_longlong, flags="F_CONTIGUOUS", ndim=1),
+            # DataColumn * columns
+            ct.POINTER(self.DataColumn),
+            # double * predictionScores
+            ndpointer(dtype=ct.c_double, flags="F_CONTIGUOUS", ndim=1),
+        ]
+        self.lib.InitializeInteractionClassificationColumns.restype = ct.c_void_p
+
+        self.lib.InitializeInteractionRegressionColumns.argtypes = [
+            # int64_t countAttributes
+            ct.c_longlong,
+            # Attribute * attributes
+            ct.POINTER(self.Attribute),
+            # int64_t countCases
+            ct.c_longlong,
+            # double * targets
+            ndpointer(dtype=ct.c_double, flags="F_CONTIGUOUS", ndim=1),
+            # DataColumn * columns
+            ct.POINTER(self.DataColumn),
+            # double * predictionScores
+            ndpointer(dtype=ct.c_double, flags="F_CONTIGUOUS", ndim=1),
+        ]
+        self.lib.InitializeInteractionRegressionColumns.restype = ct.c_void_p
+
         self.lib.GetInteractionScore.argtypes = [
             # void * tmlInteraction
             ct.c_void_p,
@@ -249,6 +572,44 @@ class Native:
         ]
         self.lib.GetInteractionScore.restype = ct.c_longlong
 
+        self.lib.GetInteractionScores.argtypes = [
+            # void * tmlInteraction
+            ct.c_void_p,
+            # int64_t countAttributeCombinations
+            ct.c_longlong,
+            # AttributeCombination * attributeCombinations
+            ct.POINTER(self.AttributeSet),
+            # int64_t * attributeCombinationIndexes
+            ndpointer(dtype=ct.c_longlong, flags="F_CONTIGUOUS", ndim=1),
+            # double * interactionScoresReturn
+            ndpointer(dtype=ct.c_double, flags="F_CONTIGUOUS", ndim=1),
+        ]
+        self.lib.GetInteractionScores.restype = ct.c_longlong
+
+        self.lib.GetInteractionScoresScreened.argtypes = [
+            # void * tmlInteraction
+            ct.c_void_p,
+            # int64_t countAttributeCombinations
+            ct.c_longlong,
+            # AttributeCombination * attributeCombinations
+            ct.POINTER(self.AttributeSet),
+            # int64_t * attributeCombinationIndexes
+            ndpointer(dtype=ct.c_longlong, flags="F_CONTIGUOUS", ndim=1),
+            # int64_t countCasesScreening
+            ct.c_longlong,
+            # double oversamplingFactor
+            ct.c_double,
+            # int64_t randomSeed
+            ct.c_longlong,
+            # int64_t countTopAttributeCombinations
+            ct.c_longlong,
+            # int64_t * topAttributeCombinationsReturn
+            ndpointer(dtype=ct.c_longlong, flags="F_CONTIGUOUS", ndim=1),
+            # double * topInteractionScoresReturn
+            ndpointer(dtype=ct.c_double, flags="F_CONTIGUOUS", ndim=1),
+        ]
+        self.lib.GetInteractionScoresScreened.restype = ct.c_longlong
+
         self.lib.FreeInteraction.argtypes = [
             # void * tmlInteraction
             ct.c_void_p
@@ -348,6 +709,11 @@ class NativeEBM:
         training_scores=None,
         validation_scores=None,
         random_state=1337,
+        single_precision=False,
+        sampling_without_replacement=False,
+        huge_pages=False,
+        out_of_core=False,
+        fast_math=False,
     ):
 
         # TODO: Update documentation for training/val scores args.
@@ -369,6 +735,18 @@ class NativeEBM:
             training_scores: Undocumented.
             validation_scores: Undocumented.
             random_state: Random seed as integer.
+            single_precision: Store per-case residuals and scores as
+                32 bit floats in the native code to halve memory traffic.
+            sampling_without_replacement: Draw each inner bag as a half
+                subsample without replacement instead of a bootstrap sample.
+            huge_pages: On linux, hint that large native datasets should be
+                backed by transparent huge pages.
+            out_of_core: Keep the native training and validation datasets in
+                temporary files mapped into memory, so that datasets larger
+                than RAM can be trained on. Results are unchanged.
+            fast_math: Calculate classification residuals and validation
+                log loss with vectorized polynomial exp and log whose
+                relative error is below 1e-9 instead of the C library's.
         """
         log.debug("Check if EBM lib is loaded")
         if this.native is None:
@@ -413,15 +791,42 @@ class NativeEBM:
             else:
                 self.validation_scores = np.zeros(X_train.shape[0])
         self.random_state = random_state
-
-        # Convert n-dim arrays ready for C.
-        self.X_train_f = np.asfortranarray(self.X_train)
-        self.X_val_f = np.asfortranarray(self.X_val)
+        self.single_precision = single_precision
+        self.sampling_without_replacement = sampling_without_replacement
+        self.huge_pages = huge_pages
+        self.out_of_core = out_of_core
+        self.fast_math = fast_math
+
+        # Describe each column to C in place.  Narrow unsigned binned data is read
+        # directly by the native code instead of being widened to an int64 copy.
+        self.X_train_c, self.X_train_columns = self._make_data_columns(self.X_train)
+        self.X_val_c, self.X_val_columns = self._make_data_columns(self.X_val)
+
+        # Bin the data once into datasets that the training and interaction
+        # states share by reference instead of each ingesting their own copy.
+        self.training_data_set = this.native.lib.InitializeDataSet(
+            len(self.attribute_array),
+            self.attribute_array,
+            self.X_train_c.shape[0],
+            self.X_train_columns,
+        )
+        self.validation_data_set = this.native.lib.InitializeDataSet(
+            len(self.attribute_array),
+            self.attribute_array,
+            self.X_val_c.shape[0],
+            self.X_val_columns,
+        )
 
         # Define extra properties
         self.model_pointer = None
         self.interaction_pointer = None
 
+        # The native code returns null on bad input or when out of memory,
+        # which it has already logged.  Passing null on would crash.
+        if self.training_data_set is None or self.validation_data_set is None:
+            self._free_data_sets()
+            raise MemoryError("Native dataset initialization failed")
+
         # Allocate external resources
         if self.model_type == "regression":
             self.y_train = self.y_train.astype("float64")
@@ -435,8 +840,49 @@ class NativeEBM:
             self._initialize_training_classification()
             self._initialize_interaction_classification()
 
+        if self.model_pointer is None or self.interaction_pointer is None:
+            if self.model_pointer is not None:
+                this.native.lib.FreeTraining(self.model_pointer)
+                self.model_pointer = None
+            if self.interaction_pointer is not None:
+                this.native.lib.FreeInteraction(self.interaction_pointer)
+                self.interaction_pointer = None
+            self._free_data_sets()
+            raise MemoryError("Native training or interaction initialization failed")
+
+        # The states hold their own references to the datasets.
+        self._free_data_sets()
+
         log.info("Allocation end")
 
+    def _free_data_sets(self):
+        # FreeDataSet accepts null, so this is safe after a failed initialization
+        this.native.lib.FreeDataSet(self.training_data_set)
+        this.native.lib.FreeDataSet(self.validation_data_set)
+        self.training_data_set = None
+        self.validation_data_set = None
+
+    @staticmethod
+    def _make_data_columns(X):
+        column_types = {
+            np.dtype("uint8"): this.native.DataColumnTypeUInt8,
+            np.dtype("uint16"): this.native.DataColumnTypeUInt16,
+            np.dtype("uint32"): this.native.DataColumnTypeUInt32,
+            np.dtype("int64"): this.native.DataColumnTypeInt64,
+        }
+        X = np.asarray(X)
+        if X.dtype not in column_types:
+            X = X.astype("int64")
+        column_type = column_types[X.dtype]
+
+        # The returned array must be kept alive for as long as the columns are used
+        columns = (this.native.DataColumn * X.shape[1])()
+        for idx in range(X.shape[1]):
+            columns[idx].data = X.ctypes.data + idx * X.strides[1]
+            columns[idx].dataType = column_type
+            columns[idx].strideBytes = X.strides[0]
+        return X, columns
+
     def _convert_attribute_info_to_c(self, attributes, attribute_sets):
         # Create C form of attributes
         attribute_ar = (this.native.Attribute * len(attributes))()
@@ -461,65 +907,84 @@ class NativeEBM:
         return attribute_ar, attribute_sets_ar, attribute_set_indexes
 
     def _initialize_interaction_regression(self):
-        self.interaction_pointer = this.native.lib.InitializeInteractionRegression(
-            len(self.attribute_array),
-            self.attribute_array,
-            self.X_train.shape[0],
+        self.interaction_pointer = this.native.lib.InitializeInteractionRegressionFromDataSet(
+            self.training_data_set,
             self.y_train,
-            self.X_train_f,
             self.training_scores,
         )
 
     def _initialize_interaction_classification(self):
-        self.interaction_pointer = this.native.lib.InitializeInteractionClassification(
-            len(self.attribute_array),
-            self.attribute_array,
+        self.interaction_pointer = this.native.lib.InitializeInteractionClassificationFromDataSet(
+            self.training_data_set,
             self.num_classification_states,
-            self.X_train.shape[0],
             self.y_train,
-            self.X_train_f,
             self.training_scores,
         )
 
     def _initialize_training_regression(self):
-        self.model_pointer = this.native.lib.InitializeTrainingRegression(
+        self.model_pointer = this.native.lib.InitializeTrainingRegressionFromDataSets(
             self.random_state,
-            len(self.attribute_array),
-            self.attribute_array,
             len(self.attribute_sets_array),
             self.attribute_sets_array,
             self.attribute_set_indexes,
-            self.X_train.shape[0],
             self.y_train,
-            self.X_train_f,
+            self.training_data_set,
             self.training_scores,
-            self.X_val.shape[0],
             self.y_val,
-            self.X_val_f,
+            self.validation_data_set,
             self.validation_scores,
             self.num_inner_bags,
+            self._training_options(),
         )
 
     def _initialize_training_classification(self):
-        self.model_pointer = this.native.lib.InitializeTrainingClassification(
+        self.model_pointer = this.native.lib.InitializeTrainingClassificationFromDataSets(
             self.random_state,
-            len(self.attribute_array),
-            self.attribute_array,
             len(self.attribute_sets_array),
             self.attribute_sets_array,
             self.attribute_set_indexes,
             self.num_classification_states,
-            self.X_train.shape[0],
             self.y_train,
-            self.X_train_f,
+            self.training_data_set,
             self.training_scores,
-            self.X_val.shape[0],
             self.y_val,
-            self.X_val_f,
+            self.validation_data_set,
             self.validation_scores,
             self.num_inner_bags,
+            self._training_options(),
         )
 
+    def _training_options(self):
+        training_options = this.native.TrainingOptionsNone
+        if self.single_precision:
+            training_options |= this.native.TrainingOptionsSinglePrecision
+        if self.sampling_without_replacement:
+            training_options |= this.native.TrainingOptionsSamplingWithoutReplacement
+        if self.huge_pages:
+            training_options |= this.native.TrainingOptionsHugePages
+        if self.out_of_core:
+            training_options |= this.native.TrainingOptionsOutOfCore
+        if self.fast_math:
+            training_options |= this.native.TrainingOptionsFastMath
+        return training_options
+
+    def memory_usage(self):
+        """ Bytes held by the native training state, split by subsystem.
+
+        Returns:
+            Dictionary from subsystem name to bytes, including the current
+            total and the peak total seen so far.
+        """
+        memory_usage = this.native.MemoryUsage()
+        return_code = this.native.lib.GetMemoryUsage(
+            self.model_pointer, ct.byref(memory_usage)
+        )
+        if return_code != 0:  # pragma: no cover
+            raise RuntimeError("Native memory usage query failed")
+        return {
+            name: getattr(memory_usage, name) for name, _ in memory_usage._fields_
+        }
+
     def close(self):
         """ Deallocates C objects used to train EBM. """
         log.info("Deallocation start")
@@ -540,6 +1005,81 @@ class NativeEBM:
         log.info("Fast interaction score end")
         return score.value
 
+    def fast_interaction_scores(self, attribute_index_tuples):
+        """ Provides scores for many attribute interactions in a single call.
+            The native code scores them in parallel. Higher is better."""
+        log.info("Fast interaction scores start")
+        attribute_sets = [
+            {"n_attributes": len(attribute_index_tuple), "attributes": attribute_index_tuple}
+            for attribute_index_tuple in attribute_index_tuples
+        ]
+        _, attribute_sets_ar, attribute_set_indexes = self._convert_attribute_info_to_c(
+            [], attribute_sets
+        )
+        scores = np.zeros(len(attribute_index_tuples), dtype=np.float64, order="F")
+        if len(attribute_index_tuples) != 0:
+            return_code = this.native.lib.GetInteractionScores(
+                self.interaction_pointer,
+                len(attribute_index_tuples),
+                attribute_sets_ar,
+                attribute_set_indexes,
+                scores,
+            )
+            if return_code != 0:  # pragma: no cover
+                raise RuntimeError("Native interaction scoring failed")
+        log.info("Fast interaction scores end")
+        return scores
+
+    def fast_interaction_scores_screened(
+        self,
+        attribute_index_tuples,
+        n_top,
+        n_screening_cases,
+        oversampling_factor=4.0,
+    ):
+        """ Finds the best attribute interactions in two stages. All of them
+            are scored on a subsample of n_screening_cases cases, and the best
+            n_top * oversampling_factor of those are rescored on all the data.
+
+        Args:
+            attribute_index_tuples: Candidate interactions as attribute index tuples.
+            n_top: Number of interactions to return.
+            n_screening_cases: Number of cases in the screening subsample.
+            oversampling_factor: Candidates kept per returned interaction.
+
+        Returns:
+            Tuple of (indexes into attribute_index_tuples, exact scores),
+            ordered from best to worst.
+        """
+        log.info("Fast interaction scores screened start")
+        n_top = min(n_top, len(attribute_index_tuples))
+        attribute_sets = [
+            {"n_attributes": len(attribute_index_tuple), "attributes": attribute_index_tuple}
+            for attribute_index_tuple in attribute_index_tuples
+        ]
+        _, attribute_sets_ar, attribute_set_indexes = self._convert_attribute_info_to_c(
+            [], attribute_sets
+        )
+        top_indexes = np.zeros(n_top, dtype=np.int64, order="F")
+        top_scores = np.zeros(n_top, dtype=np.float64, order="F")
+        if n_top != 0:
+            return_code = this.native.lib.GetInteractionScoresScreened(
+                self.interaction_pointer,
+                len(attribute_index_tuples),
+                attribute_sets_ar,
+                attribute_set_indexes,
+                n_screening_cases,
+                oversampling_factor,
+                self.random_state,
+                n_top,
+                top_indexes,
+                top_scores,
+            )
+            if return_code != 0:  # pragma: no cover
+                raise RuntimeError("Native screened interaction scoring failed")
+        log.info("Fast interaction scores screened end")
+        return top_indexes, top_scores
+
     def training_step(
         self,
         attribute_set_index,
@@ -597,6 +1137,50 @@ class NativeEBM:
         # log.debug("Training step end")
         return metric_output.value
 
+    def cyclic_boosting(
+        self,
+        num_rounds,
+        learning_rate=0.01,
+        max_tree_splits=2,
+        min_cases_for_split=2,
+        early_stopping_tolerance=1e-5,
+        early_stopping_run_length=50,
+    ):
+
+        """ Boosts every attribute set once per round inside the native
+            library until early stopping kicks in or num_rounds is reached.
+
+        Args:
+            num_rounds: Maximum number of rounds over all attribute sets.
+            learning_rate: Learning rate as a float.
+            max_tree_splits: Max tree splits on feature step.
+            min_cases_for_split: Min observations required to split.
+            early_stopping_tolerance: Minimum improvement in the validation
+                metric that resets the early stopping run.
+            early_stopping_run_length: Number of rounds without improvement
+                before stopping.  Negative disables early stopping.
+
+        Returns:
+            Tuple of validation loss after the last step, and rounds run.
+        """
+        metric_output = ct.c_double(0.0)
+        rounds_run = ct.c_longlong(0)
+        return_code = this.native.lib.RunCyclicBoosting(
+            self.model_pointer,
+            num_rounds,
+            learning_rate,
+            max_tree_splits,
+            min_cases_for_split,
+            early_stopping_tolerance,
+            early_stopping_run_length,
+            ct.byref(metric_output),
+            ct.byref(rounds_run),
+        )
+        if return_code != 0:  # pragma: no cover
+            raise Exception("RunCyclicBoosting Exception")
+
+        return metric_output.value, rounds_run.value
+
     def _get_attribute_set_shape(self, attribute_set_index):
         # Retrieve dimensions of log odds tensor
         dimensions = []
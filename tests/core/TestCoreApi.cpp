@@ -24,6 +24,7 @@
 #include <cstddef>
 #include <assert.h>
 #include <string.h>
+#include <thread>
 
 #include "ebmcore.h"
 
@@ -702,7 +703,7 @@ public:
       m_stage = Stage::ValidationAdded;
    }
 
-   void InitializeTraining(const IntegerDataType countInnerBags = k_countInnerBagsDefault) {
+   void InitializeTraining(const IntegerDataType countInnerBags = k_countInnerBagsDefault, const IntegerDataType trainingOptions = TrainingOptionsNone) {
       if(Stage::ValidationAdded != m_stage) {
          exit(1);
       }
@@ -711,9 +712,9 @@ public:
       }
 
       if(IsClassification(m_learningTypeOrCountClassificationStates)) {
-         m_pEbmTraining = InitializeTrainingClassification(randomSeed, m_attributes.size(), 0 == m_attributes.size() ? nullptr : &m_attributes[0], m_attributeCombinations.size(), 0 == m_attributeCombinations.size() ? nullptr : &m_attributeCombinations[0], 0 == m_attributeCombinationIndexes.size() ? nullptr : &m_attributeCombinationIndexes[0], m_learningTypeOrCountClassificationStates, m_trainingClassificationTargets.size(), 0 == m_trainingClassificationTargets.size() ? nullptr : &m_trainingClassificationTargets[0], 0 == m_trainingData.size() ? nullptr : &m_trainingData[0], m_bNullTrainingPredictionScores ? nullptr : &m_trainingPredictionScores[0], m_validationClassificationTargets.size(), 0 == m_validationClassificationTargets.size() ? nullptr : &m_validationClassificationTargets[0], 0 == m_validationData.size() ? nullptr : &m_validationData[0], m_bNullValidationPredictionScores ? nullptr : &m_validationPredictionScores[0], countInnerBags);
+         m_pEbmTraining = InitializeTrainingClassificationEx(randomSeed, m_attributes.size(), 0 == m_attributes.size() ? nullptr : &m_attributes[0], m_attributeCombinations.size(), 0 == m_attributeCombinations.size() ? nullptr : &m_attributeCombinations[0], 0 == m_attributeCombinationIndexes.size() ? nullptr : &m_attributeCombinationIndexes[0], m_learningTypeOrCountClassificationStates, m_trainingClassificationTargets.size(), 0 == m_trainingClassificationTargets.size() ? nullptr : &m_trainingClassificationTargets[0], 0 == m_trainingData.size() ? nullptr : &m_trainingData[0], m_bNullTrainingPredictionScores ? nullptr : &m_trainingPredictionScores[0], m_validationClassificationTargets.size(), 0 == m_validationClassificationTargets.size() ? nullptr : &m_validationClassificationTargets[0], 0 == m_validationData.size() ? nullptr : &m_validationData[0], m_bNullValidationPredictionScores ? nullptr : &m_validationPredictionScores[0], countInnerBags, trainingOptions);
       } else if(k_learningTypeRegression == m_learningTypeOrCountClassificationStates) {
-         m_pEbmTraining = InitializeTrainingRegression(randomSeed, m_attributes.size(), 0 == m_attributes.size() ? nullptr : &m_attributes[0], m_attributeCombinations.size(), 0 == m_attributeCombinations.size() ? nullptr : &m_attributeCombinations[0], 0 == m_attributeCombinationIndexes.size() ? nullptr : &m_attributeCombinationIndexes[0], m_trainingRegressionTargets.size(), 0 == m_trainingRegressionTargets.size() ? nullptr : &m_trainingRegressionTargets[0], 0 == m_trainingData.size() ? nullptr : &m_trainingData[0], m_bNullTrainingPredictionScores ? nullptr : &m_trainingPredictionScores[0], m_validationRegressionTargets.size(), 0 == m_validationRegressionTargets.size() ? nullptr : &m_validationRegressionTargets[0], 0 == m_validationData.size() ? nullptr : &m_validationData[0], m_bNullValidationPredictionScores ? nullptr : &m_validationPredictionScores[0], countInnerBags);
+         m_pEbmTraining = InitializeTrainingRegressionEx(randomSeed, m_attributes.size(), 0 == m_attributes.size() ? nullptr : &m_attributes[0], m_attributeCombinations.size(), 0 == m_attributeCombinations.size() ? nullptr : &m_attributeCombinations[0], 0 == m_attributeCombinationIndexes.size() ? nullptr : &m_attributeCombinationIndexes[0], m_trainingRegressionTargets.size(), 0 == m_trainingRegressionTargets.size() ? nullptr : &m_trainingRegressionTargets[0], 0 == m_trainingData.size() ? nullptr : &m_trainingData[0], m_bNullTrainingPredictionScores ? nullptr : &m_trainingPredictionScores[0], m_validationRegressionTargets.size(), 0 == m_validationRegressionTargets.size() ? nullptr : &m_validationRegressionTargets[0], 0 == m_validationData.size() ? nullptr : &m_validationData[0], m_bNullValidationPredictionScores ? nullptr : &m_validationPredictionScores[0], countInnerBags, trainingOptions);
       } else {
          exit(1);
       }
@@ -755,6 +756,105 @@ public:
       return validationMetricReturn;
    }
 
+   // if pRet is nullptr then anything but success is fatal, otherwise we return the return code there so that we can test cancellation
+   FractionalDataType RunCyclicBoosting(const IntegerDataType countRounds, const FractionalDataType earlyStoppingTolerance, const IntegerDataType earlyStoppingRunLength, IntegerDataType * const pCountRoundsRun, IntegerDataType * const pRet = nullptr) {
+      if(Stage::InitializedTraining != m_stage) {
+         exit(1);
+      }
+      FractionalDataType validationMetricReturn = FractionalDataType { 0 };
+      const IntegerDataType ret = ::RunCyclicBoosting(m_pEbmTraining, countRounds, k_learningRateDefault, k_countTreeSplitsMaxDefault, k_countCasesRequiredForSplitParentMinDefault, earlyStoppingTolerance, earlyStoppingRunLength, &validationMetricReturn, pCountRoundsRun);
+      if(nullptr != pRet) {
+         *pRet = ret;
+      } else if(0 != ret) {
+         exit(1);
+      }
+      return validationMetricReturn;
+   }
+
+   void Cancel() {
+      if(Stage::InitializedTraining != m_stage) {
+         exit(1);
+      }
+      CancelTraining(m_pEbmTraining);
+   }
+
+   EbmMemoryUsage GetMemoryUsage() const {
+      if(Stage::InitializedTraining != m_stage) {
+         exit(1);
+      }
+      EbmMemoryUsage memoryUsage;
+      if(0 != ::GetMemoryUsage(m_pEbmTraining, &memoryUsage)) {
+         exit(1);
+      }
+      return memoryUsage;
+   }
+
+   EbmMemoryUsage EstimateTrainingMemory(const IntegerDataType countInnerBags = k_countInnerBagsDefault, const IntegerDataType trainingOptions = TrainingOptionsNone) const {
+      if(Stage::ValidationAdded != m_stage && Stage::InitializedTraining != m_stage) {
+         exit(1);
+      }
+      EbmMemoryUsage memoryUsage;
+      IntegerDataType ret;
+      if(IsClassification(m_learningTypeOrCountClassificationStates)) {
+         ret = EstimateTrainingClassificationMemory(m_attributes.size(), 0 == m_attributes.size() ? nullptr : &m_attributes[0], m_attributeCombinations.size(), 0 == m_attributeCombinations.size() ? nullptr : &m_attributeCombinations[0], 0 == m_attributeCombinationIndexes.size() ? nullptr : &m_attributeCombinationIndexes[0], m_learningTypeOrCountClassificationStates, m_trainingClassificationTargets.size(), m_validationClassificationTargets.size(), countInnerBags, trainingOptions, &memoryUsage);
+      } else if(k_learningTypeRegression == m_learningTypeOrCountClassificationStates) {
+         ret = EstimateTrainingRegressionMemory(m_attributes.size(), 0 == m_attributes.size() ? nullptr : &m_attributes[0], m_attributeCombinations.size(), 0 == m_attributeCombinations.size() ? nullptr : &m_attributeCombinations[0], 0 == m_attributeCombinationIndexes.size() ? nullptr : &m_attributeCombinationIndexes[0], m_trainingRegressionTargets.size(), m_validationRegressionTargets.size(), countInnerBags, trainingOptions, &memoryUsage);
+      } else {
+         exit(1);
+      }
+      if(0 != ret) {
+         exit(1);
+      }
+      return memoryUsage;
+   }
+
+   std::vector<FractionalDataType> GenerateUpdate(const IntegerDataType indexAttributeCombination, const bool bThreadSafe, const FractionalDataType learningRate = k_learningRateDefault, const IntegerDataType countTreeSplitsMax = k_countTreeSplitsMaxDefault, const IntegerDataType countCasesRequiredForSplitParentMin = k_countCasesRequiredForSplitParentMinDefault) {
+      if(Stage::InitializedTraining != m_stage) {
+         exit(1);
+      }
+      if(indexAttributeCombination < IntegerDataType { 0 }) {
+         exit(1);
+      }
+      if(m_countStatesByAttributeCombination.size() <= static_cast<size_t>(indexAttributeCombination)) {
+         exit(1);
+      }
+      size_t cItems = GetVectorLength(m_learningTypeOrCountClassificationStates);
+      for(const size_t countStates : m_countStatesByAttributeCombination[static_cast<size_t>(indexAttributeCombination)]) {
+         cItems *= countStates;
+      }
+      std::vector<FractionalDataType> modelUpdate(cItems);
+      FractionalDataType gain = FractionalDataType { 0 };
+      if(bThreadSafe) {
+         PEbmTrainingThreadState pEbmTrainingThreadState = AllocateTrainingThreadState(m_pEbmTraining);
+         if(nullptr == pEbmTrainingThreadState) {
+            exit(1);
+         }
+         const IntegerDataType ret = GenerateModelUpdateThreadSafe(m_pEbmTraining, pEbmTrainingThreadState, indexAttributeCombination, learningRate, countTreeSplitsMax, countCasesRequiredForSplitParentMin, nullptr, nullptr, &gain, &modelUpdate[0]);
+         FreeTrainingThreadState(pEbmTrainingThreadState);
+         if(0 != ret) {
+            exit(1);
+         }
+      } else {
+         const FractionalDataType * const aModelUpdate = GenerateModelUpdate(m_pEbmTraining, indexAttributeCombination, learningRate, countTreeSplitsMax, countCasesRequiredForSplitParentMin, nullptr, nullptr, &gain);
+         if(nullptr == aModelUpdate) {
+            exit(1);
+         }
+         modelUpdate.assign(aModelUpdate, aModelUpdate + cItems);
+      }
+      return modelUpdate;
+   }
+
+   // unlike Train, this hands back the return code so that we can test the failures
+   IntegerDataType ApplyUpdate(const IntegerDataType indexAttributeCombination, const std::vector<FractionalDataType> modelUpdate, FractionalDataType * const pValidationMetric) {
+      if(Stage::InitializedTraining != m_stage) {
+         exit(1);
+      }
+      if(m_attributeCombinations.size() <= static_cast<size_t>(indexAttributeCombination)) {
+         exit(1);
+      }
+      return ApplyModelUpdate(m_pEbmTraining, indexAttributeCombination, &modelUpdate[0], pValidationMetric);
+   }
+
    FractionalDataType GetCurrentModelValue(const size_t iAttributeCombination, const std::vector<size_t> indexes, const size_t iScore) const {
       if(Stage::InitializedTraining != m_stage) {
          exit(1);
@@ -996,8 +1096,91 @@ public:
       }
       return interactionScoreReturn;
    }
+
+   std::vector<FractionalDataType> InteractionScores(const std::vector<std::vector<IntegerDataType>> attributeCombinations) const {
+      if(Stage::InitializedInteraction != m_stage) {
+         exit(1);
+      }
+      std::vector<EbmAttributeCombination> combinations;
+      std::vector<IntegerDataType> indexes;
+      for(const std::vector<IntegerDataType> & attributesInCombination : attributeCombinations) {
+         EbmAttributeCombination combination;
+         combination.countAttributesInCombination = attributesInCombination.size();
+         combinations.push_back(combination);
+         for(const IntegerDataType oneAttributeIndex : attributesInCombination) {
+            if(oneAttributeIndex < IntegerDataType { 0 }) {
+               exit(1);
+            }
+            if(m_attributes.size() <= static_cast<size_t>(oneAttributeIndex)) {
+               exit(1);
+            }
+            indexes.push_back(oneAttributeIndex);
+         }
+      }
+
+      std::vector<FractionalDataType> interactionScores(attributeCombinations.size(), FractionalDataType { 0 });
+      const IntegerDataType ret = GetInteractionScores(m_pEbmInteraction, combinations.size(), 0 == combinations.size() ? nullptr : &combinations[0], 0 == indexes.size() ? nullptr : &indexes[0], 0 == interactionScores.size() ? nullptr : &interactionScores[0]);
+      if(0 != ret) {
+         exit(1);
+      }
+      return interactionScores;
+   }
+
+   std::vector<IntegerDataType> InteractionScoresScreened(const std::vector<std::vector<IntegerDataType>> attributeCombinations, const IntegerDataType countCasesScreening, const FractionalDataType oversamplingFactor, const IntegerDataType countTop, std::vector<FractionalDataType> * const pInteractionScores) const {
+      if(Stage::InitializedInteraction != m_stage) {
+         exit(1);
+      }
+      std::vector<EbmAttributeCombination> combinations;
+      std::vector<IntegerDataType> indexes;
+      for(const std::vector<IntegerDataType> & attributesInCombination : attributeCombinations) {
+         EbmAttributeCombination combination;
+         combination.countAttributesInCombination = attributesInCombination.size();
+         combinations.push_back(combination);
+         for(const IntegerDataType oneAttributeIndex : attributesInCombination) {
+            if(oneAttributeIndex < IntegerDataType { 0 }) {
+               exit(1);
+            }
+            if(m_attributes.size() <= static_cast<size_t>(oneAttributeIndex)) {
+               exit(1);
+            }
+            indexes.push_back(oneAttributeIndex);
+         }
+      }
+
+      const size_t cTop = std::min(attributeCombinations.size(), static_cast<size_t>(countTop));
+      std::vector<IntegerDataType> topAttributeCombinations(cTop, IntegerDataType { -1 });
+      pInteractionScores->assign(cTop, FractionalDataType { 0 });
+      const IntegerDataType ret = GetInteractionScoresScreened(m_pEbmInteraction, combinations.size(), 0 == combinations.size() ? nullptr : &combinations[0], 0 == indexes.size() ? nullptr : &indexes[0], countCasesScreening, oversamplingFactor, randomSeed, countTop, 0 == cTop ? nullptr : &topAttributeCombinations[0], 0 == cTop ? nullptr : &(*pInteractionScores)[0]);
+      if(0 != ret) {
+         exit(1);
+      }
+      return topAttributeCombinations;
+   }
 };
 
+// repeats the cases cReplicas times.  Replicas don't change the models or the per case losses, but they push our datasets over the sizes where we split
+// our work into chunks, partitions, batches and stream blocks, so the tests below compare replicated datasets against small ones or against other options
+template<typename TCase>
+static std::vector<TCase> ReplicateCases(const std::vector<TCase> & cases, const size_t cReplicas) {
+   std::vector<TCase> casesReplicated;
+   casesReplicated.reserve(cases.size() * cReplicas);
+   for(size_t iReplica = 0; iReplica < cReplicas; ++iReplica) {
+      for(const TCase & oneCase : cases) {
+         casesReplicated.push_back(oneCase);
+      }
+   }
+   return casesReplicated;
+}
+
+// adds the attributes, the attribute combinations, cTrainingReplicas copies of the training cases and cValidationReplicas copies of the validation cases
+template<typename TCase>
+static void AddReplicatedCases(TestApi & test, const std::vector<Attribute> attributes, const std::vector<std::vector<size_t>> attributeCombinations, const std::vector<TCase> & trainingCases, const size_t cTrainingReplicas, const std::vector<TCase> & validationCases, const size_t cValidationReplicas) {
+   test.AddAttributes(attributes);
+   test.AddAttributeCombinations(attributeCombinations);
+   test.AddTrainingCases(ReplicateCases(trainingCases, cTrainingReplicas));
+   test.AddValidationCases(ReplicateCases(validationCases, cValidationReplicas));
+}
+
 TEST_CASE("null validationMetricReturn, training, regression") {
    EbmAttributeCombination combinations[1];
    combinations->countAttributesInCombination = 0;
@@ -1279,6 +1462,1483 @@ TEST_CASE("zero countTreeSplitsMax, training, regression") {
    CHECK_APPROX(modelValue, 0.1000000000000000);
 }
 
+TEST_CASE("multiple inner bags, training, regression") {
+   // every case has the same target, so every inner bag should generate the same update no matter which cases get sampled into it
+   TestApi test = TestApi(k_learningTypeRegression);
+   test.AddAttributes({ Attribute(2) });
+   test.AddAttributeCombinations({ { 0 } });
+   test.AddTrainingCases({
+      RegressionCase(10, { 0 }),
+      RegressionCase(10, { 1 }),
+      });
+   test.AddValidationCases({ RegressionCase(12, { 1 }) });
+   test.InitializeTraining(8);
+
+   FractionalDataType validationMetric = test.Train(0);
+   CHECK_APPROX(validationMetric, 11.900000000000000);
+   FractionalDataType modelValue = test.GetCurrentModelValue(0, { 0 }, 0);
+   CHECK_APPROX(modelValue, 0.1000000000000000);
+   modelValue = test.GetCurrentModelValue(0, { 1 }, 0);
+   CHECK_APPROX(modelValue, 0.1000000000000000);
+}
+
+
+TEST_CASE("zero inner bags matches the results from before SamplingFlat, training, regression") {
+   // with zero inner bags we bin without reading occurrence counts, and take the count of cases in each bin from what SamplingFlat counted at
+   // initialization.  Before SamplingFlat we read a count of 1 for every case, so these are the bits that version produced for this exact problem.
+   // Regression has no exp or log, so these don't depend on the math library.  Each update divides by the cases in its bins, so a wrong count changes them
+   static constexpr uint64_t k_expectedBits[] = {
+      // the validation metric after each training step
+      0x400dbb7b3e6469c1, 0x4009d7f98dfac1ff, 0x40075f42c933ac41, 0x4005542dac4564d1,
+      0x4003abef9ca67b20, 0x4001b15441080584, 0x40000f00b54b3a03, 0x3fff9ed87ed02407,
+      0x3fff1940a6057c42, 0x3ffdcda13d693279, 0x3ffcd120a11ffa21, 0x3ffe1c1ca37b44c5,
+      0x3ffecaf0c6a8908a, 0x3ffebb570277eff2, 0x3ffebfc180b21364, 0x40002635665d09b9,
+      // the final model of the zero dimensional, single attribute and the two pair combinations
+      0x3ff54f403531b860, 0x3fe6909d87fe2e3a, 0x3ff2fcc6cd10bfd3, 0x3ffb83432388a1be,
+      0x3fe44ef42d97f666, 0x3fecbd392881c189, 0x3fe389560c8dfc87, 0x3fdd481f95ed1fea,
+      0x3ff116b2ebc2463e, 0x3ff3c9e61ef57971, 0x3fdd481f95ed1fea, 0x3ff60fbc6cc7c4c6,
+      0x3ff8c2ef9ffaf7f9, 0x3fdd481f95ed1fea, 0x3ff60fbc6cc7c4c6, 0x3ff8c2ef9ffaf7f9,
+      0x3fda5a650317fd44, 0x3ff7fdc2fae6ce3d, 0x3ff7fdc2fae6ce3d, 0x3ff7fdc2fae6ce3d,
+      0x3fe6bdf25bf3c445, 0x3fe6bdf25bf3c445, 0x3ff07457427853da, 0x3ff07457427853da,
+   };
+   const EbmAttribute attributes[3] = { { AttributeTypeOrdinal, 0, 3 }, { AttributeTypeOrdinal, 0, 4 }, { AttributeTypeOrdinal, 0, 2 } };
+   const EbmAttributeCombination attributeCombinations[4] = { { 0 }, { 1 }, { 2 }, { 2 } };
+   const IntegerDataType attributeCombinationIndexes[5] = { 0, 0, 1, 1, 2 };
+   constexpr size_t cTrainingCases = 97;
+   constexpr size_t cValidationCases = 31;
+   std::vector<FractionalDataType> trainingTargets;
+   std::vector<FractionalDataType> validationTargets;
+   std::vector<IntegerDataType> trainingData(3 * cTrainingCases);
+   std::vector<IntegerDataType> validationData(3 * cValidationCases);
+   for(size_t iCase = 0; iCase < cTrainingCases; ++iCase) {
+      trainingData[iCase] = static_cast<IntegerDataType>((iCase * 7) % 3);
+      trainingData[cTrainingCases + iCase] = static_cast<IntegerDataType>((iCase * 5 + iCase / 3) % 4);
+      trainingData[2 * cTrainingCases + iCase] = static_cast<IntegerDataType>((iCase / 2) % 2);
+      trainingTargets.push_back(static_cast<FractionalDataType>((iCase * 37) % 23) / 3 + static_cast<FractionalDataType>(trainingData[iCase]) * 2.5 - static_cast<FractionalDataType>(trainingData[cTrainingCases + iCase] * trainingData[2 * cTrainingCases + iCase]));
+   }
+   for(size_t iCase = 0; iCase < cValidationCases; ++iCase) {
+      validationData[iCase] = static_cast<IntegerDataType>((iCase * 11) % 3);
+      validationData[cValidationCases + iCase] = static_cast<IntegerDataType>((iCase * 3 + 1) % 4);
+      validationData[2 * cValidationCases + iCase] = static_cast<IntegerDataType>((iCase / 3) % 2);
+      validationTargets.push_back(static_cast<FractionalDataType>((iCase * 13) % 17) / 7 + static_cast<FractionalDataType>(validationData[iCase]) * 2.5);
+   }
+
+   PEbmTraining pEbmTraining = InitializeTrainingRegression(randomSeed, 3, attributes, 4, attributeCombinations, attributeCombinationIndexes, cTrainingCases, &trainingTargets[0], &trainingData[0], nullptr, cValidationCases, &validationTargets[0], &validationData[0], nullptr, 0);
+   CHECK(nullptr != pEbmTraining);
+   std::vector<FractionalDataType> results;
+   for(int iEpoch = 0; iEpoch < 4; ++iEpoch) {
+      for(IntegerDataType iAttributeCombination = 0; iAttributeCombination < 4; ++iAttributeCombination) {
+         FractionalDataType validationMetric = FractionalDataType { 0 };
+         CHECK(0 == TrainingStep(pEbmTraining, iAttributeCombination, 0.1, 4, 10, nullptr, nullptr, &validationMetric));
+         results.push_back(validationMetric);
+      }
+   }
+   const size_t cModelValues[4] = { 1, 3, 12, 8 };
+   for(IntegerDataType iAttributeCombination = 0; iAttributeCombination < 4; ++iAttributeCombination) {
+      const FractionalDataType * const aModel = GetCurrentModel(pEbmTraining, iAttributeCombination);
+      results.insert(results.end(), aModel, aModel + cModelValues[iAttributeCombination]);
+   }
+   FreeTraining(pEbmTraining);
+
+   CHECK(sizeof(k_expectedBits) / sizeof(k_expectedBits[0]) == results.size());
+   for(size_t iResult = 0; iResult < results.size(); ++iResult) {
+      uint64_t bits;
+      memcpy(&bits, &results[iResult], sizeof(bits));
+      CHECK(k_expectedBits[iResult] == bits);
+   }
+}
+
+TEST_CASE("binning each inner bag separately matches binning them all in one pass, training, regression") {
+   // a regression bucket is at least 16 bytes, so two bags of an attribute with a million states are over the limit on the fused scratch and each bag
+   // bins itself.  Empty bins are compressed away before splitting, so with the same data in the first 4 states both need to give exactly the same results
+   constexpr IntegerDataType countStatesLarge = (IntegerDataType { 1 } << 20) + 4;
+   const EbmAttribute attributesFused[1] = { { AttributeTypeOrdinal, 0, 4 } };
+   const EbmAttribute attributesPerBag[1] = { { AttributeTypeOrdinal, 0, countStatesLarge } };
+   const EbmAttributeCombination attributeCombinations[1] = { { 1 } };
+   const IntegerDataType attributeCombinationIndexes[1] = { 0 };
+   constexpr size_t cTrainingCases = 301;
+   constexpr size_t cValidationCases = 29;
+   std::vector<FractionalDataType> trainingTargets;
+   std::vector<FractionalDataType> validationTargets;
+   std::vector<IntegerDataType> trainingData;
+   std::vector<IntegerDataType> validationData;
+   for(size_t iCase = 0; iCase < cTrainingCases; ++iCase) {
+      trainingData.push_back(static_cast<IntegerDataType>((iCase * 5 + iCase / 7) % 4));
+      trainingTargets.push_back(static_cast<FractionalDataType>((iCase * 37) % 23) / 3 + static_cast<FractionalDataType>(trainingData[iCase]) * 1.5);
+   }
+   for(size_t iCase = 0; iCase < cValidationCases; ++iCase) {
+      validationData.push_back(static_cast<IntegerDataType>((iCase * 3 + 1) % 4));
+      validationTargets.push_back(static_cast<FractionalDataType>((iCase * 13) % 17) / 7 + static_cast<FractionalDataType>(validationData[iCase]) * 1.5);
+   }
+
+   PEbmTraining pEbmTrainingFused = InitializeTrainingRegression(randomSeed, 1, attributesFused, 1, attributeCombinations, attributeCombinationIndexes, cTrainingCases, &trainingTargets[0], &trainingData[0], nullptr, cValidationCases, &validationTargets[0], &validationData[0], nullptr, 3);
+   PEbmTraining pEbmTrainingPerBag = InitializeTrainingRegression(randomSeed, 1, attributesPerBag, 1, attributeCombinations, attributeCombinationIndexes, cTrainingCases, &trainingTargets[0], &trainingData[0], nullptr, cValidationCases, &validationTargets[0], &validationData[0], nullptr, 3);
+   CHECK(nullptr != pEbmTrainingFused);
+   CHECK(nullptr != pEbmTrainingPerBag);
+   for(int iEpoch = 0; iEpoch < 5; ++iEpoch) {
+      FractionalDataType validationMetricFused = FractionalDataType { 0 };
+      FractionalDataType validationMetricPerBag = FractionalDataType { 0 };
+      CHECK(0 == TrainingStep(pEbmTrainingFused, 0, k_learningRateDefault, 3, 2, nullptr, nullptr, &validationMetricFused));
+      CHECK(0 == TrainingStep(pEbmTrainingPerBag, 0, k_learningRateDefault, 3, 2, nullptr, nullptr, &validationMetricPerBag));
+      CHECK(validationMetricFused == validationMetricPerBag);
+   }
+   const FractionalDataType * const aModelFused = GetCurrentModel(pEbmTrainingFused, 0);
+   const FractionalDataType * const aModelPerBag = GetCurrentModel(pEbmTrainingPerBag, 0);
+   for(size_t iState = 0; iState < 4; ++iState) {
+      CHECK(aModelFused[iState] == aModelPerBag[iState]);
+   }
+   // the model splits between the states we used, so every state above them falls into the last split and repeats the value of the last used state
+   CHECK(aModelFused[3] == aModelPerBag[countStatesLarge - 1]);
+   FreeTraining(pEbmTrainingFused);
+   FreeTraining(pEbmTrainingPerBag);
+}
+
+TEST_CASE("binning each inner bag separately matches binning them all in one pass over many partitions, training, regression") {
+   // enough cases for the most partitions we use.  With 9 bags the fused scratch of an attribute with 1100 states fits under its limit and one with 2048
+   // states doesn't, so the second bins each bag separately.  Both need 11 bits per bin, so they pack the same way and get the same 64 partitions, and
+   // with the same data in the first 1000 states both need to merge exactly the same sums
+   constexpr size_t cTrainingCases = size_t { 64 } * 32768;
+   constexpr size_t cValidationCases = 997;
+   constexpr IntegerDataType countStatesUsed = 1000;
+   constexpr IntegerDataType countInnerBags = 9;
+   const EbmAttribute attributesFused[1] = { { AttributeTypeOrdinal, 0, 1100 } };
+   const EbmAttribute attributesPerBag[1] = { { AttributeTypeOrdinal, 0, 2048 } };
+   const EbmAttributeCombination attributeCombinations[1] = { { 1 } };
+   const IntegerDataType attributeCombinationIndexes[1] = { 0 };
+   std::vector<FractionalDataType> trainingTargets;
+   std::vector<FractionalDataType> validationTargets;
+   std::vector<IntegerDataType> trainingData;
+   std::vector<IntegerDataType> validationData;
+   for(size_t iCase = 0; iCase < cTrainingCases; ++iCase) {
+      // every bin gets cases from every partition, and the targets have many significant bits so that summing them in any other order would round differently
+      trainingData.push_back(static_cast<IntegerDataType>((iCase * 7919) % countStatesUsed));
+      trainingTargets.push_back(static_cast<FractionalDataType>(iCase % 1009) / 7 + FractionalDataType { 1 } / 3 + static_cast<FractionalDataType>(trainingData[iCase] % 10));
+   }
+   for(size_t iCase = 0; iCase < cValidationCases; ++iCase) {
+      validationData.push_back(static_cast<IntegerDataType>((iCase * 13) % countStatesUsed));
+      validationTargets.push_back(static_cast<FractionalDataType>(iCase % 17) / 7 + static_cast<FractionalDataType>(validationData[iCase] % 10));
+   }
+
+   // sampling without replacement keeps our bags to a bit per case
+   PEbmTraining pEbmTrainingFused = InitializeTrainingRegressionEx(randomSeed, 1, attributesFused, 1, attributeCombinations, attributeCombinationIndexes, cTrainingCases, &trainingTargets[0], &trainingData[0], nullptr, cValidationCases, &validationTargets[0], &validationData[0], nullptr, countInnerBags, TrainingOptionsSamplingWithoutReplacement);
+   PEbmTraining pEbmTrainingPerBag = InitializeTrainingRegressionEx(randomSeed, 1, attributesPerBag, 1, attributeCombinations, attributeCombinationIndexes, cTrainingCases, &trainingTargets[0], &trainingData[0], nullptr, cValidationCases, &validationTargets[0], &validationData[0], nullptr, countInnerBags, TrainingOptionsSamplingWithoutReplacement);
+   CHECK(nullptr != pEbmTrainingFused);
+   CHECK(nullptr != pEbmTrainingPerBag);
+   for(int iEpoch = 0; iEpoch < 3; ++iEpoch) {
+      FractionalDataType validationMetricFused = FractionalDataType { 0 };
+      FractionalDataType validationMetricPerBag = FractionalDataType { 0 };
+      CHECK(0 == TrainingStep(pEbmTrainingFused, 0, k_learningRateDefault, k_countTreeSplitsMaxDefault, 2, nullptr, nullptr, &validationMetricFused));
+      CHECK(0 == TrainingStep(pEbmTrainingPerBag, 0, k_learningRateDefault, k_countTreeSplitsMaxDefault, 2, nullptr, nullptr, &validationMetricPerBag));
+      CHECK(validationMetricFused == validationMetricPerBag);
+   }
+   const FractionalDataType * const aModelFused = GetCurrentModel(pEbmTrainingFused, 0);
+   const FractionalDataType * const aModelPerBag = GetCurrentModel(pEbmTrainingPerBag, 0);
+   for(size_t iState = 0; iState < static_cast<size_t>(countStatesUsed); ++iState) {
+      CHECK(aModelFused[iState] == aModelPerBag[iState]);
+   }
+   FreeTraining(pEbmTrainingFused);
+   FreeTraining(pEbmTrainingPerBag);
+}
+
+TEST_CASE("thread safe model update matches model update, training, multiclass") {
+   TestApi test = TestApi(3);
+   test.AddAttributes({ Attribute(2), Attribute(3) });
+   test.AddAttributeCombinations({ { 0, 1 } });
+   test.AddTrainingCases({
+      ClassificationCase(0, { 0, 0 }),
+      ClassificationCase(1, { 0, 1 }),
+      ClassificationCase(2, { 1, 2 }),
+      ClassificationCase(1, { 1, 0 }),
+      ClassificationCase(0, { 1, 1 }),
+      });
+   test.AddValidationCases({ ClassificationCase(1, { 0, 1 }) });
+   test.InitializeTraining(3);
+
+   for(int iEpoch = 0; iEpoch < 3; ++iEpoch) {
+      // neither of these modifies the model, and the sampling sets are fixed at initialization, so both need to produce the same update
+      const std::vector<FractionalDataType> modelUpdateThreadSafe = test.GenerateUpdate(0, true);
+      const std::vector<FractionalDataType> modelUpdate = test.GenerateUpdate(0, false);
+      CHECK(modelUpdateThreadSafe.size() == modelUpdate.size());
+      for(size_t iItem = 0; iItem < modelUpdate.size(); ++iItem) {
+         CHECK(modelUpdateThreadSafe[iItem] == modelUpdate[iItem]);
+      }
+      test.Train(0);
+   }
+}
+
+TEST_CASE("a rejected model update leaves the model unchanged, training, multiclass") {
+   TestApi testRejected = TestApi(3);
+   TestApi testClean = TestApi(3);
+   for(TestApi * pTest : { &testRejected, &testClean }) {
+      pTest->AddAttributes({ Attribute(2), Attribute(3) });
+      pTest->AddAttributeCombinations({ { 0, 1 } });
+      pTest->AddTrainingCases({
+         ClassificationCase(0, { 0, 0 }),
+         ClassificationCase(1, { 0, 1 }),
+         ClassificationCase(2, { 1, 2 }),
+         ClassificationCase(1, { 1, 0 }),
+         ClassificationCase(0, { 1, 1 }),
+         });
+      pTest->AddValidationCases({ ClassificationCase(1, { 0, 1 }), ClassificationCase(2, { 1, 2 }) });
+      pTest->InitializeTraining();
+      for(int iEpoch = 0; iEpoch < 3; ++iEpoch) {
+         pTest->Train(0);
+      }
+   }
+
+   // a real update with one poisoned value, so that every other value would have changed the model if we had applied it
+   std::vector<FractionalDataType> modelUpdate = testRejected.GenerateUpdate(0, false);
+   modelUpdate[modelUpdate.size() / 2] = std::numeric_limits<FractionalDataType>::quiet_NaN();
+   FractionalDataType validationMetric = FractionalDataType { 1 };
+   CHECK(0 != testRejected.ApplyUpdate(0, modelUpdate, &validationMetric));
+   CHECK(0 == validationMetric);
+   modelUpdate[modelUpdate.size() / 2] = std::numeric_limits<FractionalDataType>::infinity();
+   CHECK(0 != testRejected.ApplyUpdate(0, modelUpdate, nullptr));
+
+   // the residuals and prediction scores are hidden, but if either had changed then training onwards from here would diverge from a booster that never saw
+   // the rejected updates
+   for(int iEpoch = 0; iEpoch < 3; ++iEpoch) {
+      for(size_t iState0 = 0; iState0 < 2; ++iState0) {
+         for(size_t iState1 = 0; iState1 < 3; ++iState1) {
+            for(size_t iTargetState = 0; iTargetState < 3; ++iTargetState) {
+               CHECK(testClean.GetCurrentModelValue(0, { iState0, iState1 }, iTargetState) == testRejected.GetCurrentModelValue(0, { iState0, iState1 }, iTargetState));
+               CHECK(testClean.GetBestModelValue(0, { iState0, iState1 }, iTargetState) == testRejected.GetBestModelValue(0, { iState0, iState1 }, iTargetState));
+            }
+         }
+      }
+      CHECK(testClean.Train(0) == testRejected.Train(0));
+   }
+}
+
+TEST_CASE("sampling without replacement with identical targets, training, regression") {
+   // every bag holds a different half of the cases, but every case has the same target, so every bag should still generate the same update
+   TestApi test = TestApi(k_learningTypeRegression);
+   test.AddAttributes({ Attribute(2) });
+   test.AddAttributeCombinations({ { 0 } });
+   test.AddTrainingCases({
+      RegressionCase(10, { 0 }),
+      RegressionCase(10, { 1 }),
+      RegressionCase(10, { 0 }),
+      RegressionCase(10, { 1 }),
+      });
+   test.AddValidationCases({ RegressionCase(12, { 1 }) });
+   test.InitializeTraining(8, TrainingOptionsSamplingWithoutReplacement);
+
+   FractionalDataType validationMetric = test.Train(0);
+   CHECK_APPROX(validationMetric, 11.900000000000000);
+   FractionalDataType modelValue = test.GetCurrentModelValue(0, { 0 }, 0);
+   CHECK_APPROX(modelValue, 0.1000000000000000);
+   modelValue = test.GetCurrentModelValue(0, { 1 }, 0);
+   CHECK_APPROX(modelValue, 0.1000000000000000);
+}
+
+TEST_CASE("thread safe model update matches model update with sampling without replacement, training, multiclass") {
+   TestApi test = TestApi(3);
+   test.AddAttributes({ Attribute(2), Attribute(3) });
+   test.AddAttributeCombinations({ {}, { 0 }, { 0, 1 } });
+   test.AddTrainingCases({
+      ClassificationCase(0, { 0, 0 }),
+      ClassificationCase(1, { 0, 1 }),
+      ClassificationCase(2, { 1, 2 }),
+      ClassificationCase(1, { 1, 0 }),
+      ClassificationCase(0, { 1, 1 }),
+      });
+   test.AddValidationCases({ ClassificationCase(1, { 0, 1 }) });
+   test.InitializeTraining(3, TrainingOptionsSamplingWithoutReplacement | TrainingOptionsSinglePrecision);
+
+   for(int iEpoch = 0; iEpoch < 3; ++iEpoch) {
+      for(size_t iAttributeCombination = 0; iAttributeCombination < 3; ++iAttributeCombination) {
+         const std::vector<FractionalDataType> modelUpdateThreadSafe = test.GenerateUpdate(iAttributeCombination, true);
+         const std::vector<FractionalDataType> modelUpdate = test.GenerateUpdate(iAttributeCombination, false);
+         CHECK(modelUpdateThreadSafe.size() == modelUpdate.size());
+         for(size_t iItem = 0; iItem < modelUpdate.size(); ++iItem) {
+            CHECK(modelUpdateThreadSafe[iItem] == modelUpdate[iItem]);
+         }
+         test.Train(iAttributeCombination);
+      }
+   }
+}
+
+TEST_CASE("many cases split into chunks, training, regression") {
+   // replicating every case many times doesn't change the model or the RMSE, but it does push the training and validation sets over the size where we split them into chunks
+   constexpr size_t cReplicas = 20000;
+   const std::vector<RegressionCase> trainingCases = { RegressionCase(10, { 0, 1 }), RegressionCase(20, { 1, 2 }), RegressionCase(5, { 1, 0 }) };
+   const std::vector<RegressionCase> validationCases = { RegressionCase(12, { 0, 1 }), RegressionCase(18, { 1, 2 }) };
+   TestApi testSmall = TestApi(k_learningTypeRegression);
+   TestApi testLarge = TestApi(k_learningTypeRegression);
+   AddReplicatedCases(testSmall, { Attribute(2), Attribute(3) }, { { 0, 1 } }, trainingCases, 1, validationCases, 1);
+   AddReplicatedCases(testLarge, { Attribute(2), Attribute(3) }, { { 0, 1 } }, trainingCases, cReplicas, validationCases, cReplicas);
+   testSmall.InitializeTraining(0);
+   testLarge.InitializeTraining(0);
+
+   for(int iEpoch = 0; iEpoch < 5; ++iEpoch) {
+      const FractionalDataType validationMetricSmall = testSmall.Train(0);
+      const FractionalDataType validationMetricLarge = testLarge.Train(0);
+      CHECK_APPROX(validationMetricLarge, validationMetricSmall);
+   }
+   CHECK_APPROX(testLarge.GetCurrentModelValue(0, { 0, 1 }, 0), testSmall.GetCurrentModelValue(0, { 0, 1 }, 0));
+   CHECK_APPROX(testLarge.GetCurrentModelValue(0, { 1, 2 }, 0), testSmall.GetCurrentModelValue(0, { 1, 2 }, 0));
+   CHECK_APPROX(testLarge.GetCurrentModelValue(0, { 1, 0 }, 0), testSmall.GetCurrentModelValue(0, { 1, 0 }, 0));
+}
+
+
+TEST_CASE("validation metric over many chunks is exactly the serial sum, training, regression") {
+   // more than 3 chunks of validation cases for any chunk size we use, with a partial last chunk.  With 1 thread the chunks also run in several waves
+   constexpr size_t cValidationCases = 3 * 65536 + 7;
+   const EbmAttribute attribute = { AttributeTypeOrdinal, 0, 3 };
+   const EbmAttributeCombination attributeCombination = { 1 };
+   const IntegerDataType attributeCombinationIndex = 0;
+   const FractionalDataType trainingTargets[] = { 1, 2, 3 };
+   const IntegerDataType trainingData[] = { 0, 1, 2 };
+   std::vector<FractionalDataType> validationTargets;
+   std::vector<IntegerDataType> validationData;
+   for(size_t iCase = 0; iCase < cValidationCases; ++iCase) {
+      // targets with many significant bits, so that adding them in any other order would round differently
+      validationTargets.push_back(static_cast<FractionalDataType>(iCase % 1009) / 7 + FractionalDataType { 1 } / 3);
+      validationData.push_back(static_cast<IntegerDataType>(iCase % 3));
+   }
+   const FractionalDataType modelUpdates[2][3] = { { 0.3, -1.7, 2.9 }, { -0.11, 0.23, 0.05 } };
+
+   const IntegerDataType countThreads[2] = { 1, 4 };
+   for(size_t iRun = 0; iRun < 2; ++iRun) {
+      CHECK(0 == SetThreadCount(countThreads[iRun]));
+      PEbmTraining pEbmTraining = InitializeTrainingRegression(randomSeed, 1, &attribute, 1, &attributeCombination, &attributeCombinationIndex, 3, trainingTargets, trainingData, nullptr, cValidationCases, &validationTargets[0], &validationData[0], nullptr, 0);
+      CHECK(nullptr != pEbmTraining);
+
+      // our validation residuals start at the targets, and each model update is subtracted from them, so we can follow along one case at a time
+      std::vector<FractionalDataType> residuals = validationTargets;
+      for(const FractionalDataType * const aModelUpdate : modelUpdates) {
+         FractionalDataType validationMetric = FractionalDataType { 0 };
+         CHECK(0 == ApplyModelUpdate(pEbmTraining, 0, aModelUpdate, &validationMetric));
+         FractionalDataType sumSquareError = 0;
+         for(size_t iCase = 0; iCase < cValidationCases; ++iCase) {
+            residuals[iCase] = residuals[iCase] - aModelUpdate[iCase % 3];
+            sumSquareError += residuals[iCase] * residuals[iCase];
+         }
+         CHECK(std::sqrt(sumSquareError / static_cast<FractionalDataType>(cValidationCases)) == validationMetric);
+      }
+      FreeTraining(pEbmTraining);
+   }
+   CHECK(0 == SetThreadCount(0));
+}
+
+TEST_CASE("validation metric over many chunks does not depend on the thread count, training, multiclass") {
+   constexpr size_t cValidationCases = 3 * 65536 + 7;
+   std::vector<ClassificationCase> validationCases;
+   for(size_t iCase = 0; iCase < cValidationCases; ++iCase) {
+      validationCases.push_back(ClassificationCase(static_cast<IntegerDataType>(iCase % 3), { static_cast<IntegerDataType>(iCase % 5) }, { 0, static_cast<FractionalDataType>(iCase % 101) / 37, static_cast<FractionalDataType>(iCase % 13) / -11 }));
+   }
+   std::vector<FractionalDataType> validationMetrics[2];
+   const IntegerDataType countThreads[2] = { 1, 4 };
+   for(size_t iRun = 0; iRun < 2; ++iRun) {
+      CHECK(0 == SetThreadCount(countThreads[iRun]));
+      TestApi test = TestApi(3);
+      test.AddAttributes({ Attribute(5) });
+      test.AddAttributeCombinations({ { 0 } });
+      test.AddTrainingCases({ ClassificationCase(0, { 0 }), ClassificationCase(1, { 2 }), ClassificationCase(2, { 4 }) });
+      test.AddValidationCases(validationCases);
+      test.InitializeTraining();
+      for(int iEpoch = 0; iEpoch < 3; ++iEpoch) {
+         validationMetrics[iRun].push_back(test.Train(0));
+      }
+   }
+   // the per-case log losses are added in case order after the chunks finish, so even the last bit can't depend on how the chunks were spread over threads
+   CHECK(validationMetrics[0] == validationMetrics[1]);
+   CHECK(0 == SetThreadCount(0));
+}
+
+TEST_CASE("validation log loss over many chunks is exactly the sum of each case's log loss, training, binary") {
+   // the exact log loss kernel is the scalar libm calculation at every simd level, and we add the losses up in case order, so the metric needs to be bit
+   // identical to this loop.  The 5 state attribute packs 21 cases per data unit, so the chunks don't start on a boundary of the bit packed targets.
+   // With fast math each case's log loss is within k_fastMathRelativeError of the exact one, or within epsilon once it rounds to zero
+   constexpr size_t cValidationCases = 3 * 65536 + 7;
+   constexpr double k_fastMathRelativeError = 1e-9;
+   const EbmAttribute attribute = { AttributeTypeOrdinal, 0, 5 };
+   const EbmAttributeCombination attributeCombination = { 1 };
+   const IntegerDataType attributeCombinationIndex = 0;
+   const IntegerDataType trainingTargets[] = { 0, 1, 1 };
+   const IntegerDataType trainingData[] = { 0, 2, 4 };
+   std::vector<IntegerDataType> validationTargets;
+   std::vector<IntegerDataType> validationData;
+   for(size_t iCase = 0; iCase < cValidationCases; ++iCase) {
+      validationTargets.push_back(static_cast<IntegerDataType>((iCase * 7 / 3) % 2));
+      validationData.push_back(static_cast<IntegerDataType>(iCase % 5));
+   }
+   const FractionalDataType modelUpdates[2][5] = { { 0.3, -1.7, 2.9, 0.01, -4.5 }, { -0.11, 0.23, 0.05, 1.3, -0.7 } };
+
+   const IntegerDataType simdLevelOriginal = GetSimdLevel();
+   const IntegerDataType simdLevels[3] = { SimdLevelScalar, SimdLevelAvx2, SimdLevelAvx512 };
+   for(const IntegerDataType simdLevel : simdLevels) {
+      CHECK(0 == SetSimdLevel(simdLevel));
+      for(const IntegerDataType trainingOptions : { TrainingOptionsNone, TrainingOptionsFastMath }) {
+         PEbmTraining pEbmTraining = InitializeTrainingClassificationEx(randomSeed, 1, &attribute, 1, &attributeCombination, &attributeCombinationIndex, 2, 3, trainingTargets, trainingData, nullptr, cValidationCases, &validationTargets[0], &validationData[0], nullptr, 0, trainingOptions);
+         CHECK(nullptr != pEbmTraining);
+         std::vector<FractionalDataType> predictionScores(cValidationCases, FractionalDataType { 0 });
+         for(const FractionalDataType * const aModelUpdate : modelUpdates) {
+            FractionalDataType validationMetric = FractionalDataType { 0 };
+            CHECK(0 == ApplyModelUpdate(pEbmTraining, 0, aModelUpdate, &validationMetric));
+            FractionalDataType sumLogLoss = 0;
+            for(size_t iCase = 0; iCase < cValidationCases; ++iCase) {
+               predictionScores[iCase] = predictionScores[iCase] + aModelUpdate[validationData[iCase]];
+               sumLogLoss += std::log(1 + std::exp(0 == validationTargets[iCase] ? predictionScores[iCase] : -predictionScores[iCase]));
+            }
+            if(TrainingOptionsNone == trainingOptions) {
+               CHECK(sumLogLoss == validationMetric);
+            } else {
+               CHECK(std::abs(validationMetric - sumLogLoss) <= k_fastMathRelativeError * sumLogLoss + cValidationCases * std::numeric_limits<FractionalDataType>::epsilon());
+            }
+         }
+         FreeTraining(pEbmTraining);
+      }
+   }
+   CHECK(0 == SetSimdLevel(simdLevelOriginal));
+}
+
+TEST_CASE("validation log loss over many chunks is exactly the sum of each case's log loss, training, multiclass") {
+   // at the scalar level our exp and log kernels call std::exp and std::log, and we take each exp once for both the softmax denominator and the actual
+   // target state, so the metric needs to be bit identical to this loop.  The vectorized levels use our own exp, which is only within a few ULP of std::exp
+   constexpr size_t cValidationCases = 3 * 65536 + 7;
+   constexpr size_t cTargetStates = 3;
+   const EbmAttribute attribute = { AttributeTypeOrdinal, 0, 5 };
+   const EbmAttributeCombination attributeCombination = { 1 };
+   const IntegerDataType attributeCombinationIndex = 0;
+   const IntegerDataType trainingTargets[] = { 0, 1, 2 };
+   const IntegerDataType trainingData[] = { 0, 2, 4 };
+   std::vector<IntegerDataType> validationTargets;
+   std::vector<IntegerDataType> validationData;
+   for(size_t iCase = 0; iCase < cValidationCases; ++iCase) {
+      validationTargets.push_back(static_cast<IntegerDataType>((iCase * 7 / 3) % cTargetStates));
+      validationData.push_back(static_cast<IntegerDataType>(iCase % 5));
+   }
+   const FractionalDataType modelUpdates[2][5 * cTargetStates] = {
+      { 0.3, -1.7, 2.9, 0.01, -4.5, 0.7, -0.2, 1.1, 3.3, -0.9, 0.45, 2.2, -1.3, 0.6, -2.8 },
+      { -0.11, 0.23, 0.05, 1.3, -0.7, 0.19, 0.8, -1.6, 0.02, -0.35, 1.05, -0.04, 0.6, 0.3, -0.55 }
+   };
+
+   const IntegerDataType simdLevelOriginal = GetSimdLevel();
+   CHECK(0 == SetSimdLevel(SimdLevelScalar));
+   PEbmTraining pEbmTraining = InitializeTrainingClassification(randomSeed, 1, &attribute, 1, &attributeCombination, &attributeCombinationIndex, cTargetStates, 3, trainingTargets, trainingData, nullptr, cValidationCases, &validationTargets[0], &validationData[0], nullptr, 0);
+   CHECK(nullptr != pEbmTraining);
+   std::vector<FractionalDataType> predictionScores(cValidationCases * cTargetStates, FractionalDataType { 0 });
+   for(const FractionalDataType * const aModelUpdate : modelUpdates) {
+      FractionalDataType validationMetric = FractionalDataType { 0 };
+      CHECK(0 == ApplyModelUpdate(pEbmTraining, 0, aModelUpdate, &validationMetric));
+      FractionalDataType sumLogLoss = 0;
+      for(size_t iCase = 0; iCase < cValidationCases; ++iCase) {
+         FractionalDataType * const aCaseScores = &predictionScores[iCase * cTargetStates];
+         FractionalDataType sumExp = 0;
+         for(size_t iTargetState = 0; iTargetState < cTargetStates; ++iTargetState) {
+            aCaseScores[iTargetState] = aCaseScores[iTargetState] + aModelUpdate[static_cast<size_t>(validationData[iCase]) * cTargetStates + iTargetState];
+            sumExp += std::exp(aCaseScores[iTargetState]);
+         }
+         sumLogLoss += -std::log(std::exp(aCaseScores[static_cast<size_t>(validationTargets[iCase])]) / sumExp);
+      }
+      CHECK(sumLogLoss == validationMetric);
+   }
+   FreeTraining(pEbmTraining);
+   CHECK(0 == SetSimdLevel(simdLevelOriginal));
+}
+
+TEST_CASE("many cases binned in partitions, training, multiclass") {
+   // with enough training cases we split binning into partitions that each get their own histogram, which are then merged back together
+   constexpr size_t cReplicas = 40000;
+   const std::vector<ClassificationCase> trainingCases = { ClassificationCase(0, { 0, 1 }), ClassificationCase(1, { 1, 2 }), ClassificationCase(2, { 1, 0 }) };
+   const std::vector<ClassificationCase> validationCases = { ClassificationCase(0, { 0, 1 }), ClassificationCase(2, { 1, 2 }) };
+   TestApi testSmall = TestApi(3);
+   TestApi testLarge = TestApi(3);
+   AddReplicatedCases(testSmall, { Attribute(2), Attribute(3) }, { { 0 }, { 0, 1 } }, trainingCases, 1, validationCases, 1);
+   AddReplicatedCases(testLarge, { Attribute(2), Attribute(3) }, { { 0 }, { 0, 1 } }, trainingCases, cReplicas, validationCases, 1);
+   testSmall.InitializeTraining();
+   testLarge.InitializeTraining();
+
+   for(int iEpoch = 0; iEpoch < 5; ++iEpoch) {
+      for(size_t iAttributeCombination = 0; iAttributeCombination < 2; ++iAttributeCombination) {
+         const FractionalDataType validationMetricSmall = testSmall.Train(iAttributeCombination);
+         const FractionalDataType validationMetricLarge = testLarge.Train(iAttributeCombination);
+         CHECK_APPROX(validationMetricLarge, validationMetricSmall);
+      }
+   }
+   for(size_t iTargetState = 0; iTargetState < 3; ++iTargetState) {
+      CHECK_APPROX(testLarge.GetCurrentModelValue(1, { 0, 1 }, iTargetState), testSmall.GetCurrentModelValue(1, { 0, 1 }, iTargetState));
+      CHECK_APPROX(testLarge.GetCurrentModelValue(1, { 1, 2 }, iTargetState), testSmall.GetCurrentModelValue(1, { 1, 2 }, iTargetState));
+   }
+}
+
+TEST_CASE("binned partitions are merged in partition order, training, regression") {
+   // a 2 state attribute packs 64 cases per data unit and its histogram has 2 items, so GetBinPartitionCount splits 4 * 32768 + 1000 cases into partitions
+   // of 33024 cases.  With one split and a learning rate of 1, the update of each bin is its sum of targets divided by its count, and that sum needs to be
+   // each partition's sum in case order, added together in partition order, however many threads bin the partitions
+   constexpr size_t cCases = 4 * 32768 + 1000;
+   constexpr size_t cCasesPerPartition = 33024;
+   std::vector<RegressionCase> trainingCases;
+   FractionalDataType sumsSerial[2] = { 0, 0 };
+   FractionalDataType sumsPartition[2] = { 0, 0 };
+   FractionalDataType sumsMerged[2] = { 0, 0 };
+   size_t cCasesInBins[2] = { 0, 0 };
+   for(size_t iCase = 0; iCase < cCases; ++iCase) {
+      const size_t iBin = (iCase / 3) % 2;
+      // targets with many significant bits, so that adding them in any other order would round differently
+      const FractionalDataType target = static_cast<FractionalDataType>(iCase % 1009) / 7 + FractionalDataType { 1 } / 3 + static_cast<FractionalDataType>(iBin * 5);
+      trainingCases.push_back(RegressionCase(target, { static_cast<IntegerDataType>(iBin) }));
+      sumsSerial[iBin] += target;
+      sumsPartition[iBin] += target;
+      ++cCasesInBins[iBin];
+      if(cCasesPerPartition - 1 == iCase % cCasesPerPartition || cCases - 1 == iCase) {
+         for(size_t iBinMerge = 0; iBinMerge < 2; ++iBinMerge) {
+            sumsMerged[iBinMerge] += sumsPartition[iBinMerge];
+            sumsPartition[iBinMerge] = 0;
+         }
+      }
+   }
+   // otherwise we couldn't tell partitioned binning from a single serial pass
+   CHECK(sumsMerged[0] != sumsSerial[0] || sumsMerged[1] != sumsSerial[1]);
+
+   const IntegerDataType countThreads[2] = { 1, 4 };
+   for(size_t iRun = 0; iRun < 2; ++iRun) {
+      CHECK(0 == SetThreadCount(countThreads[iRun]));
+      TestApi test = TestApi(k_learningTypeRegression);
+      test.AddAttributes({ Attribute(2) });
+      test.AddAttributeCombinations({ { 0 } });
+      test.AddTrainingCases(trainingCases);
+      test.AddValidationCases({ RegressionCase(0, { 0 }) });
+      test.InitializeTraining(0);
+      const std::vector<FractionalDataType> modelUpdate = test.GenerateUpdate(0, false, 1, 1, 2);
+      CHECK(2 == modelUpdate.size());
+      // the tree takes the sum of the right side as the total of both bins minus the left side
+      CHECK(sumsMerged[0] / static_cast<FractionalDataType>(cCasesInBins[0]) == modelUpdate[0]);
+      CHECK((sumsMerged[0] + sumsMerged[1] - sumsMerged[0]) / static_cast<FractionalDataType>(cCasesInBins[1]) == modelUpdate[1]);
+   }
+   CHECK(0 == SetThreadCount(0));
+}
+
+TEST_CASE("huge pages arena matches default arena, training, multiclass") {
+   // the residuals alone are over 2MB here, so on linux our arena is allocated on huge page boundaries.  The option should never change the results
+   constexpr size_t cReplicas = 40000;
+   const std::vector<ClassificationCase> trainingCases = { ClassificationCase(0, { 0, 1 }), ClassificationCase(1, { 1, 2 }), ClassificationCase(2, { 1, 0 }) };
+   const std::vector<ClassificationCase> validationCases = { ClassificationCase(0, { 0, 1 }), ClassificationCase(2, { 1, 2 }) };
+   TestApi testDefault = TestApi(3);
+   TestApi testHugePages = TestApi(3);
+   AddReplicatedCases(testDefault, { Attribute(2), Attribute(3) }, { { 0 }, { 0, 1 } }, trainingCases, cReplicas, validationCases, 1);
+   AddReplicatedCases(testHugePages, { Attribute(2), Attribute(3) }, { { 0 }, { 0, 1 } }, trainingCases, cReplicas, validationCases, 1);
+   testDefault.InitializeTraining(0);
+   testHugePages.InitializeTraining(0, TrainingOptionsHugePages);
+
+   for(int iEpoch = 0; iEpoch < 3; ++iEpoch) {
+      for(size_t iAttributeCombination = 0; iAttributeCombination < 2; ++iAttributeCombination) {
+         const FractionalDataType validationMetricDefault = testDefault.Train(iAttributeCombination);
+         const FractionalDataType validationMetricHugePages = testHugePages.Train(iAttributeCombination);
+         CHECK(validationMetricHugePages == validationMetricDefault);
+      }
+   }
+   for(size_t iTargetState = 0; iTargetState < 3; ++iTargetState) {
+      CHECK(testHugePages.GetCurrentModelValue(1, { 1, 2 }, iTargetState) == testDefault.GetCurrentModelValue(1, { 1, 2 }, iTargetState));
+   }
+}
+
+TEST_CASE("out of core matches in memory, training, multiclass") {
+   // several stream blocks per pass, with inner bags so that we go through the fused binning too
+   constexpr size_t cReplicas = 50000;
+   constexpr IntegerDataType cInnerBags = 2;
+   const std::vector<ClassificationCase> trainingCases = { ClassificationCase(0, { 0, 1 }), ClassificationCase(1, { 4, 0 }), ClassificationCase(2, { 2, 1 }) };
+   const std::vector<ClassificationCase> validationCases = { ClassificationCase(2, { 0, 1 }), ClassificationCase(1, { 4, 0 }), ClassificationCase(0, { 3, 1 }) };
+   TestApi testMemory = TestApi(3);
+   TestApi testOutOfCore = TestApi(3);
+   AddReplicatedCases(testMemory, { Attribute(5), Attribute(2) }, { {}, { 0 }, { 0, 1 } }, trainingCases, cReplicas, validationCases, cReplicas);
+   AddReplicatedCases(testOutOfCore, { Attribute(5), Attribute(2) }, { {}, { 0 }, { 0, 1 } }, trainingCases, cReplicas, validationCases, cReplicas);
+   testMemory.InitializeTraining(cInnerBags);
+   testOutOfCore.InitializeTraining(cInnerBags, TrainingOptionsOutOfCore);
+
+   for(int iEpoch = 0; iEpoch < 3; ++iEpoch) {
+      for(size_t iAttributeCombination = 0; iAttributeCombination < 3; ++iAttributeCombination) {
+         const FractionalDataType validationMetricMemory = testMemory.Train(iAttributeCombination);
+         const FractionalDataType validationMetricOutOfCore = testOutOfCore.Train(iAttributeCombination);
+         CHECK(validationMetricOutOfCore == validationMetricMemory);
+      }
+   }
+   for(size_t iTargetState = 0; iTargetState < 3; ++iTargetState) {
+      CHECK(testOutOfCore.GetCurrentModelValue(1, { 3 }, iTargetState) == testMemory.GetCurrentModelValue(1, { 3 }, iTargetState));
+      CHECK(testOutOfCore.GetCurrentModelValue(2, { 4, 1 }, iTargetState) == testMemory.GetCurrentModelValue(2, { 4, 1 }, iTargetState));
+   }
+}
+
+TEST_CASE("every arena backing gives identical results, training, regression") {
+   // the backing only changes where the arena of our datasets lives, so in memory, huge pages and out of core training need to agree to the last bit, in
+   // both precisions.  With this many cases out of core training streams several blocks per pass, and the inner bags take us through the fused binning
+   constexpr size_t cReplicas = 50000;
+   const std::vector<RegressionCase> trainingCases = { RegressionCase(10.25, { 0, 1 }), RegressionCase(-3.5, { 4, 0 }), RegressionCase(7.125, { 2, 1 }) };
+   const std::vector<RegressionCase> validationCases = { RegressionCase(9, { 0, 1 }), RegressionCase(-2, { 4, 0 }), RegressionCase(1, { 3, 1 }) };
+   const IntegerDataType precisions[2] = { TrainingOptionsNone, TrainingOptionsSinglePrecision };
+   const IntegerDataType backings[3] = { TrainingOptionsNone, TrainingOptionsHugePages, TrainingOptionsOutOfCore };
+   for(const IntegerDataType precision : precisions) {
+      std::vector<FractionalDataType> results[3];
+      for(size_t iBacking = 0; iBacking < 3; ++iBacking) {
+         TestApi test = TestApi(k_learningTypeRegression);
+         AddReplicatedCases(test, { Attribute(5), Attribute(2) }, { {}, { 0 }, { 0, 1 } }, trainingCases, cReplicas, validationCases, cReplicas);
+         test.InitializeTraining(2, precision | backings[iBacking]);
+         for(int iEpoch = 0; iEpoch < 3; ++iEpoch) {
+            for(size_t iAttributeCombination = 0; iAttributeCombination < 3; ++iAttributeCombination) {
+               results[iBacking].push_back(test.Train(iAttributeCombination));
+            }
+         }
+         for(size_t iState0 = 0; iState0 < 5; ++iState0) {
+            for(size_t iState1 = 0; iState1 < 2; ++iState1) {
+               results[iBacking].push_back(test.GetCurrentModelValue(2, { iState0, iState1 }, 0));
+            }
+         }
+      }
+      CHECK(results[0] == results[1]);
+      CHECK(results[0] == results[2]);
+   }
+}
+
+#ifndef _WIN32
+TEST_CASE("out of core fails cleanly when the temporary file can't be created, training, regression") {
+   // we reserve every block of the temporary file before mapping it, so running out of disk, like not having a directory to put the file in, is an error
+   // return from InitializeTraining instead of a SIGBUS later on
+   const char * const directoryPathOriginal = getenv("TMPDIR");
+   const std::string directoryPathSaved = nullptr == directoryPathOriginal ? std::string() : std::string(directoryPathOriginal);
+   CHECK(0 == setenv("TMPDIR", "/nonexistent-ebm-test-directory", 1));
+
+   const EbmAttribute attributes[1] = { { AttributeTypeOrdinal, 0, 2 } };
+   const EbmAttributeCombination combinations[1] = { { 1 } };
+   const IntegerDataType combinationIndexes[1] = { 0 };
+   const FractionalDataType targets[2] = { 10, 20 };
+   const IntegerDataType data[2] = { 0, 1 };
+   PEbmTraining pEbmTraining = InitializeTrainingRegressionEx(randomSeed, 1, attributes, 1, combinations, combinationIndexes, 2, targets, data, nullptr, 2, targets, data, nullptr, 0, TrainingOptionsOutOfCore);
+   CHECK(nullptr == pEbmTraining);
+
+   if(nullptr == directoryPathOriginal) {
+      CHECK(0 == unsetenv("TMPDIR"));
+   } else {
+      CHECK(0 == setenv("TMPDIR", directoryPathSaved.c_str(), 1));
+   }
+}
+#endif // _WIN32
+
+TEST_CASE("replicated cases train the same model regardless of where they fall in our batches, training, binary") {
+   // 1000 and 1001 replicas give our binary residual kernel different batch boundaries and partial vectors at the end of each chunk
+   const std::vector<ClassificationCase> trainingCases = { ClassificationCase(0, { 0, 1 }), ClassificationCase(1, { 4, 0 }), ClassificationCase(1, { 2, 1 }) };
+   const std::vector<ClassificationCase> validationCases = { ClassificationCase(1, { 0, 1 }), ClassificationCase(1, { 4, 0 }), ClassificationCase(0, { 3, 1 }) };
+   TestApi test1000 = TestApi(2);
+   TestApi test1001 = TestApi(2);
+   AddReplicatedCases(test1000, { Attribute(5), Attribute(2) }, { {}, { 0 }, { 0, 1 } }, trainingCases, 1000, validationCases, 1000);
+   AddReplicatedCases(test1001, { Attribute(5), Attribute(2) }, { {}, { 0 }, { 0, 1 } }, trainingCases, 1001, validationCases, 1001);
+   test1000.InitializeTraining();
+   test1001.InitializeTraining();
+
+   for(int iEpoch = 0; iEpoch < 10; ++iEpoch) {
+      for(size_t iAttributeCombination = 0; iAttributeCombination < 3; ++iAttributeCombination) {
+         const FractionalDataType validationMetric1000 = test1000.Train(iAttributeCombination);
+         const FractionalDataType validationMetric1001 = test1001.Train(iAttributeCombination);
+         CHECK_APPROX(validationMetric1001, validationMetric1000);
+      }
+   }
+   CHECK_APPROX(test1001.GetCurrentModelValue(0, {}, 1), test1000.GetCurrentModelValue(0, {}, 1));
+   CHECK_APPROX(test1001.GetCurrentModelValue(1, { 4 }, 1), test1000.GetCurrentModelValue(1, { 4 }, 1));
+   CHECK_APPROX(test1001.GetCurrentModelValue(2, { 2, 1 }, 1), test1000.GetCurrentModelValue(2, { 2, 1 }, 1));
+}
+
+TEST_CASE("replicated cases train the same model regardless of where they fall in our batches, training, multiclass") {
+   // with 10 target states 204 cases fit into one buffer of exps, so 1000 and 1001 replicas split differently into batches
+   const std::vector<ClassificationCase> trainingCases = { ClassificationCase(0, { 0, 1 }), ClassificationCase(7, { 4, 0 }), ClassificationCase(9, { 2, 1 }) };
+   const std::vector<ClassificationCase> validationCases = { ClassificationCase(9, { 0, 1 }), ClassificationCase(7, { 4, 0 }), ClassificationCase(0, { 3, 1 }) };
+   TestApi test1000 = TestApi(10);
+   TestApi test1001 = TestApi(10);
+   AddReplicatedCases(test1000, { Attribute(5), Attribute(2) }, { {}, { 0 }, { 0, 1 } }, trainingCases, 1000, validationCases, 1000);
+   AddReplicatedCases(test1001, { Attribute(5), Attribute(2) }, { {}, { 0 }, { 0, 1 } }, trainingCases, 1001, validationCases, 1001);
+   test1000.InitializeTraining();
+   test1001.InitializeTraining();
+
+   for(int iEpoch = 0; iEpoch < 10; ++iEpoch) {
+      for(size_t iAttributeCombination = 0; iAttributeCombination < 3; ++iAttributeCombination) {
+         const FractionalDataType validationMetric1000 = test1000.Train(iAttributeCombination);
+         const FractionalDataType validationMetric1001 = test1001.Train(iAttributeCombination);
+         CHECK_APPROX(validationMetric1001, validationMetric1000);
+      }
+   }
+   for(size_t iTargetState = 0; iTargetState < 10; ++iTargetState) {
+      CHECK_APPROX(test1001.GetCurrentModelValue(1, { 4 }, iTargetState), test1000.GetCurrentModelValue(1, { 4 }, iTargetState));
+      CHECK_APPROX(test1001.GetCurrentModelValue(2, { 2, 1 }, iTargetState), test1000.GetCurrentModelValue(2, { 2, 1 }, iTargetState));
+   }
+}
+
+TEST_CASE("fast math trains within its error bound of exact math, training, binary") {
+   // our fast exp and log have a relative error below 1e-9, so after a few epochs our metrics and models should still agree to far better than 1e-6
+   constexpr double k_fastMathTolerance = 1e-6;
+   const std::vector<ClassificationCase> trainingCases = { ClassificationCase(0, { 0, 1 }), ClassificationCase(1, { 4, 0 }), ClassificationCase(1, { 2, 1 }) };
+   const std::vector<ClassificationCase> validationCases = { ClassificationCase(1, { 0, 1 }), ClassificationCase(1, { 4, 0 }), ClassificationCase(0, { 3, 1 }) };
+   TestApi testExact = TestApi(2);
+   TestApi testFast = TestApi(2);
+   // an odd number of cases leaves partial vectors at the end for our kernels
+   AddReplicatedCases(testExact, { Attribute(5), Attribute(2) }, { {}, { 0 }, { 0, 1 } }, trainingCases, 1001, validationCases, 1001);
+   AddReplicatedCases(testFast, { Attribute(5), Attribute(2) }, { {}, { 0 }, { 0, 1 } }, trainingCases, 1001, validationCases, 1001);
+   testExact.InitializeTraining();
+   testFast.InitializeTraining(k_countInnerBagsDefault, TrainingOptionsFastMath);
+
+   for(int iEpoch = 0; iEpoch < 10; ++iEpoch) {
+      for(size_t iAttributeCombination = 0; iAttributeCombination < 3; ++iAttributeCombination) {
+         const FractionalDataType validationMetricExact = testExact.Train(iAttributeCombination);
+         const FractionalDataType validationMetricFast = testFast.Train(iAttributeCombination);
+         CHECK(IsApproxEqual(validationMetricFast, validationMetricExact, k_fastMathTolerance));
+      }
+   }
+   CHECK(IsApproxEqual(testFast.GetCurrentModelValue(0, {}, 1), testExact.GetCurrentModelValue(0, {}, 1), k_fastMathTolerance));
+   CHECK(IsApproxEqual(testFast.GetCurrentModelValue(1, { 4 }, 1), testExact.GetCurrentModelValue(1, { 4 }, 1), k_fastMathTolerance));
+   CHECK(IsApproxEqual(testFast.GetCurrentModelValue(2, { 2, 1 }, 1), testExact.GetCurrentModelValue(2, { 2, 1 }, 1), k_fastMathTolerance));
+}
+
+TEST_CASE("fast math trains within its error bound of exact math, training, multiclass") {
+   constexpr double k_fastMathTolerance = 1e-6;
+   const std::vector<ClassificationCase> trainingCases = { ClassificationCase(0, { 0, 1 }), ClassificationCase(1, { 4, 0 }), ClassificationCase(2, { 2, 1 }) };
+   const std::vector<ClassificationCase> validationCases = { ClassificationCase(2, { 0, 1 }), ClassificationCase(1, { 4, 0 }), ClassificationCase(0, { 3, 1 }) };
+   TestApi testExact = TestApi(3);
+   TestApi testFast = TestApi(3);
+   AddReplicatedCases(testExact, { Attribute(5), Attribute(2) }, { {}, { 0 }, { 0, 1 } }, trainingCases, 1001, validationCases, 1001);
+   AddReplicatedCases(testFast, { Attribute(5), Attribute(2) }, { {}, { 0 }, { 0, 1 } }, trainingCases, 1001, validationCases, 1001);
+   testExact.InitializeTraining();
+   testFast.InitializeTraining(k_countInnerBagsDefault, TrainingOptionsFastMath);
+
+   for(int iEpoch = 0; iEpoch < 10; ++iEpoch) {
+      for(size_t iAttributeCombination = 0; iAttributeCombination < 3; ++iAttributeCombination) {
+         const FractionalDataType validationMetricExact = testExact.Train(iAttributeCombination);
+         const FractionalDataType validationMetricFast = testFast.Train(iAttributeCombination);
+         CHECK(IsApproxEqual(validationMetricFast, validationMetricExact, k_fastMathTolerance));
+      }
+   }
+   for(size_t iTargetState = 0; iTargetState < 3; ++iTargetState) {
+      CHECK(IsApproxEqual(testFast.GetCurrentModelValue(1, { 4 }, iTargetState), testExact.GetCurrentModelValue(1, { 4 }, iTargetState), k_fastMathTolerance));
+      CHECK(IsApproxEqual(testFast.GetCurrentModelValue(2, { 2, 1 }, iTargetState), testExact.GetCurrentModelValue(2, { 2, 1 }, iTargetState), k_fastMathTolerance));
+   }
+}
+
+TEST_CASE("memory usage matches estimate, training, multiclass") {
+   // enough cases for our histograms to be binned in parallel partitions and fused across our inner bags
+   constexpr size_t cReplicas = 20000;
+   constexpr IntegerDataType cInnerBags = 3;
+   const std::vector<ClassificationCase> trainingCases = { ClassificationCase(0, { 0, 1 }), ClassificationCase(1, { 4, 0 }), ClassificationCase(2, { 2, 1 }) };
+   const std::vector<ClassificationCase> validationCases = { ClassificationCase(2, { 0, 1 }), ClassificationCase(1, { 4, 0 }) };
+   TestApi test = TestApi(3);
+   AddReplicatedCases(test, { Attribute(5), Attribute(2) }, { {}, { 0 }, { 0, 1 } }, trainingCases, cReplicas, validationCases, 1);
+   const EbmMemoryUsage estimate = test.EstimateTrainingMemory(cInnerBags);
+   test.InitializeTraining(cInnerBags);
+
+   const EbmMemoryUsage initial = test.GetMemoryUsage();
+   CHECK(initial.peakBytes == initial.currentBytes);
+   for(int iEpoch = 0; iEpoch < 2; ++iEpoch) {
+      for(size_t iAttributeCombination = 0; iAttributeCombination < 3; ++iAttributeCombination) {
+         test.Train(iAttributeCombination);
+      }
+   }
+   const EbmMemoryUsage measured = test.GetMemoryUsage();
+   CHECK(initial.currentBytes < measured.currentBytes);
+   CHECK(measured.currentBytes <= measured.peakBytes);
+   CHECK(measured.currentBytes == measured.packedDataBytes + measured.residualBytes + measured.samplingSetBytes + measured.histogramBufferBytes + measured.modelBytes + measured.otherBytes);
+
+   CHECK(estimate.packedDataBytes == measured.packedDataBytes);
+   CHECK(estimate.residualBytes == measured.residualBytes);
+   CHECK(estimate.samplingSetBytes == measured.samplingSetBytes);
+   CHECK(estimate.otherBytes == measured.otherBytes);
+   CHECK(0 < measured.histogramBufferBytes);
+   CHECK(measured.histogramBufferBytes <= estimate.histogramBufferBytes);
+   CHECK(measured.modelBytes <= estimate.modelBytes);
+   CHECK(measured.peakBytes <= estimate.peakBytes);
+}
+
+TEST_CASE("memory usage is within the estimate for every option, training, regression") {
+   // enough cases for partitioned binning, and with inner bags for the fused binning.  Only the histogram buffers and the models depend on the splits that we
+   // find, so those are upper bounds and everything else is exact, which means the peak can only be over by the slack in those two.  Their slack is
+   // what our buffers might still grow into, which shouldn't be more than we've already allocated
+   constexpr size_t cReplicas = 30000;
+   const std::vector<RegressionCase> trainingCases = { RegressionCase(10, { 0, 1 }), RegressionCase(-3, { 4, 0 }), RegressionCase(7, { 2, 1 }) };
+   const std::vector<RegressionCase> validationCases = { RegressionCase(9, { 0, 1 }), RegressionCase(-2, { 4, 0 }) };
+   const IntegerDataType trainingOptionsAll[4] = { TrainingOptionsNone, TrainingOptionsSinglePrecision, TrainingOptionsSamplingWithoutReplacement, TrainingOptionsOutOfCore };
+   const IntegerDataType countInnerBagsAll[2] = { 0, 3 };
+   for(const IntegerDataType trainingOptions : trainingOptionsAll) {
+      for(const IntegerDataType countInnerBags : countInnerBagsAll) {
+         TestApi test = TestApi(k_learningTypeRegression);
+         AddReplicatedCases(test, { Attribute(5), Attribute(2) }, { {}, { 0 }, { 0, 1 } }, trainingCases, cReplicas, validationCases, 1);
+         const EbmMemoryUsage estimate = test.EstimateTrainingMemory(countInnerBags, trainingOptions);
+         test.InitializeTraining(countInnerBags, trainingOptions);
+         for(size_t iAttributeCombination = 0; iAttributeCombination < 3; ++iAttributeCombination) {
+            test.Train(iAttributeCombination);
+         }
+         const EbmMemoryUsage measured = test.GetMemoryUsage();
+         CHECK(estimate.packedDataBytes == measured.packedDataBytes);
+         CHECK(estimate.residualBytes == measured.residualBytes);
+         CHECK(estimate.samplingSetBytes == measured.samplingSetBytes);
+         CHECK(estimate.otherBytes == measured.otherBytes);
+         CHECK(0 < measured.histogramBufferBytes);
+         CHECK(measured.histogramBufferBytes <= estimate.histogramBufferBytes);
+         CHECK(0 < measured.modelBytes);
+         CHECK(measured.modelBytes <= estimate.modelBytes);
+         CHECK(measured.peakBytes <= estimate.peakBytes);
+         CHECK(estimate.histogramBufferBytes <= 2 * measured.histogramBufferBytes);
+         CHECK(estimate.peakBytes - measured.peakBytes == estimate.histogramBufferBytes - measured.histogramBufferBytes + estimate.modelBytes - measured.modelBytes);
+      }
+   }
+}
+
+TEST_CASE("memory usage is within the estimate when the fused binning scratch would be over its limit, training, regression") {
+   // two bags of a million bins are over the limit on the fused scratch, so we bin each bag separately and the estimate needs to leave the fused scratch out
+   const IntegerDataType countStatesLarge = (IntegerDataType { 1 } << 20) + 4;
+   const std::vector<RegressionCase> trainingCases = { RegressionCase(10, { 0 }), RegressionCase(-3, { 3 }), RegressionCase(7, { 2 }) };
+   const std::vector<RegressionCase> validationCases = { RegressionCase(9, { 0 }) };
+   TestApi test = TestApi(k_learningTypeRegression);
+   AddReplicatedCases(test, { Attribute(countStatesLarge) }, { { 0 } }, trainingCases, 100, validationCases, 1);
+   const EbmMemoryUsage estimate = test.EstimateTrainingMemory(2);
+   test.InitializeTraining(2);
+   test.Train(0);
+   const EbmMemoryUsage measured = test.GetMemoryUsage();
+   CHECK(measured.histogramBufferBytes <= estimate.histogramBufferBytes);
+   CHECK(measured.peakBytes <= estimate.peakBytes);
+}
+
+TEST_CASE("many cases with bit packed targets split into chunks, training, multiclass") {
+   // the 5 state attribute packs 21 cases per data unit, so our apply model update chunks don't start on a boundary of our 2 bit packed targets
+   constexpr size_t cReplicas = 20000;
+   const std::vector<ClassificationCase> trainingCases = { ClassificationCase(0, { 0, 1 }), ClassificationCase(1, { 4, 0 }), ClassificationCase(2, { 2, 1 }) };
+   const std::vector<ClassificationCase> validationCases = { ClassificationCase(2, { 0, 1 }), ClassificationCase(1, { 4, 0 }), ClassificationCase(0, { 3, 1 }) };
+   TestApi testSmall = TestApi(3);
+   TestApi testLarge = TestApi(3);
+   AddReplicatedCases(testSmall, { Attribute(5), Attribute(2) }, { {}, { 0 }, { 0, 1 } }, trainingCases, 1, validationCases, 1);
+   AddReplicatedCases(testLarge, { Attribute(5), Attribute(2) }, { {}, { 0 }, { 0, 1 } }, trainingCases, cReplicas, validationCases, cReplicas);
+   testSmall.InitializeTraining(0);
+   testLarge.InitializeTraining(0);
+
+   for(int iEpoch = 0; iEpoch < 3; ++iEpoch) {
+      for(size_t iAttributeCombination = 0; iAttributeCombination < 3; ++iAttributeCombination) {
+         const FractionalDataType validationMetricSmall = testSmall.Train(iAttributeCombination);
+         const FractionalDataType validationMetricLarge = testLarge.Train(iAttributeCombination);
+         // the log loss is summed over the validation cases, and we have cReplicas times as many of them
+         CHECK_APPROX(validationMetricLarge / static_cast<FractionalDataType>(cReplicas), validationMetricSmall);
+      }
+   }
+   for(size_t iTargetState = 0; iTargetState < 3; ++iTargetState) {
+      CHECK_APPROX(testLarge.GetCurrentModelValue(2, { 0, 1 }, iTargetState), testSmall.GetCurrentModelValue(2, { 0, 1 }, iTargetState));
+      CHECK_APPROX(testLarge.GetCurrentModelValue(2, { 4, 0 }, iTargetState), testSmall.GetCurrentModelValue(2, { 4, 0 }, iTargetState));
+   }
+}
+
+TEST_CASE("single precision matches double precision, training, regression") {
+   // single precision only changes how we store the residuals, so the models and metrics should agree to within float rounding
+   TestApi testDouble = TestApi(k_learningTypeRegression);
+   TestApi testSingle = TestApi(k_learningTypeRegression);
+   for(TestApi * pTest : { &testDouble, &testSingle }) {
+      pTest->AddAttributes({ Attribute(2), Attribute(3) });
+      pTest->AddAttributeCombinations({ {}, { 0 }, { 0, 1 } });
+      pTest->AddTrainingCases({ RegressionCase(10, { 0, 1 }), RegressionCase(20, { 1, 2 }), RegressionCase(5, { 1, 0 }), RegressionCase(7.5, { 0, 2 }) });
+      pTest->AddValidationCases({ RegressionCase(12, { 0, 1 }), RegressionCase(18, { 1, 2 }) });
+   }
+   testDouble.InitializeTraining(2);
+   testSingle.InitializeTraining(2, TrainingOptionsSinglePrecision);
+
+   for(int iEpoch = 0; iEpoch < 20; ++iEpoch) {
+      for(size_t iAttributeCombination = 0; iAttributeCombination < 3; ++iAttributeCombination) {
+         const FractionalDataType validationMetricDouble = testDouble.Train(iAttributeCombination);
+         const FractionalDataType validationMetricSingle = testSingle.Train(iAttributeCombination);
+         CHECK_APPROX(validationMetricSingle, validationMetricDouble);
+      }
+   }
+   CHECK_APPROX(testSingle.GetCurrentModelValue(2, { 0, 1 }, 0), testDouble.GetCurrentModelValue(2, { 0, 1 }, 0));
+   CHECK_APPROX(testSingle.GetCurrentModelValue(2, { 1, 2 }, 0), testDouble.GetCurrentModelValue(2, { 1, 2 }, 0));
+}
+
+TEST_CASE("single precision matches double precision, training, multiclass") {
+   TestApi testDouble = TestApi(3);
+   TestApi testSingle = TestApi(3);
+   for(TestApi * pTest : { &testDouble, &testSingle }) {
+      pTest->AddAttributes({ Attribute(2), Attribute(3) });
+      pTest->AddAttributeCombinations({ {}, { 0 }, { 0, 1 } });
+      pTest->AddTrainingCases({ ClassificationCase(0, { 0, 1 }), ClassificationCase(1, { 1, 2 }), ClassificationCase(2, { 1, 0 }), ClassificationCase(1, { 0, 2 }) });
+      pTest->AddValidationCases({ ClassificationCase(0, { 0, 1 }), ClassificationCase(2, { 1, 2 }) });
+   }
+   testDouble.InitializeTraining(2);
+   testSingle.InitializeTraining(2, TrainingOptionsSinglePrecision);
+
+   for(int iEpoch = 0; iEpoch < 20; ++iEpoch) {
+      for(size_t iAttributeCombination = 0; iAttributeCombination < 3; ++iAttributeCombination) {
+         const FractionalDataType validationMetricDouble = testDouble.Train(iAttributeCombination);
+         const FractionalDataType validationMetricSingle = testSingle.Train(iAttributeCombination);
+         CHECK_APPROX(validationMetricSingle, validationMetricDouble);
+      }
+   }
+   for(size_t iTargetState = 0; iTargetState < 3; ++iTargetState) {
+      CHECK_APPROX(testSingle.GetCurrentModelValue(2, { 0, 1 }, iTargetState), testDouble.GetCurrentModelValue(2, { 0, 1 }, iTargetState));
+      CHECK_APPROX(testSingle.GetCurrentModelValue(2, { 1, 2 }, iTargetState), testDouble.GetCurrentModelValue(2, { 1, 2 }, iTargetState));
+   }
+}
+
+TEST_CASE("narrow strided columns match int64 matrix, training, multiclass") {
+   EbmAttribute attributes[2];
+   attributes[0].attributeType = AttributeTypeOrdinal;
+   attributes[0].hasMissing = 0;
+   attributes[0].countStates = 3;
+   attributes[1].attributeType = AttributeTypeOrdinal;
+   attributes[1].hasMissing = 0;
+   attributes[1].countStates = 2;
+   EbmAttributeCombination combinations[2];
+   combinations[0].countAttributesInCombination = 1;
+   combinations[1].countAttributesInCombination = 2;
+   const IntegerDataType combinationIndexes[] = { 0, 0, 1 };
+
+   const IntegerDataType trainingTargets[] = { 0, 1, 2, 1, 0, 2 };
+   const IntegerDataType validationTargets[] = { 1, 2, 0 };
+
+   // Fortran ordered, so all the values of attribute 0 come before attribute 1
+   const IntegerDataType trainingData[] = { 0, 1, 2, 2, 1, 0, 1, 0, 1, 1, 0, 0 };
+   const IntegerDataType validationData[] = { 1, 2, 0, 0, 1, 1 };
+
+   // row ordered uint8 for training, so each column skips over the other attribute
+   const uint8_t trainingRows[] = { 0, 1, 1, 0, 2, 1, 2, 1, 1, 0, 0, 0 };
+   EbmDataColumn trainingColumns[2];
+   trainingColumns[0].data = &trainingRows[0];
+   trainingColumns[0].dataType = DataColumnTypeUInt8;
+   trainingColumns[0].strideBytes = 2;
+   trainingColumns[1].data = &trainingRows[1];
+   trainingColumns[1].dataType = DataColumnTypeUInt8;
+   trainingColumns[1].strideBytes = 2;
+
+   // mixed widths for validation
+   const uint16_t validationAttribute0[] = { 1, 2, 0 };
+   const uint32_t validationAttribute1[] = { 0, 1, 1 };
+   EbmDataColumn validationColumns[2];
+   validationColumns[0].data = &validationAttribute0[0];
+   validationColumns[0].dataType = DataColumnTypeUInt16;
+   validationColumns[0].strideBytes = sizeof(uint16_t);
+   validationColumns[1].data = &validationAttribute1[0];
+   validationColumns[1].dataType = DataColumnTypeUInt32;
+   validationColumns[1].strideBytes = sizeof(uint32_t);
+
+   PEbmTraining pEbmTrainingInt64 = InitializeTrainingClassification(randomSeed, 2, attributes, 2, combinations, combinationIndexes, 3, 6, trainingTargets, trainingData, nullptr, 3, validationTargets, validationData, nullptr, 2);
+   PEbmTraining pEbmTrainingColumns = InitializeTrainingClassificationColumns(randomSeed, 2, attributes, 2, combinations, combinationIndexes, 3, 6, trainingTargets, trainingColumns, nullptr, 3, validationTargets, validationColumns, nullptr, 2, TrainingOptionsNone);
+   CHECK(nullptr != pEbmTrainingInt64);
+   CHECK(nullptr != pEbmTrainingColumns);
+
+   for(int iEpoch = 0; iEpoch < 10; ++iEpoch) {
+      for(IntegerDataType iAttributeCombination = 0; iAttributeCombination < 2; ++iAttributeCombination) {
+         FractionalDataType validationMetricInt64 = FractionalDataType { 0 };
+         FractionalDataType validationMetricColumns = FractionalDataType { 0 };
+         CHECK(0 == TrainingStep(pEbmTrainingInt64, iAttributeCombination, k_learningRateDefault, k_countTreeSplitsMaxDefault, k_countCasesRequiredForSplitParentMinDefault, nullptr, nullptr, &validationMetricInt64));
+         CHECK(0 == TrainingStep(pEbmTrainingColumns, iAttributeCombination, k_learningRateDefault, k_countTreeSplitsMaxDefault, k_countCasesRequiredForSplitParentMinDefault, nullptr, nullptr, &validationMetricColumns));
+         CHECK(validationMetricColumns == validationMetricInt64);
+      }
+   }
+   FreeTraining(pEbmTrainingInt64);
+   FreeTraining(pEbmTrainingColumns);
+}
+
+TEST_CASE("narrow strided columns match int64 matrix, interaction, binary") {
+   EbmAttribute attributes[2];
+   attributes[0].attributeType = AttributeTypeOrdinal;
+   attributes[0].hasMissing = 0;
+   attributes[0].countStates = 3;
+   attributes[1].attributeType = AttributeTypeOrdinal;
+   attributes[1].hasMissing = 0;
+   attributes[1].countStates = 2;
+
+   const IntegerDataType targets[] = { 0, 1, 1, 1, 0, 0 };
+   const IntegerDataType data[] = { 0, 1, 2, 2, 1, 0, 1, 0, 1, 1, 0, 0 };
+   const uint8_t rows[] = { 0, 1, 1, 0, 2, 1, 2, 1, 1, 0, 0, 0 };
+   EbmDataColumn columns[2];
+   columns[0].data = &rows[0];
+   columns[0].dataType = DataColumnTypeUInt8;
+   columns[0].strideBytes = 2;
+   columns[1].data = &rows[1];
+   columns[1].dataType = DataColumnTypeUInt8;
+   columns[1].strideBytes = 2;
+
+   PEbmInteraction pEbmInteractionInt64 = InitializeInteractionClassification(2, attributes, 2, 6, targets, data, nullptr);
+   PEbmInteraction pEbmInteractionColumns = InitializeInteractionClassificationColumns(2, attributes, 2, 6, targets, columns, nullptr);
+   CHECK(nullptr != pEbmInteractionInt64);
+   CHECK(nullptr != pEbmInteractionColumns);
+
+   const IntegerDataType attributeIndexes[] = { 0, 1 };
+   FractionalDataType interactionScoreInt64 = FractionalDataType { 0 };
+   FractionalDataType interactionScoreColumns = FractionalDataType { 0 };
+   CHECK(0 == GetInteractionScore(pEbmInteractionInt64, 2, attributeIndexes, &interactionScoreInt64));
+   CHECK(0 == GetInteractionScore(pEbmInteractionColumns, 2, attributeIndexes, &interactionScoreColumns));
+   CHECK(0 < interactionScoreInt64);
+   CHECK(interactionScoreColumns == interactionScoreInt64);
+
+   // an unknown column type is rejected instead of being read as garbage
+   columns[1].dataType = 99;
+   PEbmInteraction pEbmInteractionBad = InitializeInteractionClassificationColumns(2, attributes, 2, 6, targets, columns, nullptr);
+   CHECK(nullptr == pEbmInteractionBad);
+
+   FreeInteraction(pEbmInteractionInt64);
+   FreeInteraction(pEbmInteractionColumns);
+}
+
+TEST_CASE("shared dataset matches int64 matrix, training and interaction, multiclass") {
+   EbmAttribute attributes[2];
+   attributes[0].attributeType = AttributeTypeOrdinal;
+   attributes[0].hasMissing = 0;
+   attributes[0].countStates = 3;
+   attributes[1].attributeType = AttributeTypeOrdinal;
+   attributes[1].hasMissing = 0;
+   attributes[1].countStates = 2;
+   EbmAttributeCombination combinations[2];
+   combinations[0].countAttributesInCombination = 1;
+   combinations[1].countAttributesInCombination = 2;
+   const IntegerDataType combinationIndexes[] = { 0, 0, 1 };
+
+   const IntegerDataType trainingTargets[] = { 0, 1, 2, 1, 0, 2 };
+   const IntegerDataType validationTargets[] = { 1, 2, 0 };
+   const IntegerDataType trainingData[] = { 0, 1, 2, 2, 1, 0, 1, 0, 1, 1, 0, 0 };
+   const IntegerDataType validationData[] = { 1, 2, 0, 0, 1, 1 };
+
+   const uint8_t trainingRows[] = { 0, 1, 1, 0, 2, 1, 2, 1, 1, 0, 0, 0 };
+   EbmDataColumn trainingColumns[2];
+   trainingColumns[0].data = &trainingRows[0];
+   trainingColumns[0].dataType = DataColumnTypeUInt8;
+   trainingColumns[0].strideBytes = 2;
+   trainingColumns[1].data = &trainingRows[1];
+   trainingColumns[1].dataType = DataColumnTypeUInt8;
+   trainingColumns[1].strideBytes = 2;
+   EbmDataColumn validationColumns[2];
+   validationColumns[0].data = &validationData[0];
+   validationColumns[0].dataType = DataColumnTypeInt64;
+   validationColumns[0].strideBytes = sizeof(IntegerDataType);
+   validationColumns[1].data = &validationData[3];
+   validationColumns[1].dataType = DataColumnTypeInt64;
+   validationColumns[1].strideBytes = sizeof(IntegerDataType);
+
+   PEbmDataSet pEbmDataSetTraining = InitializeDataSet(2, attributes, 6, trainingColumns);
+   PEbmDataSet pEbmDataSetValidation = InitializeDataSet(2, attributes, 3, validationColumns);
+   CHECK(nullptr != pEbmDataSetTraining);
+   CHECK(nullptr != pEbmDataSetValidation);
+
+   PEbmTraining pEbmTrainingInt64 = InitializeTrainingClassification(randomSeed, 2, attributes, 2, combinations, combinationIndexes, 3, 6, trainingTargets, trainingData, nullptr, 3, validationTargets, validationData, nullptr, 2);
+   PEbmTraining pEbmTrainingShared = InitializeTrainingClassificationFromDataSets(randomSeed, 2, combinations, combinationIndexes, 3, trainingTargets, pEbmDataSetTraining, nullptr, validationTargets, pEbmDataSetValidation, nullptr, 2, TrainingOptionsNone);
+   PEbmInteraction pEbmInteractionInt64 = InitializeInteractionClassification(2, attributes, 3, 6, trainingTargets, trainingData, nullptr);
+   PEbmInteraction pEbmInteractionShared = InitializeInteractionClassificationFromDataSet(pEbmDataSetTraining, 3, trainingTargets, nullptr);
+   CHECK(nullptr != pEbmTrainingShared);
+   CHECK(nullptr != pEbmInteractionShared);
+
+   // mismatched attributes between the training and validation datasets are rejected
+   CHECK(nullptr == InitializeTrainingClassificationFromDataSets(randomSeed, 2, combinations, combinationIndexes, 3, trainingTargets, pEbmDataSetTraining, nullptr, validationTargets, nullptr, nullptr, 2, TrainingOptionsNone));
+
+   // the states hold their own references, so the caller can release the datasets right away
+   FreeDataSet(pEbmDataSetTraining);
+   FreeDataSet(pEbmDataSetValidation);
+
+   for(int iEpoch = 0; iEpoch < 10; ++iEpoch) {
+      for(IntegerDataType iAttributeCombination = 0; iAttributeCombination < 2; ++iAttributeCombination) {
+         FractionalDataType validationMetricInt64 = FractionalDataType { 0 };
+         FractionalDataType validationMetricShared = FractionalDataType { 0 };
+         CHECK(0 == TrainingStep(pEbmTrainingInt64, iAttributeCombination, k_learningRateDefault, k_countTreeSplitsMaxDefault, k_countCasesRequiredForSplitParentMinDefault, nullptr, nullptr, &validationMetricInt64));
+         CHECK(0 == TrainingStep(pEbmTrainingShared, iAttributeCombination, k_learningRateDefault, k_countTreeSplitsMaxDefault, k_countCasesRequiredForSplitParentMinDefault, nullptr, nullptr, &validationMetricShared));
+         CHECK(validationMetricShared == validationMetricInt64);
+      }
+   }
+
+   const IntegerDataType attributeIndexes[] = { 0, 1 };
+   FractionalDataType interactionScoreInt64 = FractionalDataType { 0 };
+   FractionalDataType interactionScoreShared = FractionalDataType { 0 };
+   CHECK(0 == GetInteractionScore(pEbmInteractionInt64, 2, attributeIndexes, &interactionScoreInt64));
+   CHECK(0 == GetInteractionScore(pEbmInteractionShared, 2, attributeIndexes, &interactionScoreShared));
+   CHECK(interactionScoreShared == interactionScoreInt64);
+
+   FreeTraining(pEbmTrainingInt64);
+   FreeTraining(pEbmTrainingShared);
+   FreeInteraction(pEbmInteractionInt64);
+   FreeInteraction(pEbmInteractionShared);
+}
+
+TEST_CASE("dataset saved to a file and loaded back matches, interaction, binary") {
+   EbmAttribute attributes[2];
+   attributes[0].attributeType = AttributeTypeOrdinal;
+   attributes[0].hasMissing = 0;
+   attributes[0].countStates = 3;
+   attributes[1].attributeType = AttributeTypeOrdinal;
+   attributes[1].hasMissing = 0;
+   attributes[1].countStates = 2;
+
+   const IntegerDataType targets[] = { 0, 1, 1, 1, 0, 0 };
+   const uint8_t rows[] = { 0, 1, 1, 0, 2, 1, 2, 1, 1, 0, 0, 0 };
+   EbmDataColumn columns[2];
+   columns[0].data = &rows[0];
+   columns[0].dataType = DataColumnTypeUInt8;
+   columns[0].strideBytes = 2;
+   columns[1].data = &rows[1];
+   columns[1].dataType = DataColumnTypeUInt8;
+   columns[1].strideBytes = 2;
+
+   const char * const filePath = "TestCoreApiDataSet.bin";
+   PEbmDataSet pEbmDataSetOriginal = InitializeDataSet(2, attributes, 6, columns);
+   CHECK(nullptr != pEbmDataSetOriginal);
+   CHECK(0 == SaveDataSet(pEbmDataSetOriginal, filePath));
+   PEbmDataSet pEbmDataSetLoaded = LoadDataSet(filePath);
+   CHECK(nullptr != pEbmDataSetLoaded);
+
+   PEbmInteraction pEbmInteractionOriginal = InitializeInteractionClassificationFromDataSet(pEbmDataSetOriginal, 2, targets, nullptr);
+   PEbmInteraction pEbmInteractionLoaded = InitializeInteractionClassificationFromDataSet(pEbmDataSetLoaded, 2, targets, nullptr);
+   FreeDataSet(pEbmDataSetOriginal);
+   FreeDataSet(pEbmDataSetLoaded);
+
+   const IntegerDataType attributeIndexes[] = { 0, 1 };
+   FractionalDataType interactionScoreOriginal = FractionalDataType { 0 };
+   FractionalDataType interactionScoreLoaded = FractionalDataType { 0 };
+   CHECK(0 == GetInteractionScore(pEbmInteractionOriginal, 2, attributeIndexes, &interactionScoreOriginal));
+   CHECK(0 == GetInteractionScore(pEbmInteractionLoaded, 2, attributeIndexes, &interactionScoreLoaded));
+   CHECK(interactionScoreLoaded == interactionScoreOriginal);
+   FreeInteraction(pEbmInteractionOriginal);
+   FreeInteraction(pEbmInteractionLoaded);
+
+   // a file that isn't one of ours is rejected
+   FILE * const pFile = fopen(filePath, "wb");
+   CHECK(nullptr != pFile);
+   fputs("not a dataset file, but long enough to hold a header", pFile);
+   fclose(pFile);
+   CHECK(nullptr == LoadDataSet(filePath));
+   remove(filePath);
+   CHECK(nullptr == LoadDataSet(filePath));
+}
+
+TEST_CASE("dataset file with corrupt attributes or bins is rejected, interaction, binary") {
+   EbmAttribute attributes[2];
+   attributes[0].attributeType = AttributeTypeOrdinal;
+   attributes[0].hasMissing = 0;
+   attributes[0].countStates = 3;
+   attributes[1].attributeType = AttributeTypeOrdinal;
+   attributes[1].hasMissing = 0;
+   attributes[1].countStates = 2;
+
+   const uint8_t rows[] = { 0, 1, 1, 0, 2, 1, 2, 1, 1, 0, 0, 0 };
+   EbmDataColumn columns[2];
+   columns[0].data = &rows[0];
+   columns[0].dataType = DataColumnTypeUInt8;
+   columns[0].strideBytes = 2;
+   columns[1].data = &rows[1];
+   columns[1].dataType = DataColumnTypeUInt8;
+   columns[1].strideBytes = 2;
+
+   const char * const filePath = "TestCoreApiDataSetCorrupt.bin";
+   PEbmDataSet pEbmDataSet = InitializeDataSet(2, attributes, 6, columns);
+   CHECK(nullptr != pEbmDataSet);
+   CHECK(0 == SaveDataSet(pEbmDataSet, filePath));
+   FreeDataSet(pEbmDataSet);
+
+   std::vector<uint64_t> file;
+   FILE * pFile = fopen(filePath, "rb");
+   CHECK(nullptr != pFile);
+   uint64_t item;
+   while(1 == fread(&item, sizeof(item), 1, pFile)) {
+      file.push_back(item);
+   }
+   fclose(pFile);
+   // 5 header items, then 3 items for each attribute, then 6 cases for each attribute, all 64 bits wide on the 64 bit machines we test on
+   CHECK(5 + 2 * 3 + 2 * 6 == file.size());
+   const size_t iAttribute0Type = 5;
+   const size_t iAttribute0HasMissing = 6;
+   const size_t iAttribute1CountStates = 5 + 3 + 2;
+   const size_t iColumn0Case4 = 5 + 2 * 3 + 4;
+   const size_t iColumn1Case0 = 5 + 2 * 3 + 6;
+
+   struct Corruption {
+      size_t iItem;
+      uint64_t value;
+      bool bValid;
+   };
+   const Corruption corruptions[] = {
+      { iColumn0Case4, 2, true }, // the original value
+      { iColumn1Case0, 1, true }, // still below countStates
+      { iColumn0Case4, 3, false }, // equal to countStates
+      { iColumn1Case0, ~uint64_t { 0 }, false }, // negative if read as a signed bin
+      { iAttribute1CountStates, 0, false },
+      { iAttribute1CountStates, ~uint64_t { 0 }, false },
+      { iAttribute1CountStates, 1, false }, // the file still holds bins of 1 for this attribute
+      { iAttribute0Type, 7, false },
+      { iAttribute0HasMissing, 2, false },
+   };
+   for(const Corruption & corruption : corruptions) {
+      std::vector<uint64_t> corrupt = file;
+      corrupt[corruption.iItem] = corruption.value;
+      pFile = fopen(filePath, "wb");
+      CHECK(nullptr != pFile);
+      CHECK(corrupt.size() == fwrite(&corrupt[0], sizeof(uint64_t), corrupt.size(), pFile));
+      fclose(pFile);
+      pEbmDataSet = LoadDataSet(filePath);
+      CHECK(corruption.bValid == (nullptr != pEbmDataSet));
+      FreeDataSet(pEbmDataSet);
+   }
+   remove(filePath);
+}
+
+TEST_CASE("cyclic boosting matches training steps, training, binary") {
+   TestApi testSteps = TestApi(2);
+   TestApi testCyclic = TestApi(2);
+   for(TestApi * pTest : { &testSteps, &testCyclic }) {
+      pTest->AddAttributes({ Attribute(2), Attribute(3) });
+      pTest->AddAttributeCombinations({ { 0 }, { 1 } });
+      pTest->AddTrainingCases({ ClassificationCase(0, { 0, 1 }), ClassificationCase(1, { 1, 2 }), ClassificationCase(1, { 0, 0 }) });
+      pTest->AddValidationCases({ ClassificationCase(0, { 0, 1 }), ClassificationCase(1, { 1, 2 }) });
+      pTest->InitializeTraining();
+   }
+
+   FractionalDataType validationMetricSteps = FractionalDataType { 0 };
+   for(int iRound = 0; iRound < 20; ++iRound) {
+      validationMetricSteps = testSteps.Train(0);
+      validationMetricSteps = testSteps.Train(1);
+   }
+
+   IntegerDataType countRoundsRun = -1;
+   // a negative run length disables early stopping
+   const FractionalDataType validationMetricCyclic = testCyclic.RunCyclicBoosting(20, 0, -1, &countRoundsRun);
+   CHECK(20 == countRoundsRun);
+   CHECK(validationMetricSteps == validationMetricCyclic);
+   CHECK(testSteps.GetCurrentModelValue(1, { 2 }, 1) == testCyclic.GetCurrentModelValue(1, { 2 }, 1));
+}
+
+TEST_CASE("cyclic boosting early stopping, training, regression") {
+   TestApi test = TestApi(k_learningTypeRegression);
+   test.AddAttributes({ Attribute(2) });
+   test.AddAttributeCombinations({ { 0 } });
+   test.AddTrainingCases({ RegressionCase(10, { 0 }), RegressionCase(20, { 1 }) });
+   test.AddValidationCases({ RegressionCase(12, { 0 }) });
+   test.InitializeTraining();
+
+   IntegerDataType countRoundsRun = -1;
+   // the metric improves by about 0.1 each round, so with a tolerance of 1 no round is an improvement and we stop once the run length is reached
+   test.RunCyclicBoosting(1000, 1, 3, &countRoundsRun);
+   CHECK(3 == countRoundsRun);
+
+   // with a tiny tolerance every round is an improvement so we run until we reach the round limit
+   test.RunCyclicBoosting(10, 0.000001, 3, &countRoundsRun);
+   CHECK(10 == countRoundsRun);
+
+   // a cancel only stops a call that's running, so one made between calls doesn't stop the next call
+   test.Cancel();
+   test.RunCyclicBoosting(10, 0, -1, &countRoundsRun);
+   CHECK(10 == countRoundsRun);
+}
+
+// SetLogMessageFunction can only be called once, so LogMessage passes every message on to this when a test sets it
+static LOG_MESSAGE_FUNCTION g_pLogMessageHook = nullptr;
+
+static TestApi * g_pTestCancelled = nullptr;
+static int g_cApplyModelUpdatesBeforeCancel = 0;
+
+// our log messages are the only place where we can run code on the thread that's inside RunCyclicBoosting, so we use them to cancel at an exact step
+static void EBMCORE_CALLING_CONVENTION CancelAfterApplyModelUpdates(signed char traceLevel, const char * message) {
+   UNUSED(traceLevel);
+   if(0 == strcmp(message, "Exited ApplyModelUpdatePerTargetStates")) {
+      --g_cApplyModelUpdatesBeforeCancel;
+      if(0 == g_cApplyModelUpdatesBeforeCancel) {
+         g_pTestCancelled->Cancel();
+      }
+   }
+}
+
+TEST_CASE("cyclic boosting cancelled in the middle of a round, training, binary") {
+   TestApi testSteps = TestApi(2);
+   TestApi testCyclic = TestApi(2);
+   for(TestApi * pTest : { &testSteps, &testCyclic }) {
+      pTest->AddAttributes({ Attribute(2), Attribute(3) });
+      pTest->AddAttributeCombinations({ { 0 }, { 1 } });
+      pTest->AddTrainingCases({ ClassificationCase(0, { 0, 1 }), ClassificationCase(1, { 1, 2 }), ClassificationCase(1, { 0, 0 }) });
+      pTest->AddValidationCases({ ClassificationCase(0, { 0, 1 }), ClassificationCase(1, { 1, 2 }) });
+      pTest->InitializeTraining();
+   }
+
+   // cancel after the first attribute combination of the second round
+   g_pTestCancelled = &testCyclic;
+   g_cApplyModelUpdatesBeforeCancel = 3;
+   g_pLogMessageHook = &CancelAfterApplyModelUpdates;
+   IntegerDataType countRoundsRun = -1;
+   IntegerDataType ret = -1;
+   const FractionalDataType validationMetricCancelled = testCyclic.RunCyclicBoosting(20, 0, -1, &countRoundsRun, &ret);
+   g_pLogMessageHook = nullptr;
+   CHECK(RunCyclicBoostingCancelled == ret);
+   CHECK(1 == countRoundsRun);
+   testSteps.Train(0);
+   testSteps.Train(1);
+   CHECK(testSteps.Train(0) == validationMetricCancelled);
+
+   // the cancel is over once the call that it stopped returns, so the next call runs its rounds from the first attribute combination
+   const FractionalDataType validationMetricResumed = testCyclic.RunCyclicBoosting(2, 0, -1, &countRoundsRun, &ret);
+   CHECK(0 == ret);
+   CHECK(2 == countRoundsRun);
+   testSteps.Train(0);
+   testSteps.Train(1);
+   testSteps.Train(0);
+   CHECK(testSteps.Train(1) == validationMetricResumed);
+
+   // no rounds means no training steps and no metric, which we report as 0 rather than infinity
+   CHECK(0 == testCyclic.RunCyclicBoosting(0, 0, -1, &countRoundsRun, &ret));
+   CHECK(0 == ret);
+   CHECK(0 == countRoundsRun);
+}
+
+
+TEST_CASE("thread count does not change results, training, multiclass") {
+   std::vector<FractionalDataType> validationMetrics[2];
+   const IntegerDataType countThreads[2] = { 1, 4 };
+   for(size_t iRun = 0; iRun < 2; ++iRun) {
+      CHECK(0 == SetThreadCount(countThreads[iRun]));
+
+      TestApi test = TestApi(3);
+      test.AddAttributes({ Attribute(2), Attribute(3) });
+      test.AddAttributeCombinations({ { 0 }, { 0, 1 } });
+      test.AddTrainingCases({
+         ClassificationCase(0, { 0, 0 }),
+         ClassificationCase(1, { 0, 1 }),
+         ClassificationCase(2, { 1, 2 }),
+         ClassificationCase(1, { 1, 0 }),
+         ClassificationCase(0, { 1, 1 }),
+         });
+      test.AddValidationCases({ ClassificationCase(1, { 0, 1 }), ClassificationCase(2, { 1, 1 }) });
+      test.InitializeTraining(8);
+
+      for(int iEpoch = 0; iEpoch < 10; ++iEpoch) {
+         for(IntegerDataType iAttributeCombination = 0; iAttributeCombination < 2; ++iAttributeCombination) {
+            validationMetrics[iRun].push_back(test.Train(iAttributeCombination));
+         }
+      }
+   }
+   // we sum the results of our parallel work in a fixed order, so we should get bit identical results no matter how many threads are used
+   CHECK(validationMetrics[0] == validationMetrics[1]);
+
+   const IntegerDataType cpuIndexes[1] = { 0 };
+   CHECK(0 == SetThreadAffinity(1, cpuIndexes));
+   // go back to the defaults for the rest of the tests
+   CHECK(0 == SetThreadAffinity(0, nullptr));
+   CHECK(0 == SetThreadCount(0));
+}
+
+
+TEST_CASE("many cases with inner bags binned in a single pass, thread count does not change results, training, multiclass") {
+   // with inner bags we bin all the bags at once, and with this many cases we also split that binning into partitions that get merged
+   constexpr size_t cReplicas = 40000;
+   const std::vector<ClassificationCase> trainingCases = { ClassificationCase(0, { 0, 1 }), ClassificationCase(1, { 1, 2 }), ClassificationCase(2, { 1, 0 }) };
+   const std::vector<ClassificationCase> validationCases = { ClassificationCase(0, { 0, 1 }), ClassificationCase(2, { 1, 2 }) };
+
+   std::vector<FractionalDataType> validationMetrics[2];
+   std::vector<FractionalDataType> modelValues[2];
+   const IntegerDataType countThreads[2] = { 1, 4 };
+   for(size_t iRun = 0; iRun < 2; ++iRun) {
+      CHECK(0 == SetThreadCount(countThreads[iRun]));
+
+      TestApi test = TestApi(3);
+      AddReplicatedCases(test, { Attribute(2), Attribute(3) }, { { 0 }, { 0, 1 } }, trainingCases, cReplicas, validationCases, 1);
+      test.InitializeTraining(3);
+
+      for(int iEpoch = 0; iEpoch < 3; ++iEpoch) {
+         for(IntegerDataType iAttributeCombination = 0; iAttributeCombination < 2; ++iAttributeCombination) {
+            validationMetrics[iRun].push_back(test.Train(iAttributeCombination));
+         }
+      }
+      for(size_t iTargetState = 0; iTargetState < 3; ++iTargetState) {
+         modelValues[iRun].push_back(test.GetCurrentModelValue(0, { 1 }, iTargetState));
+         modelValues[iRun].push_back(test.GetCurrentModelValue(1, { 1, 2 }, iTargetState));
+      }
+   }
+   CHECK(validationMetrics[0] == validationMetrics[1]);
+   CHECK(modelValues[0] == modelValues[1]);
+   // every bag sees the same replicated cases, so training should still make progress on the validation set
+   CHECK(validationMetrics[0].back() < validationMetrics[0].front());
+
+   CHECK(0 == SetThreadCount(0));
+}
+
+TEST_CASE("every simd level gives identical results, training and interaction, regression") {
+   const std::vector<RegressionCase> cases = { RegressionCase(10, { 0, 1 }), RegressionCase(20, { 1, 2 }), RegressionCase(15, { 2, 0 }), RegressionCase(-3, { 1, 1 }), RegressionCase(7, { 0, 2 }) };
+   // an odd number of cases leaves a partial vector at the end of each loop
+   const std::vector<RegressionCase> casesLarge = ReplicateCases(cases, 1001);
+
+   // EBM_SIMD_LEVEL can start us at a narrower level than the processor supports, so put back whatever we found instead of assuming the widest
+   const IntegerDataType simdLevelOriginal = GetSimdLevel();
+
+   CHECK(0 != SetSimdLevel(-1));
+   CHECK(0 != SetSimdLevel(SimdLevelAvx512 + 1));
+
+   std::vector<FractionalDataType> results[3];
+   const IntegerDataType simdLevels[3] = { SimdLevelScalar, SimdLevelAvx2, SimdLevelAvx512 };
+   for(size_t iRun = 0; iRun < 3; ++iRun) {
+      CHECK(0 == SetSimdLevel(simdLevels[iRun]));
+      // the processor might not support the level we asked for, in which case we get the widest one that it does support
+      CHECK(GetSimdLevel() <= simdLevels[iRun]);
+
+      TestApi test = TestApi(k_learningTypeRegression);
+      test.AddAttributes({ Attribute(3), Attribute(3) });
+      test.AddAttributeCombinations({ { 0 }, { 0, 1 } });
+      test.AddTrainingCases(casesLarge);
+      test.AddValidationCases(cases);
+      test.InitializeTraining(3);
+      for(int iEpoch = 0; iEpoch < 5; ++iEpoch) {
+         for(IntegerDataType iAttributeCombination = 0; iAttributeCombination < 2; ++iAttributeCombination) {
+            results[iRun].push_back(test.Train(iAttributeCombination));
+         }
+      }
+      results[iRun].push_back(test.GetCurrentModelValue(1, { 1, 2 }, 0));
+
+      TestApi testInteraction = TestApi(k_learningTypeRegression);
+      testInteraction.AddAttributes({ Attribute(3), Attribute(3) });
+      testInteraction.AddInteractionCases(casesLarge);
+      testInteraction.InitializeInteraction();
+      results[iRun].push_back(testInteraction.InteractionScore({ 0, 1 }));
+   }
+   // every variant runs the same operations in the same order, so only the speed should change
+   CHECK(results[0] == results[1]);
+   CHECK(results[0] == results[2]);
+
+   CHECK(0 == SetSimdLevel(simdLevelOriginal));
+}
+
+// the number of ULPs between two doubles of the same sign
+static uint64_t UlpDistance(const double value1, const double value2) {
+   int64_t bits1;
+   int64_t bits2;
+   memcpy(&bits1, &value1, sizeof(bits1));
+   memcpy(&bits2, &value2, sizeof(bits2));
+   return bits1 < bits2 ? static_cast<uint64_t>(bits2 - bits1) : static_cast<uint64_t>(bits1 - bits2);
+}
+
+TEST_CASE("every simd level gives results within the residual ulp bound, training, binary") {
+   // the vectorized binary classification residuals can be up to k_cBinaryclassResidualUlps from the scalar ones (see SimdKernels.h), unlike the
+   // regression kernels which are bit identical
+   constexpr uint64_t k_cBinaryclassResidualUlps = 8;
+   constexpr size_t k_cCasesPerBin = 100;
+   constexpr int k_cEpochs = 3;
+   // every case in a bin has the same target, so the residuals that we sum in each bin share a sign and can't cancel.  The attribute has only two states,
+   // so the only split is between them and the tree can't change shape when the residuals move.  The sums of residuals and hessians each pick up at most
+   // one ULP per case on top of the residual bound, the division adds one, and each epoch's update adds onto the model that the previous epochs built
+   constexpr uint64_t k_cUlpsMax = k_cEpochs * (2 * (k_cBinaryclassResidualUlps + k_cCasesPerBin) + 1);
+
+   const IntegerDataType simdLevelOriginal = GetSimdLevel();
+
+   // each case starts from a different score so that every vector lane calculates a different exp, and the odd number of cases leaves a partial vector
+   std::vector<ClassificationCase> cases;
+   for(size_t iCase = 0; iCase < 2 * k_cCasesPerBin - 1; ++iCase) {
+      const IntegerDataType target = static_cast<IntegerDataType>(iCase % 2);
+      cases.push_back(ClassificationCase(target, { target }, { 0, 0.065 * static_cast<double>(iCase) - 6.5 }));
+   }
+
+   std::vector<FractionalDataType> results[3];
+   const IntegerDataType simdLevels[3] = { SimdLevelScalar, SimdLevelAvx2, SimdLevelAvx512 };
+   for(size_t iRun = 0; iRun < 3; ++iRun) {
+      CHECK(0 == SetSimdLevel(simdLevels[iRun]));
+
+      TestApi test = TestApi(2);
+      test.AddAttributes({ Attribute(2) });
+      test.AddAttributeCombinations({ { 0 } });
+      test.AddTrainingCases(cases);
+      test.AddValidationCases(cases);
+      test.InitializeTraining();
+      for(int iEpoch = 0; iEpoch < k_cEpochs; ++iEpoch) {
+         results[iRun].push_back(test.Train(0, {}, {}, 0.5));
+         results[iRun].push_back(test.GetCurrentModelValue(0, { 0 }, 1));
+         results[iRun].push_back(test.GetCurrentModelValue(0, { 1 }, 1));
+      }
+   }
+   for(size_t iRun = 1; iRun < 3; ++iRun) {
+      for(size_t iResult = 0; iResult < results[0].size(); ++iResult) {
+         CHECK(UlpDistance(results[0][iResult], results[iRun][iResult]) <= k_cUlpsMax);
+      }
+   }
+
+   CHECK(0 == SetSimdLevel(simdLevelOriginal));
+}
 
 //TEST_CASE("infinite target training set, training, regression") {
 //   TestApi test = TestApi(k_learningTypeRegression);
@@ -1479,6 +3139,225 @@ TEST_CASE("Zero interaction cases, interaction, multiclass") {
    CHECK(0 == metricReturn);
 }
 
+TEST_CASE("batch interaction scores match single interaction scores, interaction, multiclass") {
+   TestApi test = TestApi(3);
+   test.AddAttributes({ Attribute(2), Attribute(3), Attribute(4), Attribute(2) });
+   test.AddInteractionCases({
+      ClassificationCase(0, { 0, 1, 3, 0 }),
+      ClassificationCase(1, { 1, 2, 0, 1 }),
+      ClassificationCase(2, { 1, 0, 2, 1 }),
+      ClassificationCase(1, { 0, 2, 1, 0 }),
+      ClassificationCase(0, { 1, 1, 3, 1 }),
+      ClassificationCase(2, { 0, 0, 0, 0 }),
+      });
+   test.InitializeInteraction();
+
+   const std::vector<std::vector<IntegerDataType>> attributeCombinations = { { 0, 1 }, { 0, 2 }, { 0, 3 }, { 1, 2 }, { 1, 3 }, { 2, 3 }, { 3, 1 } };
+   // scoring the same combinations twice checks that the scratch space that we keep between calls doesn't leak results from one call into the next
+   for(int iRepeat = 0; iRepeat < 2; ++iRepeat) {
+      const std::vector<FractionalDataType> interactionScores = test.InteractionScores(attributeCombinations);
+      CHECK(attributeCombinations.size() == interactionScores.size());
+      for(size_t iAttributeCombination = 0; iAttributeCombination < attributeCombinations.size(); ++iAttributeCombination) {
+         CHECK(interactionScores[iAttributeCombination] == test.InteractionScore(attributeCombinations[iAttributeCombination]));
+      }
+   }
+   CHECK(test.InteractionScores({}).empty());
+}
+
+TEST_CASE("batch interaction scores over many cases match single interaction scores, interaction, regression") {
+   // enough cases that the batch scoring needs several case tiles, and enough attributes that the pairs don't all fit in one block
+   constexpr size_t cAttributes = 12;
+   constexpr size_t cCases = 5000;
+   TestApi test = TestApi(k_learningTypeRegression);
+   test.AddAttributes(std::vector<Attribute>(cAttributes, Attribute(7)));
+   std::vector<RegressionCase> cases;
+   for(size_t iCase = 0; iCase < cCases; ++iCase) {
+      std::vector<IntegerDataType> data;
+      for(size_t iAttribute = 0; iAttribute < cAttributes; ++iAttribute) {
+         data.push_back(static_cast<IntegerDataType>((iCase * (iAttribute + 3) + iCase / (iAttribute + 1)) % 7));
+      }
+      cases.push_back(RegressionCase(static_cast<FractionalDataType>((iCase * 37) % 11) - FractionalDataType { 5 }, data));
+   }
+   test.AddInteractionCases(cases);
+   test.InitializeInteraction();
+
+   std::vector<std::vector<IntegerDataType>> attributeCombinations;
+   for(IntegerDataType iAttribute1 = 0; iAttribute1 < static_cast<IntegerDataType>(cAttributes); ++iAttribute1) {
+      for(IntegerDataType iAttribute2 = iAttribute1 + 1; iAttribute2 < static_cast<IntegerDataType>(cAttributes); ++iAttribute2) {
+         attributeCombinations.push_back({ iAttribute1, iAttribute2 });
+      }
+   }
+   const std::vector<FractionalDataType> interactionScores = test.InteractionScores(attributeCombinations);
+   for(size_t iAttributeCombination = 0; iAttributeCombination < attributeCombinations.size(); ++iAttributeCombination) {
+      CHECK(interactionScores[iAttributeCombination] == test.InteractionScore(attributeCombinations[iAttributeCombination]));
+   }
+}
+
+TEST_CASE("single interaction scores from several threads at once match batch interaction scores, interaction, multiclass") {
+   constexpr size_t cAttributes = 6;
+   constexpr size_t cCases = 2000;
+   constexpr size_t cThreads = 4;
+   TestApi test = TestApi(3);
+   test.AddAttributes(std::vector<Attribute>(cAttributes, Attribute(5)));
+   std::vector<ClassificationCase> cases;
+   for(size_t iCase = 0; iCase < cCases; ++iCase) {
+      std::vector<IntegerDataType> data;
+      for(size_t iAttribute = 0; iAttribute < cAttributes; ++iAttribute) {
+         data.push_back(static_cast<IntegerDataType>((iCase * (iAttribute + 2) + iCase / (iAttribute + 3)) % 5));
+      }
+      cases.push_back(ClassificationCase(static_cast<IntegerDataType>((iCase * 7) % 3), data));
+   }
+   test.AddInteractionCases(cases);
+   test.InitializeInteraction();
+
+   std::vector<std::vector<IntegerDataType>> attributeCombinations;
+   for(IntegerDataType iAttribute1 = 0; iAttribute1 < static_cast<IntegerDataType>(cAttributes); ++iAttribute1) {
+      for(IntegerDataType iAttribute2 = iAttribute1 + 1; iAttribute2 < static_cast<IntegerDataType>(cAttributes); ++iAttribute2) {
+         attributeCombinations.push_back({ iAttribute1, iAttribute2 });
+      }
+   }
+   const std::vector<FractionalDataType> interactionScores = test.InteractionScores(attributeCombinations);
+
+   // every thread scores every pair through the same interaction handle, so any scratch space shared between the calls would corrupt the scores
+   std::vector<std::vector<FractionalDataType>> threadInteractionScores(cThreads, std::vector<FractionalDataType>(attributeCombinations.size()));
+   std::vector<std::thread> threads;
+   for(size_t iThread = 0; iThread < cThreads; ++iThread) {
+      threads.push_back(std::thread([&test, &attributeCombinations, &threadInteractionScores, iThread]() {
+         for(size_t iRepeat = 0; iRepeat < 5; ++iRepeat) {
+            for(size_t iAttributeCombination = 0; iAttributeCombination < attributeCombinations.size(); ++iAttributeCombination) {
+               threadInteractionScores[iThread][iAttributeCombination] = test.InteractionScore(attributeCombinations[iAttributeCombination]);
+            }
+         }
+      }));
+   }
+   for(std::thread & thread : threads) {
+      thread.join();
+   }
+   for(size_t iThread = 0; iThread < cThreads; ++iThread) {
+      for(size_t iAttributeCombination = 0; iAttributeCombination < attributeCombinations.size(); ++iAttributeCombination) {
+         CHECK(interactionScores[iAttributeCombination] == threadInteractionScores[iThread][iAttributeCombination]);
+      }
+   }
+}
+
+TEST_CASE("pair interaction score matches a brute force sweep over every pair of cuts, interaction, regression") {
+   // the two attributes have different numbers of states, so indexing the tensor with the strides of the wrong dimension would change the score
+   constexpr size_t cStates1 = 3;
+   constexpr size_t cStates2 = 5;
+   constexpr size_t cCases = 40;
+   TestApi test = TestApi(k_learningTypeRegression);
+   test.AddAttributes({ Attribute(cStates1), Attribute(cStates2) });
+   std::vector<RegressionCase> cases;
+   std::vector<size_t> aiStates1;
+   std::vector<size_t> aiStates2;
+   std::vector<FractionalDataType> targets;
+   for(size_t iCase = 0; iCase < cCases; ++iCase) {
+      const size_t iState1 = (iCase * 7 + iCase / 3) % cStates1;
+      const size_t iState2 = (iCase * 3 + iCase / 5) % cStates2;
+      const FractionalDataType target = static_cast<FractionalDataType>((iCase * 13) % 9) - FractionalDataType { 4 } + (1 == iState1 && 3 <= iState2 ? FractionalDataType { 6 } : FractionalDataType { 0 });
+      aiStates1.push_back(iState1);
+      aiStates2.push_back(iState2);
+      targets.push_back(target);
+      cases.push_back(RegressionCase(target, { static_cast<IntegerDataType>(iState1), static_cast<IntegerDataType>(iState2) }));
+   }
+   test.AddInteractionCases(cases);
+   test.InitializeInteraction();
+
+   // our initial predictions are zero, so the residuals are the targets
+   FractionalDataType bestScore = -std::numeric_limits<FractionalDataType>::infinity();
+   for(size_t iCut1 = 0; iCut1 < cStates1 - 1; ++iCut1) {
+      for(size_t iCut2 = 0; iCut2 < cStates2 - 1; ++iCut2) {
+         FractionalDataType sums[4] = { 0, 0, 0, 0 };
+         size_t counts[4] = { 0, 0, 0, 0 };
+         for(size_t iCase = 0; iCase < cCases; ++iCase) {
+            const size_t iQuadrant = (iCut1 < aiStates1[iCase] ? 1 : 0) + (iCut2 < aiStates2[iCase] ? 2 : 0);
+            sums[iQuadrant] += targets[iCase];
+            ++counts[iQuadrant];
+         }
+         FractionalDataType score = 0;
+         for(size_t iQuadrant = 0; iQuadrant < 4; ++iQuadrant) {
+            score += 0 == counts[iQuadrant] ? 0 : sums[iQuadrant] / counts[iQuadrant] * sums[iQuadrant];
+         }
+         bestScore = bestScore < score ? score : bestScore;
+      }
+   }
+   CHECK_APPROX(test.InteractionScore({ 0, 1 }), bestScore);
+}
+
+TEST_CASE("screened interaction scores without screening match the exact ranking, interaction, multiclass") {
+   TestApi test = TestApi(3);
+   test.AddAttributes({ Attribute(3), Attribute(4), Attribute(2), Attribute(5) });
+   std::vector<ClassificationCase> cases;
+   for(size_t iCase = 0; iCase < 200; ++iCase) {
+      cases.push_back(ClassificationCase(static_cast<IntegerDataType>((iCase * 7 + iCase / 5) % 3), { static_cast<IntegerDataType>(iCase % 3), static_cast<IntegerDataType>((iCase / 3) % 4), static_cast<IntegerDataType>((iCase * 5) % 2), static_cast<IntegerDataType>((iCase * 11 / 7) % 5) }));
+   }
+   test.AddInteractionCases(cases);
+   test.InitializeInteraction();
+
+   const std::vector<std::vector<IntegerDataType>> attributeCombinations = { { 0, 1 }, { 0, 2 }, { 0, 3 }, { 1, 2 }, { 1, 3 }, { 2, 3 } };
+   const std::vector<FractionalDataType> interactionScores = test.InteractionScores(attributeCombinations);
+   std::vector<IntegerDataType> exactRanking;
+   for(size_t iAttributeCombination = 0; iAttributeCombination < attributeCombinations.size(); ++iAttributeCombination) {
+      exactRanking.push_back(static_cast<IntegerDataType>(iAttributeCombination));
+   }
+   std::sort(exactRanking.begin(), exactRanking.end(), [&interactionScores](const IntegerDataType iLeft, const IntegerDataType iRight) {
+      return interactionScores[iRight] < interactionScores[iLeft] || interactionScores[iRight] == interactionScores[iLeft] && iLeft < iRight;
+   });
+
+   // a subsample as big as the dataset, or enough oversampling to keep every candidate, means everything gets scored exactly
+   std::vector<FractionalDataType> topInteractionScores;
+   for(const IntegerDataType countCasesScreening : { IntegerDataType { 0 }, IntegerDataType { 200 }, IntegerDataType { 50 } }) {
+      const std::vector<IntegerDataType> topAttributeCombinations = test.InteractionScoresScreened(attributeCombinations, countCasesScreening, FractionalDataType { 100 }, 4, &topInteractionScores);
+      CHECK(4 == topAttributeCombinations.size());
+      for(size_t iTop = 0; iTop < topAttributeCombinations.size(); ++iTop) {
+         CHECK(exactRanking[iTop] == topAttributeCombinations[iTop]);
+         CHECK(interactionScores[exactRanking[iTop]] == topInteractionScores[iTop]);
+      }
+   }
+   CHECK(6 == test.InteractionScoresScreened(attributeCombinations, 50, FractionalDataType { 1 }, 100, &topInteractionScores).size());
+   CHECK(test.InteractionScoresScreened(attributeCombinations, 50, FractionalDataType { 1 }, 0, &topInteractionScores).empty());
+}
+
+TEST_CASE("screened interaction scores find the planted interaction, interaction, regression") {
+   constexpr size_t cAttributes = 10;
+   constexpr size_t cCases = 8000;
+   TestApi test = TestApi(k_learningTypeRegression);
+   test.AddAttributes(std::vector<Attribute>(cAttributes, Attribute(4)));
+   std::vector<RegressionCase> cases;
+   for(size_t iCase = 0; iCase < cCases; ++iCase) {
+      std::vector<IntegerDataType> data;
+      for(size_t iAttribute = 0; iAttribute < cAttributes; ++iAttribute) {
+         data.push_back(static_cast<IntegerDataType>((iCase / (size_t { 1 } << (iAttribute * 2 % 13)) + iCase * iAttribute / 3) % 4));
+      }
+      // the target only depends on whether attributes 3 and 7 are on the same side, which is a pure interaction with no main effects
+      const FractionalDataType target = (data[3] < 2) == (data[7] < 2) ? FractionalDataType { 1 } : FractionalDataType { -1 };
+      cases.push_back(RegressionCase(target, data));
+   }
+   test.AddInteractionCases(cases);
+   test.InitializeInteraction();
+
+   std::vector<std::vector<IntegerDataType>> attributeCombinations;
+   for(IntegerDataType iAttribute1 = 0; iAttribute1 < static_cast<IntegerDataType>(cAttributes); ++iAttribute1) {
+      for(IntegerDataType iAttribute2 = iAttribute1 + 1; iAttribute2 < static_cast<IntegerDataType>(cAttributes); ++iAttribute2) {
+         attributeCombinations.push_back({ iAttribute1, iAttribute2 });
+      }
+   }
+   const std::vector<FractionalDataType> interactionScores = test.InteractionScores(attributeCombinations);
+
+   std::vector<FractionalDataType> topInteractionScores;
+   const std::vector<IntegerDataType> topAttributeCombinations = test.InteractionScoresScreened(attributeCombinations, 500, FractionalDataType { 2 }, 3, &topInteractionScores);
+   CHECK(3 == topAttributeCombinations.size());
+   CHECK(3 == attributeCombinations[topAttributeCombinations[0]][0]);
+   CHECK(7 == attributeCombinations[topAttributeCombinations[0]][1]);
+   // the scores we return are always the exact ones, in descending order
+   for(size_t iTop = 0; iTop < topAttributeCombinations.size(); ++iTop) {
+      CHECK(interactionScores[topAttributeCombinations[iTop]] == topInteractionScores[iTop]);
+      if(0 != iTop) {
+         CHECK(topInteractionScores[iTop] <= topInteractionScores[iTop - 1]);
+      }
+   }
+}
+
 TEST_CASE("classification with 0 possible target states, training") {
    // for there to be zero states, there can't be an training data or testing data since then those would be required to have a value for the state
    TestApi test = TestApi(0);
@@ -2006,6 +3885,9 @@ void EBMCORE_CALLING_CONVENTION LogMessage(signed char traceLevel, const char *
    // don't display the message, but we want to test all our messages, so have them call us here
    strlen(message); // test that the string memory is accessible
 //   printf("%d - %s\n", traceLevel, message);
+   if(nullptr != g_pLogMessageHook) {
+      (*g_pLogMessageHook)(traceLevel, message);
+   }
 }
 
 int main() {